@@ -8,8 +8,8 @@
 #include <cmath>
 #include <cstring>
 #include <initializer_list>
-#include <random>
 
+#include "bit_iterator.hpp"
 #include "functional.hpp"
 #include "iterator.hpp"
 
@@ -139,11 +139,65 @@ inline InIter find_if_not(InIter first, InIter last, UnaryPred pred) {
     return last;
 }
 
+// contiguous ranges of trivially copyable types are copied by memmove and
+// filled by memset, see ContiguousIterator
+
+// T is assigned or constructed from Src by copying bytes
+template <typename T, typename Src>
+struct TrivialCopyAssign : is_trivially_assignable<T&, const Src&> {};
+
+template <typename T, typename Src>
+struct TrivialMoveAssign : is_trivially_assignable<T&, Src&&> {};
+
+template <typename T, typename Src>
+struct TrivialCopyConstruct : is_trivially_constructible<T, const Src&> {};
+
+template <typename T, typename Src>
+struct TrivialMoveConstruct : is_trivially_constructible<T, Src&&> {};
+
+template <typename T, typename Src, template <typename, typename> class Trivial>
+struct MemmoveElementIsSafe
+    : bool_constant<conjunction<is_object<T>, is_same<T, remove_const_t<Src>>,
+                                negation<is_volatile<T>>,
+                                is_trivially_copyable<T>,
+                                Trivial<T, Src>>::value> {};
+
+// [first, last) of InIter goes to OutIter by memmove: both iterators are
+// contiguous over the same T, and the Trivial operation on T is a byte copy
+template <typename InIter, typename OutIter,
+          template <typename, typename> class Trivial,
+          bool = conjunction<ContiguousIterator<InIter>,
+                             ContiguousIterator<OutIter>>::value>
+struct MemmoveIsSafe : false_type {};
+
+template <typename InIter, typename OutIter,
+          template <typename, typename> class Trivial>
+struct MemmoveIsSafe<InIter, OutIter, Trivial, true>
+    : MemmoveElementIsSafe<typename ContiguousIterator<OutIter>::element_type,
+                           typename ContiguousIterator<InIter>::element_type,
+                           Trivial>::type {};
+
+// memmove [src, src + n) to dst, returns dst + n
+template <typename InIter, typename Diff, typename OutIter>
+inline OutIter memmoveN(InIter src, Diff n, OutIter dst) {
+    using Elem = typename ContiguousIterator<OutIter>::element_type;
+    if (n > 0) {
+        std::memmove(
+            static_cast<void*>(ContiguousIterator<OutIter>::address(dst)),
+            static_cast<const void*>(ContiguousIterator<InIter>::address(src)),
+            static_cast<size_t>(n) * sizeof(Elem));
+        return dst + n;
+    }
+    return dst;
+}
+
 template <typename FwdIter, typename T>
 struct FillMemsetIsSafeHelper {
     using ValueType = typename iterator_traits<FwdIter>::value_type;
+    using Reference = typename iterator_traits<FwdIter>::reference;
     using type = typename conjunction<
-        is_pointer<FwdIter>,
+        ContiguousIterator<FwdIter>,
+        negation<is_volatile<remove_reference_t<Reference>>>,
         disjunction<conjunction<IsCharacter<T>, IsCharacter<ValueType>>,
                     conjunction<is_same<bool, T>, is_same<bool, ValueType>>>>::
         type;
@@ -155,11 +209,37 @@ fillMemsetIsSafe(const FwdIter&, const T&) {
     return {};
 }
 
+// a scalar fill of a contiguous range is a memset when the value has all
+// bits zero, known at run time
+template <typename FwdIter>
+struct FillZeroMemsetIsSafe
+    : conjunction<
+          ContiguousIterator<FwdIter>,
+          is_scalar<typename iterator_traits<FwdIter>::value_type>,
+          negation<is_member_pointer<
+              typename iterator_traits<FwdIter>::value_type>>,
+          negation<is_volatile<remove_reference_t<
+              typename iterator_traits<FwdIter>::reference>>>>::type {};
+
+template <typename T>
+inline bool isAllBitsZero(const T& val) noexcept {
+    const T zero{};
+    return std::memcmp(&val, &zero, sizeof(T)) == 0;
+}
+
 template <typename OutIter, typename Diff, typename T>
+inline OutIter fillNLoop(OutIter dst, Diff n, const T& val) {
+    for (; n > 0; --n, ++dst)
+        *dst = val;
+    return dst;
+}
+
+template <typename OutIter, typename Diff, typename T, typename Zero>
 inline OutIter fillNHelper(OutIter dst, Diff n, const T& val,
-                           true_type /* fill memset is safe*/) {
+                           true_type /* fill memset is safe*/, Zero) {
     if (n > 0) {
-        std::memset(dst, val, n);
+        std::memset(ContiguousIterator<OutIter>::address(dst), val,
+                    static_cast<size_t>(n));
         return dst + n;
     }
     return dst;
@@ -167,20 +247,36 @@ inline OutIter fillNHelper(OutIter dst, Diff n, const T& val,
 
 template <typename OutIter, typename Diff, typename T>
 inline OutIter fillNHelper(OutIter dst, Diff n, const T& val,
-                           false_type /* fill memset is unsafe */) {
-    for (; n > 0; --n, ++dst)
-        *dst = val;
-    return dst;
+                           false_type /* fill memset is unsafe */,
+                           true_type /* unless val is zero */) {
+    using ValueType = typename iterator_traits<OutIter>::value_type;
+    const ValueType v = val;
+    if (n > 0 && isAllBitsZero(v)) {
+        std::memset(
+            static_cast<void*>(ContiguousIterator<OutIter>::address(dst)), 0,
+            static_cast<size_t>(n) * sizeof(ValueType));
+        return dst + n;
+    }
+    return fillNLoop(dst, n, v);
+}
+
+template <typename OutIter, typename Diff, typename T>
+inline OutIter fillNHelper(OutIter dst, Diff n, const T& val,
+                           false_type /* fill memset is unsafe */,
+                           false_type) {
+    return fillNLoop(dst, n, val);
 }
 
 template <typename OutIter, typename Diff, typename T>
 inline OutIter fill_n(OutIter dst, Diff n, const T& val) {
-    return fillNHelper(dst, n, val, fillMemsetIsSafe(dst, val));
+    return fillNHelper(dst, n, val, fillMemsetIsSafe(dst, val),
+                       FillZeroMemsetIsSafe<OutIter>{});
 }
 
 template <typename FwdIter, typename T>
-inline void fillHelper(FwdIter first, FwdIter last, const T& val, true_type) {
-    std::memset(first, last - first, val);
+inline void fillHelper(FwdIter first, FwdIter last, const T& val,
+                       true_type /* contiguous */) {
+    tiny_stl::fill_n(first, last - first, val);
 }
 
 template <typename FwdIter, typename T>
@@ -191,7 +287,7 @@ inline void fillHelper(FwdIter first, FwdIter last, const T& val, false_type) {
 
 template <typename FwdIter, typename T>
 inline void fill(FwdIter first, FwdIter last, const T& val) {
-    fillHelper(first, last, val, fillMemsetIsSafe(first, val));
+    fillHelper(first, last, val, ContiguousIterator<FwdIter>{});
 }
 
 template <typename FwdIter, typename Func>
@@ -238,47 +334,220 @@ inline OutIter copy_if(InIter first, InIter last, OutIter dst, UnaryPred pred) {
 }
 
 template <typename InIter, typename OutIter>
-inline OutIter copy(InIter first, InIter last, OutIter dst) {
+inline OutIter copyHelper(InIter first, InIter last, OutIter dst,
+                          true_type /* memmove */) {
+    return memmoveN(first, last - first, dst);
+}
+
+template <typename InIter, typename OutIter>
+inline OutIter copyHelper(InIter first, InIter last, OutIter dst, false_type) {
     for (; first != last; ++first)
         *dst++ = *first;
 
     return dst;
 }
 
+template <typename InIter, typename OutIter>
+inline OutIter copy(InIter first, InIter last, OutIter dst) {
+    return copyHelper(first, last, dst,
+                      MemmoveIsSafe<InIter, OutIter, TrivialCopyAssign>{});
+}
+
+template <typename InIter, typename Size, typename OutIter>
+inline OutIter copyNHelper(InIter src, Size count, OutIter dst,
+                           true_type /* memmove */) {
+    return memmoveN(src, count, dst);
+}
+
+template <typename InIter, typename Size, typename OutIter>
+inline OutIter copyNHelper(InIter src, Size count, OutIter dst, false_type) {
+    for (; count > 0; --count, ++src, ++dst)
+        *dst = *src;
+
+    return dst;
+}
+
 template <typename InIter, typename Size, typename OutIter>
 inline OutIter copy_n(InIter src, Size count, OutIter dst) {
-    if (count > 0) {
-        for (Size i = 0; i < count; ++i)
-            *dst = *src;
-    }
+    return copyNHelper(src, count, dst,
+                       MemmoveIsSafe<InIter, OutIter, TrivialCopyAssign>{});
+}
 
-    return dst;
+template <typename BidIter1, typename BidIter2>
+inline BidIter2 copyBackwardHelper(BidIter1 first, BidIter1 last,
+                                   BidIter2 dstLast, true_type /* memmove */) {
+    const BidIter2 dstFirst = dstLast - (last - first);
+    memmoveN(first, last - first, dstFirst);
+    return dstFirst;
 }
 
 template <typename BidIter1, typename BidIter2>
-inline BidIter2 copy_backward(BidIter1 first, BidIter1 last, BidIter2 dstLast) {
+inline BidIter2 copyBackwardHelper(BidIter1 first, BidIter1 last,
+                                   BidIter2 dstLast, false_type) {
     for (; first != last;)
         *(--dstLast) = *(--last);
 
     return dstLast;
 }
 
+template <typename BidIter1, typename BidIter2>
+inline BidIter2 copy_backward(BidIter1 first, BidIter1 last, BidIter2 dstLast) {
+    return copyBackwardHelper(
+        first, last, dstLast,
+        MemmoveIsSafe<BidIter1, BidIter2, TrivialCopyAssign>{});
+}
+
+// bit iterators of vector<bool>, a word of 64 flags at a time
+// a predicate is called on no more than two elements: the first one, and
+// the first one of the other value if there is one
+
+template <typename UnaryPred>
+inline bool all_of(BitConstIterator first, BitConstIterator last,
+                   UnaryPred pred) {
+    if (first == last)
+        return true;
+
+    const bool head = *first;
+    if (!pred(head))
+        return false;
+    return bitFind(first, last, !head) == last || pred(!head);
+}
+
+template <typename UnaryPred>
+inline bool all_of(BitIterator first, BitIterator last, UnaryPred pred) {
+    return tiny_stl::all_of(BitConstIterator(first), BitConstIterator(last),
+                            tiny_stl::move(pred));
+}
+
+template <typename UnaryPred>
+inline bool any_of(BitConstIterator first, BitConstIterator last,
+                   UnaryPred pred) {
+    if (first == last)
+        return false;
+
+    const bool head = *first;
+    if (pred(head))
+        return true;
+    return bitFind(first, last, !head) != last && pred(!head);
+}
+
+template <typename UnaryPred>
+inline bool any_of(BitIterator first, BitIterator last, UnaryPred pred) {
+    return tiny_stl::any_of(BitConstIterator(first), BitConstIterator(last),
+                            tiny_stl::move(pred));
+}
+
+template <typename UnaryPred>
+inline bool none_of(BitConstIterator first, BitConstIterator last,
+                    UnaryPred pred) {
+    return !tiny_stl::any_of(first, last, tiny_stl::move(pred));
+}
+
+template <typename UnaryPred>
+inline bool none_of(BitIterator first, BitIterator last, UnaryPred pred) {
+    return !tiny_stl::any_of(first, last, tiny_stl::move(pred));
+}
+
+template <typename T>
+inline ptrdiff_t count(BitConstIterator first, BitConstIterator last,
+                       const T& val) {
+    const ptrdiff_t ones = bitCount(first, last, true);
+    return (true == val ? ones : 0) +
+           (false == val ? (last - first) - ones : 0);
+}
+
+template <typename T>
+inline ptrdiff_t count(BitIterator first, BitIterator last, const T& val) {
+    return tiny_stl::count(BitConstIterator(first), BitConstIterator(last),
+                           val);
+}
+
+template <typename T>
+inline BitConstIterator find(BitConstIterator first, BitConstIterator last,
+                             const T& val) {
+    const bool matchTrue = true == val;
+    if (matchTrue == (false == val))
+        return matchTrue ? first : last;
+    return bitFind(first, last, matchTrue);
+}
+
+template <typename T>
+inline BitIterator find(BitIterator first, BitIterator last, const T& val) {
+    return first + (tiny_stl::find(BitConstIterator(first),
+                                   BitConstIterator(last), val) -
+                    first);
+}
+
+template <typename T>
+inline void fill(BitIterator first, BitIterator last, const T& val) {
+    bitFill(first, last, static_cast<bool>(val));
+}
+
+inline BitIterator copy(BitConstIterator first, BitConstIterator last,
+                        BitIterator dst) {
+    return bitCopy(first, last, dst);
+}
+
+inline BitIterator copy(BitIterator first, BitIterator last,
+                        BitIterator dst) {
+    return bitCopy(first, last, dst);
+}
+
+inline BitIterator copy_backward(BitConstIterator first, BitConstIterator last,
+                                 BitIterator dstLast) {
+    return bitCopyBackward(first, last, dstLast);
+}
+
+inline BitIterator copy_backward(BitIterator first, BitIterator last,
+                                 BitIterator dstLast) {
+    return bitCopyBackward(first, last, dstLast);
+}
+
 template <typename InIter, typename OutIter>
-inline OutIter move(InIter first, InIter last, OutIter dstFirst) {
+inline OutIter moveHelper(InIter first, InIter last, OutIter dstFirst,
+                          true_type /* memmove */) {
+    return memmoveN(first, last - first, dstFirst);
+}
+
+template <typename InIter, typename OutIter>
+inline OutIter moveHelper(InIter first, InIter last, OutIter dstFirst,
+                          false_type) {
     for (; first != last;)
         *(dstFirst++) = tiny_stl::move(*first++);
 
     return dstFirst;
 }
 
+template <typename InIter, typename OutIter>
+inline OutIter move(InIter first, InIter last, OutIter dstFirst) {
+    return moveHelper(first, last, dstFirst,
+                      MemmoveIsSafe<InIter, OutIter, TrivialMoveAssign>{});
+}
+
 template <typename BidIter1, typename BidIter2>
-inline BidIter2 move_backward(BidIter1 first, BidIter1 last, BidIter2 dstLast) {
+inline BidIter2 moveBackwardHelper(BidIter1 first, BidIter1 last,
+                                   BidIter2 dstLast, true_type /* memmove */) {
+    const BidIter2 dstFirst = dstLast - (last - first);
+    memmoveN(first, last - first, dstFirst);
+    return dstFirst;
+}
+
+template <typename BidIter1, typename BidIter2>
+inline BidIter2 moveBackwardHelper(BidIter1 first, BidIter1 last,
+                                   BidIter2 dstLast, false_type) {
     for (; first != last;)
         *(--dstLast) = tiny_stl::move(*(--last));
 
     return dstLast;
 }
 
+template <typename BidIter1, typename BidIter2>
+inline BidIter2 move_backward(BidIter1 first, BidIter1 last, BidIter2 dstLast) {
+    return moveBackwardHelper(
+        first, last, dstLast,
+        MemmoveIsSafe<BidIter1, BidIter2, TrivialMoveAssign>{});
+}
+
 template <typename FwdIter1, typename FwdIter2>
 inline FwdIter2 swap_ranges(FwdIter1 first1, FwdIter1 last1, FwdIter2 first2) {
     for (; first1 != last1; ++first1, ++first2)
@@ -297,7 +566,7 @@ inline bool equal(InIter1 first1, InIter1 last1, InIter2 first2, BinPred pred) {
 
 template <typename InIter1, typename InIter2>
 inline bool equal(InIter1 first1, InIter1 last1, InIter2 first2) {
-    return equal(first1, last1, first2, tiny_stl::equal_to<>());
+    return tiny_stl::equal(first1, last1, first2, tiny_stl::equal_to<>());
 }
 
 template <typename InIter1, typename InIter2, typename BinPred>
@@ -314,7 +583,8 @@ inline bool equal(InIter1 first1, InIter1 last1, InIter2 first2, InIter2 last2,
 template <typename InIter1, typename InIter2>
 inline bool equal(InIter1 first1, InIter1 last1, InIter2 first2,
                   InIter2 last2) {
-    return equal(first1, last1, first2, last2, tiny_stl::equal_to<>{});
+    return tiny_stl::equal(first1, last1, first2, last2,
+                           tiny_stl::equal_to<>{});
 }
 
 template <typename FwdIter, typename Cmp>
@@ -505,7 +775,7 @@ inline FwdIter rotate(FwdIter first, FwdIter mid, FwdIter last) {
 
     FwdIter next = mid;
     do { // left
-        iter_swap(first++, next++);
+        tiny_stl::iter_swap(first++, next++);
         if (first == mid)
             mid = next;
     } while (next != last);
@@ -514,7 +784,7 @@ inline FwdIter rotate(FwdIter first, FwdIter mid, FwdIter last) {
 
     // right
     for (next = mid; next != last;) {
-        iter_swap(first++, next++);
+        tiny_stl::iter_swap(first++, next++);
         if (first == mid)
             mid = next;
         else if (next == last)
@@ -568,8 +838,8 @@ inline void adjustHeapHelper(RanIter first, Diff hole, Diff len, T&& val,
 
     // have a right child
     while (rightChild < len) {
-        if (*(first + rightChild) <
-            *(first + (rightChild - 1))) // left child > right child
+        if (cmp(*(first + rightChild),
+                *(first + (rightChild - 1)))) // left child > right child
             --rightChild;
         *(first + hole) = tiny_stl::move(
             *(first + rightChild));      // move the bigger one to the hole
@@ -608,18 +878,18 @@ inline void pop_heap(RanIter first, RanIter last, Cmp cmp) {
 
 template <typename RanIter>
 inline void pop_heap(RanIter first, RanIter last) {
-    pop_heap(first, last, tiny_stl::less<>{});
+    tiny_stl::pop_heap(first, last, tiny_stl::less<>{});
 }
 
 template <typename RanIter, typename Cmp>
 inline void sort_heap(RanIter first, RanIter last, Cmp cmp) {
     for (; last - first > 1; --last)
-        pop_heap(first, last);
+        tiny_stl::pop_heap(first, last, cmp);
 }
 
 template <typename RanIter>
 inline void sort_heap(RanIter first, RanIter last) {
-    sort_heap(first, last, tiny_stl::less<>{});
+    tiny_stl::sort_heap(first, last, tiny_stl::less<>{});
 }
 
 template <typename RanIter, typename Cmp>
@@ -641,7 +911,7 @@ inline void make_heap(RanIter first, RanIter last, Cmp cmp) {
 
 template <typename RanIter>
 inline void make_heap(RanIter first, RanIter last) {
-    make_heap(first, last, tiny_stl::less<>{});
+    tiny_stl::make_heap(first, last, tiny_stl::less<>{});
 }
 
 template <typename RanIter, typename Cmp>
@@ -658,19 +928,99 @@ inline RanIter is_heap_until(RanIter first, RanIter last, Cmp cmp) {
     return last;
 }
 
-template <typename RanIter, typename Cmp>
+template <typename RanIter>
 inline RanIter is_heap_until(RanIter first, RanIter last) {
-    return is_heap_until(first, last, tiny_stl::less<>{});
+    return tiny_stl::is_heap_until(first, last, tiny_stl::less<>{});
 }
 
 template <typename RanIter, typename Cmp>
 inline bool is_heap(RanIter first, RanIter last, Cmp cmp) {
-    return is_heap_until(first, last, cmp) == last;
+    return tiny_stl::is_heap_until(first, last, cmp) == last;
 }
 
 template <typename RanIter>
 inline bool is_heap(RanIter first, RanIter last) {
-    return is_heap(first, last, tiny_stl::less<>{});
+    return tiny_stl::is_heap(first, last, tiny_stl::less<>{});
+}
+
+// d-ary heap, the children of i are D * i + 1 ... D * i + D
+// fewer levels than a binary heap and the children of a node are
+// adjacent, but a pop compares D children per level
+
+template <size_t D, typename RanIter, typename Diff, typename T, typename Cmp>
+inline void daryPushHeapHelper(RanIter first, Diff hole, Diff top, T&& val,
+                               Cmp& cmp) {
+    while (top < hole) {
+        const Diff parent = (hole - 1) / static_cast<Diff>(D);
+        if (!cmp(*(first + parent), val))
+            break;
+
+        *(first + hole) = tiny_stl::move(*(first + parent));
+        hole = parent;
+    }
+
+    *(first + hole) = tiny_stl::move(val);
+}
+
+// move the hole down along the largest children to a leaf, then put val
+// back up from there, as adjustHeapHelper does
+template <size_t D, typename RanIter, typename Diff, typename T, typename Cmp>
+inline void daryAdjustHeapHelper(RanIter first, Diff hole, Diff len, T&& val,
+                                 Cmp& cmp) {
+    const Diff top = hole;
+    const Diff d = static_cast<Diff>(D);
+    for (Diff child = hole * d + 1; child < len; child = hole * d + 1) {
+        const Diff last = tiny_stl::min(child + d, len);
+        Diff largest = child;
+        for (++child; child < last; ++child)
+            if (cmp(*(first + largest), *(first + child)))
+                largest = child;
+
+        *(first + hole) = tiny_stl::move(*(first + largest));
+        hole = largest;
+    }
+
+    daryPushHeapHelper<D>(first, hole, top, tiny_stl::move(val), cmp);
+}
+
+template <size_t D, typename RanIter, typename Cmp>
+inline void daryPushHeap(RanIter first, RanIter last, Cmp& cmp) {
+    using Diff = typename iterator_traits<RanIter>::difference_type;
+    Diff count = last - first;
+    if (count >= 2) {
+        auto val = tiny_stl::move(*--last);
+        daryPushHeapHelper<D>(first, --count, static_cast<Diff>(0),
+                              tiny_stl::move(val), cmp);
+    }
+}
+
+template <size_t D, typename RanIter, typename Cmp>
+inline void daryPopHeap(RanIter first, RanIter last, Cmp& cmp) {
+    using Diff = typename iterator_traits<RanIter>::difference_type;
+    if (last - first < 2)
+        return;
+
+    --last;
+    auto val = tiny_stl::move(*last);
+    *last = tiny_stl::move(*first);
+    daryAdjustHeapHelper<D>(first, static_cast<Diff>(0),
+                            static_cast<Diff>(last - first),
+                            tiny_stl::move(val), cmp);
+}
+
+template <size_t D, typename RanIter, typename Cmp>
+inline void daryMakeHeap(RanIter first, RanIter last, Cmp& cmp) {
+    using Diff = typename iterator_traits<RanIter>::difference_type;
+    const Diff len = last - first;
+    if (len < 2)
+        return;
+
+    for (Diff parent = (len - 2) / static_cast<Diff>(D);; --parent) {
+        auto val = tiny_stl::move(*(first + parent));
+        daryAdjustHeapHelper<D>(first, parent, len, tiny_stl::move(val), cmp);
+        if (parent == 0)
+            return;
+    }
 }
 
 template <typename FwdIter, typename Cmp>
@@ -717,90 +1067,406 @@ inline void insertSort(RanIter first, RanIter last, Compare& cmp) {
     }
 }
 
-// quick_sort
-template <typename RanIter>
-inline auto getRandom(RanIter first, RanIter last) {
-    using Diff = typename iterator_traits<RanIter>::difference_type;
-    static std::mt19937 e;
-    std::uniform_int_distribution<Diff> u{0, (last - first - 1)};
+// the element before first is not greater than any element of
+// [first, last), it stops the inner loop
+template <typename RanIter, typename Compare>
+inline void unguardedInsertSort(RanIter first, RanIter last, Compare& cmp) {
+    if (first == last)
+        return;
 
-    return u(e);
+    for (RanIter i = first + 1; i != last; ++i) {
+        if (cmp(*i, *(i - 1))) {
+            auto key = tiny_stl::move(*i);
+            RanIter j = i;
+            do {
+                *j = tiny_stl::move(*(j - 1));
+                --j;
+            } while (cmp(key, *(j - 1)));
+
+            *j = tiny_stl::move(key);
+        }
+    }
 }
 
+static const std::ptrdiff_t INSERT_SORT_MAX = 32;
+static const std::ptrdiff_t NINTHER_MIN = 128;
+static const std::ptrdiff_t PARTIAL_INSERT_SORT_MAX = 8;
+static const std::ptrdiff_t PARTITION_BLOCK_SIZE = 64;
+
+// insert sort, give up after PARTIAL_INSERT_SORT_MAX moves,
+// return true if [first, last) is sorted
 template <typename RanIter, typename Compare>
-inline RanIter quickSortPartition(RanIter first, RanIter last, Compare& cmp) {
-    using Diff = typename iterator_traits<RanIter>::difference_type;
-    Diff randomPos = getRandom(first, last);
-    iter_swap(first + randomPos, last - 1);
-    auto key = *(last - 1);
+inline bool partialInsertSort(RanIter first, RanIter last, Compare& cmp) {
+    if (first == last)
+        return true;
 
-    RanIter i = first;
-    for (RanIter j = first; j < last - 1; ++j) {
-        if (cmp(*j, key)) {
-            iter_swap(i++, j);
+    IterDiffType<RanIter> moves = 0;
+    for (RanIter i = first + 1; i != last; ++i) {
+        if (cmp(*i, *(i - 1))) {
+            auto key = tiny_stl::move(*i);
+            RanIter j = i;
+            do {
+                *j = tiny_stl::move(*(j - 1));
+                --j;
+            } while (j != first && cmp(key, *(j - 1)));
+
+            *j = tiny_stl::move(key);
+            moves += i - j;
         }
+
+        if (moves > PARTIAL_INSERT_SORT_MAX)
+            return false;
     }
-    iter_swap(i, last - 1);
 
-    return i;
+    return true;
 }
 
-static const std::ptrdiff_t INSERT_SORT_MAX = 32;
+template <typename RanIter, typename Compare>
+inline void sort2(RanIter a, RanIter b, Compare& cmp) {
+    if (cmp(*b, *a))
+        tiny_stl::iter_swap(a, b);
+}
+
+// *b is the median
+template <typename RanIter, typename Compare>
+inline void sort3(RanIter a, RanIter b, RanIter c, Compare& cmp) {
+    sort2(a, b, cmp);
+    sort2(b, c, cmp);
+    sort2(a, b, cmp);
+}
+
+// move the median of 3, or the ninther for a big range, to *first,
+// there is an element not less than it in [first + 1, last)
+template <typename RanIter, typename Compare>
+inline void choosePivot(RanIter first, RanIter last, Compare& cmp) {
+    const IterDiffType<RanIter> count = last - first;
+    const IterDiffType<RanIter> half = count / 2;
+    if (count > NINTHER_MIN) {
+        sort3(first, first + half, last - 1, cmp);
+        sort3(first + 1, first + (half - 1), last - 2, cmp);
+        sort3(first + 2, first + (half + 1), last - 3, cmp);
+        sort3(first + (half - 1), first + half, first + (half + 1), cmp);
+        tiny_stl::iter_swap(first, first + half);
+    } else {
+        sort3(first + half, first, last - 1, cmp);
+    }
+}
+
+// Hoare partition around *first, [first, pos) < *pos <= [pos + 1, last),
+// second is true if no element was swapped
+template <typename RanIter, typename Compare>
+inline pair<RanIter, bool> partitionRight(RanIter first, RanIter last,
+                                          Compare& cmp) {
+    auto pivot = tiny_stl::move(*first);
+    RanIter i = first;
+    RanIter j = last;
+
+    while (cmp(*++i, pivot))
+        ;
+
+    // no guard on the left if nothing less than pivot was found
+    if (i - 1 == first)
+        while (i < j && !cmp(*--j, pivot))
+            ;
+    else
+        while (!cmp(*--j, pivot))
+            ;
+
+    const bool partitioned = i >= j;
+    while (i < j) {
+        tiny_stl::iter_swap(i, j);
+        while (cmp(*++i, pivot))
+            ;
+        while (!cmp(*--j, pivot))
+            ;
+    }
+
+    RanIter pos = i - 1;
+    *first = tiny_stl::move(*pos);
+    *pos = tiny_stl::move(pivot);
+    return pair<RanIter, bool>(pos, partitioned);
+}
 
+// swap the elements at the offsets, cyclic moves if the counts differ
+template <typename RanIter>
+inline void swapOffsets(RanIter lbase, RanIter rbase,
+                        const unsigned char* loffsets,
+                        const unsigned char* roffsets, size_t num,
+                        bool useSwap) {
+    if (useSwap) {
+        // keep O(n) on the descending input
+        for (size_t k = 0; k < num; ++k)
+            tiny_stl::iter_swap(lbase + loffsets[k], rbase - roffsets[k]);
+    } else if (num > 0) {
+        RanIter l = lbase + loffsets[0];
+        RanIter r = rbase - roffsets[0];
+        auto tmp = tiny_stl::move(*l);
+        *l = tiny_stl::move(*r);
+        for (size_t k = 1; k < num; ++k) {
+            l = lbase + loffsets[k];
+            *r = tiny_stl::move(*l);
+            r = rbase - roffsets[k];
+            *l = tiny_stl::move(*r);
+        }
+        *r = tiny_stl::move(tmp);
+    }
+}
+
+// same as partitionRight, the comparisons fill blocks of offsets of the
+// misplaced elements without branches (BlockQuicksort)
 template <typename RanIter, typename Compare>
-inline void quickSort(RanIter first, RanIter last, IterDiffType<RanIter> diff,
-                      Compare& cmp) {
-    IterDiffType<RanIter> count = last - first;
-    if (count > INSERT_SORT_MAX && diff > 0) {
-        RanIter miditer = quickSortPartition(first, last, cmp);
+inline pair<RanIter, bool> partitionRightBranchless(RanIter first,
+                                                    RanIter last,
+                                                    Compare& cmp) {
+    auto pivot = tiny_stl::move(*first);
+    RanIter i = first;
+    RanIter j = last;
 
-        diff = (diff >> 1) + (diff >> 2);
+    while (cmp(*++i, pivot))
+        ;
+
+    if (i - 1 == first)
+        while (i < j && !cmp(*--j, pivot))
+            ;
+    else
+        while (!cmp(*--j, pivot))
+            ;
+
+    const bool partitioned = i >= j;
+    if (!partitioned) {
+        tiny_stl::iter_swap(i, j);
+        ++i;
+
+        const size_t kBlock = static_cast<size_t>(PARTITION_BLOCK_SIZE);
+        alignas(64) unsigned char loffsets[PARTITION_BLOCK_SIZE];
+        alignas(64) unsigned char roffsets[PARTITION_BLOCK_SIZE];
+        RanIter lbase = i;
+        RanIter rbase = j;
+        size_t lnum = 0, rnum = 0, lstart = 0, rstart = 0;
+
+        while (i < j) {
+            // an empty side takes a block, or half of what is left
+            const size_t unknown = static_cast<size_t>(j - i);
+            const size_t lsplit =
+                lnum == 0 ? (rnum == 0 ? unknown / 2 : unknown) : 0;
+            const size_t rsplit = rnum == 0 ? unknown - lsplit : 0;
+
+            const size_t lcount = lsplit < kBlock ? lsplit : kBlock;
+            for (size_t k = 0; k < lcount; ++k) {
+                loffsets[lnum] = static_cast<unsigned char>(k);
+                lnum += !cmp(*i, pivot);
+                ++i;
+            }
+
+            const size_t rcount = rsplit < kBlock ? rsplit : kBlock;
+            for (size_t k = 0; k < rcount; ++k) {
+                roffsets[rnum] = static_cast<unsigned char>(k + 1);
+                rnum += cmp(*--j, pivot);
+            }
+
+            const size_t num = lnum < rnum ? lnum : rnum;
+            swapOffsets(lbase, rbase, loffsets + lstart, roffsets + rstart,
+                        num, lnum == rnum);
+            lnum -= num;
+            rnum -= num;
+            lstart += num;
+            rstart += num;
+
+            if (lnum == 0) {
+                lstart = 0;
+                lbase = i;
+            }
+
+            if (rnum == 0) {
+                rstart = 0;
+                rbase = j;
+            }
+        }
 
-        quickSort(first, miditer, diff, cmp);
-        first = miditer;
+        // the misplaced elements left on one side go to the border
+        if (lnum != 0) {
+            while (lnum-- > 0)
+                tiny_stl::iter_swap(lbase + loffsets[lstart + lnum], --j);
+            i = j;
+        }
 
-        quickSort(miditer + 1, last, diff, cmp);
-        last = miditer + 1;
+        if (rnum != 0) {
+            while (rnum-- > 0) {
+                tiny_stl::iter_swap(rbase - roffsets[rstart + rnum], i);
+                ++i;
+            }
+        }
     }
 
-    if (count > INSERT_SORT_MAX) {
-        make_heap(first, last, cmp);
-        sort_heap(first, last, cmp);
+    RanIter pos = i - 1;
+    *first = tiny_stl::move(*pos);
+    *pos = tiny_stl::move(pivot);
+    return pair<RanIter, bool>(pos, partitioned);
+}
+
+// the elements equal to *first go to the left, [first, pos] == *pos <
+// [pos + 1, last), the element before first must not be less than *first
+template <typename RanIter, typename Compare>
+inline RanIter partitionLeft(RanIter first, RanIter last, Compare& cmp) {
+    auto pivot = tiny_stl::move(*first);
+    RanIter i = first;
+    RanIter j = last;
+
+    while (cmp(pivot, *--j))
+        ;
+
+    if (j + 1 == last)
+        while (i < j && !cmp(pivot, *++i))
+            ;
+    else
+        while (!cmp(pivot, *++i))
+            ;
+
+    while (i < j) {
+        tiny_stl::iter_swap(i, j);
+        while (cmp(pivot, *--j))
+            ;
+        while (!cmp(pivot, *++i))
+            ;
     }
 
-    else if (count >= 2) {
-        insertSort(first, last, cmp);
+    *first = tiny_stl::move(*j);
+    *j = tiny_stl::move(pivot);
+    return j;
+}
+
+// swap some elements of an unbalanced partition to break the pattern
+template <typename RanIter>
+inline void breakPatterns(RanIter first, RanIter last) {
+    const IterDiffType<RanIter> count = last - first;
+    if (count < INSERT_SORT_MAX)
+        return;
+
+    const IterDiffType<RanIter> quarter = count / 4;
+    tiny_stl::iter_swap(first, first + quarter);
+    tiny_stl::iter_swap(last - 1, last - quarter);
+    if (count > NINTHER_MIN) {
+        tiny_stl::iter_swap(first + 1, first + (quarter + 1));
+        tiny_stl::iter_swap(first + 2, first + (quarter + 2));
+        tiny_stl::iter_swap(last - 2, last - (quarter + 1));
+        tiny_stl::iter_swap(last - 3, last - (quarter + 2));
     }
 }
 
+// block partition for arithmetic values compared by less or greater
+template <typename RanIter, typename Compare>
+struct BranchlessPartition
+    : bool_constant<
+          is_arithmetic<typename iterator_traits<RanIter>::value_type>::value &&
+          (is_same<Compare, tiny_stl::less<>>::value ||
+           is_same<Compare, tiny_stl::greater<>>::value ||
+           is_same<Compare,
+                   tiny_stl::less<typename iterator_traits<
+                       RanIter>::value_type>>::value ||
+           is_same<Compare,
+                   tiny_stl::greater<typename iterator_traits<
+                       RanIter>::value_type>>::value)> {};
+
+template <typename RanIter, typename Compare>
+inline pair<RanIter, bool> partitionAux(RanIter first, RanIter last,
+                                        Compare& cmp, true_type) {
+    return partitionRightBranchless(first, last, cmp);
+}
+
+template <typename RanIter, typename Compare>
+inline pair<RanIter, bool> partitionAux(RanIter first, RanIter last,
+                                        Compare& cmp, false_type) {
+    return partitionRight(first, last, cmp);
+}
+
+// introsort with the pattern-defeating steps of pdqsort, badAllowed
+// unbalanced partitions are allowed before falling back to heap sort
+template <typename RanIter, typename Compare>
+inline void quickSort(RanIter first, RanIter last, int badAllowed,
+                      Compare& cmp, bool leftmost) {
+    using Diff = IterDiffType<RanIter>;
+
+    while (true) {
+        const Diff count = last - first;
+        if (count <= INSERT_SORT_MAX) {
+            if (leftmost)
+                insertSort(first, last, cmp);
+            else
+                unguardedInsertSort(first, last, cmp);
+            return;
+        }
+
+        choosePivot(first, last, cmp);
+
+        // *(first - 1) is the pivot of the last partition, no element of
+        // [first, last) is less than it, the equal ones need no more sort
+        if (!leftmost && !cmp(*(first - 1), *first)) {
+            first = partitionLeft(first, last, cmp) + 1;
+            continue;
+        }
+
+        pair<RanIter, bool> ret = partitionAux(
+            first, last, cmp, BranchlessPartition<RanIter, Compare>{});
+        RanIter mid = ret.first;
+
+        const Diff lcount = mid - first;
+        const Diff rcount = last - (mid + 1);
+        if (lcount < count / 8 || rcount < count / 8) {
+            if (--badAllowed == 0) {
+                tiny_stl::make_heap(first, last, cmp);
+                tiny_stl::sort_heap(first, last, cmp);
+                return;
+            }
+
+            breakPatterns(first, mid);
+            breakPatterns(mid + 1, last);
+        } else if (ret.second && partialInsertSort(first, mid, cmp) &&
+                   partialInsertSort(mid + 1, last, cmp)) {
+            return; // already sorted
+        }
+
+        // loop on the right part
+        quickSort(first, mid, badAllowed, cmp, leftmost);
+        first = mid + 1;
+        leftmost = false;
+    }
+}
+
+inline int sortDepthLimit(std::ptrdiff_t count) {
+    int depth = 0;
+    for (; count > 1; count >>= 1)
+        ++depth;
+    return depth;
+}
+
 } // namespace
 
 template <typename RanIter, typename Compare>
 inline void sort(RanIter first, RanIter last, Compare cmp) {
     if (last - first - 1 > 0) {
-        quickSort(first, last, last - first, cmp);
+        quickSort(first, last, sortDepthLimit(last - first), cmp, true);
     }
 }
 
 template <typename RanIter>
 inline void sort(RanIter first, RanIter last) {
-    sort(first, last, tiny_stl::less<>{});
+    tiny_stl::sort(first, last, tiny_stl::less<>{});
 }
 
 template <typename FwdIter, typename T, typename Compare>
 inline FwdIter lower_bound(FwdIter first, FwdIter last, const T& val,
                            Compare cmp) {
-    assert(is_sorted(first, last, cmp));
-
+    // [first, last) is partitioned by cmp(elem, val), checking it would
+    // make the search O(n)
     FwdIter ret = first;
     using Diff = typename iterator_traits<FwdIter>::difference_type;
-    Diff size = distance(first, last);
+    Diff size = tiny_stl::distance(first, last);
     Diff step = 0;
 
     while (size > 0) {
         ret = first;
         step = size >> 1;
-        advance(ret, step);
+        tiny_stl::advance(ret, step);
 
         if (!cmp(*ret, val)) { // left
             size = step;
@@ -815,23 +1481,21 @@ inline FwdIter lower_bound(FwdIter first, FwdIter last, const T& val,
 
 template <typename FwdIter, typename T>
 inline FwdIter lower_bound(FwdIter first, FwdIter last, const T& val) {
-    return lower_bound(first, last, val, tiny_stl::less<>{});
+    return tiny_stl::lower_bound(first, last, val, tiny_stl::less<>{});
 }
 
 template <typename FwdIter, typename T, typename Compare>
 inline FwdIter upper_bound(FwdIter first, FwdIter last, const T& val,
                            Compare cmp) {
-    assert(is_sorted(first, last, cmp));
-
     FwdIter ret = first;
     using Diff = typename iterator_traits<FwdIter>::difference_type;
-    Diff size = distance(first, last);
+    Diff size = tiny_stl::distance(first, last);
     Diff step = 0;
 
     while (size > 0) {
         ret = first;
         step = size >> 1;
-        advance(ret, step);
+        tiny_stl::advance(ret, step);
         if (cmp(val, *ret)) { // left
             size = step;
         } else { // right
@@ -845,34 +1509,35 @@ inline FwdIter upper_bound(FwdIter first, FwdIter last, const T& val,
 
 template <typename FwdIter, typename T>
 inline FwdIter upper_bound(FwdIter first, FwdIter last, const T& val) {
-    return upper_bound(first, last, val, tiny_stl::less<>{});
+    return tiny_stl::upper_bound(first, last, val, tiny_stl::less<>{});
 }
 
 template <typename FwdIter, typename T, typename Compare>
-inline FwdIter binary_search(FwdIter first, FwdIter last, const T& val,
-                             Compare cmp) {
-    first = lower_bound(first, last, val, cmp);
+inline bool binary_search(FwdIter first, FwdIter last, const T& val,
+                          Compare cmp) {
+    first = tiny_stl::lower_bound(first, last, val, cmp);
     return (!(first == last)) && !(cmp(val, *first));
 }
 
 template <typename FwdIter, typename T>
-inline FwdIter binary_search(FwdIter first, FwdIter last, const T& val) {
-    first = lower_bound(first, last, val);
+inline bool binary_search(FwdIter first, FwdIter last, const T& val) {
+    first = tiny_stl::lower_bound(first, last, val);
     return (!(first == last)) && !(val < *first);
 }
 
+// the upper bound is searched in [lower bound, last)
 template <typename FwdIter, typename T, typename Compare>
 inline pair<FwdIter, FwdIter> equal_range(FwdIter first, FwdIter last,
                                           const T& val, Compare cmp) {
-    return make_pair(lower_bound(first, last, val, cmp),
-                     upper_bound(first, last, val, cmp));
+    first = tiny_stl::lower_bound(first, last, val, cmp);
+    return tiny_stl::make_pair(first,
+                               tiny_stl::upper_bound(first, last, val, cmp));
 }
 
 template <typename FwdIter, typename T>
 inline pair<FwdIter, FwdIter> equal_range(FwdIter first, FwdIter last,
                                           const T& val) {
-    return make_pair(lower_bound(first, last, val),
-                     upper_bound(first, last, val));
+    return tiny_stl::equal_range(first, last, val, tiny_stl::less<>{});
 }
 
 } // namespace tiny_stl
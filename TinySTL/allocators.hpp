@@ -4,9 +4,13 @@
 
 #pragma once
 
+#include <atomic>
 #include <cassert>
+#include <climits>
 #include <cstddef>
+#include <cstdint>
 #include <cstdlib>
+#include <mutex>
 #include <new>
 
 #include "utility.hpp"
@@ -138,6 +142,10 @@ public:
     }
 }; // class allocator<void>
 
+// empty, the copy constructors are user-provided
+template <typename T>
+struct is_trivially_relocatable<allocator<T>> : true_type {};
+
 template <typename T>
 inline bool operator==(const allocator<T>& lhs,
                        const allocator<T>& rhs) noexcept {
@@ -150,6 +158,1070 @@ inline bool operator!=(const allocator<T>& lhs,
     return (!(lhs == rhs));
 }
 
+// memory pools for the nodes of list, forward_list, RBTree and HashTable
+//
+// fixed_pool:   free list of blocks of one size, carved from chunks
+// node_pool:    one fixed_pool per 16-byte size class up to kPoolMaxBlock,
+//               larger or over-aligned requests go to operator new
+// arena:        monotonic buffer, deallocate does nothing
+//
+// release() of a pool or an arena frees all the memory at once, the
+// blocks allocated before are invalid then. none of them is thread safe,
+// thread_cache_allocator is.
+
+static const size_t kPoolAlign = 16;
+static const size_t kPoolMaxBlock = 256;
+static const size_t kPoolClasses = kPoolMaxBlock / kPoolAlign;
+static const size_t kPoolMaxChunkBlocks = 4096;
+
+inline size_t poolRoundUp(size_t bytes) noexcept {
+    return (bytes + kPoolAlign - 1) & ~(kPoolAlign - 1);
+}
+
+// the size class of a pooled request of bytes
+inline size_t poolClass(size_t bytes) noexcept {
+    return bytes == 0 ? 0 : (bytes - 1) / kPoolAlign;
+}
+
+inline bool poolable(size_t bytes, size_t align) noexcept {
+    return bytes <= kPoolMaxBlock && align <= alignof(std::max_align_t);
+}
+
+struct PoolBlock {
+    PoolBlock* next;
+};
+
+class fixed_pool {
+    friend class node_pool;
+
+private:
+    PoolBlock* freeList;
+    PoolBlock* chunks; // the first block of each chunk links the chunks
+    size_t blockSize;
+    size_t blocksPerChunk;
+
+    fixed_pool() noexcept : fixed_pool(kPoolAlign) {
+    }
+
+    // the chunk size doubles up to kPoolMaxChunkBlocks blocks
+    void refill() {
+        char* chunk = static_cast<char*>(
+            ::operator new((blocksPerChunk + 1) * blockSize));
+
+        PoolBlock* header = reinterpret_cast<PoolBlock*>(chunk);
+        header->next = chunks;
+        chunks = header;
+
+        for (size_t i = blocksPerChunk; i > 0; --i) {
+            PoolBlock* b = reinterpret_cast<PoolBlock*>(chunk + i * blockSize);
+            b->next = freeList;
+            freeList = b;
+        }
+
+        if (blocksPerChunk < kPoolMaxChunkBlocks)
+            blocksPerChunk <<= 1;
+    }
+
+public:
+    explicit fixed_pool(size_t size, size_t initBlocks = 32) noexcept
+        : freeList(nullptr), chunks(nullptr),
+          blockSize(poolRoundUp(size < sizeof(PoolBlock) ? sizeof(PoolBlock)
+                                                         : size)),
+          blocksPerChunk(initBlocks == 0 ? 1 : initBlocks) {
+    }
+
+    fixed_pool(const fixed_pool&) = delete;
+    fixed_pool& operator=(const fixed_pool&) = delete;
+
+    ~fixed_pool() noexcept {
+        release();
+    }
+
+    void* allocate() {
+        if (freeList == nullptr)
+            refill();
+
+        PoolBlock* p = freeList;
+        freeList = p->next;
+        return p;
+    }
+
+    void deallocate(void* p) noexcept {
+        PoolBlock* b = static_cast<PoolBlock*>(p);
+        b->next = freeList;
+        freeList = b;
+    }
+
+    void release() noexcept {
+        while (chunks != nullptr) {
+            PoolBlock* next = chunks->next;
+            ::operator delete(chunks);
+            chunks = next;
+        }
+        freeList = nullptr;
+    }
+
+    size_t block_size() const noexcept {
+        return blockSize;
+    }
+}; // class fixed_pool
+
+class node_pool {
+private:
+    fixed_pool pools[kPoolClasses];
+
+public:
+    node_pool() noexcept {
+        for (size_t i = 0; i < kPoolClasses; ++i)
+            pools[i].blockSize = (i + 1) * kPoolAlign;
+    }
+
+    node_pool(const node_pool&) = delete;
+    node_pool& operator=(const node_pool&) = delete;
+
+    void* allocate(size_t bytes, size_t align = alignof(std::max_align_t)) {
+        if (!poolable(bytes, align))
+            return ::operator new(bytes);
+        return pools[poolClass(bytes)].allocate();
+    }
+
+    void deallocate(void* p, size_t bytes,
+                    size_t align = alignof(std::max_align_t)) noexcept {
+        if (!poolable(bytes, align))
+            ::operator delete(p);
+        else
+            pools[poolClass(bytes)].deallocate(p);
+    }
+
+    void release() noexcept {
+        for (auto& pool : pools)
+            pool.release();
+    }
+}; // class node_pool
+
+class arena {
+private:
+    struct Chunk {
+        Chunk* next;
+    };
+
+    char* cur;
+    char* last;
+    Chunk* chunks;
+    char* initBuffer; // not owned
+    size_t initSize;
+    size_t nextSize;
+
+    static const size_t kMaxChunk = SIZE_MAX - kPoolAlign;
+
+    // bytes is at most kMaxChunk
+    void grow(size_t bytes) {
+        const size_t size = bytes > nextSize ? bytes : nextSize;
+        char* p = static_cast<char*>(::operator new(kPoolAlign + size));
+
+        Chunk* c = reinterpret_cast<Chunk*>(p);
+        c->next = chunks;
+        chunks = c;
+
+        cur = p + kPoolAlign;
+        last = cur + size;
+        nextSize = size <= kMaxChunk / 2 ? size * 2 : kMaxChunk;
+    }
+
+public:
+    explicit arena(size_t size = 1024) noexcept
+        : cur(nullptr), last(nullptr), chunks(nullptr), initBuffer(nullptr),
+          initSize(0), nextSize(size == 0 ? 1024 : size) {
+    }
+
+    // allocate from buffer first, e.g. a buffer on the stack
+    arena(void* buffer, size_t size) noexcept
+        : cur(static_cast<char*>(buffer)), last(cur + size), chunks(nullptr),
+          initBuffer(cur), initSize(size), nextSize(size == 0 ? 1024 : size) {
+    }
+
+    arena(const arena&) = delete;
+    arena& operator=(const arena&) = delete;
+
+    ~arena() noexcept {
+        release();
+    }
+
+    void* allocate(size_t bytes, size_t align = alignof(std::max_align_t)) {
+        size_t pad = (0 - reinterpret_cast<uintptr_t>(cur)) & (align - 1);
+        const size_t avail = static_cast<size_t>(last - cur);
+        if (cur == nullptr || bytes > avail || pad > avail - bytes) {
+            if (bytes > kMaxChunk - align)
+                throw std::bad_alloc();
+            grow(bytes + align);
+            pad = (0 - reinterpret_cast<uintptr_t>(cur)) & (align - 1);
+        }
+
+        void* p = cur + pad;
+        cur += pad + bytes;
+        return p;
+    }
+
+    void deallocate(void*, size_t, size_t = 0) noexcept {
+        // do nothing
+    }
+
+    void release() noexcept {
+        while (chunks != nullptr) {
+            Chunk* next = chunks->next;
+            ::operator delete(chunks);
+            chunks = next;
+        }
+        cur = initBuffer;
+        last = initBuffer + initSize;
+        if (initSize != 0)
+            nextSize = initSize;
+    }
+}; // class arena
+
+// the pool of the default constructed pool_allocator, one per thread so
+// the free lists are never shared. a container using it must allocate
+// and free on the thread which constructed its allocator and must not
+// outlive that thread, the pool frees its chunks on thread exit. use
+// thread_cache_allocator for nodes which cross threads
+inline node_pool& defaultNodePool() {
+    thread_local node_pool pool;
+    return pool;
+}
+
+// allocate from a node_pool, the copies and rebound copies share the pool
+template <typename T>
+class pool_allocator {
+public:
+    using value_type = T;
+    using pointer = T*;
+    using const_pointer = const T*;
+    using reference = T&;
+    using const_reference = const T&;
+    using size_type = size_t;
+    using difference_type = ptrdiff_t;
+
+    // never propagate, the sentinel nodes of a container stay with the
+    // allocator the container was constructed with
+    using propagate_on_container_copy_assignment = tiny_stl::false_type;
+    using propagate_on_container_move_assignment = tiny_stl::false_type;
+    using propagate_on_container_swap = tiny_stl::false_type;
+    using is_always_equal = tiny_stl::false_type;
+
+private:
+    node_pool* mPool;
+
+public:
+    pool_allocator() noexcept : mPool(&defaultNodePool()) {
+    }
+
+    explicit pool_allocator(node_pool* pool) noexcept : mPool(pool) {
+    }
+
+    template <typename Other>
+    pool_allocator(const pool_allocator<Other>& rhs) noexcept
+        : mPool(rhs.pool()) {
+    }
+
+    template <typename U>
+    struct rebind {
+        using other = pool_allocator<U>;
+    };
+
+    pointer allocate(size_type n) {
+        return static_cast<pointer>(mPool->allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(pointer p, size_type n) noexcept {
+        mPool->deallocate(p, n * sizeof(T), alignof(T));
+    }
+
+    template <typename Obj, typename... Args>
+    void construct(Obj* p, Args&&... args) {
+        constructHelper(p, tiny_stl::forward<Args>(args)...);
+    }
+
+    template <typename Obj>
+    void destroy(Obj* ptr) {
+        destroy_at(ptr);
+    }
+
+    size_type max_size() const noexcept {
+        return (SIZE_MAX / sizeof(T));
+    }
+
+    node_pool* pool() const noexcept {
+        return mPool;
+    }
+}; // class pool_allocator<T>
+
+template <typename T, typename U>
+inline bool operator==(const pool_allocator<T>& lhs,
+                       const pool_allocator<U>& rhs) noexcept {
+    return lhs.pool() == rhs.pool();
+}
+
+template <typename T, typename U>
+inline bool operator!=(const pool_allocator<T>& lhs,
+                       const pool_allocator<U>& rhs) noexcept {
+    return !(lhs == rhs);
+}
+
+// allocate from an arena, memory comes back only by arena::release()
+template <typename T>
+class arena_allocator {
+public:
+    using value_type = T;
+    using pointer = T*;
+    using const_pointer = const T*;
+    using reference = T&;
+    using const_reference = const T&;
+    using size_type = size_t;
+    using difference_type = ptrdiff_t;
+
+    // never propagate, the sentinel nodes of a container stay with the
+    // allocator the container was constructed with
+    using propagate_on_container_copy_assignment = tiny_stl::false_type;
+    using propagate_on_container_move_assignment = tiny_stl::false_type;
+    using propagate_on_container_swap = tiny_stl::false_type;
+    using is_always_equal = tiny_stl::false_type;
+
+private:
+    arena* mArena;
+
+public:
+    explicit arena_allocator(arena* a) noexcept : mArena(a) {
+    }
+
+    template <typename Other>
+    arena_allocator(const arena_allocator<Other>& rhs) noexcept
+        : mArena(rhs.get_arena()) {
+    }
+
+    template <typename U>
+    struct rebind {
+        using other = arena_allocator<U>;
+    };
+
+    pointer allocate(size_type n) {
+        return static_cast<pointer>(
+            mArena->allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(pointer, size_type) noexcept {
+        // do nothing
+    }
+
+    template <typename Obj, typename... Args>
+    void construct(Obj* p, Args&&... args) {
+        constructHelper(p, tiny_stl::forward<Args>(args)...);
+    }
+
+    template <typename Obj>
+    void destroy(Obj* ptr) {
+        destroy_at(ptr);
+    }
+
+    size_type max_size() const noexcept {
+        return (SIZE_MAX / sizeof(T));
+    }
+
+    arena* get_arena() const noexcept {
+        return mArena;
+    }
+}; // class arena_allocator<T>
+
+template <typename T, typename U>
+inline bool operator==(const arena_allocator<T>& lhs,
+                       const arena_allocator<U>& rhs) noexcept {
+    return lhs.get_arena() == rhs.get_arena();
+}
+
+template <typename T, typename U>
+inline bool operator!=(const arena_allocator<T>& lhs,
+                       const arena_allocator<U>& rhs) noexcept {
+    return !(lhs == rhs);
+}
+
+// blocks moved between a thread cache and the central pool at a time
+static const size_t kThreadCacheBatch = 32;
+
+// the pool behind every thread cache
+class ThreadCentralPool {
+private:
+    std::mutex mtx;
+    node_pool pool;
+
+public:
+    static ThreadCentralPool& instance() {
+        static ThreadCentralPool central;
+        return central;
+    }
+
+    // n blocks of size class cls linked as a list
+    PoolBlock* allocateBatch(size_t cls, size_t n) {
+        std::lock_guard<std::mutex> lock(mtx);
+        PoolBlock* head = nullptr;
+        for (size_t i = 0; i < n; ++i) {
+            PoolBlock* b =
+                static_cast<PoolBlock*>(pool.allocate((cls + 1) * kPoolAlign));
+            b->next = head;
+            head = b;
+        }
+
+        return head;
+    }
+
+    void deallocateBatch(size_t cls, PoolBlock* head) noexcept {
+        std::lock_guard<std::mutex> lock(mtx);
+        while (head != nullptr) {
+            PoolBlock* next = head->next;
+            pool.deallocate(head, (cls + 1) * kPoolAlign);
+            head = next;
+        }
+    }
+};
+
+// the free lists of a thread, a block may be freed by another thread
+class ThreadCache {
+private:
+    struct FreeList {
+        PoolBlock* head = nullptr;
+        size_t count = 0;
+    };
+
+    FreeList lists[kPoolClasses];
+
+    // give back the first n blocks of lists[cls]
+    void flush(size_t cls, size_t n) noexcept {
+        FreeList& list = lists[cls];
+        PoolBlock* head = list.head;
+        PoolBlock* tail = head;
+        for (size_t i = 1; i < n; ++i)
+            tail = tail->next;
+
+        list.head = tail->next;
+        list.count -= n;
+        tail->next = nullptr;
+        ThreadCentralPool::instance().deallocateBatch(cls, head);
+    }
+
+public:
+    static ThreadCache& instance() {
+        thread_local ThreadCache cache;
+        return cache;
+    }
+
+    ~ThreadCache() noexcept {
+        for (size_t cls = 0; cls < kPoolClasses; ++cls) {
+            if (lists[cls].count != 0)
+                flush(cls, lists[cls].count);
+        }
+    }
+
+    void* allocate(size_t bytes, size_t align) {
+        if (!poolable(bytes, align))
+            return ::operator new(bytes);
+
+        FreeList& list = lists[poolClass(bytes)];
+        if (list.head == nullptr) {
+            list.head = ThreadCentralPool::instance().allocateBatch(
+                poolClass(bytes), kThreadCacheBatch);
+            list.count = kThreadCacheBatch;
+        }
+
+        PoolBlock* p = list.head;
+        list.head = p->next;
+        --list.count;
+        return p;
+    }
+
+    void deallocate(void* p, size_t bytes, size_t align) noexcept {
+        if (!poolable(bytes, align)) {
+            ::operator delete(p);
+            return;
+        }
+
+        const size_t cls = poolClass(bytes);
+        FreeList& list = lists[cls];
+        PoolBlock* b = static_cast<PoolBlock*>(p);
+        b->next = list.head;
+        list.head = b;
+        if (++list.count > 2 * kThreadCacheBatch)
+            flush(cls, kThreadCacheBatch);
+    }
+};
+
+// pooled blocks cached per thread, most allocations and deallocations take
+// no lock, the central pool is locked once per kThreadCacheBatch blocks
+template <typename T>
+class thread_cache_allocator {
+public:
+    using value_type = T;
+    using pointer = T*;
+    using const_pointer = const T*;
+    using reference = T&;
+    using const_reference = const T&;
+    using size_type = size_t;
+    using difference_type = ptrdiff_t;
+
+    using propagate_on_container_move_assignment = tiny_stl::true_type;
+    using is_always_equal = tiny_stl::true_type;
+
+public:
+    thread_cache_allocator() noexcept {
+    }
+
+    template <typename Other>
+    thread_cache_allocator(const thread_cache_allocator<Other>&) noexcept {
+    }
+
+    template <typename U>
+    struct rebind {
+        using other = thread_cache_allocator<U>;
+    };
+
+    pointer allocate(size_type n) {
+        return static_cast<pointer>(
+            ThreadCache::instance().allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(pointer p, size_type n) noexcept {
+        ThreadCache::instance().deallocate(p, n * sizeof(T), alignof(T));
+    }
+
+    template <typename Obj, typename... Args>
+    void construct(Obj* p, Args&&... args) {
+        constructHelper(p, tiny_stl::forward<Args>(args)...);
+    }
+
+    template <typename Obj>
+    void destroy(Obj* ptr) {
+        destroy_at(ptr);
+    }
+
+    size_type max_size() const noexcept {
+        return (SIZE_MAX / sizeof(T));
+    }
+}; // class thread_cache_allocator<T>
+
+template <typename T, typename U>
+inline bool operator==(const thread_cache_allocator<T>&,
+                       const thread_cache_allocator<U>&) noexcept {
+    return true;
+}
+
+template <typename T, typename U>
+inline bool operator!=(const thread_cache_allocator<T>&,
+                       const thread_cache_allocator<U>&) noexcept {
+    return false;
+}
+
+namespace pmr {
+
+// polymorphic memory resources
+//
+// memory_resource: the interface, do_allocate/do_deallocate/do_is_equal
+// new_delete_resource(): operator new/delete
+// null_memory_resource(): every allocation throws std::bad_alloc
+// monotonic_buffer_resource: bump pointer over an optional initial buffer
+//                            and chunks from upstream, freed by release()
+// unsynchronized_pool_resource: free lists of power-of-two size classes,
+//                               chunks from upstream
+// synchronized_pool_resource: unsynchronized_pool_resource with a mutex
+
+class memory_resource {
+    static constexpr size_t kMaxAlign = alignof(std::max_align_t);
+
+public:
+    virtual ~memory_resource() = default;
+
+    void* allocate(size_t bytes, size_t align = kMaxAlign) {
+        return do_allocate(bytes, align);
+    }
+
+    void deallocate(void* p, size_t bytes, size_t align = kMaxAlign) {
+        do_deallocate(p, bytes, align);
+    }
+
+    bool is_equal(const memory_resource& rhs) const noexcept {
+        return do_is_equal(rhs);
+    }
+
+private:
+    virtual void* do_allocate(size_t bytes, size_t align) = 0;
+    virtual void do_deallocate(void* p, size_t bytes, size_t align) = 0;
+    virtual bool do_is_equal(const memory_resource& rhs) const noexcept = 0;
+}; // class memory_resource
+
+inline bool operator==(const memory_resource& lhs,
+                       const memory_resource& rhs) noexcept {
+    return &lhs == &rhs || lhs.is_equal(rhs);
+}
+
+inline bool operator!=(const memory_resource& lhs,
+                       const memory_resource& rhs) noexcept {
+    return !(lhs == rhs);
+}
+
+class NewDeleteResource : public memory_resource {
+private:
+    // over-aligned blocks keep the pointer from operator new before them
+    void* do_allocate(size_t bytes, size_t align) override {
+        if (align <= alignof(std::max_align_t))
+            return ::operator new(bytes);
+
+        char* raw = static_cast<char*>(
+            ::operator new(bytes + align + sizeof(void*)));
+        uintptr_t aligned =
+            (reinterpret_cast<uintptr_t>(raw) + sizeof(void*) + align - 1) &
+            ~(static_cast<uintptr_t>(align) - 1);
+        reinterpret_cast<void**>(aligned)[-1] = raw;
+        return reinterpret_cast<void*>(aligned);
+    }
+
+    void do_deallocate(void* p, size_t, size_t align) override {
+        if (align <= alignof(std::max_align_t))
+            ::operator delete(p);
+        else
+            ::operator delete(static_cast<void**>(p)[-1]);
+    }
+
+    bool do_is_equal(const memory_resource& rhs) const noexcept override {
+        return this == &rhs;
+    }
+};
+
+class NullMemoryResource : public memory_resource {
+private:
+    void* do_allocate(size_t, size_t) override {
+        throw std::bad_alloc();
+    }
+
+    void do_deallocate(void*, size_t, size_t) override {
+    }
+
+    bool do_is_equal(const memory_resource& rhs) const noexcept override {
+        return this == &rhs;
+    }
+};
+
+inline memory_resource* new_delete_resource() noexcept {
+    static NewDeleteResource resource;
+    return &resource;
+}
+
+inline memory_resource* null_memory_resource() noexcept {
+    static NullMemoryResource resource;
+    return &resource;
+}
+
+inline std::atomic<memory_resource*>& defaultResource() noexcept {
+    static std::atomic<memory_resource*> resource{new_delete_resource()};
+    return resource;
+}
+
+inline memory_resource* get_default_resource() noexcept {
+    return defaultResource().load();
+}
+
+// nullptr means new_delete_resource(), return the previous one
+inline memory_resource* set_default_resource(memory_resource* r) noexcept {
+    return defaultResource().exchange(r != nullptr ? r
+                                                   : new_delete_resource());
+}
+
+class monotonic_buffer_resource : public memory_resource {
+private:
+    struct Chunk {
+        Chunk* next;
+        size_t size; // bytes from upstream, header included
+    };
+
+    static const size_t kHeaderSize = kPoolAlign;
+
+    memory_resource* upstream;
+    char* cur;
+    char* last;
+    Chunk* chunks;
+    char* initBuffer; // not owned
+    size_t initSize;
+    size_t nextSize;
+
+    static const size_t kMaxChunk = SIZE_MAX - kHeaderSize;
+
+    void grow(size_t bytes, size_t align) {
+        if (bytes > kMaxChunk - align)
+            throw std::bad_alloc();
+
+        // the doubling stops before it can wrap
+        const size_t need = bytes + align;
+        size_t size = nextSize;
+        while (size < need && size <= kMaxChunk / 2)
+            size *= 2;
+        if (size < need)
+            size = need;
+
+        char* p = static_cast<char*>(upstream->allocate(
+            kHeaderSize + size, alignof(std::max_align_t)));
+
+        Chunk* c = reinterpret_cast<Chunk*>(p);
+        c->next = chunks;
+        c->size = kHeaderSize + size;
+        chunks = c;
+
+        cur = p + kHeaderSize;
+        last = cur + size;
+        nextSize = size <= kMaxChunk / 2 ? size * 2 : kMaxChunk;
+    }
+
+    void* do_allocate(size_t bytes, size_t align) override {
+        size_t pad = (0 - reinterpret_cast<uintptr_t>(cur)) & (align - 1);
+        const size_t avail = static_cast<size_t>(last - cur);
+        if (cur == nullptr || bytes > avail || pad > avail - bytes) {
+            grow(bytes, align);
+            pad = (0 - reinterpret_cast<uintptr_t>(cur)) & (align - 1);
+        }
+
+        void* p = cur + pad;
+        cur += pad + bytes;
+        return p;
+    }
+
+    void do_deallocate(void*, size_t, size_t) override {
+        // do nothing
+    }
+
+    bool do_is_equal(const memory_resource& rhs) const noexcept override {
+        return this == &rhs;
+    }
+
+public:
+    monotonic_buffer_resource() : monotonic_buffer_resource(1024) {
+    }
+
+    explicit monotonic_buffer_resource(memory_resource* up)
+        : monotonic_buffer_resource(1024, up) {
+    }
+
+    explicit monotonic_buffer_resource(
+        size_t initialSize, memory_resource* up = get_default_resource())
+        : upstream(up), cur(nullptr), last(nullptr), chunks(nullptr),
+          initBuffer(nullptr), initSize(0),
+          nextSize(initialSize == 0 ? 1024 : initialSize) {
+    }
+
+    monotonic_buffer_resource(void* buffer, size_t size,
+                              memory_resource* up = get_default_resource())
+        : upstream(up), cur(static_cast<char*>(buffer)), last(cur + size),
+          chunks(nullptr), initBuffer(cur), initSize(size),
+          nextSize(size == 0 ? 1024 : size) {
+    }
+
+    monotonic_buffer_resource(const monotonic_buffer_resource&) = delete;
+    monotonic_buffer_resource&
+    operator=(const monotonic_buffer_resource&) = delete;
+
+    ~monotonic_buffer_resource() override {
+        release();
+    }
+
+    void release() noexcept {
+        while (chunks != nullptr) {
+            Chunk* next = chunks->next;
+            upstream->deallocate(chunks, chunks->size,
+                                 alignof(std::max_align_t));
+            chunks = next;
+        }
+
+        cur = initBuffer;
+        last = initBuffer + initSize;
+        nextSize = initSize == 0 ? nextSize : initSize;
+    }
+
+    memory_resource* upstream_resource() const noexcept {
+        return upstream;
+    }
+}; // class monotonic_buffer_resource
+
+struct pool_options {
+    size_t max_blocks_per_chunk = 0;        // 0: the default
+    size_t largest_required_pool_block = 0; // 0: the default
+};
+
+class unsynchronized_pool_resource : public memory_resource {
+private:
+    static const size_t kMinBlock = 8;
+    static const size_t kDefaultLargest = 4096;
+    static const size_t kDefaultMaxBlocks = 1024;
+    static const size_t kMaxClasses = 32;
+
+    // chunk header, the blocks follow kHeaderSize bytes later
+    struct Chunk {
+        Chunk* next;
+        size_t size;
+    };
+
+    // a block larger than the largest pool block or over-aligned, linked
+    // for release(), the header sits right before the block
+    struct Large {
+        Large* prev;
+        Large* next;
+        char* base;   // pointer from upstream
+        size_t size;  // bytes from upstream
+        size_t align; // alignment asked from upstream
+    };
+
+    static const size_t kHeaderSize = kPoolAlign;
+    static const size_t kLargeSize = 4 * kPoolAlign;
+
+    struct Pool {
+        PoolBlock* freeList;
+        Chunk* chunks;
+        size_t blocksPerChunk;
+    };
+
+    memory_resource* upstream;
+    pool_options opts;
+    size_t numClasses;
+    Pool pools[kMaxClasses];
+    Large* larges;
+
+    size_t classSize(size_t cls) const noexcept {
+        return kMinBlock << cls;
+    }
+
+    // numClasses if need is over the largest pool block, the shift
+    // never passes the width of size_t
+    size_t classOf(size_t bytes, size_t align) const noexcept {
+        const size_t need = bytes > align ? bytes : align;
+        if (need > classSize(numClasses - 1))
+            return numClasses;
+        size_t cls = 0;
+        while (classSize(cls) < need)
+            ++cls;
+        return cls;
+    }
+
+    static size_t chunkAlign(size_t blockSize) noexcept {
+        return blockSize < alignof(std::max_align_t)
+                   ? blockSize
+                   : alignof(std::max_align_t);
+    }
+
+    void refill(size_t cls) {
+        Pool& pool = pools[cls];
+        const size_t blockSize = classSize(cls);
+        const size_t headerSize =
+            blockSize > kHeaderSize ? blockSize : kHeaderSize;
+        const size_t size = headerSize + pool.blocksPerChunk * blockSize;
+        char* p = static_cast<char*>(
+            upstream->allocate(size, chunkAlign(blockSize)));
+
+        Chunk* c = reinterpret_cast<Chunk*>(p);
+        c->next = pool.chunks;
+        c->size = size;
+        pool.chunks = c;
+
+        for (size_t i = pool.blocksPerChunk; i > 0; --i) {
+            char* block = p + headerSize + (i - 1) * blockSize;
+            PoolBlock* b = reinterpret_cast<PoolBlock*>(block);
+            b->next = pool.freeList;
+            pool.freeList = b;
+        }
+
+        if (pool.blocksPerChunk < opts.max_blocks_per_chunk)
+            pool.blocksPerChunk *= 2;
+        if (pool.blocksPerChunk > opts.max_blocks_per_chunk)
+            pool.blocksPerChunk = opts.max_blocks_per_chunk;
+    }
+
+    bool isLarge(size_t cls, size_t align) const noexcept {
+        return cls >= numClasses || align > alignof(std::max_align_t);
+    }
+
+    void* allocateLarge(size_t bytes, size_t align) {
+        const size_t offset = align > kLargeSize ? align : kLargeSize;
+        if (bytes > SIZE_MAX - offset)
+            throw std::bad_alloc();
+        const size_t upAlign = align > alignof(std::max_align_t)
+                                   ? align
+                                   : alignof(std::max_align_t);
+        char* p =
+            static_cast<char*>(upstream->allocate(offset + bytes, upAlign));
+
+        Large* l = reinterpret_cast<Large*>(p + offset - kLargeSize);
+        l->prev = nullptr;
+        l->next = larges;
+        l->base = p;
+        l->size = offset + bytes;
+        l->align = upAlign;
+        if (larges != nullptr)
+            larges->prev = l;
+        larges = l;
+
+        return p + offset;
+    }
+
+    void deallocateLarge(void* p) {
+        Large* l = reinterpret_cast<Large*>(static_cast<char*>(p) - kLargeSize);
+        if (l->prev != nullptr)
+            l->prev->next = l->next;
+        else
+            larges = l->next;
+        if (l->next != nullptr)
+            l->next->prev = l->prev;
+
+        upstream->deallocate(l->base, l->size, l->align);
+    }
+
+    void* do_allocate(size_t bytes, size_t align) override {
+        const size_t cls = classOf(bytes, align);
+        if (isLarge(cls, align))
+            return allocateLarge(bytes, align);
+
+        Pool& pool = pools[cls];
+        if (pool.freeList == nullptr)
+            refill(cls);
+
+        PoolBlock* b = pool.freeList;
+        pool.freeList = b->next;
+        return b;
+    }
+
+    void do_deallocate(void* p, size_t bytes, size_t align) override {
+        const size_t cls = classOf(bytes, align);
+        if (isLarge(cls, align)) {
+            deallocateLarge(p);
+            return;
+        }
+
+        PoolBlock* b = static_cast<PoolBlock*>(p);
+        b->next = pools[cls].freeList;
+        pools[cls].freeList = b;
+    }
+
+    bool do_is_equal(const memory_resource& rhs) const noexcept override {
+        return this == &rhs;
+    }
+
+public:
+    unsynchronized_pool_resource()
+        : unsynchronized_pool_resource(pool_options(),
+                                       get_default_resource()) {
+    }
+
+    explicit unsynchronized_pool_resource(memory_resource* up)
+        : unsynchronized_pool_resource(pool_options(), up) {
+    }
+
+    explicit unsynchronized_pool_resource(
+        const pool_options& options,
+        memory_resource* up = get_default_resource())
+        : upstream(up), opts(options), numClasses(0), larges(nullptr) {
+        if (opts.max_blocks_per_chunk == 0)
+            opts.max_blocks_per_chunk = kDefaultMaxBlocks;
+        if (opts.largest_required_pool_block == 0)
+            opts.largest_required_pool_block = kDefaultLargest;
+        if (opts.largest_required_pool_block < kMinBlock)
+            opts.largest_required_pool_block = kMinBlock;
+
+        while (numClasses < kMaxClasses &&
+               classSize(numClasses) < opts.largest_required_pool_block)
+            ++numClasses;
+        if (numClasses < kMaxClasses)
+            ++numClasses;
+        opts.largest_required_pool_block = classSize(numClasses - 1);
+
+        for (size_t i = 0; i < numClasses; ++i)
+            pools[i] = Pool{nullptr, nullptr, 4};
+    }
+
+    unsynchronized_pool_resource(const unsynchronized_pool_resource&) = delete;
+    unsynchronized_pool_resource&
+    operator=(const unsynchronized_pool_resource&) = delete;
+
+    ~unsynchronized_pool_resource() override {
+        release();
+    }
+
+    void release() noexcept {
+        for (size_t cls = 0; cls < numClasses; ++cls) {
+            Pool& pool = pools[cls];
+            while (pool.chunks != nullptr) {
+                Chunk* next = pool.chunks->next;
+                upstream->deallocate(pool.chunks, pool.chunks->size,
+                                     chunkAlign(classSize(cls)));
+                pool.chunks = next;
+            }
+            pool.freeList = nullptr;
+            pool.blocksPerChunk = 4;
+        }
+
+        while (larges != nullptr) {
+            Large* next = larges->next;
+            upstream->deallocate(larges->base, larges->size, larges->align);
+            larges = next;
+        }
+    }
+
+    memory_resource* upstream_resource() const noexcept {
+        return upstream;
+    }
+
+    pool_options options() const noexcept {
+        return opts;
+    }
+}; // class unsynchronized_pool_resource
+
+class synchronized_pool_resource : public memory_resource {
+private:
+    std::mutex mtx;
+    unsynchronized_pool_resource pool;
+
+    void* do_allocate(size_t bytes, size_t align) override {
+        std::lock_guard<std::mutex> lock(mtx);
+        return pool.allocate(bytes, align);
+    }
+
+    void do_deallocate(void* p, size_t bytes, size_t align) override {
+        std::lock_guard<std::mutex> lock(mtx);
+        pool.deallocate(p, bytes, align);
+    }
+
+    bool do_is_equal(const memory_resource& rhs) const noexcept override {
+        return this == &rhs;
+    }
+
+public:
+    synchronized_pool_resource() {
+    }
+
+    explicit synchronized_pool_resource(memory_resource* up) : pool(up) {
+    }
+
+    explicit synchronized_pool_resource(
+        const pool_options& options,
+        memory_resource* up = get_default_resource())
+        : pool(options, up) {
+    }
+
+    void release() {
+        std::lock_guard<std::mutex> lock(mtx);
+        pool.release();
+    }
+
+    memory_resource* upstream_resource() const noexcept {
+        return pool.upstream_resource();
+    }
+
+    pool_options options() const noexcept {
+        return pool.options();
+    }
+}; // class synchronized_pool_resource
+
+} // namespace pmr
+
 template <typename Alloc>
 inline void swapAllocHelper(Alloc& lhs, Alloc& rhs, true_type) {
     swapADL(lhs, rhs);
@@ -298,6 +298,29 @@ constexpr ArrayIterator<T, Size> operator+(ptrdiff_t offset,
     return rhs += offset;
 }
 
+template <typename T, size_t Size>
+struct ContiguousIterator<ArrayConstIterator<T, Size>> : true_type {
+    using element_type = const T;
+
+    static const T* address(ArrayConstIterator<T, Size> iter) noexcept {
+#ifndef NDEBUG
+        return iter.ptr + iter.idx;
+#else
+        return iter.ptr;
+#endif // !NDEBUG
+    }
+};
+
+template <typename T, size_t Size>
+struct ContiguousIterator<ArrayIterator<T, Size>> : true_type {
+    using element_type = T;
+
+    static T* address(ArrayIterator<T, Size> iter) noexcept {
+        return const_cast<T*>(ContiguousIterator<
+                              ArrayConstIterator<T, Size>>::address(iter));
+    }
+};
+
 template <typename T, size_t Size>
 class array {
 public:
@@ -0,0 +1,397 @@
+// Copyright (C) 2021 syn1w
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+
+#include "algorithm.hpp"
+#include "memory.hpp"
+#include "vector.hpp"
+
+namespace tiny_stl {
+
+// atomic_shared_ptr, a shared_ptr<T> slot read and replaced concurrently
+//
+// The slot points to a heap Entry holding one shared_ptr<T>. A writer
+// publishes a new Entry with one exchange or CAS and retires the old
+// one. Readers protect the Entry they are looking at with a hazard
+// pointer (M. Michael's scheme): the thread announces the pointer in its
+// own record, re-reads the slot, and the Entry cannot be freed until the
+// announcement is cleared. load() takes no lock and writes nothing but
+// that record, which lives on its own cache line.
+//
+// load() still copies the shared_ptr, an atomic increment of the use
+// count every reader shares. read() returns a read_guard that keeps the
+// Entry protected without copying, so readers touch no shared line at
+// all; a guard should be short-lived, it delays freeing that Entry.
+//
+// Retired Entries are freed in batches once there are a few more of
+// them than hazard records; the batch bookkeeping takes a mutex, only
+// writers go there. The destructor scans once more, so a value replaced
+// by store, exchange or compare_exchange does not outlive its
+// atomic_shared_ptr unless a read_guard still protects it.
+
+// one announced pointer, a thread owns the record while active
+struct alignas(kCacheLineSize) HazardRecord {
+    std::atomic<const void*> ptr{nullptr};
+    std::atomic<bool> active{true};
+    HazardRecord* next{nullptr};
+    char* storage; // the record, aligned to a cache line inside it
+
+    explicit HazardRecord(char* s) noexcept : storage(s) {
+    }
+};
+
+class HazardDomain {
+private:
+    struct Retired {
+        void* ptr;
+        void (*destroy)(void*);
+    };
+
+    // records are reused and never freed while the domain lives
+    std::atomic<HazardRecord*> head{nullptr};
+    std::atomic<size_t> recordCount{0};
+
+    std::mutex retireLock;
+    vector<Retired> retired;
+
+    static constexpr size_t kRetireThreshold = 64;
+
+    HazardDomain() = default;
+
+public:
+    HazardDomain(const HazardDomain&) = delete;
+    HazardDomain& operator=(const HazardDomain&) = delete;
+
+    ~HazardDomain() {
+        // no thread is left to read
+        for (auto& r : retired)
+            r.destroy(r.ptr);
+
+        for (auto rec = head.load(); rec != nullptr;) {
+            auto next = rec->next;
+            char* storage = rec->storage;
+            rec->~HazardRecord();
+            delete[] storage;
+            rec = next;
+        }
+    }
+
+    static HazardDomain& instance() {
+        static HazardDomain domain;
+        return domain;
+    }
+
+    HazardRecord* acquireRecord() {
+        for (auto rec = head.load(std::memory_order_acquire); rec != nullptr;
+             rec = rec->next) {
+            bool idle = false;
+            if (!rec->active.load(std::memory_order_relaxed) &&
+                rec->active.compare_exchange_strong(idle, true,
+                                                    std::memory_order_acquire))
+                return rec;
+        }
+
+        // operator new does not know the alignment before C++17
+        char* storage = new char[sizeof(HazardRecord) + kCacheLineSize];
+        const size_t addr = reinterpret_cast<size_t>(storage);
+        auto rec = ::new (static_cast<void*>(
+            storage + (kCacheLineSize - addr % kCacheLineSize)))
+            HazardRecord(storage);
+        rec->next = head.load(std::memory_order_relaxed);
+        while (!head.compare_exchange_weak(rec->next, rec,
+                                           std::memory_order_release,
+                                           std::memory_order_relaxed)) {
+        }
+        recordCount.fetch_add(1, std::memory_order_relaxed);
+        return rec;
+    }
+
+    void releaseRecord(HazardRecord* rec) noexcept {
+        rec->ptr.store(nullptr, std::memory_order_release);
+        rec->active.store(false, std::memory_order_release);
+    }
+
+    // free ptr by destroy once no record announces it
+    void retire(void* ptr, void (*destroy)(void*)) {
+        vector<Retired> doomed;
+        {
+            std::lock_guard<std::mutex> lock(retireLock);
+            retired.push_back(Retired{ptr, destroy});
+            if (retired.size() >=
+                kRetireThreshold +
+                    2 * recordCount.load(std::memory_order_relaxed))
+                doomed = takeUnprotected();
+        }
+
+        // outside the lock, a destructor may retire again
+        for (auto& r : doomed)
+            r.destroy(r.ptr);
+    }
+
+    // free every retired pointer no record announces, below the threshold
+    void reclaim() {
+        vector<Retired> doomed;
+        {
+            std::lock_guard<std::mutex> lock(retireLock);
+            doomed = takeUnprotected();
+        }
+
+        for (auto& r : doomed)
+            r.destroy(r.ptr);
+    }
+
+private:
+    // take out the retired pointers nobody announces
+    vector<Retired> takeUnprotected() {
+        vector<const void*> hazards;
+        for (auto rec = head.load(std::memory_order_acquire); rec != nullptr;
+             rec = rec->next) {
+            const void* p = rec->ptr.load(std::memory_order_seq_cst);
+            if (p != nullptr)
+                hazards.push_back(p);
+        }
+        tiny_stl::sort(hazards.begin(), hazards.end());
+
+        vector<Retired> doomed;
+        size_t kept = 0;
+        for (size_t i = 0; i < retired.size(); ++i) {
+            if (tiny_stl::binary_search(hazards.begin(), hazards.end(),
+                                        retired[i].ptr))
+                retired[kept++] = retired[i];
+            else
+                doomed.push_back(retired[i]);
+        }
+        retired.erase(retired.begin() + kept, retired.end());
+        return doomed;
+    }
+};
+
+// the record of this thread, a nested reader borrows another one
+class HazardThreadRecord {
+private:
+    HazardRecord* rec;
+    bool busy = false;
+
+    HazardThreadRecord() : rec(HazardDomain::instance().acquireRecord()) {
+    }
+
+public:
+    ~HazardThreadRecord() {
+        HazardDomain::instance().releaseRecord(rec);
+    }
+
+    static HazardThreadRecord& local() {
+        static thread_local HazardThreadRecord record;
+        return record;
+    }
+
+    HazardRecord* acquire() {
+        if (busy)
+            return HazardDomain::instance().acquireRecord();
+
+        busy = true;
+        return rec;
+    }
+
+    void release(HazardRecord* r) noexcept {
+        if (r != rec) {
+            HazardDomain::instance().releaseRecord(r);
+            return;
+        }
+
+        rec->ptr.store(nullptr, std::memory_order_release);
+        busy = false;
+    }
+};
+
+template <typename T>
+class atomic_shared_ptr {
+private:
+    struct Entry {
+        shared_ptr<T> value;
+    };
+
+    // nullptr is the empty shared_ptr, storing it allocates nothing
+    std::atomic<Entry*> slot{nullptr};
+
+public:
+    using value_type = shared_ptr<T>;
+
+    // a protected Entry, valid until the guard goes away
+    class read_guard {
+    private:
+        HazardRecord* rec;
+        Entry* entry;
+
+        friend class atomic_shared_ptr;
+
+        read_guard(HazardRecord* r, Entry* e) noexcept : rec(r), entry(e) {
+        }
+
+    public:
+        read_guard(read_guard&& rhs) noexcept
+            : rec(rhs.rec), entry(rhs.entry) {
+            rhs.rec = nullptr;
+            rhs.entry = nullptr;
+        }
+
+        read_guard(const read_guard&) = delete;
+        read_guard& operator=(const read_guard&) = delete;
+
+        ~read_guard() {
+            if (rec != nullptr)
+                HazardThreadRecord::local().release(rec);
+        }
+
+        const shared_ptr<T>& get() const noexcept {
+            static const shared_ptr<T> empty;
+            return entry ? entry->value : empty;
+        }
+
+        T* operator->() const noexcept {
+            return get().get();
+        }
+
+        T& operator*() const noexcept {
+            return *get();
+        }
+
+        explicit operator bool() const noexcept {
+            return static_cast<bool>(get());
+        }
+    };
+
+    atomic_shared_ptr() noexcept {
+        // the domain outlives every static atomic_shared_ptr
+        HazardDomain::instance();
+    }
+
+    atomic_shared_ptr(shared_ptr<T> desired) : atomic_shared_ptr() {
+        slot.store(makeEntry(tiny_stl::move(desired)),
+                   std::memory_order_relaxed);
+    }
+
+    atomic_shared_ptr(const atomic_shared_ptr&) = delete;
+    atomic_shared_ptr& operator=(const atomic_shared_ptr&) = delete;
+
+    // the Entries this slot retired hold their values until a scan, free
+    // them now rather than at the next batch, which may never come
+    ~atomic_shared_ptr() {
+        delete slot.load(std::memory_order_relaxed);
+        HazardDomain::instance().reclaim();
+    }
+
+    bool is_lock_free() const noexcept {
+        return slot.is_lock_free();
+    }
+
+    shared_ptr<T> load() const {
+        auto& local = HazardThreadRecord::local();
+        HazardRecord* rec = local.acquire();
+        Entry* e = protect(rec);
+        shared_ptr<T> result = e ? e->value : shared_ptr<T>{};
+        local.release(rec);
+        return result;
+    }
+
+    operator shared_ptr<T>() const {
+        return load();
+    }
+
+    read_guard read() const {
+        HazardRecord* rec = HazardThreadRecord::local().acquire();
+        return read_guard(rec, protect(rec));
+    }
+
+    void store(shared_ptr<T> desired) {
+        retire(slot.exchange(makeEntry(tiny_stl::move(desired))));
+    }
+
+    atomic_shared_ptr& operator=(shared_ptr<T> desired) {
+        store(tiny_stl::move(desired));
+        return *this;
+    }
+
+    shared_ptr<T> exchange(shared_ptr<T> desired) {
+        Entry* old = slot.exchange(makeEntry(tiny_stl::move(desired)));
+        shared_ptr<T> result;
+        if (old != nullptr) {
+            // readers may still be copying old->value, copy it too and
+            // free old later
+            result = old->value;
+            retire(old);
+        }
+        return result;
+    }
+
+    // succeeds if the slot holds the same pointer and control block as
+    // expected, otherwise expected becomes the current value
+    bool compare_exchange_strong(shared_ptr<T>& expected,
+                                 shared_ptr<T> desired) {
+        Entry* neo = makeEntry(tiny_stl::move(desired));
+        read_guard guard = read();
+        for (;;) {
+            if (!sameOwner(guard.get(), expected)) {
+                expected = guard.get();
+                delete neo;
+                return false;
+            }
+
+            Entry* cur = guard.entry;
+            if (slot.compare_exchange_strong(cur, neo)) {
+                retire(guard.entry);
+                return true;
+            }
+
+            // another Entry with maybe the same value, look again
+            guard.entry = protect(guard.rec);
+        }
+    }
+
+    bool compare_exchange_weak(shared_ptr<T>& expected,
+                               shared_ptr<T> desired) {
+        return compare_exchange_strong(expected, tiny_stl::move(desired));
+    }
+
+private:
+    static Entry* makeEntry(shared_ptr<T>&& value) {
+        if (value.mPtr == nullptr && value.mRep == nullptr)
+            return nullptr;
+
+        return new Entry{tiny_stl::move(value)};
+    }
+
+    static bool sameOwner(const shared_ptr<T>& lhs,
+                          const shared_ptr<T>& rhs) noexcept {
+        return lhs.mPtr == rhs.mPtr && lhs.mRep == rhs.mRep;
+    }
+
+    static void destroyEntry(void* p) {
+        delete static_cast<Entry*>(p);
+    }
+
+    static void retire(Entry* e) {
+        if (e != nullptr)
+            HazardDomain::instance().retire(e, &destroyEntry);
+    }
+
+    // announce the Entry in rec, then check it is still the current one
+    Entry* protect(HazardRecord* rec) const noexcept {
+        Entry* p = slot.load(std::memory_order_acquire);
+        for (;;) {
+            rec->ptr.store(p, std::memory_order_seq_cst);
+            Entry* q = slot.load(std::memory_order_seq_cst);
+            if (q == p)
+                return p;
+            p = q;
+        }
+    }
+};
+
+} // namespace tiny_stl
@@ -0,0 +1,1152 @@
+// Copyright (C) 2021 syn1w
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+// Microbenchmarks of tiny_stl side by side with std::
+//
+// Each case runs --warmup untimed repetitions, then --reps timed ones, and
+// reports the time per operation as min / p50 / p90 / p99 / max over the
+// repetitions. The summary lists std p50 / tiny_stl p50 for every case run
+// by both. --json writes every repetition statistic, two files from before
+// and after a change can be diffed to catch regressions.
+//
+//   bench [--filter text] [--reps n] [--warmup n] [--scale x]
+//         [--max-threads n] [--json file]
+//
+// --filter runs the cases whose "group impl" contains text, --scale
+// multiplies the element counts, the concurrent cases sweep 1, 2, 4, ...
+// up to --max-threads threads.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <forward_list>
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <random>
+#include <set>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "algorithm.hpp"
+#include "atomic_shared_ptr.hpp"
+#include "btree_map.hpp"
+#include "btree_set.hpp"
+#include "concurrent_queue.hpp"
+#include "concurrent_unordered_map.hpp"
+#include "deque.hpp"
+#include "flat_map.hpp"
+#include "forward_list.hpp"
+#include "list.hpp"
+#include "map.hpp"
+#include "memory.hpp"
+#include "queue.hpp"
+#include "set.hpp"
+#include "snapshot.hpp"
+#include "string.hpp"
+#include "unordered_map.hpp"
+#include "vector.hpp"
+
+namespace {
+
+struct Options {
+    const char* filter = "";
+    int reps = 15;
+    int warmup = 3;
+    double scale = 1.0;
+    int maxThreads = 64;
+    const char* json = nullptr;
+};
+
+Options gOptions;
+
+// results go here so the compiler cannot drop the work
+volatile size_t gSink;
+
+template <typename T>
+inline void sink(const T& val) {
+    gSink = gSink + static_cast<size_t>(val);
+}
+
+class Stopwatch {
+private:
+    using Clock = std::chrono::steady_clock;
+
+    Clock::time_point begin = Clock::now();
+    double elapsed = -1.0;
+
+public:
+    // leave out what the body did so far, e.g. building its input
+    void restart() {
+        elapsed = -1.0;
+        begin = Clock::now();
+    }
+
+    void stop() {
+        if (elapsed < 0.0)
+            elapsed = std::chrono::duration<double, std::nano>(Clock::now() -
+                                                               begin)
+                          .count();
+    }
+
+    double ns() {
+        stop();
+        return elapsed;
+    }
+};
+
+struct Result {
+    std::string group; // what is measured, e.g. "map/insert"
+    std::string impl;  // "tiny_stl", "std" or a tiny_stl variant
+    size_t n;
+    int threads;
+    std::vector<double> nsPerOp; // one per repetition, sorted
+    double mean;
+};
+
+std::vector<Result> gResults;
+
+// a repetition: build the input, restart the stopwatch, do the work and
+// return the number of operations
+using Body = std::function<size_t(Stopwatch&)>;
+
+double percentile(const std::vector<double>& sorted, double p) {
+    const double rank = p * static_cast<double>(sorted.size() - 1);
+    const size_t lo = static_cast<size_t>(rank);
+    const size_t hi = std::min(lo + 1, sorted.size() - 1);
+    return sorted[lo] + (sorted[hi] - sorted[lo]) * (rank - lo);
+}
+
+void run(const std::string& group, const std::string& impl, size_t n,
+         int threads, const Body& body) {
+    const std::string name = group + " " + impl;
+    if (std::strstr(name.c_str(), gOptions.filter) == nullptr)
+        return;
+
+    for (int i = 0; i < gOptions.warmup; ++i) {
+        Stopwatch sw;
+        body(sw);
+    }
+
+    Result r{group, impl, n, threads, {}, 0.0};
+    for (int i = 0; i < gOptions.reps; ++i) {
+        Stopwatch sw;
+        const size_t ops = body(sw);
+        r.nsPerOp.push_back(sw.ns() / static_cast<double>(std::max<size_t>(
+                                          ops, 1)));
+    }
+    std::sort(r.nsPerOp.begin(), r.nsPerOp.end());
+    for (double v : r.nsPerOp)
+        r.mean += v;
+    r.mean /= static_cast<double>(r.nsPerOp.size());
+
+    std::printf("%-30s %-16s %9zu %3d  %10.2f %10.2f %10.2f ns/op\n",
+                group.c_str(), impl.c_str(), n, threads, r.nsPerOp.front(),
+                percentile(r.nsPerOp, 0.5), percentile(r.nsPerOp, 0.9));
+    std::fflush(stdout);
+    gResults.push_back(std::move(r));
+}
+
+void run(const std::string& group, const std::string& impl, size_t n,
+         const Body& body) {
+    run(group, impl, n, 1, body);
+}
+
+size_t scaled(size_t n) {
+    return std::max<size_t>(
+        1, static_cast<size_t>(static_cast<double>(n) * gOptions.scale));
+}
+
+std::vector<int> randomInts(size_t n, int range = 0) {
+    std::mt19937 gen(static_cast<unsigned>(n) * 31u + 7u);
+    std::vector<int> v(n);
+    for (auto& x : v)
+        x = range > 0 ? static_cast<int>(gen() % range)
+                      : static_cast<int>(gen() >> 1);
+    return v;
+}
+
+std::vector<std::string> randomKeys(size_t n, size_t len) {
+    std::mt19937 gen(static_cast<unsigned>(n + len));
+    std::vector<std::string> v(n);
+    for (auto& s : v) {
+        s.resize(len);
+        for (auto& c : s)
+            c = static_cast<char>('a' + gen() % 26);
+    }
+    return v;
+}
+
+// fn(i) on each of threads threads, the stopwatch runs from all threads
+// being ready to all of them being done
+template <typename Fn>
+void runThreads(int threads, Stopwatch& sw, Fn fn) {
+    std::atomic<int> ready{0};
+    std::atomic<bool> go{false};
+    std::vector<std::thread> pool;
+    for (int i = 0; i < threads; ++i) {
+        pool.emplace_back([&, i] {
+            ready.fetch_add(1);
+            while (!go.load(std::memory_order_acquire))
+                std::this_thread::yield();
+            fn(i);
+        });
+    }
+
+    while (ready.load() != threads)
+        std::this_thread::yield();
+    sw.restart();
+    go.store(true, std::memory_order_release);
+    for (auto& t : pool)
+        t.join();
+    sw.stop();
+}
+
+std::vector<int> threadCounts() {
+    std::vector<int> counts;
+    for (int t = 1; t <= gOptions.maxThreads; t *= 2)
+        counts.push_back(t);
+    return counts;
+}
+
+// containers
+
+template <typename Vec>
+size_t vectorPushBack(Stopwatch& sw, const std::vector<int>& in) {
+    sw.restart();
+    Vec v;
+    for (int x : in)
+        v.push_back(x);
+    sink(v.back());
+    return in.size();
+}
+
+template <typename Vec, typename Str>
+size_t vectorPushBackString(Stopwatch& sw,
+                            const std::vector<std::string>& in) {
+    std::vector<Str> strs;
+    for (const auto& s : in)
+        strs.emplace_back(s.data(), s.size());
+    sw.restart();
+    Vec v;
+    for (auto& s : strs)
+        v.push_back(s);
+    sink(v.back().size());
+    return in.size();
+}
+
+void benchVector() {
+    const size_t n = scaled(1 << 20);
+    const auto ints = randomInts(n);
+    run("vector/push_back int", "tiny_stl", n, [&](Stopwatch& sw) {
+        return vectorPushBack<tiny_stl::vector<int>>(sw, ints);
+    });
+    run("vector/push_back int", "std", n, [&](Stopwatch& sw) {
+        return vectorPushBack<std::vector<int>>(sw, ints);
+    });
+
+    const size_t ns = scaled(1 << 17);
+    const auto keys = randomKeys(ns, 24);
+    run("vector/push_back string", "tiny_stl", ns, [&](Stopwatch& sw) {
+        return vectorPushBackString<tiny_stl::vector<tiny_stl::string>,
+                                    tiny_stl::string>(sw, keys);
+    });
+    run("vector/push_back string", "std", ns, [&](Stopwatch& sw) {
+        return vectorPushBackString<std::vector<std::string>, std::string>(
+            sw, keys);
+    });
+
+    const tiny_stl::vector<int> tv(ints.data(), ints.data() + n);
+    run("vector/copy int", "tiny_stl", n, [&](Stopwatch& sw) {
+        sw.restart();
+        tiny_stl::vector<int> c(tv);
+        sink(c[n / 2]);
+        return n;
+    });
+    run("vector/copy int", "std", n, [&](Stopwatch& sw) {
+        sw.restart();
+        std::vector<int> c(ints);
+        sink(c[n / 2]);
+        return n;
+    });
+
+    const size_t nb = scaled(1 << 24);
+    tiny_stl::vector<bool> tb(nb);
+    std::vector<bool> sb(nb);
+    for (size_t i = 0; i < nb; i += 3) {
+        tb[i] = true;
+        sb[i] = true;
+    }
+    run("vector<bool>/count", "tiny_stl", nb, [&](Stopwatch& sw) {
+        sw.restart();
+        sink(tiny_stl::count(tb.begin(), tb.end(), true));
+        return nb;
+    });
+    run("vector<bool>/count", "std", nb, [&](Stopwatch& sw) {
+        sw.restart();
+        sink(std::count(sb.begin(), sb.end(), true));
+        return nb;
+    });
+}
+
+template <typename Deque>
+size_t dequePushPop(Stopwatch& sw, size_t n) {
+    sw.restart();
+    Deque d;
+    for (size_t i = 0; i < n; ++i)
+        d.push_back(static_cast<int>(i));
+    size_t sum = 0;
+    while (!d.empty()) {
+        sum += d.front();
+        d.pop_front();
+    }
+    sink(sum);
+    return 2 * n;
+}
+
+// a queue that stays short: push two, pop one
+template <typename Deque>
+size_t dequeSliding(Stopwatch& sw, size_t n) {
+    sw.restart();
+    Deque d;
+    size_t sum = 0;
+    for (size_t i = 0; i < n; ++i) {
+        d.push_back(static_cast<int>(i));
+        if (i % 2 == 1) {
+            sum += d.front();
+            d.pop_front();
+        }
+        if (d.size() > 64) {
+            d.pop_front();
+            d.pop_front();
+        }
+    }
+    sink(sum);
+    return n;
+}
+
+template <typename Deque>
+size_t dequePushFront(Stopwatch& sw, size_t n) {
+    sw.restart();
+    Deque d;
+    for (size_t i = 0; i < n; ++i)
+        d.push_front(static_cast<int>(i));
+    sink(d.front());
+    return n;
+}
+
+void benchDeque() {
+    const size_t n = scaled(1 << 20);
+    run("deque/push_back+pop_front", "tiny_stl", n, [&](Stopwatch& sw) {
+        return dequePushPop<tiny_stl::deque<int>>(sw, n);
+    });
+    run("deque/push_back+pop_front", "std", n, [&](Stopwatch& sw) {
+        return dequePushPop<std::deque<int>>(sw, n);
+    });
+    run("deque/sliding window", "tiny_stl", n, [&](Stopwatch& sw) {
+        return dequeSliding<tiny_stl::deque<int>>(sw, n);
+    });
+    run("deque/sliding window", "std", n, [&](Stopwatch& sw) {
+        return dequeSliding<std::deque<int>>(sw, n);
+    });
+    run("deque/push_front", "tiny_stl", n, [&](Stopwatch& sw) {
+        return dequePushFront<tiny_stl::deque<int>>(sw, n);
+    });
+    run("deque/push_front", "std", n, [&](Stopwatch& sw) {
+        return dequePushFront<std::deque<int>>(sw, n);
+    });
+}
+
+template <typename List>
+size_t listSort(Stopwatch& sw, const std::vector<int>& in) {
+    List l(in.data(), in.data() + in.size());
+    sw.restart();
+    l.sort();
+    sw.stop();
+    sink(l.front());
+    return in.size();
+}
+
+void benchList() {
+    const size_t n = scaled(1 << 20);
+    const auto random = randomInts(n);
+    auto sorted = random;
+    std::sort(sorted.begin(), sorted.end());
+    auto nearly = sorted;
+    std::mt19937 gen(1);
+    for (size_t i = 0; i < n / 100; ++i)
+        std::swap(nearly[gen() % n], nearly[gen() % n]);
+
+    const std::pair<const char*, const std::vector<int>*> inputs[] = {
+        {"random", &random}, {"sorted", &sorted}, {"nearly sorted", &nearly}};
+    for (const auto& in : inputs) {
+        const std::string group = std::string("list/sort ") + in.first;
+        run(group, "tiny_stl", n, [&](Stopwatch& sw) {
+            return listSort<tiny_stl::list<int>>(sw, *in.second);
+        });
+        run(group, "std", n, [&](Stopwatch& sw) {
+            return listSort<std::list<int>>(sw, *in.second);
+        });
+    }
+
+    run("forward_list/sort random", "tiny_stl", n, [&](Stopwatch& sw) {
+        return listSort<tiny_stl::forward_list<int>>(sw, random);
+    });
+    run("forward_list/sort random", "std", n, [&](Stopwatch& sw) {
+        return listSort<std::forward_list<int>>(sw, random);
+    });
+}
+
+template <typename Map>
+size_t mapInsert(Stopwatch& sw, const std::vector<int>& keys) {
+    sw.restart();
+    Map m;
+    for (int k : keys)
+        m.insert({k, k});
+    sink(m.size());
+    return keys.size();
+}
+
+template <typename Map>
+size_t mapFind(Stopwatch& sw, const Map& m, const std::vector<int>& keys) {
+    sw.restart();
+    size_t hits = 0;
+    for (int k : keys)
+        hits += m.find(k) != m.end();
+    sink(hits);
+    return keys.size();
+}
+
+template <typename Map>
+size_t mapIterate(Stopwatch& sw, const Map& m) {
+    sw.restart();
+    size_t sum = 0;
+    for (const auto& kv : m)
+        sum += kv.second;
+    sink(sum);
+    return m.size();
+}
+
+// random int keys, erase removes all of them in another order
+template <typename Set>
+void benchSetImpl(const char* impl, const std::vector<int>& keys,
+                  const std::vector<int>& lookups) {
+    const size_t n = keys.size();
+    run("set/insert", impl, n, [&](Stopwatch& sw) {
+        sw.restart();
+        Set s;
+        for (int k : keys)
+            s.insert(k);
+        sink(s.size());
+        return n;
+    });
+
+    Set s;
+    for (int k : keys)
+        s.insert(k);
+    run("set/find", impl, n, [&](Stopwatch& sw) {
+        sw.restart();
+        size_t hits = 0;
+        for (int k : lookups)
+            hits += s.find(k) != s.end();
+        sink(hits);
+        return n;
+    });
+    run("set/iterate", impl, n, [&](Stopwatch& sw) {
+        sw.restart();
+        size_t sum = 0;
+        for (int k : s)
+            sum += static_cast<size_t>(k);
+        sink(sum);
+        return n;
+    });
+    run("set/erase", impl, n, [&](Stopwatch& sw) {
+        Set e;
+        for (int k : keys)
+            e.insert(k);
+        sw.restart();
+        for (int k : lookups)
+            e.erase(k);
+        sink(e.size());
+        return n;
+    });
+}
+
+void benchMap() {
+    const size_t n = scaled(1 << 18);
+    const auto keys = randomInts(n);
+    auto lookups = keys;
+    std::shuffle(lookups.begin(), lookups.end(), std::mt19937(2));
+
+    using TinyMap = tiny_stl::map<int, int>;
+    using BTreeMap = tiny_stl::btree_map<int, int>;
+    using FlatMap = tiny_stl::flat_map<int, int>;
+    using StdMap = std::map<int, int>;
+
+    run("map/insert", "tiny_stl", n, [&](Stopwatch& sw) {
+        return mapInsert<TinyMap>(sw, keys);
+    });
+    run("map/insert", "btree_map", n, [&](Stopwatch& sw) {
+        return mapInsert<BTreeMap>(sw, keys);
+    });
+    run("map/insert", "std", n, [&](Stopwatch& sw) {
+        return mapInsert<StdMap>(sw, keys);
+    });
+
+    TinyMap tm;
+    BTreeMap bm;
+    StdMap sm;
+    tiny_stl::vector<tiny_stl::pair<int, int>> pairs;
+    for (int k : keys) {
+        tm.insert({k, k});
+        bm.insert({k, k});
+        sm.insert({k, k});
+        pairs.push_back(tiny_stl::make_pair(k, k));
+    }
+    const FlatMap fm(pairs.begin(), pairs.end());
+
+    run("map/find", "tiny_stl", n,
+        [&](Stopwatch& sw) { return mapFind(sw, tm, lookups); });
+    run("map/find", "btree_map", n,
+        [&](Stopwatch& sw) { return mapFind(sw, bm, lookups); });
+    run("map/find", "flat_map", n,
+        [&](Stopwatch& sw) { return mapFind(sw, fm, lookups); });
+    run("map/find", "std", n,
+        [&](Stopwatch& sw) { return mapFind(sw, sm, lookups); });
+
+    run("map/iterate", "tiny_stl", n,
+        [&](Stopwatch& sw) { return mapIterate(sw, tm); });
+    run("map/iterate", "btree_map", n,
+        [&](Stopwatch& sw) { return mapIterate(sw, bm); });
+    run("map/iterate", "std", n,
+        [&](Stopwatch& sw) { return mapIterate(sw, sm); });
+
+    benchSetImpl<tiny_stl::set<int>>("tiny_stl", keys, lookups);
+    benchSetImpl<tiny_stl::btree_set<int>>("btree_set", keys, lookups);
+    benchSetImpl<std::set<int>>("std", keys, lookups);
+}
+
+template <typename Map>
+size_t hashRehash(Stopwatch& sw, const std::vector<int>& keys) {
+    Map m;
+    for (int k : keys)
+        m.insert({k, k});
+    sw.restart();
+    m.rehash(m.bucket_count() * 4);
+    sw.stop();
+    sink(m.bucket_count());
+    return keys.size();
+}
+
+template <typename Map>
+void benchHashMapImpl(const char* impl, const std::vector<int>& keys,
+                      const std::vector<int>& lookups,
+                      const std::vector<int>& misses) {
+    const size_t n = keys.size();
+    run("unordered_map/insert", impl, n,
+        [&](Stopwatch& sw) { return mapInsert<Map>(sw, keys); });
+    run("unordered_map/insert reserved", impl, n, [&](Stopwatch& sw) {
+        Map m;
+        m.reserve(n);
+        sw.restart();
+        for (int k : keys)
+            m.insert({k, k});
+        sink(m.size());
+        return n;
+    });
+    run("unordered_map/rehash", impl, n,
+        [&](Stopwatch& sw) { return hashRehash<Map>(sw, keys); });
+
+    Map m;
+    for (int k : keys)
+        m.insert({k, k});
+    run("unordered_map/find hit", impl, n,
+        [&](Stopwatch& sw) { return mapFind(sw, m, lookups); });
+    run("unordered_map/find miss", impl, n,
+        [&](Stopwatch& sw) { return mapFind(sw, m, misses); });
+    run("unordered_map/erase", impl, n, [&](Stopwatch& sw) {
+        Map c = m;
+        sw.restart();
+        for (int k : lookups)
+            c.erase(k);
+        sink(c.size());
+        return n;
+    });
+}
+
+void benchHashMap() {
+    const size_t n = scaled(1 << 18);
+    const auto keys = randomInts(n);
+    auto lookups = keys;
+    std::shuffle(lookups.begin(), lookups.end(), std::mt19937(3));
+    std::vector<int> misses(n);
+    for (size_t i = 0; i < n; ++i)
+        misses[i] = -1 - static_cast<int>(i); // randomInts are >= 0
+
+    using Chained = tiny_stl::unordered_map<int, int>;
+    using Flat = tiny_stl::unordered_map<
+        int, int, tiny_stl::hash<int>, tiny_stl::equal_to<int>,
+        tiny_stl::allocator<tiny_stl::pair<int, int>>,
+        tiny_stl::flat_hashing<>>;
+    benchHashMapImpl<Chained>("tiny_stl", keys, lookups, misses);
+    benchHashMapImpl<Flat>("flat_hashing", keys, lookups, misses);
+    benchHashMapImpl<std::unordered_map<int, int>>("std", keys, lookups,
+                                                   misses);
+
+    // string keys hash and compare bytes
+    const auto strKeys = randomKeys(n / 2, 20);
+    tiny_stl::unordered_map<tiny_stl::string, int> tsm;
+    std::unordered_map<std::string, int> ssm;
+    std::vector<tiny_stl::string> tinyKeys;
+    for (const auto& k : strKeys) {
+        tinyKeys.emplace_back(k.data(), k.size());
+        tsm.insert({tinyKeys.back(), 1});
+        ssm.insert({k, 1});
+    }
+    run("unordered_map/find string", "tiny_stl", strKeys.size(),
+        [&](Stopwatch& sw) {
+            sw.restart();
+            size_t hits = 0;
+            for (const auto& k : tinyKeys)
+                hits += tsm.find(k) != tsm.end();
+            sink(hits);
+            return tinyKeys.size();
+        });
+    run("unordered_map/find string", "std", strKeys.size(),
+        [&](Stopwatch& sw) {
+            sw.restart();
+            size_t hits = 0;
+            for (const auto& k : strKeys)
+                hits += ssm.find(k) != ssm.end();
+            sink(hits);
+            return strKeys.size();
+        });
+}
+
+template <typename Str>
+size_t stringConstruct(Stopwatch& sw, const std::vector<std::string>& in) {
+    sw.restart();
+    size_t sum = 0;
+    for (const auto& s : in) {
+        Str str(s.data(), s.size());
+        sum += static_cast<unsigned char>(str[str.size() / 2]);
+    }
+    sink(sum);
+    return in.size();
+}
+
+// building the table at startup against mapping a snapshot of it, the
+// load is per key, the mapped pages are faulted in by the lookups
+void benchSnapshot() {
+    const size_t n = scaled(1 << 18);
+    const auto keys = randomInts(n);
+    auto lookups = keys;
+    std::shuffle(lookups.begin(), lookups.end(), std::mt19937(5));
+
+    using Flat = tiny_stl::unordered_map<
+        int, int, tiny_stl::hash<int>, tiny_stl::equal_to<int>,
+        tiny_stl::allocator<tiny_stl::pair<int, int>>,
+        tiny_stl::flat_hashing<>>;
+    Flat m;
+    for (int k : keys)
+        m.insert({k, k});
+    const char* path = "tiny_stl_bench.snapshot";
+    tiny_stl::write_snapshot(path, m);
+
+    run("snapshot/load", "flat_hashing", n, [&](Stopwatch& sw) {
+        sw.restart();
+        Flat c;
+        for (int k : keys)
+            c.insert({k, k});
+        sink(c.size());
+        return n;
+    });
+    run("snapshot/load", "mapped", n, [&](Stopwatch& sw) {
+        sw.restart();
+        tiny_stl::mapped_unordered_map<int, int> c(path);
+        sink(c.size());
+        return n;
+    });
+
+    tiny_stl::mapped_unordered_map<int, int> mm(path);
+    run("snapshot/find hit", "flat_hashing", n,
+        [&](Stopwatch& sw) { return mapFind(sw, m, lookups); });
+    run("snapshot/find hit", "mapped", n,
+        [&](Stopwatch& sw) { return mapFind(sw, mm, lookups); });
+    std::remove(path);
+}
+
+void benchString() {
+    const size_t n = scaled(1 << 18);
+    for (size_t len : {7u, 15u, 22u, 40u}) {
+        const auto in = randomKeys(n, len);
+        const std::string group =
+            "string/construct " + std::to_string(len) + " chars";
+        run(group, "tiny_stl", n, [&](Stopwatch& sw) {
+            return stringConstruct<tiny_stl::string>(sw, in);
+        });
+        run(group, "std", n, [&](Stopwatch& sw) {
+            return stringConstruct<std::string>(sw, in);
+        });
+    }
+
+    // text of 4 MB, the needle is at the end
+    const size_t len = scaled(1 << 22);
+    std::string text = randomKeys(1, len)[0];
+    text.replace(len - 16, 16, "needle@haystack!");
+    const tiny_stl::string ttext(text.data(), text.size());
+
+    run("string/find char", "tiny_stl", len, [&](Stopwatch& sw) {
+        sw.restart();
+        sink(ttext.find('@'));
+        return len;
+    });
+    run("string/find char", "std", len, [&](Stopwatch& sw) {
+        sw.restart();
+        sink(text.find('@'));
+        return len;
+    });
+    run("string/find substring", "tiny_stl", len, [&](Stopwatch& sw) {
+        sw.restart();
+        sink(ttext.find("needle@hay"));
+        return len;
+    });
+    run("string/find substring", "std", len, [&](Stopwatch& sw) {
+        sw.restart();
+        sink(text.find("needle@hay"));
+        return len;
+    });
+    run("string/rfind char", "tiny_stl", len, [&](Stopwatch& sw) {
+        sw.restart();
+        sink(ttext.rfind('#'));
+        return len;
+    });
+    run("string/rfind char", "std", len, [&](Stopwatch& sw) {
+        sw.restart();
+        sink(text.rfind('#'));
+        return len;
+    });
+    run("string/find_first_of", "tiny_stl", len, [&](Stopwatch& sw) {
+        sw.restart();
+        sink(ttext.find_first_of("@#!"));
+        return len;
+    });
+    run("string/find_first_of", "std", len, [&](Stopwatch& sw) {
+        sw.restart();
+        sink(text.find_first_of("@#!"));
+        return len;
+    });
+}
+
+// algorithms and adaptors
+
+void benchSort() {
+    const size_t n = scaled(1 << 20);
+    const auto random = randomInts(n);
+    auto sorted = random;
+    std::sort(sorted.begin(), sorted.end());
+    std::vector<int> reversed(sorted.rbegin(), sorted.rend());
+    const auto few = randomInts(n, 16);
+
+    const std::pair<const char*, const std::vector<int>*> inputs[] = {
+        {"random", &random},
+        {"sorted", &sorted},
+        {"reversed", &reversed},
+        {"few distinct", &few}};
+    for (const auto& in : inputs) {
+        const std::string group = std::string("sort/") + in.first;
+        run(group, "tiny_stl", n, [&](Stopwatch& sw) {
+            tiny_stl::vector<int> v(in.second->data(),
+                                    in.second->data() + n);
+            sw.restart();
+            tiny_stl::sort(v.begin(), v.end());
+            sw.stop();
+            sink(v[n / 2]);
+            return n;
+        });
+        run(group, "std", n, [&](Stopwatch& sw) {
+            std::vector<int> v(*in.second);
+            sw.restart();
+            std::sort(v.begin(), v.end());
+            sw.stop();
+            sink(v[n / 2]);
+            return n;
+        });
+    }
+}
+
+template <typename PQ>
+size_t heapPushPop(Stopwatch& sw, const std::vector<int>& in) {
+    sw.restart();
+    PQ pq;
+    for (int x : in)
+        pq.push(x);
+    size_t sum = 0;
+    while (!pq.empty()) {
+        sum += pq.top();
+        pq.pop();
+    }
+    sink(sum);
+    return 2 * in.size();
+}
+
+void benchHeap() {
+    const size_t n = scaled(1 << 18);
+    const auto in = randomInts(n);
+    using Binary = tiny_stl::priority_queue<int>;
+    using Dary = tiny_stl::priority_queue<int, tiny_stl::vector<int>,
+                                          tiny_stl::less<int>,
+                                          tiny_stl::dary_heap<4>>;
+    run("priority_queue/push+pop", "tiny_stl", n,
+        [&](Stopwatch& sw) { return heapPushPop<Binary>(sw, in); });
+    run("priority_queue/push+pop", "dary_heap<4>", n,
+        [&](Stopwatch& sw) { return heapPushPop<Dary>(sw, in); });
+    run("priority_queue/push+pop", "std", n, [&](Stopwatch& sw) {
+        return heapPushPop<std::priority_queue<int>>(sw, in);
+    });
+}
+
+template <typename Ptr>
+size_t pointerCopy(Stopwatch& sw, const Ptr& p, size_t n) {
+    sw.restart();
+    size_t sum = 0;
+    for (size_t i = 0; i < n; ++i) {
+        Ptr copy = p;
+        sum += *copy;
+    }
+    sink(sum);
+    return n;
+}
+
+void benchSharedPtr() {
+    const size_t n = scaled(1 << 22);
+    const auto tp = tiny_stl::make_shared<int>(1);
+    const auto lp = tiny_stl::make_local_shared<int>(1);
+    const auto sp = std::make_shared<int>(1);
+    run("shared_ptr/copy", "tiny_stl", n,
+        [&](Stopwatch& sw) { return pointerCopy(sw, tp, n); });
+    run("shared_ptr/copy", "local_shared_ptr", n,
+        [&](Stopwatch& sw) { return pointerCopy(sw, lp, n); });
+    run("shared_ptr/copy", "std", n,
+        [&](Stopwatch& sw) { return pointerCopy(sw, sp, n); });
+}
+
+// concurrent cases, the same total work split over the threads
+
+// producers push, consumers pop, half of the threads each, one thread
+// alternates
+template <typename Push, typename Pop>
+void producerConsumer(Stopwatch& sw, int threads, size_t items, Push push,
+                      Pop pop) {
+    if (threads == 1) {
+        runThreads(1, sw, [&](int) {
+            for (size_t i = 0; i < items; ++i) {
+                push(static_cast<int>(i));
+                int out;
+                while (!pop(out))
+                    std::this_thread::yield();
+                sink(out);
+            }
+        });
+        return;
+    }
+
+    const int producers = threads / 2;
+    std::atomic<size_t> popped{0};
+    runThreads(threads, sw, [&](int id) {
+        if (id < producers) {
+            const size_t share = items / producers +
+                                 (static_cast<size_t>(id) < items % producers);
+            for (size_t i = 0; i < share; ++i)
+                push(static_cast<int>(i));
+            return;
+        }
+
+        size_t sum = 0;
+        int out;
+        while (popped.load(std::memory_order_relaxed) < items) {
+            if (pop(out)) {
+                sum += out;
+                popped.fetch_add(1, std::memory_order_relaxed);
+            } else {
+                std::this_thread::yield();
+            }
+        }
+        sink(sum);
+    });
+}
+
+void benchQueues() {
+    const size_t items = scaled(1 << 18);
+    for (int t : threadCounts()) {
+        run("mpmc_queue/push+pop", "tiny_stl", items, t, [&](Stopwatch& sw) {
+            tiny_stl::mpmc_queue<int> q(1024);
+            producerConsumer(
+                sw, t, items,
+                [&](int v) {
+                    while (!q.try_push(v))
+                        std::this_thread::yield();
+                },
+                [&](int& out) { return q.try_pop(out); });
+            return items;
+        });
+        run("mpmc_queue/push+pop", "std", items, t, [&](Stopwatch& sw) {
+            std::mutex lock;
+            std::queue<int> q;
+            producerConsumer(
+                sw, t, items,
+                [&](int v) {
+                    std::lock_guard<std::mutex> guard(lock);
+                    q.push(v);
+                },
+                [&](int& out) {
+                    std::lock_guard<std::mutex> guard(lock);
+                    if (q.empty())
+                        return false;
+                    out = q.front();
+                    q.pop();
+                    return true;
+                });
+            return items;
+        });
+    }
+
+    if (gOptions.maxThreads < 2)
+        return;
+    run("spsc_queue/push+pop", "tiny_stl", items, 2, [&](Stopwatch& sw) {
+        tiny_stl::spsc_queue<int> q(1024);
+        producerConsumer(
+            sw, 2, items,
+            [&](int v) {
+                while (!q.try_push(v))
+                    std::this_thread::yield();
+            },
+            [&](int& out) { return q.try_pop(out); });
+        return items;
+    });
+}
+
+// 90% lookups, 10% inserts over a key range a quarter filled at start
+void benchConcurrentMap() {
+    const size_t ops = scaled(1 << 18);
+    const int range = static_cast<int>(ops);
+    const auto keys = randomInts(ops, range);
+    for (int t : threadCounts()) {
+        const size_t share = ops / t;
+        run("concurrent_map/90% find", "tiny_stl", share * t, t,
+            [&](Stopwatch& sw) {
+                tiny_stl::concurrent_unordered_map<int, int> m;
+                for (int k = 0; k < range; k += 4)
+                    m.insert({k, k});
+                runThreads(t, sw, [&](int id) {
+                    size_t hits = 0;
+                    for (size_t i = 0; i < share; ++i) {
+                        const int k = keys[id * share + i];
+                        if (i % 10 == 0)
+                            m.insert_or_assign(k, k);
+                        else
+                            hits += m.cvisit(k, [](const tiny_stl::pair<
+                                                    const int, int>&) {});
+                    }
+                    sink(hits);
+                });
+                return share * t;
+            });
+        run("concurrent_map/90% find", "std", share * t, t,
+            [&](Stopwatch& sw) {
+                std::mutex lock;
+                std::unordered_map<int, int> m;
+                for (int k = 0; k < range; k += 4)
+                    m.insert({k, k});
+                runThreads(t, sw, [&](int id) {
+                    size_t hits = 0;
+                    for (size_t i = 0; i < share; ++i) {
+                        const int k = keys[id * share + i];
+                        std::lock_guard<std::mutex> guard(lock);
+                        if (i % 10 == 0)
+                            m[k] = k;
+                        else
+                            hits += m.count(k);
+                    }
+                    sink(hits);
+                });
+                return share * t;
+            });
+    }
+}
+
+// every thread reads a shared_ptr that one in 64 reads replaces
+void benchAtomicSharedPtr() {
+    const size_t ops = scaled(1 << 18);
+    for (int t : threadCounts()) {
+        const size_t share = ops / t;
+        run("atomic_shared_ptr/read", "tiny_stl", share * t, t,
+            [&](Stopwatch& sw) {
+                tiny_stl::atomic_shared_ptr<int> slot(
+                    tiny_stl::make_shared<int>(1));
+                runThreads(t, sw, [&](int) {
+                    size_t sum = 0;
+                    for (size_t i = 0; i < share; ++i) {
+                        if (i % 64 == 0)
+                            slot.store(tiny_stl::make_shared<int>(
+                                static_cast<int>(i)));
+                        else
+                            sum += *slot.read();
+                    }
+                    sink(sum);
+                });
+                return share * t;
+            });
+        run("atomic_shared_ptr/read", "std", share * t, t,
+            [&](Stopwatch& sw) {
+                auto slot = std::make_shared<int>(1);
+                runThreads(t, sw, [&](int) {
+                    size_t sum = 0;
+                    for (size_t i = 0; i < share; ++i) {
+                        if (i % 64 == 0)
+                            std::atomic_store(&slot, std::make_shared<int>(
+                                                         static_cast<int>(i)));
+                        else
+                            sum += *std::atomic_load(&slot);
+                    }
+                    sink(sum);
+                });
+                return share * t;
+            });
+    }
+}
+
+// report
+
+void printSummary() {
+    std::printf("\n%-30s %-16s %9s %3s  %10s\n", "group", "impl", "n", "thr",
+                "std/impl");
+    for (const auto& r : gResults) {
+        if (r.impl == "std")
+            continue;
+        for (const auto& s : gResults) {
+            if (s.impl == "std" && s.group == r.group && s.n == r.n &&
+                s.threads == r.threads) {
+                std::printf("%-30s %-16s %9zu %3d  %10.2f\n", r.group.c_str(),
+                            r.impl.c_str(), r.n, r.threads,
+                            percentile(s.nsPerOp, 0.5) /
+                                percentile(r.nsPerOp, 0.5));
+                break;
+            }
+        }
+    }
+}
+
+void writeJsonString(std::FILE* out, const std::string& s) {
+    std::fputc('"', out);
+    for (char c : s) {
+        if (c == '"' || c == '\\')
+            std::fputc('\\', out);
+        std::fputc(c, out);
+    }
+    std::fputc('"', out);
+}
+
+bool writeJson(const char* path) {
+    std::FILE* out = std::fopen(path, "w");
+    if (out == nullptr)
+        return false;
+
+    std::fprintf(out,
+                 "{\n  \"options\": {\"reps\": %d, \"warmup\": %d, "
+                 "\"scale\": %g, \"max_threads\": %d},\n  \"results\": [",
+                 gOptions.reps, gOptions.warmup, gOptions.scale,
+                 gOptions.maxThreads);
+    for (size_t i = 0; i < gResults.size(); ++i) {
+        const Result& r = gResults[i];
+        std::fprintf(out, "%s\n    {\"group\": ", i == 0 ? "" : ",");
+        writeJsonString(out, r.group);
+        std::fprintf(out, ", \"impl\": ");
+        writeJsonString(out, r.impl);
+        std::fprintf(out,
+                     ", \"n\": %zu, \"threads\": %d, \"reps\": %zu, "
+                     "\"ns_per_op\": {\"min\": %.3f, \"p50\": %.3f, "
+                     "\"p90\": %.3f, \"p99\": %.3f, \"max\": %.3f, "
+                     "\"mean\": %.3f}}",
+                     r.n, r.threads, r.nsPerOp.size(), r.nsPerOp.front(),
+                     percentile(r.nsPerOp, 0.5), percentile(r.nsPerOp, 0.9),
+                     percentile(r.nsPerOp, 0.99), r.nsPerOp.back(), r.mean);
+    }
+    std::fprintf(out, "\n  ]\n}\n");
+    return std::fclose(out) == 0;
+}
+
+bool parseOptions(int argc, char** argv) {
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        const char* val = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (val == nullptr) {
+            std::fprintf(stderr, "%s needs a value\n", arg);
+            return false;
+        }
+        ++i;
+
+        if (std::strcmp(arg, "--filter") == 0)
+            gOptions.filter = val;
+        else if (std::strcmp(arg, "--reps") == 0)
+            gOptions.reps = std::max(1, std::atoi(val));
+        else if (std::strcmp(arg, "--warmup") == 0)
+            gOptions.warmup = std::max(0, std::atoi(val));
+        else if (std::strcmp(arg, "--scale") == 0)
+            gOptions.scale = std::atof(val);
+        else if (std::strcmp(arg, "--max-threads") == 0)
+            gOptions.maxThreads = std::max(1, std::atoi(val));
+        else if (std::strcmp(arg, "--json") == 0)
+            gOptions.json = val;
+        else {
+            std::fprintf(stderr, "unknown option %s\n", arg);
+            return false;
+        }
+    }
+    return gOptions.scale > 0.0;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (!parseOptions(argc, argv)) {
+        std::fprintf(stderr,
+                     "usage: %s [--filter text] [--reps n] [--warmup n] "
+                     "[--scale x] [--max-threads n] [--json file]\n",
+                     argv[0]);
+        return 2;
+    }
+
+    std::printf("%-30s %-16s %9s %3s  %10s %10s %10s\n", "group", "impl", "n",
+                "thr", "min", "p50", "p90");
+    benchVector();
+    benchDeque();
+    benchList();
+    benchMap();
+    benchHashMap();
+    benchSnapshot();
+    benchString();
+    benchSort();
+    benchHeap();
+    benchSharedPtr();
+    benchQueues();
+    benchConcurrentMap();
+    benchAtomicSharedPtr();
+    printSummary();
+
+    if (gOptions.json != nullptr && !writeJson(gOptions.json)) {
+        std::fprintf(stderr, "cannot write %s\n", gOptions.json);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,457 @@
+// Copyright (C) 2021 syn1w
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "iterator.hpp"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace tiny_stl {
+
+// Bits packed into 64-bit words, the storage of vector<bool>
+//
+// Bit i of a range lives in word i / 64 at position i % 64, counted from
+// the lowest bit. An iterator is a word pointer and a bit offset, the
+// reference is a proxy with the word and a one-bit mask.
+//
+// The word-level helpers below work on a whole word at a time: a range
+// is a partial head word, full words and a partial tail word, the
+// partial ones are masked. algorithm.hpp overloads count, find, fill,
+// copy and all_of / any_of / none_of for bit iterators with them.
+
+using BitWord = uint64_t;
+
+constexpr size_t kBitWordBits = 64;
+
+// the number of words holding n bits
+constexpr size_t bitWordCount(size_t n) noexcept {
+    return (n + kBitWordBits - 1) / kBitWordBits;
+}
+
+// the lowest n bits set, n <= 64
+inline BitWord bitLowMask(size_t n) noexcept {
+    return n >= kBitWordBits ? ~BitWord(0) : (BitWord(1) << n) - 1;
+}
+
+inline size_t bitPopcount(BitWord x) noexcept {
+#if defined(_MSC_VER) && defined(_WIN64)
+    return static_cast<size_t>(__popcnt64(x));
+#elif defined(_MSC_VER)
+    return __popcnt(static_cast<unsigned>(x)) +
+           __popcnt(static_cast<unsigned>(x >> 32));
+#else
+    return static_cast<size_t>(__builtin_popcountll(x));
+#endif
+}
+
+inline size_t bitCountTrailingZeros(BitWord x) noexcept {
+    assert(x != 0);
+#if defined(_MSC_VER) && defined(_WIN64)
+    unsigned long idx;
+    _BitScanForward64(&idx, x);
+    return idx;
+#elif defined(_MSC_VER)
+    unsigned long idx;
+    if (_BitScanForward(&idx, static_cast<unsigned long>(x)))
+        return idx;
+    _BitScanForward(&idx, static_cast<unsigned long>(x >> 32));
+    return idx + 32;
+#else
+    return static_cast<size_t>(__builtin_ctzll(x));
+#endif
+}
+
+class BitReference {
+private:
+    BitWord* word;
+    BitWord mask;
+
+public:
+    BitReference(BitWord* w, BitWord m) noexcept : word(w), mask(m) {
+    }
+
+    // copies the proxy, assignment writes the bit
+    BitReference(const BitReference&) = default;
+
+    operator bool() const noexcept {
+        return (*word & mask) != 0;
+    }
+
+    BitReference& operator=(bool x) noexcept {
+        if (x)
+            *word |= mask;
+        else
+            *word &= ~mask;
+        return *this;
+    }
+
+    BitReference& operator=(const BitReference& rhs) noexcept {
+        return *this = static_cast<bool>(rhs);
+    }
+
+    bool operator~() const noexcept {
+        return !static_cast<bool>(*this);
+    }
+
+    void flip() noexcept {
+        *word ^= mask;
+    }
+
+    friend void swap(BitReference lhs, BitReference rhs) noexcept {
+        const bool tmp = lhs;
+        lhs = rhs;
+        rhs = tmp;
+    }
+
+    friend void swap(BitReference lhs, bool& rhs) noexcept {
+        const bool tmp = lhs;
+        lhs = rhs;
+        rhs = tmp;
+    }
+
+    friend void swap(bool& lhs, BitReference rhs) noexcept {
+        swap(rhs, lhs);
+    }
+};
+
+struct BitConstIterator {
+    using iterator_category = random_access_iterator_tag;
+    using value_type = bool;
+    using difference_type = ptrdiff_t;
+    using pointer = void;
+    using reference = bool;
+    using Self = BitConstIterator;
+
+    BitWord* word;
+    size_t offset; // [0, 64)
+
+    BitConstIterator() : word(), offset() {
+    }
+
+    BitConstIterator(BitWord* w, size_t off) : word(w), offset(off) {
+    }
+
+    reference operator*() const {
+        return (*word >> offset) & 1;
+    }
+
+    Self& operator++() {
+        if (++offset == kBitWordBits) {
+            offset = 0;
+            ++word;
+        }
+        return *this;
+    }
+
+    Self operator++(int) {
+        Self tmp = *this;
+        ++*this;
+        return tmp;
+    }
+
+    Self& operator--() {
+        if (offset-- == 0) {
+            offset = kBitWordBits - 1;
+            --word;
+        }
+        return *this;
+    }
+
+    Self operator--(int) {
+        Self tmp = *this;
+        --*this;
+        return tmp;
+    }
+
+    Self& operator+=(difference_type n) {
+        const difference_type pos = static_cast<difference_type>(offset) + n;
+        const difference_type bits = static_cast<difference_type>(kBitWordBits);
+        // floor division, pos may be negative
+        difference_type words = pos / bits;
+        if (pos % bits < 0)
+            --words;
+        word += words;
+        offset = static_cast<size_t>(pos - words * bits);
+        return *this;
+    }
+
+    Self operator+(difference_type n) const {
+        Self tmp = *this;
+        return tmp += n;
+    }
+
+    Self& operator-=(difference_type n) {
+        return *this += -n;
+    }
+
+    Self operator-(difference_type n) const {
+        Self tmp = *this;
+        return tmp -= n;
+    }
+
+    difference_type operator-(const Self& rhs) const {
+        return (word - rhs.word) * static_cast<difference_type>(kBitWordBits) +
+               static_cast<difference_type>(offset) -
+               static_cast<difference_type>(rhs.offset);
+    }
+
+    reference operator[](difference_type n) const {
+        return *(*this + n);
+    }
+
+    bool operator==(const Self& rhs) const {
+        return word == rhs.word && offset == rhs.offset;
+    }
+
+    bool operator!=(const Self& rhs) const {
+        return !(*this == rhs);
+    }
+
+    bool operator<(const Self& rhs) const {
+        return word < rhs.word || (word == rhs.word && offset < rhs.offset);
+    }
+
+    bool operator>(const Self& rhs) const {
+        return rhs < *this;
+    }
+
+    bool operator<=(const Self& rhs) const {
+        return !(rhs < *this);
+    }
+
+    bool operator>=(const Self& rhs) const {
+        return !(*this < rhs);
+    }
+}; // class BitConstIterator
+
+inline BitConstIterator operator+(BitConstIterator::difference_type n,
+                                  BitConstIterator iter) {
+    return iter += n;
+}
+
+struct BitIterator : BitConstIterator {
+    using iterator_category = random_access_iterator_tag;
+    using value_type = bool;
+    using difference_type = ptrdiff_t;
+    using pointer = void;
+    using reference = BitReference;
+
+    using Base = BitConstIterator;
+    using Self = BitIterator;
+
+    BitIterator() : Base() {
+    }
+
+    BitIterator(BitWord* w, size_t off) : Base(w, off) {
+    }
+
+    reference operator*() const {
+        return reference(word, BitWord(1) << offset);
+    }
+
+    Self& operator++() {
+        ++*static_cast<Base*>(this);
+        return *this;
+    }
+
+    Self operator++(int) {
+        Self tmp = *this;
+        ++*this;
+        return tmp;
+    }
+
+    Self& operator--() {
+        --*static_cast<Base*>(this);
+        return *this;
+    }
+
+    Self operator--(int) {
+        Self tmp = *this;
+        --*this;
+        return tmp;
+    }
+
+    Self& operator+=(difference_type n) {
+        *static_cast<Base*>(this) += n;
+        return *this;
+    }
+
+    Self operator+(difference_type n) const {
+        Self tmp = *this;
+        return tmp += n;
+    }
+
+    Self& operator-=(difference_type n) {
+        return *this += -n;
+    }
+
+    Self operator-(difference_type n) const {
+        Self tmp = *this;
+        return tmp -= n;
+    }
+
+    difference_type operator-(const Base& rhs) const {
+        return static_cast<const Base&>(*this) - rhs;
+    }
+
+    reference operator[](difference_type n) const {
+        return *(*this + n);
+    }
+}; // class BitIterator
+
+inline BitIterator operator+(BitIterator::difference_type n,
+                             BitIterator iter) {
+    return iter += n;
+}
+
+// n <= 64 bits from offset off of *w, in the low bits of the result
+inline BitWord bitLoad(const BitWord* w, size_t off, size_t n) noexcept {
+    BitWord v = w[0] >> off;
+    if (off != 0 && off + n > kBitWordBits)
+        v |= w[1] << (kBitWordBits - off);
+    return v & bitLowMask(n);
+}
+
+// the low n <= 64 bits of v to offset off of *w, the other bits stay
+inline void bitStore(BitWord* w, size_t off, size_t n, BitWord v) noexcept {
+    const BitWord mask = bitLowMask(n);
+    v &= mask;
+    w[0] = (w[0] & ~(mask << off)) | (v << off);
+    if (off != 0 && off + n > kBitWordBits) {
+        const size_t rest = off + n - kBitWordBits;
+        w[1] = (w[1] & ~bitLowMask(rest)) | (v >> (kBitWordBits - off));
+    }
+}
+
+// calls f(word, mask) for the words of [first, last), the bits outside
+// the range are clear in mask; f returns false to stop, then it returns
+// the word it stopped at, otherwise nullptr
+template <typename Func>
+inline const BitWord* bitVisitWords(BitConstIterator first,
+                                    BitConstIterator last, Func f) {
+    const BitWord* w = first.word;
+    BitWord mask = ~BitWord(0) << first.offset;
+    for (; w != last.word; ++w, mask = ~BitWord(0)) {
+        if (!f(*w, mask))
+            return w;
+    }
+
+    if (last.offset != 0) {
+        mask &= bitLowMask(last.offset);
+        if (!f(*w, mask))
+            return w;
+    }
+
+    return nullptr;
+}
+
+// the number of bits equal to val
+inline ptrdiff_t bitCount(BitConstIterator first, BitConstIterator last,
+                          bool val) {
+    size_t ones = 0;
+    bitVisitWords(first, last, [&ones](BitWord w, BitWord mask) {
+        ones += bitPopcount(w & mask);
+        return true;
+    });
+
+    const ptrdiff_t c = static_cast<ptrdiff_t>(ones);
+    return val ? c : (last - first) - c;
+}
+
+// the first bit equal to val
+inline BitConstIterator bitFind(BitConstIterator first, BitConstIterator last,
+                                bool val) {
+    const BitWord flip = val ? 0 : ~BitWord(0);
+    BitWord hit = 0;
+    const BitWord* w =
+        bitVisitWords(first, last, [flip, &hit](BitWord x, BitWord mask) {
+            hit = (x ^ flip) & mask;
+            return hit == 0;
+        });
+
+    if (w == nullptr)
+        return last;
+    return BitConstIterator(const_cast<BitWord*>(w),
+                            bitCountTrailingZeros(hit));
+}
+
+inline void bitFill(BitIterator first, BitIterator last, bool val) {
+    BitWord* w = first.word;
+    BitWord mask = ~BitWord(0) << first.offset;
+    if (w != last.word) {
+        *w = val ? (*w | mask) : (*w & ~mask);
+        ++w;
+        // the full words in between
+        std::memset(w, val ? 0xff : 0,
+                    static_cast<size_t>(last.word - w) * sizeof(BitWord));
+        w = last.word;
+        mask = ~BitWord(0);
+    }
+
+    if (last.offset == 0)
+        return;
+
+    mask &= bitLowMask(last.offset);
+    *w = val ? (*w | mask) : (*w & ~mask);
+}
+
+// copy 64 bits a step, the destination may start before the source in
+// the same array
+inline BitIterator bitCopy(BitConstIterator first, BitConstIterator last,
+                           BitIterator dst) {
+    size_t n = static_cast<size_t>(last - first);
+    if (first.offset == 0 && dst.offset == 0) {
+        // word aligned, whole words are moved at once
+        const size_t words = n / kBitWordBits;
+        std::memmove(dst.word, first.word, words * sizeof(BitWord));
+        first.word += words;
+        dst.word += words;
+        n -= words * kBitWordBits;
+    }
+
+    for (; n >= kBitWordBits; n -= kBitWordBits) {
+        bitStore(dst.word, dst.offset, kBitWordBits,
+                 bitLoad(first.word, first.offset, kBitWordBits));
+        ++first.word;
+        ++dst.word;
+    }
+
+    if (n != 0) {
+        bitStore(dst.word, dst.offset, n, bitLoad(first.word, first.offset, n));
+        dst += static_cast<ptrdiff_t>(n);
+    }
+
+    return dst;
+}
+
+// copy from the end, the destination may end after the source in the
+// same array
+inline BitIterator bitCopyBackward(BitConstIterator first,
+                                   BitConstIterator last, BitIterator dstLast) {
+    size_t n = static_cast<size_t>(last - first);
+    for (; n >= kBitWordBits; n -= kBitWordBits) {
+        last -= static_cast<ptrdiff_t>(kBitWordBits);
+        dstLast -= static_cast<ptrdiff_t>(kBitWordBits);
+        bitStore(dstLast.word, dstLast.offset, kBitWordBits,
+                 bitLoad(last.word, last.offset, kBitWordBits));
+    }
+
+    if (n != 0) {
+        dstLast -= static_cast<ptrdiff_t>(n);
+        bitStore(dstLast.word, dstLast.offset, n,
+                 bitLoad(first.word, first.offset, n));
+    }
+
+    return dstLast;
+}
+
+} // namespace tiny_stl
@@ -0,0 +1,1241 @@
+// Copyright (C) 2021 syn1w
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <cstdint>
+#include <initializer_list>
+#include <type_traits>
+
+#include "memory.hpp"
+
+namespace tiny_stl {
+
+// B-tree, the ordered engine of btree_map and btree_set
+//
+// A node stores up to Slots values side by side, so a scan or a search
+// reads a few cache lines per node instead of one per value:
+//
+//   internal: | c0 | v0 | c1 | v1 | ... | v(n-1) | cn |   c0 < v0 < c1 ...
+//   leaf:     | v0 | v1 | ... | v(n-1) |
+//
+// Leaves have no child array. All leaves are on the same level, every
+// node but the root keeps at least one value. A full node is split
+// before a value is added to it; appending at the end keeps the left
+// half full, so sorted input leaves the nodes full. Erase refills a node
+// that falls under Slots / 2 values from a sibling or merges the two.
+//
+// Unlike RBTree, insert and erase move values between slots, so they
+// invalidate every iterator, like vector.
+
+namespace {
+
+// about 256 bytes of values, at least 3 so both halves of a split are
+// valid nodes
+template <typename T>
+constexpr size_t btreeDefaultSlots() {
+    return 256 / sizeof(T) < 3 ? 3 : 256 / sizeof(T) > 256 ? 256
+                                                            : 256 / sizeof(T);
+}
+
+template <typename T, size_t Slots>
+struct BTInternal;
+
+template <typename T, size_t Slots>
+struct BTLeaf {
+    BTInternal<T, Slots>* parent; // nullptr for the root
+    uint16_t position;            // index in parent->children
+    uint16_t count;               // number of values
+    bool leaf;
+    std::aligned_union_t<1, T> slots[Slots];
+
+    T& value(size_t i) noexcept {
+        return *reinterpret_cast<T*>(slots + i);
+    }
+
+    const T& value(size_t i) const noexcept {
+        return *reinterpret_cast<const T*>(slots + i);
+    }
+};
+
+template <typename T, size_t Slots>
+struct BTInternal : BTLeaf<T, Slots> {
+    BTLeaf<T, Slots>* children[Slots + 1];
+};
+
+template <typename T, size_t Slots>
+inline BTLeaf<T, Slots>*& btChild(BTLeaf<T, Slots>* node, size_t i) noexcept {
+    return static_cast<BTInternal<T, Slots>*>(node)->children[i];
+}
+
+} // namespace
+
+// T is stored in the nodes, V is what the iterators expose, a map stores
+// pair<Key, T> and hands out pair<const Key, T> so the keys stay read-only
+template <typename T, size_t Slots, typename V = T>
+struct BTreeConstIterator {
+    using iterator_category = bidirectional_iterator_tag;
+    using value_type = remove_const_t<V>;
+    using difference_type = ptrdiff_t;
+    using pointer = const V*;
+    using reference = const V&;
+
+    using Ptr = BTLeaf<T, Slots>*;
+
+    Ptr node;
+    int position;
+
+    BTreeConstIterator() : node(), position(0) {
+    }
+    BTreeConstIterator(Ptr x, int pos) : node(x), position(pos) {
+    }
+
+    reference operator*() const {
+        return reinterpret_cast<reference>(node->value(position));
+    }
+
+    pointer operator->() const {
+        return pointer_traits<pointer>::pointer_to(**this);
+    }
+
+    BTreeConstIterator& operator++() {
+        if (!node->leaf) { // the first value of the right subtree
+            node = btChild(node, position + 1);
+            while (!node->leaf)
+                node = btChild(node, 0);
+            position = 0;
+            return *this;
+        }
+
+        if (++position < node->count)
+            return *this;
+
+        // past a leaf, the next value is the separator of an ancestor
+        Ptr save = node;
+        while (position == node->count && node->parent != nullptr) {
+            position = node->position;
+            node = node->parent;
+        }
+
+        if (position == node->count) { // end()
+            node = save;
+            position = save->count;
+        }
+
+        return *this;
+    }
+
+    BTreeConstIterator operator++(int) {
+        BTreeConstIterator tmp = *this;
+        ++*this;
+
+        return tmp;
+    }
+
+    BTreeConstIterator& operator--() {
+        if (!node->leaf) { // the last value of the left subtree
+            node = btChild(node, position);
+            while (!node->leaf)
+                node = btChild(node, node->count);
+            position = node->count - 1;
+            return *this;
+        }
+
+        if (--position >= 0)
+            return *this;
+
+        while (position < 0 && node->parent != nullptr) {
+            position = node->position - 1;
+            node = node->parent;
+        }
+
+        return *this;
+    }
+
+    BTreeConstIterator operator--(int) {
+        BTreeConstIterator tmp = *this;
+        --*this;
+
+        return tmp;
+    }
+
+    bool operator==(const BTreeConstIterator& rhs) const {
+        return node == rhs.node && position == rhs.position;
+    }
+
+    bool operator!=(const BTreeConstIterator& rhs) const {
+        return !(*this == rhs);
+    }
+}; // BTreeConstIterator
+
+template <typename T, size_t Slots, typename V = T>
+struct BTreeIterator : BTreeConstIterator<T, Slots, V> {
+    using iterator_category = bidirectional_iterator_tag;
+    using value_type = remove_const_t<V>;
+    using difference_type = ptrdiff_t;
+    using pointer = V*;
+    using reference = V&;
+
+    using Ptr = BTLeaf<T, Slots>*;
+    using Base = BTreeConstIterator<T, Slots, V>;
+
+    BTreeIterator() : Base() {
+    }
+    BTreeIterator(Ptr x, int pos) : Base(x, pos) {
+    }
+
+    reference operator*() const {
+        return const_cast<reference>(Base::operator*());
+    }
+
+    pointer operator->() const {
+        return pointer_traits<pointer>::pointer_to(**this);
+    }
+
+    BTreeIterator& operator++() {
+        ++*static_cast<Base*>(this);
+        return *this;
+    }
+
+    BTreeIterator operator++(int) {
+        BTreeIterator tmp = *this;
+        ++*this;
+        return tmp;
+    }
+
+    BTreeIterator& operator--() {
+        --*static_cast<Base*>(this);
+        return *this;
+    }
+
+    BTreeIterator operator--(int) {
+        BTreeIterator tmp = *this;
+        --*this;
+        return tmp;
+    }
+}; // BTreeIterator
+
+template <typename T, typename Compare, typename Alloc, bool isMap,
+          size_t Slots>
+class BTree {
+    static_assert(Slots >= 3 && Slots <= 0xffff,
+                  "a B-tree node holds 3 to 65535 values");
+
+public:
+    using key_type = typename AssociatedTypeHelper<T, isMap>::key_type;
+    using mapped_type = typename AssociatedTypeHelper<T, isMap>::mapped_type;
+    using value_type = T;
+    using key_compare = Compare;
+    using allocator_type = Alloc;
+    using size_type = size_t;
+    using difference_type = ptrdiff_t;
+    using reference = value_type&;
+    using const_reference = const value_type&;
+    using pointer = value_type*;
+    using const_pointer = const value_type*;
+
+    using AlTraits = allocator_traits<Alloc>;
+    using Leaf = BTLeaf<value_type, Slots>;
+    using Internal = BTInternal<value_type, Slots>;
+    using NodePtr = Leaf*;
+    using AlNode = typename AlTraits::template rebind_alloc<Leaf>;
+    using AlNodeTraits = allocator_traits<AlNode>;
+    using AlInternal = typename AlTraits::template rebind_alloc<Internal>;
+    using AlInternalTraits = allocator_traits<AlInternal>;
+
+    using ExposedType =
+        conditional_t<isMap, pair<const key_type, mapped_type>, const T>;
+    using iterator = BTreeIterator<value_type, Slots, ExposedType>;
+    using const_iterator = BTreeConstIterator<value_type, Slots, ExposedType>;
+    using reverse_iterator = tiny_stl::reverse_iterator<iterator>;
+    using const_reverse_iterator = tiny_stl::reverse_iterator<const_iterator>;
+
+    static constexpr size_type node_slots = Slots;
+
+private:
+    static constexpr size_type kMinValues = Slots / 2;
+
+    NodePtr root;
+    NodePtr leftmost;
+    NodePtr rightmost;
+    size_type mCount;
+    AlNode alloc;
+    Compare compare;
+
+private:
+    NodePtr newLeaf() {
+        NodePtr p = this->alloc.allocate(1);
+        p->parent = nullptr;
+        p->position = 0;
+        p->count = 0;
+        p->leaf = true;
+
+        return p;
+    }
+
+    Internal* newInternal() {
+        AlInternal al(this->alloc);
+        Internal* p = al.allocate(1);
+        p->parent = nullptr;
+        p->position = 0;
+        p->count = 0;
+        p->leaf = false;
+
+        return p;
+    }
+
+    void freeNode(NodePtr p) noexcept {
+        if (p->leaf) {
+            this->alloc.deallocate(p, 1);
+        } else {
+            AlInternal al(this->alloc);
+            al.deallocate(static_cast<Internal*>(p), 1);
+        }
+    }
+
+    template <typename... Args>
+    void constructValue(NodePtr p, size_type i, Args&&... args) {
+        AlNodeTraits::construct(this->alloc, tiny_stl::addressof(p->value(i)),
+                                tiny_stl::forward<Args>(args)...);
+    }
+
+    void destroyValue(NodePtr p, size_type i) noexcept {
+        AlNodeTraits::destroy(this->alloc, tiny_stl::addressof(p->value(i)));
+    }
+
+    // the slot s of src becomes raw, the slot d of dst was raw
+    void moveValue(NodePtr src, size_type s, NodePtr dst, size_type d) {
+        constructValue(dst, d, tiny_stl::move(src->value(s)));
+        destroyValue(src, s);
+    }
+
+    // slot i becomes raw, [i, count) moves one right
+    void openSlot(NodePtr p, size_type i) {
+        for (size_type j = p->count; j > i; --j)
+            moveValue(p, j - 1, p, j);
+    }
+
+    // the raw slot i is filled, [i + 1, count) moves one left
+    void closeSlot(NodePtr p, size_type i) {
+        for (size_type j = i + 1; j < p->count; ++j)
+            moveValue(p, j, p, j - 1);
+    }
+
+    void setChild(NodePtr p, size_type i, NodePtr child) noexcept {
+        btChild(p, i) = child;
+        child->parent = static_cast<Internal*>(p);
+        child->position = static_cast<uint16_t>(i);
+    }
+
+    void clearAux(NodePtr p) noexcept {
+        if (!p->leaf) {
+            for (size_type i = 0; i <= p->count; ++i)
+                clearAux(btChild(p, i));
+        }
+
+        for (size_type i = 0; i < p->count; ++i)
+            destroyValue(p, i);
+        freeNode(p);
+    }
+
+    // map, the stored pair or the one an iterator exposes
+    template <typename U>
+    static const key_type& getKeyValue(const U& val, true_type) noexcept {
+        return val.first;
+    }
+
+    // set
+    static const key_type& getKeyValue(const T& val, false_type) noexcept {
+        return val;
+    }
+
+    template <typename U>
+    static const key_type& get_key(const U& val) noexcept {
+        return getKeyValue(val, bool_constant<isMap>{});
+    }
+
+    // the first value of p not less than key
+    template <typename K>
+    size_type lowerIndex(NodePtr p, const K& key) const {
+        size_type lo = 0;
+        size_type hi = p->count;
+        while (lo < hi) {
+            const size_type mid = (lo + hi) / 2;
+            if (this->compare(get_key(p->value(mid)), key))
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+
+        return lo;
+    }
+
+    // the first value of p greater than key
+    template <typename K>
+    size_type upperIndex(NodePtr p, const K& key) const {
+        size_type lo = 0;
+        size_type hi = p->count;
+        while (lo < hi) {
+            const size_type mid = (lo + hi) / 2;
+            if (!this->compare(key, get_key(p->value(mid))))
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+
+        return lo;
+    }
+
+    template <typename K>
+    iterator lowBoundAux(const K& key) const {
+        iterator pos = endAux();
+        for (NodePtr p = root; p != nullptr;) {
+            const size_type i = lowerIndex(p, key);
+            if (i < p->count)
+                pos = iterator(p, static_cast<int>(i));
+            if (p->leaf)
+                break;
+            p = btChild(p, i);
+        }
+
+        return pos;
+    }
+
+    template <typename K>
+    iterator uppBoundAux(const K& key) const {
+        iterator pos = endAux();
+        for (NodePtr p = root; p != nullptr;) {
+            const size_type i = upperIndex(p, key);
+            if (i < p->count)
+                pos = iterator(p, static_cast<int>(i));
+            if (p->leaf)
+                break;
+            p = btChild(p, i);
+        }
+
+        return pos;
+    }
+
+    iterator beginAux() const noexcept {
+        return iterator(leftmost, 0);
+    }
+
+    iterator endAux() const noexcept {
+        return iterator(rightmost, rightmost == nullptr ? 0 : rightmost->count);
+    }
+
+    // a value goes to slot position of node, equal is an existing value
+    // with the same key when the keys are unique
+    struct InsertPos {
+        NodePtr node;
+        size_type position;
+        bool equal;
+    };
+
+    // a value can always be inserted into a leaf, right before it
+    InsertPos leafPos(iterator pos) const {
+        if (pos.node->leaf)
+            return {pos.node, static_cast<size_type>(pos.position), false};
+
+        --pos; // the last value of a leaf
+        return {pos.node, static_cast<size_type>(pos.position) + 1, false};
+    }
+
+    InsertPos uniquePos(const key_type& key) const {
+        NodePtr p = root;
+        while (true) {
+            const size_type i = lowerIndex(p, key);
+            if (i < p->count && !this->compare(key, get_key(p->value(i))))
+                return {p, i, true};
+            if (p->leaf)
+                return {p, i, false};
+            p = btChild(p, i);
+        }
+    }
+
+    // after the equal keys
+    InsertPos equalPos(const key_type& key) const {
+        NodePtr p = root;
+        while (true) {
+            const size_type i = upperIndex(p, key);
+            if (p->leaf)
+                return {p, i, false};
+            p = btChild(p, i);
+        }
+    }
+
+    // before the equal keys
+    InsertPos lowerEqualPos(const key_type& key) const {
+        NodePtr p = root;
+        while (true) {
+            const size_type i = lowerIndex(p, key);
+            if (p->leaf)
+                return {p, i, false};
+            p = btChild(p, i);
+        }
+    }
+
+    // O(1) if key goes right before hint
+    InsertPos hintUniquePos(const_iterator hint, const key_type& key) const {
+        iterator pos(hint.node, hint.position);
+        if (pos != endAux()) {
+            if (!this->compare(key, get_key(*pos))) {
+                if (!this->compare(get_key(*pos), key))
+                    return {pos.node, static_cast<size_type>(pos.position),
+                            true};
+                return uniquePos(key);
+            }
+        }
+
+        if (pos != beginAux()) {
+            iterator before = pos;
+            if (!this->compare(get_key(*--before), key))
+                return uniquePos(key);
+        }
+
+        return leafPos(pos);
+    }
+
+    // as close as possible before hint, a wrong hint falls back to the
+    // end of the equal keys it is nearest to
+    InsertPos hintEqualPos(const_iterator hint, const key_type& key) const {
+        iterator pos(hint.node, hint.position);
+        if (pos != endAux() && this->compare(get_key(*pos), key))
+            return lowerEqualPos(key);
+
+        if (pos != beginAux()) {
+            iterator before = pos;
+            if (this->compare(key, get_key(*--before)))
+                return equalPos(key);
+        }
+
+        return leafPos(pos);
+    }
+
+    // make room in the full node p before a value is inserted at i,
+    // the parents are split first, (p, i) moves to the half i falls in
+    void splitNode(NodePtr& p, size_type& i) {
+        NodePtr right = p->leaf ? newLeaf() : newInternal();
+        NodePtr parent = p->parent;
+        size_type pos = p->position;
+
+        try {
+            if (parent == nullptr) {
+                parent = newInternal();
+                setChild(parent, 0, p);
+                root = parent;
+            } else if (parent->count == Slots) {
+                splitNode(parent, pos);
+            }
+        } catch (...) {
+            freeNode(right);
+            throw;
+        }
+
+        // appending keeps p full, prepending keeps right full
+        const size_type mid = i == Slots ? Slots - 1 : i == 0 ? 1 : Slots / 2;
+
+        for (size_type j = mid + 1; j < p->count; ++j)
+            moveValue(p, j, right, j - mid - 1);
+        right->count = static_cast<uint16_t>(p->count - mid - 1);
+
+        if (!p->leaf) {
+            for (size_type j = 0; j <= right->count; ++j)
+                setChild(right, j, btChild(p, mid + 1 + j));
+        }
+
+        // the value mid goes up, right follows it in parent
+        openSlot(parent, pos);
+        for (size_type j = parent->count + 1; j > pos + 1; --j)
+            setChild(parent, j, btChild(parent, j - 1));
+        moveValue(p, mid, parent, pos);
+        setChild(parent, pos + 1, right);
+        ++parent->count;
+        p->count = static_cast<uint16_t>(mid);
+
+        if (p == rightmost)
+            rightmost = right;
+
+        if (i > mid) {
+            p = right;
+            i -= mid + 1;
+        }
+    }
+
+    // the value is built first when a split is needed, a failed split
+    // must not leave an empty node
+    template <typename... Args>
+    iterator insertAt(InsertPos pos, Args&&... args) {
+        NodePtr p = pos.node;
+        size_type i = pos.position;
+
+        if (p->count == Slots) {
+            T value(tiny_stl::forward<Args>(args)...);
+            splitNode(p, i);
+            openSlot(p, i);
+            constructValue(p, i, tiny_stl::move(value));
+        } else {
+            openSlot(p, i);
+            try {
+                constructValue(p, i, tiny_stl::forward<Args>(args)...);
+            } catch (...) {
+                closeSlot(p, i);
+                throw;
+            }
+        }
+
+        ++p->count;
+        ++this->mCount;
+
+        return iterator(p, static_cast<int>(i));
+    }
+
+    void createRoot() {
+        if (root == nullptr) {
+            root = newLeaf();
+            leftmost = root;
+            rightmost = root;
+        }
+    }
+
+    // node p borrows the first value of its right sibling through the
+    // separator pos of parent
+    void rotateLeft(NodePtr parent, size_type pos, NodePtr p, NodePtr right) {
+        moveValue(parent, pos, p, p->count);
+        moveValue(right, 0, parent, pos);
+        closeSlot(right, 0);
+
+        if (!p->leaf) {
+            setChild(p, p->count + 1, btChild(right, 0));
+            for (size_type j = 0; j < right->count; ++j)
+                setChild(right, j, btChild(right, j + 1));
+        }
+
+        ++p->count;
+        --right->count;
+    }
+
+    // node p borrows the last value of its left sibling through the
+    // separator pos of parent
+    void rotateRight(NodePtr parent, size_type pos, NodePtr left, NodePtr p,
+                     iterator& tracked) {
+        openSlot(p, 0);
+        moveValue(parent, pos, p, 0);
+        moveValue(left, left->count - 1, parent, pos);
+
+        if (!p->leaf) {
+            for (size_type j = p->count + 1; j > 0; --j)
+                setChild(p, j, btChild(p, j - 1));
+            setChild(p, 0, btChild(left, left->count));
+        }
+
+        --left->count;
+        ++p->count;
+
+        if (tracked.node == p)
+            ++tracked.position;
+    }
+
+    // right and the separator pos of parent are appended to left
+    void mergeNodes(NodePtr parent, size_type pos, NodePtr left, NodePtr right,
+                    iterator& tracked) {
+        const size_type base = left->count + 1;
+
+        moveValue(parent, pos, left, left->count);
+        for (size_type j = 0; j < right->count; ++j)
+            moveValue(right, j, left, base + j);
+
+        if (!left->leaf) {
+            for (size_type j = 0; j <= right->count; ++j)
+                setChild(left, base + j, btChild(right, j));
+        }
+
+        if (tracked.node == right) {
+            tracked.node = left;
+            tracked.position += static_cast<int>(base);
+        }
+
+        left->count = static_cast<uint16_t>(base + right->count);
+
+        closeSlot(parent, pos);
+        for (size_type j = pos + 1; j < parent->count; ++j)
+            setChild(parent, j, btChild(parent, j + 1));
+        --parent->count;
+
+        if (right == rightmost)
+            rightmost = left;
+        freeNode(right);
+    }
+
+    // p lost a value, refill it from a sibling or merge it upwards
+    void rebalance(NodePtr p, iterator& tracked) {
+        while (p != root) {
+            if (p->count >= kMinValues)
+                return;
+
+            NodePtr parent = p->parent;
+            const size_type pos = p->position;
+            NodePtr left = pos > 0 ? btChild(parent, pos - 1) : nullptr;
+            NodePtr right =
+                pos < parent->count ? btChild(parent, pos + 1) : nullptr;
+
+            if (right != nullptr && right->count > kMinValues) {
+                rotateLeft(parent, pos, p, right);
+                return;
+            }
+
+            if (left != nullptr && left->count > kMinValues) {
+                rotateRight(parent, pos - 1, left, p, tracked);
+                return;
+            }
+
+            if (right != nullptr)
+                mergeNodes(parent, pos, p, right, tracked);
+            else
+                mergeNodes(parent, pos - 1, left, p, tracked);
+
+            p = parent;
+        }
+
+        if (root->count == 0) { // the root is empty or has one child
+            NodePtr old = root;
+            if (old->leaf) {
+                root = nullptr;
+                leftmost = nullptr;
+                rightmost = nullptr;
+            } else {
+                root = btChild(old, 0);
+                root->parent = nullptr;
+                root->position = 0;
+            }
+            freeNode(old);
+        }
+    }
+
+    iterator eraseAux(iterator pos) {
+        NodePtr p = pos.node;
+        size_type i = static_cast<size_type>(pos.position);
+        const bool internal = !p->leaf;
+
+        destroyValue(p, i);
+        if (internal) { // the predecessor in a leaf takes the place
+            iterator before = pos;
+            --before;
+            moveValue(before.node, before.position, p, i);
+            p = before.node;
+            i = static_cast<size_type>(before.position);
+        }
+
+        closeSlot(p, i);
+        --p->count;
+        --this->mCount;
+
+        iterator next(p, static_cast<int>(i));
+        rebalance(p, next);
+        if (root == nullptr)
+            return iterator();
+
+        // past the leaf, step from its last value
+        if (next.position == next.node->count) {
+            --next.position;
+            ++next;
+        }
+
+        // the predecessor stands at pos now, its successor is next
+        if (internal)
+            ++next;
+
+        return next;
+    }
+
+    NodePtr copyNodes(NodePtr rhs, NodePtr parent, size_type position) {
+        NodePtr p = rhs->leaf ? newLeaf() : newInternal();
+        size_type children = 0;
+
+        try {
+            for (; p->count < rhs->count; ++p->count)
+                constructValue(p, p->count, rhs->value(p->count));
+
+            if (!rhs->leaf) {
+                for (; children <= rhs->count; ++children)
+                    btChild(p, children) =
+                        copyNodes(btChild(rhs, children), p, children);
+            }
+        } catch (...) {
+            for (size_type j = 0; j < children; ++j)
+                clearAux(btChild(p, j));
+            for (size_type j = 0; j < p->count; ++j)
+                destroyValue(p, j);
+            freeNode(p);
+            throw;
+        }
+
+        p->parent = static_cast<Internal*>(parent);
+        p->position = static_cast<uint16_t>(position);
+
+        return p;
+    }
+
+    void copyAux(const BTree& rhs) {
+        if (rhs.root == nullptr)
+            return;
+
+        root = copyNodes(rhs.root, nullptr, 0);
+        mCount = rhs.mCount;
+
+        for (leftmost = root; !leftmost->leaf;)
+            leftmost = btChild(leftmost, 0);
+        for (rightmost = root; !rightmost->leaf;)
+            rightmost = btChild(rightmost, rightmost->count);
+    }
+
+    void moveAux(BTree& rhs) noexcept {
+        tiny_stl::swapADL(this->root, rhs.root);
+        tiny_stl::swapADL(this->leftmost, rhs.leftmost);
+        tiny_stl::swapADL(this->rightmost, rhs.rightmost);
+        tiny_stl::swapADL(this->mCount, rhs.mCount);
+        tiny_stl::swapADL(this->compare, rhs.compare);
+    }
+
+    // the nodes are stolen only if they can be freed by this->alloc
+    void moveOrCopy(BTree& rhs) {
+        if (this->alloc == rhs.alloc) {
+            moveAux(rhs);
+        } else {
+            this->compare = rhs.compare;
+            copyAux(rhs);
+            rhs.clear();
+        }
+    }
+
+    // a propagated allocator comes along with the nodes, see RBTree
+    void moveAssignAux(BTree& rhs) {
+        if (AlNodeTraits::propagate_on_container_move_assignment::value) {
+            tiny_stl::swapADL(this->alloc, rhs.alloc);
+            moveAux(rhs);
+        } else {
+            moveOrCopy(rhs);
+        }
+    }
+
+public:
+    BTree()
+        : root(), leftmost(), rightmost(), mCount(0), alloc(), compare() {
+    }
+
+    BTree(const Compare& cmp, const allocator_type& al = allocator_type())
+        : root(), leftmost(), rightmost(), mCount(0), alloc(al),
+          compare(cmp) {
+    }
+
+    BTree(const BTree& rhs, const allocator_type& al)
+        : BTree(rhs.compare, al) {
+        copyAux(rhs);
+    }
+
+    BTree(BTree&& rhs) noexcept : BTree(rhs.compare, rhs.alloc) {
+        moveAux(rhs);
+    }
+
+    BTree(BTree&& rhs, const allocator_type& al) : BTree(rhs.compare, al) {
+        moveOrCopy(rhs);
+    }
+
+    BTree& operator=(const BTree& rhs) {
+        if (this != tiny_stl::addressof(rhs)) {
+            clear();
+            if (AlNodeTraits::propagate_on_container_copy_assignment::value)
+                this->alloc = rhs.alloc;
+            this->compare = rhs.compare;
+            copyAux(rhs);
+        }
+
+        return *this;
+    }
+
+    BTree& operator=(BTree&& rhs) {
+        if (this != tiny_stl::addressof(rhs)) {
+            clear();
+            moveAssignAux(rhs);
+        }
+
+        return *this;
+    }
+
+    ~BTree() {
+        clear();
+    }
+
+    allocator_type get_allocator() const noexcept {
+        return allocator_type(this->alloc);
+    }
+
+    key_compare key_comp() const {
+        return this->compare;
+    }
+
+    size_type size() const noexcept {
+        return this->mCount;
+    }
+
+    bool empty() const noexcept {
+        return size() == 0;
+    }
+
+    size_type max_size() const noexcept {
+        return AlNodeTraits::max_size(this->alloc) * Slots;
+    }
+
+    iterator lower_bound(const key_type& key) {
+        return lowBoundAux(key);
+    }
+
+    const_iterator lower_bound(const key_type& key) const {
+        return lowBoundAux(key);
+    }
+
+    template <typename K, typename Cmp = Compare,
+              typename = typename Cmp::is_transparent>
+    iterator lower_bound(const K& key) {
+        return lowBoundAux(key);
+    }
+
+    template <typename K, typename Cmp = Compare,
+              typename = typename Cmp::is_transparent>
+    const_iterator lower_bound(const K& key) const {
+        return lowBoundAux(key);
+    }
+
+    iterator upper_bound(const key_type& key) {
+        return uppBoundAux(key);
+    }
+
+    const_iterator upper_bound(const key_type& key) const {
+        return uppBoundAux(key);
+    }
+
+    template <typename K, typename Cmp = Compare,
+              typename = typename Cmp::is_transparent>
+    iterator upper_bound(const K& key) {
+        return uppBoundAux(key);
+    }
+
+    template <typename K, typename Cmp = Compare,
+              typename = typename Cmp::is_transparent>
+    const_iterator upper_bound(const K& key) const {
+        return uppBoundAux(key);
+    }
+
+    pair<iterator, iterator> equal_range(const key_type& key) {
+        return {lower_bound(key), upper_bound(key)};
+    }
+
+    pair<const_iterator, const_iterator>
+    equal_range(const key_type& key) const {
+        return {lower_bound(key), upper_bound(key)};
+    }
+
+    template <typename K, typename Cmp = Compare,
+              typename = typename Cmp::is_transparent>
+    pair<iterator, iterator> equal_range(const K& key) {
+        return {lower_bound(key), upper_bound(key)};
+    }
+
+    template <typename K, typename Cmp = Compare,
+              typename = typename Cmp::is_transparent>
+    pair<const_iterator, const_iterator> equal_range(const K& key) const {
+        return {lower_bound(key), upper_bound(key)};
+    }
+
+    size_type count(const key_type& key) const {
+        pair<const_iterator, const_iterator> range = equal_range(key);
+        return tiny_stl::distance(range.first, range.second);
+    }
+
+    template <typename K, typename Cmp = Compare,
+              typename = typename Cmp::is_transparent>
+    size_type count(const K& key) const {
+        pair<const_iterator, const_iterator> range = equal_range(key);
+        return tiny_stl::distance(range.first, range.second);
+    }
+
+    iterator find(const key_type& key) {
+        iterator pos = lower_bound(key);
+        return (pos == end() || this->compare(key, get_key(*pos))) ? end()
+                                                                   : pos;
+    }
+
+    const_iterator find(const key_type& key) const {
+        const_iterator pos = lower_bound(key);
+        return (pos == end() || this->compare(key, get_key(*pos))) ? end()
+                                                                   : pos;
+    }
+
+    template <typename K, typename Cmp = Compare,
+              typename = typename Cmp::is_transparent>
+    iterator find(const K& key) {
+        iterator pos = lower_bound(key);
+        return (pos == end() || this->compare(key, get_key(*pos))) ? end()
+                                                                   : pos;
+    }
+
+    template <typename K, typename Cmp = Compare,
+              typename = typename Cmp::is_transparent>
+    const_iterator find(const K& key) const {
+        const_iterator pos = lower_bound(key);
+        return (pos == end() || this->compare(key, get_key(*pos))) ? end()
+                                                                   : pos;
+    }
+
+protected:
+    template <typename Value>
+    pair<iterator, bool> insertUniqueAux(Value&& val) {
+        createRoot();
+        InsertPos pos = uniquePos(get_key(val));
+        if (pos.equal)
+            return {iterator(pos.node, static_cast<int>(pos.position)), false};
+
+        return {insertAt(pos, tiny_stl::forward<Value>(val)), true};
+    }
+
+    template <typename Value>
+    iterator insertHintUniqueAux(const_iterator hint, Value&& val) {
+        if (root == nullptr)
+            return insertUniqueAux(tiny_stl::forward<Value>(val)).first;
+
+        InsertPos pos = hintUniquePos(hint, get_key(val));
+        if (pos.equal)
+            return iterator(pos.node, static_cast<int>(pos.position));
+
+        return insertAt(pos, tiny_stl::forward<Value>(val));
+    }
+
+    template <typename Value>
+    iterator insertEqualAux(Value&& val) {
+        createRoot();
+        return insertAt(equalPos(get_key(val)), tiny_stl::forward<Value>(val));
+    }
+
+    template <typename Value>
+    iterator insertHintEqualAux(const_iterator hint, Value&& val) {
+        if (root == nullptr)
+            return insertEqualAux(tiny_stl::forward<Value>(val));
+
+        return insertAt(hintEqualPos(hint, get_key(val)),
+                        tiny_stl::forward<Value>(val));
+    }
+
+    iterator insert_equal(const value_type& val) {
+        return insertEqualAux(val);
+    }
+
+    iterator insert_equal(value_type&& val) {
+        return insertEqualAux(tiny_stl::move(val));
+    }
+
+    iterator insert_equal(const_iterator hint, const value_type& val) {
+        return insertHintEqualAux(hint, val);
+    }
+
+    iterator insert_equal(const_iterator hint, value_type&& val) {
+        return insertHintEqualAux(hint, tiny_stl::move(val));
+    }
+
+    // sorted input is appended at the last leaf in O(1)
+    template <typename InIter>
+    void insert_equal(InIter first, InIter last) {
+        for (; first != last; ++first)
+            insertHintEqualAux(end(), value_type(*first));
+    }
+
+    pair<iterator, bool> insert_unique(const value_type& val) {
+        return insertUniqueAux(val);
+    }
+
+    pair<iterator, bool> insert_unique(value_type&& val) {
+        return insertUniqueAux(tiny_stl::move(val));
+    }
+
+    iterator insert_unique(const_iterator hint, const value_type& val) {
+        return insertHintUniqueAux(hint, val);
+    }
+
+    iterator insert_unique(const_iterator hint, value_type&& val) {
+        return insertHintUniqueAux(hint, tiny_stl::move(val));
+    }
+
+    template <typename InIter>
+    void insert_unique(InIter first, InIter last) {
+        for (; first != last; ++first)
+            insertHintUniqueAux(end(), value_type(*first));
+    }
+
+    template <typename... Args>
+    iterator emplace_equal(Args&&... args) {
+        return insertEqualAux(value_type(tiny_stl::forward<Args>(args)...));
+    }
+
+    template <typename... Args>
+    iterator emplace_hint_equal(const_iterator hint, Args&&... args) {
+        return insertHintEqualAux(
+            hint, value_type(tiny_stl::forward<Args>(args)...));
+    }
+
+    template <typename... Args>
+    pair<iterator, bool> emplace_unique(Args&&... args) {
+        return insertUniqueAux(value_type(tiny_stl::forward<Args>(args)...));
+    }
+
+    template <typename... Args>
+    iterator emplace_hint_unique(const_iterator hint, Args&&... args) {
+        return insertHintUniqueAux(
+            hint, value_type(tiny_stl::forward<Args>(args)...));
+    }
+
+public:
+    iterator erase(const_iterator pos) {
+        return eraseAux(iterator(pos.node, pos.position));
+    }
+
+    iterator erase(iterator pos) {
+        return eraseAux(pos);
+    }
+
+    // erase invalidates last, count the values instead
+    iterator erase(const_iterator first, const_iterator last) {
+        if (first == begin() && last == end()) {
+            clear();
+            return end();
+        }
+
+        iterator pos(first.node, first.position);
+        for (size_type n = tiny_stl::distance(first, last); n > 0; --n)
+            pos = eraseAux(pos);
+
+        return pos;
+    }
+
+    size_type erase(const key_type& key) {
+        auto range = equal_range(key);
+        const size_type num = tiny_stl::distance(range.first, range.second);
+
+        erase(range.first, range.second);
+
+        return num;
+    }
+
+    iterator begin() noexcept {
+        return beginAux();
+    }
+
+    const_iterator begin() const noexcept {
+        return beginAux();
+    }
+
+    const_iterator cbegin() const noexcept {
+        return begin();
+    }
+
+    iterator end() noexcept {
+        return endAux();
+    }
+
+    const_iterator end() const noexcept {
+        return endAux();
+    }
+
+    const_iterator cend() const noexcept {
+        return end();
+    }
+
+    reverse_iterator rbegin() noexcept {
+        return reverse_iterator(end());
+    }
+
+    const_reverse_iterator rbegin() const noexcept {
+        return const_reverse_iterator(end());
+    }
+
+    const_reverse_iterator crbegin() const noexcept {
+        return rbegin();
+    }
+
+    reverse_iterator rend() noexcept {
+        return reverse_iterator(begin());
+    }
+
+    const_reverse_iterator rend() const noexcept {
+        return const_reverse_iterator(begin());
+    }
+
+    const_reverse_iterator crend() const noexcept {
+        return rend();
+    }
+
+    void clear() noexcept {
+        if (root != nullptr)
+            clearAux(root);
+
+        root = nullptr;
+        leftmost = nullptr;
+        rightmost = nullptr;
+        this->mCount = 0;
+    }
+
+    void swap(BTree& rhs) noexcept(AlTraits::is_always_equal::value&&
+                                       is_nothrow_swappable<Compare>::value) {
+        assert(this->alloc == rhs.alloc);
+
+        if (AlTraits::propagate_on_container_swap::value)
+            tiny_stl::swapAlloc(this->alloc, rhs.alloc);
+
+        moveAux(rhs);
+    }
+}; // BTree
+
+template <typename T, typename Compare, typename Alloc, bool isMap,
+          size_t Slots>
+bool operator==(const BTree<T, Compare, Alloc, isMap, Slots>& lhs,
+                const BTree<T, Compare, Alloc, isMap, Slots>& rhs) {
+    return lhs.size() == rhs.size() &&
+           tiny_stl::equal(lhs.begin(), lhs.end(), rhs.begin());
+}
+
+template <typename T, typename Compare, typename Alloc, bool isMap,
+          size_t Slots>
+bool operator!=(const BTree<T, Compare, Alloc, isMap, Slots>& lhs,
+                const BTree<T, Compare, Alloc, isMap, Slots>& rhs) {
+    return !(lhs == rhs);
+}
+
+template <typename T, typename Compare, typename Alloc, bool isMap,
+          size_t Slots>
+bool operator<(const BTree<T, Compare, Alloc, isMap, Slots>& lhs,
+               const BTree<T, Compare, Alloc, isMap, Slots>& rhs) {
+    return tiny_stl::lexicographical_compare(lhs.begin(), lhs.end(),
+                                             rhs.begin(), rhs.end());
+}
+
+template <typename T, typename Compare, typename Alloc, bool isMap,
+          size_t Slots>
+bool operator>(const BTree<T, Compare, Alloc, isMap, Slots>& lhs,
+               const BTree<T, Compare, Alloc, isMap, Slots>& rhs) {
+    return rhs < lhs;
+}
+
+template <typename T, typename Compare, typename Alloc, bool isMap,
+          size_t Slots>
+bool operator<=(const BTree<T, Compare, Alloc, isMap, Slots>& lhs,
+                const BTree<T, Compare, Alloc, isMap, Slots>& rhs) {
+    return !(rhs < lhs);
+}
+
+template <typename T, typename Compare, typename Alloc, bool isMap,
+          size_t Slots>
+bool operator>=(const BTree<T, Compare, Alloc, isMap, Slots>& lhs,
+                const BTree<T, Compare, Alloc, isMap, Slots>& rhs) {
+    return !(lhs < rhs);
+}
+
+} // namespace tiny_stl
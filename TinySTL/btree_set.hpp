@@ -0,0 +1,337 @@
+// Copyright (C) 2021 syn1w
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include "btree.hpp"
+
+namespace tiny_stl {
+
+// btree_set, a set in a B-tree, Slots values per node
+//
+// insert and erase invalidate all iterators, see btree.hpp
+template <typename Key, typename Compare = tiny_stl::less<Key>,
+          typename Alloc = tiny_stl::allocator<Key>,
+          size_t Slots = btreeDefaultSlots<Key>()>
+class btree_set : public BTree<Key, Compare, Alloc, false, Slots> {
+public:
+    using key_type = Key;
+    using value_type = Key;
+    using size_type = typename Alloc::size_type;
+    using difference_type = typename Alloc::difference_type;
+    using key_compare = Compare;
+    using value_compare = Compare;
+    using allocator_type = Alloc;
+    using reference = value_type&;
+    using const_reference = const value_type&;
+    using AlTraits = allocator_traits<allocator_type>;
+    using pointer = typename AlTraits::pointer;
+    using const_pointer = typename AlTraits::const_pointer;
+    using Base = BTree<Key, Compare, allocator_type, false, Slots>;
+    using AlNode = typename Base::AlNode;
+    using AlNodeTraits = typename Base::AlNodeTraits;
+    using iterator = typename Base::iterator;
+    using const_iterator = typename Base::const_iterator;
+    using reverse_iterator = typename Base::reverse_iterator;
+    using const_reverse_iterator = typename Base::const_reverse_iterator;
+
+public:
+    btree_set() : btree_set(Compare()) {
+    }
+    explicit btree_set(const Compare& cmp, const Alloc& alloc = Alloc())
+        : Base(cmp, alloc) {
+    }
+
+    explicit btree_set(const Alloc& alloc) : Base(key_compare(), alloc) {
+    }
+
+    template <typename InIter>
+    btree_set(InIter first, InIter last, const key_compare& cmp,
+              const Alloc& alloc = Alloc())
+        : Base(cmp, alloc) {
+        this->insert_unique(first, last);
+    }
+
+    template <typename InIter>
+    btree_set(InIter first, InIter last, const Alloc& alloc)
+        : Base(key_compare(), alloc) {
+        this->insert_unique(first, last);
+    }
+
+    // O(n), [first, last) is sorted without equal keys
+    template <typename InIter>
+    btree_set(sorted_unique_t, InIter first, InIter last,
+              const Compare& cmp = Compare(), const Alloc& alloc = Alloc())
+        : Base(cmp, alloc) {
+        this->insert_unique(first, last);
+    }
+
+    btree_set(const btree_set& rhs)
+        : Base(rhs, AlTraits::select_on_container_copy_construction(
+                        rhs.get_allocator())) {
+    }
+
+    btree_set(const btree_set& rhs, const Alloc& alloc) : Base(rhs, alloc) {
+    }
+
+    btree_set(btree_set&& rhs) : Base(tiny_stl::move(rhs)) {
+    }
+
+    btree_set(btree_set&& rhs, const Alloc& alloc)
+        : Base(tiny_stl::move(rhs), alloc) {
+    }
+
+    btree_set(std::initializer_list<value_type> ilist,
+              const Compare& cmp = Compare(), const Alloc& alloc = Alloc())
+        : Base(cmp, alloc) {
+        this->insert_unique(ilist.begin(), ilist.end());
+    }
+
+    btree_set(std::initializer_list<value_type> ilist, const Alloc& alloc)
+        : btree_set(ilist, Compare(), alloc) {
+    }
+
+    btree_set& operator=(const btree_set& rhs) {
+        Base::operator=(rhs);
+        return *this;
+    }
+
+    btree_set& operator=(btree_set&& rhs) {
+        Base::operator=(tiny_stl::move(rhs));
+        return *this;
+    }
+
+    btree_set& operator=(std::initializer_list<value_type> ilist) {
+        btree_set tmp(ilist);
+        this->swap(tmp);
+        return *this;
+    }
+
+    pair<iterator, bool> insert(const value_type& val) {
+        return this->insert_unique(val);
+    }
+
+    pair<iterator, bool> insert(value_type&& val) {
+        return this->insert_unique(tiny_stl::move(val));
+    }
+
+    // O(1) if val goes right before hint
+    iterator insert(const_iterator hint, const value_type& val) {
+        return this->insert_unique(hint, val);
+    }
+
+    iterator insert(const_iterator hint, value_type&& val) {
+        return this->insert_unique(hint, tiny_stl::move(val));
+    }
+
+    template <typename InIter>
+    void insert(InIter first, InIter last) {
+        this->insert_unique(first, last);
+    }
+
+    void insert(std::initializer_list<value_type> ilist) {
+        this->insert_unique(ilist.begin(), ilist.end());
+    }
+
+    template <typename... Args>
+    pair<iterator, bool> emplace(Args&&... args) {
+        return this->emplace_unique(tiny_stl::forward<Args>(args)...);
+    }
+
+    template <typename... Args>
+    iterator emplace_hint(const_iterator hint, Args&&... args) {
+        return this->emplace_hint_unique(hint,
+                                         tiny_stl::forward<Args>(args)...);
+    }
+
+    void swap(btree_set& rhs) {
+        Base::swap(rhs);
+    }
+
+    key_compare key_comp() const {
+        return Base::key_comp();
+    }
+
+    value_compare value_comp() const {
+        return value_compare{};
+    }
+}; // btree_set
+
+template <typename Key, typename Compare, typename Alloc, size_t Slots>
+inline void swap(btree_set<Key, Compare, Alloc, Slots>& lhs,
+                 btree_set<Key, Compare, Alloc, Slots>& rhs) noexcept(
+    noexcept(lhs.swap(rhs))) {
+    lhs.swap(rhs);
+}
+
+// btree_multiset
+template <typename Key, typename Compare = tiny_stl::less<Key>,
+          typename Alloc = tiny_stl::allocator<Key>,
+          size_t Slots = btreeDefaultSlots<Key>()>
+class btree_multiset : public BTree<Key, Compare, Alloc, false, Slots> {
+public:
+    using key_type = Key;
+    using value_type = Key;
+    using size_type = size_t;
+    using difference_type = ptrdiff_t;
+    using key_compare = Compare;
+    using value_compare = Compare;
+    using allocator_type = Alloc;
+    using reference = value_type&;
+    using const_reference = const value_type&;
+    using AlTraits = allocator_traits<allocator_type>;
+    using pointer = typename AlTraits::pointer;
+    using const_pointer = typename AlTraits::const_pointer;
+    using Base = BTree<Key, Compare, allocator_type, false, Slots>;
+    using AlNode = typename Base::AlNode;
+    using AlNodeTraits = typename Base::AlNodeTraits;
+    using iterator = typename Base::iterator;
+    using const_iterator = typename Base::const_iterator;
+    using reverse_iterator = typename Base::reverse_iterator;
+    using const_reverse_iterator = typename Base::const_reverse_iterator;
+
+public:
+    btree_multiset() : btree_multiset(Compare()) {
+    }
+    explicit btree_multiset(const Compare& cmp, const Alloc& alloc = Alloc())
+        : Base(cmp, alloc) {
+    }
+
+    explicit btree_multiset(const Alloc& alloc) : Base(key_compare(), alloc) {
+    }
+
+    template <typename InIter>
+    btree_multiset(InIter first, InIter last, const key_compare& cmp,
+                   const Alloc& alloc = Alloc())
+        : Base(cmp, alloc) {
+        this->insert_equal(first, last);
+    }
+
+    template <typename InIter>
+    btree_multiset(InIter first, InIter last, const Alloc& alloc)
+        : Base(key_compare(), alloc) {
+        this->insert_equal(first, last);
+    }
+
+    // O(n), [first, last) is sorted
+    template <typename InIter>
+    btree_multiset(sorted_equivalent_t, InIter first, InIter last,
+                   const Compare& cmp = Compare(), const Alloc& alloc = Alloc())
+        : Base(cmp, alloc) {
+        this->insert_equal(first, last);
+    }
+
+    btree_multiset(const btree_multiset& rhs)
+        : Base(rhs, AlTraits::select_on_container_copy_construction(
+                        rhs.get_allocator())) {
+    }
+
+    btree_multiset(const btree_multiset& rhs, const Alloc& alloc)
+        : Base(rhs, alloc) {
+    }
+
+    btree_multiset(btree_multiset&& rhs) : Base(tiny_stl::move(rhs)) {
+    }
+
+    btree_multiset(btree_multiset&& rhs, const Alloc& alloc)
+        : Base(tiny_stl::move(rhs), alloc) {
+    }
+
+    btree_multiset(std::initializer_list<value_type> ilist,
+                   const Compare& cmp = Compare(), const Alloc& alloc = Alloc())
+        : Base(cmp, alloc) {
+        this->insert_equal(ilist.begin(), ilist.end());
+    }
+
+    btree_multiset(std::initializer_list<value_type> ilist,
+                   const Alloc& alloc)
+        : btree_multiset(ilist, Compare(), alloc) {
+    }
+
+    btree_multiset& operator=(const btree_multiset& rhs) {
+        Base::operator=(rhs);
+        return *this;
+    }
+
+    btree_multiset& operator=(btree_multiset&& rhs) {
+        Base::operator=(tiny_stl::move(rhs));
+        return *this;
+    }
+
+    btree_multiset& operator=(std::initializer_list<value_type> ilist) {
+        btree_multiset tmp(ilist);
+        this->swap(tmp);
+        return *this;
+    }
+
+    iterator insert(const value_type& val) {
+        return this->insert_equal(val);
+    }
+
+    iterator insert(value_type&& val) {
+        return this->insert_equal(tiny_stl::move(val));
+    }
+
+    // O(1) if val goes right before hint
+    iterator insert(const_iterator hint, const value_type& val) {
+        return this->insert_equal(hint, val);
+    }
+
+    iterator insert(const_iterator hint, value_type&& val) {
+        return this->insert_equal(hint, tiny_stl::move(val));
+    }
+
+    template <typename InIter>
+    void insert(InIter first, InIter last) {
+        this->insert_equal(first, last);
+    }
+
+    void insert(std::initializer_list<value_type> ilist) {
+        this->insert_equal(ilist.begin(), ilist.end());
+    }
+
+    template <typename... Args>
+    iterator emplace(Args&&... args) {
+        return this->emplace_equal(tiny_stl::forward<Args>(args)...);
+    }
+
+    template <typename... Args>
+    iterator emplace_hint(const_iterator hint, Args&&... args) {
+        return this->emplace_hint_equal(hint,
+                                        tiny_stl::forward<Args>(args)...);
+    }
+
+    void swap(btree_multiset& rhs) {
+        Base::swap(rhs);
+    }
+
+    key_compare key_comp() const {
+        return Base::key_comp();
+    }
+
+    value_compare value_comp() const {
+        return value_compare{};
+    }
+}; // btree_multiset
+
+template <typename Key, typename Compare, typename Alloc, size_t Slots>
+inline void swap(btree_multiset<Key, Compare, Alloc, Slots>& lhs,
+                 btree_multiset<Key, Compare, Alloc, Slots>& rhs) noexcept(
+    noexcept(lhs.swap(rhs))) {
+    lhs.swap(rhs);
+}
+
+namespace pmr {
+
+template <typename Key, typename Compare = tiny_stl::less<Key>>
+using btree_set =
+    tiny_stl::btree_set<Key, Compare, polymorphic_allocator<Key>>;
+
+template <typename Key, typename Compare = tiny_stl::less<Key>>
+using btree_multiset =
+    tiny_stl::btree_multiset<Key, Compare, polymorphic_allocator<Key>>;
+
+} // namespace pmr
+
+} // namespace tiny_stl
\ No newline at end of file
@@ -0,0 +1,601 @@
+// Copyright (C) 2021 syn1w
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iosfwd>
+
+#include "type_traits.hpp"
+
+// Block backend, define TINY_STL_NO_SIMD to force the portable one
+#if !defined(TINY_STL_NO_SIMD) && defined(__AVX2__)
+#define TINY_STL_SEARCH_AVX2 1
+#include <immintrin.h>
+#elif !defined(TINY_STL_NO_SIMD) &&                                            \
+    (defined(__SSE2__) || defined(_M_X64) ||                                   \
+     (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define TINY_STL_SEARCH_SSE2 1
+#include <emmintrin.h>
+#elif !defined(TINY_STL_NO_SIMD) && defined(__ARM_NEON)
+#define TINY_STL_SEARCH_NEON 1
+#include <arm_neon.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace tiny_stl {
+
+// Character and substring search over bytes
+//
+// A block of kSearchBlockWidth bytes is compared with one character at
+// once (AVX2, SSE2 or NEON) and the matched bytes come out as a bit mask.
+//
+// searchChar, searchCharBack:     the first / last byte equal to ch, the
+//                                 forward one is memchr
+// searchCharOf, searchCharOfBack: the first / last byte in a set, a small
+//                                 set is matched a character at a time,
+//                                 a larger one through a 256-bit table
+// searchString, searchStringBack: a start p is a candidate if p[0] is the
+//                                 first character of the needle and
+//                                 p[m - 1] is the last one, a block of
+//                                 candidates is filtered at once and only
+//                                 the survivors are compared by memcmp
+//
+// They return nullptr if nothing matches. The string classes use them for
+// a char-sized CharT with std::char_traits, see UseCharSearch.
+
+inline size_t searchCountTrailingZeros(uint64_t x) noexcept {
+    assert(x != 0);
+#if defined(_MSC_VER) && defined(_WIN64)
+    unsigned long idx;
+    _BitScanForward64(&idx, x);
+    return idx;
+#elif defined(_MSC_VER)
+    unsigned long idx;
+    if (_BitScanForward(&idx, static_cast<unsigned long>(x)))
+        return idx;
+    _BitScanForward(&idx, static_cast<unsigned long>(x >> 32));
+    return idx + 32;
+#else
+    return static_cast<size_t>(__builtin_ctzll(x));
+#endif
+}
+
+// the index of the highest set bit
+inline size_t searchHighestBit(uint64_t x) noexcept {
+    assert(x != 0);
+#if defined(_MSC_VER) && defined(_WIN64)
+    unsigned long idx;
+    _BitScanReverse64(&idx, x);
+    return idx;
+#elif defined(_MSC_VER)
+    unsigned long idx;
+    if (_BitScanReverse(&idx, static_cast<unsigned long>(x >> 32)))
+        return idx + 32;
+    _BitScanReverse(&idx, static_cast<unsigned long>(x));
+    return idx;
+#else
+    return static_cast<size_t>(63 - __builtin_clzll(x));
+#endif
+}
+
+// The matched bytes of a block, every byte takes (1 << Shift) bits and at
+// most one of them is set
+template <int Shift>
+class SearchMask {
+private:
+    uint64_t mMask;
+
+public:
+    explicit SearchMask(uint64_t mask) : mMask(mask) {
+    }
+
+    explicit operator bool() const noexcept {
+        return mMask != 0;
+    }
+
+    size_t lowest() const noexcept {
+        return searchCountTrailingZeros(mMask) >> Shift;
+    }
+
+    size_t highest() const noexcept {
+        return searchHighestBit(mMask) >> Shift;
+    }
+
+    void dropLowest() noexcept {
+        mMask &= mMask - 1;
+    }
+
+    void dropHighest() noexcept {
+        mMask &= ~(uint64_t{1} << searchHighestBit(mMask));
+    }
+
+    SearchMask& operator&=(SearchMask rhs) noexcept {
+        mMask &= rhs.mMask;
+        return *this;
+    }
+
+    SearchMask& operator|=(SearchMask rhs) noexcept {
+        mMask |= rhs.mMask;
+        return *this;
+    }
+};
+
+#if defined(TINY_STL_SEARCH_AVX2)
+
+class SearchBlockAvx2 {
+public:
+    using Mask = SearchMask<0>;
+    static const size_t kWidth = 32;
+
+private:
+    __m256i mData;
+
+public:
+    explicit SearchBlockAvx2(const char* pos) noexcept
+        : mData(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(pos))) {
+    }
+
+    Mask match(char ch) const noexcept {
+        const __m256i cmp = _mm256_cmpeq_epi8(_mm256_set1_epi8(ch), mData);
+        return Mask(static_cast<uint32_t>(_mm256_movemask_epi8(cmp)));
+    }
+};
+
+using SearchBlock = SearchBlockAvx2;
+
+#elif defined(TINY_STL_SEARCH_SSE2)
+
+class SearchBlockSse2 {
+public:
+    using Mask = SearchMask<0>;
+    static const size_t kWidth = 16;
+
+private:
+    __m128i mData;
+
+public:
+    explicit SearchBlockSse2(const char* pos) noexcept
+        : mData(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pos))) {
+    }
+
+    Mask match(char ch) const noexcept {
+        const __m128i cmp = _mm_cmpeq_epi8(_mm_set1_epi8(ch), mData);
+        return Mask(static_cast<unsigned>(_mm_movemask_epi8(cmp)));
+    }
+};
+
+using SearchBlock = SearchBlockSse2;
+
+#elif defined(TINY_STL_SEARCH_NEON)
+
+class SearchBlockNeon {
+public:
+    // no movemask, narrow every byte of the compare result to a nibble
+    using Mask = SearchMask<2>;
+    static const size_t kWidth = 16;
+
+private:
+    uint8x16_t mData;
+
+public:
+    explicit SearchBlockNeon(const char* pos) noexcept
+        : mData(vld1q_u8(reinterpret_cast<const uint8_t*>(pos))) {
+    }
+
+    Mask match(char ch) const noexcept {
+        const uint8x16_t cmp =
+            vceqq_u8(vdupq_n_u8(static_cast<uint8_t>(ch)), mData);
+        const uint8x8_t nibbles = vshrn_n_u16(vreinterpretq_u16_u8(cmp), 4);
+        const uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(nibbles), 0);
+        return Mask(mask & 0x8888888888888888ULL);
+    }
+};
+
+using SearchBlock = SearchBlockNeon;
+
+#else
+
+// scalar fallback, one byte at a time
+class SearchBlockPortable {
+public:
+    using Mask = SearchMask<0>;
+    static const size_t kWidth = 16;
+
+private:
+    const char* mData;
+
+public:
+    explicit SearchBlockPortable(const char* pos) noexcept : mData(pos) {
+    }
+
+    Mask match(char ch) const noexcept {
+        uint64_t mask = 0;
+        for (size_t i = 0; i != kWidth; ++i) {
+            if (mData[i] == ch)
+                mask |= uint64_t{1} << i;
+        }
+        return Mask(mask);
+    }
+};
+
+using SearchBlock = SearchBlockPortable;
+
+#endif
+
+static const size_t kSearchBlockWidth = SearchBlock::kWidth;
+
+// a set larger than this is matched through SearchCharTable
+static const size_t kSearchSmallSet = 16;
+
+class SearchCharTable {
+private:
+    unsigned char mBits[32];
+
+public:
+    SearchCharTable(const char* set, size_t n) noexcept : mBits() {
+        for (size_t i = 0; i != n; ++i) {
+            const unsigned char c = static_cast<unsigned char>(set[i]);
+            mBits[c >> 3] |= static_cast<unsigned char>(1U << (c & 7));
+        }
+    }
+
+    bool contains(char ch) const noexcept {
+        const unsigned char c = static_cast<unsigned char>(ch);
+        return (mBits[c >> 3] >> (c & 7)) & 1U;
+    }
+};
+
+inline bool searchSetContains(const char* set, size_t n, char ch) noexcept {
+    for (size_t i = 0; i != n; ++i) {
+        if (set[i] == ch)
+            return true;
+    }
+    return false;
+}
+
+inline SearchBlock::Mask searchMatchAny(const SearchBlock& block,
+                                        const char* set, size_t n) noexcept {
+    SearchBlock::Mask mask = block.match(set[0]);
+    for (size_t i = 1; i != n; ++i)
+        mask |= block.match(set[i]);
+    return mask;
+}
+
+// memchr is already vectorized by the C library
+inline const char* searchChar(const char* first, const char* last,
+                              char ch) noexcept {
+    if (first == last)
+        return nullptr;
+
+    return static_cast<const char*>(
+        memchr(first, static_cast<unsigned char>(ch), last - first));
+}
+
+inline const char* searchCharBack(const char* first, const char* last,
+                                  char ch) noexcept {
+    while (static_cast<size_t>(last - first) >= kSearchBlockWidth) {
+        last -= kSearchBlockWidth;
+        const SearchBlock::Mask mask = SearchBlock(last).match(ch);
+        if (mask)
+            return last + mask.highest();
+    }
+
+    while (last != first) {
+        if (*--last == ch)
+            return last;
+    }
+    return nullptr;
+}
+
+inline const char* searchCharOf(const char* first, const char* last,
+                                const char* set, size_t n) noexcept {
+    if (n == 0)
+        return nullptr;
+    if (n == 1)
+        return searchChar(first, last, *set);
+
+    if (n > kSearchSmallSet) {
+        const SearchCharTable table(set, n);
+        for (; first != last; ++first) {
+            if (table.contains(*first))
+                return first;
+        }
+        return nullptr;
+    }
+
+    for (; static_cast<size_t>(last - first) >= kSearchBlockWidth;
+         first += kSearchBlockWidth) {
+        const SearchBlock::Mask mask =
+            searchMatchAny(SearchBlock(first), set, n);
+        if (mask)
+            return first + mask.lowest();
+    }
+
+    for (; first != last; ++first) {
+        if (searchSetContains(set, n, *first))
+            return first;
+    }
+    return nullptr;
+}
+
+inline const char* searchCharOfBack(const char* first, const char* last,
+                                    const char* set, size_t n) noexcept {
+    if (n == 0)
+        return nullptr;
+    if (n == 1)
+        return searchCharBack(first, last, *set);
+
+    if (n > kSearchSmallSet) {
+        const SearchCharTable table(set, n);
+        while (last != first) {
+            if (table.contains(*--last))
+                return last;
+        }
+        return nullptr;
+    }
+
+    while (static_cast<size_t>(last - first) >= kSearchBlockWidth) {
+        last -= kSearchBlockWidth;
+        const SearchBlock::Mask mask =
+            searchMatchAny(SearchBlock(last), set, n);
+        if (mask)
+            return last + mask.highest();
+    }
+
+    while (last != first) {
+        if (searchSetContains(set, n, *--last))
+            return last;
+    }
+    return nullptr;
+}
+
+// the needle is [s, s + m)
+inline const char* searchString(const char* first, const char* last,
+                                const char* s, size_t m) noexcept {
+    if (m == 0)
+        return first;
+    if (static_cast<size_t>(last - first) < m)
+        return nullptr;
+    if (m == 1)
+        return searchChar(first, last, *s);
+
+    const char head = s[0];
+    const char tail = s[m - 1];
+    const char* const end = last - (m - 1); // the candidates are [first, end)
+
+    for (; static_cast<size_t>(end - first) >= kSearchBlockWidth;
+         first += kSearchBlockWidth) {
+        SearchBlock::Mask mask = SearchBlock(first).match(head);
+        mask &= SearchBlock(first + (m - 1)).match(tail);
+        for (; mask; mask.dropLowest()) {
+            const char* const p = first + mask.lowest();
+            if (memcmp(p + 1, s + 1, m - 2) == 0)
+                return p;
+        }
+    }
+
+    for (; first != end; ++first) {
+        if (*first == head && first[m - 1] == tail &&
+            memcmp(first + 1, s + 1, m - 2) == 0)
+            return first;
+    }
+    return nullptr;
+}
+
+inline const char* searchStringBack(const char* first, const char* last,
+                                    const char* s, size_t m) noexcept {
+    if (static_cast<size_t>(last - first) < m)
+        return nullptr;
+    if (m == 0)
+        return last;
+    if (m == 1)
+        return searchCharBack(first, last, *s);
+
+    const char head = s[0];
+    const char tail = s[m - 1];
+    const char* end = last - (m - 1);
+
+    while (static_cast<size_t>(end - first) >= kSearchBlockWidth) {
+        end -= kSearchBlockWidth;
+        SearchBlock::Mask mask = SearchBlock(end).match(head);
+        mask &= SearchBlock(end + (m - 1)).match(tail);
+        for (; mask; mask.dropHighest()) {
+            const char* const p = end + mask.highest();
+            if (memcmp(p + 1, s + 1, m - 2) == 0)
+                return p;
+        }
+    }
+
+    while (end != first) {
+        --end;
+        if (*end == head && end[m - 1] == tail &&
+            memcmp(end + 1, s + 1, m - 2) == 0)
+            return end;
+    }
+    return nullptr;
+}
+
+// CharT is a byte compared as a byte
+template <typename CharT, typename Traits>
+struct UseCharSearch
+    : bool_constant<sizeof(CharT) == 1 && is_integral<CharT>::value &&
+                    is_same<Traits, std::char_traits<CharT>>::value> {};
+
+// the same searches over [first, last) of a string, the byte kernels for
+// UseCharSearch and Traits::eq otherwise
+
+template <typename CharT>
+inline const char* searchBytes(const CharT* p) noexcept {
+    return reinterpret_cast<const char*>(p);
+}
+
+template <typename Traits, typename CharT>
+inline const CharT* traitsFindAux(const CharT* first, const CharT* last,
+                                  CharT ch, true_type) noexcept {
+    return reinterpret_cast<const CharT*>(searchChar(
+        searchBytes(first), searchBytes(last), static_cast<char>(ch)));
+}
+
+template <typename Traits, typename CharT>
+inline const CharT* traitsFindAux(const CharT* first, const CharT* last,
+                                  CharT ch, false_type) noexcept {
+    for (; first != last; ++first) {
+        if (Traits::eq(*first, ch))
+            return first;
+    }
+    return nullptr;
+}
+
+template <typename Traits, typename CharT>
+inline const CharT* traitsFind(const CharT* first, const CharT* last,
+                               CharT ch) noexcept {
+    return traitsFindAux<Traits>(first, last, ch,
+                                 UseCharSearch<CharT, Traits>{});
+}
+
+template <typename Traits, typename CharT>
+inline const CharT* traitsRfindAux(const CharT* first, const CharT* last,
+                                   CharT ch, true_type) noexcept {
+    return reinterpret_cast<const CharT*>(searchCharBack(
+        searchBytes(first), searchBytes(last), static_cast<char>(ch)));
+}
+
+template <typename Traits, typename CharT>
+inline const CharT* traitsRfindAux(const CharT* first, const CharT* last,
+                                   CharT ch, false_type) noexcept {
+    while (last != first) {
+        if (Traits::eq(*--last, ch))
+            return last;
+    }
+    return nullptr;
+}
+
+template <typename Traits, typename CharT>
+inline const CharT* traitsRfind(const CharT* first, const CharT* last,
+                                CharT ch) noexcept {
+    return traitsRfindAux<Traits>(first, last, ch,
+                                  UseCharSearch<CharT, Traits>{});
+}
+
+template <typename Traits, typename CharT>
+inline const CharT* traitsFindAux(const CharT* first, const CharT* last,
+                                  const CharT* s, size_t m,
+                                  true_type) noexcept {
+    return reinterpret_cast<const CharT*>(searchString(
+        searchBytes(first), searchBytes(last), searchBytes(s), m));
+}
+
+template <typename Traits, typename CharT>
+inline const CharT* traitsFindAux(const CharT* first, const CharT* last,
+                                  const CharT* s, size_t m,
+                                  false_type) noexcept {
+    for (; static_cast<size_t>(last - first) >= m; ++first) {
+        if (Traits::compare(first, s, m) == 0)
+            return first;
+    }
+    return nullptr;
+}
+
+// the first [p, p + m) in [first, last) equal to [s, s + m)
+template <typename Traits, typename CharT>
+inline const CharT* traitsFind(const CharT* first, const CharT* last,
+                               const CharT* s, size_t m) noexcept {
+    return traitsFindAux<Traits>(first, last, s, m,
+                                 UseCharSearch<CharT, Traits>{});
+}
+
+template <typename Traits, typename CharT>
+inline const CharT* traitsRfindAux(const CharT* first, const CharT* last,
+                                   const CharT* s, size_t m,
+                                   true_type) noexcept {
+    return reinterpret_cast<const CharT*>(searchStringBack(
+        searchBytes(first), searchBytes(last), searchBytes(s), m));
+}
+
+template <typename Traits, typename CharT>
+inline const CharT* traitsRfindAux(const CharT* first, const CharT* last,
+                                   const CharT* s, size_t m,
+                                   false_type) noexcept {
+    if (static_cast<size_t>(last - first) < m)
+        return nullptr;
+
+    for (const CharT* p = last - m;; --p) {
+        if (Traits::compare(p, s, m) == 0)
+            return p;
+        if (p == first)
+            return nullptr;
+    }
+}
+
+// the last [p, p + m) in [first, last) equal to [s, s + m)
+template <typename Traits, typename CharT>
+inline const CharT* traitsRfind(const CharT* first, const CharT* last,
+                                const CharT* s, size_t m) noexcept {
+    return traitsRfindAux<Traits>(first, last, s, m,
+                                  UseCharSearch<CharT, Traits>{});
+}
+
+template <typename Traits, typename CharT>
+inline const CharT* traitsFindOfAux(const CharT* first, const CharT* last,
+                                    const CharT* set, size_t n,
+                                    true_type) noexcept {
+    return reinterpret_cast<const CharT*>(searchCharOf(
+        searchBytes(first), searchBytes(last), searchBytes(set), n));
+}
+
+template <typename Traits, typename CharT>
+inline const CharT* traitsFindOfAux(const CharT* first, const CharT* last,
+                                    const CharT* set, size_t n,
+                                    false_type) noexcept {
+    for (; first != last; ++first) {
+        if (n != 0 && Traits::find(set, n, *first) != nullptr)
+            return first;
+    }
+    return nullptr;
+}
+
+// the first character in [first, last) that is in [set, set + n)
+template <typename Traits, typename CharT>
+inline const CharT* traitsFindOf(const CharT* first, const CharT* last,
+                                 const CharT* set, size_t n) noexcept {
+    return traitsFindOfAux<Traits>(first, last, set, n,
+                                   UseCharSearch<CharT, Traits>{});
+}
+
+template <typename Traits, typename CharT>
+inline const CharT* traitsRfindOfAux(const CharT* first, const CharT* last,
+                                     const CharT* set, size_t n,
+                                     true_type) noexcept {
+    return reinterpret_cast<const CharT*>(searchCharOfBack(
+        searchBytes(first), searchBytes(last), searchBytes(set), n));
+}
+
+template <typename Traits, typename CharT>
+inline const CharT* traitsRfindOfAux(const CharT* first, const CharT* last,
+                                     const CharT* set, size_t n,
+                                     false_type) noexcept {
+    while (last != first) {
+        --last;
+        if (n != 0 && Traits::find(set, n, *last) != nullptr)
+            return last;
+    }
+    return nullptr;
+}
+
+// the last character in [first, last) that is in [set, set + n)
+template <typename Traits, typename CharT>
+inline const CharT* traitsRfindOf(const CharT* first, const CharT* last,
+                                  const CharT* set, size_t n) noexcept {
+    return traitsRfindOfAux<Traits>(first, last, set, n,
+                                    UseCharSearch<CharT, Traits>{});
+}
+
+} // namespace tiny_stl
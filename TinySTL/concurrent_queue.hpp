@@ -0,0 +1,391 @@
+// Copyright (C) 2021 syn1w
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+#include "memory.hpp"
+
+namespace tiny_stl {
+
+// bounded lock-free queues over a ring of 2^k slots
+//
+// spsc_queue: one producer thread and one consumer thread, each side owns
+// one index and caches the other one, a push or pop touches the shared
+// line only when the cache says full or empty.
+//
+// mpmc_queue: any number of threads, every cell has a sequence number
+// telling which round of the ring may use it next (D. Vyukov's bounded
+// queue). A push claims a cell by a CAS on the enqueue index, fills it
+// and publishes it through the sequence, a pop does the same on the
+// dequeue side.
+//
+// The indices written by different threads live on different cache
+// lines. try_push_n / try_pop_n move up to n elements with one index
+// update and return the number moved.
+
+namespace {
+
+// a power of 2, at least 2
+inline size_t ringCapacity(size_t n) {
+    size_t cap = 2;
+    while (cap < n)
+        cap <<= 1;
+
+    return cap;
+}
+
+} // namespace
+
+template <typename T, typename Alloc = allocator<T>>
+class spsc_queue {
+public:
+    using value_type = T;
+    using allocator_type = Alloc;
+    using size_type = size_t;
+
+private:
+    using AlTraits = allocator_traits<Alloc>;
+
+    // written by the consumer
+    alignas(kCacheLineSize) std::atomic<size_t> head;
+    size_t cachedTail;
+
+    // written by the producer
+    alignas(kCacheLineSize) std::atomic<size_t> tail;
+    size_t cachedHead;
+
+    // read only
+    alignas(kCacheLineSize) T* slots;
+    size_t mask;
+    Alloc alloc;
+
+private:
+    // free slots seen by the producer, reload head if less than n
+    size_t freeSlots(size_t t, size_t n) {
+        size_t free = mask + 1 - (t - cachedHead);
+        if (free < n) {
+            cachedHead = head.load(std::memory_order_acquire);
+            free = mask + 1 - (t - cachedHead);
+        }
+
+        return free;
+    }
+
+    // elements seen by the consumer, reload tail if less than n
+    size_t readySlots(size_t h, size_t n) {
+        size_t ready = cachedTail - h;
+        if (ready < n) {
+            cachedTail = tail.load(std::memory_order_acquire);
+            ready = cachedTail - h;
+        }
+
+        return ready;
+    }
+
+public:
+    // capacity is rounded up to a power of 2
+    explicit spsc_queue(size_type capacity, const Alloc& al = Alloc())
+        : head(0), cachedTail(0), tail(0), cachedHead(0), slots(nullptr),
+          mask(ringCapacity(capacity) - 1), alloc(al) {
+        slots = alloc.allocate(mask + 1);
+    }
+
+    spsc_queue(const spsc_queue&) = delete;
+    spsc_queue& operator=(const spsc_queue&) = delete;
+
+    // no thread uses the queue any more
+    ~spsc_queue() {
+        const size_t t = tail.load(std::memory_order_relaxed);
+        for (size_t h = head.load(std::memory_order_relaxed); h != t; ++h)
+            AlTraits::destroy(alloc, slots + (h & mask));
+        alloc.deallocate(slots, mask + 1);
+    }
+
+    // producer
+    template <typename... Args>
+    bool try_emplace(Args&&... args) {
+        const size_t t = tail.load(std::memory_order_relaxed);
+        if (freeSlots(t, 1) == 0)
+            return false;
+
+        AlTraits::construct(alloc, slots + (t & mask),
+                            tiny_stl::forward<Args>(args)...);
+        tail.store(t + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    bool try_push(const T& val) {
+        return try_emplace(val);
+    }
+
+    bool try_push(T&& val) {
+        return try_emplace(tiny_stl::move(val));
+    }
+
+    // producer, copy up to n elements of [first, ...), the ones copied
+    // before an exception are pushed
+    template <typename InIter>
+    size_type try_push_n(InIter first, size_type n) {
+        const size_t t = tail.load(std::memory_order_relaxed);
+        n = tiny_stl::min(n, freeSlots(t, n));
+
+        size_type i = 0;
+        try {
+            for (; i < n; ++i, ++first)
+                AlTraits::construct(alloc, slots + ((t + i) & mask), *first);
+        } catch (...) {
+            tail.store(t + i, std::memory_order_release);
+            throw;
+        }
+        tail.store(t + n, std::memory_order_release);
+
+        return n;
+    }
+
+    // consumer
+    bool try_pop(T& out) {
+        const size_t h = head.load(std::memory_order_relaxed);
+        if (readySlots(h, 1) == 0)
+            return false;
+
+        T* slot = slots + (h & mask);
+        out = tiny_stl::move(*slot);
+        AlTraits::destroy(alloc, slot);
+        head.store(h + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    // consumer, move up to n elements to [out, ...)
+    template <typename OutIter>
+    size_type try_pop_n(OutIter out, size_type n) {
+        const size_t h = head.load(std::memory_order_relaxed);
+        n = tiny_stl::min(n, readySlots(h, n));
+
+        size_type i = 0;
+        try {
+            for (; i < n; ++i, ++out) {
+                T* slot = slots + ((h + i) & mask);
+                *out = tiny_stl::move(*slot);
+                AlTraits::destroy(alloc, slot);
+            }
+        } catch (...) {
+            head.store(h + i, std::memory_order_release);
+            throw;
+        }
+        head.store(h + n, std::memory_order_release);
+
+        return n;
+    }
+
+    // exact only on the producer or the consumer thread
+    size_type size() const noexcept {
+        return tail.load(std::memory_order_acquire) -
+               head.load(std::memory_order_acquire);
+    }
+
+    bool empty() const noexcept {
+        return size() == 0;
+    }
+
+    size_type capacity() const noexcept {
+        return mask + 1;
+    }
+}; // class spsc_queue
+
+// A claimed cell must be filled and a ready cell must be emptied, the
+// other threads wait for it. try_push and try_emplace build the value
+// before claiming a cell, from then on T is moved, try_push_n copies
+// into the claimed cells and try_pop_n assigns from them. Those steps
+// must not throw, std::terminate is called if they do.
+template <typename T, typename Alloc = allocator<T>>
+class mpmc_queue {
+public:
+    using value_type = T;
+    using allocator_type = Alloc;
+    using size_type = size_t;
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        std::aligned_union_t<1, T> storage;
+
+        T* value() noexcept {
+            return reinterpret_cast<T*>(&storage);
+        }
+    };
+
+    using AlTraits = allocator_traits<Alloc>;
+    using AlCell = typename AlTraits::template rebind_alloc<Cell>;
+
+    alignas(kCacheLineSize) std::atomic<size_t> enqueuePos;
+    alignas(kCacheLineSize) std::atomic<size_t> dequeuePos;
+
+    // read only
+    alignas(kCacheLineSize) Cell* cells;
+    size_t mask;
+    Alloc alloc;
+
+private:
+    static ptrdiff_t diff(size_t seq, size_t pos) noexcept {
+        return static_cast<ptrdiff_t>(seq - pos);
+    }
+
+    // claim up to n cells whose sequence is pos + i + ready at
+    // [pos, pos + n), ready is 0 for a push and 1 for a pop, return the
+    // number claimed, pos is the first one
+    size_t claim(std::atomic<size_t>& index, size_t ready, size_t n,
+                 size_t& pos) {
+        pos = index.load(std::memory_order_relaxed);
+        while (true) {
+            size_t k = 0;
+            for (; k < n; ++k) {
+                const size_t seq =
+                    cells[(pos + k) & mask].sequence.load(
+                        std::memory_order_acquire);
+                if (seq != pos + k + ready)
+                    break;
+            }
+
+            if (k == 0) {
+                const size_t seq =
+                    cells[pos & mask].sequence.load(std::memory_order_acquire);
+                if (diff(seq, pos + ready) < 0)
+                    return 0; // full or empty
+
+                // another thread took pos
+                pos = index.load(std::memory_order_relaxed);
+                continue;
+            }
+
+            if (index.compare_exchange_weak(pos, pos + k,
+                                            std::memory_order_relaxed))
+                return k;
+        }
+    }
+
+    template <typename... Args>
+    void fill(size_t pos, Args&&... args) noexcept {
+        Cell& cell = cells[pos & mask];
+        AlTraits::construct(alloc, cell.value(),
+                            tiny_stl::forward<Args>(args)...);
+        cell.sequence.store(pos + 1, std::memory_order_release);
+    }
+
+    template <typename Out>
+    void drain(size_t pos, Out& out) noexcept {
+        Cell& cell = cells[pos & mask];
+        out = tiny_stl::move(*cell.value());
+        AlTraits::destroy(alloc, cell.value());
+        cell.sequence.store(pos + mask + 1, std::memory_order_release);
+    }
+
+public:
+    // capacity is rounded up to a power of 2
+    explicit mpmc_queue(size_type capacity, const Alloc& al = Alloc())
+        : enqueuePos(0), dequeuePos(0), cells(nullptr),
+          mask(ringCapacity(capacity) - 1), alloc(al) {
+        AlCell al_cell(alloc);
+        cells = al_cell.allocate(mask + 1);
+        for (size_t i = 0; i <= mask; ++i)
+            ::new (static_cast<void*>(&cells[i].sequence))
+                std::atomic<size_t>(i);
+    }
+
+    mpmc_queue(const mpmc_queue&) = delete;
+    mpmc_queue& operator=(const mpmc_queue&) = delete;
+
+    // no thread uses the queue any more
+    ~mpmc_queue() {
+        const size_t last = enqueuePos.load(std::memory_order_relaxed);
+        for (size_t pos = dequeuePos.load(std::memory_order_relaxed);
+             pos != last; ++pos)
+            AlTraits::destroy(alloc, cells[pos & mask].value());
+
+        AlCell al_cell(alloc);
+        al_cell.deallocate(cells, mask + 1);
+    }
+
+    template <typename... Args>
+    bool try_emplace(Args&&... args) {
+        T val(tiny_stl::forward<Args>(args)...);
+
+        size_t pos;
+        if (claim(enqueuePos, 0, 1, pos) == 0)
+            return false;
+
+        fill(pos, tiny_stl::move(val));
+        return true;
+    }
+
+    bool try_push(const T& val) {
+        size_t pos;
+        if (claim(enqueuePos, 0, 1, pos) == 0)
+            return false;
+
+        fill(pos, val);
+        return true;
+    }
+
+    bool try_push(T&& val) {
+        size_t pos;
+        if (claim(enqueuePos, 0, 1, pos) == 0)
+            return false;
+
+        fill(pos, tiny_stl::move(val));
+        return true;
+    }
+
+    // copy up to n elements of [first, ...)
+    template <typename InIter>
+    size_type try_push_n(InIter first, size_type n) {
+        size_t pos;
+        n = claim(enqueuePos, 0, n, pos);
+        for (size_type i = 0; i < n; ++i, ++first)
+            fill(pos + i, *first);
+
+        return n;
+    }
+
+    bool try_pop(T& out) {
+        size_t pos;
+        if (claim(dequeuePos, 1, 1, pos) == 0)
+            return false;
+
+        drain(pos, out);
+        return true;
+    }
+
+    // move up to n elements to [out, ...)
+    template <typename OutIter>
+    size_type try_pop_n(OutIter out, size_type n) {
+        size_t pos;
+        n = claim(dequeuePos, 1, n, pos);
+        for (size_type i = 0; i < n; ++i, ++out)
+            drain(pos + i, *out);
+
+        return n;
+    }
+
+    // a snapshot, the claimed cells count as pushed
+    size_type size() const noexcept {
+        const size_t first = dequeuePos.load(std::memory_order_acquire);
+        const size_t last = enqueuePos.load(std::memory_order_acquire);
+        return diff(last, first) > 0 ? last - first : 0;
+    }
+
+    bool empty() const noexcept {
+        return size() == 0;
+    }
+
+    size_type capacity() const noexcept {
+        return mask + 1;
+    }
+}; // class mpmc_queue
+
+} // namespace tiny_stl
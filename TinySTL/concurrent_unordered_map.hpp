@@ -0,0 +1,461 @@
+// Copyright (C) 2021 syn1w
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <atomic>
+#include <climits>
+#include <cstddef>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+
+#include "unordered_map.hpp"
+
+namespace tiny_stl {
+
+// concurrent_unordered_map, a hash map shared by many threads
+//
+// The keys are split over 2^k shards by the high bits of their hash, each
+// shard is an unordered_map (a HashTable) behind its own reader-writer
+// lock on its own cache lines. Lookups take the lock shared, updates take
+// it exclusive, so threads working on different shards never wait on
+// each other and a shard that grows rehashes only itself.
+//
+// No iterator or reference escapes a lock: an element is reached through
+// a visitor which runs while its shard is locked, visit() may change the
+// mapped value, cvisit() only reads it. A visitor must not call back into
+// the same map.
+
+namespace {
+
+// shared by readers, a waiting writer keeps new readers out
+class ShardLock {
+private:
+    static const unsigned kWriter = 1u << 31;
+    static const unsigned kPending = 1u << 30;
+
+    std::atomic<unsigned> state;
+
+    static void pause(unsigned& spins) noexcept {
+        if (++spins >= 64) {
+            spins = 0;
+            std::this_thread::yield();
+        }
+    }
+
+public:
+    ShardLock() noexcept : state(0) {
+    }
+
+    void lock_shared() noexcept {
+        unsigned spins = 0;
+        unsigned s = state.load(std::memory_order_relaxed);
+        while (true) {
+            if ((s & (kWriter | kPending)) == 0 &&
+                state.compare_exchange_weak(s, s + 1,
+                                            std::memory_order_acquire,
+                                            std::memory_order_relaxed))
+                return;
+
+            pause(spins);
+            s = state.load(std::memory_order_relaxed);
+        }
+    }
+
+    void unlock_shared() noexcept {
+        state.fetch_sub(1, std::memory_order_release);
+    }
+
+    void lock() noexcept {
+        unsigned spins = 0;
+        unsigned s = state.load(std::memory_order_relaxed);
+        while (true) {
+            if ((s & ~kPending) == 0) {
+                if (state.compare_exchange_weak(s, kWriter,
+                                                std::memory_order_acquire,
+                                                std::memory_order_relaxed))
+                    return;
+                continue;
+            }
+
+            if ((s & kPending) == 0)
+                state.fetch_or(kPending, std::memory_order_relaxed);
+
+            pause(spins);
+            s = state.load(std::memory_order_relaxed);
+        }
+    }
+
+    // a pending bit set by another writer is kept
+    void unlock() noexcept {
+        state.fetch_and(~kWriter, std::memory_order_release);
+    }
+};
+
+// 4 shards per hardware thread, a power of 2
+inline size_t defaultShardCount() noexcept {
+    const size_t threads = std::thread::hardware_concurrency();
+    size_t n = 1;
+    while (n < 4 * threads && n < 1024)
+        n <<= 1;
+
+    return n;
+}
+
+} // namespace
+
+template <typename Key, typename T, typename Hash = hash<Key>,
+          typename KeyEqual = equal_to<Key>,
+          typename Alloc = allocator<pair<Key, T>>,
+          typename Policy = chained_hashing<>>
+class concurrent_unordered_map {
+public:
+    using key_type = Key;
+    using mapped_type = T;
+    using value_type = pair<const Key, T>;
+    using size_type = size_t;
+    using hasher = Hash;
+    using key_equal = KeyEqual;
+    using allocator_type = Alloc;
+    using table_type = unordered_map<Key, T, Hash, KeyEqual, Alloc, Policy>;
+
+private:
+    struct alignas(kCacheLineSize) Shard {
+        mutable ShardLock lock;
+        table_type table;
+
+        Shard(const Hash& hf, const KeyEqual& eq, const Alloc& al)
+            : lock(), table(0, hf, eq, al) {
+        }
+    };
+
+    using SharedLock = std::shared_lock<ShardLock>;
+    using UniqueLock = std::lock_guard<ShardLock>;
+    using AlBytes =
+        typename allocator_traits<Alloc>::template rebind_alloc<char>;
+
+    // shift of the hash bits which pick the shard
+    static const size_t kShardShift = sizeof(size_t) * CHAR_BIT / 2;
+
+    Shard* shards;
+    char* storage; // shards, aligned to a cache line inside it
+    size_type mask;
+    hasher hashfunc;
+    AlBytes albytes;
+
+private:
+    size_type storageBytes() const noexcept {
+        return (mask + 1) * sizeof(Shard) + kCacheLineSize;
+    }
+
+    Shard& shardOf(const key_type& key) const noexcept {
+        return shards[(hashMix(hashfunc(key)) >> kShardShift) & mask];
+    }
+
+    template <typename Fn>
+    static size_type visitAux(table_type& table, const key_type& key,
+                              Fn& fn) {
+        auto pos = table.find(key);
+        if (pos == table.end())
+            return 0;
+
+        fn(*pos);
+        return 1;
+    }
+
+    template <typename Value, typename Fn>
+    bool insertOrVisitAux(Value&& val, Fn& fn) {
+        Shard& shard = shardOf(val.first);
+        UniqueLock lock(shard.lock);
+        auto pos = shard.table.find(val.first);
+        if (pos != shard.table.end()) {
+            fn(*pos);
+            return false;
+        }
+
+        shard.table.insert(tiny_stl::forward<Value>(val));
+        return true;
+    }
+
+    template <typename K, typename... Args>
+    bool tryEmplaceAux(K&& key, Args&&... args) {
+        Shard& shard = shardOf(key);
+        UniqueLock lock(shard.lock);
+        if (shard.table.find(key) != shard.table.end())
+            return false;
+
+        shard.table.emplace(tiny_stl::forward<K>(key),
+                            T(tiny_stl::forward<Args>(args)...));
+        return true;
+    }
+
+    template <typename K, typename M>
+    bool insertOrAssignAux(K&& key, M&& obj) {
+        Shard& shard = shardOf(key);
+        UniqueLock lock(shard.lock);
+        auto pos = shard.table.find(key);
+        if (pos != shard.table.end()) {
+            pos->second = tiny_stl::forward<M>(obj);
+            return false;
+        }
+
+        shard.table.emplace(tiny_stl::forward<K>(key),
+                            tiny_stl::forward<M>(obj));
+        return true;
+    }
+
+public:
+    // shard_count is rounded up to a power of 2, 0 picks one from the
+    // number of hardware threads
+    explicit concurrent_unordered_map(size_type shard_count = 0,
+                                      const Hash& hf = Hash(),
+                                      const KeyEqual& eq = KeyEqual(),
+                                      const Alloc& al = Alloc())
+        : shards(nullptr), storage(nullptr), mask(0), hashfunc(hf),
+          albytes(al) {
+        const size_type n =
+            shard_count == 0 ? defaultShardCount() : shard_count;
+        while (mask + 1 < n)
+            mask = (mask << 1) | 1;
+
+        storage = albytes.allocate(storageBytes());
+        const size_t addr = reinterpret_cast<size_t>(storage);
+        shards = reinterpret_cast<Shard*>(
+            storage + (kCacheLineSize - addr % kCacheLineSize));
+
+        size_type i = 0;
+        try {
+            for (; i <= mask; ++i)
+                ::new (static_cast<void*>(shards + i)) Shard(hf, eq, al);
+        } catch (...) {
+            while (i > 0)
+                shards[--i].~Shard();
+            albytes.deallocate(storage, storageBytes());
+            throw;
+        }
+    }
+
+    concurrent_unordered_map(const concurrent_unordered_map&) = delete;
+    concurrent_unordered_map&
+    operator=(const concurrent_unordered_map&) = delete;
+
+    // no thread uses the map any more
+    ~concurrent_unordered_map() {
+        for (size_type i = 0; i <= mask; ++i)
+            shards[i].~Shard();
+        albytes.deallocate(storage, storageBytes());
+    }
+
+    allocator_type get_allocator() const {
+        return allocator_type(albytes);
+    }
+
+    hasher hash_function() const {
+        return hashfunc;
+    }
+
+    key_equal key_eq() const {
+        return shards[0].table.key_eq();
+    }
+
+    size_type shard_count() const noexcept {
+        return mask + 1;
+    }
+
+    // a snapshot, the shards are counted one after another
+    size_type size() const {
+        size_type n = 0;
+        for (size_type i = 0; i <= mask; ++i) {
+            SharedLock lock(shards[i].lock);
+            n += shards[i].table.size();
+        }
+
+        return n;
+    }
+
+    bool empty() const {
+        return size() == 0;
+    }
+
+    bool insert(const value_type& val) {
+        return tryEmplaceAux(val.first, val.second);
+    }
+
+    bool insert(value_type&& val) {
+        return tryEmplaceAux(val.first, tiny_stl::move(val.second));
+    }
+
+    // T is built only if key is not there
+    template <typename... Args>
+    bool try_emplace(const key_type& key, Args&&... args) {
+        return tryEmplaceAux(key, tiny_stl::forward<Args>(args)...);
+    }
+
+    template <typename... Args>
+    bool try_emplace(key_type&& key, Args&&... args) {
+        return tryEmplaceAux(tiny_stl::move(key),
+                             tiny_stl::forward<Args>(args)...);
+    }
+
+    // return true if inserted, false if assigned
+    template <typename M>
+    bool insert_or_assign(const key_type& key, M&& obj) {
+        return insertOrAssignAux(key, tiny_stl::forward<M>(obj));
+    }
+
+    template <typename M>
+    bool insert_or_assign(key_type&& key, M&& obj) {
+        return insertOrAssignAux(tiny_stl::move(key),
+                                 tiny_stl::forward<M>(obj));
+    }
+
+    // insert val, or call fn(element) on the element already there,
+    // return true if inserted
+    template <typename Fn>
+    bool insert_or_visit(const value_type& val, Fn fn) {
+        return insertOrVisitAux(val, fn);
+    }
+
+    template <typename Fn>
+    bool insert_or_visit(value_type&& val, Fn fn) {
+        return insertOrVisitAux(tiny_stl::move(val), fn);
+    }
+
+    // call fn(element) on the element of key with the shard locked
+    // exclusive, return the number visited
+    template <typename Fn>
+    size_type visit(const key_type& key, Fn fn) {
+        Shard& shard = shardOf(key);
+        UniqueLock lock(shard.lock);
+        return visitAux(shard.table, key, fn);
+    }
+
+    // the same with the shard locked shared, fn gets a const element
+    template <typename Fn>
+    size_type cvisit(const key_type& key, Fn fn) const {
+        Shard& shard = shardOf(key);
+        SharedLock lock(shard.lock);
+        const table_type& table = shard.table;
+        auto pos = table.find(key);
+        if (pos == table.end())
+            return 0;
+
+        fn(*pos);
+        return 1;
+    }
+
+    template <typename Fn>
+    size_type visit(const key_type& key, Fn fn) const {
+        return cvisit(key, fn);
+    }
+
+    // every element, one shard at a time
+    template <typename Fn>
+    size_type visit_all(Fn fn) {
+        size_type n = 0;
+        for (size_type i = 0; i <= mask; ++i) {
+            UniqueLock lock(shards[i].lock);
+            for (auto& val : shards[i].table)
+                fn(val);
+            n += shards[i].table.size();
+        }
+
+        return n;
+    }
+
+    template <typename Fn>
+    size_type cvisit_all(Fn fn) const {
+        size_type n = 0;
+        for (size_type i = 0; i <= mask; ++i) {
+            SharedLock lock(shards[i].lock);
+            const table_type& table = shards[i].table;
+            for (auto& val : table)
+                fn(val);
+            n += table.size();
+        }
+
+        return n;
+    }
+
+    template <typename Fn>
+    size_type visit_all(Fn fn) const {
+        return cvisit_all(fn);
+    }
+
+    bool contains(const key_type& key) const {
+        return count(key) != 0;
+    }
+
+    size_type count(const key_type& key) const {
+        Shard& shard = shardOf(key);
+        SharedLock lock(shard.lock);
+        return shard.table.count(key);
+    }
+
+    size_type erase(const key_type& key) {
+        Shard& shard = shardOf(key);
+        UniqueLock lock(shard.lock);
+        return shard.table.erase(key);
+    }
+
+    // erase the element of key if pred(element) is true
+    template <typename Pred>
+    size_type erase_if(const key_type& key, Pred pred) {
+        Shard& shard = shardOf(key);
+        UniqueLock lock(shard.lock);
+        auto pos = shard.table.find(key);
+        if (pos == shard.table.end() || !pred(*pos))
+            return 0;
+
+        shard.table.erase(pos);
+        return 1;
+    }
+
+    // erase every element for which pred(element) is true
+    template <typename Pred>
+    size_type erase_if(Pred pred) {
+        size_type n = 0;
+        for (size_type i = 0; i <= mask; ++i) {
+            UniqueLock lock(shards[i].lock);
+            table_type& table = shards[i].table;
+            for (auto pos = table.begin(); pos != table.end();) {
+                if (pred(*pos)) {
+                    pos = table.erase(pos);
+                    ++n;
+                } else {
+                    ++pos;
+                }
+            }
+        }
+
+        return n;
+    }
+
+    void clear() {
+        for (size_type i = 0; i <= mask; ++i) {
+            UniqueLock lock(shards[i].lock);
+            shards[i].table.clear();
+        }
+    }
+
+    // room for n elements spread evenly over the shards
+    void reserve(size_type n) {
+        const size_type per_shard = n / (mask + 1) + 1;
+        for (size_type i = 0; i <= mask; ++i) {
+            UniqueLock lock(shards[i].lock);
+            shards[i].table.reserve(per_shard);
+        }
+    }
+
+    // see HashTable, bounds the time one insertion holds its shard
+    void incremental_rehash(bool on) {
+        for (size_type i = 0; i <= mask; ++i) {
+            UniqueLock lock(shards[i].lock);
+            shards[i].table.incremental_rehash(on);
+        }
+    }
+}; // class concurrent_unordered_map
+
+} // namespace tiny_stl
@@ -0,0 +1,114 @@
+// Copyright (C) 2021 syn1w
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <mutex>
+
+#include "cow_string.hpp"
+#include "string_view.hpp"
+#include "unordered_map.hpp"
+
+namespace tiny_stl {
+
+// cow_intern_pool, equal contents share one StringValue
+//
+// intern() returns a cow string sharing the pooled value of its contents,
+// so a million copies of the same tag cost one buffer. The pool keeps one
+// reference to every value and the key is a view of that value's data,
+// which never changes: any other owner sees the value shared and copies
+// before writing. purge() drops the values nobody else holds.
+//
+// Every member takes a mutex, one pool may serve all threads; global()
+// is the process-wide one, a local pool gives each arena its own table.
+template <typename CharT, typename Traits = std::char_traits<CharT>,
+          typename Alloc = allocator<CharT>,
+          typename RefCount = extra::atomic_ref_count>
+class cow_intern_pool {
+public:
+    using string_type = cow_basic_string<CharT, Traits, Alloc, RefCount>;
+    using size_type = typename string_type::size_type;
+
+private:
+    using View = basic_string_view<CharT, Traits>;
+
+    unordered_map<View, string_type> table;
+    mutable std::mutex mtx;
+
+public:
+    cow_intern_pool() = default;
+    cow_intern_pool(const cow_intern_pool&) = delete;
+    cow_intern_pool& operator=(const cow_intern_pool&) = delete;
+
+    static cow_intern_pool& global() {
+        static cow_intern_pool pool;
+        return pool;
+    }
+
+    string_type intern(const CharT* s, size_type count) {
+        std::lock_guard<std::mutex> lock(mtx);
+        auto iter = table.find(View(s, count));
+        if (iter != table.end())
+            return iter->second;
+
+        return insertValue(string_type(s, count));
+    }
+
+    string_type intern(const CharT* s) {
+        return intern(s, Traits::length(s));
+    }
+
+    // share the value of str if its contents are not pooled yet
+    string_type intern(const string_type& str) {
+        std::lock_guard<std::mutex> lock(mtx);
+        auto iter = table.find(View(str.c_str(), str.size()));
+        if (iter != table.end())
+            return iter->second;
+
+        return insertValue(str);
+    }
+
+    bool contains(const CharT* s, size_type count) const {
+        std::lock_guard<std::mutex> lock(mtx);
+        return table.find(View(s, count)) != table.end();
+    }
+
+    // the number of distinct contents
+    size_type size() const {
+        std::lock_guard<std::mutex> lock(mtx);
+        return table.size();
+    }
+
+    // drop the values only the pool refers to, return how many
+    size_type purge() {
+        std::lock_guard<std::mutex> lock(mtx);
+        size_type dropped = 0;
+        for (auto iter = table.begin(); iter != table.end();) {
+            if (iter->second.getRefCount() == 1) {
+                iter = table.erase(iter);
+                ++dropped;
+            } else {
+                ++iter;
+            }
+        }
+        return dropped;
+    }
+
+    void clear() {
+        std::lock_guard<std::mutex> lock(mtx);
+        table.clear();
+    }
+
+private:
+    string_type insertValue(const string_type& str) {
+        // the key views the pooled copy, which shares the value of str
+        auto result = table.emplace(View(str.c_str(), str.size()), str);
+        return result.first->second;
+    }
+};
+
+using cow_string_pool = cow_intern_pool<char>;
+using cow_wstring_pool = cow_intern_pool<wchar_t>;
+
+} // namespace tiny_stl
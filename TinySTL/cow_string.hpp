@@ -7,6 +7,7 @@
 #include <initializer_list>
 #include <string>
 
+#include "char_search.hpp"
 #include "memory.hpp"
 
 namespace tiny_stl {
@@ -189,14 +190,17 @@ namespace extra {
 // Reference count base class
 // Provide interface
 // Improved the original
+template <typename RefCount = atomic_ref_count>
 class RCObject {
 private:
-    size_t ref_count;
+    RefCount ref_count;
 
 protected: // Derived class call
-    RCObject() : ref_count(0) {
+    RCObject() : ref_count() {
+    }
+    // a copy is a new object, nobody refers to it yet
+    RCObject(const RCObject&) : ref_count() {
     }
-    RCObject(const RCObject& rhs) = default;
     RCObject& operator=(const RCObject& rhs) {
         return *this;
     }
@@ -205,20 +209,20 @@ protected: // Derived class call
 
 public:
     void add_reference() noexcept {
-        ++ref_count;
+        ref_count.increment();
     }
 
     void remove_reference() noexcept {
-        if (--ref_count == 0)
+        if (ref_count.decrement())
             delete this;
     }
 
     bool is_shared() const noexcept {
-        return ref_count > 1;
+        return ref_count.load() > 1;
     }
 
     size_t get_ref_count() const noexcept {
-        return ref_count;
+        return ref_count.load();
     }
 };
 
@@ -286,8 +290,13 @@ public:
 
 } // namespace extra
 
+template <typename CharT, typename Traits, typename Alloc, typename RefCount>
+class cow_intern_pool;
+
+// RefCount is extra::atomic_ref_count or extra::plain_ref_count
 template <typename CharT, typename Traits = std::char_traits<CharT>,
-          typename Alloc = allocator<CharT>>
+          typename Alloc = allocator<CharT>,
+          typename RefCount = extra::atomic_ref_count>
 class cow_basic_string {
 public:
     static_assert(is_same<typename Traits::char_type, CharT>::value,
@@ -316,7 +325,7 @@ public:
 private:
     // nested struct
     // manage resources
-    struct StringValue : public extra::RCObject {
+    struct StringValue : public extra::RCObject<RefCount> {
         size_type size;
         size_type capa;
         CharT* data;
@@ -1251,65 +1260,36 @@ private:
     // xpos + str.size() <= size()
     // Traits::eq(at(xpos + n), str.at(n))
 
+    size_type position(const CharT* p) const noexcept {
+        return p == nullptr ? npos : static_cast<size_type>(p - value->data);
+    }
+
     // find algorithm
     // pos:   this->position at which to start the search
     // count: s->length of substring to search for
     size_type findHelper(const CharT* s, size_type pos, size_type count) const {
-        // Here is a naive find algorithm
-
-        size_type thisSize = size();
-
-        if (count > thisSize || pos > thisSize - count)
+        const size_type thisSize = size();
+        if (pos > thisSize || count > thisSize - pos)
             return npos;
+        if (count == 0) // always matches
+            return pos;
 
-        if (count == 0) {
-            return tiny_stl::min(pos, size() - 1);
-        }
-
-        for (size_type i = pos; i <= thisSize - count; ++i) {
-            // if matched first character
-            if (traits_type::eq(value->data[i], s[0])) {
-                size_type j;
-                for (j = 1; j < count; ++j) {
-                    if (!traits_type::eq(value->data[i + j], s[j])) // mismatch
-                        break;
-                }
-                if (j == count)
-                    return i;
-            }
-        }
-
-        return npos;
+        return position(traitsFind<Traits>(value->data + pos,
+                                           value->data + thisSize, s, count));
     }
 
+    // the match starts at [0, pos]
     size_type rfindHelper(const CharT* str, size_type pos,
                           size_type count) const {
-        // native find algorithm
-        size_type lhsSize = size();
-        if (count > lhsSize || pos < count)
+        const size_type lhsSize = size();
+        if (count == 0) // always matches
+            return tiny_stl::min(pos, lhsSize);
+        if (count > lhsSize)
             return npos;
-        if (lhsSize == 0)
-            return npos;
-        if (count == 0)
-            return pos;
 
-        pos = tiny_stl::min(pos, lhsSize - 1);
-        // pos >= count
-        for (difference_type i = static_cast<difference_type>(pos); i >= 0;
-             --i) {
-            // mismatched the first character
-            if (!Traits::eq(value->data[i], str[0]))
-                continue;
-
-            size_type j = 1;
-            for (; j < count; ++j) {
-                if (!Traits::eq(value->data[i + j], str[j]))
-                    break;
-            }
-            if (j == count)
-                return i;
-        }
-        return npos;
+        const size_type last = tiny_stl::min(pos, lhsSize - count) + count;
+        return position(traitsRfind<Traits>(value->data, value->data + last,
+                                            str, count));
     }
 
 public:
@@ -1333,11 +1313,11 @@ public:
     }
 
     size_type find(CharT ch, size_type pos = 0) const {
-        const CharT* find_at =
-            traits_type::find(value->data + pos, size() - pos, ch);
-        return find_at == nullptr
-                   ? npos
-                   : static_cast<size_type>(find_at - value->data);
+        if (pos >= size())
+            return npos;
+
+        return position(
+            traitsFind<Traits>(value->data + pos, value->data + size(), ch));
     }
 
     size_type rfind(const cow_basic_string& str,
@@ -1354,11 +1334,12 @@ public:
     }
 
     size_type rfind(CharT ch, size_type pos = npos) const {
-        pos = tiny_stl::min(pos, size() - 1);
-        CharT str[2];
-        str[0] = ch;
-        str[1] = traits_type::to_char_type(0);
-        return rfindHelper(str, pos, 1);
+        if (empty())
+            return npos;
+
+        const size_type last = tiny_stl::min(pos, size() - 1) + 1;
+        return position(
+            traitsRfind<Traits>(value->data, value->data + last, ch));
     }
 
     // find_first_of, find_first_not_of, find_last_of, find_last_not_of
@@ -1382,6 +1363,9 @@ public:
     }
 
 private:
+    template <typename, typename, typename, typename>
+    friend class cow_intern_pool;
+
     bool isShared() const noexcept {
         return value->is_shared();
     }
@@ -1400,11 +1384,11 @@ private:
 
 }; // class basic_string<CharT, Traits, Alloc>
 
-template <typename CharT, typename Traits, typename Alloc>
-cow_basic_string<CharT, Traits, Alloc>
-operator+(const cow_basic_string<CharT, Traits, Alloc>& lhs,
-          const cow_basic_string<CharT, Traits, Alloc>& rhs) {
-    cow_basic_string<CharT, Traits, Alloc> tmp;
+template <typename CharT, typename Traits, typename Alloc, typename RefCount>
+cow_basic_string<CharT, Traits, Alloc, RefCount>
+operator+(const cow_basic_string<CharT, Traits, Alloc, RefCount>& lhs,
+          const cow_basic_string<CharT, Traits, Alloc, RefCount>& rhs) {
+    cow_basic_string<CharT, Traits, Alloc, RefCount> tmp;
     tmp.reserve(lhs.size() + rhs.size());
     tmp += lhs;
     tmp += rhs;
@@ -1412,21 +1396,23 @@ operator+(const cow_basic_string<CharT, Traits, Alloc>& lhs,
     return tmp;
 }
 
-template <typename CharT, typename Traits, typename Alloc>
-cow_basic_string<CharT, Traits, Alloc>
-operator+(const CharT* lhs, const cow_basic_string<CharT, Traits, Alloc>& rhs) {
-    cow_basic_string<CharT, Traits, Alloc> tmp;
-    tmp.reserve(Traits::length(lhs), rhs.size());
+template <typename CharT, typename Traits, typename Alloc, typename RefCount>
+cow_basic_string<CharT, Traits, Alloc, RefCount>
+operator+(const CharT* lhs,
+          const cow_basic_string<CharT, Traits, Alloc, RefCount>& rhs) {
+    cow_basic_string<CharT, Traits, Alloc, RefCount> tmp;
+    tmp.reserve(Traits::length(lhs) + rhs.size());
     tmp += lhs;
     tmp += rhs;
 
     return tmp;
 }
 
-template <typename CharT, typename Traits, typename Alloc>
-cow_basic_string<CharT, Traits, Alloc>
-operator+(CharT lhs, const cow_basic_string<CharT, Traits, Alloc>& rhs) {
-    cow_basic_string<CharT, Traits, Alloc> tmp;
+template <typename CharT, typename Traits, typename Alloc, typename RefCount>
+cow_basic_string<CharT, Traits, Alloc, RefCount>
+operator+(CharT lhs,
+          const cow_basic_string<CharT, Traits, Alloc, RefCount>& rhs) {
+    cow_basic_string<CharT, Traits, Alloc, RefCount> tmp;
     tmp.reserve(1 + rhs.size());
     tmp += lhs;
     tmp += rhs;
@@ -1434,10 +1420,11 @@ operator+(CharT lhs, const cow_basic_string<CharT, Traits, Alloc>& rhs) {
     return tmp;
 }
 
-template <typename CharT, typename Traits, typename Alloc>
-cow_basic_string<CharT, Traits, Alloc>
-operator+(const cow_basic_string<CharT, Traits, Alloc>& lhs, const CharT* rhs) {
-    cow_basic_string<CharT, Traits, Alloc> tmp;
+template <typename CharT, typename Traits, typename Alloc, typename RefCount>
+cow_basic_string<CharT, Traits, Alloc, RefCount>
+operator+(const cow_basic_string<CharT, Traits, Alloc, RefCount>& lhs,
+          const CharT* rhs) {
+    cow_basic_string<CharT, Traits, Alloc, RefCount> tmp;
     tmp.reserve(lhs.size() + Traits::length(rhs));
     tmp += lhs;
     tmp += rhs;
@@ -1445,10 +1432,11 @@ operator+(const cow_basic_string<CharT, Traits, Alloc>& lhs, const CharT* rhs) {
     return tmp;
 }
 
-template <typename CharT, typename Traits, typename Alloc>
-cow_basic_string<CharT, Traits, Alloc>
-operator+(const cow_basic_string<CharT, Traits, Alloc>& lhs, CharT rhs) {
-    cow_basic_string<CharT, Traits, Alloc> tmp;
+template <typename CharT, typename Traits, typename Alloc, typename RefCount>
+cow_basic_string<CharT, Traits, Alloc, RefCount>
+operator+(const cow_basic_string<CharT, Traits, Alloc, RefCount>& lhs,
+          CharT rhs) {
+    cow_basic_string<CharT, Traits, Alloc, RefCount> tmp;
     tmp.reserve(lhs.size() + 1);
     tmp += lhs;
     tmp += rhs;
@@ -1456,202 +1444,216 @@ operator+(const cow_basic_string<CharT, Traits, Alloc>& lhs, CharT rhs) {
     return tmp;
 }
 
-template <typename CharT, typename Traits, typename Alloc>
-cow_basic_string<CharT, Traits, Alloc>
-operator+(cow_basic_string<CharT, Traits, Alloc>&& lhs,
-          const cow_basic_string<CharT, Traits, Alloc>& rhs) {
+template <typename CharT, typename Traits, typename Alloc, typename RefCount>
+cow_basic_string<CharT, Traits, Alloc, RefCount>
+operator+(cow_basic_string<CharT, Traits, Alloc, RefCount>&& lhs,
+          const cow_basic_string<CharT, Traits, Alloc, RefCount>& rhs) {
     return tiny_stl::move(lhs.append(rhs));
 }
 
-template <typename CharT, typename Traits, typename Alloc>
-cow_basic_string<CharT, Traits, Alloc>
-operator+(const cow_basic_string<CharT, Traits, Alloc>& lhs,
-          cow_basic_string<CharT, Traits, Alloc>&& rhs) {
+template <typename CharT, typename Traits, typename Alloc, typename RefCount>
+cow_basic_string<CharT, Traits, Alloc, RefCount>
+operator+(const cow_basic_string<CharT, Traits, Alloc, RefCount>& lhs,
+          cow_basic_string<CharT, Traits, Alloc, RefCount>&& rhs) {
     return tiny_stl::move(rhs.insert(0, lhs));
 }
 
-template <typename CharT, typename Traits, typename Alloc>
-cow_basic_string<CharT, Traits, Alloc>
-operator+(cow_basic_string<CharT, Traits, Alloc>&& lhs,
-          cow_basic_string<CharT, Traits, Alloc>&& rhs) {
+template <typename CharT, typename Traits, typename Alloc, typename RefCount>
+cow_basic_string<CharT, Traits, Alloc, RefCount>
+operator+(cow_basic_string<CharT, Traits, Alloc, RefCount>&& lhs,
+          cow_basic_string<CharT, Traits, Alloc, RefCount>&& rhs) {
     return tiny_stl::move(lhs.append(rhs));
 }
 
-template <typename CharT, typename Traits, typename Alloc>
-cow_basic_string<CharT, Traits, Alloc>
-operator+(const CharT* lhs, cow_basic_string<CharT, Traits, Alloc>&& rhs) {
+template <typename CharT, typename Traits, typename Alloc, typename RefCount>
+cow_basic_string<CharT, Traits, Alloc, RefCount>
+operator+(const CharT* lhs,
+          cow_basic_string<CharT, Traits, Alloc, RefCount>&& rhs) {
     return tiny_stl::move(rhs.insert(0, lhs));
 }
 
-template <typename CharT, typename Traits, typename Alloc>
-cow_basic_string<CharT, Traits, Alloc>
-operator+(CharT lhs, cow_basic_string<CharT, Traits, Alloc>&& rhs) {
+template <typename CharT, typename Traits, typename Alloc, typename RefCount>
+cow_basic_string<CharT, Traits, Alloc, RefCount>
+operator+(CharT lhs, cow_basic_string<CharT, Traits, Alloc, RefCount>&& rhs) {
     return tiny_stl::move(rhs.insert(0, 1, lhs));
 }
 
-template <typename CharT, typename Traits, typename Alloc>
-cow_basic_string<CharT, Traits, Alloc>
-operator+(cow_basic_string<CharT, Traits, Alloc>&& lhs, const CharT* rhs) {
+template <typename CharT, typename Traits, typename Alloc, typename RefCount>
+cow_basic_string<CharT, Traits, Alloc, RefCount>
+operator+(cow_basic_string<CharT, Traits, Alloc, RefCount>&& lhs,
+          const CharT* rhs) {
     return tiny_stl::move(lhs.append(rhs));
 }
 
-template <typename CharT, typename Traits, typename Alloc>
-cow_basic_string<CharT, Traits, Alloc>
-operator+(cow_basic_string<CharT, Traits, Alloc>&& lhs, CharT rhs) {
+template <typename CharT, typename Traits, typename Alloc, typename RefCount>
+cow_basic_string<CharT, Traits, Alloc, RefCount>
+operator+(cow_basic_string<CharT, Traits, Alloc, RefCount>&& lhs, CharT rhs) {
     lhs.push_back(rhs);
     return tiny_stl::move(lhs);
 }
 
-template <typename CharT, typename Traits, typename Alloc>
-inline bool
-operator==(const cow_basic_string<CharT, Traits, Alloc>& lhs,
-           const cow_basic_string<CharT, Traits, Alloc>& rhs) noexcept {
+template <typename CharT, typename Traits, typename Alloc, typename RefCount>
+inline bool operator==(
+    const cow_basic_string<CharT, Traits, Alloc, RefCount>& lhs,
+    const cow_basic_string<CharT, Traits, Alloc, RefCount>& rhs) noexcept {
     return lhs.size() == rhs.size() &&
            tiny_stl::equal(lhs.begin(), lhs.end(), rhs.begin());
 }
 
-template <typename CharT, typename Traits, typename Alloc>
-inline bool
-operator!=(const cow_basic_string<CharT, Traits, Alloc>& lhs,
-           const cow_basic_string<CharT, Traits, Alloc>& rhs) noexcept {
+template <typename CharT, typename Traits, typename Alloc, typename RefCount>
+inline bool operator!=(
+    const cow_basic_string<CharT, Traits, Alloc, RefCount>& lhs,
+    const cow_basic_string<CharT, Traits, Alloc, RefCount>& rhs) noexcept {
     return !(lhs == rhs);
 }
 
-template <typename CharT, typename Traits, typename Alloc>
-inline bool
-operator<(const cow_basic_string<CharT, Traits, Alloc>& lhs,
-          const cow_basic_string<CharT, Traits, Alloc>& rhs) noexcept {
+template <typename CharT, typename Traits, typename Alloc, typename RefCount>
+inline bool operator<(
+    const cow_basic_string<CharT, Traits, Alloc, RefCount>& lhs,
+    const cow_basic_string<CharT, Traits, Alloc, RefCount>& rhs) noexcept {
     return tiny_stl::lexicographical_compare(lhs.begin(), lhs.end(),
                                              rhs.begin(), rhs.end());
 }
 
-template <typename CharT, typename Traits, typename Alloc>
-inline bool
-operator>(const cow_basic_string<CharT, Traits, Alloc>& lhs,
-          const cow_basic_string<CharT, Traits, Alloc>& rhs) noexcept {
+template <typename CharT, typename Traits, typename Alloc, typename RefCount>
+inline bool operator>(
+    const cow_basic_string<CharT, Traits, Alloc, RefCount>& lhs,
+    const cow_basic_string<CharT, Traits, Alloc, RefCount>& rhs) noexcept {
     return rhs < lhs;
 }
 
-template <typename CharT, typename Traits, typename Alloc>
-inline bool
-operator<=(const cow_basic_string<CharT, Traits, Alloc>& lhs,
-           const cow_basic_string<CharT, Traits, Alloc>& rhs) noexcept {
+template <typename CharT, typename Traits, typename Alloc, typename RefCount>
+inline bool operator<=(
+    const cow_basic_string<CharT, Traits, Alloc, RefCount>& lhs,
+    const cow_basic_string<CharT, Traits, Alloc, RefCount>& rhs) noexcept {
     return !(rhs < lhs);
 }
 
-template <typename CharT, typename Traits, typename Alloc>
-inline bool
-operator>=(const cow_basic_string<CharT, Traits, Alloc>& lhs,
-           const cow_basic_string<CharT, Traits, Alloc>& rhs) noexcept {
+template <typename CharT, typename Traits, typename Alloc, typename RefCount>
+inline bool operator>=(
+    const cow_basic_string<CharT, Traits, Alloc, RefCount>& lhs,
+    const cow_basic_string<CharT, Traits, Alloc, RefCount>& rhs) noexcept {
     return !(lhs < rhs);
 }
 
-template <typename CharT, typename Traits, typename Alloc>
-inline bool operator==(const CharT* clhs,
-                       const cow_basic_string<CharT, Traits, Alloc>& rhs) {
-    const cow_basic_string<CharT, Traits, Alloc> lhs(clhs);
+template <typename CharT, typename Traits, typename Alloc, typename RefCount>
+inline bool operator==(
+    const CharT* clhs,
+    const cow_basic_string<CharT, Traits, Alloc, RefCount>& rhs) {
+    const cow_basic_string<CharT, Traits, Alloc, RefCount> lhs(clhs);
     return lhs == rhs;
 }
 
-template <typename CharT, typename Traits, typename Alloc>
-inline bool operator==(const cow_basic_string<CharT, Traits, Alloc>& rhs,
-                       const CharT* crhs) {
-    const cow_basic_string<CharT, Traits, Alloc> lhs(crhs);
+template <typename CharT, typename Traits, typename Alloc, typename RefCount>
+inline bool operator==(
+    const cow_basic_string<CharT, Traits, Alloc, RefCount>& rhs,
+    const CharT* crhs) {
+    const cow_basic_string<CharT, Traits, Alloc, RefCount> lhs(crhs);
     return lhs == rhs;
 }
 
-template <typename CharT, typename Traits, typename Alloc>
-inline bool operator!=(const CharT* clhs,
-                       const cow_basic_string<CharT, Traits, Alloc>& rhs) {
-    const cow_basic_string<CharT, Traits, Alloc> lhs(clhs);
+template <typename CharT, typename Traits, typename Alloc, typename RefCount>
+inline bool operator!=(
+    const CharT* clhs,
+    const cow_basic_string<CharT, Traits, Alloc, RefCount>& rhs) {
+    const cow_basic_string<CharT, Traits, Alloc, RefCount> lhs(clhs);
     return lhs != rhs;
 }
 
-template <typename CharT, typename Traits, typename Alloc>
-inline bool operator!=(const cow_basic_string<CharT, Traits, Alloc>& lhs,
-                       const CharT* crhs) {
-    const cow_basic_string<CharT, Traits, Alloc> rhs(crhs);
+template <typename CharT, typename Traits, typename Alloc, typename RefCount>
+inline bool operator!=(
+    const cow_basic_string<CharT, Traits, Alloc, RefCount>& lhs,
+    const CharT* crhs) {
+    const cow_basic_string<CharT, Traits, Alloc, RefCount> rhs(crhs);
     return lhs != rhs;
 }
 
-template <typename CharT, typename Traits, typename Alloc>
-inline bool operator<(const CharT* clhs,
-                      const cow_basic_string<CharT, Traits, Alloc>& rhs) {
-    const cow_basic_string<CharT, Traits, Alloc> lhs(clhs);
+template <typename CharT, typename Traits, typename Alloc, typename RefCount>
+inline bool operator<(
+    const CharT* clhs,
+    const cow_basic_string<CharT, Traits, Alloc, RefCount>& rhs) {
+    const cow_basic_string<CharT, Traits, Alloc, RefCount> lhs(clhs);
     return lhs < rhs;
 }
 
-template <typename CharT, typename Traits, typename Alloc>
-inline bool operator<(const cow_basic_string<CharT, Traits, Alloc>& lhs,
-                      const CharT* crhs) {
-    const cow_basic_string<CharT, Traits, Alloc> rhs(crhs);
+template <typename CharT, typename Traits, typename Alloc, typename RefCount>
+inline bool operator<(
+    const cow_basic_string<CharT, Traits, Alloc, RefCount>& lhs,
+    const CharT* crhs) {
+    const cow_basic_string<CharT, Traits, Alloc, RefCount> rhs(crhs);
     return lhs < rhs;
 }
 
-template <typename CharT, typename Traits, typename Alloc>
-inline bool operator>(const CharT* clhs,
-                      const cow_basic_string<CharT, Traits, Alloc>& rhs) {
-    const cow_basic_string<CharT, Traits, Alloc> lhs(clhs);
+template <typename CharT, typename Traits, typename Alloc, typename RefCount>
+inline bool operator>(
+    const CharT* clhs,
+    const cow_basic_string<CharT, Traits, Alloc, RefCount>& rhs) {
+    const cow_basic_string<CharT, Traits, Alloc, RefCount> lhs(clhs);
     return lhs > rhs;
 }
 
-template <typename CharT, typename Traits, typename Alloc>
-inline bool operator>(const cow_basic_string<CharT, Traits, Alloc>& lhs,
-                      const CharT* crhs) {
-    const cow_basic_string<CharT, Traits, Alloc> rhs(crhs);
+template <typename CharT, typename Traits, typename Alloc, typename RefCount>
+inline bool operator>(
+    const cow_basic_string<CharT, Traits, Alloc, RefCount>& lhs,
+    const CharT* crhs) {
+    const cow_basic_string<CharT, Traits, Alloc, RefCount> rhs(crhs);
     return lhs > rhs;
 }
 
-template <typename CharT, typename Traits, typename Alloc>
-inline bool operator<=(const CharT* clhs,
-                       const cow_basic_string<CharT, Traits, Alloc>& rhs) {
-    const cow_basic_string<CharT, Traits, Alloc> lhs(clhs);
+template <typename CharT, typename Traits, typename Alloc, typename RefCount>
+inline bool operator<=(
+    const CharT* clhs,
+    const cow_basic_string<CharT, Traits, Alloc, RefCount>& rhs) {
+    const cow_basic_string<CharT, Traits, Alloc, RefCount> lhs(clhs);
     return lhs <= rhs;
 }
 
-template <typename CharT, typename Traits, typename Alloc>
-inline bool operator<=(const cow_basic_string<CharT, Traits, Alloc>& lhs,
-                       const CharT* crhs) {
-    const cow_basic_string<CharT, Traits, Alloc> rhs(crhs);
+template <typename CharT, typename Traits, typename Alloc, typename RefCount>
+inline bool operator<=(
+    const cow_basic_string<CharT, Traits, Alloc, RefCount>& lhs,
+    const CharT* crhs) {
+    const cow_basic_string<CharT, Traits, Alloc, RefCount> rhs(crhs);
     return lhs <= rhs;
 }
 
-template <typename CharT, typename Traits, typename Alloc>
-inline bool operator>=(const CharT* clhs,
-                       const cow_basic_string<CharT, Traits, Alloc>& rhs) {
-    const cow_basic_string<CharT, Traits, Alloc> lhs(clhs);
+template <typename CharT, typename Traits, typename Alloc, typename RefCount>
+inline bool operator>=(
+    const CharT* clhs,
+    const cow_basic_string<CharT, Traits, Alloc, RefCount>& rhs) {
+    const cow_basic_string<CharT, Traits, Alloc, RefCount> lhs(clhs);
     return lhs >= rhs;
 }
 
-template <typename CharT, typename Traits, typename Alloc>
-inline bool operator>=(const cow_basic_string<CharT, Traits, Alloc>& lhs,
-                       const CharT* crhs) {
-    const cow_basic_string<CharT, Traits, Alloc> rhs(crhs);
+template <typename CharT, typename Traits, typename Alloc, typename RefCount>
+inline bool operator>=(
+    const cow_basic_string<CharT, Traits, Alloc, RefCount>& lhs,
+    const CharT* crhs) {
+    const cow_basic_string<CharT, Traits, Alloc, RefCount> rhs(crhs);
     return lhs >= rhs;
 }
 
-template <typename CharT, typename Traits, typename Alloc>
-void swap(cow_basic_string<CharT, Traits, Alloc>& lhs,
-          cow_basic_string<CharT, Traits, Alloc>&
+template <typename CharT, typename Traits, typename Alloc, typename RefCount>
+void swap(cow_basic_string<CharT, Traits, Alloc, RefCount>& lhs,
+          cow_basic_string<CharT, Traits, Alloc, RefCount>&
               rhs) noexcept(noexcept(lhs.swap(rhs))) {
     lhs.swap(rhs);
 }
 
-template <typename CharT, typename Traits, typename Alloc>
+template <typename CharT, typename Traits, typename Alloc, typename RefCount>
 std::basic_ostream<CharT, Traits>&
 operator<<(std::basic_ostream<CharT, Traits>& os,
-           const cow_basic_string<CharT, Traits, Alloc>& str) {
+           const cow_basic_string<CharT, Traits, Alloc, RefCount>& str) {
     // no format output
     os << str.c_str();
     return os;
 }
 
-template <typename CharT, typename Traits, typename Alloc>
+template <typename CharT, typename Traits, typename Alloc, typename RefCount>
 std::basic_istream<CharT, Traits>&
 operator>>(std::basic_istream<CharT, Traits>& is,
-           cow_basic_string<CharT, Traits, Alloc>& str) {
+           cow_basic_string<CharT, Traits, Alloc, RefCount>& str) {
     if (str.isShared())
-        str = cow_basic_string<CharT, Traits, Alloc>(str.data());
+        str = cow_basic_string<CharT, Traits, Alloc, RefCount>(str.data());
 
     // no format input
     is >> str.data();
@@ -1659,14 +1661,13 @@ operator>>(std::basic_istream<CharT, Traits>& is,
     return is;
 }
 
-template <typename CharT, typename Traits, typename Alloc>
-struct hash<cow_basic_string<CharT, Traits, Alloc>> {
-    using argument_type = cow_basic_string<CharT, Traits, Alloc>;
+template <typename CharT, typename Traits, typename Alloc, typename RefCount>
+struct hash<cow_basic_string<CharT, Traits, Alloc, RefCount>> {
+    using argument_type = cow_basic_string<CharT, Traits, Alloc, RefCount>;
     using result_type = size_t;
 
-    size_t operator()(
-        const cow_basic_string<CharT, Traits, Alloc>& str) const noexcept {
-        return tiny_stl::hashFNV(str.c_str(), str.size());
+    size_t operator()(const argument_type& str) const noexcept {
+        return tiny_stl::hashString(str.c_str(), str.size());
     }
 };
 
@@ -1675,6 +1676,19 @@ using cow_wstring = cow_basic_string<wchar_t>;
 using cow_u16string = cow_basic_string<char16_t>;
 using cow_u32string = cow_basic_string<char32_t>;
 
+namespace pmr {
+
+template <typename CharT, typename Traits = std::char_traits<CharT>>
+using cow_basic_string =
+    tiny_stl::cow_basic_string<CharT, Traits, polymorphic_allocator<CharT>>;
+
+using cow_string = cow_basic_string<char>;
+using cow_wstring = cow_basic_string<wchar_t>;
+using cow_u16string = cow_basic_string<char16_t>;
+using cow_u32string = cow_basic_string<char32_t>;
+
+} // namespace pmr
+
 namespace {
 
 template <typename CharT, typename T>
@@ -6,7 +6,8 @@
 
 #include <initializer_list>
 
-#include "memory.h"
+#include "memory.hpp"
+#include "stats.hpp"
 
 namespace tiny_stl {
 
@@ -28,8 +29,18 @@ namespace tiny_stl {
 //            |
 //           node
 //
+// A buffer holds BlockSize elements, 512 bytes of them by default.
+
+namespace {
 
 template <typename T>
+constexpr size_t dequeBlockSize() {
+    return sizeof(T) < 512 ? 512 / sizeof(T) : 1;
+}
+
+} // namespace
+
+template <typename T, size_t BlockSize = dequeBlockSize<T>()>
 struct DequeConstIterator {
     using iterator_category = random_access_iterator_tag;
     using value_type = T;
@@ -39,12 +50,12 @@ struct DequeConstIterator {
     using difference_type = ptrdiff_t;
 
     using MapPtr = T**;
-    using Self = DequeConstIterator<T>;
+    using Self = DequeConstIterator<T, BlockSize>;
+
+    static_assert(BlockSize > 0, "a deque buffer holds at least one element");
 
     constexpr static size_type buffer_size() {
-        constexpr size_type sz = sizeof(T);
-        return sz < 512 ? static_cast<size_type>(512 / sz)
-                        : static_cast<size_type>(1);
+        return BlockSize;
     }
 
     T* cur;      // point to current element
@@ -92,7 +103,7 @@ struct DequeConstIterator {
     }
 
     Self operator++(int) {
-        Self tmp;
+        Self tmp = *this;
         ++*this;
         return tmp;
     }
@@ -107,7 +118,7 @@ struct DequeConstIterator {
     }
 
     Self operator--(int) {
-        Self tmp;
+        Self tmp = *this;
         --*this;
         return tmp;
     }
@@ -186,17 +197,17 @@ struct DequeConstIterator {
     bool operator>=(const Self& rhs) const {
         return !(*this < rhs);
     }
-}; // class DequeConstIterator<T>
+}; // class DequeConstIterator<T, BlockSize>
 
-template <typename T>
-inline DequeConstIterator<T>
-operator+(typename DequeConstIterator<T>::difference_type n,
-          DequeConstIterator<T> iter) {
+template <typename T, size_t BlockSize>
+inline DequeConstIterator<T, BlockSize>
+operator+(typename DequeConstIterator<T, BlockSize>::difference_type n,
+          DequeConstIterator<T, BlockSize> iter) {
     return iter += n;
 }
 
-template <typename T>
-struct DequeIterator : DequeConstIterator<T> {
+template <typename T, size_t BlockSize = dequeBlockSize<T>()>
+struct DequeIterator : DequeConstIterator<T, BlockSize> {
     using iterator_category = random_access_iterator_tag;
     using value_type = T;
     using pointer = T*;
@@ -205,8 +216,8 @@ struct DequeIterator : DequeConstIterator<T> {
     using difference_type = ptrdiff_t;
 
     using MapPtr = T**;
-    using Base = DequeConstIterator<T>;
-    using Self = DequeIterator<T>;
+    using Base = DequeConstIterator<T, BlockSize>;
+    using Self = DequeIterator<T, BlockSize>;
 
     using Base::cur;
 
@@ -240,7 +251,7 @@ struct DequeIterator : DequeConstIterator<T> {
     }
 
     Self operator++(int) {
-        Self tmp;
+        Self tmp = *this;
         ++*this;
         return tmp;
     }
@@ -251,7 +262,7 @@ struct DequeIterator : DequeConstIterator<T> {
     }
 
     Self operator--(int) {
-        Self tmp;
+        Self tmp = *this;
         --*this;
         return tmp;
     }
@@ -285,15 +296,16 @@ struct DequeIterator : DequeConstIterator<T> {
     reference operator[](difference_type n) const {
         return *(*this + n);
     }
-}; // class DequeIterator<T>
+}; // class DequeIterator<T, BlockSize>
 
-template <typename T>
-inline DequeIterator<T> operator+(typename DequeIterator<T>::difference_type n,
-                                  DequeIterator<T> iter) {
+template <typename T, size_t BlockSize>
+inline DequeIterator<T, BlockSize>
+operator+(typename DequeIterator<T, BlockSize>::difference_type n,
+          DequeIterator<T, BlockSize> iter) {
     return iter += n;
 }
 
-template <typename T, typename Alloc>
+template <typename T, typename Alloc, size_t BlockSize>
 class DequeBase {
 public:
     using value_type = T;
@@ -304,8 +316,8 @@ public:
     using const_pointer = const T*;
     using reference = T&;
     using const_reference = const T&;
-    using iterator = DequeIterator<T>;
-    using const_iterator = DequeConstIterator<T>;
+    using iterator = DequeIterator<T, BlockSize>;
+    using const_iterator = DequeConstIterator<T, BlockSize>;
     using reverse_iterator = tiny_stl::reverse_iterator<iterator>;
     using const_reverse_iterator = tiny_stl::reverse_iterator<const_iterator>;
 
@@ -315,16 +327,28 @@ protected:
         typename allocator_traits<Alloc>::template rebind_alloc<pointer>;
 
 protected:
+    constexpr static const size_type kBufferSize = iterator::buffer_size();
+
+    constexpr static const size_type kSmallestSize = 8;
+
+    // freed buffers kept for the next allocateNode(), a queue moving
+    // through the map reuses them instead of calling the allocator
+    constexpr static const size_type kSpareBuffers = 4;
+
     iterator start;
     iterator finish;
     MapPtr map_ptr;
     size_type map_size;
     Alloc alloc;
     AlPtr alloc_map;
+    T* spare[kSpareBuffers];
+    size_type spare_count;
 
-    constexpr static const size_type kBufferSize = iterator::buffer_size();
-
-    constexpr static const size_type kSmallestSize = 8;
+#ifdef TINY_STL_STATS
+    size_type map_reallocations = 0;
+    size_type map_recentres = 0;
+    size_type buffer_allocations = 0;
+#endif
 
 protected:
     MapPtr allocateMap(size_type n) {
@@ -343,20 +367,38 @@ protected:
     }
 
     T* allocateNode() {
-        T* node = nullptr;
-        try {
-            node = alloc.allocate(kBufferSize);
-            return node;
-        } catch (...) {
-            deallocateNode(node);
-            throw;
-        }
+        if (spare_count > 0)
+            return spare[--spare_count];
+
+#ifdef TINY_STL_STATS
+        ++buffer_allocations;
+#endif
+        return alloc.allocate(kBufferSize);
     }
 
     void deallocateNode(T* p) {
         alloc.deallocate(p, kBufferSize);
     }
 
+    // the elements of p are destroyed
+    void recycleNode(T* p) {
+        if (spare_count < kSpareBuffers)
+            spare[spare_count++] = p;
+        else
+            deallocateNode(p);
+    }
+
+    void releaseSpares() noexcept {
+        for (; spare_count > 0; --spare_count)
+            deallocateNode(spare[spare_count - 1]);
+    }
+
+    void swapSpares(DequeBase& rhs) noexcept {
+        for (size_type i = 0; i < kSpareBuffers; ++i)
+            tiny_stl::swap(spare[i], rhs.spare[i]);
+        tiny_stl::swap(spare_count, rhs.spare_count);
+    }
+
     void initializerMap(size_type n) {
         size_type num_nodes = n / kBufferSize + 1;
 
@@ -390,30 +432,46 @@ protected:
 
     void deallocNodes(MapPtr nstart, MapPtr nfinish) {
         for (MapPtr cur = nstart; cur != nfinish; ++cur)
-            if (cur != nullptr)
+            if (*cur != nullptr)
                 deallocateNode(*cur);
     }
 
+    // deallocate buffers and map, elements must be destroyed
+    void tidyMap() {
+        releaseSpares();
+        if (map_ptr != nullptr) {
+            deallocNodes(start.node, finish.node + 1);
+            deallocateMap(map_ptr, map_size);
+
+            map_ptr = nullptr;
+            map_size = 0;
+            start = iterator();
+            finish = iterator();
+        }
+    }
+
 public:
     DequeBase(const Alloc& a)
-        : start(), finish(), map_ptr(), map_size(0), alloc(a), alloc_map() {
+        : start(), finish(), map_ptr(), map_size(0), alloc(a), alloc_map(a),
+          spare(), spare_count(0) {
     }
 
     DequeBase(const Alloc& a, size_type num_elements)
-        : start(), finish(), map_ptr(), map_size(0), alloc(a), alloc_map() {
+        : start(), finish(), map_ptr(), map_size(0), alloc(a), alloc_map(a),
+          spare(), spare_count(0) {
         initializerMap(num_elements);
     }
 
     ~DequeBase() {
-        if (map_ptr != nullptr) {
-            deallocNodes(start.node, finish.node + 1);
-            deallocateMap(map_ptr, map_size);
-        }
+        tidyMap();
     }
-}; // class DequeBase<T, Alloc>
+}; // class DequeBase<T, Alloc, BlockSize>
 
-template <typename T, typename Alloc = allocator<T>>
-class deque : public DequeBase<T, Alloc> {
+// BlockSize elements per buffer, a larger one means fewer allocations
+// and map entries, a smaller one less memory for a short deque
+template <typename T, typename Alloc = allocator<T>,
+          size_t BlockSize = dequeBlockSize<T>()>
+class deque : public DequeBase<T, Alloc, BlockSize> {
 public:
     static_assert(is_same<T, typename Alloc::value_type>::value,
                   "Allocator::value_type is not the same as T");
@@ -427,8 +485,8 @@ public:
     using const_pointer = const T*;
     using reference = T&;
     using const_reference = const T&;
-    using iterator = DequeIterator<T>;
-    using const_iterator = DequeConstIterator<T>;
+    using iterator = DequeIterator<T, BlockSize>;
+    using const_iterator = DequeConstIterator<T, BlockSize>;
     using reverse_iterator = tiny_stl::reverse_iterator<iterator>;
     using const_reverse_iterator = tiny_stl::reverse_iterator<const_iterator>;
 
@@ -436,8 +494,8 @@ protected:
     using MapPtr = pointer*;
     using AlPtr =
         typename allocator_traits<Alloc>::template rebind_alloc<pointer>;
-    using Base = DequeBase<T, Alloc>;
-    using Self = deque<T, Alloc>;
+    using Base = DequeBase<T, Alloc, BlockSize>;
+    using Self = deque<T, Alloc, BlockSize>;
 
 private:
     using Base::alloc;
@@ -447,6 +505,7 @@ private:
     using Base::kBufferSize;
     using Base::map_ptr;
     using Base::map_size;
+    using Base::recycleNode;
     using Base::start;
 
 private:
@@ -517,6 +576,7 @@ public:
 
 private:
     void assignMove(deque&& rhs, true_type) {
+        this->swapSpares(rhs);
         this->map_ptr = rhs.map_ptr;
         this->map_size = rhs.map_size;
         this->start = tiny_stl::move(rhs.start);
@@ -528,19 +588,20 @@ private:
         rhs.finish = iterator();
     }
 
-    template <typename Iter>
-    void constructHelper(Iter first, Iter last) {
-        while (first != last)
-            emplace_back(*first);
+    // move individually, the map must be initialized
+    void moveElements(deque&& rhs) {
+        for (auto first = rhs.begin(); first != rhs.end(); ++first)
+            emplace_back(tiny_stl::move(*first));
     }
 
     void assignMove(deque&& rhs, false_type) {
-        if (this->alloc == rhs.alloc)
+        if (this->alloc == rhs.alloc) {
             assignMove(tiny_stl::move(rhs), true_type{});
-
-        else
-            constructHelper(tiny_stl::make_move_iterator(begin()),
-                            tiny_stl::make_move_iterator(end()));
+        } else {
+            if (this->map_ptr == nullptr)
+                this->initializerMap(0);
+            moveElements(tiny_stl::move(rhs));
+        }
     }
 
 public:
@@ -572,13 +633,18 @@ public:
     deque& operator=(const deque& rhs) {
         assert(this != tiny_stl::addressof(rhs));
 
-        if (this->alloc != rhs.alloc)
-            tidy();
-
         if (allocator_traits<
                 Alloc>::propagate_on_container_copy_assignment::value) {
-            this->alloc = rhs.alloc;
-            this->alloc_map = rhs.alloc_map;
+            if (this->alloc != rhs.alloc) {
+                tidy();
+                this->tidyMap();
+                this->alloc = rhs.alloc;
+                this->alloc_map = rhs.alloc_map;
+                this->initializerMap(0);
+            } else {
+                this->alloc = rhs.alloc;
+                this->alloc_map = rhs.alloc_map;
+            }
         }
 
         try {
@@ -601,12 +667,22 @@ public:
     deque& operator=(deque&& rhs) noexcept(
         noexcept(allocator_traits<Alloc>::is_always_equal::value)) {
         assert(this != tiny_stl::addressof(rhs));
-        tidy();
-        this->alloc = tiny_stl::move(rhs.alloc);
-        this->alloc_map = tiny_stl::move(rhs.alloc_map);
-        assignMove(tiny_stl::move(rhs),
-                   typename allocator_traits<
-                       Alloc>::propagate_on_container_move_assignment{});
+
+        if (allocator_traits<
+                Alloc>::propagate_on_container_move_assignment::value ||
+            this->alloc == rhs.alloc) {
+            tidy();
+            this->tidyMap();
+            if (allocator_traits<
+                    Alloc>::propagate_on_container_move_assignment::value) {
+                this->alloc = tiny_stl::move(rhs.alloc);
+                this->alloc_map = tiny_stl::move(rhs.alloc_map);
+            }
+            assignMove(tiny_stl::move(rhs), true_type{});
+        } else {
+            clear();
+            assignMove(tiny_stl::move(rhs), false_type{});
+        }
 
         return *this;
     }
@@ -739,10 +815,16 @@ public:
         return static_cast<size_type>(-1);
     }
 
+    // elements per buffer
+    constexpr static size_type buffer_size() noexcept {
+        return kBufferSize;
+    }
+
     void shrink_to_fit() {
         deque tmp{tiny_stl::make_move_iterator(begin()),
                   tiny_stl::make_move_iterator(end())};
         swap(tmp);
+        this->releaseSpares();
     }
 
 public:
@@ -750,7 +832,7 @@ public:
         // Except for the first and last buffers
         for (MapPtr p = start.node + 1; p < finish.node; ++p) {
             destroy(*p, *p + kBufferSize);
-            this->alloc.deallocate(*p, kBufferSize);
+            recycleNode(*p);
         }
 
         // There are at least two buffers
@@ -759,7 +841,7 @@ public:
             destroy(finish.first, finish.cur);
 
             // Release the last buffer, reserve the first buffer
-            this->alloc.deallocate(finish.first, kBufferSize);
+            recycleNode(finish.first);
         } else {
             // There is only one buffer, reserve the buffer, no deallocate
             destroy(start.cur, finish.cur);
@@ -769,47 +851,40 @@ public:
     }
 
 private:
-    // change the map_ptr at the front
-    void reallocateMap(size_type num_add, true_type) {
-        size_type old_num_nodes = finish.node - start.node + 1;
-        size_type new_num_nodes = old_num_nodes + num_add;
+    // make room for num_add buffers at the front or at the back, the
+    // buffers in use are recentred in the old map while it is less than
+    // half full, so a queue moving to the back does not grow the map
+    void reallocateMap(size_type num_add, bool add_at_front) {
+        const size_type old_num_nodes = finish.node - start.node + 1;
+        const size_type new_num_nodes = old_num_nodes + num_add;
 
         MapPtr new_nstart;
-
-        if (map_size > 2 * new_num_nodes) { // no reallocate
-            new_nstart = map_ptr + (map_size - new_num_nodes) / 2 + num_add;
-
-            // Avoid coverage
-            try {
-                if (new_nstart < start.node)
-                    copy(start.node, finish.node + 1, new_nstart);
-                else
-                    copy_backward(start.node, finish.node + 1,
-                                  new_nstart + old_num_nodes);
-            } catch (...) {
-                tidy();
-                throw;
-            }
+        if (map_size > 2 * new_num_nodes) { // recentre, no reallocate
+#ifdef TINY_STL_STATS
+            ++this->map_recentres;
+#endif
+            new_nstart = map_ptr + (map_size - new_num_nodes) / 2 +
+                         (add_at_front ? num_add : 0);
+
+            // the ranges may overlap
+            if (new_nstart < start.node)
+                tiny_stl::copy(start.node, finish.node + 1, new_nstart);
+            else
+                tiny_stl::copy_backward(start.node, finish.node + 1,
+                                        new_nstart + old_num_nodes);
         } else { // reallocate
-            size_type new_map_size =
+#ifdef TINY_STL_STATS
+            ++this->map_reallocations;
+#endif
+            const size_type new_map_size =
                 map_size + tiny_stl::max(map_size, num_add) + 2;
 
-            MapPtr new_map = nullptr;
-            try {
-                new_map = this->alloc_map.allocate(new_map_size);
-                new_nstart =
-                    new_map + (new_map_size - new_num_nodes) / 2 + num_add;
-
-                copy(start.node, finish.node + 1,
-                     new_nstart); // copy origin node to new map
-            } catch (...) {
-
-                tidy();
-                throw;
-            }
-
-            this->alloc_map.deallocate(map_ptr, map_size);
+            MapPtr new_map = this->allocateMap(new_map_size);
+            new_nstart = new_map + (new_map_size - new_num_nodes) / 2 +
+                         (add_at_front ? num_add : 0);
+            tiny_stl::copy(start.node, finish.node + 1, new_nstart);
 
+            this->deallocateMap(map_ptr, map_size);
             map_ptr = new_map;
             map_size = new_map_size;
         }
@@ -819,75 +894,48 @@ private:
         finish.setNode(new_nstart + old_num_nodes - 1);
     }
 
-    // change the map_ptr at the front
-    void reallocateMap(size_type num_add, false_type) {
-        size_type old_num_nodes = finish.node - start.node + 1;
-        size_type new_num_nodes = old_num_nodes + num_add;
-
-        size_type new_map_size =
-            map_size + tiny_stl::max(map_size, num_add) + 2;
-
-        MapPtr new_map = nullptr, new_nstart = nullptr;
-        try {
-            new_map = this->alloc_map.allocate(new_map_size); // reallocate
-            new_nstart = new_map + (new_map_size - new_num_nodes) / 2;
-
-            copy(start.node, finish.node + 1,
-                 new_nstart); // copy origin node to new map
-        } catch (...) {
-            this->alloc_map.deallocate(new_map, new_map_size);
-            throw;
-        }
-
-        this->alloc_map.deallocate(map_ptr, map_size);
-
-        map_ptr = new_map;
-        map_size = new_map_size;
-
-        start.setNode(new_nstart);
-        finish.setNode(new_nstart + old_num_nodes - 1);
-    }
-
     void reserveMapAtFront(size_type num_add) {
-        // change the map_ptr
         if (static_cast<difference_type>(num_add) > start.node - map_ptr)
-            reallocateMap(num_add, true_type{});
+            reallocateMap(num_add, true);
     }
 
     void reserveMapAtBack(size_type num_add) {
-        // change the map_ptr
         if (num_add + 1 + (finish.node - map_ptr) > map_size)
-            reallocateMap(num_add, false_type{});
+            reallocateMap(num_add, false);
     }
 
+    // the deque is unchanged if the construction throws
     template <typename... Args>
     void emplaceFrontAux(Args&&... args) {
         reserveMapAtFront(1);
 
+        T* node = allocateNode();
         try {
-            // allocate a new node
-            *(start.node - 1) = allocateNode();
-
-            start.setNode(start.node - 1);
-            start.cur = start.last - 1;
-            this->alloc.construct(start.cur, tiny_stl::forward<Args>(args)...);
+            this->alloc.construct(node + (kBufferSize - 1),
+                                  tiny_stl::forward<Args>(args)...);
         } catch (...) {
+            recycleNode(node);
+            throw;
         }
+
+        *(start.node - 1) = node;
+        start.setNode(start.node - 1);
+        start.cur = start.last - 1;
     }
 
     template <typename... Args>
     void emplaceBackAux(Args&&... args) {
         reserveMapAtBack(1);
 
+        T* node = allocateNode();
         try {
-            // allocate a new node
-            *(finish.node + 1) = allocateNode();
             this->alloc.construct(finish.cur, tiny_stl::forward<Args>(args)...);
         } catch (...) {
-            tidy();
+            recycleNode(node);
             throw;
         }
 
+        *(finish.node + 1) = node;
         finish.setNode(finish.node + 1);
         finish.cur = finish.first;
     }
@@ -896,16 +944,11 @@ public:
     template <typename... Args>
     void emplace_back(Args&&... args) {
         assert(size() < max_size() - 1);
-        try {
-            if (finish.cur != finish.last - 1) { // There are two or more spaces
-                alloc.construct(finish.cur, tiny_stl::forward<Args>(args)...);
-                ++finish.cur;
-            } else { // There is only one space
-                emplaceBackAux(tiny_stl::forward<Args>(args)...);
-            }
-        } catch (...) {
-            tidy();
-            throw;
+        if (finish.cur != finish.last - 1) { // There are two or more spaces
+            alloc.construct(finish.cur, tiny_stl::forward<Args>(args)...);
+            ++finish.cur;
+        } else { // There is only one space
+            emplaceBackAux(tiny_stl::forward<Args>(args)...);
         }
     }
 
@@ -1044,7 +1087,7 @@ public:
 
 private:
     void popBackAux() {
-        this->deallocateNode(finish.first); // release the last buffer
+        recycleNode(finish.first); // release the last buffer
         finish.setNode(finish.node - 1);
         finish.cur = finish.last - 1;
         this->alloc.destroy(finish.cur);
@@ -1052,7 +1095,7 @@ private:
 
     void popFrontAux() {
         this->alloc.destroy(start.cur);
-        this->deallocateNode(start.first);
+        recycleNode(start.first);
         start.setNode(start.node + 1);
         start.cur = start.first;
     }
@@ -1109,7 +1152,7 @@ public:
                 destroy(start, new_start);
 
                 for (MapPtr cur = start.node; cur < new_start.node; ++cur)
-                    this->deallocateNode(*cur);
+                    recycleNode(*cur);
                 start = new_start;
             } else { // back
                 tiny_stl::move(l, finish, f);
@@ -1118,7 +1161,7 @@ public:
 
                 for (MapPtr cur = new_finish.node + 1; cur <= finish.node;
                      ++cur)
-                    this->deallocateNode(*cur);
+                    recycleNode(*cur);
 
                 finish = new_finish;
             }
@@ -1150,46 +1193,74 @@ public:
         tiny_stl::swap(this->start, rhs.start);
         tiny_stl::swap(this->finish, rhs.finish);
         tiny_stl::swap(this->map_size, rhs.map_size);
+        this->swapSpares(rhs);
     }
 
-}; // class deque<T, Alloc>
+    deque_stats stats() const noexcept {
+        size_type buffers = 0;
+        if (this->map_ptr != nullptr)
+            buffers = this->finish.node - this->start.node + 1;
 
-template <typename T, typename Alloc>
-inline bool operator==(const deque<T, Alloc>& lhs, const deque<T, Alloc>& rhs) {
+#ifdef TINY_STL_STATS
+        return deque_stats{this->size(),        this->map_size,
+                           buffers,             this->map_reallocations,
+                           this->map_recentres, this->buffer_allocations};
+#else
+        return deque_stats{this->size(), this->map_size, buffers, 0, 0, 0};
+#endif
+    }
+}; // class deque<T, Alloc, BlockSize>
+
+template <typename T, typename Alloc, size_t BlockSize>
+inline bool operator==(const deque<T, Alloc, BlockSize>& lhs,
+                       const deque<T, Alloc, BlockSize>& rhs) {
     return lhs.size() == rhs.size() &&
            tiny_stl::equal(lhs.begin(), lhs.end(), rhs.begin());
 }
 
-template <typename T, typename Alloc>
-inline bool operator!=(const deque<T, Alloc>& lhs, const deque<T, Alloc>& rhs) {
+template <typename T, typename Alloc, size_t BlockSize>
+inline bool operator!=(const deque<T, Alloc, BlockSize>& lhs,
+                       const deque<T, Alloc, BlockSize>& rhs) {
     return !(lhs == rhs);
 }
 
-template <typename T, typename Alloc>
-inline bool operator<(const deque<T, Alloc>& lhs, const deque<T, Alloc>& rhs) {
+template <typename T, typename Alloc, size_t BlockSize>
+inline bool operator<(const deque<T, Alloc, BlockSize>& lhs,
+                      const deque<T, Alloc, BlockSize>& rhs) {
     return tiny_stl::lexicographical_compare(lhs.begin(), lhs.end(),
                                              rhs.begin(), rhs.end());
 }
 
-template <typename T, typename Alloc>
-inline bool operator>(const deque<T, Alloc>& lhs, const deque<T, Alloc>& rhs) {
+template <typename T, typename Alloc, size_t BlockSize>
+inline bool operator>(const deque<T, Alloc, BlockSize>& lhs,
+                      const deque<T, Alloc, BlockSize>& rhs) {
     return rhs < lhs;
 }
 
-template <typename T, typename Alloc>
-inline bool operator<=(const deque<T, Alloc>& lhs, const deque<T, Alloc>& rhs) {
+template <typename T, typename Alloc, size_t BlockSize>
+inline bool operator<=(const deque<T, Alloc, BlockSize>& lhs,
+                       const deque<T, Alloc, BlockSize>& rhs) {
     return !(rhs < lhs);
 }
 
-template <typename T, typename Alloc>
-inline bool operator>=(const deque<T, Alloc>& lhs, const deque<T, Alloc>& rhs) {
+template <typename T, typename Alloc, size_t BlockSize>
+inline bool operator>=(const deque<T, Alloc, BlockSize>& lhs,
+                       const deque<T, Alloc, BlockSize>& rhs) {
     return !(lhs < rhs);
 }
 
-template <typename T, typename Alloc>
-inline void swap(deque<T, Alloc>& lhs,
-                 deque<T, Alloc>& rhs) noexcept(noexcept(lhs.swap(rhs))) {
+template <typename T, typename Alloc, size_t BlockSize>
+inline void swap(deque<T, Alloc, BlockSize>& lhs,
+                 deque<T, Alloc, BlockSize>& rhs) noexcept(
+    noexcept(lhs.swap(rhs))) {
     lhs.swap(rhs);
 }
 
+namespace pmr {
+
+template <typename T>
+using deque = tiny_stl::deque<T, polymorphic_allocator<T>>;
+
+} // namespace pmr
+
 } // namespace tiny_stl
@@ -0,0 +1,479 @@
+// Copyright (C) 2021 syn1w
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+#include "algorithm.hpp"
+#include "thread_pool.hpp"
+#include "vector.hpp"
+
+namespace tiny_stl {
+
+namespace execution {
+
+class sequenced_policy {};
+class parallel_policy {};
+class parallel_unsequenced_policy {};
+
+static constexpr sequenced_policy seq{};
+static constexpr parallel_policy par{};
+static constexpr parallel_unsequenced_policy par_unseq{};
+
+} // namespace execution
+
+template <typename T>
+struct is_execution_policy : false_type {};
+
+template <>
+struct is_execution_policy<execution::sequenced_policy> : true_type {};
+
+template <>
+struct is_execution_policy<execution::parallel_policy> : true_type {};
+
+template <>
+struct is_execution_policy<execution::parallel_unsequenced_policy>
+    : true_type {};
+
+template <typename T>
+constexpr bool is_execution_policy_v = is_execution_policy<T>::value;
+
+namespace {
+
+// below this many elements a range is one chunk
+static const std::ptrdiff_t PARALLEL_MIN = 1 << 14;
+
+// each thread takes a few chunks to even out the load
+static const size_t PARALLEL_CHUNKS_PER_THREAD = 4;
+
+template <typename ExPolicy, typename T = void>
+using EnableIfPolicy =
+    enable_if_t<is_execution_policy<decay_t<ExPolicy>>::value, T>;
+
+// parallel with a policy other than seq, over random access iterators
+template <typename ExPolicy, typename... Iters>
+struct ParallelDispatch
+    : bool_constant<
+          !is_same<decay_t<ExPolicy>, execution::sequenced_policy>::value &&
+          conjunction<is_convertible<
+              typename iterator_traits<Iters>::iterator_category,
+              random_access_iterator_tag>...>::value> {};
+
+inline size_t parallelChunkCount(std::ptrdiff_t count, thread_pool& pool) {
+    if (count < 2 * PARALLEL_MIN || pool.size() == 0)
+        return 1;
+
+    const size_t maxChunks = (pool.size() + 1) * PARALLEL_CHUNKS_PER_THREAD;
+    const size_t chunks = static_cast<size_t>(count / PARALLEL_MIN);
+    return chunks < maxChunks ? chunks : maxChunks;
+}
+
+// run fn(chunk, first, last) over the chunks of [0, count)
+template <typename Fn>
+inline size_t parallelChunks(std::ptrdiff_t count, Fn fn) {
+    thread_pool& pool = default_thread_pool();
+    const size_t chunks = parallelChunkCount(count, pool);
+    auto body = [&fn, count, chunks](size_t i) {
+        const std::ptrdiff_t n = static_cast<std::ptrdiff_t>(chunks);
+        const std::ptrdiff_t k = static_cast<std::ptrdiff_t>(i);
+        fn(i, count / n * k + tiny_stl::min(k, count % n),
+           count / n * (k + 1) + tiny_stl::min(k + 1, count % n));
+    };
+    parallelInvoke(pool, chunks, body);
+    return chunks;
+}
+
+// parallel sort:
+// 1. sort 2^k runs in parallel
+// 2. merge the runs pairwise between the range and a buffer, a merge is
+//    split by binary search so each round keeps all threads busy
+
+static const std::ptrdiff_t PARALLEL_SORT_MIN = 1 << 15;
+
+template <typename InIter, typename OutIter, typename Compare>
+inline OutIter mergeMove(InIter first1, InIter last1, InIter first2,
+                         InIter last2, OutIter dst, Compare& cmp) {
+    for (; first1 != last1 && first2 != last2; ++dst) {
+        if (cmp(*first2, *first1)) {
+            *dst = tiny_stl::move(*first2);
+            ++first2;
+        } else {
+            *dst = tiny_stl::move(*first1);
+            ++first1;
+        }
+    }
+
+    dst = tiny_stl::move(first1, last1, dst);
+    return tiny_stl::move(first2, last2, dst);
+}
+
+// merge the runs [bound(2mw), bound(2mw + w)) and
+// [bound(2mw + w), bound(2mw + 2w)) of src to dst, every merge is split
+// into pieces at the same keys of both runs
+template <typename SrcIter, typename DstIter, typename Bound,
+          typename Compare>
+inline void mergeRound(SrcIter src, DstIter dst, size_t runs, size_t width,
+                       Bound& bound, Compare& cmp) {
+    const size_t merges = runs / (2 * width);
+    const size_t pieces = tiny_stl::max(
+        static_cast<size_t>(1),
+        (default_thread_pool().size() + 1) * 2 / merges);
+
+    // the cuts are found before any piece moves an element out of src
+    vector<std::ptrdiff_t> aCuts(merges * (pieces + 1));
+    vector<std::ptrdiff_t> bCuts(merges * (pieces + 1));
+    for (size_t m = 0; m < merges; ++m) {
+        const std::ptrdiff_t a0 = bound(2 * m * width);
+        const std::ptrdiff_t b0 = bound(2 * m * width + width);
+        const std::ptrdiff_t b1 = bound(2 * m * width + 2 * width);
+        const std::ptrdiff_t alen = b0 - a0;
+        const std::ptrdiff_t np = static_cast<std::ptrdiff_t>(pieces);
+        std::ptrdiff_t* const aCut = &aCuts[m * (pieces + 1)];
+        std::ptrdiff_t* const bCut = &bCuts[m * (pieces + 1)];
+
+        aCut[0] = a0;
+        bCut[0] = b0;
+        for (std::ptrdiff_t k = 1; k < np; ++k) {
+            aCut[k] = a0 + alen * k / np;
+            bCut[k] = tiny_stl::lower_bound(src + bCut[k - 1], src + b1,
+                                            src[aCut[k]], cmp) -
+                      src;
+        }
+        aCut[np] = b0;
+        bCut[np] = b1;
+    }
+
+    auto body = [&](size_t task) {
+        const size_t m = task / pieces;
+        const size_t i = m * (pieces + 1) + task % pieces;
+        const std::ptrdiff_t b0 = bCuts[m * (pieces + 1)];
+        mergeMove(src + aCuts[i], src + aCuts[i + 1], src + bCuts[i],
+                  src + bCuts[i + 1], dst + (aCuts[i] + bCuts[i] - b0),
+                  cmp);
+    };
+    parallelInvoke(default_thread_pool(), merges * pieces, body);
+}
+
+template <typename RanIter, typename Compare>
+inline void parallelSort(RanIter first, RanIter last, Compare& cmp) {
+    using T = typename iterator_traits<RanIter>::value_type;
+    const std::ptrdiff_t count = last - first;
+    const size_t threads = default_thread_pool().size() + 1;
+
+    size_t runs = 1;
+    while (runs < threads &&
+           count / static_cast<std::ptrdiff_t>(runs * 2) >= PARALLEL_SORT_MIN)
+        runs *= 2;
+
+    if (runs == 1) {
+        tiny_stl::sort(first, last, cmp);
+        return;
+    }
+
+    auto bound = [count, runs](size_t i) {
+        const std::ptrdiff_t n = static_cast<std::ptrdiff_t>(runs);
+        const std::ptrdiff_t k = static_cast<std::ptrdiff_t>(i);
+        return count / n * k + tiny_stl::min(k, count % n);
+    };
+
+    auto sortRun = [first, &bound, &cmp](size_t i) {
+        tiny_stl::sort(first + bound(i), first + bound(i + 1), cmp);
+    };
+    parallelInvoke(default_thread_pool(), runs, sortRun);
+
+    // the sorted runs move to the buffer, the first round merges them back
+    vector<T> buffer(tiny_stl::make_move_iterator(first),
+                     tiny_stl::make_move_iterator(last));
+    bool inBuffer = true;
+    for (size_t width = 1; width < runs; width *= 2) {
+        if (inBuffer)
+            mergeRound(buffer.begin(), first, runs, width, bound, cmp);
+        else
+            mergeRound(first, buffer.begin(), runs, width, bound, cmp);
+        inBuffer = !inBuffer;
+    }
+
+    if (inBuffer) {
+        auto src = buffer.begin();
+        parallelChunks(count, [src, first](size_t, std::ptrdiff_t lo,
+                                           std::ptrdiff_t hi) {
+            tiny_stl::move(src + lo, src + hi, first + lo);
+        });
+    }
+}
+
+template <typename ExPolicy, typename... Iters>
+using ParallelTag = typename ParallelDispatch<ExPolicy, Iters...>::type;
+
+template <typename RanIter, typename UnaryFunc>
+inline void forEachAux(RanIter first, RanIter last, UnaryFunc& f, true_type) {
+    parallelChunks(last - first, [first, &f](size_t, std::ptrdiff_t lo,
+                                             std::ptrdiff_t hi) {
+        tiny_stl::for_each(first + lo, first + hi, f);
+    });
+}
+
+template <typename InIter, typename UnaryFunc>
+inline void forEachAux(InIter first, InIter last, UnaryFunc& f, false_type) {
+    tiny_stl::for_each(first, last, f);
+}
+
+template <typename RanIter, typename UnaryPred>
+inline IterDiffType<RanIter> countIfAux(RanIter first, RanIter last,
+                                        UnaryPred& pred, true_type) {
+    std::atomic<IterDiffType<RanIter>> total{0};
+    parallelChunks(last - first, [first, &pred, &total](size_t,
+                                                        std::ptrdiff_t lo,
+                                                        std::ptrdiff_t hi) {
+        total.fetch_add(tiny_stl::count_if(first + lo, first + hi, pred));
+    });
+    return total.load();
+}
+
+template <typename InIter, typename UnaryPred>
+inline IterDiffType<InIter> countIfAux(InIter first, InIter last,
+                                       UnaryPred& pred, false_type) {
+    return tiny_stl::count_if(first, last, pred);
+}
+
+// a chunk behind the first match found gives up
+template <typename RanIter, typename UnaryPred>
+inline RanIter findIfAux(RanIter first, RanIter last, UnaryPred& pred,
+                         true_type) {
+    const std::ptrdiff_t count = last - first;
+    std::atomic<std::ptrdiff_t> found{count};
+    parallelChunks(count, [first, &pred, &found](size_t, std::ptrdiff_t lo,
+                                                 std::ptrdiff_t hi) {
+        for (std::ptrdiff_t i = lo; i < hi; ++i) {
+            if (i >= found.load(std::memory_order_relaxed))
+                return;
+
+            if (pred(*(first + i))) {
+                std::ptrdiff_t old = found.load();
+                while (i < old && !found.compare_exchange_weak(old, i))
+                    ;
+                return;
+            }
+        }
+    });
+    return first + found.load();
+}
+
+template <typename InIter, typename UnaryPred>
+inline InIter findIfAux(InIter first, InIter last, UnaryPred& pred,
+                        false_type) {
+    return tiny_stl::find_if(first, last, pred);
+}
+
+template <typename RanIter, typename T>
+inline void fillAux(RanIter first, RanIter last, const T& val, true_type) {
+    parallelChunks(last - first, [first, &val](size_t, std::ptrdiff_t lo,
+                                               std::ptrdiff_t hi) {
+        tiny_stl::fill(first + lo, first + hi, val);
+    });
+}
+
+template <typename FwdIter, typename T>
+inline void fillAux(FwdIter first, FwdIter last, const T& val, false_type) {
+    tiny_stl::fill(first, last, val);
+}
+
+template <typename RanIter1, typename RanIter2>
+inline RanIter2 copyAux(RanIter1 first, RanIter1 last, RanIter2 dst,
+                        true_type) {
+    parallelChunks(last - first, [first, dst](size_t, std::ptrdiff_t lo,
+                                              std::ptrdiff_t hi) {
+        tiny_stl::copy(first + lo, first + hi, dst + lo);
+    });
+    return dst + (last - first);
+}
+
+template <typename InIter, typename OutIter>
+inline OutIter copyAux(InIter first, InIter last, OutIter dst, false_type) {
+    return tiny_stl::copy(first, last, dst);
+}
+
+template <typename RanIter1, typename RanIter2, typename UnaryOp>
+inline RanIter2 transformAux(RanIter1 first, RanIter1 last, RanIter2 dst,
+                             UnaryOp& op, true_type) {
+    parallelChunks(last - first, [first, dst, &op](size_t, std::ptrdiff_t lo,
+                                                   std::ptrdiff_t hi) {
+        tiny_stl::transform(first + lo, first + hi, dst + lo, op);
+    });
+    return dst + (last - first);
+}
+
+template <typename InIter, typename OutIter, typename UnaryOp>
+inline OutIter transformAux(InIter first, InIter last, OutIter dst,
+                            UnaryOp& op, false_type) {
+    return tiny_stl::transform(first, last, dst, op);
+}
+
+// tiny_stl::transform takes one input iterator type for two ranges
+template <typename InIter1, typename InIter2, typename OutIter,
+          typename BinOp>
+inline OutIter transformRange(InIter1 first1, InIter1 last1, InIter2 first2,
+                              OutIter dst, BinOp& op) {
+    for (; first1 != last1; ++first1, ++first2, ++dst)
+        *dst = op(*first1, *first2);
+
+    return dst;
+}
+
+template <typename RanIter1, typename RanIter2, typename RanIter3,
+          typename BinOp>
+inline RanIter3 transformAux(RanIter1 first1, RanIter1 last1, RanIter2 first2,
+                             RanIter3 dst, BinOp& op, true_type) {
+    parallelChunks(last1 - first1, [first1, first2, dst, &op](
+                                       size_t, std::ptrdiff_t lo,
+                                       std::ptrdiff_t hi) {
+        transformRange(first1 + lo, first1 + hi, first2 + lo, dst + lo, op);
+    });
+    return dst + (last1 - first1);
+}
+
+template <typename InIter1, typename InIter2, typename OutIter,
+          typename BinOp>
+inline OutIter transformAux(InIter1 first1, InIter1 last1, InIter2 first2,
+                            OutIter dst, BinOp& op, false_type) {
+    return transformRange(first1, last1, first2, dst, op);
+}
+
+template <typename RanIter, typename Compare>
+inline pair<RanIter, RanIter> minmaxElementAux(RanIter first, RanIter last,
+                                               Compare& cmp, true_type) {
+    if (first == last)
+        return pair<RanIter, RanIter>(first, first);
+
+    vector<pair<RanIter, RanIter>> parts(
+        parallelChunkCount(last - first, default_thread_pool()),
+        pair<RanIter, RanIter>(first, first));
+    parallelChunks(last - first, [first, &cmp, &parts](size_t i,
+                                                       std::ptrdiff_t lo,
+                                                       std::ptrdiff_t hi) {
+        parts[i] = tiny_stl::minmax_element(first + lo, first + hi, cmp);
+    });
+
+    // the first smallest and the last largest, in chunk order
+    pair<RanIter, RanIter> ret = parts[0];
+    for (size_t i = 1; i < parts.size(); ++i) {
+        if (cmp(*parts[i].first, *ret.first))
+            ret.first = parts[i].first;
+        if (!cmp(*parts[i].second, *ret.second))
+            ret.second = parts[i].second;
+    }
+
+    return ret;
+}
+
+template <typename FwdIter, typename Compare>
+inline pair<FwdIter, FwdIter> minmaxElementAux(FwdIter first, FwdIter last,
+                                               Compare& cmp, false_type) {
+    return tiny_stl::minmax_element(first, last, cmp);
+}
+
+template <typename RanIter, typename Compare>
+inline void sortAux(RanIter first, RanIter last, Compare& cmp, true_type) {
+    parallelSort(first, last, cmp);
+}
+
+template <typename RanIter, typename Compare>
+inline void sortAux(RanIter first, RanIter last, Compare& cmp, false_type) {
+    tiny_stl::sort(first, last, cmp);
+}
+
+} // namespace
+
+// seq runs the sequential algorithm, par and par_unseq split random
+// access ranges across default_thread_pool(), short ranges stay on the
+// calling thread, an exception thrown by an element access is rethrown
+
+template <typename ExPolicy, typename FwdIter, typename UnaryFunc>
+inline EnableIfPolicy<ExPolicy> for_each(ExPolicy&&, FwdIter first,
+                                         FwdIter last, UnaryFunc f) {
+    forEachAux(first, last, f, ParallelTag<ExPolicy, FwdIter>{});
+}
+
+template <typename ExPolicy, typename FwdIter, typename UnaryPred>
+inline EnableIfPolicy<ExPolicy, IterDiffType<FwdIter>>
+count_if(ExPolicy&&, FwdIter first, FwdIter last, UnaryPred pred) {
+    return countIfAux(first, last, pred, ParallelTag<ExPolicy, FwdIter>{});
+}
+
+template <typename ExPolicy, typename FwdIter, typename T>
+inline EnableIfPolicy<ExPolicy, IterDiffType<FwdIter>>
+count(ExPolicy&&, FwdIter first, FwdIter last, const T& val) {
+    auto pred = [&val](const auto& v) { return v == val; };
+    return countIfAux(first, last, pred, ParallelTag<ExPolicy, FwdIter>{});
+}
+
+template <typename ExPolicy, typename FwdIter, typename UnaryPred>
+inline EnableIfPolicy<ExPolicy, FwdIter>
+find_if(ExPolicy&&, FwdIter first, FwdIter last, UnaryPred pred) {
+    return findIfAux(first, last, pred, ParallelTag<ExPolicy, FwdIter>{});
+}
+
+template <typename ExPolicy, typename FwdIter, typename T>
+inline EnableIfPolicy<ExPolicy> fill(ExPolicy&&, FwdIter first, FwdIter last,
+                                     const T& val) {
+    fillAux(first, last, val, ParallelTag<ExPolicy, FwdIter>{});
+}
+
+template <typename ExPolicy, typename FwdIter1, typename FwdIter2>
+inline EnableIfPolicy<ExPolicy, FwdIter2>
+copy(ExPolicy&&, FwdIter1 first, FwdIter1 last, FwdIter2 dst) {
+    return copyAux(first, last, dst,
+                   ParallelTag<ExPolicy, FwdIter1, FwdIter2>{});
+}
+
+template <typename ExPolicy, typename FwdIter1, typename FwdIter2,
+          typename UnaryOp>
+inline EnableIfPolicy<ExPolicy, FwdIter2>
+transform(ExPolicy&&, FwdIter1 first, FwdIter1 last, FwdIter2 dst,
+          UnaryOp op) {
+    return transformAux(first, last, dst, op,
+                        ParallelTag<ExPolicy, FwdIter1, FwdIter2>{});
+}
+
+template <typename ExPolicy, typename FwdIter1, typename FwdIter2,
+          typename FwdIter3, typename BinOp>
+inline EnableIfPolicy<ExPolicy, FwdIter3>
+transform(ExPolicy&&, FwdIter1 first1, FwdIter1 last1, FwdIter2 first2,
+          FwdIter3 dst, BinOp op) {
+    return transformAux(
+        first1, last1, first2, dst, op,
+        ParallelTag<ExPolicy, FwdIter1, FwdIter2, FwdIter3>{});
+}
+
+template <typename ExPolicy, typename FwdIter, typename Compare>
+inline EnableIfPolicy<ExPolicy, pair<FwdIter, FwdIter>>
+minmax_element(ExPolicy&&, FwdIter first, FwdIter last, Compare cmp) {
+    return minmaxElementAux(first, last, cmp,
+                            ParallelTag<ExPolicy, FwdIter>{});
+}
+
+template <typename ExPolicy, typename FwdIter>
+inline EnableIfPolicy<ExPolicy, pair<FwdIter, FwdIter>>
+minmax_element(ExPolicy&&, FwdIter first, FwdIter last) {
+    tiny_stl::less<> cmp;
+    return minmaxElementAux(first, last, cmp,
+                            ParallelTag<ExPolicy, FwdIter>{});
+}
+
+template <typename ExPolicy, typename RanIter, typename Compare>
+inline EnableIfPolicy<ExPolicy> sort(ExPolicy&&, RanIter first, RanIter last,
+                                     Compare cmp) {
+    sortAux(first, last, cmp, ParallelTag<ExPolicy, RanIter>{});
+}
+
+template <typename ExPolicy, typename RanIter>
+inline EnableIfPolicy<ExPolicy> sort(ExPolicy&&, RanIter first,
+                                     RanIter last) {
+    tiny_stl::less<> cmp;
+    sortAux(first, last, cmp, ParallelTag<ExPolicy, RanIter>{});
+}
+
+} // namespace tiny_stl
@@ -0,0 +1,1065 @@
+// Copyright (C) 2021 syn1w
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+
+#include "hashtable.hpp"
+
+// Group probing backend, define TINY_STL_NO_SIMD to force the portable one
+#if !defined(TINY_STL_NO_SIMD) &&                                              \
+    (defined(__SSE2__) || defined(_M_X64) ||                                   \
+     (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define TINY_STL_FLAT_SSE2 1
+#include <emmintrin.h>
+#elif !defined(TINY_STL_NO_SIMD) && defined(__ARM_NEON)
+#define TINY_STL_FLAT_NEON 1
+#include <arm_neon.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace tiny_stl {
+
+// Open addressing hash table (SwissTable-like)
+//
+// One control byte per slot, the values are stored inline in a slot array.
+//
+//   ctrl:  | h2 | E  | D  | h2 | E  | ... | h2 | S |
+//   slots: | v  |    |    | v  |    | ... | v  |
+//
+// full:     0b0xxxxxxx, 7-bit hash fragment (h2)
+// empty:    0b10000000
+// deleted:  0b11111110 (tombstone)
+// sentinel: 0b11111111 (ctrl[capacity], stops the iterator)
+//
+// The slots are probed by groups of kFlatGroupWidth control bytes, a group
+// is matched against h2 at once (SSE2, NEON or a portable loop).
+
+using FlatCtrl = signed char;
+
+enum FlatCtrlFlag : FlatCtrl {
+    kFlatEmpty = -128,
+    kFlatDeleted = -2,
+    kFlatSentinel = -1
+};
+
+inline bool flatIsFull(FlatCtrl c) noexcept {
+    return c >= 0;
+}
+
+inline bool flatIsEmptyOrDeleted(FlatCtrl c) noexcept {
+    return c < kFlatSentinel;
+}
+
+// h1 selects the probe start, h2 is stored in the control byte
+inline size_t flatH1(size_t hash) noexcept {
+    return hash >> 7;
+}
+
+inline FlatCtrl flatH2(size_t hash) noexcept {
+    return static_cast<FlatCtrl>(hash & 0x7F);
+}
+
+// control bytes of a table without slots, begin() == end()
+inline FlatCtrl* flatEmptyCtrl() noexcept {
+    alignas(16) static FlatCtrl ctrl[16] = {
+        kFlatSentinel, kFlatEmpty, kFlatEmpty, kFlatEmpty,
+        kFlatEmpty,    kFlatEmpty, kFlatEmpty, kFlatEmpty,
+        kFlatEmpty,    kFlatEmpty, kFlatEmpty, kFlatEmpty,
+        kFlatEmpty,    kFlatEmpty, kFlatEmpty, kFlatEmpty};
+    return ctrl;
+}
+
+inline size_t flatCountTrailingZeros(uint64_t x) noexcept {
+    assert(x != 0);
+#if defined(_MSC_VER) && defined(_WIN64)
+    unsigned long idx;
+    _BitScanForward64(&idx, x);
+    return idx;
+#elif defined(_MSC_VER)
+    unsigned long idx;
+    if (_BitScanForward(&idx, static_cast<unsigned long>(x)))
+        return idx;
+    _BitScanForward(&idx, static_cast<unsigned long>(x >> 32));
+    return idx + 32;
+#else
+    return static_cast<size_t>(__builtin_ctzll(x));
+#endif
+}
+
+// all control bytes of a group are checked at once
+static const size_t kFlatGroupWidth = 16;
+
+// The matched slots of a group, every slot takes (1 << Shift) bits
+template <int Shift>
+class FlatBitMask {
+private:
+    uint64_t mMask;
+
+public:
+    explicit FlatBitMask(uint64_t mask) : mMask(mask) {
+    }
+
+    explicit operator bool() const noexcept {
+        return mMask != 0;
+    }
+
+    // the index of the first matched slot
+    size_t lowest() const noexcept {
+        return flatCountTrailingZeros(mMask) >> Shift;
+    }
+
+    // drop the first matched slot
+    FlatBitMask& operator++() noexcept {
+        mMask &= mMask - 1;
+        return *this;
+    }
+};
+
+// scalar fallback, one control byte at a time
+class FlatGroupPortable {
+public:
+    using BitMask = FlatBitMask<0>;
+
+private:
+    FlatCtrl mCtrl[kFlatGroupWidth];
+
+    template <typename Pred>
+    BitMask maskIf(Pred pred) const noexcept {
+        uint64_t mask = 0;
+        for (size_t i = 0; i != kFlatGroupWidth; ++i) {
+            if (pred(mCtrl[i]))
+                mask |= uint64_t{1} << i;
+        }
+        return BitMask(mask);
+    }
+
+public:
+    explicit FlatGroupPortable(const FlatCtrl* pos) noexcept {
+        memcpy(mCtrl, pos, kFlatGroupWidth);
+    }
+
+    BitMask match(FlatCtrl h2) const noexcept {
+        return maskIf([h2](FlatCtrl c) { return c == h2; });
+    }
+
+    BitMask maskEmpty() const noexcept {
+        return maskIf([](FlatCtrl c) { return c == kFlatEmpty; });
+    }
+
+    BitMask maskEmptyOrDeleted() const noexcept {
+        return maskIf([](FlatCtrl c) { return flatIsEmptyOrDeleted(c); });
+    }
+};
+
+#if defined(TINY_STL_FLAT_SSE2)
+
+class FlatGroupSse2 {
+public:
+    using BitMask = FlatBitMask<0>;
+
+private:
+    __m128i mCtrl;
+
+    static BitMask toMask(__m128i cmp) noexcept {
+        return BitMask(static_cast<uint64_t>(
+            static_cast<unsigned>(_mm_movemask_epi8(cmp))));
+    }
+
+public:
+    explicit FlatGroupSse2(const FlatCtrl* pos) noexcept
+        : mCtrl(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pos))) {
+    }
+
+    BitMask match(FlatCtrl h2) const noexcept {
+        return toMask(_mm_cmpeq_epi8(_mm_set1_epi8(h2), mCtrl));
+    }
+
+    BitMask maskEmpty() const noexcept {
+        return toMask(_mm_cmpeq_epi8(_mm_set1_epi8(kFlatEmpty), mCtrl));
+    }
+
+    // signed compare: empty and deleted are less than the sentinel
+    BitMask maskEmptyOrDeleted() const noexcept {
+        return toMask(_mm_cmpgt_epi8(_mm_set1_epi8(kFlatSentinel), mCtrl));
+    }
+};
+
+using FlatGroup = FlatGroupSse2;
+
+#elif defined(TINY_STL_FLAT_NEON)
+
+class FlatGroupNeon {
+public:
+    // no movemask, narrow every byte of the compare result to a nibble
+    using BitMask = FlatBitMask<2>;
+
+private:
+    int8x16_t mCtrl;
+
+    static BitMask toMask(uint8x16_t cmp) noexcept {
+        const uint8x8_t nibbles = vshrn_n_u16(vreinterpretq_u16_u8(cmp), 4);
+        const uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(nibbles), 0);
+        return BitMask(mask & 0x8888888888888888ULL);
+    }
+
+public:
+    explicit FlatGroupNeon(const FlatCtrl* pos) noexcept
+        : mCtrl(vld1q_s8(pos)) {
+    }
+
+    BitMask match(FlatCtrl h2) const noexcept {
+        return toMask(vceqq_s8(vdupq_n_s8(h2), mCtrl));
+    }
+
+    BitMask maskEmpty() const noexcept {
+        return toMask(vceqq_s8(vdupq_n_s8(kFlatEmpty), mCtrl));
+    }
+
+    BitMask maskEmptyOrDeleted() const noexcept {
+        return toMask(vcltq_s8(mCtrl, vdupq_n_s8(kFlatSentinel)));
+    }
+};
+
+using FlatGroup = FlatGroupNeon;
+
+#else
+
+using FlatGroup = FlatGroupPortable;
+
+#endif
+
+// probe policy: the distance between the i-th and (i+1)-th probed group
+struct linear_probing {
+    static size_t step(size_t /* i */) noexcept {
+        return 1;
+    }
+};
+
+// triangular numbers, visit every group of a power-of-two table
+struct quadratic_probing {
+    static size_t step(size_t i) noexcept {
+        return i;
+    }
+};
+
+// The groups are aligned to kFlatGroupWidth, so a group never wraps around
+template <typename Probe>
+class FlatProbeSeq {
+private:
+    size_t mMask; // number of groups - 1
+    size_t mGroup;
+    size_t mIndex;
+
+public:
+    FlatProbeSeq(size_t hash, size_t capacity)
+        : mMask(capacity / kFlatGroupWidth - 1), mGroup(hash & mMask),
+          mIndex(0) {
+    }
+
+    // the first slot of the current group
+    size_t offset() const noexcept {
+        return mGroup * kFlatGroupWidth;
+    }
+
+    size_t offset(size_t i) const noexcept {
+        return offset() + i;
+    }
+
+    void next() noexcept {
+        ++mIndex;
+        mGroup = (mGroup + Probe::step(mIndex)) & mMask;
+    }
+};
+
+template <typename T, typename HashTableType>
+struct FlatHashIterator;
+
+template <typename T, typename HashTableType>
+struct FlatHashConstIterator {
+    using iterator_category = forward_iterator_tag;
+    using value_type = T;
+    using difference_type = ptrdiff_t;
+    using reference = const T&;
+    using pointer = const T*;
+
+    const FlatCtrl* ctrl;
+    T* slot;
+
+    FlatHashConstIterator() : ctrl(nullptr), slot(nullptr) {
+    }
+
+    FlatHashConstIterator(const FlatCtrl* c, T* s) : ctrl(c), slot(s) {
+    }
+
+    FlatHashConstIterator(const FlatHashConstIterator&) = default;
+
+    FlatHashConstIterator(
+        const FlatHashIterator<T, remove_const_t<HashTableType>>& rhs)
+        : ctrl(rhs.ctrl), slot(rhs.slot) {
+    }
+
+    reference operator*() const {
+        return *slot;
+    }
+
+    pointer operator->() const {
+        return pointer_traits<pointer>::pointer_to(**this);
+    }
+
+    // skip empty and deleted slots, stop at the sentinel
+    void skipEmptyOrDeleted() noexcept {
+        while (flatIsEmptyOrDeleted(*ctrl)) {
+            ++ctrl;
+            ++slot;
+        }
+    }
+
+    FlatHashConstIterator& operator++() {
+        ++ctrl;
+        ++slot;
+        skipEmptyOrDeleted();
+        return *this;
+    }
+
+    FlatHashConstIterator operator++(int) {
+        FlatHashConstIterator tmp = *this;
+        ++*this;
+        return tmp;
+    }
+
+    bool operator==(const FlatHashConstIterator& rhs) const {
+        return ctrl == rhs.ctrl;
+    }
+
+    bool operator!=(const FlatHashConstIterator& rhs) const {
+        return ctrl != rhs.ctrl;
+    }
+};
+
+template <typename T, typename HashTableType>
+struct FlatHashIterator {
+    using iterator_category = forward_iterator_tag;
+    using value_type = T;
+    using difference_type = ptrdiff_t;
+    using reference = T&;
+    using pointer = T*;
+
+    const FlatCtrl* ctrl;
+    T* slot;
+
+    FlatHashIterator() : ctrl(nullptr), slot(nullptr) {
+    }
+
+    FlatHashIterator(const FlatCtrl* c, T* s) : ctrl(c), slot(s) {
+    }
+
+    reference operator*() const {
+        return *slot;
+    }
+
+    pointer operator->() const {
+        return pointer_traits<pointer>::pointer_to(**this);
+    }
+
+    void skipEmptyOrDeleted() noexcept {
+        while (flatIsEmptyOrDeleted(*ctrl)) {
+            ++ctrl;
+            ++slot;
+        }
+    }
+
+    FlatHashIterator& operator++() {
+        ++ctrl;
+        ++slot;
+        skipEmptyOrDeleted();
+        return *this;
+    }
+
+    FlatHashIterator operator++(int) {
+        FlatHashIterator tmp = *this;
+        ++*this;
+        return tmp;
+    }
+
+    bool operator==(const FlatHashIterator& rhs) const {
+        return ctrl == rhs.ctrl;
+    }
+
+    bool operator!=(const FlatHashIterator& rhs) const {
+        return ctrl != rhs.ctrl;
+    }
+};
+
+// writes the control bytes and slots as they are, see snapshot.hpp
+struct FlatHashSnapshot;
+
+// Only unique keys, so only used by unordered_map and unordered_set
+template <typename T, typename Hash, typename KeyEqual, typename Alloc,
+          bool isMap, typename Probe = quadratic_probing>
+class FlatHashTable {
+    friend struct FlatHashSnapshot;
+
+public:
+    using key_type = typename AssociatedTypeHelper<T, isMap>::key_type;
+    using mapped_type = typename AssociatedTypeHelper<T, isMap>::mapped_type;
+    using value_type = T;
+    using size_type = typename Alloc::size_type;
+    using difference_type = typename Alloc::difference_type;
+    using hasher = Hash;
+    using key_equal = KeyEqual;
+    using allocator_type = Alloc;
+    using reference = value_type&;
+    using const_reference = const value_type&;
+    using AlTraits = allocator_traits<Alloc>;
+    using pointer = typename AlTraits::pointer;
+    using const_pointer = typename AlTraits::const_pointer;
+
+    using iterator = FlatHashIterator<T, FlatHashTable>;
+    using const_iterator = FlatHashConstIterator<T, const FlatHashTable>;
+
+    // every slot is a bucket which holds zero or one element
+    using local_iterator = T*;
+    using const_local_iterator = const T*;
+
+    using AlSlot = typename AlTraits::template rebind_alloc<T>;
+    using AlSlotTraits = allocator_traits<AlSlot>;
+    using AlCtrl = typename AlTraits::template rebind_alloc<FlatCtrl>;
+    using AlCtrlTraits = allocator_traits<AlCtrl>;
+    using ProbeSeq = FlatProbeSeq<Probe>;
+    using Self = FlatHashTable<T, Hash, KeyEqual, Alloc, isMap, Probe>;
+
+    static constexpr size_type kMinCapacity = kFlatGroupWidth;
+
+private:
+    FlatCtrl* ctrl;        // capacity + 1 control bytes
+    T* slots;              // capacity slots
+    size_type capacity;    // 0 or power of two
+    size_type num_elements;
+    size_type num_deleted; // tombstones
+    size_type growth_limit;
+    float maxfactor;
+    hasher hashfunc;
+    key_equal key_equ;
+    AlSlot alloc;
+
+private:
+    // map
+    const key_type& getKey(const T& val, true_type) const {
+        return val.first;
+    }
+
+    // set
+    const key_type& getKey(const T& val, false_type) const {
+        return val;
+    }
+
+    const key_type& get_key(const T& val) const {
+        return getKey(val, tiny_stl::bool_constant<isMap>{});
+    }
+
+    // at least one empty slot is left, so the probe always terminates
+    size_type growthLimit(size_type cap) const noexcept {
+        if (cap == 0)
+            return 0;
+        size_type limit =
+            static_cast<size_type>(static_cast<float>(cap) * maxfactor);
+        if (limit >= cap)
+            limit = cap - 1;
+        return limit == 0 ? 1 : limit;
+    }
+
+    static size_type normalizeCapacity(size_type n) noexcept {
+        size_type cap = kMinCapacity;
+        while (cap < n)
+            cap <<= 1;
+        return cap;
+    }
+
+    void resetEmpty() noexcept {
+        ctrl = flatEmptyCtrl();
+        slots = nullptr;
+        capacity = 0;
+        num_elements = 0;
+        num_deleted = 0;
+        growth_limit = 0;
+    }
+
+    FlatCtrl* allocateCtrl(size_type cap) {
+        AlCtrl al(alloc);
+        FlatCtrl* c = AlCtrlTraits::allocate(al, cap + 1);
+        memset(c, kFlatEmpty, cap);
+        c[cap] = kFlatSentinel;
+        return c;
+    }
+
+    void deallocateStorage(FlatCtrl* c, T* s, size_type cap) noexcept {
+        if (cap == 0)
+            return;
+        AlCtrl al(alloc);
+        AlCtrlTraits::deallocate(al, c, cap + 1);
+        AlSlotTraits::deallocate(alloc, s, cap);
+    }
+
+    void destroyElements() noexcept {
+        for (size_type i = 0; i != capacity; ++i) {
+            if (flatIsFull(ctrl[i]))
+                AlSlotTraits::destroy(alloc, slots + i);
+        }
+    }
+
+    void tidy() noexcept {
+        destroyElements();
+        deallocateStorage(ctrl, slots, capacity);
+        resetEmpty();
+    }
+
+    // the position of key, or capacity if key isn't in the table
+    //
+    // only the slots whose h2 matches are compared by key_equ,
+    // the probe stops at the first group which has an empty slot
+    size_type findAux(const key_type& key, size_t hash) const {
+        if (capacity == 0)
+            return capacity;
+
+        const FlatCtrl h2 = flatH2(hash);
+        ProbeSeq seq(flatH1(hash), capacity);
+        for (;;) {
+            const FlatGroup group(ctrl + seq.offset());
+            for (auto mask = group.match(h2); mask; ++mask) {
+                const size_type pos = seq.offset(mask.lowest());
+                if (key_equ(get_key(slots[pos]), key))
+                    return pos;
+            }
+            if (group.maskEmpty())
+                return capacity;
+            seq.next();
+        }
+    }
+
+    // the first empty or deleted slot in the probe sequence of hash
+    size_type findFirstNonFull(size_t hash) const noexcept {
+        ProbeSeq seq(flatH1(hash), capacity);
+        for (;;) {
+            const FlatGroup group(ctrl + seq.offset());
+            const auto mask = group.maskEmptyOrDeleted();
+            if (mask)
+                return seq.offset(mask.lowest());
+            seq.next();
+        }
+    }
+
+    size_type groupStart(size_type pos) const noexcept {
+        return pos & ~(kFlatGroupWidth - 1);
+    }
+
+    // rebuild the table with newCapacity slots and drop the tombstones
+    void resize(size_type newCapacity) {
+        FlatCtrl* oldCtrl = ctrl;
+        T* oldSlots = slots;
+        const size_type oldCapacity = capacity;
+
+        ctrl = allocateCtrl(newCapacity);
+        try {
+            slots = AlSlotTraits::allocate(alloc, newCapacity);
+        } catch (...) {
+            AlCtrl al(alloc);
+            AlCtrlTraits::deallocate(al, ctrl, newCapacity + 1);
+            ctrl = oldCtrl;
+            throw;
+        }
+        capacity = newCapacity;
+        num_deleted = 0;
+        growth_limit = growthLimit(newCapacity);
+
+        for (size_type i = 0; i != oldCapacity; ++i) {
+            if (flatIsFull(oldCtrl[i])) {
+                const size_t hash = hashfunc(get_key(oldSlots[i]));
+                const size_type pos = findFirstNonFull(hash);
+                AlSlotTraits::construct(alloc, slots + pos,
+                                        tiny_stl::move(oldSlots[i]));
+                ctrl[pos] = flatH2(hash);
+                AlSlotTraits::destroy(alloc, oldSlots + i);
+            }
+        }
+
+        deallocateStorage(oldCtrl, oldSlots, oldCapacity);
+    }
+
+    void growAux() {
+        if (capacity == 0)
+            resize(kMinCapacity);
+        else if (num_deleted != 0 && num_elements * 2 < growth_limit)
+            resize(capacity); // mostly tombstones, rehash in place
+        else
+            resize(capacity << 1);
+    }
+
+    // find a free slot for hash, grow if the empty slot can't be used
+    size_type prepareInsert(size_t hash) {
+        if (capacity == 0)
+            growAux();
+
+        size_type pos = findFirstNonFull(hash);
+        while (ctrl[pos] == kFlatEmpty &&
+               num_elements + num_deleted >= growth_limit) {
+            growAux();
+            pos = findFirstNonFull(hash);
+        }
+
+        return pos;
+    }
+
+    void setCtrl(size_type pos, FlatCtrl c) noexcept {
+        if (ctrl[pos] == kFlatDeleted)
+            --num_deleted;
+        ctrl[pos] = c;
+    }
+
+    iterator makeIter(size_type pos) noexcept {
+        return iterator(ctrl + pos, slots + pos);
+    }
+
+    const_iterator makeIter(size_type pos) const noexcept {
+        return const_iterator(ctrl + pos, slots + pos);
+    }
+
+    void copyAux(const FlatHashTable& rhs) {
+        if (rhs.capacity == 0)
+            return;
+
+        ctrl = allocateCtrl(rhs.capacity);
+        try {
+            slots = AlSlotTraits::allocate(alloc, rhs.capacity);
+        } catch (...) {
+            AlCtrl al(alloc);
+            AlCtrlTraits::deallocate(al, ctrl, rhs.capacity + 1);
+            ctrl = flatEmptyCtrl();
+            throw;
+        }
+        capacity = rhs.capacity;
+        growth_limit = growthLimit(capacity);
+
+        // same hasher, same layout, copy slot by slot
+        try {
+            for (size_type i = 0; i != capacity; ++i) {
+                if (flatIsFull(rhs.ctrl[i])) {
+                    AlSlotTraits::construct(alloc, slots + i, rhs.slots[i]);
+                    ctrl[i] = rhs.ctrl[i];
+                    ++num_elements;
+                } else if (rhs.ctrl[i] == kFlatDeleted) {
+                    ctrl[i] = kFlatDeleted;
+                    ++num_deleted;
+                }
+            }
+        } catch (...) {
+            tidy();
+            throw;
+        }
+    }
+
+    void stealAux(FlatHashTable& rhs) noexcept {
+        ctrl = rhs.ctrl;
+        slots = rhs.slots;
+        capacity = rhs.capacity;
+        num_elements = rhs.num_elements;
+        num_deleted = rhs.num_deleted;
+        growth_limit = rhs.growth_limit;
+        rhs.resetEmpty();
+    }
+
+public:
+    FlatHashTable(size_type n, const Alloc& al = Alloc(),
+                  const hasher& hf = hasher(),
+                  const key_equal& equ = key_equal())
+        : maxfactor(0.875f), hashfunc(hf), key_equ(equ), alloc(al) {
+        resetEmpty();
+        if (n != 0)
+            reserve(n);
+    }
+
+    FlatHashTable(const FlatHashTable& rhs)
+        : maxfactor(rhs.maxfactor), hashfunc(rhs.hashfunc),
+          key_equ(rhs.key_equ),
+          alloc(AlSlotTraits::select_on_container_copy_construction(
+              rhs.alloc)) {
+        resetEmpty();
+        copyAux(rhs);
+    }
+
+    FlatHashTable(const FlatHashTable& rhs, const Alloc& al)
+        : maxfactor(rhs.maxfactor), hashfunc(rhs.hashfunc),
+          key_equ(rhs.key_equ), alloc(al) {
+        resetEmpty();
+        copyAux(rhs);
+    }
+
+    FlatHashTable(FlatHashTable&& rhs) noexcept
+        : maxfactor(rhs.maxfactor), hashfunc(rhs.hashfunc),
+          key_equ(rhs.key_equ), alloc(tiny_stl::move(rhs.alloc)) {
+        stealAux(rhs);
+    }
+
+    FlatHashTable& operator=(const FlatHashTable& rhs) {
+        assert(this != tiny_stl::addressof(rhs));
+        tidy();
+        if (AlSlotTraits::propagate_on_container_copy_assignment::value)
+            alloc = rhs.alloc;
+        maxfactor = rhs.maxfactor;
+        hashfunc = rhs.hashfunc;
+        key_equ = rhs.key_equ;
+        copyAux(rhs);
+
+        return *this;
+    }
+
+    FlatHashTable& operator=(FlatHashTable&& rhs) {
+        assert(this != tiny_stl::addressof(rhs));
+        tidy();
+        maxfactor = rhs.maxfactor;
+        hashfunc = rhs.hashfunc;
+        key_equ = rhs.key_equ;
+
+        if (AlSlotTraits::propagate_on_container_move_assignment::value) {
+            alloc = tiny_stl::move(rhs.alloc);
+            stealAux(rhs);
+        } else if (alloc == rhs.alloc) {
+            stealAux(rhs);
+        } else {
+            // slots of rhs can not be freed by alloc, move individually
+            for (auto& val : rhs)
+                insertUniqueAux(tiny_stl::move(val));
+            rhs.clear();
+        }
+
+        return *this;
+    }
+
+    ~FlatHashTable() noexcept {
+        tidy();
+    }
+
+    allocator_type get_allocator() const {
+        return static_cast<allocator_type>(alloc);
+    }
+
+    iterator begin() noexcept {
+        iterator iter(ctrl, slots);
+        iter.skipEmptyOrDeleted();
+        return iter;
+    }
+
+    const_iterator begin() const noexcept {
+        const_iterator iter(ctrl, slots);
+        iter.skipEmptyOrDeleted();
+        return iter;
+    }
+
+    const_iterator cbegin() const noexcept {
+        return begin();
+    }
+
+    iterator end() noexcept {
+        return makeIter(capacity);
+    }
+
+    const_iterator end() const noexcept {
+        return makeIter(capacity);
+    }
+
+    const_iterator cend() const noexcept {
+        return end();
+    }
+
+    size_type size() const noexcept {
+        return num_elements;
+    }
+
+    bool empty() const noexcept {
+        return num_elements == 0;
+    }
+
+    size_type max_size() const noexcept {
+        return AlSlotTraits::max_size(alloc);
+    }
+
+    // keep the slots, only destroy the elements
+    void clear() noexcept {
+        if (capacity == 0)
+            return;
+        destroyElements();
+        memset(ctrl, kFlatEmpty, capacity);
+        num_elements = 0;
+        num_deleted = 0;
+    }
+
+private:
+    template <typename Value>
+    pair<iterator, bool> insertUniqueAux(Value&& val) {
+        const size_t hash = hashfunc(get_key(val));
+        size_type pos = findAux(get_key(val), hash);
+        if (pos != capacity) // existing
+            return tiny_stl::make_pair(makeIter(pos), false);
+
+        // not exist
+        pos = prepareInsert(hash);
+        AlSlotTraits::construct(alloc, slots + pos,
+                                tiny_stl::forward<Value>(val));
+        setCtrl(pos, flatH2(hash));
+        ++num_elements;
+
+        return tiny_stl::make_pair(makeIter(pos), true);
+    }
+
+protected:
+    pair<iterator, bool> insert_unique(const value_type& val) {
+        return insertUniqueAux(val);
+    }
+
+    pair<iterator, bool> insert_unique(value_type&& val) {
+        return insertUniqueAux(tiny_stl::move(val));
+    }
+
+    template <typename InIter>
+    void insert_unique(InIter first, InIter last) {
+        for (; first != last; ++first)
+            insertUniqueAux(*first);
+    }
+
+    template <typename... Args>
+    pair<iterator, bool> emplace_unique(Args&&... args) {
+        T val(tiny_stl::forward<Args>(args)...);
+        return insertUniqueAux(tiny_stl::move(val));
+    }
+
+    size_type count_unique(const key_type& key) const {
+        return findAux(key, hashfunc(key)) == capacity ? 0 : 1;
+    }
+
+public:
+    iterator erase(const_iterator pos) {
+        assert(pos != cend());
+        const size_type idx = static_cast<size_type>(pos.ctrl - ctrl);
+
+        AlSlotTraits::destroy(alloc, slots + idx);
+        --num_elements;
+
+        // A group with an empty slot has never been full, so no probe
+        // sequence goes through it, the slot can be reused as empty
+        if (FlatGroup(ctrl + groupStart(idx)).maskEmpty()) {
+            ctrl[idx] = kFlatEmpty;
+        } else {
+            ctrl[idx] = kFlatDeleted;
+            ++num_deleted;
+        }
+
+        iterator next = makeIter(idx);
+        ++next;
+        return next;
+    }
+
+    iterator erase(const_iterator first, const_iterator last) {
+        if (first == begin() && last == end()) {
+            clear();
+            return end();
+        }
+
+        while (first != last)
+            first = erase(first);
+
+        return makeIter(static_cast<size_type>(last.ctrl - ctrl));
+    }
+
+    size_type erase(const key_type& key) {
+        const size_type pos = findAux(key, hashfunc(key));
+        if (pos == capacity)
+            return 0;
+
+        erase(makeIter(pos));
+        return 1;
+    }
+
+    void swap(FlatHashTable& rhs) noexcept(
+        AlSlotTraits::propagate_on_container_swap::value ||
+        AlSlotTraits::is_always_equal::value) {
+        swapAlloc(alloc, rhs.alloc);
+        swapADL(hashfunc, rhs.hashfunc);
+        swapADL(key_equ, rhs.key_equ);
+        swapADL(maxfactor, rhs.maxfactor);
+        swapADL(ctrl, rhs.ctrl);
+        swapADL(slots, rhs.slots);
+        swapADL(capacity, rhs.capacity);
+        swapADL(num_elements, rhs.num_elements);
+        swapADL(num_deleted, rhs.num_deleted);
+        swapADL(growth_limit, rhs.growth_limit);
+    }
+
+public:
+    iterator find(const key_type& key) {
+        return makeIter(findAux(key, hashfunc(key)));
+    }
+
+    const_iterator find(const key_type& key) const {
+        return makeIter(findAux(key, hashfunc(key)));
+    }
+
+    pair<iterator, iterator> equal_range(const key_type& key) {
+        iterator first = find(key);
+        if (first == end())
+            return tiny_stl::make_pair(first, first);
+
+        iterator last = first;
+        return tiny_stl::make_pair(first, ++last);
+    }
+
+    pair<const_iterator, const_iterator>
+    equal_range(const key_type& key) const {
+        const_iterator first = find(key);
+        if (first == end())
+            return tiny_stl::make_pair(first, first);
+
+        const_iterator last = first;
+        return tiny_stl::make_pair(first, ++last);
+    }
+
+public:
+    local_iterator begin(size_type n) {
+        assert(n < capacity);
+        return slots + n;
+    }
+
+    const_local_iterator begin(size_type n) const {
+        assert(n < capacity);
+        return slots + n;
+    }
+
+    const_local_iterator cbegin(size_type n) const {
+        return begin(n);
+    }
+
+    local_iterator end(size_type n) {
+        return begin(n) + bucket_size(n);
+    }
+
+    const_local_iterator end(size_type n) const {
+        return begin(n) + bucket_size(n);
+    }
+
+    const_local_iterator cend(size_type n) const {
+        return end(n);
+    }
+
+    size_type bucket_count() const noexcept {
+        return capacity;
+    }
+
+    size_type max_bucket_count() const noexcept {
+        return max_size();
+    }
+
+    size_type bucket_size(size_type n) const {
+        assert(n < capacity);
+        return flatIsFull(ctrl[n]) ? 1 : 0;
+    }
+
+    // the slot of key, or the start of its probe sequence if not exist
+    size_type bucket(const key_type& key) const {
+        assert(bucket_count() != 0);
+        const size_t hash = hashfunc(key);
+        const size_type pos = findAux(key, hash);
+
+        return pos != capacity ? pos
+                               : ProbeSeq(flatH1(hash), capacity).offset();
+    }
+
+    float load_factor() const {
+        return capacity == 0 ? 0.0f
+                             : static_cast<float>(size()) /
+                                   static_cast<float>(bucket_count());
+    }
+
+    float max_load_factor() const {
+        return maxfactor;
+    }
+
+    // takes effect on the next insertion
+    void max_load_factor(float mlf) {
+        if (mlf == mlf && mlf > 0.0f) {
+            maxfactor = mlf;
+            growth_limit = growthLimit(capacity);
+        }
+    }
+
+    void rehash(size_type n) {
+        size_type newCapacity = normalizeCapacity(n);
+        while (growthLimit(newCapacity) < size())
+            newCapacity <<= 1;
+
+        if (newCapacity > capacity || num_deleted != 0)
+            resize(newCapacity);
+    }
+
+    void reserve(size_type n) {
+        size_type newCapacity = normalizeCapacity(
+            static_cast<size_type>(std::ceil(n / max_load_factor())));
+        while (growthLimit(newCapacity) < n)
+            newCapacity <<= 1;
+
+        if (newCapacity > capacity)
+            resize(newCapacity);
+    }
+
+    hasher hash_function() const {
+        return hashfunc;
+    }
+
+    key_equal key_eq() const {
+        return key_equ;
+    }
+
+    // the layout of two tables may be different, look up every element
+    bool equalAux(const FlatHashTable& rhs) const {
+        if (size() != rhs.size())
+            return false;
+
+        for (const auto& val : *this) {
+            const_iterator pos = rhs.find(get_key(val));
+            if (pos == rhs.end() || !(*pos == val))
+                return false;
+        }
+
+        return true;
+    }
+}; // FlatHashTable
+
+template <typename T, typename Hash, typename KeyEqual, typename Alloc,
+          bool isMap, typename Probe>
+inline bool
+operator==(const FlatHashTable<T, Hash, KeyEqual, Alloc, isMap, Probe>& lhs,
+           const FlatHashTable<T, Hash, KeyEqual, Alloc, isMap, Probe>& rhs) {
+    return lhs.equalAux(rhs);
+}
+
+template <typename T, typename Hash, typename KeyEqual, typename Alloc,
+          bool isMap, typename Probe>
+inline bool
+operator!=(const FlatHashTable<T, Hash, KeyEqual, Alloc, isMap, Probe>& lhs,
+           const FlatHashTable<T, Hash, KeyEqual, Alloc, isMap, Probe>& rhs) {
+    return !(lhs == rhs);
+}
+
+// engine policy of unordered_map/unordered_set, values stored inline
+template <typename Probe = quadratic_probing>
+struct flat_hashing {
+    template <typename T, typename Hash, typename KeyEqual, typename Alloc,
+              bool isMap>
+    using table = FlatHashTable<T, Hash, KeyEqual, Alloc, isMap, Probe>;
+};
+
+} // namespace tiny_stl
@@ -0,0 +1,828 @@
+// Copyright (C) 2021 syn1w
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <initializer_list>
+
+#include "algorithm.hpp"
+#include "vector.hpp"
+
+namespace tiny_stl {
+
+// flat_map, the keys and the mapped values in two arrays in key order
+//
+// A lookup is a binary search over the contiguous keys, only the value
+// found is touched. Insert and erase shift the tails in O(n), so build
+// the map with one batch instead: insert(first, last) appends the batch,
+// sorts it and merges it into the old elements in one pass. insert and
+// erase invalidate all iterators.
+//
+// *iter is pair<const Key&, T&>, a proxy to keys[i] and values[i].
+template <typename Key, typename KeyIter, typename MappedIter>
+struct FlatMapIterator {
+    using iterator_category = random_access_iterator_tag;
+    using value_type =
+        pair<Key, typename iterator_traits<MappedIter>::value_type>;
+    using difference_type = ptrdiff_t;
+    using reference =
+        pair<const Key&, typename iterator_traits<MappedIter>::reference>;
+
+    struct pointer {
+        reference ref;
+
+        reference* operator->() {
+            return tiny_stl::addressof(ref);
+        }
+    };
+
+    KeyIter keyIter;
+    MappedIter mappedIter;
+
+    FlatMapIterator() : keyIter(), mappedIter() {
+    }
+
+    FlatMapIterator(KeyIter k, MappedIter m) : keyIter(k), mappedIter(m) {
+    }
+
+    // iterator to const_iterator
+    template <typename OtherMapped,
+              typename = enable_if_t<
+                  is_convertible<OtherMapped, MappedIter>::value &&
+                  !is_same<OtherMapped, MappedIter>::value>>
+    FlatMapIterator(const FlatMapIterator<Key, KeyIter, OtherMapped>& rhs)
+        : keyIter(rhs.keyIter), mappedIter(rhs.mappedIter) {
+    }
+
+    reference operator*() const {
+        return reference(*keyIter, *mappedIter);
+    }
+
+    pointer operator->() const {
+        return pointer{**this};
+    }
+
+    reference operator[](difference_type n) const {
+        return *(*this + n);
+    }
+
+    FlatMapIterator& operator++() {
+        ++keyIter;
+        ++mappedIter;
+        return *this;
+    }
+
+    FlatMapIterator operator++(int) {
+        FlatMapIterator tmp = *this;
+        ++*this;
+        return tmp;
+    }
+
+    FlatMapIterator& operator--() {
+        --keyIter;
+        --mappedIter;
+        return *this;
+    }
+
+    FlatMapIterator operator--(int) {
+        FlatMapIterator tmp = *this;
+        --*this;
+        return tmp;
+    }
+
+    FlatMapIterator& operator+=(difference_type n) {
+        keyIter += n;
+        mappedIter += n;
+        return *this;
+    }
+
+    FlatMapIterator operator+(difference_type n) const {
+        FlatMapIterator tmp = *this;
+        return tmp += n;
+    }
+
+    FlatMapIterator& operator-=(difference_type n) {
+        return *this += -n;
+    }
+
+    FlatMapIterator operator-(difference_type n) const {
+        FlatMapIterator tmp = *this;
+        return tmp -= n;
+    }
+
+    difference_type operator-(const FlatMapIterator& rhs) const {
+        return keyIter - rhs.keyIter;
+    }
+
+    bool operator==(const FlatMapIterator& rhs) const {
+        return keyIter == rhs.keyIter;
+    }
+
+    bool operator!=(const FlatMapIterator& rhs) const {
+        return !(*this == rhs);
+    }
+
+    bool operator<(const FlatMapIterator& rhs) const {
+        return keyIter < rhs.keyIter;
+    }
+
+    bool operator>(const FlatMapIterator& rhs) const {
+        return rhs < *this;
+    }
+
+    bool operator<=(const FlatMapIterator& rhs) const {
+        return !(rhs < *this);
+    }
+
+    bool operator>=(const FlatMapIterator& rhs) const {
+        return !(*this < rhs);
+    }
+}; // FlatMapIterator
+
+template <typename Key, typename KeyIter, typename MappedIter>
+inline FlatMapIterator<Key, KeyIter, MappedIter>
+operator+(ptrdiff_t n, const FlatMapIterator<Key, KeyIter, MappedIter>& iter) {
+    return iter + n;
+}
+
+template <typename Key, typename T, typename Compare = less<Key>,
+          typename KeyContainer = vector<Key>,
+          typename MappedContainer = vector<T>>
+class flat_map {
+public:
+    using key_type = Key;
+    using mapped_type = T;
+    using value_type = pair<Key, T>;
+    using key_compare = Compare;
+    using reference = pair<const Key&, T&>;
+    using const_reference = pair<const Key&, const T&>;
+    using size_type = size_t;
+    using difference_type = ptrdiff_t;
+    using iterator =
+        FlatMapIterator<Key, typename KeyContainer::const_iterator,
+                        typename MappedContainer::iterator>;
+    using const_iterator =
+        FlatMapIterator<Key, typename KeyContainer::const_iterator,
+                        typename MappedContainer::const_iterator>;
+    using reverse_iterator = tiny_stl::reverse_iterator<iterator>;
+    using const_reverse_iterator = tiny_stl::reverse_iterator<const_iterator>;
+    using key_container_type = KeyContainer;
+    using mapped_container_type = MappedContainer;
+
+    class value_compare {
+        friend flat_map;
+
+    protected:
+        Compare mCmp;
+
+        value_compare(Compare c) : mCmp(c) {
+        }
+
+    public:
+        bool operator()(const_reference lhs, const_reference rhs) const {
+            return mCmp(lhs.first, rhs.first);
+        }
+    };
+
+    struct containers {
+        KeyContainer keys;
+        MappedContainer values;
+    };
+
+private:
+    containers c;
+    Compare compare;
+
+private:
+    iterator makeIter(size_type i) noexcept {
+        return iterator(c.keys.cbegin() + i, c.values.begin() + i);
+    }
+
+    const_iterator makeIter(size_type i) const noexcept {
+        return const_iterator(c.keys.cbegin() + i, c.values.cbegin() + i);
+    }
+
+    template <typename K>
+    size_type lowerIndex(const K& key) const {
+        return tiny_stl::lower_bound(c.keys.begin(), c.keys.end(), key,
+                                     this->compare) -
+               c.keys.begin();
+    }
+
+    template <typename K>
+    size_type upperIndex(const K& key) const {
+        return tiny_stl::upper_bound(c.keys.begin(), c.keys.end(), key,
+                                     this->compare) -
+               c.keys.begin();
+    }
+
+    template <typename K>
+    size_type findIndex(const K& key) const {
+        const size_type i = lowerIndex(key);
+        return i == size() || this->compare(key, c.keys[i]) ? size() : i;
+    }
+
+    // [old, size()) are new, sort them and merge them into [0, old),
+    // an old key wins over an equal new one, so does the first of the
+    // equal new ones
+    void mergeTail(size_type old, bool sortedTail) {
+        const size_type n = c.keys.size();
+        if (old == n)
+            return;
+
+        try {
+            // sort the positions of the new elements, equal keys keep
+            // their order
+            vector<size_type> order;
+            order.reserve(n - old);
+            for (size_type i = old; i < n; ++i)
+                order.push_back(i);
+
+            if (!sortedTail) {
+                const KeyContainer& keys = c.keys;
+                const Compare& cmp = this->compare;
+                tiny_stl::sort(order.begin(), order.end(),
+                               [&keys, &cmp](size_type lhs, size_type rhs) {
+                                   return cmp(keys[lhs], keys[rhs]) ||
+                                          (!cmp(keys[rhs], keys[lhs]) &&
+                                           lhs < rhs);
+                               });
+            }
+
+            // the elements before the smallest new key stay in place
+            const size_type start =
+                tiny_stl::lower_bound(c.keys.begin(), c.keys.begin() + old,
+                                      c.keys[order.front()], this->compare) -
+                c.keys.begin();
+
+            containers merged;
+            merged.keys.reserve(n - start);
+            merged.values.reserve(n - start);
+            size_type lhs = start;
+            auto rhs = order.begin();
+            while (lhs != old || rhs != order.end()) {
+                const size_type next =
+                    lhs != old && (rhs == order.end() ||
+                                   !this->compare(c.keys[*rhs], c.keys[lhs]))
+                        ? lhs++
+                        : *rhs++;
+                // the keys before start are less than all of them
+                if (merged.keys.empty() ||
+                    this->compare(merged.keys.back(), c.keys[next])) {
+                    merged.keys.push_back(tiny_stl::move(c.keys[next]));
+                    merged.values.push_back(tiny_stl::move(c.values[next]));
+                }
+            }
+
+            c.keys.erase(c.keys.begin() + start, c.keys.end());
+            c.values.erase(c.values.begin() + start, c.values.end());
+            for (size_type i = 0; i < merged.keys.size(); ++i) {
+                c.keys.push_back(tiny_stl::move(merged.keys[i]));
+                c.values.push_back(tiny_stl::move(merged.values[i]));
+            }
+        } catch (...) {
+            clear(); // the remaining elements may be unsorted
+            throw;
+        }
+    }
+
+    // the containers keep the same size
+    template <typename K, typename... Args>
+    void appendAux(K&& key, Args&&... args) {
+        c.keys.emplace_back(tiny_stl::forward<K>(key));
+        try {
+            c.values.emplace_back(tiny_stl::forward<Args>(args)...);
+        } catch (...) {
+            c.keys.pop_back();
+            throw;
+        }
+    }
+
+    template <typename InIter>
+    void insertRange(InIter first, InIter last, bool sorted) {
+        const size_type old = size();
+        try {
+            for (; first != last; ++first)
+                appendAux(first->first, first->second);
+        } catch (...) {
+            c.keys.erase(c.keys.begin() + old, c.keys.end());
+            c.values.erase(c.values.begin() + old, c.values.end());
+            throw;
+        }
+
+        mergeTail(old, sorted);
+    }
+
+    template <typename K, typename... Args>
+    iterator insertAt(size_type i, K&& key, Args&&... args) {
+        c.keys.emplace(c.keys.begin() + i, tiny_stl::forward<K>(key));
+        try {
+            c.values.emplace(c.values.begin() + i,
+                             tiny_stl::forward<Args>(args)...);
+        } catch (...) {
+            c.keys.erase(c.keys.begin() + i);
+            throw;
+        }
+
+        return makeIter(i);
+    }
+
+    template <typename K, typename... Args>
+    pair<iterator, bool> tryEmplaceAux(K&& key, Args&&... args) {
+        const size_type i = lowerIndex(key);
+        if (i != size() && !this->compare(key, c.keys[i]))
+            return {makeIter(i), false};
+
+        return {insertAt(i, tiny_stl::forward<K>(key),
+                         tiny_stl::forward<Args>(args)...),
+                true};
+    }
+
+    // O(1) to check that key goes right before hint
+    template <typename K, typename... Args>
+    iterator tryEmplaceHintAux(const_iterator hint, K&& key,
+                               Args&&... args) {
+        const size_type i = hint - cbegin();
+        if ((i == 0 || this->compare(c.keys[i - 1], key)) &&
+            (i == size() || this->compare(key, c.keys[i])))
+            return insertAt(i, tiny_stl::forward<K>(key),
+                            tiny_stl::forward<Args>(args)...);
+
+        return tryEmplaceAux(tiny_stl::forward<K>(key),
+                             tiny_stl::forward<Args>(args)...)
+            .first;
+    }
+
+public:
+    flat_map() : c(), compare() {
+    }
+
+    explicit flat_map(const Compare& cmp) : c(), compare(cmp) {
+    }
+
+    // sort and dedup the elements
+    flat_map(KeyContainer keys, MappedContainer values,
+             const Compare& cmp = Compare())
+        : c{tiny_stl::move(keys), tiny_stl::move(values)}, compare(cmp) {
+        assert(c.keys.size() == c.values.size());
+        mergeTail(0, false);
+    }
+
+    // keys are sorted without equal ones
+    flat_map(sorted_unique_t, KeyContainer keys, MappedContainer values,
+             const Compare& cmp = Compare())
+        : c{tiny_stl::move(keys), tiny_stl::move(values)}, compare(cmp) {
+        assert(c.keys.size() == c.values.size());
+    }
+
+    template <typename InIter>
+    flat_map(InIter first, InIter last, const Compare& cmp = Compare())
+        : c(), compare(cmp) {
+        insertRange(first, last, false);
+    }
+
+    template <typename InIter>
+    flat_map(sorted_unique_t, InIter first, InIter last,
+             const Compare& cmp = Compare())
+        : c(), compare(cmp) {
+        insertRange(first, last, true);
+    }
+
+    flat_map(std::initializer_list<value_type> ilist,
+             const Compare& cmp = Compare())
+        : flat_map(ilist.begin(), ilist.end(), cmp) {
+    }
+
+    flat_map& operator=(std::initializer_list<value_type> ilist) {
+        flat_map tmp(ilist, this->compare);
+        this->swap(tmp);
+        return *this;
+    }
+
+    iterator begin() noexcept {
+        return makeIter(0);
+    }
+
+    const_iterator begin() const noexcept {
+        return makeIter(0);
+    }
+
+    const_iterator cbegin() const noexcept {
+        return begin();
+    }
+
+    iterator end() noexcept {
+        return makeIter(size());
+    }
+
+    const_iterator end() const noexcept {
+        return makeIter(size());
+    }
+
+    const_iterator cend() const noexcept {
+        return end();
+    }
+
+    reverse_iterator rbegin() noexcept {
+        return reverse_iterator(end());
+    }
+
+    const_reverse_iterator rbegin() const noexcept {
+        return const_reverse_iterator(end());
+    }
+
+    const_reverse_iterator crbegin() const noexcept {
+        return rbegin();
+    }
+
+    reverse_iterator rend() noexcept {
+        return reverse_iterator(begin());
+    }
+
+    const_reverse_iterator rend() const noexcept {
+        return const_reverse_iterator(begin());
+    }
+
+    const_reverse_iterator crend() const noexcept {
+        return rend();
+    }
+
+    bool empty() const noexcept {
+        return c.keys.empty();
+    }
+
+    size_type size() const noexcept {
+        return c.keys.size();
+    }
+
+    size_type max_size() const noexcept {
+        return tiny_stl::min<size_type>(c.keys.max_size(),
+                                        c.values.max_size());
+    }
+
+    T& operator[](const Key& key) {
+        return tryEmplaceAux(key).first->second;
+    }
+
+    T& operator[](Key&& key) {
+        return tryEmplaceAux(tiny_stl::move(key)).first->second;
+    }
+
+    T& at(const Key& key) {
+        const size_type i = findIndex(key);
+        if (i == size())
+            xRange();
+
+        return c.values[i];
+    }
+
+    const T& at(const Key& key) const {
+        const size_type i = findIndex(key);
+        if (i == size())
+            xRange();
+
+        return c.values[i];
+    }
+
+    template <typename... Args>
+    pair<iterator, bool> emplace(Args&&... args) {
+        value_type val(tiny_stl::forward<Args>(args)...);
+        return tryEmplaceAux(tiny_stl::move(val.first),
+                             tiny_stl::move(val.second));
+    }
+
+    template <typename... Args>
+    iterator emplace_hint(const_iterator hint, Args&&... args) {
+        value_type val(tiny_stl::forward<Args>(args)...);
+        return tryEmplaceHintAux(hint, tiny_stl::move(val.first),
+                                 tiny_stl::move(val.second));
+    }
+
+    pair<iterator, bool> insert(const value_type& val) {
+        return tryEmplaceAux(val.first, val.second);
+    }
+
+    pair<iterator, bool> insert(value_type&& val) {
+        return tryEmplaceAux(tiny_stl::move(val.first),
+                             tiny_stl::move(val.second));
+    }
+
+    template <typename P,
+              typename = enable_if_t<is_constructible<value_type, P&&>::value>>
+    pair<iterator, bool> insert(P&& val) {
+        return emplace(tiny_stl::forward<P>(val));
+    }
+
+    iterator insert(const_iterator hint, const value_type& val) {
+        return tryEmplaceHintAux(hint, val.first, val.second);
+    }
+
+    iterator insert(const_iterator hint, value_type&& val) {
+        return tryEmplaceHintAux(hint, tiny_stl::move(val.first),
+                                 tiny_stl::move(val.second));
+    }
+
+    // O(m log m + n) for m new elements
+    template <typename InIter>
+    void insert(InIter first, InIter last) {
+        insertRange(first, last, false);
+    }
+
+    // O(m + n), [first, last) is sorted
+    template <typename InIter>
+    void insert(sorted_unique_t, InIter first, InIter last) {
+        insertRange(first, last, true);
+    }
+
+    void insert(std::initializer_list<value_type> ilist) {
+        insertRange(ilist.begin(), ilist.end(), false);
+    }
+
+    template <typename... Args>
+    pair<iterator, bool> try_emplace(const Key& key, Args&&... args) {
+        return tryEmplaceAux(key, tiny_stl::forward<Args>(args)...);
+    }
+
+    template <typename... Args>
+    pair<iterator, bool> try_emplace(Key&& key, Args&&... args) {
+        return tryEmplaceAux(tiny_stl::move(key),
+                             tiny_stl::forward<Args>(args)...);
+    }
+
+    template <typename... Args>
+    iterator try_emplace(const_iterator hint, const Key& key,
+                         Args&&... args) {
+        return tryEmplaceHintAux(hint, key, tiny_stl::forward<Args>(args)...);
+    }
+
+    template <typename... Args>
+    iterator try_emplace(const_iterator hint, Key&& key, Args&&... args) {
+        return tryEmplaceHintAux(hint, tiny_stl::move(key),
+                                 tiny_stl::forward<Args>(args)...);
+    }
+
+    template <typename M>
+    pair<iterator, bool> insert_or_assign(const Key& key, M&& obj) {
+        auto ret = tryEmplaceAux(key, tiny_stl::forward<M>(obj));
+        if (!ret.second)
+            ret.first->second = tiny_stl::forward<M>(obj);
+
+        return ret;
+    }
+
+    template <typename M>
+    pair<iterator, bool> insert_or_assign(Key&& key, M&& obj) {
+        auto ret =
+            tryEmplaceAux(tiny_stl::move(key), tiny_stl::forward<M>(obj));
+        if (!ret.second)
+            ret.first->second = tiny_stl::forward<M>(obj);
+
+        return ret;
+    }
+
+    // the map is empty after it
+    containers extract() && {
+        containers tmp = tiny_stl::move(c);
+        clear();
+        return tmp;
+    }
+
+    // keys are sorted without equal ones
+    void replace(KeyContainer&& keys, MappedContainer&& values) {
+        assert(keys.size() == values.size());
+        c.keys = tiny_stl::move(keys);
+        c.values = tiny_stl::move(values);
+    }
+
+    const KeyContainer& keys() const noexcept {
+        return c.keys;
+    }
+
+    const MappedContainer& values() const noexcept {
+        return c.values;
+    }
+
+    iterator erase(iterator pos) {
+        return erase(const_iterator(pos));
+    }
+
+    iterator erase(const_iterator pos) {
+        const size_type i = pos - cbegin();
+        c.keys.erase(c.keys.begin() + i);
+        c.values.erase(c.values.begin() + i);
+
+        return makeIter(i);
+    }
+
+    iterator erase(const_iterator first, const_iterator last) {
+        const size_type i = first - cbegin();
+        const size_type j = last - cbegin();
+        c.keys.erase(c.keys.begin() + i, c.keys.begin() + j);
+        c.values.erase(c.values.begin() + i, c.values.begin() + j);
+
+        return makeIter(i);
+    }
+
+    size_type erase(const key_type& key) {
+        const size_type i = findIndex(key);
+        if (i == size())
+            return 0;
+
+        erase(makeIter(i));
+        return 1;
+    }
+
+    void swap(flat_map& rhs) noexcept(
+        is_nothrow_swappable<KeyContainer>::value&&
+            is_nothrow_swappable<MappedContainer>::value&&
+                is_nothrow_swappable<Compare>::value) {
+        tiny_stl::swapADL(c.keys, rhs.c.keys);
+        tiny_stl::swapADL(c.values, rhs.c.values);
+        tiny_stl::swapADL(this->compare, rhs.compare);
+    }
+
+    void clear() noexcept {
+        c.keys.clear();
+        c.values.clear();
+    }
+
+    key_compare key_comp() const {
+        return this->compare;
+    }
+
+    value_compare value_comp() const {
+        return value_compare(this->compare);
+    }
+
+    iterator lower_bound(const key_type& key) {
+        return makeIter(lowerIndex(key));
+    }
+
+    const_iterator lower_bound(const key_type& key) const {
+        return makeIter(lowerIndex(key));
+    }
+
+    template <typename K, typename Cmp = Compare,
+              typename = typename Cmp::is_transparent>
+    iterator lower_bound(const K& key) {
+        return makeIter(lowerIndex(key));
+    }
+
+    template <typename K, typename Cmp = Compare,
+              typename = typename Cmp::is_transparent>
+    const_iterator lower_bound(const K& key) const {
+        return makeIter(lowerIndex(key));
+    }
+
+    iterator upper_bound(const key_type& key) {
+        return makeIter(upperIndex(key));
+    }
+
+    const_iterator upper_bound(const key_type& key) const {
+        return makeIter(upperIndex(key));
+    }
+
+    template <typename K, typename Cmp = Compare,
+              typename = typename Cmp::is_transparent>
+    iterator upper_bound(const K& key) {
+        return makeIter(upperIndex(key));
+    }
+
+    template <typename K, typename Cmp = Compare,
+              typename = typename Cmp::is_transparent>
+    const_iterator upper_bound(const K& key) const {
+        return makeIter(upperIndex(key));
+    }
+
+    pair<iterator, iterator> equal_range(const key_type& key) {
+        const size_type i = lowerIndex(key);
+        const size_type j = i + (i < size() && !this->compare(key, c.keys[i]));
+        return {makeIter(i), makeIter(j)};
+    }
+
+    pair<const_iterator, const_iterator>
+    equal_range(const key_type& key) const {
+        const size_type i = lowerIndex(key);
+        const size_type j = i + (i < size() && !this->compare(key, c.keys[i]));
+        return {makeIter(i), makeIter(j)};
+    }
+
+    template <typename K, typename Cmp = Compare,
+              typename = typename Cmp::is_transparent>
+    pair<iterator, iterator> equal_range(const K& key) {
+        return {lower_bound(key), upper_bound(key)};
+    }
+
+    template <typename K, typename Cmp = Compare,
+              typename = typename Cmp::is_transparent>
+    pair<const_iterator, const_iterator> equal_range(const K& key) const {
+        return {lower_bound(key), upper_bound(key)};
+    }
+
+    iterator find(const key_type& key) {
+        return makeIter(findIndex(key));
+    }
+
+    const_iterator find(const key_type& key) const {
+        return makeIter(findIndex(key));
+    }
+
+    template <typename K, typename Cmp = Compare,
+              typename = typename Cmp::is_transparent>
+    iterator find(const K& key) {
+        return makeIter(findIndex(key));
+    }
+
+    template <typename K, typename Cmp = Compare,
+              typename = typename Cmp::is_transparent>
+    const_iterator find(const K& key) const {
+        return makeIter(findIndex(key));
+    }
+
+    size_type count(const key_type& key) const {
+        return findIndex(key) != size();
+    }
+
+    template <typename K, typename Cmp = Compare,
+              typename = typename Cmp::is_transparent>
+    size_type count(const K& key) const {
+        return upperIndex(key) - lowerIndex(key);
+    }
+
+    bool contains(const key_type& key) const {
+        return findIndex(key) != size();
+    }
+
+    template <typename K, typename Cmp = Compare,
+              typename = typename Cmp::is_transparent>
+    bool contains(const K& key) const {
+        return findIndex(key) != size();
+    }
+
+private:
+    [[noreturn]] static void xRange() {
+        throw "flat_map<Key, T>, key is not exist";
+    }
+}; // class flat_map
+
+template <typename Key, typename T, typename Cmp, typename KCont,
+          typename MCont>
+inline bool operator==(const flat_map<Key, T, Cmp, KCont, MCont>& lhs,
+                       const flat_map<Key, T, Cmp, KCont, MCont>& rhs) {
+    return lhs.keys() == rhs.keys() && lhs.values() == rhs.values();
+}
+
+template <typename Key, typename T, typename Cmp, typename KCont,
+          typename MCont>
+inline bool operator!=(const flat_map<Key, T, Cmp, KCont, MCont>& lhs,
+                       const flat_map<Key, T, Cmp, KCont, MCont>& rhs) {
+    return !(lhs == rhs);
+}
+
+template <typename Key, typename T, typename Cmp, typename KCont,
+          typename MCont>
+inline bool operator<(const flat_map<Key, T, Cmp, KCont, MCont>& lhs,
+                      const flat_map<Key, T, Cmp, KCont, MCont>& rhs) {
+    return tiny_stl::lexicographical_compare(lhs.begin(), lhs.end(),
+                                             rhs.begin(), rhs.end());
+}
+
+template <typename Key, typename T, typename Cmp, typename KCont,
+          typename MCont>
+inline bool operator>(const flat_map<Key, T, Cmp, KCont, MCont>& lhs,
+                      const flat_map<Key, T, Cmp, KCont, MCont>& rhs) {
+    return rhs < lhs;
+}
+
+template <typename Key, typename T, typename Cmp, typename KCont,
+          typename MCont>
+inline bool operator<=(const flat_map<Key, T, Cmp, KCont, MCont>& lhs,
+                       const flat_map<Key, T, Cmp, KCont, MCont>& rhs) {
+    return !(rhs < lhs);
+}
+
+template <typename Key, typename T, typename Cmp, typename KCont,
+          typename MCont>
+inline bool operator>=(const flat_map<Key, T, Cmp, KCont, MCont>& lhs,
+                       const flat_map<Key, T, Cmp, KCont, MCont>& rhs) {
+    return !(lhs < rhs);
+}
+
+template <typename Key, typename T, typename Cmp, typename KCont,
+          typename MCont>
+inline void swap(flat_map<Key, T, Cmp, KCont, MCont>& lhs,
+                 flat_map<Key, T, Cmp, KCont, MCont>& rhs) noexcept(
+    noexcept(lhs.swap(rhs))) {
+    lhs.swap(rhs);
+}
+
+namespace pmr {
+
+template <typename Key, typename T, typename Compare = less<Key>>
+using flat_map =
+    tiny_stl::flat_map<Key, T, Compare, pmr::vector<Key>, pmr::vector<T>>;
+
+} // namespace pmr
+
+} // namespace tiny_stl
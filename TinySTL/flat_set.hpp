@@ -0,0 +1,404 @@
+// Copyright (C) 2021 syn1w
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <initializer_list>
+
+#include "algorithm.hpp"
+#include "vector.hpp"
+
+namespace tiny_stl {
+
+// flat_set, the keys in one sorted array
+//
+// A lookup is a binary search over contiguous memory. Insert and erase
+// shift the tail in O(n), so build the set with one batch instead:
+// insert(first, last) appends the batch, sorts it and merges it into the
+// old keys in one pass. insert and erase invalidate all iterators.
+template <typename Key, typename Compare = less<Key>,
+          typename KeyContainer = vector<Key>>
+class flat_set {
+public:
+    using key_type = Key;
+    using value_type = Key;
+    using key_compare = Compare;
+    using value_compare = Compare;
+    using reference = value_type&;
+    using const_reference = const value_type&;
+    using size_type = typename KeyContainer::size_type;
+    using difference_type = typename KeyContainer::difference_type;
+    using iterator = typename KeyContainer::const_iterator;
+    using const_iterator = typename KeyContainer::const_iterator;
+    using reverse_iterator = tiny_stl::reverse_iterator<iterator>;
+    using const_reverse_iterator = tiny_stl::reverse_iterator<const_iterator>;
+    using container_type = KeyContainer;
+
+private:
+    KeyContainer keys;
+    Compare compare;
+
+private:
+    // [old, size()) are new, sort them and merge them into [0, old),
+    // an old key wins over an equal new one
+    void mergeTail(size_type old, bool sortedTail) {
+        const auto mid = keys.begin() + old;
+        if (mid == keys.end())
+            return;
+
+        try {
+            if (!sortedTail)
+                tiny_stl::sort(mid, keys.end(), this->compare);
+
+            // the keys before the smallest new one stay in place
+            const auto start =
+                tiny_stl::lower_bound(keys.begin(), mid, *mid, this->compare);
+
+            KeyContainer merged;
+            merged.reserve(keys.end() - start);
+            auto lhs = start;
+            auto rhs = mid;
+            while (lhs != mid || rhs != keys.end()) {
+                auto& next = lhs != mid && (rhs == keys.end() ||
+                                            !this->compare(*rhs, *lhs))
+                                 ? *lhs++
+                                 : *rhs++;
+                // the keys before start are less than all of them
+                if (merged.empty() || this->compare(merged.back(), next))
+                    merged.push_back(tiny_stl::move(next));
+            }
+
+            keys.erase(start, keys.end());
+            for (auto& key : merged)
+                keys.push_back(tiny_stl::move(key));
+        } catch (...) {
+            keys.clear(); // the remaining keys may be unsorted
+            throw;
+        }
+    }
+
+    template <typename InIter>
+    void insertRange(InIter first, InIter last, bool sorted) {
+        const size_type old = keys.size();
+        try {
+            for (; first != last; ++first)
+                keys.emplace_back(*first);
+        } catch (...) {
+            keys.erase(keys.begin() + old, keys.end());
+            throw;
+        }
+
+        mergeTail(old, sorted);
+    }
+
+    template <typename K>
+    pair<iterator, bool> insertAux(K&& key) {
+        iterator pos = lower_bound(key);
+        if (pos != end() && !this->compare(key, *pos))
+            return {pos, false};
+
+        return {keys.insert(pos, tiny_stl::forward<K>(key)), true};
+    }
+
+    // O(1) to check that key goes right before hint
+    template <typename K>
+    iterator insertHintAux(const_iterator hint, K&& key) {
+        if ((hint == begin() || this->compare(*(hint - 1), key)) &&
+            (hint == end() || this->compare(key, *hint)))
+            return keys.insert(hint, tiny_stl::forward<K>(key));
+
+        return insertAux(tiny_stl::forward<K>(key)).first;
+    }
+
+public:
+    flat_set() : keys(), compare() {
+    }
+
+    explicit flat_set(const Compare& cmp) : keys(), compare(cmp) {
+    }
+
+    // sort and dedup cont
+    explicit flat_set(KeyContainer cont, const Compare& cmp = Compare())
+        : keys(tiny_stl::move(cont)), compare(cmp) {
+        mergeTail(0, false);
+    }
+
+    // cont is sorted without equal keys
+    flat_set(sorted_unique_t, KeyContainer cont,
+             const Compare& cmp = Compare())
+        : keys(tiny_stl::move(cont)), compare(cmp) {
+    }
+
+    template <typename InIter>
+    flat_set(InIter first, InIter last, const Compare& cmp = Compare())
+        : keys(), compare(cmp) {
+        insertRange(first, last, false);
+    }
+
+    template <typename InIter>
+    flat_set(sorted_unique_t, InIter first, InIter last,
+             const Compare& cmp = Compare())
+        : keys(first, last), compare(cmp) {
+    }
+
+    flat_set(std::initializer_list<value_type> ilist,
+             const Compare& cmp = Compare())
+        : flat_set(ilist.begin(), ilist.end(), cmp) {
+    }
+
+    flat_set& operator=(std::initializer_list<value_type> ilist) {
+        flat_set tmp(ilist, this->compare);
+        this->swap(tmp);
+        return *this;
+    }
+
+    iterator begin() const noexcept {
+        return keys.begin();
+    }
+
+    const_iterator cbegin() const noexcept {
+        return begin();
+    }
+
+    iterator end() const noexcept {
+        return keys.end();
+    }
+
+    const_iterator cend() const noexcept {
+        return end();
+    }
+
+    reverse_iterator rbegin() const noexcept {
+        return reverse_iterator(end());
+    }
+
+    const_reverse_iterator crbegin() const noexcept {
+        return rbegin();
+    }
+
+    reverse_iterator rend() const noexcept {
+        return reverse_iterator(begin());
+    }
+
+    const_reverse_iterator crend() const noexcept {
+        return rend();
+    }
+
+    bool empty() const noexcept {
+        return keys.empty();
+    }
+
+    size_type size() const noexcept {
+        return keys.size();
+    }
+
+    size_type max_size() const noexcept {
+        return keys.max_size();
+    }
+
+    template <typename... Args>
+    pair<iterator, bool> emplace(Args&&... args) {
+        return insertAux(Key(tiny_stl::forward<Args>(args)...));
+    }
+
+    template <typename... Args>
+    iterator emplace_hint(const_iterator hint, Args&&... args) {
+        return insertHintAux(hint, Key(tiny_stl::forward<Args>(args)...));
+    }
+
+    pair<iterator, bool> insert(const value_type& val) {
+        return insertAux(val);
+    }
+
+    pair<iterator, bool> insert(value_type&& val) {
+        return insertAux(tiny_stl::move(val));
+    }
+
+    iterator insert(const_iterator hint, const value_type& val) {
+        return insertHintAux(hint, val);
+    }
+
+    iterator insert(const_iterator hint, value_type&& val) {
+        return insertHintAux(hint, tiny_stl::move(val));
+    }
+
+    // O(m log m + n) for m new keys
+    template <typename InIter>
+    void insert(InIter first, InIter last) {
+        insertRange(first, last, false);
+    }
+
+    // O(m + n), [first, last) is sorted
+    template <typename InIter>
+    void insert(sorted_unique_t, InIter first, InIter last) {
+        insertRange(first, last, true);
+    }
+
+    void insert(std::initializer_list<value_type> ilist) {
+        insertRange(ilist.begin(), ilist.end(), false);
+    }
+
+    // the set is empty after it
+    KeyContainer extract() && {
+        KeyContainer tmp = tiny_stl::move(keys);
+        keys.clear();
+        return tmp;
+    }
+
+    // cont is sorted without equal keys
+    void replace(KeyContainer&& cont) {
+        keys = tiny_stl::move(cont);
+    }
+
+    iterator erase(const_iterator pos) {
+        return keys.erase(pos);
+    }
+
+    iterator erase(const_iterator first, const_iterator last) {
+        return keys.erase(first, last);
+    }
+
+    size_type erase(const key_type& key) {
+        auto range = equal_range(key);
+        const size_type num = range.second - range.first;
+        keys.erase(range.first, range.second);
+
+        return num;
+    }
+
+    void swap(flat_set& rhs) noexcept(
+        is_nothrow_swappable<KeyContainer>::value&&
+            is_nothrow_swappable<Compare>::value) {
+        tiny_stl::swapADL(keys, rhs.keys);
+        tiny_stl::swapADL(this->compare, rhs.compare);
+    }
+
+    void clear() noexcept {
+        keys.clear();
+    }
+
+    key_compare key_comp() const {
+        return this->compare;
+    }
+
+    value_compare value_comp() const {
+        return this->compare;
+    }
+
+    iterator lower_bound(const key_type& key) const {
+        return tiny_stl::lower_bound(begin(), end(), key, this->compare);
+    }
+
+    template <typename K, typename Cmp = Compare,
+              typename = typename Cmp::is_transparent>
+    iterator lower_bound(const K& key) const {
+        return tiny_stl::lower_bound(begin(), end(), key, this->compare);
+    }
+
+    iterator upper_bound(const key_type& key) const {
+        return tiny_stl::upper_bound(begin(), end(), key, this->compare);
+    }
+
+    template <typename K, typename Cmp = Compare,
+              typename = typename Cmp::is_transparent>
+    iterator upper_bound(const K& key) const {
+        return tiny_stl::upper_bound(begin(), end(), key, this->compare);
+    }
+
+    pair<iterator, iterator> equal_range(const key_type& key) const {
+        return tiny_stl::equal_range(begin(), end(), key, this->compare);
+    }
+
+    template <typename K, typename Cmp = Compare,
+              typename = typename Cmp::is_transparent>
+    pair<iterator, iterator> equal_range(const K& key) const {
+        return tiny_stl::equal_range(begin(), end(), key, this->compare);
+    }
+
+    iterator find(const key_type& key) const {
+        iterator pos = lower_bound(key);
+        return pos == end() || this->compare(key, *pos) ? end() : pos;
+    }
+
+    template <typename K, typename Cmp = Compare,
+              typename = typename Cmp::is_transparent>
+    iterator find(const K& key) const {
+        iterator pos = lower_bound(key);
+        return pos == end() || this->compare(key, *pos) ? end() : pos;
+    }
+
+    size_type count(const key_type& key) const {
+        return find(key) != end();
+    }
+
+    template <typename K, typename Cmp = Compare,
+              typename = typename Cmp::is_transparent>
+    size_type count(const K& key) const {
+        return find(key) != end();
+    }
+
+    bool contains(const key_type& key) const {
+        return find(key) != end();
+    }
+
+    template <typename K, typename Cmp = Compare,
+              typename = typename Cmp::is_transparent>
+    bool contains(const K& key) const {
+        return find(key) != end();
+    }
+}; // class flat_set
+
+template <typename Key, typename Cmp, typename Cont>
+inline bool operator==(const flat_set<Key, Cmp, Cont>& lhs,
+                       const flat_set<Key, Cmp, Cont>& rhs) {
+    return lhs.size() == rhs.size() &&
+           tiny_stl::equal(lhs.begin(), lhs.end(), rhs.begin());
+}
+
+template <typename Key, typename Cmp, typename Cont>
+inline bool operator!=(const flat_set<Key, Cmp, Cont>& lhs,
+                       const flat_set<Key, Cmp, Cont>& rhs) {
+    return !(lhs == rhs);
+}
+
+template <typename Key, typename Cmp, typename Cont>
+inline bool operator<(const flat_set<Key, Cmp, Cont>& lhs,
+                      const flat_set<Key, Cmp, Cont>& rhs) {
+    return tiny_stl::lexicographical_compare(lhs.begin(), lhs.end(),
+                                             rhs.begin(), rhs.end());
+}
+
+template <typename Key, typename Cmp, typename Cont>
+inline bool operator>(const flat_set<Key, Cmp, Cont>& lhs,
+                      const flat_set<Key, Cmp, Cont>& rhs) {
+    return rhs < lhs;
+}
+
+template <typename Key, typename Cmp, typename Cont>
+inline bool operator<=(const flat_set<Key, Cmp, Cont>& lhs,
+                       const flat_set<Key, Cmp, Cont>& rhs) {
+    return !(rhs < lhs);
+}
+
+template <typename Key, typename Cmp, typename Cont>
+inline bool operator>=(const flat_set<Key, Cmp, Cont>& lhs,
+                       const flat_set<Key, Cmp, Cont>& rhs) {
+    return !(lhs < rhs);
+}
+
+template <typename Key, typename Cmp, typename Cont>
+inline void
+swap(flat_set<Key, Cmp, Cont>& lhs,
+     flat_set<Key, Cmp, Cont>& rhs) noexcept(noexcept(lhs.swap(rhs))) {
+    lhs.swap(rhs);
+}
+
+namespace pmr {
+
+template <typename Key, typename Compare = less<Key>>
+using flat_set = tiny_stl::flat_set<Key, Compare, pmr::vector<Key>>;
+
+} // namespace pmr
+
+} // namespace tiny_stl
@@ -6,6 +6,7 @@
 
 #include <initializer_list>
 
+#include "list_sort.hpp"
 #include "memory.hpp"
 
 namespace tiny_stl {
@@ -296,8 +297,11 @@ public:
     forward_list& operator=(const forward_list& rhs) {
         assert(this != tiny_stl::addressof(rhs));
 
-        if (AlNodeTraits::propagate_on_container_copy_assignment::value)
+        if (AlNodeTraits::propagate_on_container_copy_assignment::value) {
+            if (this->getAlloc() != rhs.getAlloc())
+                clear(); // this->getAlloc() deallocate elements
             this->getAlloc() = rhs.getAlloc();
+        }
 
         assign(rhs.begin(), rhs.end());
         return *this;
@@ -578,47 +582,6 @@ private:
         }
     }
 
-    // merge sort
-    template <typename BinPred>
-    void sortAux(iterator before_first, iterator last, BinPred pred,
-                 size_type size) {
-        if (size < 2)
-            return;
-
-        size_type mid_size = size >> 1;
-
-        iterator mid = tiny_stl::next(before_first, 1 + mid_size); // init mid
-        sortAux(before_first, mid, pred, mid_size); // sort first half
-
-        // init before_mid
-        iterator before_mid = tiny_stl::next(before_first, mid_size);
-        sortAux(before_mid, last, pred, size - mid_size); // sort second half
-
-        // Because the iterator mid does not fail
-        // the previous sort will change the mid
-        // therefore, update the itertor mid
-        mid = tiny_stl::next(before_mid);
-        iterator first = tiny_stl::next(before_first);
-
-        // sort [first, mid) and [mid, last)
-        for (;;) {
-            if (pred(*mid, *first)) { // *mid < *first
-                splice_after(before_first, *this, before_mid);
-                ++before_first;
-                mid = tiny_stl::next(before_mid);
-
-                if (mid == last)
-                    return;
-            } else { // *mid >= *first
-                ++before_first;
-                ++first;
-
-                if (first == mid)
-                    return;
-            }
-        }
-    }
-
 public:
     void merge(forward_list& rhs) {
         mergeAux(rhs, tiny_stl::less<>{});
@@ -733,9 +696,10 @@ public:
         unique(tiny_stl::equal_to<>{});
     }
 
+    // bottom-up merge sort of natural runs, see list_sort.hpp
     template <typename Cmp>
     void sort(Cmp cmp) {
-        sortAux(before_begin(), end(), cmp, this->sizeAux());
+        listSortChain(this->getHead()->next, cmp, false_type{});
     }
 
     void sort() {
@@ -786,4 +750,11 @@ void swap(forward_list<T, Alloc>& lhs,
     lhs.swap(rhs);
 }
 
+namespace pmr {
+
+template <typename T>
+using forward_list = tiny_stl::forward_list<T, polymorphic_allocator<T>>;
+
+} // namespace pmr
+
 } // namespace tiny_stl
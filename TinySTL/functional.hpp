@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include "hash_bytes.hpp"
 #include "utility.hpp"
 
 namespace tiny_stl {
@@ -478,14 +479,25 @@ inline size_t hashFNV(const T* p, size_t count) noexcept {
     return ret;
 }
 
+// hash of string-like keys, hash<basic_string>, hash<cow_basic_string> and
+// hash<basic_string_view> use it. define TINY_STL_FNV_STRING_HASH to go back
+// to hashFNV
+template <typename CharT>
+inline size_t hashString(const CharT* p, size_t count) noexcept {
+#ifdef TINY_STL_FNV_STRING_HASH
+    return hashFNV(p, count);
+#else
+    return hashBytes(p, count * sizeof(CharT));
+#endif
+}
+
 template <typename Key>
 struct hash {
     using argument_type = Key;
     using result_type = size_t;
 
     size_t operator()(const Key& key) const noexcept {
-        return hashFNV(&reinterpret_cast<const unsigned char&>(key),
-                       sizeof(Key));
+        return hashBytes(tiny_stl::addressof(key), sizeof(Key));
     }
 };
 
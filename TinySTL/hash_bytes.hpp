@@ -0,0 +1,302 @@
+// Copyright (C) 2021 syn1w
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// Long input backend, define TINY_STL_NO_SIMD to force the portable one
+#if !defined(TINY_STL_NO_SIMD) &&                                              \
+    (defined(__SSE2__) || defined(_M_X64) ||                                   \
+     (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define TINY_STL_HASH_SSE2 1
+#include <emmintrin.h>
+#elif !defined(TINY_STL_NO_SIMD) && defined(__ARM_NEON)
+#define TINY_STL_HASH_NEON 1
+#include <arm_neon.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace tiny_stl {
+
+// Seedable hash of a byte sequence, word at a time
+//
+// len <= 256: wyhash-like, 16 or 48 bytes per round, each round is one
+//             64 x 64 -> 128 bit multiply
+// len >  256: xxh3-like, 8 accumulators fed by 64-byte stripes, which the
+//             SSE2/NEON backends update two lanes at a time. the
+//             accumulators are scrambled every 1024 bytes
+//
+// all backends give the same value, it is not the same as wyhash or xxh3
+
+static const size_t kHashLongSize = 256;
+static const size_t kHashStripe = 64;
+static const size_t kHashStripesPerBlock = 16;
+static const size_t kHashSecretSize = 24;
+
+static const uint64_t kHashWyP[4] = {
+    0xA0761D6478BD642FULL, 0xE7037ED1A0B428DBULL, 0x8EBC6AF09C88C6E3ULL,
+    0x589965CC75374CC3ULL};
+
+static const uint64_t kHashPrime32 = 0x9E3779B1U;
+
+// stripe s of a block is keyed by kHashSecret + s
+static const uint64_t kHashSecret[kHashSecretSize] = {
+    0x6E789E6AA1B965F4ULL, 0x06C45D188009454FULL, 0xF88BB8A8724C81ECULL,
+    0x1B39896A51A8749BULL, 0x53CB9F0C747EA2EAULL, 0x2C829ABE1F4532E1ULL,
+    0xC584133AC916AB3CULL, 0x3EE5789041C98AC3ULL, 0xF3B8488C368CB0A6ULL,
+    0x657EECDD3CB13D09ULL, 0xC2D326E0055BDEF6ULL, 0x8621A03FE0BBDB7BULL,
+    0x8E1F7555983AA92FULL, 0xB54E0F1600CC4D19ULL, 0x84BB3F97971D80ABULL,
+    0x7D29825C75521255ULL, 0xC3CF17102B7F7F86ULL, 0x3466E9A083914F64ULL,
+    0xD81A8D2B5A4485ACULL, 0xDB01602B100B9ED7ULL, 0xA9038A921825F10DULL,
+    0xEDF5F1D90DCA2F6AULL, 0x54496AD67BD2634CULL, 0xDD7C01D4F5407269ULL};
+
+inline uint64_t hashRead8(const unsigned char* p) noexcept {
+    uint64_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+inline uint64_t hashRead4(const unsigned char* p) noexcept {
+    uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+// a * b, a = the low 64 bits, b = the high 64 bits
+inline void hashMum(uint64_t& a, uint64_t& b) noexcept {
+#if defined(__SIZEOF_INT128__)
+    __uint128_t r = a;
+    r *= b;
+    a = static_cast<uint64_t>(r);
+    b = static_cast<uint64_t>(r >> 64);
+#elif defined(_MSC_VER) && defined(_M_X64)
+    a = _umul128(a, b, &b);
+#else
+    const uint64_t ha = a >> 32, hb = b >> 32;
+    const uint64_t la = static_cast<uint32_t>(a), lb = static_cast<uint32_t>(b);
+    const uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+    const uint64_t t = rl + (rm0 << 32);
+    uint64_t carry = t < rl;
+    const uint64_t lo = t + (rm1 << 32);
+    carry += lo < t;
+    a = lo;
+    b = rh + (rm0 >> 32) + (rm1 >> 32) + carry;
+#endif
+}
+
+inline uint64_t hashMix64(uint64_t a, uint64_t b) noexcept {
+    hashMum(a, b);
+    return a ^ b;
+}
+
+// acc[i] += lo32(d ^ key) * hi32(d ^ key), acc[i ^ 1] += d
+struct HashAccPortable {
+    static void accumulate(uint64_t* acc, const unsigned char* p,
+                           const uint64_t* key) noexcept {
+        for (size_t i = 0; i < 8; ++i) {
+            const uint64_t d = hashRead8(p + 8 * i);
+            const uint64_t dk = d ^ key[i];
+            acc[i ^ 1] += d;
+            acc[i] += (dk & 0xFFFFFFFFU) * (dk >> 32);
+        }
+    }
+
+    static void scramble(uint64_t* acc, const uint64_t* key) noexcept {
+        for (size_t i = 0; i < 8; ++i) {
+            uint64_t a = acc[i];
+            a ^= a >> 47;
+            a ^= key[i];
+            acc[i] = a * kHashPrime32;
+        }
+    }
+};
+
+#ifdef TINY_STL_HASH_SSE2
+struct HashAccSse2 {
+    static void accumulate(uint64_t* acc, const unsigned char* p,
+                           const uint64_t* key) noexcept {
+        __m128i* xacc = reinterpret_cast<__m128i*>(acc);
+        for (size_t j = 0; j < 4; ++j) {
+            const __m128i d =
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(p) + j);
+            const __m128i k =
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(key) + j);
+            const __m128i dk = _mm_xor_si128(d, k);
+            // the high half of each lane moved to the low half
+            const __m128i dkHi = _mm_shuffle_epi32(dk, _MM_SHUFFLE(0, 3, 0, 1));
+            const __m128i prod = _mm_mul_epu32(dk, dkHi);
+            const __m128i dSwap = _mm_shuffle_epi32(d, _MM_SHUFFLE(1, 0, 3, 2));
+            xacc[j] = _mm_add_epi64(xacc[j], _mm_add_epi64(prod, dSwap));
+        }
+    }
+
+    static void scramble(uint64_t* acc, const uint64_t* key) noexcept {
+        __m128i* xacc = reinterpret_cast<__m128i*>(acc);
+        const __m128i prime = _mm_set1_epi32(static_cast<int>(kHashPrime32));
+        for (size_t j = 0; j < 4; ++j) {
+            __m128i a = xacc[j];
+            a = _mm_xor_si128(a, _mm_srli_epi64(a, 47));
+            a = _mm_xor_si128(
+                a, _mm_loadu_si128(reinterpret_cast<const __m128i*>(key) + j));
+            const __m128i lo = _mm_mul_epu32(a, prime);
+            const __m128i hi = _mm_mul_epu32(_mm_srli_epi64(a, 32), prime);
+            xacc[j] = _mm_add_epi64(lo, _mm_slli_epi64(hi, 32));
+        }
+    }
+};
+#endif // TINY_STL_HASH_SSE2
+
+#ifdef TINY_STL_HASH_NEON
+struct HashAccNeon {
+    static void accumulate(uint64_t* acc, const unsigned char* p,
+                           const uint64_t* key) noexcept {
+        for (size_t j = 0; j < 4; ++j) {
+            uint64x2_t a = vld1q_u64(acc + 2 * j);
+            const uint64x2_t d = vreinterpretq_u64_u8(vld1q_u8(p + 16 * j));
+            const uint64x2_t dk = veorq_u64(d, vld1q_u64(key + 2 * j));
+            const uint64x2_t prod =
+                vmull_u32(vmovn_u64(dk), vshrn_n_u64(dk, 32));
+            a = vaddq_u64(a, vextq_u64(d, d, 1));
+            vst1q_u64(acc + 2 * j, vaddq_u64(a, prod));
+        }
+    }
+
+    static void scramble(uint64_t* acc, const uint64_t* key) noexcept {
+        const uint32x2_t prime =
+            vdup_n_u32(static_cast<uint32_t>(kHashPrime32));
+        for (size_t j = 0; j < 4; ++j) {
+            uint64x2_t a = vld1q_u64(acc + 2 * j);
+            a = veorq_u64(a, vshrq_n_u64(a, 47));
+            a = veorq_u64(a, vld1q_u64(key + 2 * j));
+            const uint64x2_t lo = vmull_u32(vmovn_u64(a), prime);
+            const uint64x2_t hi = vmull_u32(vshrn_n_u64(a, 32), prime);
+            vst1q_u64(acc + 2 * j, vaddq_u64(lo, vshlq_n_u64(hi, 32)));
+        }
+    }
+};
+#endif // TINY_STL_HASH_NEON
+
+#if defined(TINY_STL_HASH_SSE2)
+using HashAcc = HashAccSse2;
+#elif defined(TINY_STL_HASH_NEON)
+using HashAcc = HashAccNeon;
+#else
+using HashAcc = HashAccPortable;
+#endif
+
+template <typename Acc>
+inline uint64_t hashLong(const unsigned char* p, size_t len,
+                         uint64_t seed) noexcept {
+    uint64_t seeded[kHashSecretSize];
+    const uint64_t* key = kHashSecret;
+    if (seed != 0) {
+        for (size_t i = 0; i < kHashSecretSize; ++i)
+            seeded[i] = (i & 1) ? kHashSecret[i] - seed : kHashSecret[i] + seed;
+        key = seeded;
+    }
+
+    alignas(16) uint64_t acc[8] = {
+        0xC2B2AE3DU,           0x9E3779B185EBCA87ULL, 0xC2B2AE3D27D4EB4FULL,
+        0x165667B19E3779F9ULL, 0x85EBCA77C2B2AE63ULL, 0x85EBCA77U,
+        0x27D4EB2F165667C5ULL, 0x9E3779B1U};
+
+    const size_t blockSize = kHashStripe * kHashStripesPerBlock;
+    const size_t numBlocks = (len - 1) / blockSize;
+    for (size_t b = 0; b < numBlocks; ++b) {
+        for (size_t s = 0; s < kHashStripesPerBlock; ++s)
+            Acc::accumulate(acc, p + b * blockSize + s * kHashStripe, key + s);
+        Acc::scramble(acc, key + kHashSecretSize - 8);
+    }
+
+    // the last stripe may overlap the previous one
+    const unsigned char* rest = p + numBlocks * blockSize;
+    const size_t numStripes = (len - 1 - numBlocks * blockSize) / kHashStripe;
+    for (size_t s = 0; s < numStripes; ++s)
+        Acc::accumulate(acc, rest + s * kHashStripe, key + s);
+    Acc::accumulate(acc, p + len - kHashStripe, key + 13);
+
+    uint64_t h = len * 0x9E3779B185EBCA87ULL;
+    for (size_t i = 0; i < 4; ++i)
+        h += hashMix64(acc[2 * i] ^ key[2 * i + 3],
+                       acc[2 * i + 1] ^ key[2 * i + 4]);
+
+    h ^= h >> 37;
+    h *= 0x165667919E3779F9ULL;
+    h ^= h >> 32;
+
+    return h;
+}
+
+inline uint64_t hashBytes64(const void* data, size_t len,
+                            uint64_t seed = 0) noexcept {
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    if (len > kHashLongSize)
+        return hashLong<HashAcc>(p, len, seed);
+
+    seed ^= hashMix64(seed ^ kHashWyP[0], kHashWyP[1]);
+
+    uint64_t a;
+    uint64_t b;
+    if (len <= 16) {
+        if (len >= 4) {
+            // two overlapping reads of 4 bytes from each end
+            const size_t mid = (len >> 3) << 2;
+            a = (hashRead4(p) << 32) | hashRead4(p + mid);
+            b = (hashRead4(p + len - 4) << 32) | hashRead4(p + len - 4 - mid);
+        } else if (len > 0) {
+            a = (static_cast<uint64_t>(p[0]) << 16) |
+                (static_cast<uint64_t>(p[len >> 1]) << 8) | p[len - 1];
+            b = 0;
+        } else {
+            a = b = 0;
+        }
+    } else {
+        size_t i = len;
+        if (i > 48) {
+            uint64_t see1 = seed;
+            uint64_t see2 = seed;
+            do {
+                seed = hashMix64(hashRead8(p) ^ kHashWyP[1],
+                                 hashRead8(p + 8) ^ seed);
+                see1 = hashMix64(hashRead8(p + 16) ^ kHashWyP[2],
+                                 hashRead8(p + 24) ^ see1);
+                see2 = hashMix64(hashRead8(p + 32) ^ kHashWyP[3],
+                                 hashRead8(p + 40) ^ see2);
+                p += 48;
+                i -= 48;
+            } while (i > 48);
+            seed ^= see1 ^ see2;
+        }
+
+        while (i > 16) {
+            seed =
+                hashMix64(hashRead8(p) ^ kHashWyP[1], hashRead8(p + 8) ^ seed);
+            p += 16;
+            i -= 16;
+        }
+
+        // the last 16 bytes, may overlap the previous round
+        a = hashRead8(p + i - 16);
+        b = hashRead8(p + i - 8);
+    }
+
+    a ^= kHashWyP[1];
+    b ^= seed;
+    hashMum(a, b);
+
+    return hashMix64(a ^ kHashWyP[0] ^ len, b ^ kHashWyP[1]);
+}
+
+inline size_t hashBytes(const void* data, size_t len,
+                        size_t seed = 0) noexcept {
+    return static_cast<size_t>(hashBytes64(data, len, seed));
+}
+
+} // namespace tiny_stl
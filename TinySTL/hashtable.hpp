@@ -4,7 +4,10 @@
 
 #pragma once
 
+#include <cstdint>
+
 #include "forward_list.hpp"
+#include "stats.hpp"
 #include "vector.hpp"
 
 namespace tiny_stl {
@@ -46,21 +49,8 @@ struct HashConstIterator {
 
     HashConstIterator& operator++() {
         ++iter;
-        if (iter == hashtable->buckets[idx_bucket].end()) {
-            // jump to the next bucket with element(s)
-            for (;;) {
-                if (idx_bucket == hashtable->buckets.size() - 1) {
-                    iter = hashtable->buckets[idx_bucket].end();
-                    break;
-                } else {
-                    ++idx_bucket;
-                    if (!hashtable->buckets[idx_bucket].empty()) {
-                        iter = hashtable->buckets[idx_bucket].begin();
-                        break;
-                    }
-                }
-            }
-        }
+        // jump to the next bucket with element(s)
+        idx_bucket = hashtable->updateNextIter(iter, idx_bucket);
 
         return *this;
     }
@@ -107,20 +97,7 @@ struct HashIterator {
 
     HashIterator& operator++() {
         ++iter;
-        if (iter == hashtable->buckets[idx_bucket].end()) {
-            for (;;) {
-                if (idx_bucket == hashtable->buckets.size() - 1) {
-                    iter = hashtable->buckets[idx_bucket].end();
-                    break;
-                } else {
-                    ++idx_bucket;
-                    if (!hashtable->buckets[idx_bucket].empty()) {
-                        iter = hashtable->buckets[idx_bucket].begin();
-                        break;
-                    }
-                }
-            }
-        }
+        idx_bucket = hashtable->updateNextIter(iter, idx_bucket);
 
         return *this;
     }
@@ -140,14 +117,33 @@ struct HashIterator {
     }
 };
 
-// FIXME: write a helper class for prime
+#if SIZE_MAX > 0xFFFFFFFFU
+static const int stlPrimesSize = 61;
+#else
 static const int stlPrimesSize = 28;
+#endif
+
 static const size_t stlPrimesArray[stlPrimesSize] = {
     53,        97,         193,         389,        769,       1543,
     3079,      6151,       12289,       24593,      49157,     98317,
     196613,    393241,     786433,      1572869,    3145739,   6291469,
     12582917,  25165843,   50331653,    100663319,  201326611, 402653189,
-    805306457, 1610612741, 3221225473U, 4294967291U};
+    805306457, 1610612741, 3221225473U, 4294967291U,
+#if SIZE_MAX > 0xFFFFFFFFU
+    // the first prime after 3 * 2^k, k = 31 ... 62, and the last 64-bit prime
+    6442450967ULL, 12884901893ULL, 25769803799ULL,
+    51539607599ULL, 103079215111ULL, 206158430209ULL,
+    412316860441ULL, 824633720837ULL, 1649267441681ULL,
+    3298534883417ULL, 6597069766657ULL, 13194139533349ULL,
+    26388279066671ULL, 52776558133303ULL, 105553116266509ULL,
+    211106232533047ULL, 422212465066001ULL, 844424930132057ULL,
+    1688849860263953ULL, 3377699720527897ULL, 6755399441055827ULL,
+    13510798882111519ULL, 27021597764223071ULL, 54043195528445957ULL,
+    108086391056891941ULL, 216172782113783843ULL, 432345564227567621ULL,
+    864691128455135281ULL, 1729382256910270481ULL, 3458764513820540933ULL,
+    6917529027641081903ULL, 13835058055282163729ULL, 18446744073709551557ULL
+#endif
+};
 
 inline size_t stlNextPrime(size_t n) {
     const size_t* first = stlPrimesArray;
@@ -157,8 +153,86 @@ inline size_t stlNextPrime(size_t n) {
     return pos == last ? *(last - 1) : *pos;
 }
 
+// murmur3 finalizer, every bit of the input affects the low bits
+inline size_t hashMix(size_t h) noexcept {
+#if SIZE_MAX > 0xFFFFFFFFU
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDULL;
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53ULL;
+    h ^= h >> 33;
+#else
+    h ^= h >> 16;
+    h *= 0x85EBCA6BU;
+    h ^= h >> 13;
+    h *= 0xC2B2AE35U;
+    h ^= h >> 16;
+#endif
+    return h;
+}
+
+// bucket count policy of HashTable
+//
+// next_size(n): the bucket count used for at least n buckets
+// index(hash, n): the bucket of hash when there are n buckets
+
+// prime bucket count, hash % n, tolerates weak user hash functions
+struct prime_bucket_policy {
+    static size_t next_size(size_t n) noexcept {
+        return stlNextPrime(n);
+    }
+
+    static size_t index(size_t hash, size_t n) noexcept {
+        return hash % n;
+    }
+
+    static size_t max_size() noexcept {
+        return stlPrimesArray[stlPrimesSize - 1];
+    }
+};
+
+// power-of-two bucket count, the mixed hash is masked instead of divided
+struct pow2_bucket_policy {
+    static const size_t kMinSize = 64;
+
+    static size_t next_size(size_t n) noexcept {
+        size_t count = kMinSize;
+        while (count < n && count < max_size())
+            count <<= 1;
+        return count;
+    }
+
+    static size_t index(size_t hash, size_t n) noexcept {
+        return hashMix(hash) & (n - 1);
+    }
+
+    static size_t max_size() noexcept {
+        return (SIZE_MAX >> 1) + 1;
+    }
+};
+
+// whether HashTable stores the hash code of the key in each node, so that
+// rehash need not call Hash, and a node whose hash code differs is skipped
+// without calling KeyEqual. hashing a scalar key costs less than storing it,
+// specialize it for other cheap or expensive Hash
+template <typename Key, typename Hash>
+struct hash_code_cached : bool_constant<!is_scalar<Key>::value> {};
+
+template <typename T>
+struct HashNode : FLNode<T> {
+    size_t hash_code;
+};
+
+// a singly linked chain of FLNode per bucket, the nodes are owned by the
+// table itself, so rehash only relinks them
+//
+// incremental rehash (off by default): when the table grows, the old bucket
+// array is kept and its chains are moved to the new array a few buckets per
+// insertion. while it is in progress, a key lives in its old bucket if that
+// bucket is not migrated yet, otherwise in its new bucket. bucket n refers to
+// the new array for n < new bucket count, and to the old array after that
 template <typename T, typename Hash, typename KeyEqual, typename Alloc,
-          bool isMap>
+          bool isMap, typename BucketPolicy = prime_bucket_policy>
 class HashTable {
     friend HashConstIterator<T, const HashTable>;
     friend HashIterator<T, HashTable>;
@@ -175,27 +249,43 @@ public:
     using reference = value_type&;
     using const_reference = const value_type&;
     using AlTraits = allocator_traits<Alloc>;
-    using List = forward_list<T>;
     using pointer = typename AlTraits::pointer;
     using const_pointer = typename AlTraits::const_pointer;
 
     using iterator = HashIterator<T, HashTable>;
     using const_iterator = HashConstIterator<T, const HashTable>;
 
-    using local_iterator = typename forward_list<T>::iterator;
-    using const_local_iterator = typename forward_list<T>::const_iterator;
+    using local_iterator = FListIterator<T>;
+    using const_local_iterator = FListConstIterator<T>;
 
-    using AlFlist = typename allocator_traits<Alloc>::template rebind_alloc<
-        forward_list<T>>;
-    using Bucket = vector<forward_list<T>, AlFlist>;
-    using Self = HashTable<T, Hash, KeyEqual, Alloc, isMap>;
+    static const bool cacheHash = hash_code_cached<key_type, Hash>::value;
+
+    // the chains are linked through FLNode, Node is what is allocated
+    using Node = conditional_t<cacheHash, HashNode<T>, FLNode<T>>;
+    using NodePtr = FLNode<T>*;
+    using AlNode = typename AlTraits::template rebind_alloc<Node>;
+    using AlNodePtr = typename AlTraits::template rebind_alloc<NodePtr>;
+    using Bucket = vector<NodePtr, AlNodePtr>;
+    using Self = HashTable<T, Hash, KeyEqual, Alloc, isMap, BucketPolicy>;
+
+    // old buckets migrated per insertion during incremental rehash
+    static const size_type kRehashStep = 8;
 
 public:
     Bucket buckets;
+    Bucket old_buckets;    // not empty only during incremental rehash
+    size_type migrate_pos; // old buckets before it have been migrated
     size_type num_elements;
     float maxfactor;
+    bool incremental;
     hasher hashfunc;
     key_equal key_equ;
+    AlNode alnode;
+
+#ifdef TINY_STL_STATS
+    size_type rehash_count = 0;
+    uint64_t rehash_ns = 0;
+#endif
 
 private:
     // map
@@ -212,124 +302,381 @@ private:
         return getKey(val, tiny_stl::bool_constant<isMap>{});
     }
 
-    size_type getNthBucket(const T& val) const {
-        return hashfunc(get_key(val)) % buckets.size();
+    NodePtr& bucketHead(size_type n) {
+        return n < buckets.size() ? buckets[n]
+                                  : old_buckets[n - buckets.size()];
+    }
+
+    NodePtr bucketHead(size_type n) const {
+        return n < buckets.size() ? buckets[n]
+                                  : old_buckets[n - buckets.size()];
+    }
+
+    // the bucket where the key of hash h lives now
+    size_type bucketOfHash(size_t h) const {
+        if (!old_buckets.empty()) {
+            size_type idx = BucketPolicy::index(h, old_buckets.size());
+            if (old_buckets[idx] != nullptr)
+                return buckets.size() + idx;
+        }
+
+        return BucketPolicy::index(h, buckets.size());
+    }
+
+    size_t nodeHash(NodePtr p, true_type) const {
+        return static_cast<const Node*>(p)->hash_code;
+    }
+
+    size_t nodeHash(NodePtr p, false_type) const {
+        return hashfunc(get_key(p->data));
+    }
+
+    size_t nodeHash(NodePtr p) const {
+        return nodeHash(p, bool_constant<cacheHash>{});
+    }
+
+    void setHash(NodePtr p, size_t h, true_type) {
+        static_cast<Node*>(p)->hash_code = h;
+    }
+
+    void setHash(NodePtr, size_t, false_type) {
+    }
+
+    void copyHash(NodePtr dst, NodePtr src, true_type) {
+        setHash(dst, nodeHash(src), true_type{});
+    }
+
+    void copyHash(NodePtr, NodePtr, false_type) {
+    }
+
+    // h is the hash code of key
+    bool nodeMatch(NodePtr p, const key_type& key, size_t h, true_type) const {
+        return static_cast<const Node*>(p)->hash_code == h &&
+               key_equ(get_key(p->data), key);
+    }
+
+    bool nodeMatch(NodePtr p, const key_type& key, size_t, false_type) const {
+        return key_equ(get_key(p->data), key);
+    }
+
+    bool nodeMatch(NodePtr p, const key_type& key, size_t h) const {
+        return nodeMatch(p, key, h, bool_constant<cacheHash>{});
+    }
+
+    template <typename... U>
+    NodePtr createNode(NodePtr nextNode, size_t h, U&&... val) {
+        Node* p = nullptr;
+        try {
+            p = alnode.allocate(1);
+            alnode.construct(tiny_stl::addressof(p->data),
+                             tiny_stl::forward<U>(val)...);
+        } catch (...) {
+            alnode.deallocate(p, 1);
+            throw;
+        }
+
+        p->next = nextNode;
+        setHash(p, h, bool_constant<cacheHash>{});
+
+        return p;
+    }
+
+    void freeNode(NodePtr p) {
+        alnode.destroy(tiny_stl::addressof(p->data));
+        alnode.deallocate(static_cast<Node*>(p), 1);
+    }
+
+    void freeChains(Bucket& bkt) noexcept {
+        for (auto& head : bkt) {
+            while (head != nullptr) {
+                NodePtr next = head->next;
+                freeNode(head);
+                head = next;
+            }
+        }
     }
 
-    size_type getNthBucketK(const key_type& key) const {
-        return hashfunc(key) % buckets.size();
+    void freeOldBuckets() {
+        Bucket(AlNodePtr(alnode)).swap(old_buckets);
+        migrate_pos = 0;
     }
 
     void init(size_type n) {
-        const size_type num_bucket = stlNextPrime(n);
-        buckets.reserve(num_bucket);
-        buckets.assign(num_bucket, List{});
+        buckets.assign(BucketPolicy::next_size(n), nullptr);
+        migrate_pos = 0;
         maxfactor = 1.0f;
         num_elements = 0;
+        incremental = false;
+    }
+
+    // deep copy, the order in each chain is kept
+    void copyChains(const Bucket& src, Bucket& dst) {
+        dst.assign(src.size(), nullptr);
+        for (size_type i = 0; i < src.size(); ++i) {
+            NodePtr* tail = &dst[i];
+            for (NodePtr p = src[i]; p != nullptr; p = p->next) {
+                *tail = createNode(nullptr, 0, p->data);
+                copyHash(*tail, p, bool_constant<cacheHash>{});
+                tail = &(*tail)->next;
+            }
+        }
     }
 
     void copyAux(const HashTable& rhs) {
-        buckets = rhs.buckets;
-    }
-
-    size_type updateNextIter(const_local_iterator& iter, size_type idx) const {
-        size_type iterIdx = idx;
-        if (iter == buckets[iterIdx].end()) {
-            for (;;) {
-                if (iterIdx == bucket_count() - 1) {
-                    iter = buckets[iterIdx].end();
-                    break;
-                } else {
-                    ++iterIdx;
-                    if (!buckets[iterIdx].empty()) {
-                        iter = buckets[iterIdx].begin();
-                        break;
-                    }
-                }
+        try {
+            copyChains(rhs.buckets, buckets);
+            copyChains(rhs.old_buckets, old_buckets);
+        } catch (...) {
+            freeChains(buckets);
+            freeChains(old_buckets);
+            throw;
+        }
+        migrate_pos = rhs.migrate_pos;
+    }
+
+    // move every node of the chain into dst, no allocation and no copy.
+    // equal keys are adjacent in the chain, so they stay adjacent in dst
+    void relinkChain(NodePtr& head, Bucket& dst) {
+        NodePtr p = head;
+        head = nullptr;
+        while (p != nullptr) {
+            NodePtr next = p->next;
+            NodePtr& dstHead =
+                dst[BucketPolicy::index(nodeHash(p), dst.size())];
+            p->next = dstHead;
+            dstHead = p;
+            p = next;
+        }
+    }
+
+    void rehashStep() {
+        for (size_type k = 0;
+             k < kRehashStep && migrate_pos < old_buckets.size(); ++k)
+            relinkChain(old_buckets[migrate_pos++], buckets);
+
+        if (migrate_pos == old_buckets.size())
+            freeOldBuckets();
+    }
+
+    void finishRehash() {
+        if (old_buckets.empty())
+            return;
+
+#ifdef TINY_STL_STATS
+        StatsTimer timer(rehash_ns);
+#endif
+        while (migrate_pos < old_buckets.size())
+            relinkChain(old_buckets[migrate_pos++], buckets);
+
+        freeOldBuckets();
+    }
+
+    void rehashAux(size_type count) {
+        finishRehash();
+        if (count == buckets.size())
+            return;
+
+#ifdef TINY_STL_STATS
+        ++rehash_count;
+        StatsTimer timer(rehash_ns);
+#endif
+        Bucket newBuckets(count, static_cast<NodePtr>(nullptr),
+                          AlNodePtr(alnode));
+        for (auto& head : buckets)
+            relinkChain(head, newBuckets);
+
+        buckets.swap(newBuckets);
+    }
+
+    void startRehash(size_type count) {
+        finishRehash();
+        if (count == buckets.size())
+            return;
+
+#ifdef TINY_STL_STATS
+        ++rehash_count;
+        StatsTimer timer(rehash_ns);
+#endif
+        old_buckets.swap(buckets);
+        buckets.assign(count, nullptr);
+        migrate_pos = 0;
+    }
+
+    // make room for one more element
+    void growAux() {
+        if (static_cast<float>(size() + 1) <=
+            max_load_factor() * static_cast<float>(buckets.size()))
+            return;
+
+        const size_type n = static_cast<size_type>(
+            static_cast<float>(size() + 1) / max_load_factor());
+        const size_type count = BucketPolicy::next_size(
+            tiny_stl::max(n + 1, buckets.size() + 1));
+
+        if (incremental && !buckets.empty())
+            startRehash(count);
+        else
+            rehashAux(count);
+    }
+
+    // the new bucket of hash h, where the inserted node goes
+    size_type prepareInsert(size_t h) {
+        if (!old_buckets.empty()) {
+#ifdef TINY_STL_STATS
+            StatsTimer timer(rehash_ns);
+#endif
+            // the old bucket of the key first, so that equal keys never
+            // live in both arrays
+            relinkChain(old_buckets[BucketPolicy::index(h, old_buckets.size())],
+                        buckets);
+            rehashStep();
+        }
+
+        return BucketPolicy::index(h, buckets.size());
+    }
+
+    // return the bucket of key, node is the first element equal to key or
+    // nullptr
+    size_type findNode(const key_type& key, size_t h, NodePtr& node) const {
+        node = nullptr;
+        if (num_elements == 0)
+            return 0;
+
+        const size_type idx = bucketOfHash(h);
+        for (NodePtr p = bucketHead(idx); p != nullptr; p = p->next) {
+            if (nodeMatch(p, key, h)) {
+                node = p;
+                break;
             }
         }
 
-        return iterIdx;
+        return idx;
     }
 
-    size_type updateNextIter(local_iterator& iter, size_type idx) {
-        return static_cast<const Self&>(*this).updateNextIter(iter, idx);
+    // the end of the range of key which begins at first
+    NodePtr lastEqual(const key_type& key, size_t h, NodePtr first) const {
+        NodePtr last = first->next;
+        while (last != nullptr && nodeMatch(last, key, h))
+            last = last->next;
+
+        return last;
+    }
+
+    template <typename LocalIter>
+    size_type updateNextIter(LocalIter& iter, size_type idx) const {
+        if (iter.ptr != nullptr)
+            return idx;
+
+        const size_type total = bucket_count();
+        for (++idx; idx < total; ++idx) {
+            NodePtr head = bucketHead(idx);
+            if (head != nullptr) {
+                iter.ptr = head;
+                return idx;
+            }
+        }
+
+        return 0; // end
     }
 
 public:
     HashTable(size_type n, const Alloc& al = Alloc(),
               const hasher& hf = hasher(), const key_equal& equ = key_equal())
-        : buckets(static_cast<AlFlist>(al)), hashfunc(hf), key_equ(equ) {
+        : buckets(AlNodePtr(al)), old_buckets(AlNodePtr(al)), hashfunc(hf),
+          key_equ(equ), alnode(al) {
         init(n);
     }
 
-    HashTable(const HashTable&) = default;
+    HashTable(const HashTable& rhs)
+        : HashTable(rhs, AlTraits::select_on_container_copy_construction(
+                             rhs.get_allocator())) {
+    }
 
     HashTable(const HashTable& rhs, const Alloc& alloc)
-        : buckets(static_cast<AlFlist>(alloc)), num_elements(rhs.num_elements),
-          maxfactor(rhs.maxfactor), hashfunc(rhs.hashfunc),
-          key_equ(rhs.key_equ) {
+        : buckets(AlNodePtr(alloc)), old_buckets(AlNodePtr(alloc)),
+          migrate_pos(0), num_elements(rhs.num_elements),
+          maxfactor(rhs.maxfactor), incremental(rhs.incremental),
+          hashfunc(rhs.hashfunc), key_equ(rhs.key_equ), alnode(alloc) {
         copyAux(rhs);
     }
 
     HashTable(HashTable&& rhs) noexcept
-        : buckets(tiny_stl::move(rhs.buckets)), num_elements(rhs.num_elements),
-          maxfactor(rhs.maxfactor), hashfunc(rhs.hashfunc),
-          key_equ(rhs.key_equ) {
+        : buckets(tiny_stl::move(rhs.buckets)),
+          old_buckets(tiny_stl::move(rhs.old_buckets)),
+          migrate_pos(rhs.migrate_pos), num_elements(rhs.num_elements),
+          maxfactor(rhs.maxfactor), incremental(rhs.incremental),
+          hashfunc(rhs.hashfunc), key_equ(rhs.key_equ),
+          alnode(tiny_stl::move(rhs.alnode)) {
+        rhs.migrate_pos = 0;
         rhs.num_elements = 0;
     }
 
     HashTable& operator=(const HashTable& rhs) {
         assert(this != tiny_stl::addressof(rhs));
-        buckets = rhs.buckets;
-        num_elements = rhs.num_elements;
-        hashfunc = rhs.hashfunc;
-        key_equ = rhs.key_equ;
-        maxfactor = rhs.maxfactor;
+        HashTable tmp(rhs, get_allocator());
+        this->swap(tmp);
 
         return *this;
     }
 
     HashTable& operator=(HashTable&& rhs) {
         assert(this != tiny_stl::addressof(rhs));
-        buckets = tiny_stl::move(rhs.buckets);
-        num_elements = rhs.num_elements;
+        using POCMA = typename allocator_traits<
+            AlNode>::propagate_on_container_move_assignment;
+
+        if (POCMA::value || alnode == rhs.alnode) {
+            freeChains(buckets);
+            freeChains(old_buckets);
+            buckets = tiny_stl::move(rhs.buckets);
+            old_buckets = tiny_stl::move(rhs.old_buckets);
+            if (POCMA::value)
+                alnode = tiny_stl::move(rhs.alnode);
+
+            migrate_pos = rhs.migrate_pos;
+            num_elements = rhs.num_elements;
+            rhs.migrate_pos = 0;
+            rhs.num_elements = 0;
+        } else {
+            // the nodes of rhs can not be freed by alnode, move individually
+            clear();
+            for (auto& val : rhs)
+                insertEqualAux(tiny_stl::move(val));
+            rhs.clear();
+        }
+
+        maxfactor = rhs.maxfactor;
+        incremental = rhs.incremental;
         hashfunc = rhs.hashfunc;
         key_equ = rhs.key_equ;
-        maxfactor = rhs.maxfactor;
-        rhs.num_elements = 0;
 
         return *this;
     }
 
-    ~HashTable() noexcept = default;
+    ~HashTable() noexcept {
+        freeChains(buckets);
+        freeChains(old_buckets);
+    }
 
     allocator_type get_allocator() const {
-        return allocator_type{};
+        return allocator_type(alnode);
     }
 
     iterator begin() noexcept {
-        size_type idx = 0;
-        for (; idx != buckets.size(); ++idx) {
-            if (!buckets[idx].empty())
-                break;
-        }
-        if (idx == buckets.size())
+        if (bucket_count() == 0)
             return end();
 
-        return iterator(idx, begin(idx), this);
+        local_iterator iter(bucketHead(0));
+        size_type idx = updateNextIter(iter, 0);
+        return iterator(idx, iter, this);
     }
 
     const_iterator begin() const noexcept {
-        size_type idx = 0;
-        for (; idx != buckets.size(); ++idx) {
-            if (!buckets[idx].empty())
-                break;
-        }
-        if (idx == buckets.size())
+        if (bucket_count() == 0)
             return end();
 
-        return const_iterator(idx, begin(idx), this);
+        const_local_iterator iter(bucketHead(0));
+        size_type idx = updateNextIter(iter, 0);
+        return const_iterator(idx, iter, this);
     }
 
     const_iterator cbegin() const noexcept {
@@ -337,13 +684,11 @@ public:
     }
 
     iterator end() noexcept {
-        size_type idx = bucket_count() - 1;
-        return iterator(idx, buckets[idx].end(), this);
+        return iterator(0, local_iterator(), this);
     }
 
     const_iterator end() const noexcept {
-        size_type idx = bucket_count() - 1;
-        return const_iterator(idx, buckets[idx].end(), this);
+        return const_iterator(0, const_local_iterator(), this);
     }
 
     const_iterator cend() const noexcept {
@@ -362,57 +707,56 @@ public:
         return static_cast<size_t>(-1);
     }
 
+    // keep the bucket count
     void clear() noexcept {
-        init(0);
+        freeChains(buckets);
+        freeChains(old_buckets);
+        freeOldBuckets();
+        num_elements = 0;
     }
 
 private:
     template <typename Value>
     iterator insertEqualAux(Value&& val) {
-        if (load_factor() > max_load_factor())
-            rehash(stlNextPrime(size()));
-
-        ++num_elements;
-
-        size_type idx = getNthBucket(val);
+        growAux();
 
-        for (auto cpos = cbegin(idx); cpos != cend(idx); ++cpos) {
-            if (key_equ(get_key(val), get_key(*cpos))) { // existing
-                auto pos = buckets[idx].insert_after(
-                    cpos, tiny_stl::forward<Value>(val));
+        const size_t h = hashfunc(get_key(val));
+        const size_type idx = prepareInsert(h);
 
-                return iterator(idx, pos, this);
+        NodePtr* pos = &buckets[idx];
+        for (NodePtr p = *pos; p != nullptr; p = p->next) {
+            if (nodeMatch(p, get_key(val), h)) { // existing
+                pos = &p->next;
+                break;
             }
         }
 
-        // not exist
-        auto pos = buckets[idx].insert_after(buckets[idx].before_begin(),
-                                             tiny_stl::forward<Value>(val));
-        return iterator(idx, pos, this);
+        *pos = createNode(*pos, h, tiny_stl::forward<Value>(val));
+        ++num_elements;
+
+        return iterator(idx, local_iterator(*pos), this);
     }
 
     template <typename Value>
     pair<iterator, bool> insertUniqueAux(Value&& val) {
-        size_type idx = getNthBucket(val);
-
-        for (auto cpos = cbegin(idx); cpos != cend(idx); ++cpos) {
-            if (key_equ(get_key(val), get_key(*cpos))) { // existing
-                return make_pair(
-                    iterator(idx, buckets[idx].makeIter(cpos), this), false);
-            }
+        const size_t h = hashfunc(get_key(val));
+        NodePtr node;
+        size_type idx = findNode(get_key(val), h, node);
+        if (node != nullptr) { // existing
+            return tiny_stl::make_pair(
+                iterator(idx, local_iterator(node), this), false);
         }
 
         // not exist
-        ++num_elements;
-        if (load_factor() > max_load_factor()) {
-            rehash(stlNextPrime(size()));
-            idx = getNthBucket(val);
-        }
+        growAux();
+        idx = prepareInsert(h);
 
-        auto pos = buckets[idx].insert_after(buckets[idx].before_begin(),
-                                             tiny_stl::forward<Value>(val));
+        buckets[idx] =
+            createNode(buckets[idx], h, tiny_stl::forward<Value>(val));
+        ++num_elements;
 
-        return make_pair(iterator(idx, pos, this), true);
+        return tiny_stl::make_pair(
+            iterator(idx, local_iterator(buckets[idx]), this), true);
     }
 
 protected:
@@ -458,7 +802,7 @@ protected:
 
     size_type count_equal(const key_type& key) const {
         auto range = equal_range(key);
-        return distance(range.first, range.second);
+        return tiny_stl::distance(range.first, range.second);
     }
 
     size_type count_unique(const key_type& key) const {
@@ -469,19 +813,19 @@ protected:
 public:
     iterator erase(const_iterator pos) {
         assert(pos != cend());
-        --num_elements;
 
-        size_type idx = getNthBucket(*pos);
-        auto prev = buckets[idx].cbefore_begin(); // pos prev
-        auto next = prev;
-        // find pos prev
-        for (++next; next != pos.iter; ++next, ++prev) {
-            // do nothing
-        }
+        size_type idx = pos.idx_bucket;
+        NodePtr* prev = &bucketHead(idx); // the link to pos
+        while (*prev != pos.iter.ptr)
+            prev = &(*prev)->next;
 
-        auto iter = buckets[idx].erase_after(prev); // erase pos
+        NodePtr node = *prev;
+        *prev = node->next; // unlink pos
+        freeNode(node);
+        --num_elements;
 
-        updateNextIter(iter, idx);
+        local_iterator iter(*prev);
+        idx = updateNextIter(iter, idx);
 
         return iterator(idx, iter, this);
     }
@@ -495,13 +839,13 @@ public:
         while (first != last)
             erase(first++);
 
-        return iterator(first.idx_bucket,
-                        buckets[first.idx_bucket].makeIter(first.iter), this);
+        return iterator(first.idx_bucket, local_iterator(first.iter.ptr),
+                        this);
     }
 
     size_type erase(const key_type& key) {
         auto range = static_cast<const Self*>(this)->equal_range(key);
-        size_type num = distance(range.first, range.second);
+        size_type num = tiny_stl::distance(range.first, range.second);
 
         erase(range.first, range.second);
 
@@ -512,91 +856,72 @@ public:
         swapADL(hashfunc, rhs.hashfunc);
         swapADL(key_equ, rhs.key_equ);
         swapADL(maxfactor, rhs.maxfactor);
+        swapADL(incremental, rhs.incremental);
         swapADL(num_elements, rhs.num_elements);
+        swapADL(migrate_pos, rhs.migrate_pos);
+        swapAlloc(alnode, rhs.alnode);
         buckets.swap(rhs.buckets);
+        old_buckets.swap(rhs.old_buckets);
     }
 
 public:
     iterator find(const key_type& key) {
-        size_type idx = getNthBucketK(key);
-        for (auto pos = begin(idx); pos != end(idx); ++pos) {
-            if (key_equ(get_key(*pos), key))
-                return iterator(idx, pos, this);
-        }
+        NodePtr node;
+        size_type idx = findNode(key, hashfunc(key), node);
+        if (node == nullptr)
+            return end();
 
-        return end();
+        return iterator(idx, local_iterator(node), this);
     }
 
     const_iterator find(const key_type& key) const {
-        size_type idx = getNthBucketK(key);
-        for (auto pos = begin(idx); pos != end(idx); ++pos) {
-            if (key_equ(*pos, key))
-                return const_iterator(idx, pos, this);
-        }
+        NodePtr node;
+        size_type idx = findNode(key, hashfunc(key), node);
+        if (node == nullptr)
+            return end();
 
-        return end();
+        return const_iterator(idx, const_local_iterator(node), this);
     }
 
     pair<iterator, iterator> equal_range(const key_type& key) {
-        size_type idx = getNthBucketK(key);
-
-        auto first = begin(idx);
-        for (; first != end(idx); ++first) {
-            if (key_equ(*first, key)) // find first
-                break;
-        }
-
-        if (first == end(idx))
-            return make_pair(end(), end());
-
-        auto last = first;
-
-        for (++last; last != end(idx); ++last) {
-            if (!key_equ(*last, key)) // find last
-                break;
-        }
+        const size_t h = hashfunc(key);
+        NodePtr first;
+        size_type idx = findNode(key, h, first);
+        if (first == nullptr)
+            return tiny_stl::make_pair(end(), end());
 
+        local_iterator last(lastEqual(key, h, first));
         size_type lastIdx = updateNextIter(last, idx);
 
-        return make_pair(iterator(idx, first, this),
-                         iterator(lastIdx, last, this));
+        return tiny_stl::make_pair(iterator(idx, local_iterator(first), this),
+                                   iterator(lastIdx, last, this));
     }
 
     pair<const_iterator, const_iterator>
     equal_range(const key_type& key) const {
-        size_type idx = getNthBucketK(key);
-
-        auto first = begin(idx);
-        for (; first != end(idx); ++first) {
-            if (key_equ(*first, key)) // find first
-                break;
-        }
-
-        if (first == end(idx))
-            return make_pair(end(), end());
-
-        auto last = first;
-
-        for (++last; last != end(idx); ++last) {
-            if (!key_equ(*last, key)) // find last
-                break;
-        }
+        const size_t h = hashfunc(key);
+        NodePtr first;
+        size_type idx = findNode(key, h, first);
+        if (first == nullptr)
+            return tiny_stl::make_pair(end(), end());
 
+        const_local_iterator last(lastEqual(key, h, first));
         size_type lastIdx = updateNextIter(last, idx);
 
-        return make_pair(const_iterator(idx, first, this),
-                         const_iterator(lastIdx, last, this));
+        return tiny_stl::make_pair(
+            const_iterator(idx, const_local_iterator(first), this),
+            const_iterator(lastIdx, last, this));
     }
 
 public:
     local_iterator begin(size_type n) {
-        assert(n < buckets.size());
-        return buckets[n].begin();
+        assert(n < bucket_count());
+        return local_iterator(bucketHead(n));
     }
 
     const_local_iterator begin(size_type n) const {
-        assert(n < buckets.size());
-        return buckets[n].begin();
+        assert(n < bucket_count());
+        return const_local_iterator(bucketHead(n));
     }
 
     const_local_iterator cbegin(size_type n) const {
@@ -604,25 +929,26 @@ public:
     }
 
     local_iterator end(size_type n) {
-        assert(n < buckets.size());
-        return buckets[n].end();
+        assert(n < bucket_count());
+        return local_iterator();
     }
 
     const_local_iterator end(size_type n) const {
-        assert(n < buckets.size());
-        return buckets[n].end();
+        assert(n < bucket_count());
+        return const_local_iterator();
     }
 
     const_local_iterator cend(size_type n) const {
         return end(n);
     }
 
+    // the old buckets are counted during incremental rehash
     size_type bucket_count() const noexcept {
-        return buckets.size();
+        return buckets.size() + old_buckets.size();
     }
 
     size_type max_bucket_count() const noexcept {
-        return stlPrimesArray[stlPrimesSize - 1] >> 2;
+        return BucketPolicy::max_size() >> 2;
     }
 
     size_type bucket_size(size_type n) const {
@@ -634,11 +960,11 @@ public:
 
     size_type bucket(const key_type& key) const {
         assert(bucket_count() != 0);
-        return getNthBucketK(key);
+        return bucketOfHash(hashfunc(key));
     }
 
     float load_factor() const {
-        return static_cast<float>(size()) / static_cast<float>(bucket_count());
+        return static_cast<float>(size()) / static_cast<float>(buckets.size());
     }
 
     float max_load_factor() const {
@@ -650,19 +976,57 @@ public:
             maxfactor = mlf;
     }
 
+    // relink the nodes into the new buckets, no element is copied
     void rehash(size_type n) {
         if (n <= size() / max_load_factor())
             return;
-        HashTable tmp(stlNextPrime(n));
-        for (const auto& val : *this)
-            tmp.insert_equal(val);
-        this->swap(tmp);
+        rehashAux(BucketPolicy::next_size(n));
     }
 
     void reserve(size_type n) {
         rehash(std::ceil(n / max_load_factor()));
     }
 
+    // spread the migration of growing over the following insertions,
+    // so that no single insertion relinks all the elements
+    void incremental_rehash(bool on) {
+        incremental = on;
+        if (!on)
+            finishRehash();
+    }
+
+    bool incremental_rehash() const noexcept {
+        return incremental;
+    }
+
+    bool rehashing() const noexcept {
+        return !old_buckets.empty();
+    }
+
+    // the chains are walked, a histogram with many long chains points to
+    // a weak hash function
+    hash_stats stats() const {
+        hash_stats s{};
+        s.size = size();
+        s.bucket_count = bucket_count();
+        s.load_factor = buckets.empty() ? 0.0f : load_factor();
+        for (size_type i = 0; i < s.bucket_count; ++i) {
+            size_type len = 0;
+            for (NodePtr p = bucketHead(i); p != nullptr; p = p->next)
+                ++len;
+
+            ++s.chains[tiny_stl::min<size_t>(len, kHashStatsChainBins - 1)];
+            s.longest_chain = tiny_stl::max<size_t>(s.longest_chain, len);
+        }
+        s.empty_buckets = s.chains[0];
+#ifdef TINY_STL_STATS
+        s.rehashes = rehash_count;
+        s.rehash_ns = rehash_ns;
+#endif
+
+        return s;
+    }
+
     hasher hash_function() const {
         return hashfunc;
     }
@@ -673,25 +1037,36 @@ public:
 }; // HashTable
 
 template <typename T, typename Hash, typename KeyEqual, typename Alloc,
-          bool isMap>
-inline bool operator==(const HashTable<T, Hash, KeyEqual, Alloc, isMap>& lhs,
-                       const HashTable<T, Hash, KeyEqual, Alloc, isMap>& rhs) {
+          bool isMap, typename BucketPolicy>
+inline bool operator==(
+    const HashTable<T, Hash, KeyEqual, Alloc, isMap, BucketPolicy>& lhs,
+    const HashTable<T, Hash, KeyEqual, Alloc, isMap, BucketPolicy>& rhs) {
     return lhs.size() == rhs.size() &&
            equal(lhs.begin(), lhs.end(), rhs.begin());
 }
 
 template <typename T, typename Hash, typename KeyEqual, typename Alloc,
-          bool isMap>
-inline bool operator!=(const HashTable<T, Hash, KeyEqual, Alloc, isMap>& lhs,
-                       const HashTable<T, Hash, KeyEqual, Alloc, isMap>& rhs) {
+          bool isMap, typename BucketPolicy>
+inline bool operator!=(
+    const HashTable<T, Hash, KeyEqual, Alloc, isMap, BucketPolicy>& lhs,
+    const HashTable<T, Hash, KeyEqual, Alloc, isMap, BucketPolicy>& rhs) {
     return !(lhs == rhs);
 }
 
 template <typename T, typename Hash, typename KeyEqual, typename Alloc,
-          bool isMap>
-inline bool operator==(HashTable<T, Hash, KeyEqual, Alloc, isMap>& lhs,
-                       HashTable<T, Hash, KeyEqual, Alloc, isMap>& rhs) {
+          bool isMap, typename BucketPolicy>
+inline bool
+operator==(HashTable<T, Hash, KeyEqual, Alloc, isMap, BucketPolicy>& lhs,
+           HashTable<T, Hash, KeyEqual, Alloc, isMap, BucketPolicy>& rhs) {
     return lhs.swap(rhs);
 }
 
+// engine policy of unordered_map/unordered_set, a forward_list per bucket
+template <typename BucketPolicy = prime_bucket_policy>
+struct chained_hashing {
+    template <typename T, typename Hash, typename KeyEqual, typename Alloc,
+              bool isMap>
+    using table = HashTable<T, Hash, KeyEqual, Alloc, isMap, BucketPolicy>;
+};
+
 } // namespace tiny_stl
@@ -131,6 +131,21 @@ inline typename iterator_traits<Iter>::value_type* value_type(const Iter&) {
 template <typename Iter>
 using IteratorValueType = typename iterator_traits<Iter>::value_type;
 
+// an iterator over contiguous storage, address() is the pointer to the
+// element it points to, also for an end iterator. The containers with
+// contiguous storage specialize it for their iterators.
+template <typename Iter>
+struct ContiguousIterator : false_type {};
+
+template <typename T>
+struct ContiguousIterator<T*> : true_type {
+    using element_type = T;
+
+    static constexpr T* address(T* p) noexcept {
+        return p;
+    }
+};
+
 namespace {
 
 template <typename Iter>
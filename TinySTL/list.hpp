@@ -6,6 +6,7 @@
 
 #include <initializer_list>
 
+#include "list_sort.hpp"
 #include "memory.hpp"
 
 namespace tiny_stl {
@@ -865,40 +866,15 @@ public:
     }
 
 private:
-    template <typename Cmp>
-    iterator sortAux(iterator first, iterator last, Cmp& cmp, size_type size) {
-        if (size < 2)
-            return first;
-
-        size_type mid_size = size >> 1;
-
-        iterator mid = first;
-        tiny_stl::advance(mid, mid_size);
-
-        first = sortAux(first, mid, cmp, mid_size);
-        mid = sortAux(mid, last, cmp, size - mid_size);
-        iterator ret = first; // return iter of min *iter
-
-        bool is_once = true;
-
-        while (true) {
-            if (cmp(*mid, *first)) { // *mid < *first
-                if (is_once)
-                    ret = mid;
-                iterator next = mid;
-                ++next;
-                this->transfer(first, mid, next);
-                mid = next;
-                if (mid == last)
-                    return ret;
-            } else { // *mid >= *first
-                ++first;
-                if (first == mid)
-                    return ret;
-            }
-
-            is_once = false;
+    // a sort threw: link prev along the chain from head->next, close the ring
+    void relinkPrev() noexcept {
+        NodePtr prev = this->head;
+        for (NodePtr p = this->head->next; p != nullptr; p = p->next) {
+            p->prev = prev;
+            prev = p;
         }
+        prev->next = this->head;
+        this->head->prev = prev;
     }
 
 public:
@@ -906,9 +882,24 @@ public:
         sort(tiny_stl::less<>{});
     }
 
+    // bottom-up merge sort of natural runs, see list_sort.hpp
     template <typename Cmp>
     void sort(Cmp cmp) {
-        sortAux(begin(), end(), cmp, Base::count);
+        if (Base::count < 2)
+            return;
+
+        // the nodes as a chain by next, then back into the ring
+        this->head->prev->next = nullptr;
+        NodePtr last;
+        try {
+            last = listSortChain(this->head->next, cmp, true_type{});
+        } catch (...) {
+            relinkPrev();
+            throw;
+        }
+        this->head->next->prev = this->head;
+        last->next = this->head;
+        this->head->prev = last;
     }
 
 private:
@@ -955,4 +946,11 @@ inline void swap(list<T, Alloc>& lhs,
     lhs.swap(rhs);
 }
 
+namespace pmr {
+
+template <typename T>
+using list = tiny_stl::list<T, polymorphic_allocator<T>>;
+
+} // namespace pmr
+
 } // namespace tiny_stl
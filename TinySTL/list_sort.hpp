@@ -0,0 +1,200 @@
+// Copyright (C) 2021 syn1w
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <cstddef>
+
+#include "type_traits.hpp"
+
+namespace tiny_stl {
+
+// Bottom-up merge sort of a node chain, for list and forward_list
+//
+// The chain is linked by next and ends with nullptr, node->data is the
+// value. It is cut into natural runs: a non-descending run is taken as
+// it is, a strictly descending one is reversed, so a sorted or reversed
+// chain is one run and sorts in n - 1 compares. The runs go through 64
+// bins like a binary counter (SGI's list::sort): bin i holds the merge of
+// 2^i runs, a new run is merged into bins 0, 1, ... until an empty one.
+//
+// A merge relinks next pointers and never walks a chain again. With
+// HasPrev (list) it also sets prev of each node it links, the node is in
+// cache then, so every node but the first of a chain has the right prev
+// and a run keeps its last node at hand: the caller only closes the ring.
+//
+// Equal values keep their order. If cmp throws, the chain still holds
+// every node, in an unspecified order, and prev must be fixed by a walk.
+
+namespace {
+
+constexpr size_t kListSortBins = 64;
+
+template <typename NodePtr>
+struct ListSortRun {
+    NodePtr first = nullptr;
+    NodePtr last = nullptr;
+};
+
+template <typename NodePtr>
+inline void listSortLinkPrev(NodePtr node, NodePtr prev, true_type) noexcept {
+    node->prev = prev;
+}
+
+template <typename NodePtr>
+inline void listSortLinkPrev(NodePtr, NodePtr, false_type) noexcept {
+}
+
+// link src after the last node of dst, only on the throw path
+template <typename NodePtr>
+void listSortAppend(NodePtr& dst, NodePtr src) noexcept {
+    if (dst == nullptr) {
+        dst = src;
+        return;
+    }
+
+    NodePtr last = dst;
+    while (last->next != nullptr)
+        last = last->next;
+    last->next = src;
+}
+
+// cut the first run off chain
+template <typename NodePtr, typename Cmp, typename HasPrev>
+ListSortRun<NodePtr> listSortTakeRun(NodePtr& chain, Cmp& cmp, HasPrev) {
+    ListSortRun<NodePtr> run;
+    run.first = run.last = chain;
+    NodePtr next = chain->next;
+    if (next == nullptr) {
+        chain = nullptr;
+        return run;
+    }
+
+    if (!cmp(next->data, run.first->data)) {
+        // prev is right already, chain stays whole until the cut
+        while (next != nullptr && !cmp(next->data, run.last->data)) {
+            run.last = next;
+            next = next->next;
+        }
+        run.last->next = nullptr;
+        chain = next;
+        return run;
+    }
+
+    // strictly descending, reversed while it is read
+    run.first->next = nullptr;
+    try {
+        while (next != nullptr && cmp(next->data, run.first->data)) {
+            NodePtr after = next->next;
+            next->next = run.first;
+            listSortLinkPrev(run.first, next, HasPrev{});
+            run.first = next;
+            next = after;
+        }
+    } catch (...) {
+        run.last->next = next;
+        chain = run.first;
+        throw;
+    }
+    chain = next;
+    return run;
+}
+
+// merge b into a, values of a go first on a tie, if cmp throws a.first
+// holds the nodes of both
+template <typename NodePtr, typename Cmp, typename HasPrev>
+void listSortMerge(ListSortRun<NodePtr>& a, ListSortRun<NodePtr> b,
+                   Cmp& cmp, HasPrev) {
+    NodePtr x = a.first;
+    NodePtr y = b.first;
+    NodePtr head = nullptr;
+    NodePtr prev = nullptr;
+    NodePtr* tail = &head;
+    try {
+        while (x != nullptr && y != nullptr) {
+            if (cmp(y->data, x->data)) {
+                *tail = y;
+                listSortLinkPrev(y, prev, HasPrev{});
+                prev = y;
+                tail = &y->next;
+                y = y->next;
+            } else {
+                *tail = x;
+                listSortLinkPrev(x, prev, HasPrev{});
+                prev = x;
+                tail = &x->next;
+                x = x->next;
+            }
+        }
+    } catch (...) {
+        *tail = x;
+        listSortAppend(head, y);
+        a.first = head;
+        throw;
+    }
+
+    if (x != nullptr) {
+        *tail = x;
+        listSortLinkPrev(x, prev, HasPrev{});
+    } else if (y != nullptr) {
+        *tail = y;
+        listSortLinkPrev(y, prev, HasPrev{});
+        a.last = b.last;
+    }
+    a.first = head;
+}
+
+// sort chain, return its last node
+template <typename NodePtr, typename Cmp, typename HasPrev>
+NodePtr listSortChain(NodePtr& chain, Cmp& cmp, HasPrev) {
+    ListSortRun<NodePtr> bins[kListSortBins];
+    size_t filled = 0;
+    ListSortRun<NodePtr> run;
+
+    try {
+        while (chain != nullptr) {
+            run = listSortTakeRun(chain, cmp, HasPrev{});
+
+            // the bins hold earlier values than run
+            size_t i = 0;
+            for (; i < filled && bins[i].first != nullptr; ++i) {
+                ListSortRun<NodePtr> later = run;
+                run = ListSortRun<NodePtr>{};
+                listSortMerge(bins[i], later, cmp, HasPrev{});
+                run = bins[i];
+                bins[i] = ListSortRun<NodePtr>{};
+            }
+
+            if (i == kListSortBins)
+                --i; // more than 2^64 nodes
+            bins[i] = run;
+            run = ListSortRun<NodePtr>{};
+            if (i == filled)
+                ++filled;
+        }
+
+        // a higher bin holds earlier values
+        for (size_t i = 0; i < filled; ++i) {
+            if (bins[i].first != nullptr) {
+                ListSortRun<NodePtr> later = run;
+                run = ListSortRun<NodePtr>{};
+                listSortMerge(bins[i], later, cmp, HasPrev{});
+                run = bins[i];
+                bins[i] = ListSortRun<NodePtr>{};
+            }
+        }
+    } catch (...) {
+        listSortAppend(chain, run.first);
+        for (size_t i = 0; i < filled; ++i)
+            listSortAppend(chain, bins[i].first);
+        throw;
+    }
+
+    chain = run.first;
+    return run.last;
+}
+
+} // namespace
+
+} // namespace tiny_stl
@@ -70,6 +70,14 @@ public:
         this->insert_unique(first, last);
     }
 
+    // O(n), [first, last) is sorted without equal keys
+    template <typename InIter>
+    map(sorted_unique_t, InIter first, InIter last,
+        const Compare& cmp = Compare(), const Alloc& alloc = Alloc())
+        : Base(cmp, alloc) {
+        this->insert_sorted_unique(first, last);
+    }
+
     map(const map& rhs)
         : Base(rhs, AlTraits::select_on_container_copy_construction(
                         rhs.get_allocator())) {
@@ -129,7 +137,7 @@ public:
     T& operator[](const Key& key) {
         iterator pos = this->find(key);
         if (pos == this->end())
-            return this->insert(make_pair(key, T{})).first->second;
+            return this->insert(tiny_stl::make_pair(key, T{})).first->second;
 
         return pos->second;
     }
@@ -137,7 +145,7 @@ public:
     T& operator[](Key&& key) {
         iterator pos = this->find(key);
         if (pos == this->end())
-            return this->insert(make_pair(tiny_stl::move(key), T{}))
+            return this->insert(tiny_stl::make_pair(tiny_stl::move(key), T{}))
                 .first->second;
 
         return pos->second;
@@ -157,6 +165,15 @@ public:
         return this->insert_unique(tiny_stl::move(val));
     }
 
+    // O(1) if val goes right before or after hint
+    iterator insert(const_iterator hint, const value_type& val) {
+        return this->insert_unique(hint, val);
+    }
+
+    iterator insert(const_iterator hint, value_type&& val) {
+        return this->insert_unique(hint, tiny_stl::move(val));
+    }
+
     template <typename InIter>
     void insert(InIter first, InIter last) {
         this->insert_unique(first, last);
@@ -171,6 +188,12 @@ public:
         return this->emplace_unique(tiny_stl::forward<Args>(args)...);
     }
 
+    template <typename... Args>
+    iterator emplace_hint(const_iterator hint, Args&&... args) {
+        return this->emplace_hint_unique(hint,
+                                         tiny_stl::forward<Args>(args)...);
+    }
+
     void swap(map& rhs) {
         Base::swap(rhs);
     }
@@ -258,6 +281,14 @@ public:
         this->insert_equal(first, last);
     }
 
+    // O(n), [first, last) is sorted
+    template <typename InIter>
+    multimap(sorted_equivalent_t, InIter first, InIter last,
+             const Compare& cmp = Compare(), const Alloc& alloc = Alloc())
+        : Base(cmp, alloc) {
+        this->insert_sorted_equal(first, last);
+    }
+
     multimap(const multimap& rhs)
         : Base(rhs, AlTraits::select_on_container_copy_construction(
                         rhs.get_allocator())) {
@@ -299,20 +330,29 @@ public:
         return *this;
     }
 
-    pair<iterator, bool> insert(const value_type& val) {
+    iterator insert(const value_type& val) {
         return this->insert_equal(val);
     }
 
     template <typename P,
               typename = enable_if_t<is_constructible<value_type, P&&>::value>>
-    pair<iterator, bool> insert(P&& val) {
+    iterator insert(P&& val) {
         return this->insert_equal(tiny_stl::forward<P>(val));
     }
 
-    pair<iterator, bool> insert(value_type&& val) {
+    iterator insert(value_type&& val) {
         return this->insert_equal(tiny_stl::move(val));
     }
 
+    // O(1) if val goes right before hint
+    iterator insert(const_iterator hint, const value_type& val) {
+        return this->insert_equal(hint, val);
+    }
+
+    iterator insert(const_iterator hint, value_type&& val) {
+        return this->insert_equal(hint, tiny_stl::move(val));
+    }
+
     template <typename InIter>
     void insert(InIter first, InIter last) {
         this->insert_equal(first, last);
@@ -323,10 +363,16 @@ public:
     }
 
     template <typename... Args>
-    pair<iterator, bool> emplace(Args&&... args) {
+    iterator emplace(Args&&... args) {
         return this->emplace_equal(tiny_stl::forward<Args>(args)...);
     }
 
+    template <typename... Args>
+    iterator emplace_hint(const_iterator hint, Args&&... args) {
+        return this->emplace_hint_equal(hint,
+                                        tiny_stl::forward<Args>(args)...);
+    }
+
     void swap(multimap& rhs) {
         Base::swap(rhs);
     }
@@ -352,4 +398,15 @@ swap(multimap<Key, T, Cmp, Alloc>& lhs,
     lhs.swap(rhs);
 }
 
+namespace pmr {
+
+template <typename Key, typename T, typename Compare = less<Key>>
+using map = tiny_stl::map<Key, T, Compare, polymorphic_allocator<pair<Key, T>>>;
+
+template <typename Key, typename T, typename Compare = less<Key>>
+using multimap =
+    tiny_stl::multimap<Key, T, Compare, polymorphic_allocator<pair<Key, T>>>;
+
+} // namespace pmr
+
 } // namespace tiny_stl
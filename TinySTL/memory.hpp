@@ -19,6 +19,9 @@ namespace tiny_stl {
 
 namespace {
 
+// data written by different threads is kept this far apart
+constexpr size_t kCacheLineSize = 64;
+
 template <typename T, typename... Args>
 inline void constructInPlace(T& dst, Args&&... args) noexcept(
     (is_nothrow_constructible<T, Args...>::value)) {
@@ -43,11 +46,8 @@ inline FwdIt uninitializedCopyAux(InIt first, InIt last, FwdIt dst,
 
 template <typename InIt, typename FwdIt>
 inline FwdIt uninitializedCopyAux(InIt first, InIt last, FwdIt dst,
-                                  true_type /* is pod -- assign */) {
-    for (; first != last; ++first, ++dst)
-        *dst = *first;
-
-    return dst;
+                                  true_type /* memmove */) {
+    return memmoveN(first, last - first, dst);
 }
 
 template <typename InIt, typename Size, typename FwdIt>
@@ -61,16 +61,13 @@ inline FwdIt uninitializedCopyNAux(InIt first, Size n, FwdIt dst,
 
 template <typename InIt, typename Size, typename FwdIt>
 inline FwdIt uninitializedCopyNAux(InIt first, Size n, FwdIt dst,
-                                   true_type /* is pod -- assign */) {
-    for (; n > 0; ++first, ++dst, --n)
-        *dst = *first;
-
-    return dst;
+                                   true_type /* memmove */) {
+    return memmoveN(first, n, dst);
 }
 
 template <typename FwdIt, typename T>
 inline void uninitializedFillAux(FwdIt first, FwdIt last, const T& x,
-                                 false_type /* is not pod type */) {
+                                 false_type /* no special optimization */) {
 
     for (; first != last; ++first)
         constructInPlace(*first, x);
@@ -78,14 +75,13 @@ inline void uninitializedFillAux(FwdIt first, FwdIt last, const T& x,
 
 template <typename FwdIt, typename T>
 inline void uninitializedFillAux(FwdIt first, FwdIt last, const T& x,
-                                 true_type /* is pod -- assign */) {
-    for (; first != last; ++first)
-        *first = x;
+                                 true_type /* trivial -- assign */) {
+    tiny_stl::fill(first, last, x);
 }
 
 template <typename FwdIt, typename Size, typename T>
 inline void uninitializedFillNAux(FwdIt first, Size n, const T& x,
-                                  false_type /* is not pod type */) {
+                                  false_type /* no special optimization */) {
 
     for (; n--; ++first)
         constructInPlace(*first, x);
@@ -93,62 +89,44 @@ inline void uninitializedFillNAux(FwdIt first, Size n, const T& x,
 
 template <typename FwdIt, typename Size, typename T>
 inline void uninitializedFillNAux(FwdIt first, Size n, const T& x,
-                                  true_type /* is pod -- copy */) {
-    for (; n--; ++first)
-        *first = x;
+                                  true_type /* trivial -- assign */) {
+    tiny_stl::fill_n(first, n, x);
 }
 
+// constructing the value type from const T& is the same as assigning
+// it, fill can then use memset
+template <typename FwdIt, typename T>
+using UninitializedFillIsAssign = typename conjunction<
+    is_trivial<IteratorValueType<FwdIt>>,
+    is_trivially_assignable<IteratorValueType<FwdIt>&, const T&>>::type;
+
 } // namespace
 
+// memmove for contiguous ranges of trivially copyable types
 template <typename InIter, typename FwdIter>
 inline FwdIter uninitialized_copy(InIter first, InIter last, FwdIter dst) {
-    using T = typename iterator_traits<InIter>::value_type;
-    return uninitializedCopyAux(first, last, dst,
-                                bool_constant<is_pod<T>::value>{});
-}
-
-// const char* and const wchar_t* version
-inline char* uninitialized_copy(const char* first, const char* last,
-                                char* dst) {
-    memmove(dst, first, sizeof(char) * (last - first));
-    return dst + (last - first);
-}
-
-inline wchar_t* uninitialized_copy(const wchar_t* first, const wchar_t* last,
-                                   wchar_t* dst) {
-    memmove(dst, first, sizeof(wchar_t) * (last - first));
-    return dst + (last - first);
+    return uninitializedCopyAux(
+        first, last, dst,
+        MemmoveIsSafe<InIter, FwdIter, TrivialCopyConstruct>{});
 }
 
 template <typename InIter, typename Size, typename FwdIter>
 inline FwdIter uninitialized_copy_n(InIter first, Size n, FwdIter dst) {
-    using T = typename iterator_traits<InIter>::value_type;
-    return uninitializedCopyNAux(first, n, dst,
-                                 integral_constant<bool, is_pod_v<T>>{});
-}
-
-inline char* uninitialized_copy_n(const char* first, size_t n, char* dst) {
-    memmove(dst, first, n);
-    return dst + n;
-}
-
-inline wchar_t* uninitialized_copy_n(const wchar_t* first, size_t n,
-                                     wchar_t* dst) {
-    memmove(dst, first, n * sizeof(wchar_t));
-    return dst + n;
+    return uninitializedCopyNAux(
+        first, n, dst, MemmoveIsSafe<InIter, FwdIter, TrivialCopyConstruct>{});
 }
 
 // use x to construct [first, last)
 template <typename FwdIter, typename T>
 inline void uninitialized_fill(FwdIter first, FwdIter last, const T& x) {
     uninitializedFillAux(first, last, x,
-                         integral_constant<bool, is_pod_v<T>>{});
+                         UninitializedFillIsAssign<FwdIter, T>{});
 }
 
 // use x to construct [first, first + n)
 template <typename FwdIter, typename Size, typename T>
 inline void uninitialized_fill_n(FwdIter first, Size n, const T& x) {
-    uninitializedFillNAux(first, n, x, integral_constant<bool, is_pod_v<T>>{});
+    uninitializedFillNAux(first, n, x, UninitializedFillIsAssign<FwdIter, T>{});
 }
 
 // use allocator to copy/fill
@@ -235,7 +213,7 @@ template <typename FwdIter, typename Size, typename Alloc>
 inline FwdIter
 uninitAllocFillNAux(FwdIter first, Size n,
                     const typename iterator_traits<FwdIter>::value_type& val,
-                    Alloc& alloc, false_type /* fill memset is not safe */) {
+                    Alloc& alloc, false_type /* fill is not assign */) {
 
     for (; n > 0; --n, ++first)
         alloc.construct(tiny_stl::addressof(*first), val);
@@ -247,21 +225,20 @@ template <typename FwdIter, typename Size, typename Alloc>
 inline FwdIter
 uninitAllocFillNAux(FwdIter first, Size n,
                     const typename iterator_traits<FwdIter>::value_type& val,
-                    Alloc&, true_type /* fill memset is safe */) {
-    ::memset(first, val, n);
-    return first + n;
+                    Alloc&, true_type /* fill is assign */) {
+    return tiny_stl::fill_n(first, n, val);
 }
 
 template <typename FwdIter, typename Size, typename Alloc>
 inline FwdIter uninitializedAllocFillN(
     FwdIter first, Size n,
     const typename iterator_traits<FwdIter>::value_type& val, Alloc& alloc) {
-    // if memset safe && (default allocator || not user allocator)
-    // then use memset
+    // if fill is assign && (default allocator || not user allocator)
+    // then use fill_n, it is a memset for bytes or a zero value
     return uninitAllocFillNAux(
         first, n, val, alloc,
         typename conjunction<
-            decltype(tiny_stl::fillMemsetIsSafe(first, val)),
+            UninitializedFillIsAssign<FwdIter, decltype(val)>,
             UseDefaultConstruct<Alloc, decltype(tiny_stl::addressof(*first)),
                                 decltype(val)>>::type{});
 }
@@ -289,7 +266,9 @@ inline FwdIter uninitAllocDefaultNAux(FwdIter first, Size n, Alloc&,
 template <typename FwdIter, typename Size, typename Alloc>
 inline FwdIter uninitAllocDefaultNAux(FwdIter first, Size n, Alloc& alloc,
                                       false_type) {
-    alloc.construct(tiny_stl::addressof(*first));
+    for (; n > 0; --n, ++first)
+        alloc.construct(tiny_stl::addressof(*first));
+
     return first;
 }
 
@@ -306,11 +285,8 @@ inline FwdIter uninitializedAllocDefaultN(FwdIter first, Size n, Alloc& alloc) {
 template <typename InIter, typename FwdIter, typename Alloc>
 inline FwdIter uninitializedAllocCopyAux(InIter first, InIter last,
                                          FwdIter newFirst, Alloc&,
-                                         true_type /*pod*/) {
-    for (; first != last; ++first, ++newFirst)
-        *newFirst = *first;
-
-    return newFirst;
+                                         true_type /* memmove */) {
+    return memmoveN(first, last - first, newFirst);
 }
 
 template <typename InIter, typename FwdIter, typename Alloc>
@@ -319,23 +295,41 @@ inline FwdIter uninitializedAllocCopyAux(InIter first, InIter last,
                                          false_type) {
 
     for (; first != last; ++first, ++newFirst)
-        alloc.construct(newFirst, *first);
+        allocator_traits<Alloc>::construct(
+            alloc, tiny_stl::addressof(*newFirst), *first);
 
     return newFirst;
 }
 
+// memmove if the allocator constructs nothing itself
+template <typename InIter, typename FwdIter, typename Alloc,
+          template <typename, typename> class Trivial, typename... Args>
+using UseAllocMemmove = typename conjunction<
+    MemmoveIsSafe<InIter, FwdIter, Trivial>,
+    UseDefaultConstruct<Alloc, decltype(tiny_stl::addressof(
+                                   *tiny_stl::declval<FwdIter&>())),
+                        Args...>>::type;
+
 template <typename InIter, typename FwdIter, typename Alloc>
 inline FwdIter uninitializedAllocCopy(InIter first, InIter last,
                                       FwdIter newFirst, Alloc& alloc) {
-    using T = typename iterator_traits<InIter>::value_type;
-    return uninitializedAllocCopyAux(first, last, newFirst, alloc,
-                                     bool_constant<is_pod<T>::value>{});
+    return uninitializedAllocCopyAux(
+        first, last, newFirst, alloc,
+        UseAllocMemmove<InIter, FwdIter, Alloc, TrivialCopyConstruct,
+                        decltype(*first)>{});
 }
 
 template <typename InIter, typename FwdIter, typename Alloc>
-inline FwdIter uninitializedAllocMove(InIter first, InIter last,
-                                      FwdIter newFirst, Alloc& alloc) {
+inline FwdIter uninitializedAllocMoveAux(InIter first, InIter last,
+                                         FwdIter newFirst, Alloc&,
+                                         true_type /* memmove */) {
+    return memmoveN(first, last - first, newFirst);
+}
 
+template <typename InIter, typename FwdIter, typename Alloc>
+inline FwdIter uninitializedAllocMoveAux(InIter first, InIter last,
+                                         FwdIter newFirst, Alloc& alloc,
+                                         false_type) {
     for (; first != last; ++newFirst, ++first) {
         allocator_traits<Alloc>::construct(
             alloc, tiny_stl::addressof(*newFirst), tiny_stl::move(*first));
@@ -344,6 +338,27 @@ inline FwdIter uninitializedAllocMove(InIter first, InIter last,
     return newFirst;
 }
 
+template <typename InIter, typename FwdIter, typename Alloc>
+inline FwdIter uninitializedAllocMove(InIter first, InIter last,
+                                      FwdIter newFirst, Alloc& alloc) {
+    return uninitializedAllocMoveAux(
+        first, last, newFirst, alloc,
+        UseAllocMemmove<InIter, FwdIter, Alloc, TrivialMoveConstruct,
+                        decltype(tiny_stl::move(*first))>{});
+}
+
+// move [first, last) to raw memory at dst and end the old elements by
+// copying bytes, T is trivially relocatable, the ranges may overlap
+template <typename T>
+inline T* uninitializedRelocate(T* first, T* last, T* dst) noexcept {
+    const size_t n = static_cast<size_t>(last - first);
+    if (n != 0)
+        memmove(static_cast<void*>(dst), static_cast<const void*>(first),
+                n * sizeof(T));
+
+    return dst + n;
+}
+
 template <typename T>
 struct GetFirstParameter;
 
@@ -702,6 +717,112 @@ struct uses_allocator : HasAllocatorType<Con, Alloc>::type {};
 template <typename Con, typename Alloc>
 constexpr bool uses_allocator_value = uses_allocator<Con, Alloc>::value;
 
+namespace pmr {
+
+// allocate from a memory_resource, containers of pmr:: aliases store a
+// polymorphic_allocator and pass it to the elements which use allocator
+template <typename T>
+class polymorphic_allocator {
+public:
+    using value_type = T;
+    using pointer = T*;
+    using const_pointer = const T*;
+    using reference = T&;
+    using const_reference = const T&;
+    using size_type = size_t;
+    using difference_type = ptrdiff_t;
+
+private:
+    memory_resource* mResource;
+
+    template <typename Obj, typename... Args>
+    void constructAux(true_type /* use allocator */, Obj* p, Args&&... args) {
+        constructHelper(p, tiny_stl::forward<Args>(args)..., *this);
+    }
+
+    template <typename Obj, typename... Args>
+    void constructAux(false_type, Obj* p, Args&&... args) {
+        constructHelper(p, tiny_stl::forward<Args>(args)...);
+    }
+
+public:
+    polymorphic_allocator() noexcept : mResource(get_default_resource()) {
+    }
+
+    polymorphic_allocator(memory_resource* r) : mResource(r) {
+        assert(r != nullptr);
+    }
+
+    template <typename Other>
+    polymorphic_allocator(const polymorphic_allocator<Other>& rhs) noexcept
+        : mResource(rhs.resource()) {
+    }
+
+    template <typename U>
+    struct rebind {
+        using other = polymorphic_allocator<U>;
+    };
+
+    pointer allocate(size_type n) {
+        if (n > max_size())
+            throw std::bad_alloc();
+        return static_cast<pointer>(
+            mResource->allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(pointer p, size_type n) noexcept {
+        mResource->deallocate(p, n * sizeof(T), alignof(T));
+    }
+
+    // uses-allocator construction, the allocator is passed as the last
+    // argument of the constructor
+    template <typename Obj, typename... Args>
+    void construct(Obj* p, Args&&... args) {
+        constructAux(
+            bool_constant<
+                uses_allocator<Obj, polymorphic_allocator>::value &&
+                is_constructible<Obj, Args..., const polymorphic_allocator&>::
+                    value>{},
+            p, tiny_stl::forward<Args>(args)...);
+    }
+
+    template <typename Obj>
+    void destroy(Obj* ptr) {
+        destroy_at(ptr);
+    }
+
+    size_type max_size() const noexcept {
+        return (SIZE_MAX / sizeof(T));
+    }
+
+    // a copy of container uses the default resource
+    polymorphic_allocator select_on_container_copy_construction() const {
+        return polymorphic_allocator();
+    }
+
+    memory_resource* resource() const noexcept {
+        return mResource;
+    }
+}; // class polymorphic_allocator<T>
+
+template <typename T, typename U>
+inline bool operator==(const polymorphic_allocator<T>& lhs,
+                       const polymorphic_allocator<U>& rhs) noexcept {
+    return *lhs.resource() == *rhs.resource();
+}
+
+template <typename T, typename U>
+inline bool operator!=(const polymorphic_allocator<T>& lhs,
+                       const polymorphic_allocator<U>& rhs) noexcept {
+    return !(lhs == rhs);
+}
+
+} // namespace pmr
+
+// a pointer to the resource
+template <typename T>
+struct is_trivially_relocatable<pmr::polymorphic_allocator<T>> : true_type {};
+
 template <typename T>
 struct default_delete {
     constexpr default_delete() noexcept = default;
@@ -1053,6 +1174,10 @@ template <typename T, typename... Args,
           typename = enable_if_t<std::extent<T>::value != 0>>
 void make_unique(Args&&...) = delete;
 
+template <typename T, typename D>
+struct is_trivially_relocatable<unique_ptr<T, D>>
+    : is_trivially_relocatable<D>::type {};
+
 template <typename T, typename D>
 struct hash<unique_ptr<T, D>> {
     using argument_type = unique_ptr<T, D>;
@@ -1168,12 +1293,72 @@ inline void swap(unique_ptr<T, D>& lhs, unique_ptr<T, D>& rhs) noexcept {
     lhs.swap(rhs);
 }
 
+namespace extra {
+
+// Reference count policies of RCObject and intrusive_ref_counter
+//
+// atomic_ref_count: copies may live in different threads, an increment is
+//                   relaxed (the new owner already holds a reference) and a
+//                   decrement is acq_rel, so the last owner sees every write
+//                   made before the other owners let go
+// plain_ref_count:  single thread only, no atomic instruction
+class atomic_ref_count {
+private:
+    std::atomic<size_t> count;
+
+public:
+    atomic_ref_count() noexcept : count(0) {
+    }
+
+    void increment() noexcept {
+        count.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // true if it was the last reference, the sole owner skips the atomic
+    // write since nobody else can copy the object
+    bool decrement() noexcept {
+        if (count.load(std::memory_order_acquire) == 1)
+            return true;
+        return count.fetch_sub(1, std::memory_order_acq_rel) == 1;
+    }
+
+    size_t load() const noexcept {
+        return count.load(std::memory_order_acquire);
+    }
+};
+
+class plain_ref_count {
+private:
+    size_t count;
+
+public:
+    plain_ref_count() noexcept : count(0) {
+    }
+
+    void increment() noexcept {
+        ++count;
+    }
+
+    bool decrement() noexcept {
+        return --count == 0;
+    }
+
+    size_t load() const noexcept {
+        return count;
+    }
+};
+
+} // namespace extra
+
 template <typename T>
 class shared_ptr;
 
 template <typename T>
 class weak_ptr;
 
+template <typename T>
+class atomic_shared_ptr;
+
 // reference MSVC implement
 
 // reference count abstract base class
@@ -1254,10 +1439,11 @@ public:
     }
 };
 
-template <typename T>
-class RefCount : public RefCountBase {
+// Base is RefCountBase or LocalRefCountBase
+template <typename T, typename Base = RefCountBase>
+class RefCount : public Base {
 public:
-    explicit RefCount(T* p) : RefCountBase(), mPtr(p) {
+    explicit RefCount(T* p) : Base(), mPtr(p) {
     }
 
 private:
@@ -1488,6 +1674,9 @@ protected:
     template <typename U>
     friend class PtrBase;
 
+    template <typename U>
+    friend class atomic_shared_ptr;
+
 private:
     element_type* mPtr{nullptr};
     RefCountBase* mRep{nullptr};
@@ -1745,12 +1934,14 @@ private:
 
 namespace {
 
-template <typename T>
-class RefCountObj : public RefCountBase {
+// the object lives in the control block, one allocation for both
+template <typename T, typename Base = RefCountBase>
+class RefCountObj : public Base {
 public:
     template <typename... Args>
-    explicit RefCountObj(Args&&... args) noexcept : RefCountBase(), mStroage() {
-        ::new (static_cast<void*>(&mStroage)) T(tiny_stl::forward<T>(args)...);
+    explicit RefCountObj(Args&&... args) : Base(), mStroage() {
+        ::new (static_cast<void*>(&mStroage))
+            T(tiny_stl::forward<Args>(args)...);
     }
 
     T* getPtr() {
@@ -2073,6 +2264,13 @@ void swap(weak_ptr<T>& lhs, weak_ptr<T>& rhs) noexcept {
     lhs.swap(rhs);
 }
 
+// a pointer and a control block pointer
+template <typename T>
+struct is_trivially_relocatable<shared_ptr<T>> : true_type {};
+
+template <typename T>
+struct is_trivially_relocatable<weak_ptr<T>> : true_type {};
+
 template <typename T>
 class enable_shared_from_this {
 public:
@@ -2116,4 +2314,441 @@ private:
     mutable weak_ptr<T> mWptr;
 };
 
+// control block of local_shared_ptr
+// the owners live in one thread, so the use count is a plain integer, and
+// without a weak count the object and the block go away together
+class LocalRefCountBase {
+private:
+    virtual void destroyAux() noexcept = 0;
+    virtual void deleteThis() noexcept = 0;
+
+private:
+    long mUses;
+
+protected:
+    LocalRefCountBase() : mUses(1) {
+    }
+
+public:
+    virtual ~LocalRefCountBase() noexcept {
+    }
+
+    void increaseRef() noexcept {
+        ++mUses;
+    }
+
+    void decreaseRef() noexcept {
+        if (--mUses == 0) {
+            destroyAux();
+            deleteThis();
+        }
+    }
+
+    long useCount() const noexcept {
+        return mUses;
+    }
+};
+
+// local_shared_ptr, shared ownership inside one thread
+// copies never cross threads, no atomic instruction, no weak_ptr and no
+// enable_shared_from_this. make_local_shared puts the object in the
+// control block like make_shared
+template <typename T>
+class local_shared_ptr {
+public:
+    using element_type = T;
+
+    constexpr local_shared_ptr() noexcept {
+    }
+
+    constexpr local_shared_ptr(std::nullptr_t) noexcept {
+    }
+
+    template <typename U, enable_if_t<is_convertible_v<U*, T*>, int> = 0>
+    explicit local_shared_ptr(U* ptr) {
+        try {
+            mRep = new RefCount<U, LocalRefCountBase>(ptr);
+        } catch (...) {
+            delete ptr;
+            throw;
+        }
+        mPtr = ptr;
+    }
+
+    template <typename U>
+    local_shared_ptr(const local_shared_ptr<U>& rhs,
+                     element_type* ptr) noexcept {
+        constructCopy(ptr, rhs.mRep);
+    }
+
+    local_shared_ptr(const local_shared_ptr& rhs) noexcept {
+        constructCopy(rhs.mPtr, rhs.mRep);
+    }
+
+    template <typename U, enable_if_t<is_convertible_v<U*, T*>, int> = 0>
+    local_shared_ptr(const local_shared_ptr<U>& rhs) noexcept {
+        constructCopy(rhs.mPtr, rhs.mRep);
+    }
+
+    local_shared_ptr(local_shared_ptr&& rhs) noexcept
+        : mPtr(rhs.mPtr), mRep(rhs.mRep) {
+        rhs.mPtr = nullptr;
+        rhs.mRep = nullptr;
+    }
+
+    template <typename U, enable_if_t<is_convertible_v<U*, T*>, int> = 0>
+    local_shared_ptr(local_shared_ptr<U>&& rhs) noexcept
+        : mPtr(rhs.mPtr), mRep(rhs.mRep) {
+        rhs.mPtr = nullptr;
+        rhs.mRep = nullptr;
+    }
+
+    ~local_shared_ptr() noexcept {
+        if (mRep) {
+            mRep->decreaseRef();
+        }
+    }
+
+    local_shared_ptr& operator=(const local_shared_ptr& rhs) noexcept {
+        local_shared_ptr{rhs}.swap(*this);
+        return *this;
+    }
+
+    template <typename U>
+    local_shared_ptr& operator=(const local_shared_ptr<U>& rhs) noexcept {
+        local_shared_ptr{rhs}.swap(*this);
+        return *this;
+    }
+
+    local_shared_ptr& operator=(local_shared_ptr&& rhs) noexcept {
+        local_shared_ptr{tiny_stl::move(rhs)}.swap(*this);
+        return *this;
+    }
+
+    template <typename U>
+    local_shared_ptr& operator=(local_shared_ptr<U>&& rhs) noexcept {
+        local_shared_ptr{tiny_stl::move(rhs)}.swap(*this);
+        return *this;
+    }
+
+    void swap(local_shared_ptr& rhs) noexcept {
+        tiny_stl::swap(mPtr, rhs.mPtr);
+        tiny_stl::swap(mRep, rhs.mRep);
+    }
+
+    void reset() noexcept {
+        local_shared_ptr{}.swap(*this);
+    }
+
+    template <typename U>
+    void reset(U* ptr) {
+        local_shared_ptr{ptr}.swap(*this);
+    }
+
+    element_type* get() const noexcept {
+        return mPtr;
+    }
+
+    T& operator*() const noexcept {
+        return *mPtr;
+    }
+
+    T* operator->() const noexcept {
+        return mPtr;
+    }
+
+    long use_count() const noexcept {
+        return mRep ? mRep->useCount() : 0;
+    }
+
+    bool unique() const noexcept {
+        return use_count() == 1;
+    }
+
+    explicit operator bool() const noexcept {
+        return mPtr != nullptr;
+    }
+
+    template <typename U>
+    bool owner_before(const local_shared_ptr<U>& rhs) const noexcept {
+        return mRep < rhs.mRep;
+    }
+
+private:
+    void constructCopy(element_type* ptr, LocalRefCountBase* rep) noexcept {
+        if (rep) {
+            rep->increaseRef();
+        }
+
+        mPtr = ptr;
+        mRep = rep;
+    }
+
+    template <typename U>
+    friend class local_shared_ptr;
+
+    template <typename T0, typename... Args>
+    friend local_shared_ptr<T0> make_local_shared(Args&&... args);
+
+    element_type* mPtr{nullptr};
+    LocalRefCountBase* mRep{nullptr};
+}; // class local_shared_ptr
+
+template <typename T, typename... Args>
+inline local_shared_ptr<T> make_local_shared(Args&&... args) {
+    const auto pRcX = new RefCountObj<T, LocalRefCountBase>(
+        tiny_stl::forward<Args>(args)...);
+
+    local_shared_ptr<T> sp;
+    sp.mPtr = pRcX->getPtr();
+    sp.mRep = pRcX;
+    return sp;
+}
+
+template <typename T, typename U>
+local_shared_ptr<T>
+static_pointer_cast(const local_shared_ptr<U>& sp) noexcept {
+    return local_shared_ptr<T>(sp, static_cast<T*>(sp.get()));
+}
+
+template <typename T1, typename T2>
+bool operator==(const local_shared_ptr<T1>& lhs,
+                const local_shared_ptr<T2>& rhs) noexcept {
+    return lhs.get() == rhs.get();
+}
+
+template <typename T1, typename T2>
+bool operator!=(const local_shared_ptr<T1>& lhs,
+                const local_shared_ptr<T2>& rhs) noexcept {
+    return !(lhs == rhs);
+}
+
+template <typename T1, typename T2>
+bool operator<(const local_shared_ptr<T1>& lhs,
+               const local_shared_ptr<T2>& rhs) noexcept {
+    return lhs.get() < rhs.get();
+}
+
+template <typename T>
+bool operator==(const local_shared_ptr<T>& lhs, std::nullptr_t) noexcept {
+    return lhs.get() == nullptr;
+}
+
+template <typename T>
+bool operator==(std::nullptr_t, const local_shared_ptr<T>& rhs) noexcept {
+    return rhs.get() == nullptr;
+}
+
+template <typename T>
+bool operator!=(const local_shared_ptr<T>& lhs, std::nullptr_t) noexcept {
+    return lhs.get() != nullptr;
+}
+
+template <typename T>
+bool operator!=(std::nullptr_t, const local_shared_ptr<T>& rhs) noexcept {
+    return rhs.get() != nullptr;
+}
+
+template <typename T>
+void swap(local_shared_ptr<T>& lhs, local_shared_ptr<T>& rhs) noexcept {
+    lhs.swap(rhs);
+}
+
+// intrusive_ref_counter, the count lives in the object
+// Derived inherits it and intrusive_ptr<Derived> finds the two functions
+// below by ADL. RefCount is extra::atomic_ref_count or
+// extra::plain_ref_count
+template <typename Derived, typename RefCount = extra::atomic_ref_count>
+class intrusive_ref_counter {
+private:
+    mutable RefCount mCount;
+
+public:
+    size_t use_count() const noexcept {
+        return mCount.load();
+    }
+
+protected:
+    intrusive_ref_counter() noexcept : mCount() {
+    }
+
+    // a copy is a new object, nobody refers to it yet
+    intrusive_ref_counter(const intrusive_ref_counter&) noexcept : mCount() {
+    }
+
+    intrusive_ref_counter& operator=(const intrusive_ref_counter&) noexcept {
+        return *this;
+    }
+
+    ~intrusive_ref_counter() = default;
+
+    friend void intrusive_ptr_add_ref(const intrusive_ref_counter* p) noexcept {
+        p->mCount.increment();
+    }
+
+    friend void intrusive_ptr_release(const intrusive_ref_counter* p) noexcept {
+        if (p->mCount.decrement()) {
+            delete static_cast<const Derived*>(p);
+        }
+    }
+};
+
+// intrusive_ptr, a T* calling intrusive_ptr_add_ref(T*) and
+// intrusive_ptr_release(T*), no control block
+template <typename T>
+class intrusive_ptr {
+public:
+    using element_type = T;
+
+    constexpr intrusive_ptr() noexcept {
+    }
+
+    // add_ref is false to adopt a reference the caller already holds
+    intrusive_ptr(T* ptr, bool add_ref = true) : mPtr(ptr) {
+        if (mPtr && add_ref) {
+            intrusive_ptr_add_ref(mPtr);
+        }
+    }
+
+    intrusive_ptr(const intrusive_ptr& rhs) : intrusive_ptr(rhs.get()) {
+    }
+
+    template <typename U, enable_if_t<is_convertible_v<U*, T*>, int> = 0>
+    intrusive_ptr(const intrusive_ptr<U>& rhs) : intrusive_ptr(rhs.get()) {
+    }
+
+    intrusive_ptr(intrusive_ptr&& rhs) noexcept : mPtr(rhs.mPtr) {
+        rhs.mPtr = nullptr;
+    }
+
+    template <typename U, enable_if_t<is_convertible_v<U*, T*>, int> = 0>
+    intrusive_ptr(intrusive_ptr<U>&& rhs) noexcept : mPtr(rhs.detach()) {
+    }
+
+    ~intrusive_ptr() {
+        if (mPtr) {
+            intrusive_ptr_release(mPtr);
+        }
+    }
+
+    intrusive_ptr& operator=(const intrusive_ptr& rhs) {
+        intrusive_ptr{rhs}.swap(*this);
+        return *this;
+    }
+
+    template <typename U>
+    intrusive_ptr& operator=(const intrusive_ptr<U>& rhs) {
+        intrusive_ptr{rhs}.swap(*this);
+        return *this;
+    }
+
+    intrusive_ptr& operator=(intrusive_ptr&& rhs) noexcept {
+        intrusive_ptr{tiny_stl::move(rhs)}.swap(*this);
+        return *this;
+    }
+
+    template <typename U>
+    intrusive_ptr& operator=(intrusive_ptr<U>&& rhs) noexcept {
+        intrusive_ptr{tiny_stl::move(rhs)}.swap(*this);
+        return *this;
+    }
+
+    intrusive_ptr& operator=(T* ptr) {
+        intrusive_ptr{ptr}.swap(*this);
+        return *this;
+    }
+
+    void reset() {
+        intrusive_ptr{}.swap(*this);
+    }
+
+    void reset(T* ptr, bool add_ref = true) {
+        intrusive_ptr{ptr, add_ref}.swap(*this);
+    }
+
+    // give up the reference without releasing it
+    T* detach() noexcept {
+        T* ptr = mPtr;
+        mPtr = nullptr;
+        return ptr;
+    }
+
+    T* get() const noexcept {
+        return mPtr;
+    }
+
+    T& operator*() const noexcept {
+        return *mPtr;
+    }
+
+    T* operator->() const noexcept {
+        return mPtr;
+    }
+
+    explicit operator bool() const noexcept {
+        return mPtr != nullptr;
+    }
+
+    void swap(intrusive_ptr& rhs) noexcept {
+        tiny_stl::swap(mPtr, rhs.mPtr);
+    }
+
+private:
+    T* mPtr{nullptr};
+}; // class intrusive_ptr
+
+template <typename T1, typename T2>
+bool operator==(const intrusive_ptr<T1>& lhs,
+                const intrusive_ptr<T2>& rhs) noexcept {
+    return lhs.get() == rhs.get();
+}
+
+template <typename T1, typename T2>
+bool operator!=(const intrusive_ptr<T1>& lhs,
+                const intrusive_ptr<T2>& rhs) noexcept {
+    return !(lhs == rhs);
+}
+
+template <typename T1, typename T2>
+bool operator<(const intrusive_ptr<T1>& lhs,
+               const intrusive_ptr<T2>& rhs) noexcept {
+    return lhs.get() < rhs.get();
+}
+
+template <typename T>
+bool operator==(const intrusive_ptr<T>& lhs, std::nullptr_t) noexcept {
+    return lhs.get() == nullptr;
+}
+
+template <typename T>
+bool operator==(std::nullptr_t, const intrusive_ptr<T>& rhs) noexcept {
+    return rhs.get() == nullptr;
+}
+
+template <typename T>
+bool operator!=(const intrusive_ptr<T>& lhs, std::nullptr_t) noexcept {
+    return lhs.get() != nullptr;
+}
+
+template <typename T>
+bool operator!=(std::nullptr_t, const intrusive_ptr<T>& rhs) noexcept {
+    return rhs.get() != nullptr;
+}
+
+template <typename T, typename U>
+intrusive_ptr<T> static_pointer_cast(const intrusive_ptr<U>& ptr) {
+    return intrusive_ptr<T>(static_cast<T*>(ptr.get()));
+}
+
+template <typename T>
+void swap(intrusive_ptr<T>& lhs, intrusive_ptr<T>& rhs) noexcept {
+    lhs.swap(rhs);
+}
+
+template <typename T>
+struct is_trivially_relocatable<local_shared_ptr<T>> : true_type {};
+
+template <typename T>
+struct is_trivially_relocatable<intrusive_ptr<T>> : true_type {};
+
 } // namespace tiny_stl
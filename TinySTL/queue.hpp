@@ -171,8 +171,51 @@ template <typename T, typename Container, typename Alloc>
 struct uses_allocator<queue<T, Container>, Alloc>
     : uses_allocator<Container, Alloc>::type {};
 
+// heap layouts for priority_queue
+
+// push_heap / pop_heap / make_heap of the algorithm library
+struct binary_heap {
+    template <typename RanIter, typename Cmp>
+    static void push_heap(RanIter first, RanIter last, Cmp& cmp) {
+        tiny_stl::push_heap(first, last, cmp);
+    }
+
+    template <typename RanIter, typename Cmp>
+    static void pop_heap(RanIter first, RanIter last, Cmp& cmp) {
+        tiny_stl::pop_heap(first, last, cmp);
+    }
+
+    template <typename RanIter, typename Cmp>
+    static void make_heap(RanIter first, RanIter last, Cmp& cmp) {
+        tiny_stl::make_heap(first, last, cmp);
+    }
+};
+
+// D children per node, dary_heap<4> suits large queues: half the levels
+// of a binary heap and the 4 children of a node usually on one cache line
+template <size_t D>
+struct dary_heap {
+    static_assert(D >= 2, "dary_heap needs at least 2 children per node");
+
+    template <typename RanIter, typename Cmp>
+    static void push_heap(RanIter first, RanIter last, Cmp& cmp) {
+        daryPushHeap<D>(first, last, cmp);
+    }
+
+    template <typename RanIter, typename Cmp>
+    static void pop_heap(RanIter first, RanIter last, Cmp& cmp) {
+        daryPopHeap<D>(first, last, cmp);
+    }
+
+    template <typename RanIter, typename Cmp>
+    static void make_heap(RanIter first, RanIter last, Cmp& cmp) {
+        daryMakeHeap<D>(first, last, cmp);
+    }
+};
+
 template <typename T, typename Container = tiny_stl::vector<T>,
-          typename Compare = tiny_stl::less<typename Container::value_type>>
+          typename Compare = tiny_stl::less<typename Container::value_type>,
+          typename Heap = binary_heap>
 class priority_queue {
 public:
     using container_type = Container;
@@ -194,14 +237,14 @@ public:
     // (1)
     priority_queue(const value_compare& cmp, const container_type& c)
         : comp(cmp), cont(c) {
-        tiny_stl::make_heap(cont.begin(), cont.end(), comp);
+        Heap::make_heap(cont.begin(), cont.end(), comp);
     }
 
     // (2)
     explicit priority_queue(const value_compare& cmp = value_compare{},
                             container_type&& c = container_type{})
         : comp(cmp), cont(tiny_stl::move(c)) {
-        tiny_stl::make_heap(cont.begin(), cont.end(), comp);
+        Heap::make_heap(cont.begin(), cont.end(), comp);
     }
 
     // (3)
@@ -232,7 +275,7 @@ public:
     priority_queue(const value_compare& cmp, const container_type& c,
                    const Alloc& alloc)
         : comp(cmp), cont(c, alloc) {
-        tiny_stl::make_heap(cont.begin(), cont.end(), comp);
+        Heap::make_heap(cont.begin(), cont.end(), comp);
     }
 
     // (8)
@@ -241,7 +284,7 @@ public:
     priority_queue(const value_compare& cmp, container_type&& c,
                    const Alloc& alloc)
         : comp(cmp), cont(tiny_stl::move(c), alloc) {
-        tiny_stl::make_heap(cont.begin(), cont.end(), comp);
+        Heap::make_heap(cont.begin(), cont.end(), comp);
     }
 
     // (9)
@@ -265,7 +308,7 @@ public:
                    const container_type& c)
         : comp(cmp), cont(c) {
         cont.insert(cont.end(), first, last);
-        tiny_stl::make_heap(cont.begin(), cont.end(), comp);
+        Heap::make_heap(cont.begin(), cont.end(), comp);
     }
 
     // (12)
@@ -275,7 +318,7 @@ public:
                    container_type&& c = container_type{})
         : comp(cmp), cont(tiny_stl::move(c)) {
         cont.insert(cont.end(), first, last);
-        tiny_stl::make_heap(cont.begin(), cont.end(), comp);
+        Heap::make_heap(cont.begin(), cont.end(), comp);
     }
 
     const_reference top() const {
@@ -292,22 +335,22 @@ public:
 
     void push(const value_type& val) {
         cont.push_back(val);
-        tiny_stl::push_heap(cont.begin(), cont.end(), comp);
+        Heap::push_heap(cont.begin(), cont.end(), comp);
     }
 
     void push(value_type&& val) {
         cont.push_back(tiny_stl::move(val));
-        tiny_stl::push_heap(cont.begin(), cont.end(), comp);
+        Heap::push_heap(cont.begin(), cont.end(), comp);
     }
 
     template <typename... Args>
     void emplace(Args&&... args) {
         cont.emplace_back(tiny_stl::forward<Args>(args)...);
-        tiny_stl::push_heap(cont.begin(), cont.end(), comp);
+        Heap::push_heap(cont.begin(), cont.end(), comp);
     }
 
     void pop() {
-        tiny_stl::pop_heap(cont.begin(), cont.end(), comp);
+        Heap::pop_heap(cont.begin(), cont.end(), comp);
         cont.pop_back();
     }
 
@@ -319,15 +362,251 @@ public:
     }
 }; // class priority_queue<T, Container>
 
-template <typename T, typename Container, typename Compare>
-void swap(priority_queue<T, Container, Compare>& lhs,
-          priority_queue<T, Container, Compare>&
+template <typename T, typename Container, typename Compare, typename Heap>
+void swap(priority_queue<T, Container, Compare, Heap>& lhs,
+          priority_queue<T, Container, Compare, Heap>&
               rhs) noexcept(noexcept(lhs.swap(rhs))) {
     lhs.swap(rhs);
 }
 
-template <typename T, typename Container, typename Compare, typename Alloc>
-struct uses_allocator<priority_queue<T, Container, Compare>, Alloc>
+template <typename T, typename Container, typename Compare, typename Heap,
+          typename Alloc>
+struct uses_allocator<priority_queue<T, Container, Compare, Heap>, Alloc>
     : tiny_stl::uses_allocator<Container, Alloc>::type {};
 
+// a priority_queue whose elements can be changed or erased through the
+// handle that push returns, so that decrease-key needs no lazy deletion
+//
+// an indexed D-ary heap: every element owns a slot, the heap entries
+// record their slot and the slots record their heap position. A handle
+// is valid until its element is popped or erased, then its slot may be
+// given to a later push.
+template <typename T, typename Compare = tiny_stl::less<T>, size_t D = 4,
+          typename Alloc = tiny_stl::allocator<T>>
+class addressable_priority_queue {
+public:
+    using value_type = T;
+    using size_type = size_t;
+    using const_reference = const T&;
+    using value_compare = Compare;
+    using allocator_type = Alloc;
+    using handle_type = size_t;
+
+    static_assert(D >= 2, "addressable_priority_queue needs D >= 2");
+
+private:
+    struct Entry {
+        T value;
+        size_type slot;
+
+        template <typename... Args>
+        Entry(size_type s, Args&&... args)
+            : value(tiny_stl::forward<Args>(args)...), slot(s) {
+        }
+    };
+
+    using AlTraits = allocator_traits<Alloc>;
+    using AlEntry = typename AlTraits::template rebind_alloc<Entry>;
+    using AlIndex = typename AlTraits::template rebind_alloc<size_type>;
+
+    // the heap position of a free slot
+    static const size_type kFree = static_cast<size_type>(-1);
+
+    vector<Entry, AlEntry> heap;
+    vector<size_type, AlIndex> position; // slot -> heap index
+    vector<size_type, AlIndex> free_slots;
+    value_compare comp;
+
+private:
+    void place(size_type i, Entry&& entry) {
+        heap[i] = tiny_stl::move(entry);
+        position[heap[i].slot] = i;
+    }
+
+    void siftUp(size_type i) {
+        Entry entry = tiny_stl::move(heap[i]);
+        while (i > 0) {
+            const size_type parent = (i - 1) / D;
+            if (!comp(heap[parent].value, entry.value))
+                break;
+
+            place(i, tiny_stl::move(heap[parent]));
+            i = parent;
+        }
+        place(i, tiny_stl::move(entry));
+    }
+
+    void siftDown(size_type i) {
+        const size_type n = heap.size();
+        Entry entry = tiny_stl::move(heap[i]);
+        for (size_type child = i * D + 1; child < n; child = i * D + 1) {
+            const size_type last = tiny_stl::min(child + D, n);
+            size_type largest = child;
+            for (++child; child < last; ++child)
+                if (comp(heap[largest].value, heap[child].value))
+                    largest = child;
+
+            if (!comp(entry.value, heap[largest].value))
+                break;
+
+            place(i, tiny_stl::move(heap[largest]));
+            i = largest;
+        }
+        place(i, tiny_stl::move(entry));
+    }
+
+    // the value at i has changed
+    void fix(size_type i) {
+        if (i > 0 && comp(heap[(i - 1) / D].value, heap[i].value))
+            siftUp(i);
+        else
+            siftDown(i);
+    }
+
+public:
+    explicit addressable_priority_queue(const Compare& cmp = Compare(),
+                                        const Alloc& al = Alloc())
+        : heap(AlEntry(al)), position(AlIndex(al)), free_slots(AlIndex(al)),
+          comp(cmp) {
+    }
+
+    explicit addressable_priority_queue(const Alloc& al)
+        : addressable_priority_queue(Compare(), al) {
+    }
+
+    allocator_type get_allocator() const {
+        return allocator_type(heap.get_allocator());
+    }
+
+    const_reference top() const {
+        assert(!empty());
+        return heap.front().value;
+    }
+
+    handle_type top_handle() const {
+        assert(!empty());
+        return heap.front().slot;
+    }
+
+    bool empty() const noexcept {
+        return heap.empty();
+    }
+
+    size_type size() const noexcept {
+        return heap.size();
+    }
+
+    // whether h refers to an element in the queue
+    bool contains(handle_type h) const noexcept {
+        return h < position.size() && position[h] != kFree;
+    }
+
+    const_reference value(handle_type h) const {
+        assert(contains(h));
+        return heap[position[h]].value;
+    }
+
+    template <typename... Args>
+    handle_type emplace(Args&&... args) {
+        const bool reuse = !free_slots.empty();
+        const size_type slot = reuse ? free_slots.back() : position.size();
+        if (!reuse)
+            position.push_back(kFree);
+
+        try {
+            heap.emplace_back(slot, tiny_stl::forward<Args>(args)...);
+        } catch (...) {
+            if (!reuse)
+                position.pop_back();
+            throw;
+        }
+
+        if (reuse)
+            free_slots.pop_back();
+        position[slot] = heap.size() - 1;
+        siftUp(heap.size() - 1);
+
+        return slot;
+    }
+
+    handle_type push(const value_type& val) {
+        return emplace(val);
+    }
+
+    handle_type push(value_type&& val) {
+        return emplace(tiny_stl::move(val));
+    }
+
+    void pop() {
+        erase(top_handle());
+    }
+
+    void erase(handle_type h) {
+        assert(contains(h));
+        free_slots.push_back(h);
+
+        const size_type i = position[h];
+        position[h] = kFree;
+        if (i + 1 == heap.size()) {
+            heap.pop_back();
+            return;
+        }
+
+        place(i, tiny_stl::move(heap.back()));
+        heap.pop_back();
+        fix(i);
+    }
+
+    // replace the value of h, it moves up or down as needed
+    void update(handle_type h, const value_type& val) {
+        assert(contains(h));
+        heap[position[h]].value = val;
+        fix(position[h]);
+    }
+
+    void update(handle_type h, value_type&& val) {
+        assert(contains(h));
+        heap[position[h]].value = tiny_stl::move(val);
+        fix(position[h]);
+    }
+
+    // call fn(value&) on the value of h, then restore the heap
+    template <typename Fn>
+    void modify(handle_type h, Fn fn) {
+        assert(contains(h));
+        fn(heap[position[h]].value);
+        fix(position[h]);
+    }
+
+    void reserve(size_type n) {
+        heap.reserve(n);
+        position.reserve(n);
+    }
+
+    // all handles become invalid
+    void clear() noexcept {
+        heap.clear();
+        position.clear();
+        free_slots.clear();
+    }
+
+    void swap(addressable_priority_queue& rhs) noexcept(
+        is_nothrow_swappable<Compare>::value) {
+        heap.swap(rhs.heap);
+        position.swap(rhs.position);
+        free_slots.swap(rhs.free_slots);
+        swapADL(comp, rhs.comp);
+    }
+}; // class addressable_priority_queue
+
+template <typename T, typename Compare, size_t D, typename Alloc>
+const size_t addressable_priority_queue<T, Compare, D, Alloc>::kFree;
+
+template <typename T, typename Compare, size_t D, typename Alloc>
+void swap(addressable_priority_queue<T, Compare, D, Alloc>& lhs,
+          addressable_priority_queue<T, Compare, D, Alloc>&
+              rhs) noexcept(noexcept(lhs.swap(rhs))) {
+    lhs.swap(rhs);
+}
+
 } // namespace tiny_stl
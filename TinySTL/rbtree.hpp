@@ -7,6 +7,7 @@
 #include <initializer_list>
 
 #include "memory.hpp"
+#include "stats.hpp"
 
 namespace tiny_stl {
 
@@ -255,6 +256,10 @@ protected:
     AlNode alloc;
     Compare compare;
 
+#ifdef TINY_STL_STATS
+    size_type rotations = 0;
+#endif
+
 public:
     RBTreeBase() : mCount(0), alloc(), compare() {
         createHeaderNode();
@@ -411,7 +416,17 @@ private:
         return pos;
     }
 
-    NodePtr copyNodes(NodePtr rhsRoot, NodePtr thisPos) {
+    static const T& nodeValue(NodePtr p, false_type /* copy */) noexcept {
+        return p->value;
+    }
+
+    static T&& nodeValue(NodePtr p, true_type /* move */) noexcept {
+        return tiny_stl::move(p->value);
+    }
+
+    // clone the shape of rhs, copy or move the values by Tag
+    template <typename Tag>
+    NodePtr copyNodes(NodePtr rhsRoot, NodePtr thisPos, Tag tag) {
         NodePtr newheader = this->header;
 
         if (!rhsRoot->isNil) {
@@ -419,8 +434,11 @@ private:
             p->color = rhsRoot->color;
             p->isNil = 0;
             p->parent = thisPos;
+            p->left = this->header;
+            p->right = this->header;
             try {
-                p->value = rhsRoot->value;
+                this->alloc.construct(tiny_stl::addressof(p->value),
+                                      nodeValue(rhsRoot, tag));
             } catch (...) {
                 this->alloc.deallocate(p, 1);
                 throw;
@@ -429,15 +447,21 @@ private:
             if (newheader->isNil)
                 newheader = p;
 
-            p->left = copyNodes(rhsRoot->left, p);
-            p->right = copyNodes(rhsRoot->right, p);
+            try {
+                p->left = copyNodes(rhsRoot->left, p, tag);
+                p->right = copyNodes(rhsRoot->right, p, tag);
+            } catch (...) {
+                clearAux(p);
+                throw;
+            }
         }
 
         return newheader;
     }
 
-    void copyAux(const RBTree& rhs) {
-        getRoot() = copyNodes(rhs.getRoot(), this->header);
+    template <typename Tag>
+    void copyAux(const RBTree& rhs, Tag tag) {
+        getRoot() = copyNodes(rhs.getRoot(), this->header, tag);
         this->mCount = rhs.mCount;
 
         if (!getRoot()->isNil) {
@@ -449,12 +473,44 @@ private:
         }
     }
 
+    void copyAux(const RBTree& rhs) {
+        copyAux(rhs, false_type{});
+    }
+
     void moveAux(RBTree&& rhs) {
         tiny_stl::swapADL(this->compare, rhs.compare);
         tiny_stl::swapADL(this->header, rhs.header);
         tiny_stl::swapADL(this->mCount, rhs.mCount);
     }
 
+    // steal the nodes only if they can be freed by this->alloc
+    void moveAssignAux(RBTree&& rhs) {
+        if (AlNodeTraits::propagate_on_container_move_assignment::value) {
+            tiny_stl::swapADL(this->alloc, rhs.alloc);
+            moveAux(tiny_stl::move(rhs));
+        } else if (this->alloc == rhs.alloc) {
+            moveAux(tiny_stl::move(rhs));
+        } else {
+            this->compare = rhs.compare;
+            copyAux(rhs, true_type{});
+            rhs.clear();
+        }
+    }
+
+    void leftRotate(NodePtr& root, NodePtr x) {
+#ifdef TINY_STL_STATS
+        ++this->rotations;
+#endif
+        rbTreeLeftRotate(root, x);
+    }
+
+    void rightRotate(NodePtr& root, NodePtr y) {
+#ifdef TINY_STL_STATS
+        ++this->rotations;
+#endif
+        rbTreeRightRotate(root, y);
+    }
+
     void rbTreeFixupForInsert(NodePtr& root, NodePtr z) {
         while (z->parent->color == Color::RED) { // parent is red
             // if parent is grandfather's left child
@@ -470,12 +526,12 @@ private:
                     if (z == z->parent->right) {
                         // case 2, z is parent's right child
                         z = z->parent;
-                        rbTreeLeftRotate(root, z);
+                        leftRotate(root, z);
                     }
                     z->parent->color =
                         Color::BLACK; // case 3, z is parent's left child
                     z->parent->parent->color = Color::RED;
-                    rbTreeRightRotate(root, z->parent->parent);
+                    rightRotate(root, z->parent->parent);
                 }
             } else { // parent is grandfather's right
                 NodePtr y = z->parent->parent->left; // y is z's uncle
@@ -489,12 +545,12 @@ private:
                     if (z == z->parent->left) {
                         // case 2, z is parent's left child
                         z = z->parent;
-                        rbTreeRightRotate(root, z);
+                        rightRotate(root, z);
                     }
                     // case 3, z is parent's left child
                     z->parent->color = Color::BLACK;
                     z->parent->parent->color = Color::RED;
-                    rbTreeLeftRotate(root, z->parent->parent);
+                    leftRotate(root, z->parent->parent);
                 }
             }
         }
@@ -509,7 +565,7 @@ private:
                 if (w->color == Color::RED) { // case 1, x's brother w is red
                     w->color = Color::BLACK;
                     x->parent->color = Color::RED;
-                    rbTreeLeftRotate(root, x->parent);
+                    leftRotate(root, x->parent);
                     w = x->parent->right;
                 }
                 if (w->left->color == Color::BLACK &&
@@ -521,13 +577,13 @@ private:
                     if (w->right->color == Color::BLACK) {
                         w->left->color = Color::BLACK;
                         w->color = Color::RED;
-                        rbTreeRightRotate(root, w);
+                        rightRotate(root, w);
                         w = x->parent->right;
                     }
                     w->color = x->parent->color;
                     x->parent->color = Color::BLACK;
                     w->right->color = Color::BLACK;
-                    rbTreeLeftRotate(root, x->parent);
+                    leftRotate(root, x->parent);
                     x = root;
                 }
             } else {
@@ -535,7 +591,7 @@ private:
                 if (w->color == Color::RED) { // case 1
                     w->color = Color::BLACK;
                     x->parent->color = Color::RED;
-                    rbTreeRightRotate(root, x->parent);
+                    rightRotate(root, x->parent);
                     w = x->parent->left;
                 }
                 if (w->left->color == Color::BLACK &&
@@ -546,14 +602,14 @@ private:
                     if (w->left->color == Color::BLACK) { // case 3
                         w->right->color = Color::BLACK;
                         w->color = Color::RED;
-                        rbTreeLeftRotate(root, w);
+                        leftRotate(root, w);
                         w = x->parent->left;
                     }
                     // case 4
                     w->color = x->parent->color;
                     x->parent->color = Color::BLACK;
                     w->left->color = Color::BLACK;
-                    rbTreeRightRotate(root, x->parent);
+                    rightRotate(root, x->parent);
                     x = root;
                 }
             }
@@ -584,7 +640,12 @@ public:
     }
 
     RBTree(RBTree&& rhs, const Alloc& alloc) : Base(rhs.compare, alloc) {
-        moveAux(tiny_stl::move(rhs));
+        if (this->alloc == rhs.alloc) {
+            moveAux(tiny_stl::move(rhs));
+        } else {
+            copyAux(rhs, true_type{});
+            rhs.clear();
+        }
     }
 
     RBTree& operator=(const RBTree& rhs) {
@@ -596,9 +657,8 @@ public:
     }
 
     RBTree& operator=(RBTree&& rhs) {
-        // Non-standard, user allocator may be wrong
         clear();
-        moveAux(tiny_stl::move(rhs));
+        moveAssignAux(tiny_stl::move(rhs));
 
         return *this;
     }
@@ -724,37 +784,29 @@ public:
     }
 
 private:
-    iterator insertAux(NodePtr z) {
-        NodePtr x = getRoot();
-        NodePtr y = this->header;
-
-        if (y->left->isNil || this->compare(get_key(z), get_key(y->left)))
-            y->left = z;
-
-        if (y->right->isNil || !this->compare(get_key(z), get_key(y->right)))
-            y->right = z;
-
-        while (!x->isNil) {
-            y = x;
-            if (this->compare(get_key(z), get_key(x)))
-                x = x->left;
-            else
-                x = x->right;
-        }
-
+    // a new node is linked as the left or right child of parent, equal is
+    // the node holding the same key when the keys are unique
+    struct LinkPos {
+        NodePtr parent;
+        bool left;
+        NodePtr equal;
+    };
+
+    iterator linkNode(NodePtr z, LinkPos pos) {
+        NodePtr y = pos.parent;
         z->parent = y;
 
         if (y->isNil) {
             getRoot() = z;
             this->header->left = z;
             this->header->right = z;
-        } else if (this->compare(get_key(z), get_key(y))) {
+        } else if (pos.left) {
             y->left = z;
-            if (this->compare(get_key(z), get_key(this->header->left)))
+            if (y == this->header->left)
                 this->header->left = z; // z.key < min_value
         } else {
             y->right = z;
-            if (!this->compare(get_key(z), get_key(this->header->right)))
+            if (y == this->header->right)
                 this->header->right = z; // z.key >= max_value
         }
 
@@ -765,62 +817,389 @@ private:
         return iterator(z);
     }
 
+    // after the equal keys
+    LinkPos equalPos(const key_type& key) const {
+        NodePtr x = getRoot();
+        NodePtr y = this->header;
+        bool left = true;
+
+        while (!x->isNil) {
+            y = x;
+            left = this->compare(key, get_key(x));
+            x = left ? x->left : x->right;
+        }
+
+        return {y, left, nullptr};
+    }
+
+    // before the equal keys
+    LinkPos lowerEqualPos(const key_type& key) const {
+        NodePtr x = getRoot();
+        NodePtr y = this->header;
+        bool left = true;
+
+        while (!x->isNil) {
+            y = x;
+            left = !this->compare(get_key(x), key);
+            x = left ? x->left : x->right;
+        }
+
+        return {y, left, nullptr};
+    }
+
+    LinkPos uniquePos(const key_type& key) const {
+        LinkPos pos = equalPos(key);
+        NodePtr before = pos.parent;
+
+        if (pos.left) {
+            if (before == this->header->left) // also the empty tree
+                return pos;
+            before = (--iterator(before)).ptr;
+        }
+
+        if (this->compare(get_key(before), key))
+            return pos;
+
+        return {nullptr, false, before};
+    }
+
+    // the new node goes right before hint or right after it, O(1) if key
+    // fits there, otherwise the usual descent
+    LinkPos hintUniquePos(NodePtr hint, const key_type& key) const {
+        if (hint->isNil) { // end()
+            if (this->mCount > 0 &&
+                this->compare(get_key(this->header->right), key))
+                return {this->header->right, false, nullptr};
+
+            return uniquePos(key);
+        }
+
+        if (this->compare(key, get_key(hint))) {
+            if (hint == this->header->left)
+                return {hint, true, nullptr};
+
+            NodePtr before = (--iterator(hint)).ptr;
+            if (!this->compare(get_key(before), key))
+                return uniquePos(key);
+
+            // hint is the leftmost node of a non-nil before->right
+            return before->right->isNil ? LinkPos{before, false, nullptr}
+                                        : LinkPos{hint, true, nullptr};
+        }
+
+        if (this->compare(get_key(hint), key)) {
+            if (hint == this->header->right)
+                return {hint, false, nullptr};
+
+            NodePtr after = (++iterator(hint)).ptr;
+            if (!this->compare(key, get_key(after)))
+                return uniquePos(key);
+
+            // after is the leftmost node of a non-nil hint->right
+            return hint->right->isNil ? LinkPos{hint, false, nullptr}
+                                      : LinkPos{after, true, nullptr};
+        }
+
+        return {nullptr, false, hint};
+    }
+
+    // as close as possible before hint, a wrong hint falls back to the
+    // end of the equal keys nearest it
+    LinkPos hintEqualPos(NodePtr hint, const key_type& key) const {
+        if (hint->isNil) { // end()
+            if (this->mCount > 0 &&
+                !this->compare(key, get_key(this->header->right)))
+                return {this->header->right, false, nullptr};
+
+            return equalPos(key);
+        }
+
+        if (!this->compare(get_key(hint), key)) {
+            if (hint == this->header->left)
+                return {hint, true, nullptr};
+
+            NodePtr before = (--iterator(hint)).ptr;
+            if (this->compare(key, get_key(before)))
+                return equalPos(key);
+
+            return before->right->isNil ? LinkPos{before, false, nullptr}
+                                        : LinkPos{hint, true, nullptr};
+        }
+
+        if (hint == this->header->right)
+            return {hint, false, nullptr};
+
+        NodePtr after = (++iterator(hint)).ptr;
+        if (this->compare(get_key(after), key))
+            return lowerEqualPos(key);
+
+        return hint->right->isNil ? LinkPos{hint, false, nullptr}
+                                  : LinkPos{after, true, nullptr};
+    }
+
+    template <typename... Args>
+    iterator emplaceEqualAux(Args&&... args) {
+        NodePtr z = allocAndConstruct(tiny_stl::forward<Args>(args)...);
+        return linkNode(z, equalPos(get_key(z)));
+    }
+
+    template <typename... Args>
+    iterator emplaceHintEqualAux(NodePtr hint, Args&&... args) {
+        NodePtr z = allocAndConstruct(tiny_stl::forward<Args>(args)...);
+        return linkNode(z, hintEqualPos(hint, get_key(z)));
+    }
+
+    // val is a value_type, nothing is constructed for an existing key
     template <typename Value>
-    iterator insertEqualAux(Value&& val) {
+    pair<iterator, bool> insertUniqueAux(LinkPos pos, Value&& val) {
+        if (pos.equal != nullptr)
+            return tiny_stl::make_pair(iterator(pos.equal), false);
+
         NodePtr z = allocAndConstruct(tiny_stl::forward<Value>(val));
-        return insertAux(z);
+        return tiny_stl::make_pair(linkNode(z, pos), true);
     }
 
-    template <typename Value>
-    pair<iterator, bool> insertUniqueAux(Value&& val) {
-        T value(tiny_stl::forward<Value>(val));
-        iterator pos = find(getKeyFromValue(val));
+    // the key is known after the node is constructed
+    template <typename... Args>
+    pair<iterator, bool> emplaceUniqueAux(NodePtr hint, Args&&... args) {
+        NodePtr z = allocAndConstruct(tiny_stl::forward<Args>(args)...);
+        LinkPos pos = hint == nullptr ? uniquePos(get_key(z))
+                                      : hintUniquePos(hint, get_key(z));
+        if (pos.equal != nullptr) {
+            destroyAndFree(z);
+            return tiny_stl::make_pair(iterator(pos.equal), false);
+        }
+
+        return tiny_stl::make_pair(linkNode(z, pos), true);
+    }
+
+    // the next count values of a sorted range make a balanced subtree,
+    // before the last level every level is full, so the nodes on the last
+    // level are red and the others black
+    template <typename FwdIter, typename Unique>
+    NodePtr buildSorted(FwdIter& first, FwdIter last, size_type count,
+                        size_type depth, size_type redDepth, Unique unique) {
+        if (count == 0)
+            return this->header;
+
+        const size_type leftCount = (count - 1) / 2;
+        NodePtr left =
+            buildSorted(first, last, leftCount, depth + 1, redDepth, unique);
 
-        if (pos != end()) {
-            return make_pair(pos, false);
+        NodePtr p;
+        try {
+            p = allocAndConstruct(*first);
+        } catch (...) {
+            clearAux(left);
+            throw;
         }
 
-        NodePtr z = allocAndConstruct(tiny_stl::move(value));
-        return make_pair(insertAux(z), true);
+        p->color = depth == redDepth ? Color::RED : Color::BLACK;
+        p->left = left;
+        if (!left->isNil)
+            left->parent = p;
+
+        ++first;
+        skipEqual(first, last, p, unique);
+
+        try {
+            p->right = buildSorted(first, last, count - 1 - leftCount,
+                                   depth + 1, redDepth, unique);
+        } catch (...) {
+            clearAux(p);
+            throw;
+        }
+
+        if (!p->right->isNil)
+            p->right->parent = p;
+
+        return p;
+    }
+
+    // keep the first of equal keys like insert_unique()
+    template <typename FwdIter>
+    void skipEqual(FwdIter& first, FwdIter last, NodePtr p, true_type) {
+        while (first != last &&
+               !this->compare(get_key(p), getKeyFromValue(*first)))
+            ++first;
+    }
+
+    template <typename FwdIter>
+    void skipEqual(FwdIter&, FwdIter, NodePtr, false_type) {
+    }
+
+    // O(n), the tree is empty, [first, last) is sorted and has count
+    // values, or count unique keys if unique
+    template <typename FwdIter, typename Unique>
+    void buildTree(FwdIter first, FwdIter last, size_type count,
+                   Unique unique) {
+        assert(empty());
+        if (count == 0)
+            return;
+
+        size_type redDepth = 0;
+        for (size_type n = count + 1; n > 1; n >>= 1)
+            ++redDepth;
+
+        getRoot() = buildSorted(first, last, count, 0, redDepth, unique);
+        getRoot()->parent = this->header;
+        this->header->left = rbTreeMinValue(getRoot());
+        this->header->right = rbTreeMaxValue(getRoot());
+        this->mCount = count;
+    }
+
+    // count the values to build, false if the range is not sorted
+    template <typename FwdIter, typename Unique>
+    bool sortedCount(FwdIter first, FwdIter last, size_type& count,
+                     Unique) const {
+        count = 0;
+        if (first == last)
+            return true;
+
+        count = 1;
+        for (FwdIter prev = first; ++first != last; prev = first) {
+            if (this->compare(getKeyFromValue(*first),
+                              getKeyFromValue(*prev)))
+                return false;
+
+            if (!Unique::value || this->compare(getKeyFromValue(*prev),
+                                                getKeyFromValue(*first)))
+                ++count;
+        }
+
+        return true;
+    }
+
+    template <typename InIter>
+    using IsForwardIter = bool_constant<is_convertible<
+        typename iterator_traits<InIter>::iterator_category,
+        forward_iterator_tag>::value>;
+
+    template <typename InIter, typename Unique>
+    void insertRange(InIter first, InIter last, Unique unique,
+                     false_type /* single pass */) {
+        insertRangeHint(first, last, unique);
+    }
+
+    // a sorted range is built in O(n) when the tree is empty
+    template <typename FwdIter, typename Unique>
+    void insertRange(FwdIter first, FwdIter last, Unique unique,
+                     true_type /* forward */) {
+        size_type count = 0;
+        if (empty() && sortedCount(first, last, count, unique))
+            buildTree(first, last, count, unique);
+        else
+            insertRangeHint(first, last, unique);
+    }
+
+    // ascending values are linked after the last node in O(1)
+    template <typename InIter>
+    void insertRangeHint(InIter first, InIter last, true_type) {
+        for (; first != last; ++first)
+            emplaceUniqueAux(this->header, *first);
+    }
+
+    template <typename InIter>
+    void insertRangeHint(InIter first, InIter last, false_type) {
+        for (; first != last; ++first)
+            emplaceHintEqualAux(this->header, *first);
+    }
+
+    template <typename InIter, typename Unique>
+    void insertSorted(InIter first, InIter last, Unique unique,
+                      false_type /* single pass */) {
+        insertRangeHint(first, last, unique);
+    }
+
+    template <typename FwdIter, typename Unique>
+    void insertSorted(FwdIter first, FwdIter last, Unique,
+                      true_type /* forward */) {
+        const size_type count =
+            static_cast<size_type>(tiny_stl::distance(first, last));
+        buildTree(first, last, count, false_type{}); // no check
     }
 
 protected:
     iterator insert_equal(const value_type& val) {
-        return insertEqualAux(val);
+        return emplaceEqualAux(val);
     }
 
     iterator insert_equal(value_type&& val) {
-        return insertEqualAux(tiny_stl::move(val));
+        return emplaceEqualAux(tiny_stl::move(val));
+    }
+
+    iterator insert_equal(const_iterator hint, const value_type& val) {
+        return emplaceHintEqualAux(hint.ptr, val);
+    }
+
+    iterator insert_equal(const_iterator hint, value_type&& val) {
+        return emplaceHintEqualAux(hint.ptr, tiny_stl::move(val));
     }
 
     template <typename InIter>
     void insert_equal(InIter first, InIter last) {
-        for (; first != last; ++first)
-            insertEqualAux(*first);
+        insertRange(first, last, false_type{}, IsForwardIter<InIter>{});
+    }
+
+    // the tree is empty and [first, last) is sorted
+    template <typename InIter>
+    void insert_sorted_equal(InIter first, InIter last) {
+        assert(empty());
+        insertSorted(first, last, false_type{}, IsForwardIter<InIter>{});
     }
 
     pair<iterator, bool> insert_unique(const value_type& val) {
-        return insertUniqueAux(val);
+        return insertUniqueAux(uniquePos(getKeyFromValue(val)), val);
     }
 
     pair<iterator, bool> insert_unique(value_type&& val) {
-        return insertUniqueAux(tiny_stl::move(val));
+        return insertUniqueAux(uniquePos(getKeyFromValue(val)),
+                               tiny_stl::move(val));
+    }
+
+    iterator insert_unique(const_iterator hint, const value_type& val) {
+        return insertUniqueAux(hintUniquePos(hint.ptr, getKeyFromValue(val)),
+                               val)
+            .first;
+    }
+
+    iterator insert_unique(const_iterator hint, value_type&& val) {
+        return insertUniqueAux(hintUniquePos(hint.ptr, getKeyFromValue(val)),
+                               tiny_stl::move(val))
+            .first;
     }
 
     template <typename InIter>
     void insert_unique(InIter first, InIter last) {
-        for (; first != last; ++first)
-            insertUniqueAux(*first);
+        insertRange(first, last, true_type{}, IsForwardIter<InIter>{});
+    }
+
+    // the tree is empty and [first, last) is sorted without equal keys
+    template <typename InIter>
+    void insert_sorted_unique(InIter first, InIter last) {
+        assert(empty());
+        insertSorted(first, last, true_type{}, IsForwardIter<InIter>{});
     }
 
     template <typename... Args>
     iterator emplace_equal(Args&&... args) {
-        return insertEqualAux(tiny_stl::forward<Args>(args)...);
+        return emplaceEqualAux(tiny_stl::forward<Args>(args)...);
+    }
+
+    template <typename... Args>
+    iterator emplace_hint_equal(const_iterator hint, Args&&... args) {
+        return emplaceHintEqualAux(hint.ptr, tiny_stl::forward<Args>(args)...);
     }
 
     template <typename... Args>
     pair<iterator, bool> emplace_unique(Args&&... args) {
-        return insertUniqueAux(tiny_stl::forward<Args>(args)...);
+        return emplaceUniqueAux(nullptr, tiny_stl::forward<Args>(args)...);
+    }
+
+    template <typename... Args>
+    iterator emplace_hint_unique(const_iterator hint, Args&&... args) {
+        return emplaceUniqueAux(hint.ptr, tiny_stl::forward<Args>(args)...)
+            .first;
     }
 
 private:
@@ -836,7 +1215,8 @@ private:
         v->parent = u->parent;
     }
 
-    // erase node z
+    // erase node z, root is kept here because the nil node is the header
+    // and header->parent is overwritten when nil is relinked
     void eraseAux(NodePtr root, NodePtr z) {
         NodePtr y = z;
         NodePtr x = nullptr;
@@ -851,10 +1231,10 @@ private:
 
         if (z->left->isNil) { // z has not left child
             x = z->right;
-            transplantForErase(getRoot(), z, z->right);
+            transplantForErase(root, z, z->right);
         } else if (z->right->isNil) { // z has not right child
             x = z->left;
-            transplantForErase(getRoot(), z, z->left);
+            transplantForErase(root, z, z->left);
         } else { // z has left and right child
             y = rbTreeMinValue(z->right);
             yOriginColor = y->color;
@@ -863,12 +1243,12 @@ private:
             if (y->parent == z) {
                 x->parent = y;
             } else {
-                transplantForErase(getRoot(), y, y->right);
+                transplantForErase(root, y, y->right);
                 y->right = z->right;
                 y->right->parent = y;
             }
 
-            transplantForErase(getRoot(), z, y);
+            transplantForErase(root, z, y);
             y->left = z->left;
             y->left->parent = y;
             y->color = z->color;
@@ -995,6 +1375,22 @@ public:
         tiny_stl::swapADL(this->mCount, rhs.mCount);
     }
 
+    tree_stats stats() const noexcept {
+#ifdef TINY_STL_STATS
+        return tree_stats{size(), heightAux(getRoot()), this->rotations};
+#else
+        return tree_stats{size(), heightAux(getRoot()), 0};
+#endif
+    }
+
+private:
+    // nodes on the longest path down from x, at most 2 log2(n + 1)
+    static size_type heightAux(NodePtr x) noexcept {
+        if (x->isNil)
+            return 0;
+
+        return 1 + tiny_stl::max(heightAux(x->left), heightAux(x->right));
+    }
 }; // RBTree
 
 template <typename T, typename Compare, typename Alloc, bool isMap>
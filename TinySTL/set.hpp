@@ -56,6 +56,14 @@ public:
         this->insert_unique(first, last);
     }
 
+    // O(n), [first, last) is sorted without equal keys
+    template <typename InIter>
+    set(sorted_unique_t, InIter first, InIter last,
+        const Compare& cmp = Compare(), const Alloc& alloc = Alloc())
+        : Base(cmp, alloc) {
+        this->insert_sorted_unique(first, last);
+    }
+
     set(const set& rhs)
         : Base(rhs, AlTraits::select_on_container_copy_construction(
                         rhs.get_allocator())) {
@@ -104,6 +112,15 @@ public:
         return this->insert_unique(tiny_stl::move(val));
     }
 
+    // O(1) if val goes right before or after hint
+    iterator insert(const_iterator hint, const value_type& val) {
+        return this->insert_unique(hint, val);
+    }
+
+    iterator insert(const_iterator hint, value_type&& val) {
+        return this->insert_unique(hint, tiny_stl::move(val));
+    }
+
     template <typename InIter>
     void insert(InIter first, InIter last) {
         this->insert_unique(first, last);
@@ -118,6 +135,12 @@ public:
         return this->emplace_unique(tiny_stl::forward<Args>(args)...);
     }
 
+    template <typename... Args>
+    iterator emplace_hint(const_iterator hint, Args&&... args) {
+        return this->emplace_hint_unique(hint,
+                                         tiny_stl::forward<Args>(args)...);
+    }
+
     void swap(set& rhs) {
         Base::swap(rhs);
     }
@@ -186,6 +209,14 @@ public:
         this->insert_equal(first, last);
     }
 
+    // O(n), [first, last) is sorted
+    template <typename InIter>
+    multiset(sorted_equivalent_t, InIter first, InIter last,
+             const Compare& cmp = Compare(), const Alloc& alloc = Alloc())
+        : Base(cmp, alloc) {
+        this->insert_sorted_equal(first, last);
+    }
+
     multiset(const multiset& rhs)
         : Base(rhs, AlTraits::select_on_container_copy_construction(
                         rhs.get_allocator())) {
@@ -235,6 +266,15 @@ public:
         return this->insert_equal(tiny_stl::move(val));
     }
 
+    // O(1) if val goes right before hint
+    iterator insert(const_iterator hint, const value_type& val) {
+        return this->insert_equal(hint, val);
+    }
+
+    iterator insert(const_iterator hint, value_type&& val) {
+        return this->insert_equal(hint, tiny_stl::move(val));
+    }
+
     template <typename InIter>
     void insert(InIter first, InIter last) {
         this->insert_equal(first, last);
@@ -246,7 +286,13 @@ public:
 
     template <typename... Args>
     iterator emplace(Args&&... args) {
-        return this->insert_equal(tiny_stl::forward<Args>(args)...);
+        return this->emplace_equal(tiny_stl::forward<Args>(args)...);
+    }
+
+    template <typename... Args>
+    iterator emplace_hint(const_iterator hint, Args&&... args) {
+        return this->emplace_hint_equal(hint,
+                                        tiny_stl::forward<Args>(args)...);
     }
 
     void swap(multiset& rhs) {
@@ -269,4 +315,14 @@ swap(multiset<Key, Compare, Alloc>& lhs,
     lhs.swap(rhs);
 }
 
+namespace pmr {
+
+template <typename Key, typename Compare = tiny_stl::less<Key>>
+using set = tiny_stl::set<Key, Compare, polymorphic_allocator<Key>>;
+
+template <typename Key, typename Compare = tiny_stl::less<Key>>
+using multiset = tiny_stl::multiset<Key, Compare, polymorphic_allocator<Key>>;
+
+} // namespace pmr
+
 } // namespace tiny_stl
\ No newline at end of file
@@ -0,0 +1,708 @@
+// Copyright (C) 2021 syn1w
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <initializer_list>
+#include <type_traits>
+
+#include "algorithm.hpp"
+#include "vector.hpp"
+
+namespace tiny_stl {
+
+// small_vector, a vector with room for N elements inside the object
+//
+// Up to N elements live in the inline buffer and cost no allocation, the
+// one after them moves all of them to the heap, which then grows as a
+// vector does (VectorBase::capacityGrowth). The heap array is kept when
+// the size drops, shrink_to_fit moves the elements back inline if they
+// fit. An inline small_vector is moved element by element, so a move
+// invalidates its iterators unless is_inline() is false. The delegated
+// constructor small_vector(al) has run when the others may throw, so
+// the destructor cleans up after them.
+template <typename T, size_t N, typename Alloc = allocator<T>>
+class small_vector : public VectorBase<T, Alloc> {
+public:
+    static_assert(N > 0, "small_vector needs an inline capacity");
+    static_assert(tiny_stl::is_same_v<T, typename Alloc::value_type>,
+                  "Alloc::value_type is not the same as T");
+
+public:
+    using value_type = T;
+    using size_type = size_t;
+    using difference_type = ptrdiff_t;
+    using pointer = T*;
+    using const_pointer = const T*;
+    using reference = T&;
+    using const_reference = const T&;
+    using iterator = VectorIterator<T>;
+    using const_iterator = VectorConstIterator<T>;
+    using reverse_iterator = tiny_stl::reverse_iterator<iterator>;
+    using const_reverse_iterator = tiny_stl::reverse_iterator<const_iterator>;
+    using allocator_type = Alloc;
+
+private:
+    using Base = VectorBase<T, Alloc>;
+    using AlTraits = allocator_traits<Alloc>;
+
+    using Base::alloc;
+    using Base::end_of_storage;
+    using Base::first;
+    using Base::last;
+
+    using Base::capacityGrowth;
+    using Base::eraseRange;
+    using Base::relocate;
+
+    std::aligned_union_t<1, T> buffer[N];
+
+private:
+    pointer inlineFirst() noexcept {
+        return reinterpret_cast<pointer>(buffer);
+    }
+
+    const_pointer inlineFirst() const noexcept {
+        return reinterpret_cast<const_pointer>(buffer);
+    }
+
+    void resetInline() noexcept {
+        first = inlineFirst();
+        last = first;
+        end_of_storage = first + N;
+    }
+
+    // destroy the elements and free the heap array, then it is inline
+    void tidy() noexcept {
+        destroyAllocRange(first, last, alloc);
+        if (!is_inline())
+            this->deallocateAux(first, capacity());
+        resetInline();
+    }
+
+    // move the elements to an array of newCapacity, the inline buffer if
+    // they fit, strong exception guarantee
+    void reallocAndInit(size_type newCapacity) {
+        const bool toInline = newCapacity <= N;
+        if (toInline && is_inline())
+            return;
+
+        const pointer newFirst =
+            toInline ? inlineFirst() : this->allocateAux(newCapacity);
+        const size_type oldSize = size();
+        try {
+            relocate(last, newFirst, newFirst + oldSize);
+        } catch (...) {
+            if (!toInline)
+                this->deallocateAux(newFirst, newCapacity);
+            throw;
+        }
+        if (oldSize != 0 && newCapacity > capacity())
+            this->countReallocation(oldSize);
+
+        if (!is_inline())
+            this->deallocateAux(first, capacity());
+
+        first = newFirst;
+        last = newFirst + oldSize;
+        end_of_storage = newFirst + (toInline ? N : newCapacity);
+    }
+
+    // room for newSize elements
+    void growTo(size_type newSize) {
+        if (newSize > capacity()) {
+            if (newSize > max_size())
+                xLength();
+
+            reallocAndInit(capacityGrowth(newSize));
+        }
+    }
+
+    // the element after the last one goes to a new array, args may refer
+    // to an element
+    template <typename... Args>
+    void emplaceBackAux(Args&&... args) {
+        const size_type oldSize = size();
+        if (oldSize == max_size())
+            xLength();
+
+        const size_type newCapacity = capacityGrowth(oldSize + 1);
+        const pointer newFirst = this->allocateAux(newCapacity);
+        try {
+            AlTraits::construct(alloc, newFirst + oldSize,
+                                tiny_stl::forward<Args>(args)...);
+        } catch (...) {
+            this->deallocateAux(newFirst, newCapacity);
+            throw;
+        }
+
+        try {
+            relocate(last, newFirst, newFirst + oldSize);
+        } catch (...) {
+            AlTraits::destroy(alloc, newFirst + oldSize);
+            this->deallocateAux(newFirst, newCapacity);
+            throw;
+        }
+        this->countReallocation(oldSize);
+
+        if (!is_inline())
+            this->deallocateAux(first, capacity());
+
+        first = newFirst;
+        last = newFirst + oldSize + 1;
+        end_of_storage = newFirst + newCapacity;
+    }
+
+    // take the heap array of rhs, or move its elements if they are inline
+    void takeFrom(small_vector& rhs) {
+        if (rhs.is_inline()) {
+            last = uninitializedAllocMove(rhs.first, rhs.last, first, alloc);
+            rhs.clear();
+        } else {
+            first = rhs.first;
+            last = rhs.last;
+            end_of_storage = rhs.end_of_storage;
+            rhs.resetInline();
+        }
+    }
+
+    template <typename InIter>
+    void appendRange(InIter xfirst, InIter xlast, input_iterator_tag) {
+        for (; xfirst != xlast; ++xfirst)
+            emplace_back(*xfirst);
+    }
+
+    template <typename FwdIter>
+    void appendRange(FwdIter xfirst, FwdIter xlast, forward_iterator_tag) {
+        growTo(size() +
+               static_cast<size_type>(tiny_stl::distance(xfirst, xlast)));
+        for (; xfirst != xlast; ++xfirst, ++last)
+            AlTraits::construct(alloc, last, *xfirst);
+    }
+
+    template <typename Fn>
+    void resizeHelper(size_type newSize, Fn append) {
+        const size_type oldSize = size();
+        if (newSize < oldSize) {
+            const pointer newLast = first + newSize;
+            destroyAllocRange(newLast, last, alloc);
+            last = newLast;
+        } else if (newSize > oldSize) {
+            growTo(newSize);
+            last = append(last, newSize - oldSize);
+        }
+    }
+
+public:
+    // (1)
+    small_vector() noexcept(noexcept(Alloc())) : small_vector(Alloc()) {
+    }
+
+    explicit small_vector(const Alloc& al) noexcept : Base(al) {
+        resetInline();
+    }
+
+    // (2)
+    small_vector(size_type count, const T& val, const Alloc& al = Alloc())
+        : small_vector(al) {
+        growTo(count);
+        last = uninitializedAllocFillN(first, count, val, alloc);
+    }
+
+    // (3)
+    explicit small_vector(size_type count, const Alloc& al = Alloc())
+        : small_vector(al) {
+        growTo(count);
+        last = uninitializedAllocDefaultN(first, count, alloc);
+    }
+
+    // (4)
+    template <typename InIter,
+              typename = enable_if_t<is_iterator<InIter>::value>>
+    small_vector(InIter xfirst, InIter xlast, const Alloc& al = Alloc())
+        : small_vector(al) {
+        appendRange(xfirst, xlast,
+                    typename iterator_traits<InIter>::iterator_category{});
+    }
+
+    // (5)
+    small_vector(const small_vector& rhs)
+        : small_vector(rhs.begin(), rhs.end(),
+                       AlTraits::select_on_container_copy_construction(
+                           rhs.alloc)) {
+    }
+
+    small_vector(const small_vector& rhs, const Alloc& al)
+        : small_vector(rhs.begin(), rhs.end(), al) {
+    }
+
+    // (6)
+    small_vector(small_vector&& rhs) noexcept(
+        is_nothrow_move_constructible<T>::value)
+        : small_vector(rhs.alloc) {
+        takeFrom(rhs);
+    }
+
+    // (7)
+    small_vector(std::initializer_list<T> ilist, const Alloc& al = Alloc())
+        : small_vector(ilist.begin(), ilist.end(), al) {
+    }
+
+    ~small_vector() {
+        tidy();
+        this->first = pointer(); // nothing for ~VectorBase() to free
+    }
+
+    small_vector& operator=(const small_vector& rhs) {
+        if (this != tiny_stl::addressof(rhs)) {
+            if (AlTraits::propagate_on_container_copy_assignment::value) {
+                if (alloc != rhs.alloc)
+                    tidy();
+                alloc = rhs.alloc;
+            }
+            assign(rhs.begin(), rhs.end());
+        }
+
+        return *this;
+    }
+
+    small_vector& operator=(small_vector&& rhs) noexcept(
+        is_nothrow_move_constructible<T>::value &&
+        (AlTraits::propagate_on_container_move_assignment::value ||
+         AlTraits::is_always_equal::value)) {
+        if (this == tiny_stl::addressof(rhs))
+            return *this;
+
+        if (AlTraits::propagate_on_container_move_assignment::value ||
+            alloc == rhs.alloc) {
+            tidy();
+            if (AlTraits::propagate_on_container_move_assignment::value)
+                alloc = rhs.alloc;
+            takeFrom(rhs);
+        } else {
+            assign(tiny_stl::make_move_iterator(rhs.begin()),
+                   tiny_stl::make_move_iterator(rhs.end()));
+            rhs.clear();
+        }
+
+        return *this;
+    }
+
+    small_vector& operator=(std::initializer_list<T> ilist) {
+        assign(ilist.begin(), ilist.end());
+        return *this;
+    }
+
+    void assign(size_type count, const T& val) {
+        clear();
+        resize(count, val);
+    }
+
+    template <typename InIter,
+              typename = enable_if_t<is_iterator<InIter>::value>>
+    void assign(InIter xfirst, InIter xlast) {
+        clear();
+        appendRange(xfirst, xlast,
+                    typename iterator_traits<InIter>::iterator_category{});
+    }
+
+    void assign(std::initializer_list<T> ilist) {
+        assign(ilist.begin(), ilist.end());
+    }
+
+    allocator_type get_allocator() const {
+        return static_cast<allocator_type>(alloc);
+    }
+
+    T& at(size_type pos) {
+        if (pos >= size())
+            xRange();
+
+        return first[pos];
+    }
+
+    const T& at(size_type pos) const {
+        if (pos >= size())
+            xRange();
+
+        return first[pos];
+    }
+
+    T& operator[](size_type pos) {
+        assert(pos < size());
+        return first[pos];
+    }
+
+    const T& operator[](size_type pos) const {
+        assert(pos < size());
+        return first[pos];
+    }
+
+    T& front() {
+        assert(!empty());
+        return *first;
+    }
+
+    const T& front() const {
+        assert(!empty());
+        return *first;
+    }
+
+    T& back() {
+        assert(!empty());
+        return last[-1];
+    }
+
+    const T& back() const {
+        assert(!empty());
+        return last[-1];
+    }
+
+    T* data() noexcept {
+        return first;
+    }
+
+    const T* data() const noexcept {
+        return first;
+    }
+
+    iterator begin() noexcept {
+        return iterator(first);
+    }
+
+    const_iterator begin() const noexcept {
+        return const_iterator(first);
+    }
+
+    const_iterator cbegin() const noexcept {
+        return begin();
+    }
+
+    iterator end() noexcept {
+        return iterator(last);
+    }
+
+    const_iterator end() const noexcept {
+        return const_iterator(last);
+    }
+
+    const_iterator cend() const noexcept {
+        return end();
+    }
+
+    reverse_iterator rbegin() noexcept {
+        return reverse_iterator(end());
+    }
+
+    const_reverse_iterator rbegin() const noexcept {
+        return const_reverse_iterator(end());
+    }
+
+    const_reverse_iterator crbegin() const noexcept {
+        return rbegin();
+    }
+
+    reverse_iterator rend() noexcept {
+        return reverse_iterator(begin());
+    }
+
+    const_reverse_iterator rend() const noexcept {
+        return const_reverse_iterator(begin());
+    }
+
+    const_reverse_iterator crend() const noexcept {
+        return rend();
+    }
+
+    bool empty() const noexcept {
+        return first == last;
+    }
+
+    size_type size() const noexcept {
+        return static_cast<size_type>(last - first);
+    }
+
+    size_type max_size() const noexcept {
+        return Base::maxSize();
+    }
+
+    size_type capacity() const noexcept {
+        return static_cast<size_type>(end_of_storage - first);
+    }
+
+    // whether the elements are in the inline buffer
+    bool is_inline() const noexcept {
+        return first == inlineFirst();
+    }
+
+    static constexpr size_type inline_capacity() noexcept {
+        return N;
+    }
+
+    void reserve(size_type newCapacity) {
+        if (newCapacity > capacity()) {
+            if (newCapacity > max_size())
+                xLength();
+
+            reallocAndInit(newCapacity);
+        }
+    }
+
+    void shrink_to_fit() {
+        if (!is_inline() && size() < capacity())
+            reallocAndInit(size());
+    }
+
+    void clear() noexcept {
+        destroyAllocRange(first, last, alloc);
+        last = first;
+    }
+
+    template <typename... Args>
+    void emplace_back(Args&&... args) {
+        if (last != end_of_storage) {
+            AlTraits::construct(alloc, last, tiny_stl::forward<Args>(args)...);
+            ++last;
+        } else {
+            emplaceBackAux(tiny_stl::forward<Args>(args)...);
+        }
+    }
+
+    void push_back(const T& val) {
+        emplace_back(val);
+    }
+
+    void push_back(T&& val) {
+        emplace_back(tiny_stl::move(val));
+    }
+
+    void pop_back() {
+        assert(!empty());
+        AlTraits::destroy(alloc, --last);
+    }
+
+    // the new elements are appended and rotated into place
+    template <typename... Args>
+    iterator emplace(const_iterator pos, Args&&... args) {
+        assert(pos.ptr >= first && pos.ptr <= last);
+        const size_type offset = pos.ptr - first;
+        if (pos.ptr == last) {
+            emplace_back(tiny_stl::forward<Args>(args)...);
+        } else {
+            T obj(tiny_stl::forward<Args>(args)...); // args may be in *this
+            emplace_back(tiny_stl::move(obj));
+            tiny_stl::rotate(first + offset, last - 1, last);
+        }
+
+        return begin() + offset;
+    }
+
+    iterator insert(const_iterator pos, const T& val) {
+        return emplace(pos, val);
+    }
+
+    iterator insert(const_iterator pos, T&& val) {
+        return emplace(pos, tiny_stl::move(val));
+    }
+
+    iterator insert(const_iterator pos, size_type count, const T& val) {
+        assert(pos.ptr >= first && pos.ptr <= last);
+        const size_type offset = pos.ptr - first;
+        const size_type oldSize = size();
+        if (oldSize + count > capacity()) {
+            const T copy(val); // val may be in *this
+            growTo(oldSize + count);
+            last = uninitializedAllocFillN(last, count, copy, alloc);
+        } else {
+            last = uninitializedAllocFillN(last, count, val, alloc);
+        }
+        tiny_stl::rotate(first + offset, first + oldSize, last);
+
+        return begin() + offset;
+    }
+
+    template <typename InIter,
+              typename = enable_if_t<is_iterator<InIter>::value>>
+    iterator insert(const_iterator pos, InIter xfirst, InIter xlast) {
+        assert(pos.ptr >= first && pos.ptr <= last);
+        const size_type offset = pos.ptr - first;
+        const size_type oldSize = size();
+        appendRange(xfirst, xlast,
+                    typename iterator_traits<InIter>::iterator_category{});
+        tiny_stl::rotate(first + offset, first + oldSize, last);
+
+        return begin() + offset;
+    }
+
+    iterator insert(const_iterator pos, std::initializer_list<T> ilist) {
+        return insert(pos, ilist.begin(), ilist.end());
+    }
+
+    iterator erase(const_iterator pos) {
+        assert(pos.ptr >= first && pos.ptr < last);
+        return erase(pos, pos + 1);
+    }
+
+    iterator erase(const_iterator xfirst, const_iterator xlast) {
+        assert(xfirst.ptr >= first && xfirst.ptr <= xlast.ptr &&
+               xlast.ptr <= last);
+        const pointer dst = const_cast<pointer>(xfirst.ptr);
+        if (xfirst != xlast)
+            last = eraseRange(dst, const_cast<pointer>(xlast.ptr));
+
+        return iterator(dst);
+    }
+
+    void resize(size_type newSize) {
+        resizeHelper(newSize, [this](pointer dst, size_type n) {
+            return uninitializedAllocDefaultN(dst, n, alloc);
+        });
+    }
+
+    void resize(size_type newSize, const T& val) {
+        if (newSize > capacity()) {
+            const T copy(val); // val may be in *this
+            resizeHelper(newSize, [this, &copy](pointer dst, size_type n) {
+                return uninitializedAllocFillN(dst, n, copy, alloc);
+            });
+        } else {
+            resizeHelper(newSize, [this, &val](pointer dst, size_type n) {
+                return uninitializedAllocFillN(dst, n, val, alloc);
+            });
+        }
+    }
+
+    // heap arrays are exchanged, inline elements are moved
+    void swap(small_vector& rhs) {
+        if (!is_inline() && !rhs.is_inline()) {
+            swapAlloc(alloc, rhs.alloc);
+            tiny_stl::swap(first, rhs.first);
+            tiny_stl::swap(last, rhs.last);
+            tiny_stl::swap(end_of_storage, rhs.end_of_storage);
+            return;
+        }
+
+        small_vector tmp(tiny_stl::move(rhs));
+        rhs = tiny_stl::move(*this);
+        *this = tiny_stl::move(tmp);
+    }
+
+    vector_stats stats() const noexcept {
+        return this->growthStats(size(), capacity());
+    }
+
+private:
+    [[noreturn]] static void xLength() {
+        throw "small_vector<T, N> too long";
+    }
+
+    [[noreturn]] static void xRange() {
+        throw "invalid small_vector<T, N> subscript";
+    }
+}; // class small_vector<T, N>
+
+template <typename T, size_t N, typename Alloc>
+inline bool operator==(const small_vector<T, N, Alloc>& lhs,
+                       const small_vector<T, N, Alloc>& rhs) {
+    return lhs.size() == rhs.size() &&
+           tiny_stl::equal(lhs.begin(), lhs.end(), rhs.begin());
+}
+
+template <typename T, size_t N, typename Alloc>
+inline bool operator!=(const small_vector<T, N, Alloc>& lhs,
+                       const small_vector<T, N, Alloc>& rhs) {
+    return !(lhs == rhs);
+}
+
+template <typename T, size_t N, typename Alloc>
+inline bool operator<(const small_vector<T, N, Alloc>& lhs,
+                      const small_vector<T, N, Alloc>& rhs) {
+    return tiny_stl::lexicographical_compare(lhs.begin(), lhs.end(),
+                                             rhs.begin(), rhs.end());
+}
+
+template <typename T, size_t N, typename Alloc>
+inline bool operator<=(const small_vector<T, N, Alloc>& lhs,
+                       const small_vector<T, N, Alloc>& rhs) {
+    return !(rhs < lhs);
+}
+
+template <typename T, size_t N, typename Alloc>
+inline bool operator>(const small_vector<T, N, Alloc>& lhs,
+                      const small_vector<T, N, Alloc>& rhs) {
+    return rhs < lhs;
+}
+
+template <typename T, size_t N, typename Alloc>
+inline bool operator>=(const small_vector<T, N, Alloc>& lhs,
+                       const small_vector<T, N, Alloc>& rhs) {
+    return !(lhs < rhs);
+}
+
+template <typename T, size_t N, typename Alloc>
+inline void swap(small_vector<T, N, Alloc>& lhs,
+                 small_vector<T, N, Alloc>& rhs) {
+    lhs.swap(rhs);
+}
+
+namespace {
+
+// the allocator of static_vector, it has no memory to give
+template <typename T>
+class StaticVectorAlloc : public allocator<T> {
+public:
+    template <typename U>
+    struct rebind {
+        using other = StaticVectorAlloc<U>;
+    };
+
+    StaticVectorAlloc() noexcept {
+    }
+
+    template <typename U>
+    StaticVectorAlloc(const StaticVectorAlloc<U>&) noexcept {
+    }
+
+    T* allocate(size_t) {
+        throw "static_vector<T, N> is full";
+    }
+
+    void deallocate(T*, size_t) noexcept {
+    }
+};
+
+} // namespace
+
+// static_vector, at most N elements inside the object, it never
+// allocates and growing past N throws
+template <typename T, size_t N>
+class static_vector : public small_vector<T, N, StaticVectorAlloc<T>> {
+private:
+    using Base = small_vector<T, N, StaticVectorAlloc<T>>;
+
+public:
+    using size_type = typename Base::size_type;
+
+    using Base::Base;
+
+    static_vector() noexcept : Base() {
+    }
+
+    size_type max_size() const noexcept {
+        return N;
+    }
+
+    // the elements stay inline
+    void shrink_to_fit() noexcept {
+    }
+}; // class static_vector<T, N>
+
+namespace pmr {
+
+template <typename T, size_t N>
+using small_vector = tiny_stl::small_vector<T, N, polymorphic_allocator<T>>;
+
+} // namespace pmr
+
+} // namespace tiny_stl
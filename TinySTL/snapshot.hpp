@@ -0,0 +1,908 @@
+// Copyright (C) 2021 syn1w
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "flat_hashtable.hpp"
+#include "flat_map.hpp"
+#include "vector.hpp"
+
+namespace tiny_stl {
+
+// Memory-mapped snapshots of vector, flat_map and the flat hash tables
+//
+// write_snapshot() writes a container whose elements are trivially
+// copyable to a file in one pass. mapped_vector, mapped_flat_map,
+// mapped_unordered_map and mapped_unordered_set map the file read-only
+// and look up directly in the mapped pages, so opening one is O(1) and
+// the pages are shared through the page cache by every process mapping
+// the same file.
+//
+//   | header | pad | section 0 | pad | section 1 |
+//
+// vector:     section 0 holds the elements
+// flat_map:   section 0 holds the keys, section 1 the mapped values
+// flat hash:  section 0 holds the capacity + 1 control bytes, section 1
+//             the slots, the slots which aren't full are zeroed
+//
+// The sections are offsets from the start of the file, aligned to
+// kSnapshotAlign, nothing in the file is a pointer. The header records
+// the byte order, the element sizes and alignments and the probing of
+// the table, the open throws if any of them differs from the reader.
+// Compare and Hash must order and hash like the ones of the writer, the
+// open checks Hash against a sample of the slots.
+
+static const char kSnapshotMagic[8] = {'T', 'S', 'T', 'L',
+                                       'S', 'N', 'A', 'P'};
+static const uint32_t kSnapshotVersion = 1;
+static const uint32_t kSnapshotByteOrder = 0x01020304;
+static const size_t kSnapshotAlign = 64;
+static const size_t kSnapshotHashSamples = 64;
+
+enum SnapshotKind : uint32_t {
+    kSnapshotVector = 1,
+    kSnapshotFlatMap = 2,
+    kSnapshotFlatHashMap = 3,
+    kSnapshotFlatHashSet = 4
+};
+
+struct SnapshotHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t kind;
+    uint32_t byteOrder;
+    uint32_t groupWidth; // kFlatGroupWidth, 0 if not a hash table
+    uint32_t probe;      // Probe::step(1), ..., step(4), a byte each
+    uint32_t elemSize[2];
+    uint32_t elemAlign[2];
+    uint64_t size;
+    uint64_t capacity;
+    uint64_t offset[2];
+    uint64_t bytes[2];
+    uint64_t fileSize;
+};
+
+// read-only shared mapping of a whole file
+class mapped_file {
+private:
+    const unsigned char* mData;
+    size_t mSize;
+#ifdef _WIN32
+    HANDLE mFile;
+    HANDLE mMapping;
+#endif
+
+    void reset() noexcept {
+        mData = nullptr;
+        mSize = 0;
+#ifdef _WIN32
+        mFile = INVALID_HANDLE_VALUE;
+        mMapping = nullptr;
+#endif
+    }
+
+    void moveFrom(mapped_file& rhs) noexcept {
+        mData = rhs.mData;
+        mSize = rhs.mSize;
+#ifdef _WIN32
+        mFile = rhs.mFile;
+        mMapping = rhs.mMapping;
+#endif
+        rhs.reset();
+    }
+
+public:
+    mapped_file() noexcept {
+        reset();
+    }
+
+    explicit mapped_file(const char* path) {
+        reset();
+#ifdef _WIN32
+        mFile = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr,
+                            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (mFile == INVALID_HANDLE_VALUE)
+            throw "mapped_file: cannot open the file";
+        LARGE_INTEGER bytes;
+        if (!GetFileSizeEx(mFile, &bytes)) {
+            close();
+            throw "mapped_file: cannot stat the file";
+        }
+        mSize = static_cast<size_t>(bytes.QuadPart);
+        if (mSize == 0)
+            return;
+        mMapping =
+            CreateFileMappingA(mFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mMapping == nullptr) {
+            close();
+            throw "mapped_file: cannot map the file";
+        }
+        mData = static_cast<const unsigned char*>(
+            MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0));
+        if (mData == nullptr) {
+            close();
+            throw "mapped_file: cannot map the file";
+        }
+#else
+        const int fd = ::open(path, O_RDONLY);
+        if (fd < 0)
+            throw "mapped_file: cannot open the file";
+        struct stat st;
+        if (::fstat(fd, &st) != 0) {
+            ::close(fd);
+            throw "mapped_file: cannot stat the file";
+        }
+        mSize = static_cast<size_t>(st.st_size);
+        if (mSize == 0) {
+            ::close(fd);
+            return;
+        }
+        // the mapping keeps the file, the descriptor isn't needed
+        void* p = ::mmap(nullptr, mSize, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (p == MAP_FAILED) {
+            mSize = 0;
+            throw "mapped_file: cannot map the file";
+        }
+        mData = static_cast<const unsigned char*>(p);
+#endif
+    }
+
+    mapped_file(const mapped_file&) = delete;
+    mapped_file& operator=(const mapped_file&) = delete;
+
+    mapped_file(mapped_file&& rhs) noexcept {
+        moveFrom(rhs);
+    }
+
+    mapped_file& operator=(mapped_file&& rhs) noexcept {
+        if (this != &rhs) {
+            close();
+            moveFrom(rhs);
+        }
+        return *this;
+    }
+
+    ~mapped_file() {
+        close();
+    }
+
+    void close() noexcept {
+#ifdef _WIN32
+        if (mData != nullptr)
+            UnmapViewOfFile(mData);
+        if (mMapping != nullptr)
+            CloseHandle(mMapping);
+        if (mFile != INVALID_HANDLE_VALUE)
+            CloseHandle(mFile);
+#else
+        if (mData != nullptr)
+            ::munmap(const_cast<unsigned char*>(mData), mSize);
+#endif
+        reset();
+    }
+
+    // page aligned, nullptr if the file is empty
+    const unsigned char* data() const noexcept {
+        return mData;
+    }
+
+    size_t size() const noexcept {
+        return mSize;
+    }
+};
+
+template <typename Probe>
+inline uint32_t snapshotProbe() noexcept {
+    uint32_t fingerprint = 0;
+    for (size_t i = 1; i <= 4; ++i)
+        fingerprint = (fingerprint << 8) | (Probe::step(i) & 0xFF);
+    return fingerprint;
+}
+
+inline uint64_t snapshotAlignUp(uint64_t n) noexcept {
+    const uint64_t mask = kSnapshotAlign - 1;
+    return (n + mask) & ~mask;
+}
+
+// pair has its own assignments, but it copies member by member
+template <typename T>
+struct IsSnapshotElement : is_trivially_copyable<T> {};
+
+template <typename T1, typename T2>
+struct IsSnapshotElement<pair<T1, T2>>
+    : bool_constant<is_trivially_copyable<T1>::value &&
+                    is_trivially_copyable<T2>::value> {};
+
+template <typename T>
+inline void snapshotCheckElement() {
+    static_assert(IsSnapshotElement<T>::value,
+                  "the elements of a snapshot must be trivially copyable");
+    static_assert(alignof(T) <= kSnapshotAlign,
+                  "the elements of a snapshot are aligned to kSnapshotAlign");
+}
+
+// the header which every write_snapshot() fills and every view checks,
+// the sections follow in order
+template <typename T0, typename T1>
+inline SnapshotHeader makeSnapshotHeader(SnapshotKind kind, size_t size,
+                                         size_t capacity, uint64_t bytes0,
+                                         uint64_t bytes1) noexcept {
+    SnapshotHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, kSnapshotMagic, sizeof(h.magic));
+    h.version = kSnapshotVersion;
+    h.kind = kind;
+    h.byteOrder = kSnapshotByteOrder;
+    h.elemSize[0] = static_cast<uint32_t>(sizeof(T0));
+    h.elemSize[1] = static_cast<uint32_t>(sizeof(T1));
+    h.elemAlign[0] = static_cast<uint32_t>(alignof(T0));
+    h.elemAlign[1] = static_cast<uint32_t>(alignof(T1));
+    h.size = size;
+    h.capacity = capacity;
+    h.offset[0] = snapshotAlignUp(sizeof(SnapshotHeader));
+    h.bytes[0] = bytes0;
+    h.offset[1] = snapshotAlignUp(h.offset[0] + bytes0);
+    h.bytes[1] = bytes1;
+    h.fileSize = h.offset[1] + bytes1;
+    return h;
+}
+
+// one pass sequential writer, the file is closed on any exit
+class SnapshotWriter {
+private:
+    std::FILE* file;
+    uint64_t written;
+
+public:
+    explicit SnapshotWriter(const char* path)
+        : file(std::fopen(path, "wb")), written(0) {
+        if (file == nullptr)
+            throw "write_snapshot: cannot open the file";
+    }
+
+    SnapshotWriter(const SnapshotWriter&) = delete;
+    SnapshotWriter& operator=(const SnapshotWriter&) = delete;
+
+    ~SnapshotWriter() {
+        if (file != nullptr)
+            std::fclose(file);
+    }
+
+    void write(const void* p, size_t n) {
+        if (n != 0 && std::fwrite(p, 1, n, file) != n)
+            throw "write_snapshot: cannot write the file";
+        written += n;
+    }
+
+    // zeros up to offset
+    void padTo(uint64_t offset) {
+        static const unsigned char zeros[kSnapshotAlign] = {};
+        while (written < offset) {
+            const uint64_t n = offset - written;
+            write(zeros, n < kSnapshotAlign ? static_cast<size_t>(n)
+                                            : kSnapshotAlign);
+        }
+    }
+
+    // pads an empty last section, then flushes
+    void finish(const SnapshotHeader& h) {
+        padTo(h.fileSize);
+        const int err = std::fclose(file);
+        file = nullptr;
+        if (err != 0)
+            throw "write_snapshot: cannot write the file";
+    }
+};
+
+template <typename T, typename Alloc>
+void write_snapshot(const char* path, const vector<T, Alloc>& v) {
+    snapshotCheckElement<T>();
+    const SnapshotHeader h = makeSnapshotHeader<T, char>(
+        kSnapshotVector, v.size(), v.size(), v.size() * sizeof(T), 0);
+
+    SnapshotWriter out(path);
+    out.write(&h, sizeof(h));
+    out.padTo(h.offset[0]);
+    out.write(v.data(), v.size() * sizeof(T));
+    out.finish(h);
+}
+
+template <typename Key, typename T, typename Compare, typename KeyAlloc,
+          typename MappedAlloc>
+void write_snapshot(
+    const char* path,
+    const flat_map<Key, T, Compare, vector<Key, KeyAlloc>,
+                   vector<T, MappedAlloc>>& m) {
+    snapshotCheckElement<Key>();
+    snapshotCheckElement<T>();
+    const size_t n = m.size();
+    const SnapshotHeader h = makeSnapshotHeader<Key, T>(
+        kSnapshotFlatMap, n, n, n * sizeof(Key), n * sizeof(T));
+
+    SnapshotWriter out(path);
+    out.write(&h, sizeof(h));
+    out.padTo(h.offset[0]);
+    out.write(m.keys().data(), n * sizeof(Key));
+    out.padTo(h.offset[1]);
+    out.write(m.values().data(), n * sizeof(T));
+    out.finish(h);
+}
+
+// reads the private storage of FlatHashTable, the table is written with
+// its capacity and layout so the reader probes the same groups
+struct FlatHashSnapshot {
+    template <typename T, typename Hash, typename KeyEqual, typename Alloc,
+              bool isMap, typename Probe>
+    static void
+    write(const char* path,
+          const FlatHashTable<T, Hash, KeyEqual, Alloc, isMap, Probe>& tb) {
+        snapshotCheckElement<T>();
+        const size_t cap = tb.capacity;
+        SnapshotHeader h = makeSnapshotHeader<FlatCtrl, T>(
+            isMap ? kSnapshotFlatHashMap : kSnapshotFlatHashSet,
+            tb.num_elements, cap, cap == 0 ? 0 : cap + 1, cap * sizeof(T));
+        h.groupWidth = static_cast<uint32_t>(kFlatGroupWidth);
+        h.probe = snapshotProbe<Probe>();
+
+        SnapshotWriter out(path);
+        out.write(&h, sizeof(h));
+        out.padTo(h.offset[0]);
+        if (cap != 0)
+            out.write(tb.ctrl, cap + 1);
+        out.padTo(h.offset[1]);
+        // the runs of full slots as they are, the others as zeros
+        size_t i = 0;
+        while (i != cap) {
+            size_t j = i;
+            if (flatIsFull(tb.ctrl[i])) {
+                while (j != cap && flatIsFull(tb.ctrl[j]))
+                    ++j;
+                out.write(tb.slots + i, (j - i) * sizeof(T));
+            } else {
+                while (j != cap && !flatIsFull(tb.ctrl[j]))
+                    ++j;
+                out.padTo(h.offset[1] + j * sizeof(T));
+            }
+            i = j;
+        }
+        out.finish(h);
+    }
+};
+
+// unordered_map and unordered_set with flat_hashing
+template <typename T, typename Hash, typename KeyEqual, typename Alloc,
+          bool isMap, typename Probe>
+void write_snapshot(
+    const char* path,
+    const FlatHashTable<T, Hash, KeyEqual, Alloc, isMap, Probe>& tb) {
+    FlatHashSnapshot::write(path, tb);
+}
+
+// the checks every view runs on open, the sections are in the file and
+// hold the elements of the reader
+template <typename T0, typename T1>
+inline const SnapshotHeader& checkSnapshot(const mapped_file& file,
+                                           SnapshotKind kind) {
+    if (file.size() < sizeof(SnapshotHeader))
+        throw "snapshot: the file is too short";
+    const SnapshotHeader& h =
+        *reinterpret_cast<const SnapshotHeader*>(file.data());
+    if (memcmp(h.magic, kSnapshotMagic, sizeof(h.magic)) != 0)
+        throw "snapshot: not a snapshot";
+    if (h.version != kSnapshotVersion)
+        throw "snapshot: unknown version";
+    if (h.byteOrder != kSnapshotByteOrder)
+        throw "snapshot: the byte order differs";
+    if (h.kind != kind)
+        throw "snapshot: the container differs";
+    if (h.elemSize[0] != sizeof(T0) || h.elemSize[1] != sizeof(T1) ||
+        h.elemAlign[0] != alignof(T0) || h.elemAlign[1] != alignof(T1))
+        throw "snapshot: the element layout differs";
+    if (h.fileSize != file.size())
+        throw "snapshot: the file is truncated";
+    if (static_cast<size_t>(h.size) != h.size ||
+        static_cast<size_t>(h.capacity) != h.capacity)
+        throw "snapshot: the container is too large";
+    for (size_t i = 0; i != 2; ++i) {
+        if (h.offset[i] % kSnapshotAlign != 0 || h.offset[i] > h.fileSize ||
+            h.bytes[i] > h.fileSize - h.offset[i])
+            throw "snapshot: a section is out of the file";
+    }
+    return h;
+}
+
+template <typename T>
+inline const T* snapshotSection(const mapped_file& file,
+                                const SnapshotHeader& h, size_t i) noexcept {
+    return reinterpret_cast<const T*>(file.data() + h.offset[i]);
+}
+
+// section i holds count elements of T, checked by division since count
+// comes from the file and count * sizeof(T) may wrap
+template <typename T>
+inline bool snapshotHolds(const SnapshotHeader& h, size_t i,
+                          uint64_t count) noexcept {
+    return h.bytes[i] % sizeof(T) == 0 && h.bytes[i] / sizeof(T) == count;
+}
+
+template <typename T>
+class mapped_vector {
+public:
+    using value_type = T;
+    using size_type = size_t;
+    using difference_type = ptrdiff_t;
+    using reference = const T&;
+    using const_reference = const T&;
+    using pointer = const T*;
+    using const_pointer = const T*;
+    using iterator = const T*;
+    using const_iterator = const T*;
+
+private:
+    mapped_file file;
+    const T* first;
+    size_type num_elements;
+
+public:
+    explicit mapped_vector(const char* path) : file(path) {
+        snapshotCheckElement<T>();
+        const SnapshotHeader& h = checkSnapshot<T, char>(file, kSnapshotVector);
+        if (!snapshotHolds<T>(h, 0, h.size))
+            throw "snapshot: a section is out of the file";
+        first = snapshotSection<T>(file, h, 0);
+        num_elements = static_cast<size_type>(h.size);
+    }
+
+    mapped_vector(mapped_vector&&) = default;
+    mapped_vector& operator=(mapped_vector&&) = default;
+
+    const_iterator begin() const noexcept {
+        return first;
+    }
+
+    const_iterator end() const noexcept {
+        return first + num_elements;
+    }
+
+    const_iterator cbegin() const noexcept {
+        return begin();
+    }
+
+    const_iterator cend() const noexcept {
+        return end();
+    }
+
+    size_type size() const noexcept {
+        return num_elements;
+    }
+
+    bool empty() const noexcept {
+        return num_elements == 0;
+    }
+
+    const T* data() const noexcept {
+        return first;
+    }
+
+    const_reference operator[](size_type pos) const {
+        assert(pos < num_elements);
+        return first[pos];
+    }
+
+    const_reference at(size_type pos) const {
+        if (pos >= num_elements)
+            throw "invalid mapped_vector<T> subscript";
+        return first[pos];
+    }
+
+    const_reference front() const {
+        assert(num_elements != 0);
+        return first[0];
+    }
+
+    const_reference back() const {
+        assert(num_elements != 0);
+        return first[num_elements - 1];
+    }
+}; // class mapped_vector<T>
+
+// Compare must order the keys like the Compare of the written flat_map
+template <typename Key, typename T, typename Compare = less<Key>>
+class mapped_flat_map {
+public:
+    using key_type = Key;
+    using mapped_type = T;
+    using value_type = pair<Key, T>;
+    using key_compare = Compare;
+    using size_type = size_t;
+    using difference_type = ptrdiff_t;
+    using const_reference = pair<const Key&, const T&>;
+    using reference = const_reference;
+    using const_iterator = FlatMapIterator<Key, const Key*, const T*>;
+    using iterator = const_iterator;
+
+private:
+    mapped_file file;
+    const Key* keyFirst;
+    const T* valueFirst;
+    size_type num_elements;
+    Compare compare;
+
+    const_iterator makeIter(size_type i) const noexcept {
+        return const_iterator(keyFirst + i, valueFirst + i);
+    }
+
+    template <typename K>
+    size_type lowerIndex(const K& key) const {
+        return tiny_stl::lower_bound(keyFirst, keyFirst + num_elements, key,
+                                     this->compare) -
+               keyFirst;
+    }
+
+    template <typename K>
+    size_type upperIndex(const K& key) const {
+        return tiny_stl::upper_bound(keyFirst, keyFirst + num_elements, key,
+                                     this->compare) -
+               keyFirst;
+    }
+
+    template <typename K>
+    size_type findIndex(const K& key) const {
+        const size_type i = lowerIndex(key);
+        return i == num_elements || this->compare(key, keyFirst[i])
+                   ? num_elements
+                   : i;
+    }
+
+public:
+    explicit mapped_flat_map(const char* path, const Compare& cmp = Compare())
+        : file(path), compare(cmp) {
+        snapshotCheckElement<Key>();
+        snapshotCheckElement<T>();
+        const SnapshotHeader& h = checkSnapshot<Key, T>(file, kSnapshotFlatMap);
+        if (!snapshotHolds<Key>(h, 0, h.size) ||
+            !snapshotHolds<T>(h, 1, h.size))
+            throw "snapshot: a section is out of the file";
+        keyFirst = snapshotSection<Key>(file, h, 0);
+        valueFirst = snapshotSection<T>(file, h, 1);
+        num_elements = static_cast<size_type>(h.size);
+    }
+
+    mapped_flat_map(mapped_flat_map&&) = default;
+    mapped_flat_map& operator=(mapped_flat_map&&) = default;
+
+    const_iterator begin() const noexcept {
+        return makeIter(0);
+    }
+
+    const_iterator end() const noexcept {
+        return makeIter(num_elements);
+    }
+
+    const_iterator cbegin() const noexcept {
+        return begin();
+    }
+
+    const_iterator cend() const noexcept {
+        return end();
+    }
+
+    size_type size() const noexcept {
+        return num_elements;
+    }
+
+    bool empty() const noexcept {
+        return num_elements == 0;
+    }
+
+    // sorted, unique keys
+    const Key* keys() const noexcept {
+        return keyFirst;
+    }
+
+    const T* values() const noexcept {
+        return valueFirst;
+    }
+
+    const T& at(const key_type& key) const {
+        const size_type i = findIndex(key);
+        if (i == num_elements)
+            throw "mapped_flat_map<Key, T>, key is not exist";
+        return valueFirst[i];
+    }
+
+    key_compare key_comp() const {
+        return this->compare;
+    }
+
+    const_iterator find(const key_type& key) const {
+        return makeIter(findIndex(key));
+    }
+
+    template <typename K, typename Cmp = Compare,
+              typename = typename Cmp::is_transparent>
+    const_iterator find(const K& key) const {
+        return makeIter(findIndex(key));
+    }
+
+    size_type count(const key_type& key) const {
+        return findIndex(key) != num_elements;
+    }
+
+    bool contains(const key_type& key) const {
+        return findIndex(key) != num_elements;
+    }
+
+    const_iterator lower_bound(const key_type& key) const {
+        return makeIter(lowerIndex(key));
+    }
+
+    const_iterator upper_bound(const key_type& key) const {
+        return makeIter(upperIndex(key));
+    }
+
+    pair<const_iterator, const_iterator>
+    equal_range(const key_type& key) const {
+        const size_type i = lowerIndex(key);
+        const size_type j =
+            i + (i < num_elements && !this->compare(key, keyFirst[i]));
+        return {makeIter(i), makeIter(j)};
+    }
+}; // class mapped_flat_map<Key, T, Compare>
+
+// the lookups of FlatHashTable over the mapped control bytes and slots,
+// Hash and KeyEqual must hash and compare like the ones of the writer
+template <typename T, typename Hash, typename KeyEqual, bool isMap,
+          typename Probe>
+class MappedFlatHashTable {
+public:
+    using key_type = typename AssociatedTypeHelper<T, isMap>::key_type;
+    using mapped_type = typename AssociatedTypeHelper<T, isMap>::mapped_type;
+    using value_type = T;
+    using size_type = size_t;
+    using difference_type = ptrdiff_t;
+    using hasher = Hash;
+    using key_equal = KeyEqual;
+    using reference = const T&;
+    using const_reference = const T&;
+    using const_iterator = FlatHashConstIterator<T, const MappedFlatHashTable>;
+    using iterator = const_iterator;
+
+private:
+    using ProbeSeq = FlatProbeSeq<Probe>;
+
+    mapped_file file;
+    const FlatCtrl* ctrl;
+    T* slots; // the iterators take T*, nothing writes through it
+    size_type capacity;
+    size_type num_elements;
+    hasher hashfunc;
+    key_equal key_equ;
+
+private:
+    // map
+    const key_type& getKey(const T& val, true_type) const {
+        return val.first;
+    }
+
+    // set
+    const key_type& getKey(const T& val, false_type) const {
+        return val;
+    }
+
+    const key_type& get_key(const T& val) const {
+        return getKey(val, tiny_stl::bool_constant<isMap>{});
+    }
+
+    // FlatHashTable::findAux
+    size_type findAux(const key_type& key, size_t hash) const {
+        if (capacity == 0)
+            return capacity;
+
+        const FlatCtrl h2 = flatH2(hash);
+        ProbeSeq seq(flatH1(hash), capacity);
+        for (;;) {
+            const FlatGroup group(ctrl + seq.offset());
+            for (auto mask = group.match(h2); mask; ++mask) {
+                const size_type pos = seq.offset(mask.lowest());
+                if (key_equ(get_key(slots[pos]), key))
+                    return pos;
+            }
+            if (group.maskEmpty())
+                return capacity;
+            seq.next();
+        }
+    }
+
+    const_iterator makeIter(size_type pos) const noexcept {
+        return const_iterator(ctrl + pos, slots + pos);
+    }
+
+    // the control bytes hold a table of the reader: size full bytes and
+    // an empty one which ends every probe, and the first full slots hash
+    // to their h2 like they did for the writer
+    void checkTable(const SnapshotHeader& h) {
+        if (h.groupWidth != kFlatGroupWidth)
+            throw "snapshot: the group width differs";
+        if (h.probe != snapshotProbe<Probe>())
+            throw "snapshot: the probing differs";
+        const uint64_t cap = h.capacity;
+        if (cap == 0) {
+            if (h.size != 0 || h.bytes[0] != 0 || h.bytes[1] != 0)
+                throw "snapshot: the table is corrupt";
+            return;
+        }
+        if ((cap & (cap - 1)) != 0 || cap % kFlatGroupWidth != 0 ||
+            h.size >= cap || h.bytes[0] != cap + 1 ||
+            !snapshotHolds<T>(h, 1, cap))
+            throw "snapshot: the table is corrupt";
+        const FlatCtrl* c = snapshotSection<FlatCtrl>(file, h, 0);
+        if (c[cap] != kFlatSentinel)
+            throw "snapshot: the table is corrupt";
+
+        // a missed key probes until an empty byte, one pass over them
+        uint64_t full = 0;
+        uint64_t empty = 0;
+        for (uint64_t i = 0; i != cap; ++i) {
+            if (flatIsFull(c[i]))
+                ++full;
+            else if (c[i] == kFlatEmpty)
+                ++empty;
+            else if (c[i] != kFlatDeleted)
+                throw "snapshot: the table is corrupt";
+        }
+        if (full != h.size || empty == 0)
+            throw "snapshot: the table is corrupt";
+
+        const T* s = snapshotSection<T>(file, h, 1);
+        size_t sampled = 0;
+        for (uint64_t i = 0; i != cap && sampled != kSnapshotHashSamples;
+             ++i) {
+            if (!flatIsFull(c[i]))
+                continue;
+            if (flatH2(hashfunc(get_key(s[i]))) != c[i])
+                throw "snapshot: the hash function differs";
+            ++sampled;
+        }
+    }
+
+public:
+    explicit MappedFlatHashTable(const char* path, const hasher& hf = hasher(),
+                                 const key_equal& equal = key_equal())
+        : file(path), hashfunc(hf), key_equ(equal) {
+        snapshotCheckElement<T>();
+        const SnapshotHeader& h = checkSnapshot<FlatCtrl, T>(
+            file, isMap ? kSnapshotFlatHashMap : kSnapshotFlatHashSet);
+        checkTable(h);
+        capacity = static_cast<size_type>(h.capacity);
+        num_elements = static_cast<size_type>(h.size);
+        if (capacity == 0) {
+            ctrl = flatEmptyCtrl();
+            slots = nullptr;
+        } else {
+            ctrl = snapshotSection<FlatCtrl>(file, h, 0);
+            slots = const_cast<T*>(snapshotSection<T>(file, h, 1));
+        }
+    }
+
+    MappedFlatHashTable(MappedFlatHashTable&&) = default;
+    MappedFlatHashTable& operator=(MappedFlatHashTable&&) = default;
+
+    const_iterator begin() const noexcept {
+        const_iterator iter(ctrl, slots);
+        iter.skipEmptyOrDeleted();
+        return iter;
+    }
+
+    const_iterator cbegin() const noexcept {
+        return begin();
+    }
+
+    const_iterator end() const noexcept {
+        return makeIter(capacity);
+    }
+
+    const_iterator cend() const noexcept {
+        return end();
+    }
+
+    size_type size() const noexcept {
+        return num_elements;
+    }
+
+    bool empty() const noexcept {
+        return num_elements == 0;
+    }
+
+    size_type bucket_count() const noexcept {
+        return capacity;
+    }
+
+    float load_factor() const noexcept {
+        return capacity == 0 ? 0.0f
+                             : static_cast<float>(num_elements) /
+                                   static_cast<float>(capacity);
+    }
+
+    hasher hash_function() const {
+        return hashfunc;
+    }
+
+    key_equal key_eq() const {
+        return key_equ;
+    }
+
+    const_iterator find(const key_type& key) const {
+        return makeIter(findAux(key, hashfunc(key)));
+    }
+
+    size_type count(const key_type& key) const {
+        return findAux(key, hashfunc(key)) != capacity;
+    }
+
+    bool contains(const key_type& key) const {
+        return count(key) != 0;
+    }
+
+    pair<const_iterator, const_iterator>
+    equal_range(const key_type& key) const {
+        const size_type pos = findAux(key, hashfunc(key));
+        if (pos == capacity)
+            return {end(), end()};
+        const_iterator first = makeIter(pos);
+        const_iterator last = first;
+        return {first, ++last};
+    }
+}; // class MappedFlatHashTable
+
+template <typename Key, typename T, typename Hash = hash<Key>,
+          typename KeyEqual = equal_to<Key>,
+          typename Probe = quadratic_probing>
+class mapped_unordered_map
+    : public MappedFlatHashTable<pair<Key, T>, Hash, KeyEqual, true, Probe> {
+private:
+    using Base =
+        MappedFlatHashTable<pair<Key, T>, Hash, KeyEqual, true, Probe>;
+
+public:
+    using Base::Base;
+
+    const T& at(const Key& key) const {
+        auto iter = this->find(key);
+        if (iter == this->end())
+            throw "mapped_unordered_map: out of range";
+        return iter->second;
+    }
+}; // class mapped_unordered_map<Key, T, Hash, KeyEqual, Probe>
+
+template <typename Key, typename Hash = hash<Key>,
+          typename KeyEqual = equal_to<Key>,
+          typename Probe = quadratic_probing>
+class mapped_unordered_set
+    : public MappedFlatHashTable<Key, Hash, KeyEqual, false, Probe> {
+private:
+    using Base = MappedFlatHashTable<Key, Hash, KeyEqual, false, Probe>;
+
+public:
+    using Base::Base;
+}; // class mapped_unordered_set<Key, Hash, KeyEqual, Probe>
+
+} // namespace tiny_stl
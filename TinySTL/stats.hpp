@@ -0,0 +1,303 @@
+// Copyright (C) 2021 syn1w
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <typeinfo>
+
+#include "memory.hpp"
+
+namespace tiny_stl {
+
+// Runtime statistics of the containers
+//
+// stats_allocator<T, Alloc, Tag> wraps Alloc and counts allocations,
+// deallocations, bytes and the high-water mark of bytes in use into one
+// record per Tag. Tag survives rebind, so the nodes, buckets and maps a
+// container allocates for itself land in the record of the container
+// type. for_each_alloc_stats() visits every record used so far.
+//
+// stats() of vector, small_vector, deque, HashTable (chained
+// unordered_map/set) and RBTree (map/set) returns a snapshot struct. The
+// shape (size, capacity, chain lengths, tree height) is measured when it
+// is called. The event counters (reallocations, rehashes and their time,
+// rotations) are kept only if TINY_STL_STATS is defined, otherwise they
+// read 0 and the containers carry no counter. The macro changes the
+// layout of the containers, define it the same way in every translation
+// unit.
+
+#ifdef TINY_STL_STATS
+static const bool kStatsEnabled = true;
+#else
+static const bool kStatsEnabled = false;
+#endif
+
+struct alloc_stats {
+    size_t allocations;
+    size_t deallocations;
+    size_t bytes_allocated;
+    size_t bytes_deallocated;
+    size_t bytes_in_use;
+    size_t peak_bytes; // the most bytes in use at once
+};
+
+struct vector_stats {
+    size_t size;
+    size_t capacity;
+    size_t reallocations; // the elements moved to a larger array
+    size_t relocated;     // elements moved by the reallocations
+};
+
+struct deque_stats {
+    size_t size;
+    size_t map_size;
+    size_t buffers;            // buffers in use
+    size_t map_reallocations;  // the map moved to a larger one
+    size_t map_recentres;      // the buffers recentred in the same map
+    size_t buffer_allocations; // from the allocator, reused spares are not
+};
+
+// chain lengths 0, 1, ..., the last bin counts the longer ones too
+static const size_t kHashStatsChainBins = 16;
+
+struct hash_stats {
+    size_t size;
+    size_t bucket_count;
+    float load_factor;
+    size_t empty_buckets;
+    size_t longest_chain;
+    size_t chains[kHashStatsChainBins]; // buckets by chain length
+    size_t rehashes;
+    uint64_t rehash_ns; // spent relinking, incremental steps included
+};
+
+struct tree_stats {
+    size_t size;
+    size_t height; // nodes on the longest path from the root
+    size_t rotations;
+};
+
+#ifdef TINY_STL_STATS
+// adds the time of its scope to total
+class StatsTimer {
+private:
+    using Clock = std::chrono::steady_clock;
+
+    uint64_t& total;
+    Clock::time_point begin;
+
+public:
+    explicit StatsTimer(uint64_t& t) noexcept : total(t), begin(Clock::now()) {
+    }
+
+    StatsTimer(const StatsTimer&) = delete;
+    StatsTimer& operator=(const StatsTimer&) = delete;
+
+    ~StatsTimer() {
+        total += static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() -
+                                                                 begin)
+                .count());
+    }
+};
+#endif // TINY_STL_STATS
+
+// the counters of one Tag, updated from any thread. records are linked
+// on first use and live as long as the program
+class AllocStatsRecord {
+private:
+    std::atomic<size_t> allocations{0};
+    std::atomic<size_t> deallocations{0};
+    std::atomic<size_t> bytesAllocated{0};
+    std::atomic<size_t> bytesDeallocated{0};
+    std::atomic<size_t> bytesInUse{0};
+    std::atomic<size_t> peakBytes{0};
+    const char* tagName;
+    AllocStatsRecord* next;
+
+    static std::atomic<AllocStatsRecord*>& head() noexcept {
+        static std::atomic<AllocStatsRecord*> list{nullptr};
+        return list;
+    }
+
+public:
+    explicit AllocStatsRecord(const char* name) noexcept
+        : tagName(name), next(head().load(std::memory_order_relaxed)) {
+        while (!head().compare_exchange_weak(next, this,
+                                             std::memory_order_release,
+                                             std::memory_order_relaxed)) {
+        }
+    }
+
+    AllocStatsRecord(const AllocStatsRecord&) = delete;
+    AllocStatsRecord& operator=(const AllocStatsRecord&) = delete;
+
+    void onAllocate(size_t bytes) noexcept {
+        allocations.fetch_add(1, std::memory_order_relaxed);
+        bytesAllocated.fetch_add(bytes, std::memory_order_relaxed);
+        const size_t inUse =
+            bytesInUse.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+        size_t peak = peakBytes.load(std::memory_order_relaxed);
+        while (peak < inUse &&
+               !peakBytes.compare_exchange_weak(peak, inUse,
+                                                std::memory_order_relaxed)) {
+        }
+    }
+
+    void onDeallocate(size_t bytes) noexcept {
+        deallocations.fetch_add(1, std::memory_order_relaxed);
+        bytesDeallocated.fetch_add(bytes, std::memory_order_relaxed);
+        bytesInUse.fetch_sub(bytes, std::memory_order_relaxed);
+    }
+
+    // each counter is exact, taken together they may be a little apart
+    // while other threads allocate
+    alloc_stats snapshot() const noexcept {
+        return alloc_stats{allocations.load(std::memory_order_relaxed),
+                           deallocations.load(std::memory_order_relaxed),
+                           bytesAllocated.load(std::memory_order_relaxed),
+                           bytesDeallocated.load(std::memory_order_relaxed),
+                           bytesInUse.load(std::memory_order_relaxed),
+                           peakBytes.load(std::memory_order_relaxed)};
+    }
+
+    // bytes in use stay, the peak restarts from them
+    void reset() noexcept {
+        allocations.store(0, std::memory_order_relaxed);
+        deallocations.store(0, std::memory_order_relaxed);
+        bytesAllocated.store(0, std::memory_order_relaxed);
+        bytesDeallocated.store(0, std::memory_order_relaxed);
+        peakBytes.store(bytesInUse.load(std::memory_order_relaxed),
+                        std::memory_order_relaxed);
+    }
+
+    const char* name() const noexcept {
+        return tagName;
+    }
+
+    template <typename Fn>
+    friend void for_each_alloc_stats(Fn fn);
+};
+
+template <typename Tag>
+inline AllocStatsRecord& allocStatsOf() {
+    static AllocStatsRecord record(typeid(Tag).name());
+    return record;
+}
+
+// fn(name, alloc_stats) for every Tag used so far, name is
+// typeid(Tag).name()
+template <typename Fn>
+void for_each_alloc_stats(Fn fn) {
+    for (AllocStatsRecord* rec =
+             AllocStatsRecord::head().load(std::memory_order_acquire);
+         rec != nullptr; rec = rec->next)
+        fn(static_cast<const char*>(rec->tagName), rec->snapshot());
+}
+
+template <typename T, typename Alloc = allocator<T>, typename Tag = T>
+class stats_allocator {
+private:
+    using AlTraits = allocator_traits<Alloc>;
+
+    template <typename, typename, typename>
+    friend class stats_allocator;
+
+    Alloc inner;
+
+public:
+    using value_type = T;
+    using pointer = typename AlTraits::pointer;
+    using const_pointer = typename AlTraits::const_pointer;
+    using void_pointer = typename AlTraits::void_pointer;
+    using const_void_pointer = typename AlTraits::const_void_pointer;
+    using size_type = typename AlTraits::size_type;
+    using difference_type = typename AlTraits::difference_type;
+
+    using propagate_on_container_copy_assignment =
+        typename AlTraits::propagate_on_container_copy_assignment;
+    using propagate_on_container_move_assignment =
+        typename AlTraits::propagate_on_container_move_assignment;
+    using propagate_on_container_swap =
+        typename AlTraits::propagate_on_container_swap;
+    using is_always_equal = typename AlTraits::is_always_equal;
+
+    template <typename U>
+    struct rebind {
+        using other = stats_allocator<
+            U, typename AlTraits::template rebind_alloc<U>, Tag>;
+    };
+
+    stats_allocator() = default;
+
+    explicit stats_allocator(const Alloc& a) : inner(a) {
+    }
+
+    template <typename U, typename A>
+    stats_allocator(const stats_allocator<U, A, Tag>& rhs) : inner(rhs.inner) {
+    }
+
+    pointer allocate(size_type n) {
+        pointer p = AlTraits::allocate(inner, n);
+        allocStatsOf<Tag>().onAllocate(n * sizeof(T));
+        return p;
+    }
+
+    void deallocate(pointer p, size_type n) noexcept {
+        AlTraits::deallocate(inner, p, n);
+        allocStatsOf<Tag>().onDeallocate(n * sizeof(T));
+    }
+
+    template <typename Obj, typename... Args>
+    void construct(Obj* p, Args&&... args) {
+        AlTraits::construct(inner, p, tiny_stl::forward<Args>(args)...);
+    }
+
+    template <typename Obj>
+    void destroy(Obj* p) {
+        AlTraits::destroy(inner, p);
+    }
+
+    size_type max_size() const noexcept {
+        return AlTraits::max_size(inner);
+    }
+
+    stats_allocator select_on_container_copy_construction() const {
+        return stats_allocator(
+            AlTraits::select_on_container_copy_construction(inner));
+    }
+
+    const Alloc& inner_allocator() const noexcept {
+        return inner;
+    }
+
+    // the record of Tag, shared by every container type using it
+    static alloc_stats stats() noexcept {
+        return allocStatsOf<Tag>().snapshot();
+    }
+
+    static void reset_stats() noexcept {
+        allocStatsOf<Tag>().reset();
+    }
+
+    template <typename U, typename A>
+    bool operator==(const stats_allocator<U, A, Tag>& rhs) const noexcept {
+        return inner == rhs.inner;
+    }
+
+    template <typename U, typename A>
+    bool operator!=(const stats_allocator<U, A, Tag>& rhs) const noexcept {
+        return !(*this == rhs);
+    }
+}; // class stats_allocator<T, Alloc, Tag>
+
+template <typename T, typename Alloc, typename Tag>
+struct is_trivially_relocatable<stats_allocator<T, Alloc, Tag>>
+    : is_trivially_relocatable<Alloc> {};
+
+} // namespace tiny_stl
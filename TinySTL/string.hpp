@@ -4,10 +4,16 @@
 
 #pragma once
 
+#include "char_search.hpp"
 #include "memory.hpp"
 #include "string_view.hpp"
 #include <initializer_list>
 
+#if defined(TINY_STL_COMPACT_STRING) && defined(__BYTE_ORDER__) &&            \
+    __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "TINY_STL_COMPACT_STRING needs a little-endian target"
+#endif
+
 namespace tiny_stl {
 
 template <typename T>
@@ -176,6 +182,24 @@ struct StringIterator : StringConstIterator<T> {
     }
 }; // StringIterator<T>
 
+template <typename T>
+struct ContiguousIterator<StringConstIterator<T>> : true_type {
+    using element_type = const T;
+
+    static const T* address(StringConstIterator<T> iter) noexcept {
+        return iter.ptr;
+    }
+};
+
+template <typename T>
+struct ContiguousIterator<StringIterator<T>> : true_type {
+    using element_type = T;
+
+    static T* address(StringIterator<T> iter) noexcept {
+        return const_cast<T*>(iter.ptr);
+    }
+};
+
 template <typename CharT, typename Traits = std::char_traits<CharT>,
           typename Alloc = allocator<CharT>>
 class basic_string {
@@ -205,11 +229,31 @@ public:
     static const size_type npos = static_cast<size_type>(-1);
 
 private:
+    // The default layout is size, capacity and a 16-byte buffer. Define
+    // TINY_STL_COMPACT_STRING for a 3-word layout keeping 23 chars inline:
+    //   long:  ptr, size and capacity, the high bit of capacity is set
+    //   short: the same bytes are the buffer, the last byte is the unused
+    //          capacity (kBufferSize - 1 - size), so it is also the null
+    //          character of a full buffer, a shrinking edit moves the null
+    //          character before setSize
     class StringValue {
     public:
         static_assert(sizeof(value_type) <= 16,
                       "size of value_type is too large");
+#ifdef TINY_STL_COMPACT_STRING
+        struct Long {
+            pointer ptr;
+            size_type size;
+            size_type capacity;
+        };
+
+        static_assert(sizeof(Long) % sizeof(value_type) == 0,
+                      "size of value_type does not divide the layout");
+        static constexpr const size_type kBufferSize =
+            sizeof(Long) / sizeof(value_type);
+#else
         static constexpr const size_type kBufferSize = 16 / sizeof(value_type);
+#endif
         static constexpr const size_type kBufferMask =
             sizeof(value_type) <= 1
                 ? 15
@@ -219,9 +263,15 @@ private:
                             ? 3
                             : sizeof(value_type) <= 8 ? 1 : 0;
 
-    public:
+    private:
+#ifdef TINY_STL_COMPACT_STRING
+        // the top bit of the last byte on a little-endian target
+        static constexpr const size_type kLongFlag = ~(~size_type{0} >> 1);
+        static constexpr const unsigned char kLongTag = 0x80;
+#else
         size_type size;
         size_type capacity;
+#endif
 
         // short string optimization
         union Data {
@@ -231,39 +281,114 @@ private:
             }
 
             value_type buf[kBufferSize];
+#ifdef TINY_STL_COMPACT_STRING
+            Long lng;
+#else
             pointer ptr;
             char placeholder[kBufferSize]; // unused
+#endif
         } data;
 
+#ifdef TINY_STL_COMPACT_STRING
+        unsigned char& lastByte() noexcept {
+            return reinterpret_cast<unsigned char*>(&data)[sizeof(Long) - 1];
+        }
+
+        unsigned char lastByte() const noexcept {
+            return const_cast<StringValue*>(this)->lastByte();
+        }
+
+    public:
+        StringValue() : data() {
+            setShort(0);
+        }
+
+        bool isShortString() const noexcept {
+            return (lastByte() & kLongTag) == 0;
+        }
+
+        size_type getSize() const noexcept {
+            return isShortString() ? kBufferSize - 1 - lastByte()
+                                   : data.lng.size;
+        }
+
+        size_type getCapacity() const noexcept {
+            return isShortString() ? kBufferSize - 1
+                                   : data.lng.capacity & ~kLongFlag;
+        }
+
+        void setSize(size_type newSize) noexcept {
+            if (isShortString())
+                setShort(newSize);
+            else
+                data.lng.size = newSize;
+        }
+
+        // switch to the buffer, the characters are written by the caller
+        void setShort(size_type newSize) noexcept {
+            assert(newSize < kBufferSize);
+            lastByte() = static_cast<unsigned char>(kBufferSize - 1 - newSize);
+        }
+
+        void setLong(pointer ptr, size_type newSize,
+                     size_type newCapacity) noexcept {
+            assert((newCapacity & kLongFlag) == 0);
+            data.lng.ptr = ptr;
+            data.lng.size = newSize;
+            data.lng.capacity = newCapacity | kLongFlag;
+        }
+
+        const value_type* getPtr() const noexcept {
+            return isShortString() ? data.buf : data.lng.ptr;
+        }
+#else
+    public:
         StringValue() : size(0), capacity(0), data() {
         }
 
-        const value_type* getPtr() const {
+        bool isShortString() const noexcept {
+            return capacity < kBufferSize;
+        }
+
+        size_type getSize() const noexcept {
+            return size;
+        }
+
+        size_type getCapacity() const noexcept {
+            return capacity;
+        }
+
+        void setSize(size_type newSize) noexcept {
+            size = newSize;
+        }
+
+        // switch to the buffer, the characters are written by the caller
+        void setShort(size_type newSize) noexcept {
+            assert(newSize < kBufferSize);
+            size = newSize;
+            capacity = kBufferSize - 1;
+        }
+
+        void setLong(pointer ptr, size_type newSize,
+                     size_type newCapacity) noexcept {
+            data.ptr = ptr;
+            size = newSize;
+            capacity = newCapacity;
+        }
+
+        const value_type* getPtr() const noexcept {
             const value_type* ptr = data.ptr;
             if (isShortString()) {
                 ptr = data.buf;
             }
             return ptr;
         }
+#endif
 
-        value_type* getPtr() {
+        value_type* getPtr() noexcept {
             return const_cast<value_type*>(
                 static_cast<const StringValue*>(this)->getPtr());
         }
-
-        void checkIndex(const size_type idx) const {
-            if (idx > size) {
-                xRange();
-            }
-        }
-
-        bool isShortString() const {
-            return capacity < kBufferSize;
-        }
-
-        [[noreturn]] static void xRange() {
-            throw "invalid tiny_stl::basic_string<CharT> index";
-        }
     };
 
 private:
@@ -306,7 +431,8 @@ public:
         init(rhs, pos, count);
     }
 
-    basic_string(const value_type* str, size_type count, const Alloc& a)
+    basic_string(const value_type* str, size_type count,
+                 const Alloc& a = Alloc())
         : allocVal(a) {
         initEmpty(); // for setting capacity
         init(str, count);
@@ -370,7 +496,7 @@ public:
     basic_string& operator=(const basic_string& rhs) {
         if (this != tiny_stl::addressof(rhs)) {
             copyAlloc(getAlloc(), rhs.getAlloc());
-            init(rhs.getVal().getPtr(), rhs.getVal().size);
+            init(rhs.getVal().getPtr(), rhs.size());
         }
 
         return *this;
@@ -390,7 +516,7 @@ public:
     }
 
     basic_string& operator=(value_type ch) {
-        getVal().size = 1;
+        getVal().setSize(1);
         pointer ptr = getVal().getPtr();
         Traits::assign(ptr[0], ch);
         Traits::assign(ptr[1], value_type{});
@@ -495,45 +621,33 @@ private:
         if (getAlloc() == rhs.getAlloc()) {
             assignMove(rhs, EqualAllocator{});
         } else {
-            init(rhs.getVal().getPtr(), rhs.getVal().size);
+            init(rhs.getVal().getPtr(), rhs.size());
         }
     }
 
 private:
     void constructCopy(const basic_string& rhs) {
         auto& rhsValue = rhs.getVal();
-        const size_type rhsSize = rhsValue.size;
+        const size_type rhsSize = rhsValue.getSize();
         const value_type* rhsPtr = rhsValue.getPtr();
         auto& value = getVal();
         if (rhsSize < StringValue::kBufferSize) {
-            Traits::move(value.data.buf, rhsPtr, StringValue::kBufferSize);
-            value.size = rhsSize;
-            value.capacity = StringValue::kBufferSize - 1;
+            value.setShort(rhsSize);
+            Traits::copy(value.getPtr(), rhsPtr, rhsSize + 1);
             return;
         }
         auto& alloc = getAlloc();
         const size_type newCapacity =
             tiny_stl::min(rhsSize | StringValue::kBufferMask, max_size());
         pointer newPtr = alloc.allocate(newCapacity + 1);
-        value.data.ptr = newPtr;
-        Traits::move(newPtr, rhsPtr, rhsSize + 1);
-        value.size = rhsSize;
-        value.capacity = newCapacity;
+        Traits::copy(newPtr, rhsPtr, rhsSize + 1);
+        value.setLong(newPtr, rhsSize, newCapacity);
     }
 
     void constructMove(basic_string& rhs) noexcept {
-        auto& value = getVal();
-        auto& rhsValue = rhs.getVal();
-        if (rhsValue.isShortString()) {
-            // copy short string
-            Traits::move(value.data.buf, rhsValue.data.buf, rhsValue.size + 1);
-        } else {
-            value.data.ptr = rhsValue.data.ptr;
-            rhsValue.data.ptr = pointer();
-        }
-
-        value.size = rhsValue.size;
-        value.capacity = rhsValue.capacity;
+        // the buffer holds no pointer into itself, copying the bytes moves
+        // both a short and a long string
+        getVal() = rhs.getVal();
         rhs.initEmpty();
     }
 
@@ -544,15 +658,14 @@ public:
 
 private:
     void initEmpty() noexcept {
-        getVal().size = 0;
-        getVal().capacity = StringValue::kBufferSize - 1;
-        Traits::assign(getVal().data.buf[0], value_type());
+        getVal().setShort(0);
+        Traits::assign(getVal().getPtr()[0], value_type());
     }
 
     basic_string& init(size_type count, value_type ch) {
-        if (count <= getVal().capacity) {
+        if (count <= capacity()) {
             value_type* const ptr = getVal().getPtr();
-            getVal().size = count;
+            getVal().setSize(count);
             Traits::assign(ptr, count, ch);
             Traits::assign(ptr[count], value_type());
 
@@ -572,14 +685,14 @@ private:
     basic_string& init(const basic_string& rhs, size_type pos,
                        size_type count = npos) {
         rhs.checkOffset(pos);
-        count = tiny_stl::min(count, rhs.getVal().size - pos);
+        count = tiny_stl::min(count, rhs.size() - pos);
         return init(rhs.getVal().getPtr(), count);
     }
 
     basic_string& init(const value_type* str, size_type count) {
-        if (count <= getVal().capacity) {
+        if (count <= capacity()) {
             value_type* const ptr = getVal().getPtr();
-            getVal().size = count;
+            getVal().setSize(count);
             Traits::move(ptr, str, count);
             Traits::assign(ptr[count], value_type());
             return *this;
@@ -641,18 +754,16 @@ private:
     basic_string& reallocAndAssign(size_type newSize, F func, Args... args) {
         checkLength(newSize);
         Alloc& alloc = getAlloc();
-        const size_type oldCapacity = getVal().capacity;
+        auto& value = getVal();
         const size_type newCapacity = capacityGrowth(newSize);
 
         pointer newPtr = alloc.allocate(newCapacity + 1); // for null character
-        getVal().size = newSize;
-        getVal().capacity = newCapacity;
         func(newPtr, newSize, args...);
 
-        if (oldCapacity >= StringValue::kBufferSize) {
-            alloc.deallocate(getVal().data.ptr, oldCapacity + 1);
+        if (!value.isShortString()) {
+            alloc.deallocate(value.getPtr(), value.getCapacity() + 1);
         }
-        getVal().data.ptr = newPtr;
+        value.setLong(newPtr, newSize, newCapacity);
 
         return *this;
     }
@@ -661,27 +772,22 @@ private:
     basic_string& reallocAndAssignGrowBy(size_type growSize, F func,
                                          Args... args) {
         auto& value = getVal();
-        const size_type oldSize = value.size;
+        const size_type oldSize = value.getSize();
         // check length
         if (max_size() - oldSize < growSize) {
             xLength();
         }
 
         const size_type newSize = oldSize + growSize;
-        const size_type oldCapacity = value.capacity;
         const size_type newCapacity = capacityGrowth(newSize);
         auto& alloc = getAlloc();
         pointer newPtr = alloc.allocate(newCapacity + 1); // throws
-        value.size = newSize;
-        value.capacity = newCapacity;
-        if (oldCapacity >= StringValue::kBufferSize) {
-            pointer oldPtr = value.data.ptr;
-            func(newPtr, oldPtr, oldSize, args...);
-            alloc.deallocate(oldPtr, oldCapacity + 1);
-        } else {
-            func(newPtr, value.data.buf, oldSize, args...);
+        pointer oldPtr = value.getPtr();
+        func(newPtr, oldPtr, oldSize, args...);
+        if (!value.isShortString()) {
+            alloc.deallocate(oldPtr, value.getCapacity() + 1);
         }
-        value.data.ptr = newPtr;
+        value.setLong(newPtr, newSize, newCapacity);
         return *this;
     }
 
@@ -705,7 +811,7 @@ private:
         if (!getVal().isShortString()) {
             Alloc& alloc = getAlloc();
             const pointer ptr = getVal().getPtr();
-            alloc.deallocate(ptr, getVal().capacity + 1);
+            alloc.deallocate(ptr, getVal().getCapacity() + 1);
         }
         initEmpty();
     }
@@ -772,12 +878,12 @@ public:
 
     iterator end() noexcept {
         return iterator(getVal().getPtr() +
-                        static_cast<difference_type>(getVal().size));
+                        static_cast<difference_type>(size()));
     }
 
     const_iterator end() const noexcept {
         const value_type* ptr =
-            getVal().getPtr() + static_cast<difference_type>(getVal().size);
+            getVal().getPtr() + static_cast<difference_type>(size());
         return const_iterator{ptr};
     }
 
@@ -815,7 +921,7 @@ public:
     }
 
     size_type size() const noexcept {
-        return allocVal.get_second().size;
+        return getVal().getSize();
     }
 
     size_type length() const noexcept {
@@ -823,34 +929,37 @@ public:
     }
 
     size_type max_size() const noexcept {
+        // capacity + 1 (null character) elements must fit in difference_type
         return tiny_stl::min(static_cast<size_type>(-1) / sizeof(value_type) -
                                  1,
                              static_cast<size_type>(
-                                 std::numeric_limits<difference_type>::max()));
+                                 std::numeric_limits<difference_type>::max()) /
+                                     sizeof(value_type) -
+                                 1);
     }
 
     void reserve(size_type newCapacity = 0) {
-        if (newCapacity < getVal().size) {
+        if (newCapacity < size()) {
             shrink_to_fit();
             return;
         }
 
-        if (newCapacity <= getVal().capacity) {
+        if (newCapacity <= capacity()) {
             return; // do nothing
         }
 
         // reallocate memory if newCapacity > oldCapacity
-        const size_type oldSize = getVal().size;
+        const size_type oldSize = size();
         reallocAndAssignGrowBy(newCapacity - oldSize,
                                [](value_type* newPtr, const value_type* oldPtr,
                                   const size_type oldSizeX) {
                                    Traits::move(newPtr, oldPtr, oldSizeX + 1);
                                });
-        getVal().size = oldSize;
+        getVal().setSize(oldSize);
     }
 
     size_type capacity() const noexcept {
-        return allocVal.get_second().capacity;
+        return getVal().getCapacity();
     }
 
     void shrink_to_fit() {
@@ -858,39 +967,11 @@ public:
     }
 
 private:
-    void swapShortWithLong(StringValue& shortVal,
-                           StringValue& longVal) noexcept {
-        pointer ptr = longVal.data.ptr;
-        Traits::move(longVal.data.buf, shortVal.data.buf,
-                     StringValue::kBufferSize);
-        shortVal.data.ptr = ptr;
-    }
-
     void swapAux(basic_string& rhs) noexcept {
-        auto& lhsVal = getVal();
-        auto& rhsVal = rhs.getVal();
-        const bool isShortLhs = lhsVal.isShortString();
-        const bool isShortRhs = rhsVal.isShortString();
-
-        if (isShortLhs) {
-            if (isShortRhs)
-                swapADL(lhsVal.data.ptr, rhsVal.data.ptr);
-            else
-                swapShortWithLong(lhsVal, rhsVal);
-        } else { // lhs is long string
-            if (isShortRhs) {
-                swapShortWithLong(rhsVal, lhsVal);
-            } else {
-                value_type tmpBuf[StringValue::kBufferSize];
-                Traits::move(tmpBuf, lhsVal.data.buf, StringValue::kBufferSize);
-                Traits::move(lhsVal.data.buf, rhsVal.data.buf,
-                             StringValue::kBufferSize);
-                Traits::move(rhsVal.data.buf, tmpBuf, StringValue::kBufferSize);
-            }
-        }
-
-        swapADL(lhsVal.size, rhsVal.size);
-        swapADL(lhsVal.capacity, rhsVal.capacity);
+        // no pointer into the buffer, swap the bytes of both layouts
+        StringValue tmp = getVal();
+        getVal() = rhs.getVal();
+        rhs.getVal() = tmp;
     }
 
 public:
@@ -904,7 +985,7 @@ public:
         const size_type oldSize = size();
         if (count <= oldCapcity && oldSize <= oldCapcity - count) {
             auto& val = getVal();
-            val.size += count;
+            val.setSize(oldSize + count);
             Traits::move(val.getPtr() + pos + count, val.getPtr() + pos,
                          oldSize - pos + 1);
             Traits::assign(val.getPtr() + pos, count, ch);
@@ -937,7 +1018,7 @@ public:
         const size_type oldSize = size();
         if (count <= oldCapacity && oldSize <= oldCapacity - count) {
             auto& val = getVal();
-            val.size += count;
+            val.setSize(oldSize + count);
             Traits::move(val.getPtr() + pos + count, val.getPtr() + pos,
                          oldSize - pos + 1);
             Traits::move(val.getPtr() + pos, str, count);
@@ -1000,9 +1081,11 @@ public:
         checkOffset(pos);
         count = tiny_stl::min(count, size() - pos);
         auto& val = getVal();
-        val.size -= count;
+        const size_type newSize = size() - count;
+        // move the null character before shrinking, see StringValue
         Traits::move(val.getPtr() + pos, val.getPtr() + pos + count,
-                     val.size - pos + 1 /*'\0'*/);
+                     newSize - pos + 1 /*'\0'*/);
+        val.setSize(newSize);
 
         return *this;
     }
@@ -1027,7 +1110,7 @@ public:
         const size_type oldSize = size();
         if (oldSize < oldCapacity) { // has enough space
             auto& val = getVal();
-            ++val.size;
+            val.setSize(oldSize + 1);
             pointer ptr = val.getPtr();
             Traits::assign(ptr[oldSize], ch);
             Traits::assign(ptr[oldSize + 1], value_type());
@@ -1051,7 +1134,7 @@ public:
             return;
 
         auto& val = getVal();
-        --val.size;
+        val.setSize(size() - 1);
         Traits::assign(val.getPtr()[size()], value_type());
     }
 
@@ -1070,7 +1153,7 @@ public:
         if (count <= oldCapacity &&
             oldSize <= oldCapacity - count) { // has enough space
             auto& val = getVal();
-            val.size += count;
+            val.setSize(oldSize + count);
             Traits::assign(val.getPtr() + oldSize, count, ch);
             Traits::assign(val.getPtr()[oldSize + count], value_type());
             return *this;
@@ -1104,7 +1187,7 @@ public:
         const size_type oldSize = size();
         if (count <= oldCapacity && oldSize <= oldCapacity - count) {
             auto& val = getVal();
-            val.size += count;
+            val.setSize(oldSize + count);
             Traits::move(val.getPtr() + oldSize, str, count);
             Traits::assign(val.getPtr()[oldSize + count], value_type());
 
@@ -1118,7 +1201,7 @@ public:
                const size_type xCount) {
                 Traits::move(newPtr, oldPtr, xOldSize);
                 Traits::move(newPtr + xOldSize, xStr, xCount);
-                Traits::assign(newPtr[xOldSize + 1], value_type());
+                Traits::assign(newPtr[xOldSize + xCount], value_type());
             },
             str, count);
     }
@@ -1259,11 +1342,11 @@ public:
 
         const size_type suffixSize = oldSize - pos - count + 1;
         if (count > count2) {
-            val.size = oldSize - (count - count2);
             value_type* oldPtr = val.getPtr();
             value_type* replaceAt = oldPtr + pos;
             Traits::move(replaceAt, str, count2);
             Traits::move(replaceAt + count2, replaceAt + count, suffixSize);
+            val.setSize(oldSize - (count - count2));
             return *this;
         }
 
@@ -1271,7 +1354,7 @@ public:
         const size_type growSize = count2 - count;
         const size_type oldCapacity = capacity();
         if (growSize < oldCapacity - oldSize) {
-            val.size = oldSize + growSize;
+            val.setSize(oldSize + growSize);
             value_type* replaceAt = val.getPtr() + pos;
             value_type* oldSuffixAt = replaceAt + count;
             value_type* newSuffixAt = oldSuffixAt + growSize;
@@ -1324,12 +1407,12 @@ public:
 
         const size_type oldCapacity = capacity();
         if (count2 < count || count2 - count < oldCapacity - oldSize) {
-            val.size = oldSize + count2 - count;
             value_type* oldPtr = val.getPtr();
             value_type* replaceAt = oldPtr + pos;
             Traits::move(replaceAt + count2, replaceAt + count,
                          oldSize - pos - count + 1);
             Traits::assign(replaceAt, count2, ch);
+            val.setSize(oldSize + count2 - count);
             return *this;
         }
 
@@ -1386,61 +1469,52 @@ public:
     }
 
 private:
+    size_type position(const value_type* p) const noexcept {
+        return p == nullptr ? npos : static_cast<size_type>(p - data());
+    }
+
     size_type findHelper(const value_type* str, size_type pos,
                          size_type count) const noexcept {
-        // native find algorithm
-        size_type lhsSize = size();
-        if (count > lhsSize || pos > lhsSize - count)
+        const size_type lhsSize = size();
+        if (pos > lhsSize || count > lhsSize - pos)
             return npos;
-        if (count == 0)
+        if (count == 0) // always matches
             return pos;
 
-        for (size_type i = pos; i <= lhsSize - count; ++i) {
-            // mismatched the first character
-            if (!Traits::eq(data()[i], str[0]))
-                continue;
-
-            size_type j = 1;
-            for (; j < count; ++j) {
-                if (!Traits::eq(data()[i + j], str[j]))
-                    break;
-            }
-            if (j == count)
-                return i;
-        }
-
-        return npos;
+        return position(
+            traitsFind<Traits>(data() + pos, data() + lhsSize, str, count));
     }
 
-    // [0, pos]
+    // the match starts at [0, pos]
     size_type rfindHelper(const value_type* str, size_type pos,
                           size_type count) const noexcept {
-        // native find algorithm
-        size_type lhsSize = size();
-        if (count > lhsSize || pos < count)
+        const size_type lhsSize = size();
+        if (count == 0) // always matches
+            return tiny_stl::min(pos, lhsSize);
+        if (count > lhsSize)
             return npos;
-        if (lhsSize == 0)
+
+        const size_type last = tiny_stl::min(pos, lhsSize - count) + count;
+        return position(traitsRfind<Traits>(data(), data() + last, str, count));
+    }
+
+    size_type findOfHelper(const value_type* str, size_type pos,
+                           size_type count) const noexcept {
+        if (pos >= size())
             return npos;
-        if (count == 0)
-            return pos;
 
-        pos = tiny_stl::min(pos, lhsSize - 1);
-        // pos >= count
-        for (difference_type i = static_cast<difference_type>(pos); i >= 0;
-             --i) {
-            // mismatched the first character
-            if (!Traits::eq(data()[i], str[0]))
-                continue;
-
-            size_type j = 1;
-            for (; j < count; ++j) {
-                if (!Traits::eq(data()[i + j], str[j]))
-                    break;
-            }
-            if (j == count)
-                return i;
-        }
-        return npos;
+        return position(
+            traitsFindOf<Traits>(data() + pos, data() + size(), str, count));
+    }
+
+    size_type rfindOfHelper(const value_type* str, size_type pos,
+                            size_type count) const noexcept {
+        if (empty())
+            return npos;
+
+        const size_type last = tiny_stl::min(pos, size() - 1) + 1;
+        return position(
+            traitsRfindOf<Traits>(data(), data() + last, str, count));
     }
 
 public:
@@ -1458,9 +1532,10 @@ public:
     }
 
     size_type find(value_type ch, size_type pos = 0) const noexcept {
-        const value_type* findAt = Traits::find(data() + pos, size() - pos, ch);
-        return findAt == nullptr ? npos
-                                 : static_cast<size_type>(findAt - data());
+        if (pos >= size())
+            return npos;
+
+        return position(traitsFind<Traits>(data() + pos, data() + size(), ch));
     }
 
     size_type rfind(const basic_string& str,
@@ -1473,15 +1548,53 @@ public:
         return rfindHelper(str, pos, count);
     }
 
+    size_type rfind(const value_type* str, size_type pos = npos) const {
+        return rfindHelper(str, pos, Traits::length(str));
+    }
+
     size_type rfind(value_type ch, size_type pos = npos) const noexcept {
-        pos = tiny_stl::min(pos, size() - 1);
-        difference_type i = pos;
-        for (; i >= 0; --i) {
-            if (data()[i] == ch)
-                return static_cast<size_type>(i);
-        }
+        if (empty())
+            return npos;
+
+        const size_type last = tiny_stl::min(pos, size() - 1) + 1;
+        return position(traitsRfind<Traits>(data(), data() + last, ch));
+    }
+
+    size_type find_first_of(const basic_string& str,
+                            size_type pos = 0) const noexcept {
+        return findOfHelper(str.data(), pos, str.size());
+    }
+
+    size_type find_first_of(const value_type* str, size_type pos,
+                            size_type count) const {
+        return findOfHelper(str, pos, count);
+    }
+
+    size_type find_first_of(const value_type* str, size_type pos = 0) const {
+        return findOfHelper(str, pos, Traits::length(str));
+    }
+
+    size_type find_first_of(value_type ch, size_type pos = 0) const noexcept {
+        return find(ch, pos);
+    }
+
+    size_type find_last_of(const basic_string& str,
+                           size_type pos = npos) const noexcept {
+        return rfindOfHelper(str.data(), pos, str.size());
+    }
 
-        return npos;
+    size_type find_last_of(const value_type* str, size_type pos,
+                           size_type count) const {
+        return rfindOfHelper(str, pos, count);
+    }
+
+    size_type find_last_of(const value_type* str,
+                           size_type pos = npos) const {
+        return rfindOfHelper(str, pos, Traits::length(str));
+    }
+
+    size_type find_last_of(value_type ch, size_type pos = npos) const noexcept {
+        return rfind(ch, pos);
     }
 
 private:
@@ -1498,7 +1611,7 @@ private:
     }
 
     size_type capacityGrowth(size_type newSize) const {
-        const size_type oldSize = allocVal.get_second().size;
+        const size_type oldSize = size();
         const size_type masked = newSize | StringValue::kBufferMask;
         const size_type maxSize = max_size();
         if (masked > maxSize) {
@@ -1702,6 +1815,11 @@ void swap(
     lhs.swap(rhs);
 }
 
+// the short string buffer is inside the object, but nothing points to it
+template <typename CharT, typename Traits, typename Alloc>
+struct is_trivially_relocatable<basic_string<CharT, Traits, Alloc>>
+    : is_trivially_relocatable<Alloc>::type {};
+
 template <typename CharT, typename Traits, typename Alloc>
 std::basic_ostream<CharT, Traits>&
 operator<<(std::basic_ostream<CharT, Traits>& os,
@@ -1728,7 +1846,7 @@ struct hash<basic_string<CharT, Traits, Alloc>> {
 
     size_t
     operator()(const basic_string<CharT, Traits, Alloc>& str) const noexcept {
-        return tiny_stl::hashFNV(str.c_str(), str.size());
+        return tiny_stl::hashString(str.c_str(), str.size());
     }
 };
 
@@ -1784,6 +1902,19 @@ using wstring = basic_string<wchar_t>;
 using u16string = basic_string<char16_t>;
 using u32string = basic_string<char32_t>;
 
+namespace pmr {
+
+template <typename CharT, typename Traits = std::char_traits<CharT>>
+using basic_string =
+    tiny_stl::basic_string<CharT, Traits, polymorphic_allocator<CharT>>;
+
+using string = basic_string<char>;
+using wstring = basic_string<wchar_t>;
+using u16string = basic_string<char16_t>;
+using u32string = basic_string<char32_t>;
+
+} // namespace pmr
+
 inline string to_string(int value) {
     return IntegerToString<char>(value);
 }
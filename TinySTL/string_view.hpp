@@ -9,6 +9,7 @@
 #include <cstring>
 #include <stdexcept>
 
+#include "char_search.hpp"
 #include "string.hpp"
 
 namespace tiny_stl {
@@ -230,6 +231,19 @@ operator+(const typename StringViewIterator<CharT>::difference_type off,
     return rhs;
 }
 
+template <typename CharT>
+struct ContiguousIterator<StringViewIterator<CharT>> : true_type {
+    using element_type = const CharT;
+
+    static const CharT* address(StringViewIterator<CharT> iter) noexcept {
+#ifndef NDEBUG
+        return iter.ptr + iter.index;
+#else
+        return iter.ptr;
+#endif // !NDEBUG
+    }
+};
+
 template <typename CharT, typename Traits = std::char_traits<CharT>>
 class basic_string_view {
 public:
@@ -437,111 +451,117 @@ public:
         return ends_with(basic_string_view{str});
     }
 
-    XCONSTEXPR14
     size_type find(basic_string_view rhs, size_type pos1 = 0) const noexcept {
-        if (mSize < rhs.mSize || pos1 + rhs.mSize > mSize) {
+        if (pos1 > mSize || rhs.mSize > mSize - pos1)
             return npos;
-        }
-
-        if (rhs.empty()) { // always matches
-            return min(pos1, mSize);
-        }
-
-        for (size_type i = pos1; i <= mSize - rhs.mSize; ++i) {
-            if (mData[i] == rhs[0]) { // matched the first element
-                size_type j = 1;
-                for (j = 1; j < rhs.mSize; ++j) {
-                    if (mData[i + j] != rhs[j]) { // mismatched
-                        break;
-                    }
-                }
-
-                if (j == rhs.mSize) {
-                    return i; // matched
-                }
-            }
-        }
+        if (rhs.mSize == 0) // always matches, mData may be nullptr
+            return pos1;
 
-        return npos;
+        return position(
+            traitsFind<Traits>(mData + pos1, dataEnd(), rhs.mData, rhs.mSize));
     }
 
-    XCONSTEXPR14
     size_type find(CharT ch, size_type pos1 = 0) const noexcept {
-        for (size_type i = pos1; i < mSize; ++i) {
-            if (mData[i] == ch) {
-                return i; // matched
-            }
-        }
+        if (pos1 >= mSize)
+            return npos;
 
-        return npos;
+        return position(traitsFind<Traits>(mData + pos1, dataEnd(), ch));
     }
 
-    XCONSTEXPR14
     size_type find(const CharT* str, size_type pos1,
                    size_type count2) const noexcept {
         return find(basic_string_view{str, count2}, pos1);
     }
 
-    XCONSTEXPR14
     size_type find(const CharT* str, size_type pos1) const noexcept {
         return find(basic_string_view{str}, pos1);
     }
 
-    XCONSTEXPR14
     size_type rfind(basic_string_view rhs,
                     size_type pos1 = npos) const noexcept {
-        if (rhs.mSize == 0) { // always matches
+        if (rhs.mSize == 0) // always matches, mData may be nullptr
             return min(pos1, mSize);
-        }
-
-        if (rhs.mSize > mSize) {
+        if (rhs.mSize > mSize)
             return npos;
-        }
 
-        for (size_type i = min(pos1, mSize - rhs.mSize);
-             i != static_cast<size_type>(-1); --i) {
-            if (mData[i] == rhs[0]) { // matched the first element
-                size_type j = 1;
-                for (j = 1; j < rhs.mSize; ++j) {
-                    if (mData[i + j] != rhs[j]) {
-                        break;
-                    }
-                }
-
-                if (j == rhs.mSize) {
-                    return i;
-                }
-            }
-        }
-
-        return npos;
+        // the match starts at [0, pos1]
+        const size_type last = min(pos1, mSize - rhs.mSize) + rhs.mSize;
+        return position(
+            traitsRfind<Traits>(mData, mData + last, rhs.mData, rhs.mSize));
     }
 
-    XCONSTEXPR14
     size_type rfind(CharT ch, size_type pos1 = npos) const noexcept {
-        if (mSize == 0) {
+        if (mSize == 0)
             return npos;
-        }
 
-        for (int i = static_cast<int>(min(pos1, mSize - 1)); i >= 0; --i) {
-            if (mData[i] == ch) {
-                return i; // matched
-            }
-        }
-
-        return npos;
+        const size_type last = min(pos1, mSize - 1) + 1;
+        return position(traitsRfind<Traits>(mData, mData + last, ch));
     }
 
-    XCONSTEXPR14 size_type rfind(const CharT* str, size_type pos1,
-                                 size_type count2) const {
+    size_type rfind(const CharT* str, size_type pos1,
+                    size_type count2) const {
         return rfind(basic_string_view{str, count2}, pos1);
     }
 
-    XCONSTEXPR14
     size_type rfind(const CharT* str, size_type pos1 = npos) const {
         return rfind(basic_string_view{str}, pos1);
     }
 
+    size_type find_first_of(basic_string_view rhs,
+                            size_type pos1 = 0) const noexcept {
+        if (pos1 >= mSize)
+            return npos;
+
+        return position(
+            traitsFindOf<Traits>(mData + pos1, dataEnd(), rhs.mData,
+                                 rhs.mSize));
+    }
+
+    size_type find_first_of(CharT ch, size_type pos1 = 0) const noexcept {
+        return find(ch, pos1);
+    }
+
+    size_type find_first_of(const CharT* str, size_type pos1,
+                            size_type count2) const noexcept {
+        return find_first_of(basic_string_view{str, count2}, pos1);
+    }
+
+    size_type find_first_of(const CharT* str, size_type pos1 = 0) const {
+        return find_first_of(basic_string_view{str}, pos1);
+    }
+
+    size_type find_last_of(basic_string_view rhs,
+                           size_type pos1 = npos) const noexcept {
+        if (mSize == 0)
+            return npos;
+
+        const size_type last = min(pos1, mSize - 1) + 1;
+        return position(
+            traitsRfindOf<Traits>(mData, mData + last, rhs.mData, rhs.mSize));
+    }
+
+    size_type find_last_of(CharT ch, size_type pos1 = npos) const noexcept {
+        return rfind(ch, pos1);
+    }
+
+    size_type find_last_of(const CharT* str, size_type pos1,
+                           size_type count2) const noexcept {
+        return find_last_of(basic_string_view{str, count2}, pos1);
+    }
+
+    size_type find_last_of(const CharT* str, size_type pos1 = npos) const {
+        return find_last_of(basic_string_view{str}, pos1);
+    }
+
+private:
+    size_type position(const_pointer p) const noexcept {
+        return p == nullptr ? npos : static_cast<size_type>(p - mData);
+    }
+
+    const_pointer dataEnd() const noexcept {
+        return mData + mSize;
+    }
+
     static XCONSTEXPR14 size_type getStringLength(const_pointer str) noexcept {
         size_type len = Traits::length(str);
         return len;
@@ -639,7 +659,7 @@ struct hash<basic_string_view<CharT, Traits>> {
 
     size_t
     operator()(const basic_string_view<CharT, Traits>& str) const noexcept {
-        return tiny_stl::hashFNV(str.data(), str.size());
+        return tiny_stl::hashString(str.data(), str.size());
     }
 };
 
@@ -7,15 +7,31 @@
 #include <crtdbg.h>
 #endif
 
+#include <algorithm>
 #include <chrono>
 #include <climits>
+#include <cmath>
+#include <cstdio>
 #include <ctime>
 #include <iostream>
+#include <numeric>
+#include <thread>
 
+#include "allocators.hpp"
 #include "array.hpp"
+#include "atomic_shared_ptr.hpp"
+#include "btree_map.hpp"
+#include "btree_set.hpp"
+#include "concurrent_queue.hpp"
+#include "concurrent_unordered_map.hpp"
+#include "cow_intern_pool.hpp"
 #include "cow_string.hpp"
 #include "deque.hpp"
+#include "execution.hpp"
+#include "flat_map.hpp"
+#include "flat_set.hpp"
 #include "forward_list.hpp"
+#include "hash_bytes.hpp"
 #include "iterator.hpp"
 #include "list.hpp"
 #include "map.hpp"
@@ -23,7 +39,10 @@
 #include "queue.hpp"
 #include "rbtree.hpp"
 #include "set.hpp"
+#include "small_vector.hpp"
+#include "snapshot.hpp"
 #include "stack.hpp"
+#include "stats.hpp"
 #include "string.hpp"
 #include "string_view.hpp"
 #include "tuple.hpp"
@@ -202,6 +221,520 @@ void testMemory() {
     UNIT_TEST(42, *sp4);
 }
 
+struct LocalNode {
+    static int alive;
+    int value;
+    tiny_stl::local_shared_ptr<LocalNode> next;
+
+    explicit LocalNode(int v) : value(v) {
+        ++alive;
+    }
+
+    ~LocalNode() {
+        --alive;
+    }
+};
+
+int LocalNode::alive = 0;
+
+void testLocalSharedPtr() {
+    tiny_stl::local_shared_ptr<int> lp0;
+    UNIT_TEST(false, static_cast<bool>(lp0));
+    UNIT_TEST(0, lp0.use_count());
+    UNIT_TEST(true, lp0 == nullptr);
+
+    tiny_stl::local_shared_ptr<int> lp1{new int(42)};
+    UNIT_TEST(1, lp1.use_count());
+    UNIT_TEST(42, *lp1);
+
+    auto lp2 = lp1;
+    UNIT_TEST(2, lp1.use_count());
+    UNIT_TEST(true, lp1 == lp2);
+    auto lp3 = tiny_stl::move(lp2);
+    UNIT_TEST(2, lp3.use_count());
+    UNIT_TEST(true, lp2 == nullptr);
+    lp3.reset();
+    UNIT_TEST(true, lp1.unique());
+
+    {
+        // a chain of nodes from make_local_shared, freed by the head
+        auto head = tiny_stl::make_local_shared<LocalNode>(0);
+        auto node = head;
+        for (int i = 1; i < 100; ++i) {
+            node->next = tiny_stl::make_local_shared<LocalNode>(i);
+            node = node->next;
+        }
+        UNIT_TEST(100, LocalNode::alive);
+        UNIT_TEST(2, node.use_count());
+        UNIT_TEST(99, node->value);
+
+        // aliasing keeps the owner alive
+        tiny_stl::local_shared_ptr<int> value(head, &head->value);
+        head.reset();
+        node.reset();
+        UNIT_TEST(100, LocalNode::alive);
+        UNIT_TEST(0, *value);
+    }
+    UNIT_TEST(0, LocalNode::alive);
+
+    auto ls = tiny_stl::make_local_shared<tiny_stl::string>("local", 3);
+    UNIT_TEST(tiny_stl::string("loc"), *ls);
+    UNIT_TEST(
+        true,
+        tiny_stl::is_trivially_relocatable_v<tiny_stl::local_shared_ptr<int>>);
+}
+
+struct IntrusiveBase : tiny_stl::intrusive_ref_counter<IntrusiveBase> {
+    static int alive;
+
+    IntrusiveBase() {
+        ++alive;
+    }
+
+    virtual ~IntrusiveBase() {
+        --alive;
+    }
+};
+
+int IntrusiveBase::alive = 0;
+
+struct IntrusiveDerived : IntrusiveBase {
+    int value = 7;
+};
+
+struct IntrusivePlain
+    : tiny_stl::intrusive_ref_counter<IntrusivePlain,
+                                      tiny_stl::extra::plain_ref_count> {
+    int value = 3;
+};
+
+void testIntrusivePtr() {
+    {
+        tiny_stl::intrusive_ptr<IntrusiveDerived> d{new IntrusiveDerived};
+        UNIT_TEST(1, d->use_count());
+        tiny_stl::intrusive_ptr<IntrusiveBase> b = d;
+        UNIT_TEST(2, d->use_count());
+        UNIT_TEST(true, b.get() == d.get());
+
+        // a raw pointer from the object makes a new owner
+        tiny_stl::intrusive_ptr<IntrusiveBase> raw{b.get()};
+        UNIT_TEST(3, b->use_count());
+        auto back = tiny_stl::static_pointer_cast<IntrusiveDerived>(raw);
+        UNIT_TEST(7, back->value);
+
+        tiny_stl::intrusive_ptr<IntrusiveBase> moved = tiny_stl::move(b);
+        UNIT_TEST(true, b == nullptr);
+        UNIT_TEST(4, moved->use_count());
+        d.reset();
+        raw.reset();
+        back.reset();
+        UNIT_TEST(1, IntrusiveBase::alive);
+        UNIT_TEST(1, moved->use_count());
+
+        // detach and adopt leave the count alone
+        IntrusiveBase* p = moved.detach();
+        tiny_stl::intrusive_ptr<IntrusiveBase> adopt{p, false};
+        UNIT_TEST(1, adopt->use_count());
+    }
+    UNIT_TEST(0, IntrusiveBase::alive);
+
+    tiny_stl::intrusive_ptr<IntrusivePlain> p1{new IntrusivePlain};
+    auto p2 = p1;
+    UNIT_TEST(2, p1->use_count());
+    p1 = nullptr;
+    UNIT_TEST(1, p2->use_count());
+    UNIT_TEST(3, p2->value);
+    UNIT_TEST(sizeof(void*), sizeof(p2));
+}
+
+struct AtomicConfig {
+    static std::atomic<int> alive;
+    int version;
+    int twice;
+
+    explicit AtomicConfig(int v) : version(v), twice(2 * v) {
+        ++alive;
+    }
+
+    ~AtomicConfig() {
+        --alive;
+    }
+};
+
+std::atomic<int> AtomicConfig::alive{0};
+
+void testAtomicSharedPtr() {
+    using Ptr = tiny_stl::shared_ptr<AtomicConfig>;
+    tiny_stl::atomic_shared_ptr<AtomicConfig> empty;
+    UNIT_TEST(true, empty.is_lock_free());
+    UNIT_TEST(true, empty.load() == nullptr);
+    UNIT_TEST(false, static_cast<bool>(empty.read()));
+
+    tiny_stl::atomic_shared_ptr<AtomicConfig> config{
+        tiny_stl::make_shared<AtomicConfig>(1)};
+    Ptr first = config.load();
+    UNIT_TEST(1, first->version);
+    UNIT_TEST(2, first.use_count());
+    {
+        auto guard = config.read();
+        UNIT_TEST(1, guard->version);
+        // a nested reader in one thread borrows another record
+        UNIT_TEST(3, config.load().use_count());
+    }
+
+    Ptr old = config.exchange(tiny_stl::make_shared<AtomicConfig>(2));
+    UNIT_TEST(true, old == first);
+    UNIT_TEST(2, config.load()->version);
+
+    Ptr expected = first;
+    UNIT_TEST(false, config.compare_exchange_strong(
+                         expected, tiny_stl::make_shared<AtomicConfig>(3)));
+    UNIT_TEST(2, expected->version);
+    UNIT_TEST(true, config.compare_exchange_strong(
+                        expected, tiny_stl::make_shared<AtomicConfig>(3)));
+    UNIT_TEST(3, config.load()->version);
+
+    // an aliasing pointer shares the control block, not the value
+    expected = Ptr(config.load(), nullptr);
+    UNIT_TEST(false, config.compare_exchange_strong(expected, first));
+
+    // readers always see a whole config while one writer replaces it
+    const int kVersions = 20000;
+    std::atomic<bool> done{false};
+    std::atomic<int> torn{0};
+    std::atomic<int> backwards{0};
+    tiny_stl::vector<std::thread> readers;
+    for (int t = 0; t < 3; ++t) {
+        readers.emplace_back([&, t] {
+            int last = 0;
+            while (!done.load()) {
+                int version;
+                if (t == 0) {
+                    auto guard = config.read();
+                    torn += guard->twice != 2 * guard->version;
+                    version = guard->version;
+                } else {
+                    Ptr p = config.load();
+                    torn += p->twice != 2 * p->version;
+                    version = p->version;
+                }
+                backwards += version < last;
+                last = version;
+            }
+        });
+    }
+    for (int v = 4; v < kVersions; ++v)
+        config.store(tiny_stl::make_shared<AtomicConfig>(v));
+    done = true;
+    for (auto& t : readers)
+        t.join();
+    UNIT_TEST(0, torn.load());
+    UNIT_TEST(0, backwards.load());
+    UNIT_TEST(kVersions - 1, config.load()->version);
+
+    // retired configs are freed in batches, not kept around
+    UNIT_TEST(true, AtomicConfig::alive.load() < 200);
+
+    // or when the atomic_shared_ptr which retired them goes away
+    const int before = AtomicConfig::alive.load();
+    {
+        tiny_stl::atomic_shared_ptr<AtomicConfig> scoped(
+            tiny_stl::make_shared<AtomicConfig>(0));
+        for (int v = 1; v < 4; ++v)
+            scoped.store(tiny_stl::make_shared<AtomicConfig>(v));
+        UNIT_TEST(true, AtomicConfig::alive.load() > before);
+    }
+    UNIT_TEST(true, AtomicConfig::alive.load() <= before);
+}
+
+void testAllocators() {
+    tiny_stl::fixed_pool fp(24, 4);
+    UNIT_TEST(32, fp.block_size());
+    void* b1 = fp.allocate();
+    void* b2 = fp.allocate();
+    UNIT_TEST(32, static_cast<char*>(b2) - static_cast<char*>(b1));
+    fp.deallocate(b2);
+    UNIT_TEST(b2, fp.allocate());
+    fp.release();
+
+    // all the nodes come from one pool
+    tiny_stl::node_pool pool;
+    {
+        tiny_stl::pool_allocator<int> alloc(&pool);
+        tiny_stl::list<int, tiny_stl::pool_allocator<int>> l(alloc);
+        tiny_stl::forward_list<int, tiny_stl::pool_allocator<int>> fl(alloc);
+        for (int i = 0; i < 1000; ++i) {
+            l.push_back(i);
+            fl.push_front(i);
+        }
+        UNIT_TEST(1000, l.size());
+        UNIT_TEST(999, l.back());
+        UNIT_TEST(999, fl.front());
+        l.clear();
+        for (int i = 0; i < 10; ++i)
+            l.push_back(i);
+        UNIT_TEST(45, std::accumulate(l.begin(), l.end(), 0));
+
+        using PairAlloc = tiny_stl::pool_allocator<
+            tiny_stl::pair<const int, tiny_stl::string>>;
+        tiny_stl::map<int, tiny_stl::string, tiny_stl::less<int>, PairAlloc> m{
+            tiny_stl::less<int>(), PairAlloc(alloc)};
+        for (int i = 0; i < 500; ++i)
+            m[i] = tiny_stl::to_string(i);
+        for (int i = 0; i < 500; i += 2)
+            m.erase(i);
+        UNIT_TEST(250, m.size());
+        UNIT_TEST(tiny_stl::string("333"), m[333]);
+        UNIT_TEST(true, m.get_allocator() == alloc);
+    }
+    pool.release();
+
+    tiny_stl::pool_allocator<double> dalloc;
+    UNIT_TEST(true, dalloc == tiny_stl::pool_allocator<char>());
+    UNIT_TEST(true, dalloc != tiny_stl::pool_allocator<char>(&pool));
+    double* big = dalloc.allocate(1000); // not pooled
+    big[999] = 1.5;
+    UNIT_TEST(1.5, big[999]);
+    dalloc.deallocate(big, 1000);
+
+    // the default pool is per thread
+    bool otherPool = false;
+    std::thread other([&otherPool, dalloc] {
+        tiny_stl::list<int, tiny_stl::pool_allocator<int>> l(10, 1);
+        otherPool = l.get_allocator() != dalloc && l.size() == 10;
+    });
+    other.join();
+    UNIT_TEST(true, otherPool);
+
+    // memory from the stack first, then from chunks
+    alignas(16) char buffer[512];
+    {
+        tiny_stl::arena ar(buffer, sizeof(buffer));
+        tiny_stl::arena_allocator<int> alloc(&ar);
+        int* p = alloc.allocate(4);
+        UNIT_TEST(static_cast<void*>(buffer), static_cast<void*>(p));
+        tiny_stl::list<int, tiny_stl::arena_allocator<int>> l(alloc);
+        for (int i = 0; i < 1000; ++i)
+            l.push_back(i);
+        UNIT_TEST(1000, l.size());
+        UNIT_TEST(499500, std::accumulate(l.begin(), l.end(), 0));
+        void* q = ar.allocate(1, 64);
+        UNIT_TEST(0, reinterpret_cast<uintptr_t>(q) % 64);
+
+        // the chunk size would wrap
+        bool thrown = false;
+        try {
+            ar.allocate(SIZE_MAX - 8);
+        } catch (const std::bad_alloc&) {
+            thrown = true;
+        }
+        UNIT_TEST(true, thrown);
+    }
+
+    // a block freed by another thread goes to the cache of that thread
+    tiny_stl::thread_cache_allocator<int> talloc;
+    tiny_stl::list<int, tiny_stl::thread_cache_allocator<int>> tl;
+    for (int i = 0; i < 1000; ++i)
+        tl.push_back(i);
+    int sum = 0;
+    std::thread worker([&tl, &sum] {
+        tiny_stl::list<int, tiny_stl::thread_cache_allocator<int>> local;
+        local.swap(tl);
+        sum = std::accumulate(local.begin(), local.end(), 0);
+    });
+    worker.join();
+    UNIT_TEST(499500, sum);
+    UNIT_TEST(true, tl.empty());
+    int* tp = talloc.allocate(1);
+    *tp = 7;
+    UNIT_TEST(7, *tp);
+    talloc.deallocate(tp, 1);
+}
+
+// count the bytes from upstream
+class CountResource : public tiny_stl::pmr::memory_resource {
+public:
+    size_t bytes = 0;
+    size_t count = 0;
+    size_t total = 0; // allocate() calls
+
+private:
+    void* do_allocate(size_t n, size_t align) override {
+        bytes += n;
+        ++count;
+        ++total;
+        return tiny_stl::pmr::new_delete_resource()->allocate(n, align);
+    }
+
+    void do_deallocate(void* p, size_t n, size_t align) override {
+        bytes -= n;
+        --count;
+        tiny_stl::pmr::new_delete_resource()->deallocate(p, n, align);
+    }
+
+    bool do_is_equal(const memory_resource& rhs) const noexcept override {
+        return this == &rhs;
+    }
+};
+
+void testPmr() {
+    namespace pmr = tiny_stl::pmr;
+
+    // containers on a stack buffer, no allocation from upstream
+    alignas(16) char buffer[4096];
+    {
+        pmr::monotonic_buffer_resource mono(buffer, sizeof(buffer),
+                                            pmr::null_memory_resource());
+        pmr::vector<int> v(&mono);
+        pmr::list<int> l(&mono);
+        pmr::map<int, int> m(&mono);
+        for (int i = 0; i < 50; ++i) {
+            v.push_back(i);
+            l.push_back(i);
+            m[i] = i * i;
+        }
+        UNIT_TEST(1225, std::accumulate(v.begin(), v.end(), 0));
+        UNIT_TEST(1225, std::accumulate(l.begin(), l.end(), 0));
+        UNIT_TEST(49 * 49, m[49]);
+        UNIT_TEST(true, m.get_allocator().resource() == &mono);
+
+        bool thrown = false;
+        try {
+            mono.allocate(sizeof(buffer));
+        } catch (const std::bad_alloc&) {
+            thrown = true;
+        }
+        UNIT_TEST(true, thrown);
+    }
+
+    // the elements use the allocator of the container
+    CountResource cnt;
+    {
+        pmr::monotonic_buffer_resource mono(&cnt);
+        pmr::vector<pmr::string> v(&mono);
+        v.emplace_back("a string which does not fit in the small buffer");
+        v.push_back(pmr::string("short"));
+        UNIT_TEST(true, v[0].get_allocator().resource() == &mono);
+        UNIT_TEST(true, v[1].get_allocator().resource() == &mono);
+        UNIT_TEST(true, cnt.count > 0);
+
+        // the chunk size would wrap
+        bool thrown = false;
+        try {
+            mono.allocate(SIZE_MAX - 8);
+        } catch (const std::bad_alloc&) {
+            thrown = true;
+        }
+        UNIT_TEST(true, thrown);
+
+        {
+            pmr::unordered_map<int, int> um(&mono);
+            pmr::deque<int> dq(&mono);
+            pmr::set<int> st(&mono);
+            for (int i = 0; i < 1000; ++i) {
+                um[i] = i;
+                dq.push_front(i);
+                st.insert(i);
+            }
+            UNIT_TEST(1000, um.size());
+            UNIT_TEST(999, dq.front());
+            UNIT_TEST(999, *st.rbegin());
+        }
+        v.clear();
+        v.shrink_to_fit();
+        mono.release();
+        UNIT_TEST(0, cnt.bytes);
+    }
+
+    // move between resources, the elements are moved individually
+    {
+        pmr::unsynchronized_pool_resource r1(&cnt), r2(&cnt);
+        pmr::vector<int> v1({1, 2, 3}, &r1), v2(&r2);
+        pmr::deque<int> d1({1, 2, 3}, &r1), d2(&r2);
+        pmr::list<int> l1({1, 2, 3}, &r1), l2(&r2);
+        pmr::set<int> s1({1, 2, 3}, &r1), s2(&r2);
+        pmr::unordered_set<int> u1({1, 2, 3}, 0, &r1), u2(&r2);
+        v2 = tiny_stl::move(v1);
+        d2 = tiny_stl::move(d1);
+        l2 = tiny_stl::move(l1);
+        s2 = tiny_stl::move(s1);
+        u2 = tiny_stl::move(u1);
+        UNIT_TEST(true, v2.get_allocator().resource() == &r2);
+        UNIT_TEST(true, d2.get_allocator().resource() == &r2);
+        UNIT_TEST(true, s2.get_allocator().resource() == &r2);
+        UNIT_TEST(6, std::accumulate(v2.begin(), v2.end(), 0));
+        UNIT_TEST(6, std::accumulate(d2.begin(), d2.end(), 0));
+        UNIT_TEST(6, std::accumulate(l2.begin(), l2.end(), 0));
+        UNIT_TEST(6, std::accumulate(s2.begin(), s2.end(), 0));
+        UNIT_TEST(3, u2.size());
+        UNIT_TEST(true, s1.empty());
+
+        pmr::set<int> s3(tiny_stl::move(s2), &r1);
+        UNIT_TEST(3, s3.size());
+        UNIT_TEST(true, s3.get_allocator().resource() == &r1);
+
+        // a copy uses the default resource
+        pmr::vector<int> v3(v2);
+        UNIT_TEST(true, v3.get_allocator().resource() ==
+                            pmr::get_default_resource());
+    }
+    UNIT_TEST(0, cnt.bytes);
+
+    // freed blocks are reused
+    {
+        pmr::unsynchronized_pool_resource pool(&cnt);
+        void* p1 = pool.allocate(24);
+        pool.deallocate(p1, 24);
+        UNIT_TEST(p1, pool.allocate(24));
+        void* big = pool.allocate(1 << 20, 64);
+        UNIT_TEST(0, reinterpret_cast<uintptr_t>(big) % 64);
+        void* aligned = pool.allocate(8, 128);
+        UNIT_TEST(0, reinterpret_cast<uintptr_t>(aligned) % 128);
+        pool.deallocate(aligned, 8, 128);
+        UNIT_TEST(true, cnt.bytes > (1 << 20));
+
+        // past every size class, no pool is searched
+        bool thrown = false;
+        try {
+            pool.allocate(SIZE_MAX - 8);
+        } catch (const std::bad_alloc&) {
+            thrown = true;
+        }
+        UNIT_TEST(true, thrown);
+    }
+    UNIT_TEST(0, cnt.bytes);
+
+    {
+        pmr::synchronized_pool_resource pool(&cnt);
+        auto work = [&pool] {
+            pmr::list<int> l(&pool);
+            for (int i = 0; i < 1000; ++i)
+                l.push_back(i);
+            return std::accumulate(l.begin(), l.end(), 0);
+        };
+        int sum = 0;
+        std::thread worker([&work, &sum] { sum = work(); });
+        int local = work();
+        worker.join();
+        UNIT_TEST(499500, sum);
+        UNIT_TEST(499500, local);
+    }
+    UNIT_TEST(0, cnt.bytes);
+
+    pmr::memory_resource* old = pmr::set_default_resource(&cnt);
+    {
+        pmr::vector<int> v{1, 2, 3};
+        UNIT_TEST(true, v.get_allocator().resource() == &cnt);
+        UNIT_TEST(true, cnt.bytes >= 3 * sizeof(int));
+    }
+    UNIT_TEST(&cnt, pmr::set_default_resource(old));
+    UNIT_TEST(0, cnt.bytes);
+    UNIT_TEST(true, *pmr::new_delete_resource() ==
+                        *pmr::new_delete_resource());
+    UNIT_TEST(true, *pmr::new_delete_resource() !=
+                        *pmr::null_memory_resource());
+}
+
 void testAlgorithm() {
     tiny_stl::vector<int> v1 = {1, 2, 3, 4, 2};
     UNIT_TEST(true, tiny_stl::is_sorted(v1.begin(), v1.end() - 1));
@@ -249,6 +782,69 @@ void testAlgorithm() {
     tiny_stl::sort(vs.begin(), vs.end());
     UNIT_TEST(true, tiny_stl::is_sorted(vs.begin(), vs.end()));
 
+    // random, sorted, reversed, organ pipe and few distinct values
+    const int kSortSize = 10000;
+    for (int pattern = 0; pattern < 5; ++pattern) {
+        tiny_stl::vector<int> in(kSortSize);
+        for (int i = 0; i < kSortSize; ++i) {
+            switch (pattern) {
+            case 0: in[i] = rand(); break;
+            case 1: in[i] = i; break;
+            case 2: in[i] = kSortSize - i; break;
+            case 3: in[i] = i < kSortSize / 2 ? i : kSortSize - i; break;
+            default: in[i] = rand() % 4; break;
+            }
+        }
+
+        tiny_stl::vector<int> expect = in;
+        std::sort(expect.begin(), expect.end());
+
+        tiny_stl::vector<int> out = in;
+        tiny_stl::sort(out.begin(), out.end());
+        UNIT_TEST(true, out == expect);
+
+        out = in;
+        tiny_stl::sort(out.begin(), out.end(), tiny_stl::greater<int>());
+        UNIT_TEST(true, tiny_stl::equal(out.rbegin(), out.rend(),
+                                        expect.begin()));
+
+        // no branchless partition for a lambda, count the comparisons
+        long long cmpCount = 0;
+        out = in;
+        tiny_stl::sort(out.begin(), out.end(),
+                       [&cmpCount](int x, int y) {
+                           ++cmpCount;
+                           return x < y;
+                       });
+        UNIT_TEST(true, out == expect);
+        UNIT_TEST(true, cmpCount < 3LL * kSortSize * 14);
+        if (pattern == 1 || pattern == 2)
+            UNIT_TEST(true, cmpCount < 4LL * kSortSize);
+    }
+
+    tiny_stl::vector<tiny_stl::string> strs;
+    for (int i = 0; i < 1000; ++i)
+        strs.push_back(tiny_stl::to_string(rand() % 500));
+    tiny_stl::sort(strs.begin(), strs.end());
+    UNIT_TEST(true, tiny_stl::is_sorted(strs.begin(), strs.end()));
+
+    // the heap sort fallback uses the comparator
+    tiny_stl::vector<double> hv = {0.5, 3.5, -1.0, 2.0, 8.0, 1.0, 7.5};
+    tiny_stl::make_heap(hv.begin(), hv.end(), tiny_stl::greater<>());
+    UNIT_TEST(-1.0, hv.front());
+    tiny_stl::sort_heap(hv.begin(), hv.end(), tiny_stl::greater<>());
+    UNIT_TEST(true, tiny_stl::is_sorted(hv.begin(), hv.end(),
+                                        tiny_stl::greater<>()));
+
+    tiny_stl::vector<int> bv = {1, 2, 2, 2, 5, 7};
+    UNIT_TEST(true, tiny_stl::binary_search(bv.begin(), bv.end(), 5));
+    UNIT_TEST(false, tiny_stl::binary_search(bv.begin(), bv.end(), 3));
+    auto br = tiny_stl::equal_range(bv.begin(), bv.end(), 2);
+    UNIT_TEST(1, br.first - bv.begin());
+    UNIT_TEST(4, br.second - bv.begin());
+    br = tiny_stl::equal_range(bv.begin(), bv.end(), 6);
+    UNIT_TEST(true, br.first == br.second && *br.first == 7);
+
 #if 0
     tiny_stl::vector<int> bigNums(100'000'000);
     for (int i = 0; i < 100'000'000; ++i)
@@ -266,6 +862,176 @@ void testAlgorithm() {
 #endif
 }
 
+void testTrivialCopy() {
+    using tiny_stl::ContiguousIterator;
+    UNIT_TEST(true, ContiguousIterator<int*>::value);
+    using IntVector = tiny_stl::vector<int>;
+    UNIT_TEST(true, ContiguousIterator<IntVector::iterator>::value);
+    using StrIter = tiny_stl::string::const_iterator;
+    UNIT_TEST(true, ContiguousIterator<StrIter>::value);
+    using IntArray = tiny_stl::array<int, 8>;
+    UNIT_TEST(true, ContiguousIterator<IntArray::iterator>::value);
+    using DequeIter = tiny_stl::deque<int>::iterator;
+    UNIT_TEST(false, ContiguousIterator<DequeIter>::value);
+    UNIT_TEST(false, ContiguousIterator<tiny_stl::list<int>::iterator>::value);
+
+    // memmove from vector, array and string iterators, a loop from list
+    IntArray arr = {1, 2, 3, 4, 5, 6, 7, 8};
+    tiny_stl::vector<int> v(8);
+    UNIT_TEST(true, tiny_stl::copy(arr.cbegin(), arr.cend(), v.begin()) ==
+                        v.end());
+    UNIT_TEST(true, tiny_stl::equal(v.begin(), v.end(), arr.begin()));
+    tiny_stl::list<int> l(v.begin(), v.end());
+    int raw[8] = {};
+    UNIT_TEST(raw + 8, tiny_stl::copy_n(l.begin(), 8, raw));
+    UNIT_TEST(true, tiny_stl::equal(raw, raw + 8, arr.begin()));
+    UNIT_TEST(raw + 3, tiny_stl::copy_n(arr.cbegin() + 5, 3, raw));
+    UNIT_TEST(8, raw[2]);
+    UNIT_TEST(true,
+              tiny_stl::copy_n(v.begin(), 0, arr.begin()) == arr.begin());
+    tiny_stl::string s = "contiguous";
+    char buf[16] = {};
+    tiny_stl::copy(s.cbegin(), s.cend(), buf);
+    UNIT_TEST(s, buf);
+
+    // overlapping ranges
+    auto dstFirst = tiny_stl::copy_backward(v.begin(), v.begin() + 6, v.end());
+    UNIT_TEST(true, dstFirst == v.begin() + 2);
+    UNIT_TEST(1, v[2]);
+    UNIT_TEST(6, v[7]);
+    UNIT_TEST(true,
+              tiny_stl::move(v.begin() + 2, v.end(), v.begin()) == v.end() - 2);
+    UNIT_TEST(1, v[0]);
+    UNIT_TEST(6, v[5]);
+    tiny_stl::move_backward(raw, raw + 4, raw + 5);
+    UNIT_TEST(6, raw[1]);
+
+    // fill by memset for bytes and zero values only
+    char chars[5];
+    tiny_stl::fill(chars, chars + 5, 'x');
+    UNIT_TEST(true, tiny_stl::all_of(chars, chars + 5,
+                                     [](char c) { return c == 'x'; }));
+    tiny_stl::vector<double> dv(4, 1.5);
+    tiny_stl::fill(dv.begin(), dv.end(), 0);
+    UNIT_TEST(0.0, dv[3]);
+    tiny_stl::fill_n(dv.begin(), 2, -0.0);
+    UNIT_TEST(true, std::signbit(dv[0]) && std::signbit(dv[1]));
+    UNIT_TEST(false, std::signbit(dv[2]));
+    int x = 0;
+    int* ptrs[3] = {&x, &x, &x};
+    tiny_stl::fill(ptrs, ptrs + 3, nullptr);
+    UNIT_TEST(true, ptrs[2] == nullptr);
+
+    // the iterator value type decides, not the argument: no assignment to
+    // a string that is not constructed
+    void* storage = ::operator new(3 * sizeof(tiny_stl::string));
+    auto strs = static_cast<tiny_stl::string*>(storage);
+    tiny_stl::uninitialized_fill(strs, strs + 3, "fill");
+    UNIT_TEST("fill", strs[2]);
+    tiny_stl::destroy(strs, strs + 3);
+    tiny_stl::string from[2] = {"a long string out of the small buffer", "b"};
+    tiny_stl::uninitialized_copy(from, from + 2, strs);
+    UNIT_TEST(from[0], strs[0]);
+    tiny_stl::destroy(strs, strs + 2);
+    ::operator delete(storage);
+
+    tiny_stl::vector<tiny_stl::vector<int>> nested(3, v);
+    tiny_stl::vector<tiny_stl::vector<int>> nestedCopy = nested;
+    UNIT_TEST(true, nestedCopy[2] == v);
+}
+
+void testExecution() {
+    namespace ex = tiny_stl::execution;
+    UNIT_TEST(true, tiny_stl::is_execution_policy_v<ex::parallel_policy>);
+    UNIT_TEST(false, tiny_stl::is_execution_policy_v<int>);
+
+    // more workers than cores still splits the work
+    tiny_stl::thread_pool pool(3);
+    tiny_stl::thread_pool* old = tiny_stl::set_default_thread_pool(&pool);
+    UNIT_TEST(3, tiny_stl::default_thread_pool().size());
+
+    const int n = 300000;
+    tiny_stl::vector<int> v(n);
+    tiny_stl::fill(ex::par, v.begin(), v.end(), 1);
+    UNIT_TEST(n, tiny_stl::count(ex::par, v.begin(), v.end(), 1));
+
+    std::atomic<long long> sum{0};
+    tiny_stl::for_each(ex::par_unseq, v.begin(), v.end(),
+                       [&sum](int x) { sum += x; });
+    UNIT_TEST(n, sum.load());
+
+    for (int i = 0; i < n; ++i)
+        v[i] = static_cast<int>(i * 7919LL % n);
+    tiny_stl::vector<int> w(n);
+    tiny_stl::transform(ex::par, v.begin(), v.end(), w.begin(),
+                        [](int x) { return x * 2; });
+    UNIT_TEST(true, w[12345] == v[12345] * 2);
+    tiny_stl::transform(ex::par, v.begin(), v.end(), w.begin(), w.begin(),
+                        [](int x, int y) { return y - x; });
+    UNIT_TEST(true, tiny_stl::equal(v.begin(), v.end(), w.begin()));
+
+    tiny_stl::vector<int> c(n);
+    tiny_stl::copy(ex::par, v.begin(), v.end(), c.begin());
+    UNIT_TEST(true, c == v);
+    UNIT_TEST(n / 2, tiny_stl::count_if(ex::par, v.begin(), v.end(),
+                                        [](int x) { return x % 2 == 0; }));
+
+    // the first match, not the first one found
+    v[200000] = -1;
+    v[100000] = -1;
+    auto it = tiny_stl::find_if(ex::par, v.begin(), v.end(),
+                                [](int x) { return x < 0; });
+    UNIT_TEST(100000, it - v.begin());
+    UNIT_TEST(true, tiny_stl::find_if(ex::par, v.begin(), v.end(), [](int x) {
+                        return x > n;
+                    }) == v.end());
+
+    // the first smallest and the last largest
+    v[250000] = -1;
+    v[10] = n;
+    v[290000] = n;
+    auto mm = tiny_stl::minmax_element(ex::par, v.begin(), v.end());
+    UNIT_TEST(100000, mm.first - v.begin());
+    UNIT_TEST(290000, mm.second - v.begin());
+
+    for (int pattern = 0; pattern < 3; ++pattern) {
+        for (int i = 0; i < n; ++i)
+            v[i] = pattern == 0 ? rand() : pattern == 1 ? n - i : rand() % 3;
+        c = v;
+        std::sort(c.begin(), c.end());
+        tiny_stl::sort(ex::par, v.begin(), v.end());
+        UNIT_TEST(true, c == v);
+    }
+    tiny_stl::sort(ex::par, v.begin(), v.end(), tiny_stl::greater<>());
+    UNIT_TEST(true, tiny_stl::is_sorted(v.begin(), v.end(),
+                                        tiny_stl::greater<>()));
+
+    tiny_stl::vector<tiny_stl::string> strs;
+    for (int i = 0; i < 100000; ++i)
+        strs.push_back(tiny_stl::to_string(rand()));
+    tiny_stl::sort(ex::par, strs.begin(), strs.end());
+    UNIT_TEST(true, tiny_stl::is_sorted(strs.begin(), strs.end()));
+
+    // not random access, sequential
+    tiny_stl::list<int> l(1000, 3);
+    UNIT_TEST(1000, tiny_stl::count(ex::par, l.begin(), l.end(), 3));
+    tiny_stl::fill(ex::seq, l.begin(), l.end(), 4);
+    UNIT_TEST(4, l.back());
+
+    bool thrown = false;
+    try {
+        tiny_stl::for_each(ex::par, v.begin(), v.end(), [](int x) {
+            if (x == 0)
+                throw "zero";
+        });
+    } catch (const char*) {
+        thrown = true;
+    }
+    UNIT_TEST(true, thrown);
+
+    UNIT_TEST(&pool, tiny_stl::set_default_thread_pool(old));
+}
+
 void testArray() {
     tiny_stl::array<std::int32_t, 10> arr;
     arr.assign(42);
@@ -310,6 +1076,15 @@ void testArray() {
 void testVector() {
     tiny_stl::vector<int> v;
     UNIT_TEST(0, v.size());
+    tiny_stl::vector<tiny_stl::string> vs(3);
+    UNIT_TEST(3, vs.size());
+    UNIT_TEST(true, vs[2].empty());
+    vs.reserve(8);
+    vs.insert(vs.begin(), tiny_stl::string(40, 'a'));
+    vs.insert(vs.begin() + 1, vs[0]);
+    UNIT_TEST(5, vs.size());
+    UNIT_TEST(40, vs[1].size());
+    UNIT_TEST(true, vs[4].empty());
     tiny_stl::vector<int> v1(3, 42);
     UNIT_TEST(3, v1.size());
     UNIT_TEST(3, v1.capacity());
@@ -406,6 +1181,437 @@ void testVector() {
     UNIT_TEST(42, v16.back());
 }
 
+// counts moves, a copy throws when throwAt reaches 0
+struct Relocated {
+    static int moves;
+    static int throwAt;
+
+    int val;
+
+    Relocated(int v) : val(v) {
+    }
+
+    Relocated(const Relocated& rhs) : val(rhs.val) {
+        if (--throwAt == 0)
+            throw "Relocated";
+    }
+
+    Relocated(Relocated&& rhs) noexcept : val(rhs.val) {
+        ++moves;
+    }
+
+    Relocated& operator=(const Relocated&) = default;
+
+    ~Relocated() {
+    }
+};
+
+int Relocated::moves = 0;
+int Relocated::throwAt = 0;
+
+namespace tiny_stl {
+
+template <>
+struct is_trivially_relocatable<Relocated> : true_type {};
+
+} // namespace tiny_stl
+
+// points into itself, so it cannot be relocated by bytes
+struct SelfPointer {
+    SelfPointer* self;
+    int val;
+
+    SelfPointer(int v) : self(this), val(v) {
+    }
+
+    SelfPointer(const SelfPointer& rhs) : self(this), val(rhs.val) {
+    }
+
+    SelfPointer& operator=(const SelfPointer& rhs) {
+        val = rhs.val;
+        return *this;
+    }
+};
+
+// edit a vector<bool> and a byte-per-flag vector the same way
+void testVectorBool() {
+    using Bits = tiny_stl::vector<bool>;
+    Bits b0;
+    UNIT_TEST(true, b0.empty());
+    Bits b1(130, true);
+    UNIT_TEST(130, b1.size());
+    UNIT_TEST(192, b1.capacity());
+    UNIT_TEST(true, b1[129]);
+    b1[64] = false;
+    b1.back().flip();
+    UNIT_TEST(false, b1.at(64));
+    UNIT_TEST(false, b1.back());
+    UNIT_TEST(128, tiny_stl::count(b1.begin(), b1.end(), true));
+
+    Bits b2{true, false, true};
+    Bits b3 = b2;
+    UNIT_TEST(true, b2 == b3);
+    b3.flip();
+    UNIT_TEST(false, b3[0]);
+    UNIT_TEST(true, b3[1]);
+    swap(b3[0], b3[1]);
+    UNIT_TEST(true, b3[0]);
+
+    tiny_stl::vector<char> ref;
+    Bits bits;
+    int mismatch = 0;
+    auto same = [&]() {
+        if (ref.size() != bits.size())
+            return false;
+        for (size_t i = 0; i < ref.size(); ++i)
+            if ((ref[i] != 0) != bits[i])
+                return false;
+        return true;
+    };
+    srand(25);
+    for (int step = 0; step < 2000; ++step) {
+        const size_t pos = ref.empty() ? 0 : rand() % (ref.size() + 1);
+        const bool val = rand() % 3 == 0;
+        switch (rand() % 6) {
+        case 0:
+            ref.push_back(val);
+            bits.push_back(val);
+            break;
+        case 1: {
+            const size_t n = rand() % 150;
+            ref.insert(ref.begin() + pos, n, val);
+            bits.insert(bits.begin() + pos, n, val);
+            break;
+        }
+        case 2: {
+            const size_t n = rand() % 100;
+            const size_t end = pos + n < ref.size() ? pos + n : ref.size();
+            ref.erase(ref.begin() + pos, ref.begin() + end);
+            bits.erase(bits.begin() + pos, bits.begin() + end);
+            break;
+        }
+        case 3:
+            if (ref.size() > 3000) {
+                ref.resize(pos);
+                bits.resize(pos);
+            } else {
+                ref.resize(pos + 50, val);
+                bits.resize(pos + 50, val);
+            }
+            break;
+        case 4:
+            if (!ref.empty() && pos < ref.size()) {
+                ref[pos] = !ref[pos];
+                bits[pos].flip();
+            }
+            break;
+        default: {
+            // the word-level algorithms on a random sub-range
+            const size_t end = pos + rand() % (ref.size() - pos + 1);
+            auto rf = ref.begin() + pos, rl = ref.begin() + end;
+            auto bf = bits.begin() + pos, bl = bits.begin() + end;
+            mismatch += tiny_stl::count(rf, rl, val ? 1 : 0) !=
+                        tiny_stl::count(bf, bl, val);
+            mismatch += (tiny_stl::find(rf, rl, val ? 1 : 0) - rf) !=
+                        (tiny_stl::find(bf, bl, val) - bf);
+            auto isTrue = [](bool x) { return x; };
+            auto isByte = [](char x) { return x != 0; };
+            mismatch += tiny_stl::all_of(rf, rl, isByte) !=
+                        tiny_stl::all_of(bf, bl, isTrue);
+            mismatch += tiny_stl::any_of(rf, rl, isByte) !=
+                        tiny_stl::any_of(bf, bl, isTrue);
+            mismatch += tiny_stl::none_of(rf, rl, isByte) !=
+                        tiny_stl::none_of(bf, bl, isTrue);
+            tiny_stl::fill(rf, rl, !val);
+            tiny_stl::fill(bf, bl, !val);
+            break;
+        }
+        }
+        mismatch += !same();
+    }
+    UNIT_TEST(0, mismatch);
+
+    // copy at every pair of bit offsets
+    Bits src(300), dst;
+    for (size_t i = 0; i < src.size(); ++i)
+        src[i] = (i * 7 + i / 5) % 3 == 0;
+    mismatch = 0;
+    for (int from = 0; from < 64; from += 9) {
+        for (int to = 0; to < 64; to += 7) {
+            dst.assign(400, false);
+            auto last = tiny_stl::copy(src.cbegin() + from, src.cend() - 5,
+                                       dst.begin() + to);
+            mismatch += (last - dst.begin()) != 295 - from + to;
+            for (int i = from; i < 295; ++i)
+                mismatch += src[i] != dst[i - from + to];
+            mismatch += to > 0 && dst[to - 1];
+        }
+    }
+    UNIT_TEST(0, mismatch);
+#ifndef TINY_STL_STATS
+    UNIT_TEST(true, sizeof(Bits) <= 5 * sizeof(void*));
+#endif
+}
+
+void testRelocatable() {
+    using tiny_stl::is_trivially_relocatable_v;
+    UNIT_TEST(true, is_trivially_relocatable_v<int>);
+    UNIT_TEST(true, is_trivially_relocatable_v<tiny_stl::unique_ptr<int>>);
+    UNIT_TEST(true, is_trivially_relocatable_v<tiny_stl::shared_ptr<int>>);
+    UNIT_TEST(true, is_trivially_relocatable_v<tiny_stl::string>);
+    UNIT_TEST(true, is_trivially_relocatable_v<tiny_stl::vector<int>>);
+    UNIT_TEST(false, is_trivially_relocatable_v<SelfPointer>);
+    UNIT_TEST(false, (is_trivially_relocatable_v<
+                         tiny_stl::small_vector<int, 4>>));
+
+    // no move constructor is called to grow, insert or erase
+    Relocated::moves = 0;
+    tiny_stl::vector<Relocated> vr;
+    for (int i = 0; i < 100; ++i)
+        vr.emplace_back(i);
+    vr.emplace(vr.begin() + 10, -1);
+    vr.insert(vr.begin(), 2, Relocated(-2));
+    vr.insert(vr.begin() + 1, vr[50]);
+    vr.erase(vr.begin() + 3, vr.begin() + 5);
+    vr.erase(vr.begin());
+    vr.shrink_to_fit();
+    UNIT_TEST(0, Relocated::moves);
+    UNIT_TEST(101, vr.size());
+    UNIT_TEST(47, vr[0].val);
+    UNIT_TEST(-2, vr[1].val);
+    UNIT_TEST(2, vr[2].val);
+    UNIT_TEST(-1, vr[10].val);
+    UNIT_TEST(99, vr.back().val);
+
+    // a copy throws while the tail is shifted, the vector is unchanged
+    tiny_stl::vector<Relocated> vr2;
+    vr2.reserve(16);
+    for (int i = 0; i < 6; ++i)
+        vr2.emplace_back(i);
+    const tiny_stl::vector<int> src = {10, 11, 12};
+    Relocated::throwAt = 2;
+    bool thrown = false;
+    try {
+        tiny_stl::vector<Relocated> tmp(src.begin(), src.end());
+        Relocated::throwAt = 2;
+        vr2.insert(vr2.begin() + 2, tmp.begin(), tmp.end());
+    } catch (const char*) {
+        thrown = true;
+    }
+    Relocated::throwAt = 0;
+    UNIT_TEST(true, thrown);
+    UNIT_TEST(6, vr2.size());
+    int mismatch = 0;
+    for (int i = 0; i < 6; ++i)
+        mismatch += vr2[i].val != i;
+    UNIT_TEST(0, mismatch);
+
+    // same when it reallocates
+    thrown = false;
+    try {
+        Relocated::throwAt = 5;
+        vr2.insert(vr2.begin() + 1, 12, Relocated(7));
+    } catch (const char*) {
+        thrown = true;
+    }
+    Relocated::throwAt = 0;
+    UNIT_TEST(true, thrown);
+    UNIT_TEST(6, vr2.size());
+    UNIT_TEST(16, vr2.capacity());
+    UNIT_TEST(5, vr2.back().val);
+
+    tiny_stl::vector<tiny_stl::unique_ptr<int>> vp;
+    for (int i = 0; i < 20; ++i)
+        vp.push_back(tiny_stl::make_unique<int>(i));
+    vp.emplace(vp.begin() + 5, new int(-1));
+    vp.erase(vp.begin(), vp.begin() + 2);
+    UNIT_TEST(19, vp.size());
+    UNIT_TEST(2, *vp[0]);
+    UNIT_TEST(-1, *vp[3]);
+    UNIT_TEST(19, *vp.back());
+
+    tiny_stl::vector<tiny_stl::string> vs;
+    for (int i = 0; i < 20; ++i)
+        vs.push_back(tiny_stl::string(i % 2 ? 30 : 3, 'a' + i));
+    vs.insert(vs.begin() + 1, vs[10]);
+    vs.erase(vs.begin() + 2);
+    UNIT_TEST(20, vs.size());
+    UNIT_TEST(tiny_stl::string(3, 'k'), vs[1]);
+    UNIT_TEST(tiny_stl::string(3, 'c'), vs[2]);
+    UNIT_TEST(tiny_stl::string(30, 't'), vs.back());
+
+    tiny_stl::small_vector<tiny_stl::string, 2> svs;
+    for (int i = 0; i < 10; ++i)
+        svs.emplace_back(20, 'a' + i);
+    svs.erase(svs.begin() + 1);
+    UNIT_TEST(9, svs.size());
+    UNIT_TEST(tiny_stl::string(20, 'c'), svs[1]);
+
+    // the generic path still moves element by element
+    tiny_stl::vector<SelfPointer> vsp;
+    for (int i = 0; i < 20; ++i)
+        vsp.emplace_back(i);
+    vsp.insert(vsp.begin() + 3, 4, SelfPointer(-1));
+    const tiny_stl::vector<int> src2 = {-2, -3};
+    vsp.insert(vsp.begin() + 1, src2.begin(), src2.end());
+    vsp.erase(vsp.begin());
+    mismatch = 0;
+    for (const auto& x : vsp)
+        mismatch += x.self != &x;
+    UNIT_TEST(0, mismatch);
+    UNIT_TEST(25, vsp.size());
+    UNIT_TEST(-2, vsp[0].val);
+    UNIT_TEST(-1, vsp[4].val);
+    UNIT_TEST(19, vsp.back().val);
+
+    // the filled value is an element which the shift moves
+    tiny_stl::vector<SelfPointer> vsp2;
+    vsp2.reserve(16);
+    for (int i = 0; i < 6; ++i)
+        vsp2.emplace_back(i);
+    vsp2.insert(vsp2.begin() + 1, 2, vsp2[4]); // move backward
+    vsp2.insert(vsp2.begin() + 6, 3, vsp2[7]); // no move backward
+    mismatch = 0;
+    const int expect[] = {0, 4, 4, 1, 2, 3, 5, 5, 5, 4, 5};
+    for (size_t i = 0; i < vsp2.size(); ++i)
+        mismatch += vsp2[i].val != expect[i];
+    UNIT_TEST(11, vsp2.size());
+    UNIT_TEST(0, mismatch);
+}
+
+void testSmallVector() {
+    CountResource res;
+    {
+        tiny_stl::pmr::small_vector<tiny_stl::string, 4> sv(&res);
+        UNIT_TEST(true, sv.is_inline());
+        UNIT_TEST(4, sv.capacity());
+        for (int i = 0; i < 4; ++i)
+            sv.emplace_back(1, static_cast<char>('a' + i));
+        UNIT_TEST(0, res.total);
+        UNIT_TEST(true, sv.is_inline());
+        sv.push_back(sv[0]); // the argument lives in the old buffer
+        UNIT_TEST(false, sv.is_inline());
+        UNIT_TEST(1, res.count);
+        UNIT_TEST(8, sv.capacity());
+        UNIT_TEST("a", sv.back());
+        sv.insert(sv.begin() + 1, 2, "x");
+        sv.erase(sv.begin() + 4, sv.begin() + 6);
+        UNIT_TEST(5, sv.size());
+        UNIT_TEST("x", sv[2]);
+        UNIT_TEST("b", sv[3]);
+        sv.erase(sv.begin(), sv.begin() + 3);
+        sv.shrink_to_fit();
+        UNIT_TEST(true, sv.is_inline());
+        UNIT_TEST(0, res.count);
+        UNIT_TEST("a", sv[1]);
+
+        tiny_stl::pmr::small_vector<tiny_stl::string, 4> sv1(sv);
+        UNIT_TEST(true, sv1 == sv);
+        sv1.resize(6, "y");
+        auto heap = sv1.data();
+        tiny_stl::pmr::small_vector<tiny_stl::string, 4> sv2(
+            tiny_stl::move(sv1));
+        UNIT_TEST(true, heap == sv2.data()); // the heap array is taken
+        UNIT_TEST(true, sv1.is_inline());
+        UNIT_TEST(true, sv1.empty());
+        sv1 = tiny_stl::move(sv);
+        UNIT_TEST(2, sv1.size());
+        UNIT_TEST("b", sv1[0]);
+        sv1.swap(sv2);
+        UNIT_TEST(6, sv1.size());
+        UNIT_TEST(2, sv2.size());
+        UNIT_TEST(true, sv2.is_inline());
+        sv1.emplace(sv1.begin(), "z");
+        UNIT_TEST("z", sv1.front());
+        UNIT_TEST("y", sv1.back());
+    }
+    UNIT_TEST(0, res.count);
+
+    tiny_stl::small_vector<int, 8> sv3 = {1, 2, 3};
+    sv3.assign(12, 7);
+    UNIT_TEST(12, sv3.size());
+    UNIT_TEST(false, sv3.is_inline());
+    sv3.resize(2);
+    sv3.insert(sv3.end(), {4, 5});
+    UNIT_TEST(4, sv3.size());
+    UNIT_TEST(5, sv3.back());
+    UNIT_TEST(true, (sv3 < tiny_stl::small_vector<int, 8>(3, 9)));
+
+    tiny_stl::static_vector<int, 3> st(2, 1);
+    st.push_back(2);
+    UNIT_TEST(3, st.size());
+    UNIT_TEST(3, st.max_size());
+    bool full = false;
+    try {
+        st.push_back(3);
+    } catch (const char*) {
+        full = true;
+    }
+    UNIT_TEST(true, full);
+    UNIT_TEST(3, st.size());
+    UNIT_TEST(2, st.back());
+    tiny_stl::static_vector<int, 3> st1 = st;
+    st1.erase(st1.begin());
+    UNIT_TEST(2, st1.size());
+    UNIT_TEST(true, st1 != st);
+}
+
+// sort patterns of (key, position) by key, ties keep their order
+template <typename List>
+int listSortMismatch() {
+    using Item = tiny_stl::pair<int, int>;
+    auto byKey = [](const Item& a, const Item& b) { return a.first < b.first; };
+    int mismatch = 0;
+    srand(26);
+    for (int pattern = 0; pattern < 6; ++pattern) {
+        for (int n : {0, 1, 2, 3, 17, 1000, 5000}) {
+            tiny_stl::vector<Item> ref;
+            for (int i = 0; i < n; ++i) {
+                int key;
+                switch (pattern) {
+                case 0: key = rand(); break;
+                case 1: key = i; break;
+                case 2: key = n - i; break;
+                case 3: key = i % 97; break;          // sawtooth runs
+                case 4: key = rand() % 4; break;      // many ties
+                default: key = i ^ (rand() % 8); break; // nearly sorted
+                }
+                ref.emplace_back(key, i);
+            }
+            List l(ref.begin(), ref.end());
+            l.sort(byKey);
+            // the positions differ, a plain sort is the stable one
+            tiny_stl::sort(ref.begin(), ref.end());
+            mismatch += !tiny_stl::equal(ref.begin(), ref.end(), l.begin());
+            mismatch += tiny_stl::distance(l.begin(), l.end()) != n;
+        }
+    }
+
+    // a throwing compare leaves every element in the list
+    List l;
+    long long sum = 0;
+    for (int i = 0; i < 3000; ++i) {
+        l.push_front(Item(rand() % 1000, i));
+        sum += i;
+    }
+    int calls = 0;
+    try {
+        l.sort([&calls](const Item& a, const Item& b) {
+            if (++calls == 20000)
+                throw 1;
+            return a.first < b.first;
+        });
+        ++mismatch;
+    } catch (int) {
+    }
+    for (const auto& item : l)
+        sum -= item.second;
+    mismatch += sum != 0;
+    l.sort();
+    mismatch += !tiny_stl::is_sorted(l.begin(), l.end());
+    return mismatch;
+}
+
 void testList() {
     tiny_stl::list<int> l1;
     UNIT_TEST(0, l1.size());
@@ -503,6 +1709,15 @@ void testList() {
     tiny_stl::list<int> l7 = {3, 4, 2, 1, 5, 6, 0, 7};
     l7.sort();
     UNIT_TEST(true, tiny_stl::is_sorted(l7.begin(), l7.end()));
+    using PairList = tiny_stl::list<tiny_stl::pair<int, int>>;
+    UNIT_TEST(0, listSortMismatch<PairList>());
+
+    // prev links are rebuilt after the sort
+    l7 = {5, 3, 9, 1};
+    l7.sort(tiny_stl::greater<>{});
+    UNIT_TEST(1, *--l7.end());
+    UNIT_TEST(5, *++l7.begin());
+    UNIT_TEST(3, *----l7.end());
 }
 
 void testForwardList() {
@@ -572,6 +1787,8 @@ void testForwardList() {
     fl12.sort();
     UNIT_TEST(true, is_sorted(fl12.begin(), fl12.end()));
     // print_elements(t);
+    using PairList = tiny_stl::forward_list<tiny_stl::pair<int, int>>;
+    UNIT_TEST(0, listSortMismatch<PairList>());
 }
 
 void testDeque() {
@@ -652,6 +1869,46 @@ void testDeque() {
     UNIT_TEST(10, d5.size());
     d5.resize(4);
     UNIT_TEST(4, d5.size());
+    auto iter2 = d5.begin();
+    UNIT_TEST(1, *iter2++);
+    UNIT_TEST(2, *iter2--);
+    UNIT_TEST(1, *iter2);
+
+    // small buffers, elements cross them on insert and erase
+    tiny_stl::deque<int, tiny_stl::allocator<int>, 3> d6;
+    for (int i = 0; i < 20; ++i)
+        d6.push_front(i);
+    d6.insert(d6.begin() + 7, 5, -1);
+    d6.erase(d6.begin() + 2, d6.begin() + 4);
+    d6.erase(d6.end() - 6, d6.end() - 1);
+    UNIT_TEST(18, d6.size());
+    UNIT_TEST(19, d6.front());
+    UNIT_TEST(-1, d6[5]);
+    UNIT_TEST(0, d6.back());
+    UNIT_TEST(3, d6.buffer_size());
+    auto d7 = d6;
+    UNIT_TEST(true, d7 == d6);
+
+    // a queue moving through the map reuses the freed buffers and
+    // recentres the map instead of growing it
+    CountResource res;
+    {
+        tiny_stl::deque<int, tiny_stl::pmr::polymorphic_allocator<int>, 16> q(
+            &res);
+        int fifo = 0;
+        for (int i = 0; i < 100000; ++i) {
+            q.push_back(i);
+            if (i == 1000)
+                res.total = 0;
+            if (i >= 64) {
+                fifo += q.front() == i - 64;
+                q.pop_front();
+            }
+        }
+        UNIT_TEST(100000 - 64, fifo);
+        UNIT_TEST(0, res.total);
+    }
+    UNIT_TEST(0, res.count);
 }
 
 void testAdaptor() {
@@ -704,11 +1961,169 @@ void testAdaptor() {
     UNIT_TEST(4, pq1.top());
     pq1.push(10);
     UNIT_TEST(10, pq1.top());
+
+    // the same order from every heap layout
+    tiny_stl::priority_queue<int, tiny_stl::vector<int>,
+                             tiny_stl::greater<int>>
+        bq;
+    tiny_stl::priority_queue<int, tiny_stl::vector<int>,
+                             tiny_stl::greater<int>, tiny_stl::dary_heap<4>>
+        dq;
+    unsigned seed = 7;
+    for (int i = 0; i < 2000; ++i) {
+        seed = seed * 1103515245 + 12345;
+        const int val = static_cast<int>(seed >> 16) % 500;
+        bq.push(val);
+        dq.emplace(val);
+    }
+    int heap_mismatch = 0;
+    int prev = -1;
+    while (!bq.empty()) {
+        heap_mismatch += bq.top() != dq.top() || bq.top() < prev;
+        prev = bq.top();
+        bq.pop();
+        dq.pop();
+    }
+    UNIT_TEST(0, heap_mismatch);
+    UNIT_TEST(true, dq.empty());
+
+    tiny_stl::vector<int> hv3 = {3, 1, 4, 1, 5, 9, 2, 6, 5, 3};
+    tiny_stl::priority_queue<int, tiny_stl::vector<int>, tiny_stl::less<int>,
+                             tiny_stl::dary_heap<3>>
+        pq3(hv3.begin(), hv3.end());
+    UNIT_TEST(9, pq3.top());
+    pq3.pop();
+    UNIT_TEST(6, pq3.top());
+    UNIT_TEST(true,
+              hv3.begin() + 2 == tiny_stl::is_heap_until(hv3.begin(),
+                                                         hv3.end()));
+
+    // min-queue with decrease-key
+    tiny_stl::addressable_priority_queue<int, tiny_stl::greater<int>> aq;
+    tiny_stl::vector<size_t> handles;
+    for (int i = 0; i < 100; ++i)
+        handles.push_back(aq.push(1000 + i));
+    UNIT_TEST(1000, aq.top());
+    UNIT_TEST(handles[0], aq.top_handle());
+    aq.update(handles[50], 5);
+    UNIT_TEST(5, aq.top());
+    aq.modify(handles[50], [](int& val) { val = 2000; });
+    UNIT_TEST(1000, aq.top());
+    UNIT_TEST(2000, aq.value(handles[50]));
+    aq.erase(handles[0]);
+    UNIT_TEST(false, aq.contains(handles[0]));
+    UNIT_TEST(1001, aq.top());
+    for (int i = 1; i < 100; i += 2)
+        aq.update(handles[i], i); // odd ones first now
+    UNIT_TEST(99, aq.size());
+    const size_t reused = aq.push(0);
+    UNIT_TEST(handles[0], reused);
+    int aq_mismatch = 0;
+    prev = -1;
+    while (!aq.empty()) {
+        aq_mismatch += aq.top() < prev;
+        prev = aq.top();
+        aq.pop();
+    }
+    UNIT_TEST(0, aq_mismatch);
+    UNIT_TEST(2000, prev);
+}
+
+void testConcurrentQueue() {
+    tiny_stl::spsc_queue<tiny_stl::string> sq(3);
+    UNIT_TEST(4, sq.capacity());
+    UNIT_TEST(true, sq.try_push("a"));
+    UNIT_TEST(true, sq.try_emplace(3, 'b'));
+    tiny_stl::string batch[] = {"c", "d", "e"};
+    UNIT_TEST(2, sq.try_push_n(batch, 3));
+    UNIT_TEST(false, sq.try_push("f"));
+    tiny_stl::string out;
+    UNIT_TEST(true, sq.try_pop(out));
+    UNIT_TEST("a", out);
+    tiny_stl::string outs[4];
+    UNIT_TEST(3, sq.try_pop_n(outs, 4));
+    UNIT_TEST("bbb", outs[0]);
+    UNIT_TEST("d", outs[2]);
+    UNIT_TEST(false, sq.try_pop(out));
+    UNIT_TEST(true, sq.try_push("left")); // destroyed by the queue
+
+    tiny_stl::mpmc_queue<tiny_stl::string> mq(2);
+    UNIT_TEST(true, mq.try_push("x"));
+    UNIT_TEST(true, mq.try_emplace(2, 'y'));
+    UNIT_TEST(false, mq.try_push("z"));
+    UNIT_TEST(2, mq.size());
+    UNIT_TEST(2, mq.try_pop_n(outs, 4));
+    UNIT_TEST("yy", outs[1]);
+    UNIT_TEST(true, mq.empty());
+    UNIT_TEST(2, mq.try_push_n(batch, 3));
+    UNIT_TEST(true, mq.try_pop(out));
+    UNIT_TEST("c", out);
+
+    // every value arrives once, in order from each producer
+    const int kCount = 20000;
+    tiny_stl::spsc_queue<int> sq1(64);
+    long long sum = 0;
+    bool ordered = true;
+    std::thread producer([&sq1] {
+        for (int i = 0; i < kCount;) {
+            int vals[8];
+            int n = 0;
+            for (; n < 8 && i + n < kCount; ++n)
+                vals[n] = i + n;
+            i += static_cast<int>(sq1.try_push_n(vals, n));
+        }
+    });
+    for (int expect = 0; expect < kCount;) {
+        int v;
+        if (sq1.try_pop(v)) {
+            ordered = ordered && v == expect++;
+            sum += v;
+        }
+    }
+    producer.join();
+    UNIT_TEST(true, ordered);
+    UNIT_TEST(1LL * kCount * (kCount - 1) / 2, sum);
+
+    tiny_stl::mpmc_queue<int> mq1(128);
+    std::atomic<long long> msum{0};
+    std::atomic<int> popped{0};
+    tiny_stl::vector<std::thread> threads;
+    for (int t = 0; t < 3; ++t) {
+        threads.emplace_back([&mq1, t] {
+            for (int i = t; i < kCount; i += 3)
+                while (!mq1.try_push(i))
+                    std::this_thread::yield();
+        });
+        threads.emplace_back([&mq1, &msum, &popped] {
+            int vals[4];
+            while (popped.load() < kCount) {
+                size_t n = mq1.try_pop_n(vals, 4);
+                for (size_t i = 0; i < n; ++i)
+                    msum += vals[i];
+                popped += static_cast<int>(n);
+                if (n == 0)
+                    std::this_thread::yield();
+            }
+        });
+    }
+    for (auto& t : threads)
+        t.join();
+    UNIT_TEST(kCount, popped.load());
+    UNIT_TEST(1LL * kCount * (kCount - 1) / 2, msum.load());
 }
 
 void testStringView() {
     tiny_stl::string_view str0;
     UNIT_TEST(true, str0.empty());
+    // an empty needle matches at pos, even without data
+    UNIT_TEST(0, str0.find(""));
+    UNIT_TEST(0, str0.rfind(""));
+    UNIT_TEST(tiny_stl::string_view::npos, str0.find("", 1));
+    UNIT_TEST(0, str0.rfind("", 5));
+    UNIT_TEST(tiny_stl::string_view::npos, str0.find("a"));
+    UNIT_TEST(2, tiny_stl::string_view("abcd").find("", 2));
+    UNIT_TEST(4, tiny_stl::string_view("abcd").rfind(""));
+    UNIT_TEST(1, tiny_stl::string_view("abcd").rfind("", 1));
 
     tiny_stl::string_view str1 = "abcd";
     UNIT_TEST(4, str1.size());
@@ -921,6 +2336,100 @@ void testCowString() {
     UNIT_TEST(tiny_stl::cow_string{"-9223372036854775808"}, s16);
 }
 
+void testCowRefCount() {
+    // single thread policy, the same copy on write
+    using LocalCow =
+        tiny_stl::cow_basic_string<char, std::char_traits<char>,
+                                   tiny_stl::allocator<char>,
+                                   tiny_stl::extra::plain_ref_count>;
+    LocalCow l1 = "local";
+    LocalCow l2 = l1;
+    UNIT_TEST(true, l1.c_str() == l2.c_str());
+    l2[0] = 'L';
+    UNIT_TEST(true, l1 == LocalCow("local"));
+    UNIT_TEST(true, l2 == LocalCow("Local"));
+
+    // copies made and dropped by many threads at once
+    const tiny_stl::cow_string shared = "shared between threads";
+    tiny_stl::vector<std::thread> threads;
+    int mismatch = 0;
+    std::mutex mtx;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&shared, &mismatch, &mtx, t] {
+            int bad = 0;
+            for (int i = 0; i < 20000; ++i) {
+                tiny_stl::cow_string copy = shared;
+                if (i % 1000 == t) {
+                    copy.front() = 'S'; // unshares
+                    bad += copy.c_str() == shared.c_str() ||
+                           copy[1] != shared[1];
+                } else {
+                    bad += copy.c_str() != shared.c_str();
+                }
+            }
+            std::lock_guard<std::mutex> lock(mtx);
+            mismatch += bad;
+        });
+    }
+    for (auto& th : threads)
+        th.join();
+    UNIT_TEST(0, mismatch);
+    UNIT_TEST(true, shared == tiny_stl::cow_string("shared between threads"));
+}
+
+void testCowInternPool() {
+    tiny_stl::cow_string_pool pool;
+    tiny_stl::cow_string a = pool.intern("status=ok");
+    tiny_stl::cow_string b = pool.intern("status=ok", 9);
+    tiny_stl::cow_string c = pool.intern("status=failed");
+    UNIT_TEST(true, a.c_str() == b.c_str());
+    UNIT_TEST(false, a.c_str() == c.c_str());
+    UNIT_TEST(2, pool.size());
+    UNIT_TEST(true, pool.contains("status=ok", 9));
+    UNIT_TEST(false, pool.contains("status", 6));
+
+    // a write copies first, the pooled value stays
+    b.front() = 'S';
+    UNIT_TEST(true, a == tiny_stl::cow_string("status=ok"));
+    UNIT_TEST(true, pool.intern("status=ok").c_str() == a.c_str());
+    UNIT_TEST(false, pool.intern("Status=ok").c_str() == b.c_str());
+
+    // a string not built by the pool shares its value
+    const tiny_stl::cow_string d = "region=eu";
+    UNIT_TEST(true, pool.intern(d).c_str() == d.c_str());
+    UNIT_TEST(4, pool.size());
+
+    // "status=failed" and "Status=ok" are only held by the pool
+    c = tiny_stl::cow_string();
+    UNIT_TEST(2, pool.purge());
+    UNIT_TEST(2, pool.size());
+    UNIT_TEST(true, pool.intern("region=eu").c_str() == d.c_str());
+
+    // dedup many equal tags from several threads through one pool
+    tiny_stl::vector<tiny_stl::cow_string> tags[4];
+    tiny_stl::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&tags, t] {
+            const char* names[] = {"host", "service", "env"};
+            for (int i = 0; i < 3000; ++i)
+                tags[t].push_back(
+                    tiny_stl::cow_string_pool::global().intern(names[i % 3]));
+        });
+    }
+    for (auto& th : threads)
+        th.join();
+    int differ = 0;
+    for (auto& v : tags) {
+        for (size_t i = 0; i < v.size(); ++i)
+            differ += v[i].c_str() != tags[0][i % 3].c_str();
+    }
+    UNIT_TEST(0, differ);
+
+    pool.clear();
+    UNIT_TEST(0, pool.size());
+    UNIT_TEST(true, a == tiny_stl::cow_string("status=ok"));
+}
+
 void testString() {
     tiny_stl::string str1;
     UNIT_TEST(true, str1.empty());
@@ -1056,6 +2565,188 @@ void testString() {
 
     str16.replace(5, 1, 3, '5');
     UNIT_TEST(10, str16.size());
+
+    // the whole short buffer is swapped, a long pointer too
+    tiny_stl::string str18 = "0123456789ab";
+    tiny_stl::string str19 = "ba9876543210";
+    str18.swap(str19);
+    UNIT_TEST(true, str18 == "ba9876543210" && str19 == "0123456789ab");
+    tiny_stl::string str20(20, 'a');
+    str18.swap(str20);
+    UNIT_TEST(true, str18.size() == 20 && str20 == "ba9876543210");
+    tiny_stl::string str21(30, 'b');
+    str18.swap(str21);
+    UNIT_TEST(true, str18 == tiny_stl::string(30, 'b'));
+    UNIT_TEST(true, str21 == tiny_stl::string(20, 'a'));
+}
+
+void testStringSearch() {
+    // random text over a small alphabet, every length crosses a block
+    unsigned seed = 7;
+    auto next = [&seed](unsigned n) {
+        seed = seed * 1103515245U + 12345U;
+        return (seed >> 16) % n;
+    };
+
+    const std::string needles[] = {"a", "ab", "ba", "aab", "abcab",
+                                   "bbbbbbbbbbbbbbbbbbbc", ""};
+    const std::string sets[] = {"", "c", "cd", "dcba", "xyzwvu0d",
+                                "0123456789xyzd"};
+    const size_t positions[] = {0, 1, 15, 16, 31, 33, 100, std::string::npos};
+
+    int mismatch = 0;
+    for (size_t len = 0; len < 140; len += 1 + len / 8) {
+        std::string text;
+        for (size_t i = 0; i < len; ++i)
+            text.push_back(static_cast<char>('a' + next(len % 3 + 2)));
+
+        const tiny_stl::string_view view(text.data(), text.size());
+        const tiny_stl::string str(text.data(), text.size());
+        const tiny_stl::cow_string cow(text.c_str());
+        for (size_t pos : positions) {
+            for (const auto& s : needles) {
+                const tiny_stl::string_view sv(s.data(), s.size());
+                mismatch += view.find(sv, pos) != text.find(s, pos);
+                mismatch += view.rfind(sv, pos) != text.rfind(s, pos);
+                mismatch += str.find(s.data(), pos, s.size()) !=
+                            text.find(s, pos);
+                mismatch += str.rfind(s.data(), pos, s.size()) !=
+                            text.rfind(s, pos);
+                mismatch += cow.find(s.data(), pos, s.size()) !=
+                            text.find(s, pos);
+                mismatch += cow.rfind(s.data(), pos, s.size()) !=
+                            text.rfind(s, pos);
+            }
+
+            for (char ch : {'a', 'c', 'd'}) {
+                mismatch += view.find(ch, pos) != text.find(ch, pos);
+                mismatch += view.rfind(ch, pos) != text.rfind(ch, pos);
+                mismatch += str.find(ch, pos) != text.find(ch, pos);
+                mismatch += str.rfind(ch, pos) != text.rfind(ch, pos);
+                mismatch += cow.find(ch, pos) != text.find(ch, pos);
+                mismatch += cow.rfind(ch, pos) != text.rfind(ch, pos);
+            }
+
+            for (const auto& s : sets) {
+                const tiny_stl::string_view sv(s.data(), s.size());
+                mismatch += view.find_first_of(sv, pos) !=
+                            text.find_first_of(s, pos);
+                mismatch += view.find_last_of(sv, pos) !=
+                            text.find_last_of(s, pos);
+                mismatch += str.find_first_of(s.data(), pos, s.size()) !=
+                            text.find_first_of(s, pos);
+                mismatch += str.find_last_of(s.data(), pos, s.size()) !=
+                            text.find_last_of(s, pos);
+            }
+        }
+    }
+    UNIT_TEST(0, mismatch);
+
+    const tiny_stl::string log = "GET /index.html HTTP/1.1\r\nHost: x\r\n";
+    UNIT_TEST(4, log.find('/'));
+    UNIT_TEST(20, log.rfind('/'));
+    UNIT_TEST(24, log.find("\r\n"));
+    UNIT_TEST(33, log.rfind("\r\n"));
+    UNIT_TEST(3, log.find_first_of(" \r\n"));
+    UNIT_TEST(34, log.find_last_of(" \r\n"));
+    UNIT_TEST(tiny_stl::string::npos, log.find("HTTP/2"));
+
+    // not char-sized, the Traits::eq loops
+    const tiny_stl::wstring wide = L"abcabcabc";
+    const tiny_stl::wstring_view wview = L"abcabcabc";
+    UNIT_TEST(3, wide.find(L"ab", 1));
+    UNIT_TEST(6, wide.rfind(L"ab"));
+    UNIT_TEST(2, wide.find_first_of(L"xc"));
+    UNIT_TEST(7, wide.find_last_of(L"b", 7));
+    UNIT_TEST(6, wview.rfind(L'a'));
+    UNIT_TEST(tiny_stl::wstring_view::npos, wview.find(L"d"));
+}
+
+// grow and shrink across the end of the inline buffer, against std
+template <typename CharT>
+int stringLayoutMismatch() {
+    using Tiny = tiny_stl::basic_string<CharT>;
+    using Std = std::basic_string<CharT>;
+    auto same = [](const Tiny& t, const Std& s) {
+        return t.size() == s.size() && t.c_str()[t.size()] == CharT() &&
+               Std(t.c_str(), t.size()) == s && t.size() <= t.capacity();
+    };
+
+    int mismatch = 0;
+    for (size_t len = 0; len < 40; ++len) {
+        Tiny t;
+        Std s;
+        for (size_t i = 0; i < len; ++i) {
+            t.push_back(static_cast<CharT>('a' + i % 26));
+            s.push_back(static_cast<CharT>('a' + i % 26));
+        }
+        mismatch += !same(t, s);
+
+        Tiny copy = t;
+        Tiny moved = tiny_stl::move(copy);
+        mismatch += !same(moved, s) || !copy.empty();
+
+        Tiny other(3, static_cast<CharT>('z'));
+        other.swap(moved);
+        mismatch += !same(other, s) || !same(moved, Std(3, CharT('z')));
+
+        t.insert(len / 2, 2, static_cast<CharT>('#'));
+        s.insert(len / 2, 2, static_cast<CharT>('#'));
+        mismatch += !same(t, s);
+
+        const CharT tail[] = {'x', 'y', 'z'};
+        t.append(tail, 3);
+        s.append(tail, 3);
+        mismatch += !same(t, s);
+
+        t.replace(1, 3, tail, 2);
+        s.replace(1, 3, tail, 2);
+        mismatch += !same(t, s);
+
+        t.replace(0, 2, 1, static_cast<CharT>('-'));
+        s.replace(0, 2, 1, static_cast<CharT>('-'));
+        mismatch += !same(t, s);
+
+        t.erase(1, len);
+        s.erase(1, len);
+        mismatch += !same(t, s);
+
+        t.pop_back();
+        s.pop_back();
+        mismatch += !same(t, s);
+
+        t.reserve(len + 30);
+        mismatch += !same(t, s) || t.capacity() < len + 30;
+
+        t.clear();
+        mismatch += !t.empty() || t.c_str()[0] != CharT();
+    }
+    return mismatch;
+}
+
+void testStringLayout() {
+    UNIT_TEST(0, stringLayoutMismatch<char>());
+    UNIT_TEST(0, stringLayoutMismatch<wchar_t>());
+    UNIT_TEST(0, stringLayoutMismatch<char16_t>());
+    UNIT_TEST(0, stringLayoutMismatch<char32_t>());
+
+#ifdef TINY_STL_COMPACT_STRING
+    UNIT_TEST(3 * sizeof(void*), sizeof(tiny_stl::string));
+    UNIT_TEST(3 * sizeof(void*) - 1, tiny_stl::string().capacity());
+    UNIT_TEST(3 * sizeof(void*) / 4 - 1, tiny_stl::u32string().capacity());
+#else
+    UNIT_TEST(2 * sizeof(size_t) + 16, sizeof(tiny_stl::string));
+    UNIT_TEST(15, tiny_stl::string().capacity());
+#endif
+
+    // the longest inline string, the last byte is its null character
+    const size_t inlineMax = tiny_stl::string().capacity();
+    tiny_stl::string full(inlineMax, 'k');
+    UNIT_TEST(inlineMax, full.capacity());
+    UNIT_TEST(true, full.c_str()[inlineMax] == '\0');
+    full.push_back('k');
+    UNIT_TEST(true, full.capacity() > inlineMax);
+    UNIT_TEST(std::string(inlineMax + 1, 'k'), full.c_str());
 }
 
 void testRBTree() {
@@ -1121,6 +2812,51 @@ void testSet() {
     }
     UNIT_TEST(true, tiny_stl::is_sorted(s1.begin(), s1.end()));
     UNIT_TEST(1000, s1.size());
+
+    // sorted ranges are built in O(n), equal keys are dropped for set
+    tiny_stl::vector<int> sorted;
+    for (int i = 0; i < 1000; ++i)
+        sorted.push_back(i / 2);
+    tiny_stl::set<int> s2(sorted.begin(), sorted.end(), tiny_stl::less<int>());
+    UNIT_TEST(500, s2.size());
+    UNIT_TEST(true, tiny_stl::is_sorted(s2.begin(), s2.end()));
+    UNIT_TEST(499, *s2.find(499));
+    tiny_stl::multiset<int> ms2(sorted.begin(), sorted.end(),
+                                tiny_stl::less<int>());
+    UNIT_TEST(1000, ms2.size());
+    UNIT_TEST(2, ms2.count(250));
+    UNIT_TEST(true, tiny_stl::equal(ms2.begin(), ms2.end(), sorted.begin()));
+    for (int i = 0; i < 1000; i += 2)
+        ms2.erase(i / 2); // the root too
+    UNIT_TEST(true, ms2.empty());
+
+    tiny_stl::vector<int> keys;
+    for (int i = 0; i < 100; ++i)
+        keys.push_back(i * 3);
+    tiny_stl::set<int> s3(tiny_stl::sorted_unique, keys.begin(), keys.end());
+    UNIT_TEST(100, s3.size());
+    UNIT_TEST(0, *s3.begin());
+    UNIT_TEST(297, *--s3.end());
+    s3.insert(4);
+    UNIT_TEST(101, s3.size());
+    UNIT_TEST(4, *++++s3.begin());
+
+    // hints right before or after the position
+    tiny_stl::set<int> s4;
+    for (int i = 0; i < 100; ++i)
+        s4.insert(s4.end(), i);
+    UNIT_TEST(100, s4.size());
+    UNIT_TEST(true, tiny_stl::is_sorted(s4.begin(), s4.end()));
+    auto hint = s4.insert(s4.begin(), 50); // exists, no insert
+    UNIT_TEST(50, *hint);
+    UNIT_TEST(100, s4.size());
+    hint = s4.emplace_hint(s4.find(10), -1); // wrong hint
+    UNIT_TEST(-1, *hint);
+    UNIT_TEST(-1, *s4.begin());
+    tiny_stl::multiset<int> ms3(tiny_stl::sorted_equivalent, sorted.begin(),
+                                sorted.end());
+    auto mhint = ms3.insert(ms3.find(100), 100);
+    UNIT_TEST(true, mhint == ms3.find(100) && ms3.count(100) == 3);
 }
 
 void testMap() {
@@ -1156,6 +2892,291 @@ void testMap() {
                                        {3, 3.3}, {0, 0.0}, {1, 1.1}};
 
     UNIT_TEST(7, mm.size());
+
+    tiny_stl::vector<tiny_stl::pair<int, int>> sorted;
+    for (int i = 0; i < 1000; ++i)
+        sorted.push_back(tiny_stl::make_pair(i, i * 2));
+    tiny_stl::map<int, int> m3(sorted.begin(), sorted.end());
+    UNIT_TEST(1000, m3.size());
+    UNIT_TEST(998, m3.at(499));
+    tiny_stl::map<int, int> m4(tiny_stl::sorted_unique, sorted.begin(),
+                               sorted.end());
+    UNIT_TEST(true, m3 == m4);
+    m4.erase(m4.begin(), m4.find(999));
+    UNIT_TEST(1, m4.size());
+
+    tiny_stl::map<int, int> m5;
+    for (int i = 0; i < 1000; ++i)
+        m5.emplace_hint(m5.end(), i, i * 2);
+    UNIT_TEST(true, m3 == m5);
+    auto pos = m5.insert(m5.find(7), tiny_stl::make_pair(6, 0));
+    UNIT_TEST(12, pos->second);
+    tiny_stl::multimap<int, int> mm1(tiny_stl::sorted_equivalent,
+                                     sorted.begin(), sorted.end());
+    mm1.insert(mm1.end(), tiny_stl::make_pair(999, 0));
+    UNIT_TEST(0, (--mm1.end())->second);
+    UNIT_TEST(2, mm1.count(999));
+
+    // a wrong hint among equal keys inserts at the nearest end of them
+    tiny_stl::multimap<int, int> mm2{{0, 0}, {1, 0}, {2, 1}, {2, 2}, {3, 3}};
+    mm2.insert(mm2.begin(), tiny_stl::make_pair(2, 4));
+    mm2.insert(mm2.end(), tiny_stl::make_pair(2, 5));
+    mm2.insert(mm2.find(3), tiny_stl::make_pair(2, 6));
+    tiny_stl::vector<int> order;
+    for (auto it = mm2.lower_bound(2); it != mm2.upper_bound(2); ++it)
+        order.push_back(it->second);
+    UNIT_TEST(true, (order == tiny_stl::vector<int>{4, 1, 2, 5, 6}));
+}
+
+// stateful and unequal across ids, but propagates on move assignment,
+// outstanding counts the blocks of each id not yet freed by that id
+template <typename T>
+struct MovingAlloc {
+    using value_type = T;
+    using size_type = size_t;
+    using difference_type = ptrdiff_t;
+    using propagate_on_container_move_assignment = tiny_stl::true_type;
+
+    template <typename U>
+    struct rebind {
+        using other = MovingAlloc<U>;
+    };
+
+    static int outstanding[2];
+    int id;
+
+    explicit MovingAlloc(int i = 0) : id(i) {
+    }
+
+    template <typename U>
+    MovingAlloc(const MovingAlloc<U>& rhs) : id(rhs.id) {
+    }
+
+    T* allocate(size_t n) {
+        ++MovingAlloc<char>::outstanding[id];
+        return static_cast<T*>(::operator new(n * sizeof(T)));
+    }
+
+    void deallocate(T* p, size_t) {
+        --MovingAlloc<char>::outstanding[id];
+        ::operator delete(p);
+    }
+
+    template <typename U>
+    bool operator==(const MovingAlloc<U>& rhs) const {
+        return id == rhs.id;
+    }
+
+    template <typename U>
+    bool operator!=(const MovingAlloc<U>& rhs) const {
+        return id != rhs.id;
+    }
+};
+
+template <typename T>
+int MovingAlloc<T>::outstanding[2];
+
+void testBTree() {
+    // small nodes split and merge on every level
+    tiny_stl::btree_multiset<int, tiny_stl::less<int>,
+                             tiny_stl::allocator<int>, 3>
+        bs;
+    tiny_stl::multiset<int> ref;
+    unsigned seed = 1;
+    int mismatch = 0;
+    for (int i = 0; i < 4000; ++i) {
+        seed = seed * 1103515245 + 12345;
+        int v = static_cast<int>(seed >> 16) % 500;
+        if (i % 3 == 2) {
+            mismatch += ref.erase(v) != bs.erase(v);
+        } else {
+            ref.insert(v);
+            mismatch += *bs.insert(v) != v;
+        }
+    }
+    UNIT_TEST(0, mismatch);
+    UNIT_TEST(ref.size(), bs.size());
+    UNIT_TEST(true, tiny_stl::equal(ref.begin(), ref.end(), bs.begin()));
+    UNIT_TEST(true, tiny_stl::equal(ref.rbegin(), ref.rend(), bs.rbegin()));
+
+    // erase returns the next value
+    auto next = bs.upper_bound(250);
+    int after = next == bs.end() ? -1 : *next;
+    auto pos = bs.erase(--next);
+    UNIT_TEST(after, pos == bs.end() ? -1 : *pos);
+    pos = bs.erase(bs.lower_bound(100), bs.upper_bound(400));
+    UNIT_TEST(true, pos == bs.upper_bound(400));
+    UNIT_TEST(0, bs.count(300));
+    while (!bs.empty())
+        bs.erase(bs.begin());
+    UNIT_TEST(true, bs.begin() == bs.end());
+
+    tiny_stl::btree_set<int> s{5, 3, 1, 3, 4};
+    UNIT_TEST(4, s.size());
+    UNIT_TEST(false, s.insert(4).second);
+    UNIT_TEST(1, *s.begin());
+    UNIT_TEST(5, *s.rbegin());
+    UNIT_TEST(true, s.find(2) == s.end());
+    UNIT_TEST(4, *s.lower_bound(4));
+    UNIT_TEST(5, *s.upper_bound(4));
+
+    tiny_stl::vector<int> sorted;
+    for (int i = 0; i < 10000; ++i)
+        sorted.push_back(i);
+    tiny_stl::btree_set<int, tiny_stl::less<int>, tiny_stl::allocator<int>, 16>
+        s1(tiny_stl::sorted_unique, sorted.begin(), sorted.end());
+    auto s2 = s1;
+    UNIT_TEST(10000, s2.size());
+    UNIT_TEST(true, s1 == s2);
+    s2.insert(s2.find(5000), 5000);
+    s2.insert(s2.end(), 10000);
+    UNIT_TEST(10001, s2.size());
+    UNIT_TEST(true, s1 < s2);
+    auto s3 = tiny_stl::move(s2);
+    UNIT_TEST(0, s2.size());
+    UNIT_TEST(10000, *--s3.end());
+
+    tiny_stl::btree_map<tiny_stl::string, int> m;
+    for (int i = 0; i < 1000; ++i)
+        m[tiny_stl::to_string(i)] = i;
+    for (int i = 0; i < 1000; i += 2)
+        m.erase(tiny_stl::to_string(i));
+    UNIT_TEST(500, m.size());
+    UNIT_TEST(777, m.at("777"));
+    UNIT_TEST(true, m.find("778") == m.end());
+    auto p = m.emplace("42", 0);
+    UNIT_TEST(true, p.second);
+    UNIT_TEST(0, m.emplace_hint(m.end(), "42", 1)->second);
+
+    tiny_stl::btree_multimap<int, int> mm{{1, 1}, {2, 2}, {1, 3}};
+    UNIT_TEST(2, mm.count(1));
+    UNIT_TEST(3, (++mm.begin())->second);
+    tiny_stl::btree_multimap<int, int> mm1;
+    mm1.swap(mm);
+    UNIT_TEST(0, mm.size());
+    UNIT_TEST(3, mm1.size());
+
+    // the keys are read-only through an iterator
+    UNIT_TEST(true, (tiny_stl::is_same<decltype(*m.begin()),
+                                       tiny_stl::pair<const tiny_stl::string,
+                                                      int>&>::value));
+    UNIT_TEST(true, (tiny_stl::is_same<decltype(*s.begin()),
+                                       const int&>::value));
+
+    // key_comp is the comparator the tree was built with
+    struct DirLess {
+        int dir;
+        bool operator()(int lhs, int rhs) const {
+            return dir * lhs < dir * rhs;
+        }
+    };
+    tiny_stl::btree_multimap<int, int, DirLess> dm(DirLess{-1});
+    dm.insert({1, 1});
+    dm.insert({2, 2});
+    UNIT_TEST(-1, dm.key_comp().dir);
+    UNIT_TEST(2, dm.begin()->first);
+    UNIT_TEST(true, dm.value_comp()(*dm.begin(), *++dm.begin()));
+
+    // a wrong hint among equal keys inserts at the nearest end of them
+    tiny_stl::btree_multimap<int, int> hm{{1, 0}, {2, 1}, {2, 2}, {3, 3}};
+    hm.insert(hm.begin(), {2, 4});
+    hm.insert(hm.end(), {2, 5});
+    tiny_stl::vector<int> order;
+    for (auto it = hm.lower_bound(2); it != hm.upper_bound(2); ++it)
+        order.push_back(it->second);
+    UNIT_TEST(true, (order == tiny_stl::vector<int>{4, 1, 2, 5}));
+
+    // a propagated allocator takes the nodes along, each id frees its own
+    {
+        using MovingSet =
+            tiny_stl::btree_set<int, tiny_stl::less<int>, MovingAlloc<int>, 3>;
+        MovingSet ms1(MovingAlloc<int>(0));
+        MovingSet ms2(MovingAlloc<int>(1));
+        for (int i = 0; i < 100; ++i) {
+            ms1.insert(i);
+            ms2.insert(-i);
+        }
+        const int* addr = &*ms1.find(50);
+        ms2 = tiny_stl::move(ms1);
+        UNIT_TEST(0, ms2.get_allocator().id);
+        UNIT_TEST(1, ms1.get_allocator().id);
+        UNIT_TEST(100, ms2.size());
+        UNIT_TEST(true, addr == &*ms2.find(50));
+        UNIT_TEST(0, MovingAlloc<char>::outstanding[1]);
+        ms1.insert(7);
+    }
+    UNIT_TEST(0, MovingAlloc<char>::outstanding[0]);
+    UNIT_TEST(0, MovingAlloc<char>::outstanding[1]);
+}
+
+void testFlatMap() {
+    tiny_stl::flat_set<int> s{5, 3, 1, 3, 4};
+    UNIT_TEST(4, s.size());
+    UNIT_TEST(1, *s.begin());
+    UNIT_TEST(false, s.insert(4).second);
+    UNIT_TEST(2, *s.insert(s.begin() + 1, 2));
+    UNIT_TEST(true, s.contains(2));
+    UNIT_TEST(0, s.count(6));
+
+    // the batch is sorted and merged, equal keys are dropped
+    tiny_stl::vector<int> batch = {9, 0, 3, 9, 7, 6};
+    s.insert(batch.begin(), batch.end());
+    tiny_stl::vector<int> expect = {0, 1, 2, 3, 4, 5, 6, 7, 9};
+    UNIT_TEST(true, tiny_stl::equal(s.begin(), s.end(), expect.begin()));
+    UNIT_TEST(expect.size(), s.size());
+    UNIT_TEST(1, s.erase(4));
+    UNIT_TEST(5, *s.erase(s.find(3)));
+    tiny_stl::vector<int> tail = {10, 11, 12};
+    s.insert(tiny_stl::sorted_unique, tail.begin(), tail.end());
+    UNIT_TEST(12, *s.rbegin());
+    auto keys = tiny_stl::move(s).extract();
+    UNIT_TEST(true, s.empty());
+    UNIT_TEST(10, keys.size());
+    tiny_stl::flat_set<int> s1(tiny_stl::sorted_unique, keys);
+    UNIT_TEST(true, tiny_stl::equal(s1.begin(), s1.end(), keys.begin()));
+
+    tiny_stl::flat_map<int, tiny_stl::string> m{{3, "c"}, {1, "a"}, {3, "x"}};
+    UNIT_TEST(2, m.size());
+    UNIT_TEST("c", m.at(3));
+    m[2] = "b";
+    UNIT_TEST(1, m.begin()->first);
+    UNIT_TEST("b", (m.begin() + 1)->second);
+    UNIT_TEST(false, m.try_emplace(2, "y").second);
+    UNIT_TEST(false, m.insert_or_assign(2, "z").second);
+    UNIT_TEST("z", m[2]);
+    UNIT_TEST(true, m.find(4) == m.end());
+    m.emplace(0, "0");
+    UNIT_TEST(0, m.keys().front());
+    UNIT_TEST("0", m.values().front());
+
+    tiny_stl::vector<tiny_stl::pair<int, tiny_stl::string>> pairs;
+    for (int i = 100; i > 0; --i)
+        pairs.push_back(tiny_stl::make_pair(i % 50, tiny_stl::to_string(i)));
+    m.insert(pairs.begin(), pairs.end());
+    UNIT_TEST(50, m.size());
+    UNIT_TEST(true, tiny_stl::is_sorted(m.keys().begin(), m.keys().end()));
+    // the old element wins, then the first new one
+    UNIT_TEST("z", m.at(2));
+    UNIT_TEST("99", m.at(49));
+    UNIT_TEST("0", m[0]);
+    auto it = m.erase(m.find(10));
+    UNIT_TEST(11, it->first);
+    UNIT_TEST(0, m.erase(10));
+    UNIT_TEST(true, m.lower_bound(10) == it);
+
+    tiny_stl::flat_map<int, int> m1(tiny_stl::vector<int>{3, 1, 2, 1},
+                                    tiny_stl::vector<int>{30, 10, 20, 11});
+    UNIT_TEST(3, m1.size());
+    UNIT_TEST(10, m1.at(1));
+    const auto& cm1 = m1;
+    int sum = 0;
+    for (auto p : cm1)
+        sum += p.first + p.second;
+    UNIT_TEST(66, sum);
+    auto m2 = m1;
+    UNIT_TEST(true, m1 == m2);
+    m2.begin()->second = 0;
+    UNIT_TEST(true, m2 < m1);
 }
 
 void testTuple() {
@@ -1248,6 +3269,90 @@ void testUnorderSet() {
 
     ums.swap(ums1);
     UNIT_TEST(1001, ums.size());
+
+    using Pow2Set = tiny_stl::unordered_set<
+        int, tiny_stl::hash<int>, tiny_stl::equal_to<int>,
+        tiny_stl::allocator<int>,
+        tiny_stl::chained_hashing<tiny_stl::pow2_bucket_policy>>;
+    Pow2Set ps;
+    for (int i = 0; i < 1000; ++i)
+        ps.insert(i * 1024); // low bits all zero
+    UNIT_TEST(1000, ps.size());
+    UNIT_TEST(0, ps.bucket_count() & (ps.bucket_count() - 1));
+    UNIT_TEST(1, ps.count(512 * 1024));
+    UNIT_TEST(0, ps.count(7));
+    size_t longest = 0;
+    for (size_t i = 0; i < ps.bucket_count(); ++i)
+        longest = tiny_stl::max(longest, ps.bucket_size(i));
+    UNIT_TEST(true, longest < 16);
+
+    using Pow2MultiSet =
+        tiny_stl::unordered_multiset<int, tiny_stl::hash<int>,
+                                     tiny_stl::equal_to<int>,
+                                     tiny_stl::allocator<int>,
+                                     tiny_stl::pow2_bucket_policy>;
+    Pow2MultiSet pms;
+    for (int i = 0; i < 1000; ++i)
+        pms.insert((i % 500) * 1024);
+    UNIT_TEST(1000, pms.size());
+    UNIT_TEST(0, pms.bucket_count() & (pms.bucket_count() - 1));
+    UNIT_TEST(2, pms.count(256 * 1024));
+    using Pow2MultiMap = tiny_stl::unordered_multimap<
+        int, int, tiny_stl::hash<int>, tiny_stl::equal_to<int>,
+        tiny_stl::allocator<tiny_stl::pair<int, int>>,
+        tiny_stl::pow2_bucket_policy>;
+    Pow2MultiMap pmm{{1, 1}, {1, 2}, {2, 3}};
+    Pow2MultiMap pmm1;
+    swap(pmm, pmm1);
+    UNIT_TEST(2, pmm1.count(1));
+    UNIT_TEST(0, pmm1.bucket_count() & (pmm1.bucket_count() - 1));
+
+    UNIT_TEST(53, tiny_stl::stlNextPrime(0));
+    UNIT_TEST(4294967291U, tiny_stl::stlNextPrime(4294967290U));
+#if SIZE_MAX > 0xFFFFFFFFU
+    UNIT_TEST(6442450967ULL, tiny_stl::stlNextPrime(4294967292ULL));
+    UNIT_TEST(18446744073709551557ULL, tiny_stl::stlNextPrime(SIZE_MAX));
+#endif
+
+    // rehash relinks the nodes, addresses and equal ranges are kept
+    tiny_stl::unordered_multiset<int> ums2;
+    for (int i = 0; i < 300; ++i) {
+        ums2.insert(i);
+        ums2.insert(i);
+    }
+    auto eq150 = ums2.equal_range(150);
+    const int* addr = &*eq150.first;
+    ums2.rehash(5000);
+    UNIT_TEST(true, ums2.bucket_count() >= 5000);
+    UNIT_TEST(600, ums2.size());
+    eq150 = ums2.equal_range(150);
+    UNIT_TEST(true, addr == &*eq150.first || addr == &*++eq150.first);
+    UNIT_TEST(2, ums2.count(299));
+    UNIT_TEST(600, tiny_stl::distance(ums2.begin(), ums2.end()));
+
+    tiny_stl::unordered_set<int> us4;
+    us4.incremental_rehash(true);
+    bool migrated = false;
+    for (int i = 0; i < 10000; ++i) {
+        us4.insert(i);
+        migrated = migrated || us4.rehashing();
+    }
+    UNIT_TEST(true, migrated);
+    UNIT_TEST(10000, us4.size());
+    UNIT_TEST(10000, tiny_stl::distance(us4.begin(), us4.end()));
+    size_t found = 0;
+    for (int i = 0; i < 10000; ++i)
+        found += us4.count(i);
+    UNIT_TEST(10000, found);
+    UNIT_TEST(0, us4.count(10000));
+    us4.erase(5000);
+    UNIT_TEST(0, us4.count(5000));
+    auto us5 = us4;
+    UNIT_TEST(9999, us5.size());
+    UNIT_TEST(1, us5.count(9999));
+    us4.incremental_rehash(false);
+    UNIT_TEST(false, us4.rehashing());
+    UNIT_TEST(9999, tiny_stl::distance(us4.begin(), us4.end()));
 }
 
 void testUnorderedMap() {
@@ -1285,28 +3390,688 @@ void testUnorderedMap() {
         {2, 2.2}, {3, 3.3}, {6, 6.6}, {4, 4.4}, {3, 3.3}, {0, 0.0}, {1, 1.1}};
 
     UNIT_TEST(7, umm.size());
+
+    // string keys cache the hash code, rehash does not hash again
+    struct CountHash {
+        int* count;
+        size_t operator()(const tiny_stl::string& str) const {
+            ++*count;
+            return tiny_stl::hash<tiny_stl::string>()(str);
+        }
+    };
+    UNIT_TEST(true, (tiny_stl::hash_code_cached<tiny_stl::string,
+                                                CountHash>::value));
+    UNIT_TEST(false,
+              (tiny_stl::hash_code_cached<int, tiny_stl::hash<int>>::value));
+    int hash_count = 0;
+    tiny_stl::unordered_map<tiny_stl::string, int, CountHash> um3(
+        0, CountHash{&hash_count});
+    for (int i = 0; i < 500; ++i)
+        um3[tiny_stl::to_string(i)] = i;
+    hash_count = 0;
+    um3.rehash(4 * um3.bucket_count());
+    UNIT_TEST(0, hash_count);
+    UNIT_TEST(500, um3.size());
+    UNIT_TEST(499, um3.at("499"));
+    UNIT_TEST(1, hash_count);
+    auto um4 = um3;
+    UNIT_TEST(1, hash_count);
+    UNIT_TEST(250, um4.at("250"));
+}
+
+void testFlatHashTable() {
+    using FlatSet = tiny_stl::unordered_set<int, tiny_stl::hash<int>,
+                                            tiny_stl::equal_to<int>,
+                                            tiny_stl::allocator<int>,
+                                            tiny_stl::flat_hashing<>>;
+    FlatSet us = {1, 2, 3, 5, 5};
+    UNIT_TEST(4, us.size());
+    UNIT_TEST(1, *us.find(1));
+    UNIT_TEST(5, *us.find(5));
+    UNIT_TEST(true, us.find(4) == us.end());
+    UNIT_TEST(1, us.count(5));
+    UNIT_TEST(5, *us.equal_range(5).first);
+
+    us.erase(5);
+    UNIT_TEST(0, us.count(5));
+    UNIT_TEST(3, us.size());
+
+    FlatSet us1;
+    UNIT_TEST(true, us1.begin() == us1.end());
+    for (int i = 0; i < 1000; ++i)
+        us1.insert(i);
+    UNIT_TEST(1000, us1.size());
+    UNIT_TEST(1000, tiny_stl::distance(us1.begin(), us1.end()));
+    for (int i = 0; i < 1000; i += 2)
+        us1.erase(i);
+    UNIT_TEST(500, us1.size());
+    UNIT_TEST(0, us1.count(10));
+    UNIT_TEST(1, us1.count(11));
+    for (int i = 0; i < 1000; i += 2)
+        us1.insert(i);
+    UNIT_TEST(1000, us1.size());
+    UNIT_TEST(true, us1.load_factor() <= us1.max_load_factor());
+
+    auto us2(us1);
+    UNIT_TEST(true, us1 == us2);
+    auto us3 = tiny_stl::move(us2);
+    UNIT_TEST(1000, us3.size());
+    UNIT_TEST(0, us2.size());
+    us.swap(us3);
+    UNIT_TEST(1000, us.size());
+    UNIT_TEST(1, us.count(999));
+
+    using FlatMap =
+        tiny_stl::unordered_map<tiny_stl::string, int,
+                                tiny_stl::hash<tiny_stl::string>,
+                                tiny_stl::equal_to<tiny_stl::string>,
+                                tiny_stl::allocator<
+                                    tiny_stl::pair<tiny_stl::string, int>>,
+                                tiny_stl::flat_hashing<tiny_stl::linear_probing>>;
+    FlatMap um{{"one", 1}, {"two", 2}, {"three", 3}};
+    auto p = um.insert({"one", 11});
+    UNIT_TEST(false, p.second);
+    UNIT_TEST(1, p.first->second);
+    UNIT_TEST(3, um.at("three"));
+    um["four"] = 4;
+    UNIT_TEST(4, um.size());
+    UNIT_TEST(4, um["four"]);
+    UNIT_TEST(0, um["five"]);
+    UNIT_TEST(5, um.size());
+    um.clear();
+    UNIT_TEST(true, um.empty());
+    UNIT_TEST(true, um.find("one") == um.end());
+
+    // the SIMD group and the portable group give the same matches
+    tiny_stl::FlatCtrl ctrl[tiny_stl::kFlatGroupWidth];
+    for (int i = 0; i < static_cast<int>(tiny_stl::kFlatGroupWidth); ++i)
+        ctrl[i] = i % 3 == 0 ? tiny_stl::kFlatEmpty
+                             : (i % 3 == 1 ? 5 : tiny_stl::kFlatDeleted);
+    const tiny_stl::FlatGroup group(ctrl);
+    const tiny_stl::FlatGroupPortable portable(ctrl);
+    size_t matched = 0;
+    bool same = true;
+    auto m1 = group.match(5);
+    auto m2 = portable.match(5);
+    for (; m1 && m2; ++m1, ++m2, ++matched)
+        same = same && m1.lowest() == m2.lowest();
+    UNIT_TEST(true, same && !m1 && !m2);
+    UNIT_TEST(5, matched);
+    UNIT_TEST(0, group.maskEmpty().lowest());
+    UNIT_TEST(1, group.maskEmptyOrDeleted().lowest() + 1);
+    UNIT_TEST(true, !group.match(6));
+
+    // h2 filters the candidates before KeyEqual
+    struct CountEqual {
+        int* count;
+        bool operator()(int lhs, int rhs) const {
+            ++*count;
+            return lhs == rhs;
+        }
+    };
+    int equal_count = 0;
+    tiny_stl::unordered_set<int, tiny_stl::hash<int>, CountEqual,
+                            tiny_stl::allocator<int>, tiny_stl::flat_hashing<>>
+        us4(0, tiny_stl::hash<int>(), CountEqual{&equal_count});
+    for (int i = 0; i < 1000; ++i)
+        us4.insert(i);
+    equal_count = 0;
+    for (int i = 0; i < 1000; ++i)
+        us4.find(i);
+    UNIT_TEST(true, equal_count >= 1000 && equal_count < 1500);
+}
+
+void testConcurrentMap() {
+    tiny_stl::concurrent_unordered_map<int, tiny_stl::string> m(3);
+    UNIT_TEST(4, m.shard_count());
+    UNIT_TEST(true, m.empty());
+    UNIT_TEST(true, m.insert(tiny_stl::make_pair(1, tiny_stl::string("a"))));
+    UNIT_TEST(false, m.insert(tiny_stl::make_pair(1, tiny_stl::string("b"))));
+    UNIT_TEST(true, m.try_emplace(2, 3, 'c'));
+    UNIT_TEST(false, m.try_emplace(2, "d"));
+    UNIT_TEST(false, m.insert_or_assign(2, "e"));
+    UNIT_TEST(true, m.insert_or_assign(3, "f"));
+    UNIT_TEST(3, m.size());
+
+    tiny_stl::string seen;
+    UNIT_TEST(1, m.cvisit(2, [&seen](const tiny_stl::pair<int,
+                                        tiny_stl::string>& val) {
+        seen = val.second;
+    }));
+    UNIT_TEST("e", seen);
+    UNIT_TEST(0, m.cvisit(4, [&seen](const tiny_stl::pair<int,
+                                        tiny_stl::string>&) { seen = "x"; }));
+    UNIT_TEST("e", seen);
+    UNIT_TEST(1, m.visit(1, [](tiny_stl::pair<int, tiny_stl::string>& val) {
+        val.second += "z";
+    }));
+    UNIT_TEST(false,
+              m.insert_or_visit(tiny_stl::make_pair(1, tiny_stl::string()),
+                                [&seen](tiny_stl::pair<int, tiny_stl::string>&
+                                            val) { seen = val.second; }));
+    UNIT_TEST("az", seen);
+    UNIT_TEST(true, m.contains(3));
+    UNIT_TEST(0, m.count(4));
+
+    size_t total = 0;
+    UNIT_TEST(3, m.cvisit_all([&total](const tiny_stl::pair<int,
+                                          tiny_stl::string>& val) {
+        total += val.second.size();
+    }));
+    UNIT_TEST(4, total);
+    UNIT_TEST(0, m.erase_if(3, [](const tiny_stl::pair<int,
+                                     tiny_stl::string>& val) {
+        return val.second != "f";
+    }));
+    UNIT_TEST(1, m.erase(3));
+    UNIT_TEST(1, m.erase_if([](const tiny_stl::pair<int,
+                                  tiny_stl::string>& val) {
+        return val.first == 2;
+    }));
+    UNIT_TEST(1, m.size());
+    m.clear();
+    UNIT_TEST(true, m.empty());
+
+    // 4 threads count the same keys and insert their own ones
+    const int kKeys = 500;
+    tiny_stl::concurrent_unordered_map<int, int> counts(8);
+    counts.incremental_rehash(true);
+    tiny_stl::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&counts, t] {
+            for (int i = 0; i < kKeys; ++i) {
+                counts.insert_or_visit(tiny_stl::make_pair(i, 1),
+                                       [](tiny_stl::pair<int, int>& val) {
+                                           ++val.second;
+                                       });
+                counts.try_emplace(kKeys * (t + 1) + i, t);
+                counts.cvisit(i, [](const tiny_stl::pair<int, int>&) {});
+            }
+        });
+    }
+    for (auto& t : threads)
+        t.join();
+    int bad = 0;
+    long long owned = 0;
+    counts.cvisit_all([&bad, &owned](const tiny_stl::pair<int, int>& val) {
+        if (val.first < kKeys)
+            bad += val.second != 4;
+        else
+            owned += val.second;
+    });
+    UNIT_TEST(0, bad);
+    UNIT_TEST(kKeys * 5, counts.size());
+    UNIT_TEST(1LL * kKeys * (0 + 1 + 2 + 3), owned);
+}
+
+void testHashBytes() {
+    unsigned char buf[3000];
+    for (size_t i = 0; i < sizeof(buf); ++i)
+        buf[i] = static_cast<unsigned char>(rand());
+
+    // SIMD accumulators agree with the portable ones
+    alignas(16) uint64_t acc1[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+    alignas(16) uint64_t acc2[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+    for (size_t s = 0; s < 16; ++s) {
+        tiny_stl::HashAccPortable::accumulate(acc1, buf + 64 * s,
+                                              tiny_stl::kHashSecret + s);
+        tiny_stl::HashAcc::accumulate(acc2, buf + 64 * s,
+                                      tiny_stl::kHashSecret + s);
+    }
+    tiny_stl::HashAccPortable::scramble(acc1, tiny_stl::kHashSecret + 16);
+    tiny_stl::HashAcc::scramble(acc2, tiny_stl::kHashSecret + 16);
+    UNIT_TEST(true, memcmp(acc1, acc2, sizeof(acc1)) == 0);
+    UNIT_TEST(tiny_stl::hashLong<tiny_stl::HashAccPortable>(buf, 2500, 7),
+              tiny_stl::hashBytes64(buf, 2500, 7));
+
+    // every length and every seed gives another value
+    tiny_stl::unordered_set<size_t> values;
+    for (size_t len = 0; len <= 1100; ++len)
+        values.insert(tiny_stl::hashBytes(buf, len));
+    UNIT_TEST(1101, values.size());
+    UNIT_TEST(tiny_stl::hashBytes(buf, 40, 1), tiny_stl::hashBytes(buf, 40, 1));
+    UNIT_TEST(true,
+              tiny_stl::hashBytes(buf, 40, 1) != tiny_stl::hashBytes(buf, 40));
+    UNIT_TEST(true, tiny_stl::hashBytes(buf, 700, 1) !=
+                        tiny_stl::hashBytes(buf, 700));
+
+    // a flipped bit is seen in every path, swapped stripes too
+    for (size_t len : {3u, 12u, 40u, 200u, 1000u, 2500u}) {
+        const size_t h = tiny_stl::hashBytes(buf, len);
+        buf[len / 2] ^= 0x10;
+        UNIT_TEST(true, h != tiny_stl::hashBytes(buf, len));
+        buf[len / 2] ^= 0x10;
+    }
+    unsigned char swapped[512];
+    memcpy(swapped, buf + 256, 256);
+    memcpy(swapped + 256, buf, 256);
+    UNIT_TEST(true, tiny_stl::hashBytes(buf, 512) !=
+                        tiny_stl::hashBytes(swapped, 512));
+
+    tiny_stl::string str = "hello, hash";
+    tiny_stl::string_view sv = str.c_str();
+    UNIT_TEST(tiny_stl::hash<tiny_stl::string>()(str),
+              tiny_stl::hash<tiny_stl::string_view>()(sv));
+#ifndef TINY_STL_FNV_STRING_HASH
+    UNIT_TEST(tiny_stl::hashBytes(str.c_str(), str.size()),
+              tiny_stl::hash<tiny_stl::string>()(str));
+#endif
+}
+
+struct StatsTagVector {};
+struct StatsTagMap {};
+
+// four buckets at most
+struct StatsWeakHash {
+    size_t operator()(int key) const noexcept {
+        return static_cast<size_t>(key & 3);
+    }
+};
+
+void testStats() {
+    using VectorAlloc = tiny_stl::stats_allocator<int, tiny_stl::allocator<int>,
+                                                  StatsTagVector>;
+    {
+        // capacity 1, 2, 4, ..., 128, the old array is freed after the
+        // new one is allocated
+        tiny_stl::vector<int, VectorAlloc> v;
+        for (int i = 0; i < 100; ++i)
+            v.push_back(i);
+        tiny_stl::alloc_stats as = VectorAlloc::stats();
+        UNIT_TEST(8, as.allocations);
+        UNIT_TEST(7, as.deallocations);
+        UNIT_TEST(255 * sizeof(int), as.bytes_allocated);
+        UNIT_TEST(128 * sizeof(int), as.bytes_in_use);
+        UNIT_TEST(192 * sizeof(int), as.peak_bytes);
+
+        tiny_stl::vector_stats vs = v.stats();
+        UNIT_TEST(100, vs.size);
+        UNIT_TEST(128, vs.capacity);
+        UNIT_TEST(tiny_stl::kStatsEnabled ? 7 : 0, vs.reallocations);
+        UNIT_TEST(tiny_stl::kStatsEnabled ? 127 : 0, vs.relocated);
+
+        // shrinking or growing an empty array is no reallocation
+        v.shrink_to_fit();
+        v.clear();
+        v.reserve(1000);
+        UNIT_TEST(tiny_stl::kStatsEnabled ? 7 : 0, v.stats().reallocations);
+    }
+    tiny_stl::alloc_stats as = VectorAlloc::stats();
+    UNIT_TEST(as.allocations, as.deallocations);
+    UNIT_TEST(0, as.bytes_in_use);
+    VectorAlloc::reset_stats();
+    UNIT_TEST(0, VectorAlloc::stats().allocations);
+    UNIT_TEST(0, VectorAlloc::stats().peak_bytes);
+
+    // the node allocator of map is rebound, the tag stays
+    using MapAlloc = tiny_stl::stats_allocator<
+        tiny_stl::pair<int, int>, tiny_stl::allocator<tiny_stl::pair<int, int>>,
+        StatsTagMap>;
+    {
+        tiny_stl::map<int, int, tiny_stl::less<int>, MapAlloc> m;
+        for (int i = 0; i < 1000; ++i)
+            m.insert(tiny_stl::make_pair(i, i));
+        UNIT_TEST(1001, MapAlloc::stats().allocations); // and the header
+
+        // ascending keys rotate at every other insertion
+        tiny_stl::tree_stats ts = m.stats();
+        UNIT_TEST(1000, ts.size);
+        UNIT_TEST(true, ts.height >= 10 && ts.height <= 20);
+        UNIT_TEST(true, tiny_stl::kStatsEnabled ? ts.rotations >= 900
+                                                : ts.rotations == 0);
+
+        size_t records = 0;
+        tiny_stl::for_each_alloc_stats(
+            [&](const char* name, const tiny_stl::alloc_stats& s) {
+                if (strcmp(name, typeid(StatsTagMap).name()) == 0) {
+                    ++records;
+                    UNIT_TEST(1001, s.allocations);
+                }
+            });
+        UNIT_TEST(1, records);
+    }
+    UNIT_TEST(0, MapAlloc::stats().bytes_in_use);
+
+    tiny_stl::set<int> empty;
+    UNIT_TEST(0, empty.stats().height);
+
+    // a weak hash function shows as a few long chains
+    tiny_stl::unordered_set<int, StatsWeakHash> weak;
+    tiny_stl::unordered_set<int> good;
+    for (int i = 0; i < 1000; ++i) {
+        weak.insert(i);
+        good.insert(i);
+    }
+    tiny_stl::hash_stats hs = weak.stats();
+    UNIT_TEST(1000, hs.size);
+    UNIT_TEST(weak.bucket_count(), hs.bucket_count);
+    UNIT_TEST(250, hs.longest_chain);
+    UNIT_TEST(4, hs.chains[tiny_stl::kHashStatsChainBins - 1]);
+    UNIT_TEST(hs.bucket_count - 4, hs.empty_buckets);
+
+    hs = good.stats();
+    size_t buckets = 0;
+    size_t elements = 0;
+    for (size_t i = 0; i < tiny_stl::kHashStatsChainBins; ++i) {
+        buckets += hs.chains[i];
+        elements += i * hs.chains[i];
+    }
+    UNIT_TEST(hs.bucket_count, buckets);
+    UNIT_TEST(true, hs.longest_chain < 8);
+    UNIT_TEST(hs.size, elements); // no chain reaches the last bin
+    UNIT_TEST(true, hs.load_factor > 0.0f && hs.load_factor <= 1.0f);
+    UNIT_TEST(true, tiny_stl::kStatsEnabled ? hs.rehashes > 0
+                                            : hs.rehashes == 0);
+
+    // incremental rehash counts once per growth
+    tiny_stl::unordered_set<int> inc;
+    inc.incremental_rehash(true);
+    for (int i = 0; i < 1000; ++i)
+        inc.insert(i);
+    inc.incremental_rehash(false);
+    UNIT_TEST(hs.rehashes, inc.stats().rehashes);
+    UNIT_TEST(1000, inc.stats().size);
+
+    // a queue moving through the deque recentres it and reuses buffers
+    tiny_stl::deque<int> d;
+    for (int i = 0; i < 100000; ++i) {
+        d.push_back(i);
+        if (d.size() > 100)
+            d.pop_front();
+    }
+    tiny_stl::deque_stats ds = d.stats();
+    UNIT_TEST(100, ds.size);
+    UNIT_TEST(true, ds.buffers >= 1 && ds.buffers <= ds.map_size);
+    UNIT_TEST(true, tiny_stl::kStatsEnabled ? ds.map_recentres > 0
+                                            : ds.map_recentres == 0);
+    UNIT_TEST(true, ds.map_reallocations <= 1);
+    UNIT_TEST(true, ds.buffer_allocations <= 8);
+
+    tiny_stl::small_vector<int, 4> sv;
+    for (int i = 0; i < 10; ++i)
+        sv.push_back(i);
+    UNIT_TEST(tiny_stl::kStatsEnabled ? 2 : 0, sv.stats().reallocations);
+    UNIT_TEST(tiny_stl::kStatsEnabled ? 12 : 0, sv.stats().relocated);
+
+    tiny_stl::vector<bool> bits(100, true);
+    bits.resize(1000, false);
+    UNIT_TEST(1000, bits.stats().size);
+    UNIT_TEST(tiny_stl::kStatsEnabled ? 1 : 0, bits.stats().reallocations);
+}
+
+struct SnapshotPoint {
+    int x;
+    int y;
+};
+
+// the same keys land in other groups
+struct SnapshotOtherHash {
+    size_t operator()(int key) const noexcept {
+        return static_cast<size_t>(key) * 0x9E3779B97F4A7C15ull + 1;
+    }
+};
+
+// the message thrown by open(), "" if it opens
+template <typename Open>
+std::string snapshotOpenError(Open open) {
+    try {
+        open();
+    } catch (const char* e) {
+        return e;
+    }
+    return "";
+}
+
+// the first n bytes of from
+void snapshotTruncate(const char* from, const char* to, size_t n) {
+    tiny_stl::mapped_file file(from);
+    std::FILE* out = std::fopen(to, "wb");
+    std::fwrite(file.data(), 1, n, out);
+    std::fclose(out);
+}
+
+// a copy of the snapshot from, with its bytes changed by edit
+template <typename Edit>
+void snapshotCorrupt(const char* from, const char* to, Edit edit) {
+    tiny_stl::mapped_file file(from);
+    tiny_stl::vector<char> bytes(file.data(), file.data() + file.size());
+    edit(*reinterpret_cast<tiny_stl::SnapshotHeader*>(bytes.data()),
+         bytes.data());
+    std::FILE* out = std::fopen(to, "wb");
+    std::fwrite(bytes.data(), 1, bytes.size(), out);
+    std::fclose(out);
+}
+
+void testSnapshot() {
+    const char* path = "tiny_stl_test.snapshot";
+    const char* cut = "tiny_stl_test_cut.snapshot";
+
+    tiny_stl::vector<SnapshotPoint> points;
+    for (int i = 0; i < 1000; ++i)
+        points.push_back(SnapshotPoint{i, -i});
+    tiny_stl::write_snapshot(path, points);
+    {
+        tiny_stl::mapped_vector<SnapshotPoint> mv(path);
+        UNIT_TEST(1000, mv.size());
+        UNIT_TEST(0, reinterpret_cast<uintptr_t>(mv.data()) %
+                         tiny_stl::kSnapshotAlign);
+        UNIT_TEST(-500, mv[500].y);
+        UNIT_TEST(999, mv.back().x);
+        long long sum = 0;
+        for (const SnapshotPoint& p : mv)
+            sum += p.x;
+        UNIT_TEST(499500, sum);
+        UNIT_TEST("invalid mapped_vector<T> subscript",
+                  snapshotOpenError([&] { mv.at(1000); }));
+
+        // the mapping outlives the move
+        tiny_stl::mapped_vector<SnapshotPoint> mv2(tiny_stl::move(mv));
+        UNIT_TEST(7, mv2[7].x);
+    }
+    UNIT_TEST("snapshot: the element layout differs",
+              snapshotOpenError([&] { tiny_stl::mapped_vector<int> v(path); }));
+    UNIT_TEST("snapshot: the container differs", snapshotOpenError([&] {
+                  tiny_stl::mapped_flat_map<int, int> m(path);
+              }));
+    snapshotTruncate(path, cut, 4096);
+    UNIT_TEST("snapshot: the file is truncated", snapshotOpenError([&] {
+                  tiny_stl::mapped_vector<SnapshotPoint> v(cut);
+              }));
+    snapshotTruncate(path, cut, 16);
+    UNIT_TEST("snapshot: the file is too short", snapshotOpenError([&] {
+                  tiny_stl::mapped_vector<SnapshotPoint> v(cut);
+              }));
+    UNIT_TEST("mapped_file: cannot open the file", snapshotOpenError([&] {
+                  tiny_stl::mapped_vector<int> v("tiny_stl_no_such.snapshot");
+              }));
+
+    tiny_stl::write_snapshot(path, tiny_stl::vector<int>());
+    UNIT_TEST(true, tiny_stl::mapped_vector<int>(path).empty());
+
+    // size * sizeof(T) wraps around to the section size
+    tiny_stl::write_snapshot(path, tiny_stl::vector<long long>{7});
+    snapshotCorrupt(path, cut, [](tiny_stl::SnapshotHeader& h, char*) {
+        h.size = (1ULL << 61) + 1;
+    });
+    UNIT_TEST("snapshot: a section is out of the file", snapshotOpenError([&] {
+                  tiny_stl::mapped_vector<long long> v(cut);
+              }));
+
+    // flat_map, the keys and the values in two sections
+    tiny_stl::flat_map<int, double> fm;
+    for (int i = 0; i < 500; ++i)
+        fm.emplace(i * 2, i * 0.5);
+    tiny_stl::write_snapshot(path, fm);
+    {
+        tiny_stl::mapped_flat_map<int, double> mfm(path);
+        UNIT_TEST(500, mfm.size());
+        UNIT_TEST(4.5, mfm.at(18));
+        UNIT_TEST(true, mfm.find(19) == mfm.end());
+        UNIT_TEST(1, mfm.count(998));
+        UNIT_TEST(false, mfm.contains(1000));
+        UNIT_TEST(20, mfm.lower_bound(19)->first);
+        UNIT_TEST(22, mfm.upper_bound(20)->first);
+        auto range = mfm.equal_range(40);
+        UNIT_TEST(1, range.second - range.first);
+        UNIT_TEST(10.0, range.first->second);
+        UNIT_TEST(0, mfm.equal_range(41).second - mfm.equal_range(41).first);
+        UNIT_TEST("mapped_flat_map<Key, T>, key is not exist",
+                  snapshotOpenError([&] { mfm.at(1); }));
+        bool same = true;
+        auto iter = fm.begin();
+        for (auto p : mfm) {
+            same = same && p.first == iter->first && p.second == iter->second;
+            ++iter;
+        }
+        UNIT_TEST(true, same);
+    }
+
+    tiny_stl::flat_map<long long, long long> fm1{{1, 2}};
+    tiny_stl::write_snapshot(path, fm1);
+    snapshotCorrupt(path, cut, [](tiny_stl::SnapshotHeader& h, char*) {
+        h.size = (1ULL << 61) + 1;
+    });
+    UNIT_TEST("snapshot: a section is out of the file", snapshotOpenError([&] {
+                  tiny_stl::mapped_flat_map<long long, long long> m(cut);
+              }));
+
+    // the flat hash tables separately, the groups are probed in the file
+    using FlatMap = tiny_stl::unordered_map<
+        int, int, tiny_stl::hash<int>, tiny_stl::equal_to<int>,
+        tiny_stl::allocator<tiny_stl::pair<int, int>>,
+        tiny_stl::flat_hashing<>>;
+    FlatMap um;
+    for (int i = 0; i < 3000; ++i)
+        um.emplace(i, i * 3);
+    for (int i = 0; i < 3000; i += 3)
+        um.erase(i); // tombstones are written as they are
+    tiny_stl::write_snapshot(path, um);
+    {
+        tiny_stl::mapped_unordered_map<int, int> mum(path);
+        UNIT_TEST(um.size(), mum.size());
+        UNIT_TEST(um.bucket_count(), mum.bucket_count());
+        UNIT_TEST(3, mum.at(1));
+        UNIT_TEST(true, mum.find(3) == mum.end());
+        UNIT_TEST(0, mum.count(3000));
+        UNIT_TEST(true, mum.contains(2999));
+        size_t found = 0;
+        for (int i = 0; i < 3000; ++i)
+            found += mum.count(i);
+        UNIT_TEST(2000, found);
+        auto range = mum.equal_range(5);
+        UNIT_TEST(15, range.first->second);
+        UNIT_TEST(1, tiny_stl::distance(range.first, range.second));
+        long long sum = 0, expect = 0;
+        for (const auto& p : mum)
+            sum += p.second;
+        for (const auto& p : um)
+            expect += p.second;
+        UNIT_TEST(expect, sum);
+        UNIT_TEST("mapped_unordered_map: out of range",
+                  snapshotOpenError([&] { mum.at(3); }));
+    }
+    UNIT_TEST("snapshot: the hash function differs", snapshotOpenError([&] {
+                  tiny_stl::mapped_unordered_map<int, int, SnapshotOtherHash>
+                      m(path);
+              }));
+    UNIT_TEST("snapshot: the probing differs", snapshotOpenError([&] {
+                  tiny_stl::mapped_unordered_map<
+                      int, int, tiny_stl::hash<int>, tiny_stl::equal_to<int>,
+                      tiny_stl::linear_probing>
+                      m(path);
+              }));
+    UNIT_TEST("snapshot: the container differs", snapshotOpenError([&] {
+                  tiny_stl::mapped_unordered_set<int> s(path);
+              }));
+
+    using FlatSet = tiny_stl::unordered_set<int, tiny_stl::hash<int>,
+                                            tiny_stl::equal_to<int>,
+                                            tiny_stl::allocator<int>,
+                                            tiny_stl::flat_hashing<>>;
+    FlatSet us = {1, 2, 3, 5, 8};
+    tiny_stl::write_snapshot(path, us);
+    {
+        tiny_stl::mapped_unordered_set<int> mus(path);
+        UNIT_TEST(5, mus.size());
+        UNIT_TEST(8, *mus.find(8));
+        UNIT_TEST(false, mus.contains(4));
+        int sum = 0;
+        for (int k : mus)
+            sum += k;
+        UNIT_TEST(19, sum);
+    }
+
+    // no empty control byte would end the probe of a missed key
+    snapshotCorrupt(path, cut, [](tiny_stl::SnapshotHeader& h, char* data) {
+        std::fill(data + h.offset[0], data + h.offset[0] + h.capacity,
+                  static_cast<char>(tiny_stl::kFlatDeleted));
+        h.size = 0;
+    });
+    UNIT_TEST("snapshot: the table is corrupt", snapshotOpenError([&] {
+                  tiny_stl::mapped_unordered_set<int> s(cut);
+              }));
+    // or the full bytes disagree with the size
+    snapshotCorrupt(path, cut, [](tiny_stl::SnapshotHeader& h, char*) {
+        h.size = 4;
+    });
+    UNIT_TEST("snapshot: the table is corrupt", snapshotOpenError([&] {
+                  tiny_stl::mapped_unordered_set<int> s(cut);
+              }));
+
+    tiny_stl::write_snapshot(path, FlatSet());
+    {
+        tiny_stl::mapped_unordered_set<int> mus(path);
+        UNIT_TEST(true, mus.empty());
+        UNIT_TEST(true, mus.begin() == mus.end());
+        UNIT_TEST(false, mus.contains(1));
+    }
+
+    std::remove(path);
+    std::remove(cut);
 }
 
 void testAll() {
     testUtility();
     testTypeTraits();
     testAlgorithm();
+    testTrivialCopy();
+    testExecution();
     testArray();
     testMemory();
+    testLocalSharedPtr();
+    testIntrusivePtr();
+    testAtomicSharedPtr();
+    testAllocators();
+    testPmr();
     testVector();
+    testVectorBool();
+    testSmallVector();
+    testRelocatable();
     testList();
     testForwardList();
     testDeque();
     testAdaptor();
+    testConcurrentQueue();
     testCowString();
+    testCowRefCount();
+    testCowInternPool();
     testString();
+    testStringSearch();
+    testStringLayout();
     testStringView();
     testRBTree();
     testSet();
     testMap();
+    testBTree();
+    testFlatMap();
     testTuple();
     testUnorderSet();
     testUnorderedMap();
+    testFlatHashTable();
+    testConcurrentMap();
+    testHashBytes();
+    testStats();
+    testSnapshot();
 }
 
 int main() {
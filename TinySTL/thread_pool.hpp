@@ -0,0 +1,176 @@
+// Copyright (C) 2021 syn1w
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include "deque.hpp"
+#include "vector.hpp"
+
+namespace tiny_stl {
+
+// a fixed number of workers take tasks from one queue
+class thread_pool {
+private:
+    vector<std::thread> workers;
+    deque<std::function<void()>> tasks;
+    std::mutex mtx;
+    std::condition_variable cv;
+    bool stopping;
+
+    void workerLoop() {
+        while (true) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mtx);
+                cv.wait(lock, [this] { return stopping || !tasks.empty(); });
+                if (tasks.empty())
+                    return; // stopping and drained
+
+                task = tiny_stl::move(tasks.front());
+                tasks.pop_front();
+            }
+
+            task();
+        }
+    }
+
+public:
+    // threads == 0 makes a pool without workers, submit() runs the task
+    explicit thread_pool(size_t threads) : stopping(false) {
+        workers.reserve(threads);
+        for (size_t i = 0; i < threads; ++i)
+            workers.emplace_back([this] { workerLoop(); });
+    }
+
+    thread_pool(const thread_pool&) = delete;
+    thread_pool& operator=(const thread_pool&) = delete;
+
+    // run the pending tasks, then join
+    ~thread_pool() {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            stopping = true;
+        }
+        cv.notify_all();
+
+        for (auto& t : workers)
+            t.join();
+    }
+
+    size_t size() const noexcept {
+        return workers.size();
+    }
+
+    template <typename Fn>
+    void submit(Fn&& fn) {
+        if (workers.empty()) {
+            fn();
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            tasks.emplace_back(tiny_stl::forward<Fn>(fn));
+        }
+        cv.notify_one();
+    }
+
+    // run one pending task on the calling thread, a thread waiting for
+    // its tasks helps instead of blocking a worker
+    bool try_run_one() {
+        std::function<void()> task;
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            if (tasks.empty())
+                return false;
+
+            task = tiny_stl::move(tasks.front());
+            tasks.pop_front();
+        }
+
+        task();
+        return true;
+    }
+}; // class thread_pool
+
+// the workers and the calling thread use every hardware thread
+inline thread_pool& hardwareThreadPool() {
+    static thread_pool pool(std::thread::hardware_concurrency() > 1
+                                ? std::thread::hardware_concurrency() - 1
+                                : 0);
+    return pool;
+}
+
+inline std::atomic<thread_pool*>& defaultThreadPool() noexcept {
+    static std::atomic<thread_pool*> pool{nullptr};
+    return pool;
+}
+
+// the pool of the parallel algorithms
+inline thread_pool& default_thread_pool() {
+    thread_pool* pool = defaultThreadPool().load();
+    return pool != nullptr ? *pool : hardwareThreadPool();
+}
+
+// nullptr means the pool of hardware threads, return the previous one
+inline thread_pool* set_default_thread_pool(thread_pool* pool) noexcept {
+    return defaultThreadPool().exchange(pool);
+}
+
+// run fn(i) for i in [0, count), fn(0) on the calling thread, return after
+// all of them, rethrow the first exception
+template <typename Fn>
+inline void parallelInvoke(thread_pool& pool, size_t count, Fn& fn) {
+    struct Group {
+        std::atomic<size_t> pending;
+        std::mutex mtx;
+        std::condition_variable cv;
+        std::exception_ptr error;
+    } group;
+
+    group.pending.store(count);
+    auto runOne = [&group, &fn](size_t i) {
+        try {
+            fn(i);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(group.mtx);
+            if (!group.error)
+                group.error = std::current_exception();
+        }
+
+        // under the lock, group must outlive the last notify
+        std::lock_guard<std::mutex> lock(group.mtx);
+        if (group.pending.fetch_sub(1) == 1)
+            group.cv.notify_all();
+    };
+
+    for (size_t i = 1; i < count; ++i)
+        pool.submit([&runOne, i] { runOne(i); });
+    if (count > 0)
+        runOne(0);
+
+    while (group.pending.load() != 0) {
+        if (pool.try_run_one())
+            continue;
+
+        // the rest is running on the workers
+        std::unique_lock<std::mutex> lock(group.mtx);
+        group.cv.wait(lock, [&group] { return group.pending.load() == 0; });
+    }
+
+    // wait for the last task to release the lock
+    std::lock_guard<std::mutex> lock(group.mtx);
+    if (group.error)
+        std::rethrow_exception(group.error);
+}
+
+} // namespace tiny_stl
@@ -575,6 +575,28 @@ struct is_pod : bool_constant<std::is_pod<T>::value> {};
 template <typename T>
 constexpr bool is_pod_v = is_pod<T>::value;
 
+template <typename T>
+struct is_trivial : bool_constant<std::is_trivial<T>::value> {};
+
+template <typename T>
+constexpr bool is_trivial_v = is_trivial<T>::value;
+
+template <typename T>
+struct is_trivially_copyable
+    : bool_constant<std::is_trivially_copyable<T>::value> {};
+
+template <typename T>
+constexpr bool is_trivially_copyable_v = is_trivially_copyable<T>::value;
+
+// moving a T to new storage and destroying the old one is the same as
+// copying its bytes, the containers then relocate T by memcpy/memmove.
+// Specialize it as true_type for a type that does not point into itself
+template <typename T>
+struct is_trivially_relocatable : is_trivially_copyable<T>::type {};
+
+template <typename T>
+constexpr bool is_trivially_relocatable_v = is_trivially_relocatable<T>::value;
+
 template <typename T>
 struct is_empty : bool_constant<std::is_empty<T>::value> {};
 
@@ -4,15 +4,17 @@
 
 #pragma once
 
+#include "flat_hashtable.hpp"
 #include "hashtable.hpp"
 
 namespace tiny_stl {
 
 template <typename Key, typename T, typename Hash = hash<Key>,
           typename KeyEqual = equal_to<Key>,
-          typename Alloc = allocator<pair<Key, T>>>
-class unordered_map
-    : public HashTable<pair<Key, T>, Hash, KeyEqual, Alloc, true> {
+          typename Alloc = allocator<pair<Key, T>>,
+          typename Policy = chained_hashing<>>
+class unordered_map : public Policy::template table<pair<Key, T>, Hash,
+                                                   KeyEqual, Alloc, true> {
 public:
     using key_type = Key;
     using mapped_type = T;
@@ -27,7 +29,8 @@ public:
     using AlTraits = allocator_traits<allocator_type>;
     using pointer = typename AlTraits::pointer;
     using const_pointer = typename AlTraits::const_pointer;
-    using Base = HashTable<pair<Key, T>, Hash, KeyEqual, Alloc, true>;
+    using Base = typename Policy::template table<pair<Key, T>, Hash,
+                                                 KeyEqual, Alloc, true>;
     using iterator = typename Base::iterator;
     using const_iterator = typename Base::const_iterator;
     using local_iterator = typename Base::local_iterator;
@@ -149,7 +152,7 @@ public:
     T& operator[](const key_type& key) {
         iterator pos = this->find(key);
         if (pos == this->end())
-            return this->insert(make_pair(key, T{})).first->second;
+            return this->insert(tiny_stl::make_pair(key, T{})).first->second;
 
         return pos->second;
     }
@@ -157,7 +160,7 @@ public:
     T& operator[](key_type&& key) {
         iterator pos = this->find(key);
         if (pos == this->end())
-            return this->insert(make_pair(tiny_stl::move(key), T{}))
+            return this->insert(tiny_stl::make_pair(tiny_stl::move(key), T{}))
                 .first->second;
 
         return pos->second;
@@ -186,7 +189,7 @@ public:
 
     template <typename... Args>
     pair<iterator, bool> emplace(Args&&... args) {
-        this->emplace_unique(tiny_stl::forward<Args>(args)...);
+        return this->emplace_unique(tiny_stl::forward<Args>(args)...);
     }
 
     void swap(unordered_map& rhs) {
@@ -195,17 +198,20 @@ public:
 }; // unordered_map
 
 template <typename Key, typename T, typename Hash, typename KeyEqual,
-          typename Alloc>
-void swap(unordered_map<Key, T, Hash, KeyEqual, Alloc>& lhs,
-          unordered_map<Key, T, Hash, KeyEqual, Alloc>& rhs) {
+          typename Alloc, typename Policy>
+void swap(unordered_map<Key, T, Hash, KeyEqual, Alloc, Policy>& lhs,
+          unordered_map<Key, T, Hash, KeyEqual, Alloc, Policy>& rhs) {
     lhs.swap(rhs);
 }
 
+// the equal keys need the chained engine, only its bucket policy varies
 template <typename Key, typename T, typename Hash = hash<Key>,
           typename KeyEqual = equal_to<Key>,
-          typename Alloc = allocator<pair<Key, T>>>
+          typename Alloc = allocator<pair<Key, T>>,
+          typename BucketPolicy = prime_bucket_policy>
 class unordered_multimap
-    : public HashTable<pair<Key, T>, Hash, KeyEqual, Alloc, true> {
+    : public HashTable<pair<Key, T>, Hash, KeyEqual, Alloc, true,
+                       BucketPolicy> {
 public:
     using key_type = Key;
     using mapped_type = T;
@@ -220,7 +226,8 @@ public:
     using AlTraits = allocator_traits<allocator_type>;
     using pointer = typename AlTraits::pointer;
     using const_pointer = typename AlTraits::const_pointer;
-    using Base = HashTable<pair<Key, T>, Hash, KeyEqual, Alloc, true>;
+    using Base =
+        HashTable<pair<Key, T>, Hash, KeyEqual, Alloc, true, BucketPolicy>;
     using iterator = typename Base::iterator;
     using const_iterator = typename Base::const_iterator;
     using local_iterator = typename Base::local_iterator;
@@ -351,8 +358,8 @@ public:
     }
 
     template <typename... Args>
-    pair<iterator, bool> emplace(Args&&... args) {
-        this->emplace_equal(tiny_stl::forward<Args>(args)...);
+    iterator emplace(Args&&... args) {
+        return this->emplace_equal(tiny_stl::forward<Args>(args)...);
     }
 
     void swap(unordered_multimap& rhs) {
@@ -361,10 +368,27 @@ public:
 }; // unordered_multimap
 
 template <typename Key, typename T, typename Hash, typename KeyEqual,
-          typename Alloc>
-void swap(unordered_multimap<Key, T, Hash, KeyEqual, Alloc>& lhs,
-          unordered_multimap<Key, T, Hash, KeyEqual, Alloc>& rhs) {
+          typename Alloc, typename BucketPolicy>
+void swap(
+    unordered_multimap<Key, T, Hash, KeyEqual, Alloc, BucketPolicy>& lhs,
+    unordered_multimap<Key, T, Hash, KeyEqual, Alloc, BucketPolicy>& rhs) {
     lhs.swap(rhs);
 }
 
+namespace pmr {
+
+template <typename Key, typename T, typename Hash = hash<Key>,
+          typename KeyEqual = equal_to<Key>>
+using unordered_map =
+    tiny_stl::unordered_map<Key, T, Hash, KeyEqual,
+                            polymorphic_allocator<pair<Key, T>>>;
+
+template <typename Key, typename T, typename Hash = hash<Key>,
+          typename KeyEqual = equal_to<Key>>
+using unordered_multimap =
+    tiny_stl::unordered_multimap<Key, T, Hash, KeyEqual,
+                                 polymorphic_allocator<pair<Key, T>>>;
+
+} // namespace pmr
+
 } // namespace tiny_stl
@@ -4,13 +4,16 @@
 
 #pragma once
 
+#include "flat_hashtable.hpp"
 #include "hashtable.hpp"
 
 namespace tiny_stl {
 
 template <typename Key, typename Hash = hash<Key>,
-          typename KeyEqual = equal_to<Key>, typename Alloc = allocator<Key>>
-class unordered_set : public HashTable<Key, Hash, KeyEqual, Alloc, false> {
+          typename KeyEqual = equal_to<Key>, typename Alloc = allocator<Key>,
+          typename Policy = chained_hashing<>>
+class unordered_set
+    : public Policy::template table<Key, Hash, KeyEqual, Alloc, false> {
 public:
     using key_type = Key;
     using value_type = Key;
@@ -24,7 +27,8 @@ public:
     using AlTraits = allocator_traits<allocator_type>;
     using pointer = typename AlTraits::pointer;
     using const_pointer = typename AlTraits::const_pointer;
-    using Base = HashTable<Key, Hash, KeyEqual, Alloc, false>;
+    using Base =
+        typename Policy::template table<Key, Hash, KeyEqual, Alloc, false>;
     using iterator = typename Base::iterator;
     using const_iterator = typename Base::const_iterator;
     using local_iterator = typename Base::local_iterator;
@@ -150,7 +154,7 @@ public:
 
     template <typename... Args>
     pair<iterator, bool> emplace(Args&&... args) {
-        this->emplace_unique(tiny_stl::forward<Args>(args)...);
+        return this->emplace_unique(tiny_stl::forward<Args>(args)...);
     }
 
     void swap(unordered_set& rhs) {
@@ -158,15 +162,19 @@ public:
     }
 }; // unordered_set
 
-template <typename Key, typename Hash, typename KeyEqual, typename Alloc>
-void swap(unordered_set<Key, Hash, KeyEqual, Alloc>& lhs,
-          unordered_set<Key, Hash, KeyEqual, Alloc>& rhs) {
+template <typename Key, typename Hash, typename KeyEqual, typename Alloc,
+          typename Policy>
+void swap(unordered_set<Key, Hash, KeyEqual, Alloc, Policy>& lhs,
+          unordered_set<Key, Hash, KeyEqual, Alloc, Policy>& rhs) {
     lhs.swap(rhs);
 }
 
+// the equal keys need the chained engine, only its bucket policy varies
 template <typename Key, typename Hash = hash<Key>,
-          typename KeyEqual = equal_to<Key>, typename Alloc = allocator<Key>>
-class unordered_multiset : public HashTable<Key, Hash, KeyEqual, Alloc, false> {
+          typename KeyEqual = equal_to<Key>, typename Alloc = allocator<Key>,
+          typename BucketPolicy = prime_bucket_policy>
+class unordered_multiset
+    : public HashTable<Key, Hash, KeyEqual, Alloc, false, BucketPolicy> {
 public:
     using key_type = Key;
     using value_type = Key;
@@ -180,7 +188,7 @@ public:
     using AlTraits = allocator_traits<allocator_type>;
     using pointer = typename AlTraits::pointer;
     using const_pointer = typename AlTraits::const_pointer;
-    using Base = HashTable<Key, Hash, KeyEqual, Alloc, false>;
+    using Base = HashTable<Key, Hash, KeyEqual, Alloc, false, BucketPolicy>;
     using iterator = typename Base::iterator;
     using const_iterator = typename Base::const_iterator;
     using local_iterator = typename Base::local_iterator;
@@ -312,7 +320,7 @@ public:
 
     template <typename... Args>
     iterator emplace(Args&&... args) {
-        this->emplace_equal(tiny_stl::forward<Args>(args)...);
+        return this->emplace_equal(tiny_stl::forward<Args>(args)...);
     }
 
     void swap(unordered_multiset& rhs) {
@@ -320,10 +328,26 @@ public:
     }
 }; // unordered_multiset
 
-template <typename Key, typename Hash, typename KeyEqual, typename Alloc>
-void swap(unordered_multiset<Key, Hash, KeyEqual, Alloc>& lhs,
-          unordered_multiset<Key, Hash, KeyEqual, Alloc>& rhs) {
+template <typename Key, typename Hash, typename KeyEqual, typename Alloc,
+          typename BucketPolicy>
+void swap(unordered_multiset<Key, Hash, KeyEqual, Alloc, BucketPolicy>& lhs,
+          unordered_multiset<Key, Hash, KeyEqual, Alloc, BucketPolicy>& rhs) {
     lhs.swap(rhs);
 }
 
+namespace pmr {
+
+template <typename Key, typename Hash = hash<Key>,
+          typename KeyEqual = equal_to<Key>>
+using unordered_set = tiny_stl::unordered_set<Key, Hash, KeyEqual,
+                                              polymorphic_allocator<Key>>;
+
+template <typename Key, typename Hash = hash<Key>,
+          typename KeyEqual = equal_to<Key>>
+using unordered_multiset =
+    tiny_stl::unordered_multiset<Key, Hash, KeyEqual,
+                                 polymorphic_allocator<Key>>;
+
+} // namespace pmr
+
 } // namespace tiny_stl
\ No newline at end of file
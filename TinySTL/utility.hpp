@@ -255,7 +255,7 @@ make_pair(T1&& t1, T2&& t2) {
 
 template <typename T1, typename T2>
 constexpr bool operator==(const pair<T1, T2>& lhs, const pair<T1, T2>& rhs) {
-    return (lhs.first == rhs.first && lhs.second == lhs.second);
+    return (lhs.first == rhs.first && lhs.second == rhs.second);
 }
 
 template <typename T1, typename T2>
@@ -266,7 +266,7 @@ constexpr bool operator!=(const pair<T1, T2>& lhs, const pair<T1, T2>& rhs) {
 template <typename T1, typename T2>
 constexpr bool operator<(const pair<T1, T2>& lhs, const pair<T1, T2>& rhs) {
     return (lhs.first < rhs.first) ||
-           (!(lhs.first < rhs.first) && lhs.second < rhs.second);
+           (!(rhs.first < lhs.first) && lhs.second < rhs.second);
 }
 
 template <typename T1, typename T2>
@@ -566,4 +566,16 @@ struct in_place_index_t {
 template <std::size_t I>
 constexpr in_place_index_t<I> in_place_index{};
 
+// the range is sorted and has no equivalent keys
+struct sorted_unique_t {
+    explicit sorted_unique_t() = default;
+};
+constexpr sorted_unique_t sorted_unique{};
+
+// the range is sorted
+struct sorted_equivalent_t {
+    explicit sorted_equivalent_t() = default;
+};
+constexpr sorted_equivalent_t sorted_equivalent{};
+
 } // namespace tiny_stl
@@ -4,7 +4,9 @@
 
 #pragma once
 
+#include "bit_iterator.hpp"
 #include "memory.hpp"
+#include "stats.hpp"
 #include <initializer_list>
 
 namespace tiny_stl {
@@ -198,6 +200,24 @@ operator+(typename VectorIterator<T>::difference_type offset,
     return iter += offset;
 }
 
+template <typename T>
+struct ContiguousIterator<VectorConstIterator<T>> : true_type {
+    using element_type = const T;
+
+    static const T* address(VectorConstIterator<T> iter) noexcept {
+        return iter.ptr;
+    }
+};
+
+template <typename T>
+struct ContiguousIterator<VectorIterator<T>> : true_type {
+    using element_type = T;
+
+    static T* address(VectorIterator<T> iter) noexcept {
+        return iter.ptr;
+    }
+};
+
 template <typename T, typename Alloc>
 class VectorBase {
 public:
@@ -221,10 +241,147 @@ protected:
     T* last;
     T* end_of_storage;
 
+#ifdef TINY_STL_STATS
+    size_type reallocations = 0;
+    size_type relocated = 0;
+#endif
+
 public:
     VectorBase(const Alloc& a) : alloc(a), first(), last(), end_of_storage() {
     }
 
+protected:
+    static size_type maxSize() noexcept {
+        return sizeof(T) == 1 ? static_cast<size_type>(-1) >> 1
+                              : static_cast<size_type>(-1) / sizeof(T);
+    }
+
+    // normal: capacity <<= 1, the growth of vector and small_vector
+    size_type capacityGrowth(size_type newSize) const {
+        const size_type oldCapacity = end_of_storage - first;
+
+        if ((oldCapacity << 1) > maxSize())
+            return newSize;
+
+        const size_type newCapacity = (oldCapacity << 1);
+
+        return newCapacity < newSize ? newSize : newCapacity;
+    }
+
+    // copy construct at raw memory, the copies are destroyed if one throws
+    template <typename Iter>
+    T* constructRange(Iter xfirst, Iter xlast, T* newFirst) {
+        T* dst = newFirst;
+        try {
+            for (; xfirst != xlast; ++xfirst, ++dst)
+                allocator_traits<Alloc>::construct(alloc, dst, *xfirst);
+        } catch (...) {
+            destroyAllocRange(newFirst, dst, alloc);
+            throw;
+        }
+
+        return dst;
+    }
+
+    // n copies of val
+    T* constructFill(T* newFirst, size_type n, const T& val) {
+        T* dst = newFirst;
+        try {
+            for (; n > 0; --n, ++dst)
+                allocator_traits<Alloc>::construct(alloc, dst, val);
+        } catch (...) {
+            destroyAllocRange(newFirst, dst, alloc);
+            throw;
+        }
+
+        return dst;
+    }
+
+    // move construct
+    void moveOrCopyAux(T* xfirst, T* xlast, T* newFirst, true_type) {
+        uninitializedAllocMove(xfirst, xlast, newFirst, alloc);
+    }
+
+    void moveOrCopyAux(T* xfirst, T* xlast, T* newFirst, false_type) {
+        constructRange(xfirst, xlast, newFirst);
+    }
+
+    // move if it cannot throw or T cannot be copied, for reallocation
+    void moveOrCopy(T* xfirst, T* xlast, T* newFirst) {
+        moveOrCopyAux(xfirst, xlast, newFirst,
+                      typename tiny_stl::disjunction<
+                          is_nothrow_move_constructible<T>,
+                          negation<is_copy_constructible<T>>>::type());
+    }
+
+    // copy the bytes instead of move + destroy, the allocator must not
+    // customize construct or destroy
+    using Relocatable =
+        typename conjunction<is_trivially_relocatable<T>,
+                             UseDefaultConstruct<Alloc, T*, T&&>,
+                             UseDefaultDestroy<Alloc, T*>>::type;
+
+    void relocateAux(T* pos, T* newFirst, T* newPos, true_type) noexcept {
+        uninitializedRelocate(first, pos, newFirst);
+        uninitializedRelocate(pos, last, newPos);
+    }
+
+    void relocateAux(T* pos, T* newFirst, T* newPos, false_type) {
+        moveOrCopy(first, pos, newFirst);
+        try {
+            moveOrCopy(pos, last, newPos);
+        } catch (...) {
+            destroyAllocRange(newFirst, newFirst + (pos - first), alloc);
+            throw;
+        }
+
+        destroyAllocRange(first, last, alloc);
+    }
+
+    // move [first, pos) to newFirst and [pos, last) to newPos in another
+    // array and destroy the old elements, if it throws nothing is changed
+    // unless moveOrCopy had to use a throwing move
+    void relocate(T* pos, T* newFirst, T* newPos) {
+        relocateAux(pos, newFirst, newPos, Relocatable{});
+    }
+
+    T* eraseAux(T* xfirst, T* xlast, true_type) noexcept {
+        destroyAllocRange(xfirst, xlast, alloc);
+        return uninitializedRelocate(xlast, last, xfirst);
+    }
+
+    T* eraseAux(T* xfirst, T* xlast, false_type) {
+        T* const newLast = tiny_stl::move(xlast, last, xfirst);
+        destroyAllocRange(newLast, last, alloc);
+        return newLast;
+    }
+
+    // remove [xfirst, xlast) and return the new last
+    T* eraseRange(T* xfirst, T* xlast) {
+        return eraseAux(xfirst, xlast, Relocatable{});
+    }
+
+    // the array moved to a larger one, taking moved elements along
+    void countReallocation(size_type moved) noexcept {
+#ifdef TINY_STL_STATS
+        ++reallocations;
+        relocated += moved;
+#else
+        (void)moved;
+#endif
+    }
+
+    vector_stats growthStats(size_type size, size_type capacity) const
+        noexcept {
+#ifdef TINY_STL_STATS
+        return vector_stats{size, capacity, reallocations, relocated};
+#else
+        return vector_stats{size, capacity, 0, 0};
+#endif
+    }
+
+public:
+
     T* allocateAux(size_t n) {
         return alloc.allocate(n);
     }
@@ -276,6 +433,14 @@ private:
     using Base::first;
     using Base::last;
 
+    using Base::capacityGrowth;
+    using Base::constructFill;
+    using Base::constructRange;
+    using Base::eraseRange;
+    using Base::relocate;
+
+    using Relocatable = typename Base::Relocatable;
+
 private:
     // only allocate
     bool allocAux(size_type newCapacity) {
@@ -305,25 +470,6 @@ private:
         return uninitializedAllocDefaultN(dest, count, this->alloc);
     }
 
-    // move construct
-    void moveOrCopyAux(pointer xfirst, pointer xlast, pointer newFirst,
-                       true_type) {
-        uninitializedAllocMove(xfirst, xlast, newFirst, this->alloc);
-    }
-
-    // copy construct
-    void moveOrCopyAux(pointer xfirst, pointer xlast, pointer newFirst,
-                       false_type) {
-        uninitializedAllocCopy(xfirst, xlast, newFirst, this->alloc);
-    }
-
-    void moveOrCopy(pointer xfirst, pointer xlast, pointer newFirst) {
-        moveOrCopyAux(xfirst, xlast, newFirst,
-                      typename tiny_stl::disjunction<
-                          is_nothrow_move_constructible<T>,
-                          negation<is_copy_constructible<T>>>::type());
-    }
-
     pointer moveAux(pointer xfirst, pointer xlast, pointer newFirst) {
         return uninitializedAllocMove(xfirst, xlast, newFirst, this->alloc);
     }
@@ -463,7 +609,7 @@ public:
     // (7)
     vector(vector&& rhs, const Alloc& alloc) : Base(alloc) {
         // FIXME, no strong exception
-        constructMove(rhs.first, rhs.last,
+        constructMove(tiny_stl::move(rhs),
                       typename allocator_traits<Alloc>::is_always_equal{});
     }
 
@@ -519,12 +665,19 @@ private:
     }
 
     void assignMove(vector&& rhs, true_type) noexcept {
+        tidy();
+        if (allocator_traits<
+                Alloc>::propagate_on_container_move_assignment::value)
+            this->alloc = rhs.alloc;
         constructMove(tiny_stl::move(rhs), true_type{});
     }
 
     void assignMove(vector&& rhs, false_type) {
-        if (this->alloc == rhs.alloc)
+        if (this->alloc == rhs.alloc) {
+            tidy();
             constructMove(tiny_stl::move(rhs), true_type{});
+            return;
+        }
 
         // Move individually
         const size_type newSize = rhs.size();
@@ -589,12 +742,12 @@ public:
     vector& operator=(const vector& rhs) {
         assert(this != tiny_stl::addressof(rhs));
 
-        if (this->alloc != rhs.alloc)
-            tidy(); // this->alloc deallocate elements
-
         if (allocator_traits<
-                Alloc>::propagate_on_container_copy_assignment::value)
+                Alloc>::propagate_on_container_copy_assignment::value) {
+            if (this->alloc != rhs.alloc)
+                tidy(); // this->alloc deallocate elements
             this->alloc = rhs.alloc;
+        }
 
         assign(rhs.first, rhs.last);
         return *this;
@@ -606,10 +759,6 @@ public:
         allocator_traits<Alloc>::is_always_equal::value) {
         assert(this != tiny_stl::addressof(rhs));
 
-        if (allocator_traits<
-                Alloc>::propagate_on_container_move_assignment::value)
-            this->alloc = rhs.alloc;
-
         assignMove(
             tiny_stl::move(rhs),
             disjunction<typename allocator_traits<
@@ -730,42 +879,79 @@ public:
     }
 
 private:
+    // the old elements are relocated, deallocate the old array
     void updatePointer(const pointer newFirst, size_type newSize,
                        size_type newCapacity) {
-        if (this->first != pointer()) {
-            destroyAllocRange(this->first, this->last, this->alloc);
-            this->alloc.deallocate(this->first, capacity());
-        }
+        if (this->first != this->last && newCapacity > capacity())
+            this->countReallocation(size());
+        this->deallocateAux(this->first, capacity());
 
         this->first = newFirst;
         this->last = newFirst + newSize;
         this->end_of_storage = newFirst + newCapacity;
     }
 
+    // strong exception guarantee, see relocate
     void reallocAndInit(size_type newCapacity) {
         const size_type newSize = size();
         const pointer newFirst = this->alloc.allocate(newCapacity);
 
         try {
-            moveOrCopy(this->first, this->last, newFirst);
+            relocate(this->last, newFirst, newFirst + newSize);
         } catch (...) {
-            tidy();
+            this->alloc.deallocate(newFirst, newCapacity);
             throw;
         }
 
-        // destroy/deallocate old elements, update new pointer
         updatePointer(newFirst, newSize, newCapacity);
     }
 
-    size_type capacityGrowth(size_type newSize) const {
-        const size_type oldCapacity = capacity();
+    // reallocate for n more elements, build(dst) constructs them at
+    // [dst, dst + n) of the new array and the old ones go around them,
+    // build must not leave any of them if it throws
+    template <typename Build>
+    void reallocInsert(size_type offset, size_type n, Build build) {
+        const size_type oldSize = size();
+        if (n > max_size() - oldSize)
+            xLength();
 
-        if ((oldCapacity << 1) > max_size())
-            return newSize;
+        const size_type newSize = oldSize + n;
+        const size_type newCapacity = capacityGrowth(newSize);
+        const pointer newFirst = this->alloc.allocate(newCapacity);
+        const pointer newPos = newFirst + offset;
 
-        const size_type newCapacity = (oldCapacity << 1);
+        try {
+            build(newPos);
+        } catch (...) {
+            this->alloc.deallocate(newFirst, newCapacity);
+            throw;
+        }
 
-        return newCapacity < newSize ? newSize : newCapacity;
+        try {
+            relocate(this->first + offset, newFirst, newPos + n);
+        } catch (...) {
+            destroyAllocRange(newPos, newPos + n, this->alloc);
+            this->alloc.deallocate(newFirst, newCapacity);
+            throw;
+        }
+
+        updatePointer(newFirst, newSize, newCapacity);
+    }
+
+    // T is trivially relocatable, open a gap of n at pos by moving the
+    // bytes of the tail and build(pos) into it, the gap is closed again if
+    // build throws
+    template <typename Build>
+    void shiftInsert(pointer pos, size_type n, Build build) {
+        uninitializedRelocate(pos, this->last, pos + n);
+        try {
+            build(pos);
+        } catch (...) {
+            uninitializedRelocate(pos + n, this->last + n, pos);
+            throw;
+        }
+
+        this->last += n;
     }
 
 public:
@@ -778,8 +964,7 @@ public:
     }
 
     size_type max_size() const noexcept {
-        return sizeof(T) == 1 ? static_cast<size_type>(-1) >> 1
-                              : static_cast<size_type>(-1) / sizeof(T);
+        return Base::maxSize();
     }
 
     void reserve(size_type newcapacity) {
@@ -817,29 +1002,11 @@ public:
             allocator_traits<Alloc>::construct(
                 this->alloc, this->last, tiny_stl::forward<Args>(args)...);
             ++this->last;
-        } else { // reallocate
-            const size_type oldSize = size();
-            if (oldSize == max_size())
-                xLength();
-
-            const size_type newSize = oldSize + 1;
-
-            // normal: capacity <<= 1
-            const size_type newCapacity = capacityGrowth(newSize);
-
-            try {
-                const pointer newFirst = this->alloc.allocate(newCapacity);
-
+        } else { // reallocate, args may refer to an element
+            reallocInsert(size(), 1, [&](pointer dst) {
                 allocator_traits<Alloc>::construct(
-                    this->alloc, tiny_stl::addressof(*(newFirst + oldSize)),
-                    tiny_stl::forward<Args>(args)...);
-
-                moveOrCopy(this->first, this->last, newFirst);
-                updatePointer(newFirst, newSize, newCapacity);
-            } catch (...) {
-                tidy();
-                throw;
-            }
+                    this->alloc, dst, tiny_stl::forward<Args>(args)...);
+            });
         }
     }
 
@@ -851,54 +1018,58 @@ public:
         emplace_back(tiny_stl::move(val));
     }
 
+private:
+    // move the bytes of the tail
+    template <typename... Args>
+    void emplaceShift(pointer pos, true_type, Args&&... args) {
+        // args may refer to an element
+        std::aligned_union_t<1, T> buf;
+        const pointer obj = reinterpret_cast<pointer>(&buf);
+        allocator_traits<Alloc>::construct(this->alloc, obj,
+                                           tiny_stl::forward<Args>(args)...);
+
+        shiftInsert(pos, 1, [obj](pointer dst) noexcept {
+            uninitializedRelocate(obj, obj + 1, dst);
+        });
+    }
+
+    // move assign the tail
+    template <typename... Args>
+    void emplaceShift(pointer pos, false_type, Args&&... args) {
+        // args may refer to an element
+        T obj(tiny_stl::forward<Args>(args)...);
+
+        // *last is raw memory, construct it before assigning
+        pointer oldLast = this->last;
+        allocator_traits<Alloc>::construct(
+            this->alloc, tiny_stl::addressof(*oldLast),
+            tiny_stl::move(oldLast[-1]));
+        ++this->last;
+
+        for (--oldLast; pos != oldLast; --oldLast)
+            *oldLast = tiny_stl::move(oldLast[-1]);
+        *oldLast = tiny_stl::move(obj);
+    }
+
+public:
     template <typename... Args>
     iterator emplace(const_iterator pos, Args&&... args) {
         assert(pos.ptr >= this->first && pos.ptr <= this->last);
-        const bool is_back = pos.ptr == this->last;
         const size_type offset = pos.ptr - this->first;
 
         if (this->last == this->end_of_storage) { // reallocate
-            const size_type oldSize = size();
-            if (oldSize == max_size())
-                xLength();
-
-            // reallocate
-            const size_type newSize = oldSize + 1;
-            const size_type newCapacity = capacityGrowth(newSize);
-
-            try {
-                const pointer newFirst = this->alloc.allocate(newCapacity);
-
-                // construct
+            reallocInsert(offset, 1, [&](pointer dst) {
                 allocator_traits<Alloc>::construct(
-                    this->alloc, tiny_stl::addressof(*(newFirst + offset)),
-                    tiny_stl::forward<Args>(args)...);
-
-                if (is_back) { // Strong exception guarantee
-                    moveOrCopy(this->first, this->last, newFirst);
-                } else {
-                    moveAux(this->first, pos.ptr, newFirst);
-                    moveAux(pos.ptr, this->last, newFirst + offset + 1);
-                }
-
-                updatePointer(newFirst, newSize, newCapacity);
-            } catch (...) {
-                tidy();
-                throw;
-            }
-        } else if (is_back) { // no reallocate, and emplace at back
+                    this->alloc, dst, tiny_stl::forward<Args>(args)...);
+            });
+        } else if (pos.ptr == this->last) { // no reallocate, emplace at back
             allocator_traits<Alloc>::construct(
                 this->alloc, tiny_stl::addressof(*this->last),
                 tiny_stl::forward<Args>(args)...);
             ++this->last;
         } else { // no reallocate, move old elements
-            pointer oldLast = this->last;
-            for (; pos.ptr != oldLast; --oldLast)
-                *oldLast = tiny_stl::move(oldLast[-1]);
-
-            T obj(tiny_stl::forward<Args>(args)...);
-            ++this->last;
-            *oldLast = tiny_stl::move(obj);
+            emplaceShift(pos.ptr, Relocatable{},
+                         tiny_stl::forward<Args>(args)...);
         }
         return begin() + offset;
     }
@@ -911,6 +1082,43 @@ public:
         return emplace(pos, tiny_stl::move(val));
     }
 
+private:
+    // move the bytes of the tail
+    void insertFill(pointer pos, size_type n, const T& val, true_type) {
+        // val may be in the tail and move with it
+        const T* pval = tiny_stl::addressof(val);
+        if (pos <= pval && pval < this->last)
+            pval += n;
+
+        shiftInsert(pos, n, [this, n, pval](pointer dst) {
+            constructFill(dst, n, *pval);
+        });
+    }
+
+    // move assign the tail, only the basic exception guarantee: the tail
+    // has been moved when a copy throws, so the vector is left empty
+    void insertFill(pointer pos, size_type n, const T& val, false_type) {
+        const T copy(val); // val may be in the tail
+        const pointer oldLast = this->last;
+        const size_type number_move = oldLast - pos;
+
+        try {
+            if (n >= number_move) { // no move backward
+                this->last = fillHelper(oldLast, n - number_move, copy);
+                this->last = moveAux(pos, pos + number_move, this->last);
+                fill(pos, oldLast, copy);
+            } else { // move backward
+                this->last = moveAux(oldLast - n, oldLast, oldLast);
+                tiny_stl::move_backward(pos, oldLast - n, oldLast);
+                fill(pos, pos + n, copy);
+            }
+        } catch (...) {
+            tidy();
+            throw;
+        }
+    }
+
+public:
     iterator insert(const_iterator pos, size_type n, const T& val) {
         assert(pos.ptr >= this->first && pos.ptr <= this->last);
 
@@ -922,47 +1130,12 @@ public:
             // do nothing
         } else if (n >
                    static_cast<size_type>(this->end_of_storage - this->last)) {
-            // reallocate
-            const size_type oldSize = size();
-            if (n + oldSize > max_size())
-                xLength();
-
-            const size_type newSize = oldSize + n;
-            const size_type newCapacity = capacityGrowth(newSize);
-
-            try {
-                const pointer newFirst = this->alloc.allocate(newCapacity);
-                fillHelper(newFirst + offset, n, val);
-                moveAux(this->first, pos.ptr, newFirst);
-                moveAux(pos.ptr, this->last, newFirst + offset + n);
-                updatePointer(newFirst, newSize, newCapacity);
-            } catch (...) {
-                tidy();
-                throw;
-            }
+            // reallocate, val may be an element
+            reallocInsert(offset, n, [this, n, &val](pointer dst) {
+                constructFill(dst, n, val);
+            });
         } else { // no reallocate
-            const pointer oldLast = this->last;
-            const size_type number_move = oldLast - pos.ptr;
-
-            try {
-                if (n >= number_move) { // no move backward
-                    this->last = fillHelper(oldLast, n - number_move, val);
-                    this->last =
-                        moveAux(pos.ptr, pos.ptr + number_move, this->last);
-                    fill(pos.ptr, oldLast, val);
-                } else { // move backward
-                    this->last = oldLast + n;
-                    pointer p = const_cast<pointer>(oldLast + (n - 1));
-                    for (size_type i = 0; i < number_move; ++i, --p)
-                        *p =
-                            tiny_stl::move(p[-static_cast<difference_type>(n)]);
-
-                    fill(pos.ptr, p, val);
-                }
-            } catch (...) {
-                tidy();
-                throw;
-            }
+            insertFill(pos.ptr, n, val, Relocatable{});
         }
 
         return begin() + offset;
@@ -994,61 +1167,51 @@ private:
             static_cast<size_type>(tiny_stl::distance(xfirst, xlast));
         const size_type offset = pos.ptr - this->first;
 
-        if (n == 1 && pos.ptr == this->last)
-            emplace(pos.ptr, *xfirst);
-
         if (n == 0) {
             // do nothing
         } else if (n >
                    static_cast<size_type>(this->end_of_storage - this->last)) {
-            // reallocate
-            const size_type oldSize = size();
-            if (n + oldSize > max_size())
-                xLength();
-
-            const size_type newSize = oldSize + n;
-            const size_type newCapacity = capacityGrowth(newSize);
+            // reallocate, strong exception guarantee
+            reallocInsert(offset, n, [this, xfirst, xlast](pointer dst) {
+                constructRange(xfirst, xlast, dst);
+            });
+        } else { // no reallocate
+            insertCopy(pos.ptr, xfirst, xlast, n, Relocatable{});
+        }
+    }
 
-            try {
-                const pointer newFirst = this->alloc.allocate(newCapacity);
+    // move the bytes of the tail
+    template <typename FwdIter>
+    void insertCopy(pointer pos, FwdIter xfirst, FwdIter xlast, size_type n,
+                    true_type) {
+        shiftInsert(pos, n, [this, xfirst, xlast](pointer dst) {
+            constructRange(xfirst, xlast, dst);
+        });
+    }
 
-                copyAux(xfirst, xlast, newFirst + offset);
-                moveAux(this->first, pos.ptr, newFirst);
-                moveAux(pos.ptr, this->last, newFirst + offset + n);
+    // move assign the tail, only the basic exception guarantee as in
+    // insertFill
+    template <typename FwdIter>
+    void insertCopy(pointer pos, FwdIter xfirst, FwdIter xlast, size_type n,
+                    false_type) {
+        const pointer oldLast = this->last;
+        const size_type number_move = oldLast - pos;
 
-                updatePointer(newFirst, newSize, newCapacity);
-            } catch (...) {
-                tidy();
-                throw;
-            }
-        } else { // no reallocate
-            const pointer oldLast = this->last;
-            const size_type number_move = oldLast - pos.ptr;
+        try {
             if (n >= number_move) { // no move backward
-                const pointer newPos = this->first + (offset + n);
-                this->last = moveAux(pos.ptr, oldLast, newPos);
-
-                try {
-                    copyAux(xfirst, xlast, pos.ptr);
-                } catch (...) {
-                    // FIXME, move rollback
-                    tidy();
-                    throw;
-                }
+                FwdIter mid = xfirst;
+                tiny_stl::advance(mid, number_move);
+                this->last = constructRange(mid, xlast, oldLast);
+                this->last = moveAux(pos, oldLast, this->last);
+                tiny_stl::copy(xfirst, mid, pos);
             } else { // move backward
-                this->last = oldLast + n;
-                pointer p = const_cast<pointer>(oldLast + (n - 1));
-                for (size_type i = 0; i < number_move; ++i, --p)
-                    *p = tiny_stl::move(p[-static_cast<difference_type>(n)]);
-
-                try {
-                    copyAux(xfirst, xlast, pos.ptr);
-                } catch (...) {
-                    // FIXME, move rollback
-                    tidy();
-                    throw;
-                }
+                this->last = moveAux(oldLast - n, oldLast, oldLast);
+                tiny_stl::move_backward(pos, oldLast - n, oldLast);
+                tiny_stl::copy(xfirst, xlast, pos);
             }
+        } catch (...) {
+            tidy();
+            throw;
         }
     }
 
@@ -1071,9 +1234,7 @@ public:
         assert(pos.ptr >= this->first && pos.ptr < this->last);
 
         const size_type offset = pos.ptr - this->first;
-        moveAux(pos.ptr + 1, this->last, pos.ptr);
-        this->alloc.destroy(tiny_stl::addressof(*(this->last - 1)));
-        --this->last;
+        this->last = eraseRange(pos.ptr, pos.ptr + 1);
         return this->first + offset;
     }
 
@@ -1082,11 +1243,8 @@ public:
                (xfirst.ptr >= this->first && xfirst.ptr < xlast.ptr &&
                 xlast.ptr <= this->last));
         const size_type offset = xfirst.ptr - this->first;
-        if (xfirst != xlast) {
-            const pointer newLast = moveAux(xlast.ptr, this->last, xfirst.ptr);
-            destroyRange(newLast, this->last);
-            this->last = newLast;
-        }
+        if (xfirst != xlast)
+            this->last = eraseRange(xfirst.ptr, xlast.ptr);
         return this->first + offset;
     }
 
@@ -1100,30 +1258,19 @@ private:
     template <typename Lambda>
     void resizeHelper(size_type newSize, Lambda default_or_fill) {
         const size_type oldSize = size();
-        const size_type oldCapacity = capacity();
 
-        if (newSize > oldCapacity) { // reallocate
-            if (newSize > max_size())
-                xLength();
-
-            size_type newCapacity = (newSize >> 1) + newSize;
-
-            const pointer newFirst = nullptr;
-            try {
-                newFirst = this->alloc.allocate(newCapacity);
-                moveOrCopy(this->first, this->last, newFirst);
-            } catch (...) {
-                tidy();
-                throw;
-            }
-
-            // destroy/deallocate old elements, update new pointer
-            updatePointer(newFirst, newSize, newCapacity);
-        } else if (newSize < oldSize) { // update pointer, size = newSize
+        if (newSize < oldSize) { // update pointer, size = newSize
             const pointer newLast = this->first + newSize;
             destroyRange(newLast, this->last);
             this->last = newLast;
         } else if (newSize > oldSize) { // use lambda to append elements
+            if (newSize > capacity()) { // reallocate
+                if (newSize > max_size())
+                    xLength();
+
+                reallocAndInit(capacityGrowth(newSize));
+            }
+
             const pointer oldLast = this->last;
             this->last = default_or_fill(oldLast, newSize - oldSize);
         }
@@ -1148,9 +1295,14 @@ public:
         noexcept(allocator_traits<Alloc>::propagate_on_container_swap::value ||
                  allocator_traits<Alloc>::is_always_equal::value)) {
         swapAlloc(this->alloc, rhs.alloc);
-        swapADL(this->first, rhs.first);
-        swapADL(this->last, rhs.last);
-        swapADL(this->end_of_storage, rhs.end_of_storage);
+        // not ADL, T* may find std::swap through the namespaces of T
+        tiny_stl::swap(this->first, rhs.first);
+        tiny_stl::swap(this->last, rhs.last);
+        tiny_stl::swap(this->end_of_storage, rhs.end_of_storage);
+    }
+
+    vector_stats stats() const noexcept {
+        return this->growthStats(size(), capacity());
     }
 
 private:
@@ -1163,6 +1315,11 @@ private:
     }
 }; // class vector<T>
 
+// three pointers to a heap array
+template <typename T, typename Alloc>
+struct is_trivially_relocatable<vector<T, Alloc>>
+    : is_trivially_relocatable<Alloc>::type {};
+
 template <typename T, typename Alloc>
 inline bool operator==(const vector<T, Alloc>& lhs,
                        const vector<T, Alloc>& rhs) {
@@ -1207,4 +1364,482 @@ inline void swap(vector<T, Alloc>& lhs,
     lhs.swap(rhs);
 }
 
+// vector<bool>, one bit a flag
+//
+// The flags are packed into 64-bit words on VectorBase storage: first,
+// last and end_of_storage point to words, last is the end of the words
+// in use and size counts the bits. The bits of the last word past size
+// are unspecified. reference is a proxy, there is no data().
+template <typename Alloc>
+class vector<bool, Alloc>
+    : public VectorBase<
+          BitWord, typename allocator_traits<Alloc>::template rebind_alloc<
+                       BitWord>> {
+public:
+    static_assert(tiny_stl::is_same_v<bool, typename Alloc::value_type>,
+                  "Alloc::value_type is not the same as T");
+
+public:
+    using value_type = bool;
+    using size_type = size_t;
+    using difference_type = ptrdiff_t;
+    using pointer = BitIterator;
+    using const_pointer = BitConstIterator;
+    using reference = BitReference;
+    using const_reference = bool;
+    using iterator = BitIterator;
+    using const_iterator = BitConstIterator;
+    using reverse_iterator = tiny_stl::reverse_iterator<iterator>;
+    using const_reverse_iterator = tiny_stl::reverse_iterator<const_iterator>;
+    using allocator_type = Alloc;
+
+private:
+    using WordAlloc =
+        typename allocator_traits<Alloc>::template rebind_alloc<BitWord>;
+    using Base = VectorBase<BitWord, WordAlloc>;
+
+    size_type mSize = 0;
+
+private:
+    size_type capacityWords() const noexcept {
+        return this->end_of_storage - this->first;
+    }
+
+    void setSize(size_type n) noexcept {
+        mSize = n;
+        this->last = this->first + bitWordCount(n);
+    }
+
+    // move the words in use to an array of newWords
+    void reallocWords(size_type newWords) {
+        BitWord* newFirst = this->allocateAux(newWords);
+        const size_type used = this->last - this->first;
+        if (used != 0) {
+            if (newWords > capacityWords())
+                this->countReallocation(mSize);
+            std::memcpy(newFirst, this->first, used * sizeof(BitWord));
+        }
+
+        this->deallocateAux(this->first, capacityWords());
+        this->first = newFirst;
+        this->last = newFirst + used;
+        this->end_of_storage = newFirst + newWords;
+    }
+
+    // room for newSize bits, growing geometrically
+    void growTo(size_type newSize) {
+        if (newSize > max_size())
+            xLength();
+
+        const size_type words = bitWordCount(newSize);
+        if (words > capacityWords())
+            reallocWords(this->capacityGrowth(words));
+    }
+
+    // open n bits at offset, the new bits are unspecified
+    iterator openGap(size_type offset, size_type n) {
+        const size_type oldSize = mSize;
+        growTo(oldSize + n);
+        setSize(oldSize + n);
+        tiny_stl::copy_backward(cbegin() + offset, cbegin() + oldSize, end());
+        return begin() + offset;
+    }
+
+    template <typename InIter>
+    void insertRange(size_type offset, InIter xfirst, InIter xlast,
+                     input_iterator_tag) {
+        for (; xfirst != xlast; ++xfirst, ++offset)
+            *openGap(offset, 1) = static_cast<bool>(*xfirst);
+    }
+
+    template <typename FwdIter>
+    void insertRange(size_type offset, FwdIter xfirst, FwdIter xlast,
+                     forward_iterator_tag) {
+        const size_type n =
+            static_cast<size_type>(tiny_stl::distance(xfirst, xlast));
+        iterator dst = openGap(offset, n);
+        for (; xfirst != xlast; ++xfirst, ++dst)
+            *dst = static_cast<bool>(*xfirst);
+    }
+
+    void copyWords(const vector& rhs) {
+        const size_type words = bitWordCount(rhs.mSize);
+        if (words != 0) {
+            this->first = this->allocateAux(words);
+            this->end_of_storage = this->first + words;
+            std::memcpy(this->first, rhs.first, words * sizeof(BitWord));
+        }
+        setSize(rhs.mSize);
+    }
+
+    void constructMove(vector& rhs) noexcept {
+        this->first = rhs.first;
+        this->last = rhs.last;
+        this->end_of_storage = rhs.end_of_storage;
+        mSize = rhs.mSize;
+
+        rhs.first = nullptr;
+        rhs.last = nullptr;
+        rhs.end_of_storage = nullptr;
+        rhs.mSize = 0;
+    }
+
+    void tidy() noexcept {
+        this->deallocateAux(this->first, capacityWords());
+        this->first = nullptr;
+        this->last = nullptr;
+        this->end_of_storage = nullptr;
+        mSize = 0;
+    }
+
+public:
+    vector() noexcept(noexcept(Alloc())) : vector(Alloc()) {
+    }
+
+    explicit vector(const Alloc& alloc) noexcept : Base(WordAlloc(alloc)) {
+    }
+
+    vector(size_type count, const bool& val, const Alloc& alloc = Alloc())
+        : Base(WordAlloc(alloc)) {
+        insert(end(), count, val);
+    }
+
+    explicit vector(size_type count, const Alloc& alloc = Alloc())
+        : vector(count, false, alloc) {
+    }
+
+    template <typename InIter,
+              typename = enable_if_t<is_iterator<InIter>::value>>
+    vector(InIter xfirst, InIter xlast, const Alloc& alloc = Alloc())
+        : Base(WordAlloc(alloc)) {
+        insert(end(), xfirst, xlast);
+    }
+
+    vector(std::initializer_list<bool> ilist, const Alloc& alloc = Alloc())
+        : vector(ilist.begin(), ilist.end(), alloc) {
+    }
+
+    vector(const vector& rhs)
+        : Base(allocator_traits<WordAlloc>::
+                   select_on_container_copy_construction(rhs.alloc)) {
+        copyWords(rhs);
+    }
+
+    vector(const vector& rhs, const Alloc& alloc) : Base(WordAlloc(alloc)) {
+        copyWords(rhs);
+    }
+
+    vector(vector&& rhs) noexcept : Base(tiny_stl::move(rhs.alloc)) {
+        constructMove(rhs);
+    }
+
+    vector(vector&& rhs, const Alloc& alloc) : Base(WordAlloc(alloc)) {
+        if (this->alloc == rhs.alloc)
+            constructMove(rhs);
+        else
+            copyWords(rhs);
+    }
+
+    vector& operator=(const vector& rhs) {
+        if (this != tiny_stl::addressof(rhs)) {
+            if (allocator_traits<
+                    Alloc>::propagate_on_container_copy_assignment::value &&
+                this->alloc != rhs.alloc) {
+                tidy();
+                this->alloc = rhs.alloc;
+            }
+            assign(rhs.begin(), rhs.end());
+        }
+        return *this;
+    }
+
+    vector& operator=(vector&& rhs) noexcept(
+        allocator_traits<
+            Alloc>::propagate_on_container_move_assignment::value ||
+        allocator_traits<Alloc>::is_always_equal::value) {
+        if (this == tiny_stl::addressof(rhs))
+            return *this;
+
+        if (allocator_traits<
+                Alloc>::propagate_on_container_move_assignment::value) {
+            tidy();
+            this->alloc = tiny_stl::move(rhs.alloc);
+            constructMove(rhs);
+        } else if (this->alloc == rhs.alloc) {
+            tidy();
+            constructMove(rhs);
+        } else {
+            assign(rhs.begin(), rhs.end());
+        }
+        return *this;
+    }
+
+    vector& operator=(std::initializer_list<bool> ilist) {
+        assign(ilist.begin(), ilist.end());
+        return *this;
+    }
+
+    void assign(size_type n, const bool& val) {
+        clear();
+        insert(end(), n, val);
+    }
+
+    template <typename InIter,
+              typename = enable_if_t<is_iterator<InIter>::value>>
+    void assign(InIter xfirst, InIter xlast) {
+        clear();
+        insert(end(), xfirst, xlast);
+    }
+
+    void assign(std::initializer_list<bool> ilist) {
+        assign(ilist.begin(), ilist.end());
+    }
+
+    allocator_type get_allocator() const {
+        return static_cast<allocator_type>(this->alloc);
+    }
+
+    reference at(size_type pos) {
+        if (pos >= size())
+            xRange();
+
+        return begin()[pos];
+    }
+
+    const_reference at(size_type pos) const {
+        if (pos >= size())
+            xRange();
+
+        return begin()[pos];
+    }
+
+    reference operator[](size_type pos) {
+        assert(pos < size());
+        return reference(this->first + pos / kBitWordBits,
+                         BitWord(1) << (pos % kBitWordBits));
+    }
+
+    const_reference operator[](size_type pos) const {
+        assert(pos < size());
+        return (this->first[pos / kBitWordBits] >> (pos % kBitWordBits)) & 1;
+    }
+
+    reference front() {
+        assert(!empty());
+        return *begin();
+    }
+
+    const_reference front() const {
+        assert(!empty());
+        return *begin();
+    }
+
+    reference back() {
+        assert(!empty());
+        return (*this)[mSize - 1];
+    }
+
+    const_reference back() const {
+        assert(!empty());
+        return (*this)[mSize - 1];
+    }
+
+    iterator begin() noexcept {
+        return iterator(this->first, 0);
+    }
+
+    const_iterator begin() const noexcept {
+        return const_iterator(this->first, 0);
+    }
+
+    const_iterator cbegin() const noexcept {
+        return begin();
+    }
+
+    iterator end() noexcept {
+        return iterator(this->first + mSize / kBitWordBits,
+                        mSize % kBitWordBits);
+    }
+
+    const_iterator end() const noexcept {
+        return const_iterator(this->first + mSize / kBitWordBits,
+                              mSize % kBitWordBits);
+    }
+
+    const_iterator cend() const noexcept {
+        return end();
+    }
+
+    reverse_iterator rbegin() noexcept {
+        return reverse_iterator(end());
+    }
+
+    const_reverse_iterator rbegin() const noexcept {
+        return const_reverse_iterator(end());
+    }
+
+    const_reverse_iterator crbegin() const noexcept {
+        return rbegin();
+    }
+
+    reverse_iterator rend() noexcept {
+        return reverse_iterator(begin());
+    }
+
+    const_reverse_iterator rend() const noexcept {
+        return const_reverse_iterator(begin());
+    }
+
+    const_reverse_iterator crend() const noexcept {
+        return rend();
+    }
+
+    bool empty() const noexcept {
+        return mSize == 0;
+    }
+
+    size_type size() const noexcept {
+        return mSize;
+    }
+
+    size_type max_size() const noexcept {
+        return (static_cast<size_type>(-1) >> 1) - (kBitWordBits - 1);
+    }
+
+    void reserve(size_type newCapacity) {
+        if (newCapacity > max_size())
+            xLength();
+
+        const size_type words = bitWordCount(newCapacity);
+        if (words > capacityWords())
+            reallocWords(words);
+    }
+
+    size_type capacity() const noexcept {
+        return capacityWords() * kBitWordBits;
+    }
+
+    void shrink_to_fit() {
+        const size_type words = bitWordCount(mSize);
+        if (words == 0)
+            tidy();
+        else if (words < capacityWords())
+            reallocWords(words);
+    }
+
+    void clear() noexcept {
+        setSize(0);
+    }
+
+    void push_back(bool val) {
+        growTo(mSize + 1);
+        setSize(mSize + 1);
+        back() = val;
+    }
+
+    template <typename... Args>
+    reference emplace_back(Args&&... args) {
+        push_back(bool(tiny_stl::forward<Args>(args)...));
+        return back();
+    }
+
+    void pop_back() {
+        assert(!empty());
+        setSize(mSize - 1);
+    }
+
+    template <typename... Args>
+    iterator emplace(const_iterator pos, Args&&... args) {
+        return insert(pos, bool(tiny_stl::forward<Args>(args)...));
+    }
+
+    iterator insert(const_iterator pos, const bool& val) {
+        return insert(pos, 1, val);
+    }
+
+    iterator insert(const_iterator pos, size_type n, const bool& val) {
+        const size_type offset = pos - cbegin();
+        assert(offset <= mSize);
+        iterator dst = openGap(offset, n);
+        tiny_stl::fill(dst, dst + n, val);
+        return dst;
+    }
+
+    template <typename InIter,
+              typename = enable_if_t<is_iterator<InIter>::value>>
+    iterator insert(const_iterator pos, InIter xfirst, InIter xlast) {
+        const size_type offset = pos - cbegin();
+        assert(offset <= mSize);
+        insertRange(offset, xfirst, xlast,
+                    typename iterator_traits<InIter>::iterator_category{});
+        return begin() + offset;
+    }
+
+    iterator insert(const_iterator pos, std::initializer_list<bool> ilist) {
+        return insert(pos, ilist.begin(), ilist.end());
+    }
+
+    iterator erase(const_iterator pos) {
+        return erase(pos, pos + 1);
+    }
+
+    iterator erase(const_iterator xfirst, const_iterator xlast) {
+        const size_type offset = xfirst - cbegin();
+        const size_type n = xlast - xfirst;
+        assert(offset + n <= mSize);
+        tiny_stl::copy(xlast, cend(), begin() + offset);
+        setSize(mSize - n);
+        return begin() + offset;
+    }
+
+    void resize(size_type newSize, bool val = false) {
+        if (newSize > mSize)
+            insert(end(), newSize - mSize, val);
+        else
+            setSize(newSize);
+    }
+
+    void flip() noexcept {
+        for (BitWord* w = this->first; w != this->last; ++w)
+            *w = ~*w;
+    }
+
+    void swap(vector& rhs) noexcept(
+        noexcept(allocator_traits<Alloc>::propagate_on_container_swap::value ||
+                 allocator_traits<Alloc>::is_always_equal::value)) {
+        swapAlloc(this->alloc, rhs.alloc);
+        tiny_stl::swap(this->first, rhs.first);
+        tiny_stl::swap(this->last, rhs.last);
+        tiny_stl::swap(this->end_of_storage, rhs.end_of_storage);
+        tiny_stl::swap(mSize, rhs.mSize);
+    }
+
+    // in bits
+    vector_stats stats() const noexcept {
+        return this->growthStats(mSize, capacity());
+    }
+
+    static void swap(reference lhs, reference rhs) noexcept {
+        const bool tmp = lhs;
+        lhs = rhs;
+        rhs = tmp;
+    }
+
+private:
+    [[noreturn]] static void xLength() {
+        throw "vector<bool> too long";
+    }
+
+    [[noreturn]] static void xRange() {
+        throw "invalid vector<bool> subscript";
+    }
+}; // class vector<bool>
+
+namespace pmr {
+
+template <typename T>
+using vector = tiny_stl::vector<T, polymorphic_allocator<T>>;
+
+} // namespace pmr
+
 } // namespace tiny_stl